@@ -61,6 +61,7 @@ static struct option long_opts[] = {
 	{"bits", required_argument, nullptr, 'b'},
 	{"rate", required_argument, nullptr, 'r'},
 	{"outfile", required_argument, nullptr, 'o'},
+	{"stems", 0, nullptr, 'S'},
 	{"interpolation", required_argument, nullptr, 'I'},
 	{"version", 0, nullptr, 'v'},
 	{"verbose", optional_argument, nullptr, 'V'},
@@ -147,6 +148,7 @@ int main(int argc, char *argv[])
 		QString songFilename;
 		QString playlistFilename;
 		QString outFilename = nullptr;
+		bool bExportStems = false;
 		QString sSelectedDriver;
 		bool showVersionOpt = false;
 		const char* logLevelOpt = "Error";
@@ -181,6 +183,9 @@ int main(int argc, char *argv[])
 			case 'o':
 				outFilename = QString::fromLocal8Bit(optarg);
 				break;
+			case 'S':
+				bExportStems = true;
+				break;
 			case 'i':
 				//install h2drumkit
 				drumkitName = makePathAbsolute( optarg );
@@ -390,8 +395,13 @@ int main(int argc, char *argv[])
 			for (auto i = 0; i < pInstrumentList->size(); i++) {
 				pInstrumentList->get(i)->set_currently_exported( true );
 			}
+			// All stems are rendered in the same pass as the song.
+			std::vector<DiskWriterDriver::Stem> stems;
+			if ( bExportStems ) {
+				stems = pHydrogen->getExportStems( outFilename );
+			}
 			pHydrogen->startExportSession(rate, bits);
-			pHydrogen->startExportSong( outFilename );
+			pHydrogen->startExportSong( outFilename, stems );
 			std::cout << "Export Progress ... ";
 			ExportMode = true;
 		}
@@ -480,7 +490,10 @@ int main(int argc, char *argv[])
 					if( pPlaylist ){
 						QString FirstSongFilename;
 						pPlaylist->getSongFilenameByNumber( event.value, FirstSongFilename );
-						pSong = Song::load( FirstSongFilename );
+						pSong = pPlaylist->getPrefetchedSong( event.value );
+						if ( pSong == nullptr ) {
+							pSong = Song::load( FirstSongFilename );
+						}
 					
 						if( pSong ) {
 							pHydrogen->setSong( pSong );
@@ -592,6 +605,8 @@ void showUsage()
 	std::cout << "   -s, --song FILE - Load a song (*.h2song) at startup" << std::endl;
 	std::cout << "   -p, --playlist FILE - Load a playlist (*.h2playlist) at startup" << std::endl;
 	std::cout << "   -o, --outfile FILE - Output to file (export)" << std::endl;
+	std::cout << "   -S, --stems - Additionally export each instrument to a separate" << std::endl;
+	std::cout << "       file named FILE-INSTRUMENT (requires -o)" << std::endl;
 	std::cout << "   -r, --rate RATE - Set bitrate while exporting file" << std::endl;
 	std::cout << "   -b, --bits BITS - Set bits depth while exporting file" << std::endl;
 	std::cout << "   -k, --kit drumkit_name - Load a drumkit at startup" << std::endl;
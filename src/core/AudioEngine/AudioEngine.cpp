@@ -62,7 +62,10 @@
 
 #include <core/Hydrogen.h>	// TODO: remove this line as soon as possible
 #include <core/Preferences/Preferences.h>
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <limits>
 #include <random>
 
@@ -91,19 +94,13 @@ inline float getGaussian( float z )
 }
 
 
-/** Gets the current time.
- * \return Current time obtained by gettimeofday()*/
-inline timeval currentTime2()
-{
-	struct timeval now;
-	gettimeofday( &now, nullptr );
-	return now;
-}
-
 AudioEngine::AudioEngine()
 		: TransportInfo()
 		, m_pSampler( nullptr )
 		, m_pSynth( nullptr )
+		, m_pNotePool( nullptr )
+		, m_pDspProfiler( nullptr )
+		, m_pTempoMap( nullptr )
 		, m_pAudioDriver( nullptr )
 		, m_pMidiDriver( nullptr )
 		, m_pMidiDriverOut( nullptr )
@@ -114,10 +111,18 @@ AudioEngine::AudioEngine()
 		, m_nPatternSize( MAX_NOTES )
 		, m_fSongSizeInTicks( 0 )
 		, m_nRealtimeFrames( 0 )
+		, m_nCycleStartTime( 0 )
+		, m_nCycleStartFrame( 0 )
+		, m_nCycleStartJackFrame( -1 )
 		, m_fMasterPeak_L( 0.0f )
 		, m_fMasterPeak_R( 0.0f )
 		, m_nColumn( -1 )
 		, m_nextState( State::Ready )
+		, m_songNoteQueue( static_cast<int>( Preferences::get_instance()->m_nMaxNotes ) *
+						   NotePool::nSlotsPerVoice )
+		, m_noteProgram( NoteProgram::nDefaultCapacity )
+		, m_bReserveNoteProgram( false )
+		, m_nReservedNotesRevision( -1 )
 		, m_fProcessTime( 0.0f )
 		, m_fLadspaTime( 0.0f )
 		, m_fMaxProcessTime( 0.0f )
@@ -133,6 +138,12 @@ AudioEngine::AudioEngine()
 	
 	m_pSampler = new Sampler;
 	m_pSynth = new Synth;
+	// Changes of the maximum number of notes will only be taken
+	// into account after a restart.
+	m_pTempoMap = new TempoMap();
+	m_pNotePool = new NotePool( static_cast<int>( Preferences::get_instance()->m_nMaxNotes ) *
+								NotePool::nSlotsPerVoice );
+	m_pDspProfiler = new DspProfiler();
 	
 	gettimeofday( &m_currentTickTime, nullptr );
 	
@@ -197,6 +208,9 @@ AudioEngine::~AudioEngine()
 //	delete Sequencer::get_instance();
 	delete m_pSampler;
 	delete m_pSynth;
+	delete m_pNotePool;
+	delete m_pDspProfiler;
+	delete m_pTempoMap;
 }
 
 Sampler* AudioEngine::getSampler() const
@@ -205,6 +219,18 @@ Sampler* AudioEngine::getSampler() const
 	return m_pSampler;
 }
 
+NotePool* AudioEngine::getNotePool() const
+{
+	assert(m_pNotePool);
+	return m_pNotePool;
+}
+
+DspProfiler* AudioEngine::getDspProfiler() const
+{
+	assert(m_pDspProfiler);
+	return m_pDspProfiler;
+}
+
 Synth* AudioEngine::getSynth() const
 {
 	assert(m_pSynth);
@@ -225,6 +251,8 @@ void AudioEngine::lock( const char* file, unsigned int line, const char* functio
 	m_pLocker.line = line;
 	m_pLocker.function = function;
 	m_LockingThread = std::this_thread::get_id();
+	// The caller might add notes to the patterns.
+	m_bReserveNoteProgram = true;
 }
 
 bool AudioEngine::tryLock( const char* file, unsigned int line, const char* function )
@@ -244,6 +272,7 @@ bool AudioEngine::tryLock( const char* file, unsigned int line, const char* func
 	m_pLocker.line = line;
 	m_pLocker.function = function;
 	m_LockingThread = std::this_thread::get_id();
+	m_bReserveNoteProgram = true;
 	#ifdef H2CORE_HAVE_DEBUG
 	if ( __logger->should_log( Logger::Locks ) ) {
 		__logger->log( Logger::Locks, _class_name(), __FUNCTION__, QString( "locked" ) );
@@ -283,6 +312,11 @@ bool AudioEngine::tryLockFor( std::chrono::microseconds duration, const char* fi
 
 void AudioEngine::unlock()
 {
+	if ( m_bReserveNoteProgram ) {
+		m_bReserveNoteProgram = false;
+		reserveNoteProgram();
+	}
+
 	// Leave "__locker" dirty.
 	m_LockingThread = std::thread::id();
 	m_EngineMutex.unlock();
@@ -293,6 +327,33 @@ void AudioEngine::unlock()
 	#endif
 }
 
+void AudioEngine::reserveNoteProgram() {
+	const int nRevision = Pattern::get_notes_revision();
+	if ( nRevision == m_nReservedNotesRevision ) {
+		return;
+	}
+
+	auto pSong = Hydrogen::get_instance()->getSong();
+	if ( pSong == nullptr || pSong->getPatternList() == nullptr ) {
+		return;
+	}
+	m_nReservedNotesRevision = nRevision;
+
+	// Each pattern is contained at most once in #m_pPlayingPatterns.
+	int nNotes = 0;
+	for ( const auto& ppPattern : *pSong->getPatternList() ) {
+		if ( ppPattern != nullptr ) {
+			nNotes += static_cast<int>( ppPattern->get_notes()->size() );
+		}
+	}
+
+	if ( nNotes > m_noteProgram.capacity() ) {
+		// Leave some room for further notes to avoid reallocating
+		// the program each time a note is added.
+		m_noteProgram.reserve( 2 * nNotes );
+	}
+}
+
 void AudioEngine::startPlayback()
 {
 	INFOLOG( "" );
@@ -690,158 +751,37 @@ long long AudioEngine::computeFrameFromTick( const double fTick, double* fTickMi
 		return 0;
 	}
 		
-	const auto tempoMarkers = pTimeline->getAllTempoMarkers();
-	
-	long long nNewFrames = 0;
-	if ( pHydrogen->isTimelineEnabled() &&
-		 ! ( tempoMarkers.size() == 1 &&
-			 pTimeline->isFirstTempoMarkerSpecial() ) ) {
-
-		double fNewTick = fTick;
-		double fRemainingTicks = fTick;
-		double fNextTick, fPassedTicks = 0;
-		double fNextTickSize;
-		double fNewFrames = 0;
-
-		int nColumns = pSong->getPatternGroupVector()->size();
-
-		while ( fRemainingTicks > 0 ) {
-		
-			for ( int ii = 1; ii <= tempoMarkers.size(); ++ii ) {
-				if ( ii == tempoMarkers.size() ||
-					 tempoMarkers[ ii ]->nColumn >= nColumns ) {
-					fNextTick = m_fSongSizeInTicks;
-				} else {
-					fNextTick =
-						static_cast<double>(pHydrogen->getTickForColumn( tempoMarkers[ ii ]->nColumn ) );
-				}
-
-				fNextTickSize =
-					AudioEngine::computeDoubleTickSize( nSampleRate,
-														tempoMarkers[ ii - 1 ]->fBpm,
-														nResolution );
-				
-				if ( fRemainingTicks > ( fNextTick - fPassedTicks ) ) {
-					// The whole segment of the timeline covered by tempo
-					// marker ii is left of the current transport position.
-					fNewFrames += ( fNextTick - fPassedTicks ) * fNextTickSize;
-
-					// DEBUGLOG( QString( "[segment] fTick: %1, fNewFrames: %2, nNextTick: %3, nRemainingTicks: %4, nPassedTicks: %5, fNextTickSize: %6, col: %7, bpm: %8, tick increment: %9, frame increment: %10" )
-					// 		  .arg( fTick, 0, 'f' )
-					// 		  .arg( fNewFrames, 0, 'f' )
-					// 		  .arg( fNextTick, 0, 'f' )
-					// 		  .arg( fRemainingTicks, 0, 'f' )
-					// 		  .arg( fPassedTicks, 0, 'f' )
-					// 		  .arg( fNextTickSize, 0, 'f' )
-					// 		  .arg( tempoMarkers[ ii - 1 ]->nColumn )
-					// 		  .arg( tempoMarkers[ ii - 1 ]->fBpm )
-					// 		  .arg( fNextTick - fPassedTicks, 0, 'f' )
-					// 		  .arg( ( fNextTick - fPassedTicks ) * fNextTickSize, 0, 'g', 30 )
-					// 		  );
-					
-					fRemainingTicks -= fNextTick - fPassedTicks;
-					
-					fPassedTicks = fNextTick;
-
-				} else {
-					// We are within this segment.
-					fNewFrames += fRemainingTicks * fNextTickSize;
-
-					nNewFrames = static_cast<long long>( std::round( fNewFrames ) );
-					if ( fRemainingTicks != ( fNextTick - fPassedTicks ) ) {
-						*fTickMismatch = ( fNewFrames - static_cast<double>( nNewFrames ) ) /
-							fNextTickSize;
-					} else {
-						// We ended at the very tick containing a
-						// tempo marker. If the mismatch is negative,
-						// we round the tick to a higher value, we
-						// need to use the tick size of the next tempo
-						// marker. For positive values, the mismatch
-						// resides on "this" side of the tempo marker.
-						double fMismatchInFrames =
-							fNewFrames - static_cast<double>( nNewFrames );
-						if ( fMismatchInFrames < 0 ) {
-							// Get the tick size of the next tempo
-							// marker.
-							if ( ii < tempoMarkers.size() ) {
-
-								fNextTickSize =
-									AudioEngine::computeDoubleTickSize( nSampleRate,
-																		tempoMarkers[ ii ]->fBpm,
-																		nResolution );
-							} else {
-								fNextTickSize =
-									AudioEngine::computeDoubleTickSize( nSampleRate,
-																		tempoMarkers[ 0 ]->fBpm,
-																		nResolution );
-							}
-						}
-						*fTickMismatch = fMismatchInFrames /
-							fNextTickSize;
-					}
-
-					// DEBUGLOG( QString( "[end] fTick: %1, fNewFrames: %2, nNewFrames: %9, fTickMismatch: %10, nNextTick: %3, nRemainingTicks: %4, nPassedTicks: %5, fNextTickSize: %6, col: %7, bpm: %8, tick increment: %11, frame increment: %12" )
-					// 		  .arg( fTick, 0, 'f' )
-					// 		  .arg( fNewFrames, 0, 'g', 30 )
-					// 		  .arg( fNextTick, 0, 'f' )
-					// 		  .arg( fRemainingTicks, 0, 'f' )
-					// 		  .arg( fPassedTicks, 0, 'f' )
-					// 		  .arg( fNextTickSize, 0, 'f' )
-					// 		  .arg( tempoMarkers[ ii - 1 ]->nColumn )
-					// 		  .arg( tempoMarkers[ ii - 1 ]->fBpm )
-					// 		  .arg( nNewFrames )
-					// 		  .arg( *fTickMismatch, 0, 'g', 30 )
-					// 		  .arg( fRemainingTicks, 0, 'f' )
-					// 		  .arg( fRemainingTicks * fNextTickSize, 0, 'g', 30 )
-					// 		  );
-
-					fRemainingTicks -= fNewTick - fPassedTicks;
-					break;
-				}
+	if ( pHydrogen->isTimelineEnabled() ) {
+		// The TempoMap is rebuilt by updateTempoMap() whenever the
+		// Timeline or the song changes. Till this happened the
+		// previous map is used instead of building a new one in
+		// here, which would allocate memory within the audio
+		// thread. Only a request for a different sample rate -
+		// which the audio thread never does - is computed on the
+		// fly.
+		if ( m_pTempoMap->getSampleRate() == nSampleRate ) {
+			if ( m_pTempoMap->hasTempoMarkers() ) {
+				return m_pTempoMap->computeFrameFromTick( fTick, fTickMismatch );
 			}
-
-			if ( fRemainingTicks != 0 ) {
-				// The provided fTick is larger than the song. But,
-				// luckily, we just calculated the song length in
-				// frames (fNewFrames).
-				int nRepetitions = std::floor(fTick / m_fSongSizeInTicks);
-				double fSongSizeInFrames = fNewFrames;
-				
-				fNewFrames *= static_cast<double>(nRepetitions);
-				fNewTick = std::fmod( fTick, m_fSongSizeInTicks );
-				fRemainingTicks = fNewTick;
-				fPassedTicks = 0;
-
-				// DEBUGLOG( QString( "[repeat] frames covered: %1, ticks covered: %2, ticks remaining: %3, nRepetitions: %4, fSongSizeInFrames: %5" )
-				// 		  .arg( fNewFrames, 0, 'g', 30 )
-				// 		  .arg( fTick - fNewTick, 0, 'g', 30 )
-				// 		  .arg( fRemainingTicks, 0, 'g', 30 )
-				// 		  .arg( nRepetitions )
-				// 		  .arg( fSongSizeInFrames, 0, 'g', 30 )
-				// 		  );
-
-				if ( std::isinf( fNewFrames ) ||
-					 static_cast<long long>(fNewFrames) >
-					 std::numeric_limits<long long>::max() ) {
-					ERRORLOG( QString( "Provided ticks [%1] are too large." ).arg( fTick ) );
-					return 0;
-				}
+		} else {
+			TempoMap tempoMap;
+			tempoMap.update( pSong, pTimeline, m_fSongSizeInTicks, nSampleRate );
+			if ( tempoMap.hasTempoMarkers() ) {
+				return tempoMap.computeFrameFromTick( fTick, fTickMismatch );
 			}
 		}
-	} else {
-		
-		// No Timeline but a single tempo for the whole song.
-		double fNewFrames = static_cast<double>(fTick) *
-			fTickSize;
-		nNewFrames = static_cast<long long>( std::round( fNewFrames ) );
-		*fTickMismatch = ( fNewFrames - static_cast<double>(nNewFrames ) ) /
-			fTickSize;
-
-		// DEBUGLOG(QString("[no-timeline] nNewFrames: %1, fTick: %2, fTickSize: %3, fTickMismatch: %4" )
-		// 		 .arg( nNewFrames ).arg( fTick, 0, 'f' ).arg( fTickSize, 0, 'f' )
-		// 		 .arg( *fTickMismatch, 0, 'g', 30 ));
-		
 	}
+
+	// No Timeline but a single tempo for the whole song.
+	double fNewFrames = static_cast<double>(fTick) *
+		fTickSize;
+	long long nNewFrames = static_cast<long long>( std::round( fNewFrames ) );
+	*fTickMismatch = ( fNewFrames - static_cast<double>(nNewFrames ) ) /
+		fTickSize;
+
+	// DEBUGLOG(QString("[no-timeline] nNewFrames: %1, fTick: %2, fTickSize: %3, fTickMismatch: %4" )
+	// 		 .arg( nNewFrames ).arg( fTick, 0, 'f' ).arg( fTickSize, 0, 'f' )
+	// 		 .arg( *fTickMismatch, 0, 'g', 30 ));
 	
 	return nNewFrames;
 }
@@ -877,131 +817,26 @@ double AudioEngine::computeTickFromFrame( const long long nFrame, int nSampleRat
 		return fTick;
 	}
 		
-	const auto tempoMarkers = pTimeline->getAllTempoMarkers();
-	
-	if ( pHydrogen->isTimelineEnabled() &&
-		 ! ( tempoMarkers.size() == 1 &&
-			 pTimeline->isFirstTempoMarkerSpecial() ) ) {
-
-		// We are using double precision in here to avoid rounding
-		// errors.
-		double fTargetFrames = static_cast<double>(nFrame);
-		double fPassedFrames = 0;
-		double fNextFrames = 0;
-		double fNextTicks, fPassedTicks = 0;
-		double fNextTickSize;
-		long long nRemainingFrames;
-
-		int nColumns = pSong->getPatternGroupVector()->size();
-
-		while ( fPassedFrames < fTargetFrames ) {
-		
-			for ( int ii = 1; ii <= tempoMarkers.size(); ++ii ) {
-
-				fNextTickSize =
-					AudioEngine::computeDoubleTickSize( nSampleRate,
-														tempoMarkers[ ii - 1 ]->fBpm,
-														nResolution );
-				if ( ii == tempoMarkers.size() ||
-					 tempoMarkers[ ii ]->nColumn >= nColumns ) {
-					fNextTicks = m_fSongSizeInTicks;
-				} else {
-					fNextTicks =
-						static_cast<double>(pHydrogen->getTickForColumn( tempoMarkers[ ii ]->nColumn ));
-				}
-				fNextFrames = (fNextTicks - fPassedTicks) * fNextTickSize;
-		
-				if ( fNextFrames < ( fTargetFrames -
-									 fPassedFrames ) ) {
-
-					// DEBUGLOG(QString( "[segment] nFrame: %1, fTick: %11, sampleRate: %2, tickSize: %3, nNextTicks: %5, fNextFrames: %6, col: %7, bpm: %8, nPassedTicks: %9, fPassedFrames: %10, tick increment: %12, frame increment: %13" )
-					// 		 .arg( nFrame )
-					// 		 .arg( nSampleRate )
-					// 		 .arg( fNextTickSize, 0, 'f' )
-					// 		 .arg( fNextTicks, 0, 'f' )
-					// 		 .arg( fNextFrames, 0, 'f' )
-					// 		 .arg( tempoMarkers[ ii -1 ]->nColumn )
-					// 		 .arg( tempoMarkers[ ii -1 ]->fBpm )
-					// 		 .arg( fPassedTicks, 0, 'f' )
-					// 		 .arg( fPassedFrames, 0, 'f' )
-					// 		 .arg( fTick, 0, 'f' )
-					// 		 .arg( fNextTicks - fPassedTicks, 0, 'f' )
-					// 		 .arg( (fNextTicks - fPassedTicks) * fNextTickSize, 0, 'g', 30 )
-					// 		 );
-					
-					// The whole segment of the timeline covered by tempo
-					// marker ii is left of the transport position.
-					fTick += fNextTicks - fPassedTicks;
-
-					fPassedFrames += fNextFrames;
-					fPassedTicks = fNextTicks;
-
-				} else {
-					// We are within this segment.
-					// We use a floor in here because only integers
-					// frames are supported.
-					double fNewTick = (fTargetFrames - fPassedFrames ) /
-						fNextTickSize;
-
-					fTick += fNewTick;
-											
-					fPassedFrames = fTargetFrames;
-					
-					// DEBUGLOG(QString( "[end] nFrame: %1, fTick: %11, sampleRate: %2, tickSize: %3, nNextTicks: %5, fNextFrames: %6, col: %7, bpm: %8, nPassedTicks: %9, fPassedFrames: %10, tick increment: %12, frame increment: %13" )
-					// 		 .arg( nFrame )
-					// 		 .arg( nSampleRate )
-					// 		 .arg( fNextTickSize, 0, 'f' )
-					// 		 .arg( fNextTicks, 0, 'f' )
-					// 		 .arg( fNextFrames, 0, 'f' )
-					// 		 .arg( tempoMarkers[ ii -1 ]->nColumn )
-					// 		 .arg( tempoMarkers[ ii -1 ]->fBpm )
-					// 		 .arg( fPassedTicks, 0, 'f' )
-					// 		 .arg( fPassedFrames, 0, 'f' )
-					// 		 .arg( fTick, 0, 'f' )
-					// 		 .arg( fNewTick, 0, 'f' )
-					// 		 .arg( fNewTick * fNextTickSize, 0, 'g', 30 )
-					// 		 );
-					
-					break;
-				}
+	if ( pHydrogen->isTimelineEnabled() ) {
+		// See computeFrameFromTick().
+		if ( m_pTempoMap->getSampleRate() == nSampleRate ) {
+			if ( m_pTempoMap->hasTempoMarkers() ) {
+				return m_pTempoMap->computeTickFromFrame( nFrame );
 			}
-
-			if ( fPassedFrames != fTargetFrames ) {
-				// The provided nFrame is larger than the song. But,
-				// luckily, we just calculated the song length in
-				// frames.
-				double fSongSizeInFrames = fPassedFrames;
-				int nRepetitions = std::floor(fTargetFrames / fSongSizeInFrames);
-				if ( m_fSongSizeInTicks * nRepetitions >
-					 std::numeric_limits<double>::max() ) {
-					ERRORLOG( QString( "Provided frames [%1] are too large." ).arg( nFrame ) );
-					return 0;
-				}
-				fTick = m_fSongSizeInTicks * nRepetitions;
-
-				fPassedFrames = static_cast<double>(nRepetitions) *
-					fSongSizeInFrames;
-				fPassedTicks = 0;
-
-				// DEBUGLOG( QString( "[repeat] frames covered: %1, frames remaining: %2, ticks covered: %3,  nRepetitions: %4, fSongSizeInFrames: %5" )
-				// 		  .arg( fPassedFrames, 0, 'g', 30 )
-				// 		  .arg( fTargetFrames - fPassedFrames, 0, 'g', 30 )
-				// 		  .arg( fTick, 0, 'g', 30 )
-				// 		  .arg( nRepetitions )
-				// 		  .arg( fSongSizeInFrames, 0, 'g', 30 )
-				// 		  );
-				
+		} else {
+			TempoMap tempoMap;
+			tempoMap.update( pSong, pTimeline, m_fSongSizeInTicks, nSampleRate );
+			if ( tempoMap.hasTempoMarkers() ) {
+				return tempoMap.computeTickFromFrame( nFrame );
 			}
 		}
-	} else {
-	
-		// No Timeline. Constant tempo/tick size for the whole song.
-		fTick = static_cast<double>(nFrame) / fTickSize;
+	}
 
-		// DEBUGLOG(QString( "[no timeline] nFrame: %1, sampleRate: %2, tickSize: %3" )
-		// 		 .arg( nFrame ).arg( nSampleRate ).arg( fTickSize, 0, 'f' ) );
+	// No Timeline. Constant tempo/tick size for the whole song.
+	fTick = static_cast<double>(nFrame) / fTickSize;
 
-	}
+	// DEBUGLOG(QString( "[no timeline] nFrame: %1, sampleRate: %2, tickSize: %3" )
+	// 		 .arg( nFrame ).arg( nSampleRate ).arg( fTickSize, 0, 'f' ) );
 	
 	return fTick;
 }
@@ -1315,6 +1150,10 @@ void AudioEngine::handleDriverChange() {
 	}
 	
 	handleTimelineChange();
+
+	// The playback track was converted to the sample rate of the
+	// previous driver.
+	m_pSampler->updatePlaybackTrackSampleRate();
 }
 
 float AudioEngine::getBpmAtColumn( int nColumn ) {
@@ -1493,15 +1332,17 @@ void AudioEngine::processPlayNotes( unsigned long nframes )
 			 */
 			auto  noteInstrument = pNote->get_instrument();
 			if ( noteInstrument->is_stop_notes() ){
-				Note *pOffNote = new Note( noteInstrument,
-										   0.0,
-										   0.0,
-										   0.0,
-										   -1,
-										   0 );
-				pOffNote->set_note_off( true );
-				pHydrogen->getAudioEngine()->getSampler()->noteOn( pOffNote );
-				delete pOffNote;
+				Note *pOffNote = m_pNotePool->create( noteInstrument,
+													  0.0,
+													  0.0,
+													  0.0,
+													  -1,
+													  0 );
+				if ( pOffNote != nullptr ) {
+					pOffNote->set_note_off( true );
+					m_pSampler->noteOn( pOffNote );
+					m_pNotePool->release( pOffNote );
+				}
 			}
 
 			m_pSampler->noteOn( pNote );
@@ -1510,7 +1351,7 @@ void AudioEngine::processPlayNotes( unsigned long nframes )
 			// raise noteOn event
 			int nInstrument = pSong->getInstrumentList()->index( pNote->get_instrument() );
 			if( pNote->get_note_off() ){
-				delete pNote;
+				m_pNotePool->release( pNote );
 			}
 
 			// Check whether the instrument could be found.
@@ -1531,13 +1372,13 @@ void AudioEngine::clearNoteQueue()
 	// delete all copied notes in the song notes queue
 	while (!m_songNoteQueue.empty()) {
 		m_songNoteQueue.top()->get_instrument()->dequeue();
-		delete m_songNoteQueue.top();
+		m_pNotePool->release( m_songNoteQueue.top() );
 		m_songNoteQueue.pop();
 	}
 
 	// delete all copied notes in the midi notes queue
 	for ( unsigned i = 0; i < m_midiNoteQueue.size(); ++i ) {
-		delete m_midiNoteQueue[i];
+		m_pNotePool->release( m_midiNoteQueue[i] );
 	}
 	m_midiNoteQueue.clear();
 }
@@ -1545,7 +1386,9 @@ void AudioEngine::clearNoteQueue()
 int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 {
 	AudioEngine* pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
-	timeval startTimeval = currentTime2();
+	DspProfiler* pProfiler = pAudioEngine->m_pDspProfiler;
+	const uint64_t nProfilerStart = DspProfiler::now();
+	const long long nCycleStartTime = MidiMessage::currentTimestamp();
 
 	// Resetting all audio output buffers with zeros.
 	pAudioEngine->clearAudioBuffers( nframes );
@@ -1558,6 +1401,7 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 	float sampleRate = static_cast<float>(pAudioEngine->m_pAudioDriver->getSampleRate());
 	pAudioEngine->m_fMaxProcessTime = 1000.0 / ( sampleRate / nframes );
 	float fSlackTime = pAudioEngine->m_fMaxProcessTime - pAudioEngine->m_fProcessTime;
+	pProfiler->beginCycle( nProfilerStart, nframes, sampleRate );
 
 	// If we expect to take longer than the available time to process,
 	// require immediate locking or not at all: we're bound to drop a
@@ -1573,8 +1417,13 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 	 * audio processing. Returning the special return value "2" enables the disk 
 	 * writer driver to repeat the processing of the current data.
 	 */
-	if ( !pAudioEngine->tryLockFor( std::chrono::microseconds( (int)(1000.0*fSlackTime) ),
-							  RIGHT_HERE ) ) {
+	uint64_t nStageStart = DspProfiler::now();
+	const bool bLocked =
+		pAudioEngine->tryLockFor( std::chrono::microseconds( (int)(1000.0*fSlackTime) ),
+								  RIGHT_HERE );
+	pProfiler->addStage( DspProfiler::Stage::LockWait, DspProfiler::now() - nStageStart );
+	if ( ! bLocked ) {
+		pProfiler->endCycle( DspProfiler::now(), true );
 		___ERRORLOG( QString( "Failed to lock audioEngine in allowed %1 ms, missed buffer" ).arg( fSlackTime ) );
 
 		if ( dynamic_cast<DiskWriterDriver*>(pAudioEngine->m_pAudioDriver) != nullptr ) {
@@ -1586,6 +1435,7 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 
 	if ( ! ( pAudioEngine->getState() == AudioEngine::State::Ready ||
 			 pAudioEngine->getState() == AudioEngine::State::Playing ) ) {
+		pProfiler->endCycle( DspProfiler::now() );
 		pAudioEngine->unlock();
 		return 0;
 	}
@@ -1628,10 +1478,27 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 		pAudioEngine->setRealtimeFrames( pAudioEngine->getRealtimeFrames() +
 										 static_cast<long long>(nframes) );
 	}
+
+	// Reference used to place incoming MIDI events.
+	pAudioEngine->m_nCycleStartTime = nCycleStartTime;
+	pAudioEngine->m_nCycleStartJackFrame = -1;
+	if ( Hydrogen::get_instance()->haveJackAudioDriver() ) {
+		pAudioEngine->m_nCycleStartJackFrame =
+			static_cast<JackAudioDriver*>( pAudioEngine->m_pAudioDriver )->getCycleFrameTime();
+	}
+	if ( pAudioEngine->getState() == State::Playing ||
+		 pAudioEngine->getState() == State::Testing ) {
+		pAudioEngine->m_nCycleStartFrame = pAudioEngine->getFrames();
+	} else {
+		pAudioEngine->m_nCycleStartFrame = pAudioEngine->getRealtimeFrames();
+	}
    
 	// always update note queue.. could come from pattern or realtime input
 	// (midi, keyboard)
+	nStageStart = DspProfiler::now();
 	int nResNoteQueue = pAudioEngine->updateNoteQueue( nframes );
+	pProfiler->addStage( DspProfiler::Stage::UpdateNoteQueue,
+						 DspProfiler::now() - nStageStart );
 	if ( nResNoteQueue == -1 ) {	// end of song
 		___INFOLOG( "End of song received" );
 		pAudioEngine->stop();
@@ -1640,6 +1507,7 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 
 		if ( dynamic_cast<FakeDriver*>(pAudioEngine->m_pAudioDriver) != nullptr ) {
 			___INFOLOG( "End of song." );
+			pProfiler->endCycle( DspProfiler::now() );
 			
 			return 1;	// kill the audio AudioDriver thread
 		}
@@ -1652,10 +1520,9 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 		pAudioEngine->incrementTransportPosition( nframes );
 	}
 
-	timeval finishTimeval = currentTime2();
-	pAudioEngine->m_fProcessTime =
-			( finishTimeval.tv_sec - startTimeval.tv_sec ) * 1000.0
-			+ ( finishTimeval.tv_usec - startTimeval.tv_usec ) / 1000.0;
+	pProfiler->endCycle( DspProfiler::now() );
+	pAudioEngine->m_fProcessTime = pProfiler->getLastCycleUs() / 1000.0;
+	pAudioEngine->m_fLadspaTime = pProfiler->getLastLadspaUs() / 1000.0;
 	
 #ifdef CONFIG_DEBUG
 	if ( pAudioEngine->m_fProcessTime > pAudioEngine->m_fMaxProcessTime ) {
@@ -1664,7 +1531,7 @@ int AudioEngine::audioEngine_process( uint32_t nframes, void* /*arg*/ )
 		___WARNINGLOG( QString( "XRUN of %1 msec (%2 > %3)" )
 					   .arg( ( pAudioEngine->m_fProcessTime - pAudioEngine->m_fMaxProcessTime ) )
 					   .arg( pAudioEngine->m_fProcessTime ).arg( pAudioEngine->m_fMaxProcessTime ) );
-		___WARNINGLOG( QString( "Ladspa process time = %1" ).arg( fLadspaTime ) );
+		___WARNINGLOG( QString( "Ladspa process time = %1" ).arg( pAudioEngine->m_fLadspaTime ) );
 		___WARNINGLOG( "------------" );
 		___WARNINGLOG( "" );
 		// raise xRun event
@@ -1682,7 +1549,10 @@ void AudioEngine::processAudio( uint32_t nFrames ) {
 	auto pSong = Hydrogen::get_instance()->getSong();
 
 	// play all notes
+	uint64_t nStageStart = DspProfiler::now();
 	processPlayNotes( nFrames );
+	m_pDspProfiler->addStage( DspProfiler::Stage::ProcessPlayNotes,
+							  DspProfiler::now() - nStageStart );
 
 	float *pBuffer_L = m_pAudioDriver->getOut_L(),
 		*pBuffer_R = m_pAudioDriver->getOut_R();
@@ -1698,6 +1568,7 @@ void AudioEngine::processAudio( uint32_t nFrames ) {
 	}
 
 	// SYNTH
+	nStageStart = DspProfiler::now();
 	getSynth()->process( nFrames );
 	out_L = getSynth()->m_pOut_L;
 	out_R = getSynth()->m_pOut_R;
@@ -1705,14 +1576,15 @@ void AudioEngine::processAudio( uint32_t nFrames ) {
 		pBuffer_L[ i ] += out_L[ i ];
 		pBuffer_R[ i ] += out_R[ i ];
 	}
-
-	timeval ladspaTime_start = currentTime2();
+	m_pDspProfiler->addStage( DspProfiler::Stage::Synth, DspProfiler::now() - nStageStart );
 
 #ifdef H2CORE_HAVE_LADSPA
 	// Process LADSPA FX
+	const uint64_t nLadspaStart = DspProfiler::now();
 	for ( unsigned nFX = 0; nFX < MAX_FX; ++nFX ) {
 		LadspaFX *pFX = Effects::get_instance()->getLadspaFX( nFX );
 		if ( ( pFX ) && ( pFX->isEnabled() ) ) {
+			nStageStart = DspProfiler::now();
 			pFX->processFX( nFrames );
 
 			float *buf_L, *buf_R;
@@ -1735,15 +1607,14 @@ void AudioEngine::processAudio( uint32_t nFrames ) {
 					m_fFXPeak_R[nFX] = buf_R[ i ];
 				}
 			}
+			m_pDspProfiler->addLadspa( nFX, DspProfiler::now() - nStageStart );
 		}
 	}
+	m_pDspProfiler->addStage( DspProfiler::Stage::Ladspa, DspProfiler::now() - nLadspaStart );
 #endif
-	timeval ladspaTime_end = currentTime2();
-	m_fLadspaTime =
-			( ladspaTime_end.tv_sec - ladspaTime_start.tv_sec ) * 1000.0
-			+ ( ladspaTime_end.tv_usec - ladspaTime_start.tv_usec ) / 1000.0;
 
 	// update master peaks
+	nStageStart = DspProfiler::now();
 	float val_L, val_R;
 	for ( unsigned i = 0; i < nFrames; ++i ) {
 		val_L = pBuffer_L[i];
@@ -1771,7 +1642,7 @@ void AudioEngine::processAudio( uint32_t nFrames ) {
 			}
 		}
 	}
-
+	m_pDspProfiler->addStage( DspProfiler::Stage::Metering, DspProfiler::now() - nStageStart );
 }
 
 void AudioEngine::setState( AudioEngine::State state ) {
@@ -1816,6 +1687,7 @@ void AudioEngine::setSong( std::shared_ptr<Song> pNewSong )
 	// pattern mode.
 	if ( pNewSong->getPatternList()->size() > 0 ) {
 		m_pPlayingPatterns->add( pNewSong->getPatternList()->get( 0 ) );
+		m_noteProgram.invalidate();
 		m_nPatternSize = m_pPlayingPatterns->longest_pattern_length();
 	} else {
 		m_nPatternSize = MAX_NOTES;
@@ -1833,6 +1705,7 @@ void AudioEngine::setSong( std::shared_ptr<Song> pNewSong )
 
 	Hydrogen::get_instance()->setTimeline( pNewSong->getTimeline() );
 	Hydrogen::get_instance()->getTimeline()->activate();
+	updateTempoMap();
 
 	this->unlock();
 }
@@ -1856,6 +1729,7 @@ void AudioEngine::removeSong()
 
 	m_pPlayingPatterns->clear();
 	m_pNextPatterns->clear();
+	m_noteProgram.invalidate();
 	clearNoteQueue();
 	m_pSampler->stopPlayingNotes();
 
@@ -1883,6 +1757,7 @@ void AudioEngine::updateSongSize() {
 	EventQueue::get_instance()->push_event( EVENT_SONG_SIZE_CHANGED, 0 );
 
 	if ( pHydrogen->getMode() == Song::Mode::Pattern ) {
+		updateTempoMap();
 		return;
 	}
 
@@ -1909,6 +1784,7 @@ void AudioEngine::updateSongSize() {
 
 	//
 	m_fSongSizeInTicks = fNewSongSizeInTicks;
+	updateTempoMap();
 
 	// Expected behavior:
 	// - changing any part of the song except of the pattern currently
@@ -2000,12 +1876,17 @@ void AudioEngine::updateSongSize() {
 
 void AudioEngine::removePlayingPattern( int nIndex ) {
 	m_pPlayingPatterns->del( nIndex );
+	m_noteProgram.invalidate();
 }
 
 void AudioEngine::updatePlayingPatterns( int nColumn, long nTick ) {
 	auto pHydrogen = Hydrogen::get_instance();
 	auto pSong = pHydrogen->getSong();
 
+	// Triggers a recompilation of the notes played back in
+	// updateNoteQueue().
+	m_noteProgram.invalidate();
+
 	if ( pHydrogen->getMode() == Song::Mode::Song ) {
 		// Called when transport enteres a new column.
 		m_pPlayingPatterns->clear();
@@ -2127,6 +2008,8 @@ void AudioEngine::flushAndAddNextPattern( int nPatternNumber ) {
 
 void AudioEngine::handleTimelineChange() {
 
+	updateTempoMap();
+
 	setFrames( computeFrameFromTick( getDoubleTick(), &m_fTickMismatch ) );
 	updateBpmAndTickSize();
 
@@ -2139,21 +2022,24 @@ void AudioEngine::handleTimelineChange() {
 
 	// Recalculate the note start in frames for all notes currently
 	// processed by the AudioEngine.
-	if ( m_songNoteQueue.size() > 0 ) {
-		std::vector<Note*> notes;
-		for ( ; ! m_songNoteQueue.empty(); m_songNoteQueue.pop() ) {
-			notes.push_back( m_songNoteQueue.top() );
-		}
-
-		for ( auto nnote : notes ) {
-			nnote->computeNoteStart();
-			m_songNoteQueue.push( nnote );
-		}
-	}
+	m_songNoteQueue.updateAll( []( Note* pNote ) {
+		pNote->computeNoteStart();
+	} );
 	
 	getSampler()->handleTimelineOrTempoChange();
 }
 
+void AudioEngine::updateTempoMap() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pSong = pHydrogen->getSong();
+	if ( pSong == nullptr || m_pAudioDriver == nullptr ) {
+		return;
+	}
+
+	m_pTempoMap->update( pSong, pHydrogen->getTimeline(), m_fSongSizeInTicks,
+						 m_pAudioDriver->getSampleRate() );
+}
+
 void AudioEngine::handleTempoChange() {
 	if ( m_songNoteQueue.size() == 0 ) {
 		return;
@@ -2164,17 +2050,9 @@ void AudioEngine::handleTempoChange() {
 	if ( m_songNoteQueue.top()->getUsedTickSize() !=
 		 getTickSize() ) {
 
-		std::vector<Note*> notes;
-		for ( ; ! m_songNoteQueue.empty(); m_songNoteQueue.pop() ) {
-			notes.push_back( m_songNoteQueue.top() );
-		}
-
-		// All notes share the same ticksize state (or things have gone
-		// wrong at some point).
-		for ( auto nnote : notes ) {
-			nnote->computeNoteStart();
-			m_songNoteQueue.push( nnote );
-		}
+		m_songNoteQueue.updateAll( []( Note* pNote ) {
+			pNote->computeNoteStart();
+		} );
 	
 		getSampler()->handleTimelineOrTempoChange();
 	}
@@ -2185,12 +2063,8 @@ void AudioEngine::handleSongSizeChange() {
 		return;
 	}
 
-	std::vector<Note*> notes;
-	for ( ; ! m_songNoteQueue.empty(); m_songNoteQueue.pop() ) {
-		notes.push_back( m_songNoteQueue.top() );
-	}
-
-	for ( auto nnote : notes ) {
+	const long nTickOffset = static_cast<long>(std::floor(getTickOffset()));
+	m_songNoteQueue.updateAll( [nTickOffset]( Note* nnote ) {
 
 		// DEBUGLOG( QString( "name: %1, pos: %2, new pos: %3, tick offset: %4, tick offset floored: %5" )
 		// 		  .arg( nnote->get_instrument()->get_name() )
@@ -2201,12 +2075,10 @@ void AudioEngine::handleSongSizeChange() {
 		// 		  .arg( getTickOffset() )
 		// 		  .arg( std::floor(getTickOffset()) ) );
 		
-		nnote->set_position( std::max( nnote->get_position() +
-									   static_cast<long>(std::floor(getTickOffset())),
+		nnote->set_position( std::max( nnote->get_position() + nTickOffset,
 									   static_cast<long>(0) ) );
 		nnote->computeNoteStart();
-		m_songNoteQueue.push( nnote );
-	}
+	} );
 	
 	getSampler()->handleSongSizeChange();
 }
@@ -2324,6 +2196,13 @@ int AudioEngine::updateNoteQueue( unsigned nFrames )
 		m_midiNoteQueue.pop_front();
 		pNote->get_instrument()->enqueue();
 		pNote->computeNoteStart();
+		if ( pNote->hasFixedNoteStart() &&
+			 pNote->getNoteStart() > m_nCycleStartFrame + 2 * static_cast<long long>(nFrames) ) {
+			// The start of this realtime note was computed before
+			// transport was started or stopped and refers to a
+			// different frame domain. Play it right away.
+			pNote->setNoteStart( 0 );
+		}
 		m_songNoteQueue.push( pNote );
 	}
 
@@ -2417,16 +2296,18 @@ int AudioEngine::updateNoteQueue( unsigned nFrames )
 				m_pMetronomeInstrument->set_volume(
 							Preferences::get_instance()->m_fMetronomeVolume
 							);
-				Note *pMetronomeNote = new Note( m_pMetronomeInstrument,
-												 nnTick,
-												 fVelocity,
-												 0.f, // pan
-												 -1,
-												 fPitch
-												 );
-				m_pMetronomeInstrument->enqueue();
-				pMetronomeNote->computeNoteStart();
-				m_songNoteQueue.push( pMetronomeNote );
+				Note *pMetronomeNote = m_pNotePool->create( m_pMetronomeInstrument,
+															nnTick,
+															fVelocity,
+															0.f, // pan
+															-1,
+															fPitch
+															);
+				if ( pMetronomeNote != nullptr ) {
+					m_pMetronomeInstrument->enqueue();
+					pMetronomeNote->computeNoteStart();
+					m_songNoteQueue.push( pMetronomeNote );
+				}
 			}
 		}
 
@@ -2434,131 +2315,157 @@ int AudioEngine::updateNoteQueue( unsigned nFrames )
 		// Update the notes queue.
 		//
 		// Supporting ticks with float precision:
-		// - make FOREACH_NOTE_CST_IT_BOUND loop over all notes
-		// `(_it)->first >= (_bound) && (_it)->first < (_bound + 1)`
+		// - store the fractional part of the tick in
+		// NoteProgram::Event and visit all notes within
+		// `[nnTick, nnTick + 1)` in NoteProgram::forEachNoteAt()
 		// - add remainder of pNote->get_position() % 1 when setting
 		// nnTick as new position.
 		//
-		if ( m_pPlayingPatterns->size() != 0 ) {
-			for ( unsigned nPat = 0 ;
-				  nPat < m_pPlayingPatterns->size() ;
-				  ++nPat ) {
-				Pattern *pPattern = m_pPlayingPatterns->get( nPat );
-				assert( pPattern != nullptr );
-				Pattern::notes_t* notes = (Pattern::notes_t*)pPattern->get_notes();
-
-				// Loop over all notes at tick nPatternTickPosition
-				// (associated tick is determined by Note::__position
-				// at the time of insertion into the Pattern).
-				FOREACH_NOTE_CST_IT_BOUND(notes, it, m_nPatternTickPosition) {
-					Note *pNote = it->second;
-					if ( pNote ) {
-						pNote->set_just_recorded( false );
-						
-						/** Time Offset in frames (relative to sample rate)
-						*	Sum of 3 components: swing, humanized timing, lead_lag
-						*/
-						int nOffset = 0;
-
-					   /** Swing 16ths //
-						* delay the upbeat 16th-notes by a constant (manual) offset
-						*/
-						if ( ( ( m_nPatternTickPosition % ( MAX_NOTES / 16 ) ) == 0 )
-							 && ( ( m_nPatternTickPosition % ( MAX_NOTES / 8 ) ) != 0 )
-							 && pSong->getSwingFactor() > 0 ) {
-							/* TODO: incorporate the factor MAX_NOTES / 32. either in Song::m_fSwingFactor
-							* or make it a member variable.
-							* comment by oddtime:
-							* 32 depends on the fact that the swing is applied to the upbeat 16th-notes.
-							* (not to upbeat 8th-notes as in jazz swing!).
-							* however 32 could be changed but must be >16, otherwise the max delay is too long and
-							* the swing note could be played after the next downbeat!
-							*/
-							// If the Timeline is activated, the tick
-							// size may change at any
-							// point. Therefore, the length in frames
-							// of a 16-th note offset has to be
-							// calculated for a particular transport
-							// position and is not generally applicable.
-							nOffset +=
-								computeFrameFromTick( nnTick + MAX_NOTES / 32., &fTickMismatch ) *
-								pSong->getSwingFactor() -
-								computeFrameFromTick( nnTick, &fTickMismatch );
-						}
+		if ( ! m_noteProgram.isValid() ) {
+			// Either the column changed or the patterns were edited.
+			m_noteProgram.compile( m_pPlayingPatterns );
+		}
 
-						/* Humanize - Time parameter //
-						* Add a random offset to each note. Due to
-						* the nature of the Gaussian distribution,
-						* the factor Song::__humanize_time_value will
-						* also scale the variance of the generated
-						* random variable.
-						*/
-						if ( pSong->getHumanizeTimeValue() != 0 ) {
-							nOffset += ( int )(
-										getGaussian( 0.3 )
-										* pSong->getHumanizeTimeValue()
-										* AudioEngine::nMaxTimeHumanize
-										);
-						}
+		// Loop over all notes at tick nPatternTickPosition
+		// (associated tick is determined by Note::__position
+		// at the time of insertion into the Pattern).
+		m_noteProgram.forEachNoteAt( m_nPatternTickPosition, [&]( Note* pNote ) {
+			pNote->set_just_recorded( false );
+			
+			/** Time Offset in frames (relative to sample rate)
+			*	Sum of 3 components: swing, humanized timing, lead_lag
+			*/
+			int nOffset = 0;
+
+		   /** Swing 16ths //
+			* delay the upbeat 16th-notes by a constant (manual) offset
+			*/
+			if ( ( ( m_nPatternTickPosition % ( MAX_NOTES / 16 ) ) == 0 )
+				 && ( ( m_nPatternTickPosition % ( MAX_NOTES / 8 ) ) != 0 )
+				 && pSong->getSwingFactor() > 0 ) {
+				/* TODO: incorporate the factor MAX_NOTES / 32. either in Song::m_fSwingFactor
+				* or make it a member variable.
+				* comment by oddtime:
+				* 32 depends on the fact that the swing is applied to the upbeat 16th-notes.
+				* (not to upbeat 8th-notes as in jazz swing!).
+				* however 32 could be changed but must be >16, otherwise the max delay is too long and
+				* the swing note could be played after the next downbeat!
+				*/
+				// If the Timeline is activated, the tick
+				// size may change at any
+				// point. Therefore, the length in frames
+				// of a 16-th note offset has to be
+				// calculated for a particular transport
+				// position and is not generally applicable.
+				nOffset +=
+					computeFrameFromTick( nnTick + MAX_NOTES / 32., &fTickMismatch ) *
+					pSong->getSwingFactor() -
+					computeFrameFromTick( nnTick, &fTickMismatch );
+			}
 
-						// Lead or Lag - timing parameter //
-						// Add a constant offset to all notes.
-						nOffset += (int) ( pNote->get_lead_lag() * nLeadLagFactor );
+			/* Humanize - Time parameter //
+			* Add a random offset to each note. Due to
+			* the nature of the Gaussian distribution,
+			* the factor Song::__humanize_time_value will
+			* also scale the variance of the generated
+			* random variable.
+			*/
+			if ( pSong->getHumanizeTimeValue() != 0 ) {
+				nOffset += ( int )(
+							getGaussian( 0.3 )
+							* pSong->getHumanizeTimeValue()
+							* AudioEngine::nMaxTimeHumanize
+							);
+			}
 
-						// Lower bound of the offset. No note is
-						// allowed to start prior to the beginning of
-						// the song.
-						if( nNoteStart + nOffset < 0 ){
-							nOffset = -nNoteStart;
-						}
+			// Lead or Lag - timing parameter //
+			// Add a constant offset to all notes.
+			nOffset += (int) ( pNote->get_lead_lag() * nLeadLagFactor );
 
-						if ( nOffset > AudioEngine::nMaxTimeHumanize ) {
-							nOffset = AudioEngine::nMaxTimeHumanize;
-						} else if ( nOffset < -1 * AudioEngine::nMaxTimeHumanize ) {
-							nOffset = -AudioEngine::nMaxTimeHumanize;
-						}
-						
-						// Generate a copy of the current note, assign
-						// it the new offset, and push it to the list
-						// of all notes, which are about to be played
-						// back.
-						//
-						// Why a copy? because it has the new offset
-						// (including swing and random timing) in its
-						// humanized delay, and tick position is
-						// expressed referring to start time (and not
-						// pattern).
-						Note *pCopiedNote = new Note( pNote );
-						pCopiedNote->set_humanize_delay( nOffset );
-
-						// DEBUGLOG( QString( "getDoubleTick(): %1, getFrames(): %2, getColumn(): %3, nnTick: %4, nColumn: %5, " )
-						// 		  .arg( getDoubleTick() ).arg( getFrames() )
-						// 		  .arg( getColumn() ).arg( nnTick )
-						// 		  .arg( nColumn )
-						// 		  .append( pCopiedNote->toQString("", true ) ) );
-						
-						pCopiedNote->set_position( nnTick );
-						// Important: this call has to be done _after_
-						// setting the position and the humanize_delay.
-						pCopiedNote->computeNoteStart();
-						
-						if ( pHydrogen->getMode() == Song::Mode::Song ) {
-							float fPos = static_cast<float>( m_nColumn ) +
-								pCopiedNote->get_position() % 192 / 192.f;
-							pCopiedNote->set_velocity( pNote->get_velocity() *
-													   pAutomationPath->get_value( fPos ) );
-						}
-						pNote->get_instrument()->enqueue();
-						m_songNoteQueue.push( pCopiedNote );
-					}
-				}
+			// Lower bound of the offset. No note is
+			// allowed to start prior to the beginning of
+			// the song.
+			if( nNoteStart + nOffset < 0 ){
+				nOffset = -nNoteStart;
 			}
-		}
+
+			if ( nOffset > AudioEngine::nMaxTimeHumanize ) {
+				nOffset = AudioEngine::nMaxTimeHumanize;
+			} else if ( nOffset < -1 * AudioEngine::nMaxTimeHumanize ) {
+				nOffset = -AudioEngine::nMaxTimeHumanize;
+			}
+			
+			// Generate a copy of the current note, assign
+			// it the new offset, and push it to the list
+			// of all notes, which are about to be played
+			// back.
+			//
+			// Why a copy? because it has the new offset
+			// (including swing and random timing) in its
+			// humanized delay, and tick position is
+			// expressed referring to start time (and not
+			// pattern).
+			Note *pCopiedNote = m_pNotePool->create( pNote );
+			if ( pCopiedNote == nullptr ) {
+				// Pool exhausted. The GUI got already
+				// notified by the pool itself.
+				return;
+			}
+			pCopiedNote->set_humanize_delay( nOffset );
+
+			// DEBUGLOG( QString( "getDoubleTick(): %1, getFrames(): %2, getColumn(): %3, nnTick: %4, nColumn: %5, " )
+			// 		  .arg( getDoubleTick() ).arg( getFrames() )
+			// 		  .arg( getColumn() ).arg( nnTick )
+			// 		  .arg( nColumn )
+			// 		  .append( pCopiedNote->toQString("", true ) ) );
+			
+			pCopiedNote->set_position( nnTick );
+			// Important: this call has to be done _after_
+			// setting the position and the humanize_delay.
+			pCopiedNote->computeNoteStart();
+			
+			if ( pHydrogen->getMode() == Song::Mode::Song ) {
+				float fPos = static_cast<float>( m_nColumn ) +
+					pCopiedNote->get_position() % 192 / 192.f;
+				pCopiedNote->set_velocity( pNote->get_velocity() *
+										   pAutomationPath->get_value( fPos ) );
+			}
+			pNote->get_instrument()->enqueue();
+			m_songNoteQueue.push( pCopiedNote );
+		} );
 	}
 
 	return 0;
 }
 
+long long AudioEngine::computeFrameFromMidiTimestamp( long long nTimestamp,
+														long long nJackFrameTime ) const
+{
+	const long long nBufferSize = static_cast<long long>( m_pAudioDriver->getBufferSize() );
+	const double fSampleRate = static_cast<double>( m_pAudioDriver->getSampleRate() );
+
+	if ( nJackFrameTime >= 0 && m_nCycleStartJackFrame >= 0 ) {
+		// JACK frame times are 32 bit unsigned integers and wrap
+		// around.
+		long long nOffset = static_cast<int32_t>(
+			static_cast<uint32_t>( nJackFrameTime - m_nCycleStartJackFrame ) );
+		nOffset = std::max( 0LL, std::min( nOffset, 2 * nBufferSize - 1 ) );
+
+		return m_nCycleStartFrame + nBufferSize + nOffset;
+	}
+
+	// Events arriving before the cycle started could not be handled
+	// in time and the ones arriving after the end of the cycle
+	// indicate a delayed audio thread. Both are played as close to
+	// their intended position as possible.
+	long long nOffset = static_cast<long long>(
+		std::floor( static_cast<double>( nTimestamp - m_nCycleStartTime ) *
+					fSampleRate / 1000000.0 ) );
+	nOffset = std::max( 0LL, std::min( nOffset, nBufferSize - 1 ) );
+
+	return m_nCycleStartFrame + nBufferSize + nOffset;
+}
+
 void AudioEngine::noteOn( Note *note )
 {
 	// check current state
@@ -2567,22 +2474,13 @@ void AudioEngine::noteOn( Note *note )
 			 getState() == State::Testing ) ) {
 		ERRORLOG( QString( "Error the audio engine is not in State::Ready, State::Playing, or State::Testing but [%1]" )
 					 .arg( static_cast<int>( getState() ) ) );
-		delete note;
+		m_pNotePool->release( note );
 		return;
 	}
 
 	m_midiNoteQueue.push_back( note );
 }
 
-bool AudioEngine::compare_pNotes::operator()(Note* pNote1, Note* pNote2)
-{
-	float fTickSize = Hydrogen::get_instance()->getAudioEngine()->getTickSize();
-	return (pNote1->get_humanize_delay() +
-			AudioEngine::computeFrame( pNote1->get_position(), fTickSize ) ) >
-		(pNote2->get_humanize_delay() +
-		 AudioEngine::computeFrame( pNote2->get_position(), fTickSize ) );
-}
-
 void AudioEngine::play() {
 	
 	assert( m_pAudioDriver );
@@ -3805,6 +3703,334 @@ bool AudioEngine::testNoteEnqueuing() {
 	return bNoMismatch;
 }
 
+bool AudioEngine::testMidiTimestamps() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pPref = Preferences::get_instance();
+
+	// Scripted MIDI source passing messages with predefined
+	// timestamps to the regular input handling.
+	class ScriptedMidiInput : public MidiInput {
+	public:
+		virtual void open() override {}
+		virtual void close() override {}
+		virtual std::vector<QString> getOutputPortList() override {
+			return std::vector<QString>();
+		}
+	};
+	ScriptedMidiInput midiInput;
+
+	const long long nBufferSize = static_cast<long long>( pPref->m_nBufferSize );
+	const double fSampleRate = static_cast<double>( m_pAudioDriver->getSampleRate() );
+	const long long nStartTime = 1000000;
+	auto frameToTimestamp = [&]( long long nFrame ) {
+		return nStartTime + std::llround( static_cast<double>( nFrame ) * 1000000.0 /
+										  fSampleRate );
+	};
+
+	std::random_device randomSeed;
+	std::default_random_engine randomEngine( randomSeed() );
+	std::uniform_int_distribution<long long> offsetDist( 0, nBufferSize - 1 );
+	std::uniform_int_distribution<int> eventsDist( 0, 3 );
+
+	lock( RIGHT_HERE );
+	reset( false );
+	clearNoteQueue();
+	setState( AudioEngine::State::Testing );
+	unlock();
+
+	const int nCycles = 64;
+	long long nMinLatency = std::numeric_limits<long long>::max();
+	long long nMaxLatency = std::numeric_limits<long long>::min();
+	bool bNoMismatch = true;
+
+	for ( int nn = 0; nn < nCycles + 4; ++nn ) {
+		// What audioEngine_process() does at the beginning of each
+		// cycle.
+		lock( RIGHT_HERE );
+		m_nCycleStartFrame = getFrames();
+		m_nCycleStartTime = frameToTimestamp( m_nCycleStartFrame );
+		unlock();
+
+		// Events the MIDI driver received while the cycle was
+		// rendered. They are handled in the MIDI thread.
+		std::vector<long long> eventFrames;
+		const int nEvents = nn < nCycles ? eventsDist( randomEngine ) : 0;
+		for ( int ee = 0; ee < nEvents; ++ee ) {
+			eventFrames.push_back( m_nCycleStartFrame + offsetDist( randomEngine ) );
+		}
+		std::sort( eventFrames.begin(), eventFrames.end() );
+
+		for ( const auto nEventFrame : eventFrames ) {
+			MidiMessage msg;
+			msg.m_type = MidiMessage::NOTE_ON;
+			msg.m_nData1 = 36;
+			msg.m_nData2 = 100;
+			msg.m_nChannel = 0;
+			msg.m_nTimestamp = frameToTimestamp( nEventFrame );
+			midiInput.handleMidiMessage( msg );
+
+			lock( RIGHT_HERE );
+			if ( m_midiNoteQueue.size() == 0 ) {
+				qDebug() << "[testMidiTimestamps] MIDI note was not enqueued";
+				bNoMismatch = false;
+			} else {
+				const long long nLatency =
+					m_midiNoteQueue.back()->getNoteStart() - nEventFrame;
+				nMinLatency = std::min( nMinLatency, nLatency );
+				nMaxLatency = std::max( nMaxLatency, nLatency );
+			}
+			unlock();
+		}
+
+		lock( RIGHT_HERE );
+		updateNoteQueue( nBufferSize );
+		processAudio( nBufferSize );
+		incrementTransportPosition( nBufferSize );
+		unlock();
+
+		if ( ! bNoMismatch ) {
+			break;
+		}
+	}
+
+	lock( RIGHT_HERE );
+
+	// All events have to be passed on to the Sampler.
+	if ( m_midiNoteQueue.size() != 0 ) {
+		qDebug() << QString( "[testMidiTimestamps] [%1] MIDI notes were not processed" )
+			.arg( m_midiNoteQueue.size() );
+		bNoMismatch = false;
+	}
+
+	// The latency must be constant up to rounding errors
+	// introduced by the timestamps in microseconds.
+	if ( nMinLatency <= nMaxLatency &&
+		 ( nMinLatency < nBufferSize - 1 || nMaxLatency > nBufferSize + 1 ) ) {
+		qDebug() << QString( "[testMidiTimestamps] Latency jitters: min: %1, max: %2, buffer size: %3" )
+			.arg( nMinLatency ).arg( nMaxLatency ).arg( nBufferSize );
+		bNoMismatch = false;
+	}
+
+	clearNoteQueue();
+	setState( AudioEngine::State::Ready );
+	unlock();
+
+	return bNoMismatch;
+}
+
+bool AudioEngine::testMidiJackClientOrder() {
+	auto pPref = Preferences::get_instance();
+
+	class ScriptedMidiInput : public MidiInput {
+	public:
+		virtual void open() override {}
+		virtual void close() override {}
+		virtual std::vector<QString> getOutputPortList() override {
+			return std::vector<QString>();
+		}
+	};
+	ScriptedMidiInput midiInput;
+
+	const long long nBufferSize = static_cast<long long>( pPref->m_nBufferSize );
+
+	std::random_device randomSeed;
+	std::default_random_engine randomEngine( randomSeed() );
+	std::uniform_int_distribution<long long> offsetDist( 0, nBufferSize - 1 );
+	std::uniform_int_distribution<int> eventsDist( 0, 3 );
+
+	bool bNoMismatch = true;
+	for ( const bool bMidiClientFirst : { false, true } ) {
+		lock( RIGHT_HERE );
+		reset( false );
+		clearNoteQueue();
+		setState( AudioEngine::State::Testing );
+		unlock();
+
+		// Start close to the wrap around of the 32 bit JACK frame
+		// time.
+		long long nJackFrameTime = 0xFFFFFFFFLL - 8 * nBufferSize;
+		const int nCycles = 32;
+		long long nMinLatency = std::numeric_limits<long long>::max();
+		long long nMaxLatency = std::numeric_limits<long long>::min();
+
+		for ( int nn = 0; nn < nCycles + 4; ++nn ) {
+			// Events received within the current JACK cycle.
+			std::vector<long long> eventOffsets;
+			const int nEvents = nn > 0 && nn < nCycles ? eventsDist( randomEngine ) : 0;
+			for ( int ee = 0; ee < nEvents; ++ee ) {
+				eventOffsets.push_back( offsetDist( randomEngine ) );
+			}
+			std::sort( eventOffsets.begin(), eventOffsets.end() );
+
+			lock( RIGHT_HERE );
+			const long long nCycleStartFrame = getFrames();
+			unlock();
+
+			auto handleEvents = [&]() {
+				for ( const auto nOffset : eventOffsets ) {
+					MidiMessage msg;
+					msg.m_type = MidiMessage::NOTE_ON;
+					msg.m_nData1 = 36;
+					msg.m_nData2 = 100;
+					msg.m_nChannel = 0;
+					msg.m_nJackFrameTime = ( nJackFrameTime + nOffset ) & 0xFFFFFFFFLL;
+					midiInput.handleMidiMessage( msg );
+
+					lock( RIGHT_HERE );
+					if ( m_midiNoteQueue.size() == 0 ) {
+						qDebug() << "[testMidiJackClientOrder] MIDI note was not enqueued";
+						bNoMismatch = false;
+					} else {
+						const long long nLatency = m_midiNoteQueue.back()->getNoteStart() -
+							( nCycleStartFrame + nOffset );
+						nMinLatency = std::min( nMinLatency, nLatency );
+						nMaxLatency = std::max( nMaxLatency, nLatency );
+					}
+					unlock();
+				}
+			};
+
+			if ( bMidiClientFirst ) {
+				// The audio engine still refers to the previous cycle.
+				handleEvents();
+			}
+
+			// What audioEngine_process() does at the beginning of
+			// each cycle.
+			lock( RIGHT_HERE );
+			m_nCycleStartFrame = nCycleStartFrame;
+			m_nCycleStartJackFrame = nJackFrameTime;
+			unlock();
+
+			if ( ! bMidiClientFirst ) {
+				handleEvents();
+			}
+
+			lock( RIGHT_HERE );
+			updateNoteQueue( nBufferSize );
+			processAudio( nBufferSize );
+			incrementTransportPosition( nBufferSize );
+			unlock();
+
+			nJackFrameTime = ( nJackFrameTime + nBufferSize ) & 0xFFFFFFFFLL;
+
+			if ( ! bNoMismatch ) {
+				break;
+			}
+		}
+
+		lock( RIGHT_HERE );
+		if ( m_midiNoteQueue.size() != 0 ) {
+			qDebug() << QString( "[testMidiJackClientOrder] [%1] MIDI notes were not processed" )
+				.arg( m_midiNoteQueue.size() );
+			bNoMismatch = false;
+		}
+
+		// JACK frame times are exact. No jitter is allowed at all.
+		if ( nMinLatency <= nMaxLatency &&
+			 ( nMinLatency != nBufferSize || nMaxLatency != nBufferSize ) ) {
+			qDebug() << QString( "[testMidiJackClientOrder] MIDI client first: %1, latency min: %2, max: %3, buffer size: %4" )
+				.arg( bMidiClientFirst ).arg( nMinLatency ).arg( nMaxLatency )
+				.arg( nBufferSize );
+			bNoMismatch = false;
+		}
+
+		m_nCycleStartJackFrame = -1;
+		clearNoteQueue();
+		setState( AudioEngine::State::Ready );
+		unlock();
+
+		if ( ! bNoMismatch ) {
+			break;
+		}
+	}
+
+	return bNoMismatch;
+}
+
+bool AudioEngine::testRealtimeNoteWithoutTimestamp() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pPref = Preferences::get_instance();
+
+	const bool bOldQuantize = pPref->getQuantizeEvents();
+	const bool bOldRecord = pPref->getRecordEvents();
+	pPref->setQuantizeEvents( true );
+	pPref->setRecordEvents( false );
+
+	const long long nBufferSize = static_cast<long long>( pPref->m_nBufferSize );
+
+	bool bNoMismatch = true;
+	for ( const auto state : { AudioEngine::State::Testing,
+							   AudioEngine::State::Ready } ) {
+		lock( RIGHT_HERE );
+		reset( false );
+		clearNoteQueue();
+		setState( state );
+
+		if ( state == AudioEngine::State::Testing ) {
+			// Move transport off the grid.
+			for ( int nn = 0; nn < 3; ++nn ) {
+				m_nCycleStartFrame = getFrames();
+				updateNoteQueue( nBufferSize );
+				processAudio( nBufferSize );
+				incrementTransportPosition( nBufferSize );
+			}
+		}
+		m_nCycleStartFrame = getFrames();
+		unlock();
+
+		pHydrogen->addRealtimeNote( 0, 1.0, 0.0, false, 36 );
+
+		lock( RIGHT_HERE );
+		if ( m_midiNoteQueue.size() != 1 ) {
+			qDebug() << QString( "[testRealtimeNoteWithoutTimestamp] [%1] MIDI notes enqueued" )
+				.arg( m_midiNoteQueue.size() );
+			bNoMismatch = false;
+		}
+		else {
+			auto pNote = m_midiNoteQueue.back();
+
+			// Start as derived from the position of the note alone.
+			Note referenceNote( pNote->get_instrument(), pNote->get_position(),
+								1.0, 0.0, -1, 0 );
+			referenceNote.computeNoteStart();
+
+			if ( pNote->hasFixedNoteStart() ||
+				 pNote->getNoteStart() != referenceNote.getNoteStart() ) {
+				qDebug() << QString( "[testRealtimeNoteWithoutTimestamp] state: %1, fixed start: %2, note start: %3, expected: %4" )
+					.arg( static_cast<int>( state ) )
+					.arg( pNote->hasFixedNoteStart() )
+					.arg( pNote->getNoteStart() )
+					.arg( referenceNote.getNoteStart() );
+				bNoMismatch = false;
+			}
+		}
+
+		updateNoteQueue( nBufferSize );
+		processAudio( nBufferSize );
+
+		// The note has to be passed on within the next cycle.
+		if ( m_midiNoteQueue.size() != 0 ) {
+			qDebug() << QString( "[testRealtimeNoteWithoutTimestamp] state: %1, MIDI note was not processed" )
+				.arg( static_cast<int>( state ) );
+			bNoMismatch = false;
+		}
+
+		clearNoteQueue();
+		setState( AudioEngine::State::Ready );
+		unlock();
+
+		if ( ! bNoMismatch ) {
+			break;
+		}
+	}
+
+	pPref->setQuantizeEvents( bOldQuantize );
+	pPref->setRecordEvents( bOldRecord );
+
+	return bNoMismatch;
+}
+
 void AudioEngine::testMergeQueues( std::vector<std::shared_ptr<Note>>* noteList, std::vector<std::shared_ptr<Note>> newNotes ) {
 	bool bNoteFound;
 	for ( const auto& newNote : newNotes ) {
@@ -30,6 +30,11 @@
 #include <core/Synth/Synth.h>
 #include <core/Basics/Note.h>
 #include <core/AudioEngine/TransportInfo.h>
+#include <core/AudioEngine/DspProfiler.h>
+#include <core/AudioEngine/NotePool.h>
+#include <core/AudioEngine/NoteProgram.h>
+#include <core/AudioEngine/NoteQueue.h>
+#include <core/AudioEngine/TempoMap.h>
 #include <core/CoreActionController.h>
 
 #include <core/IO/AudioOutput.h>
@@ -286,6 +291,10 @@ public:
 	Sampler*		getSampler() const;
 	/** \return #m_pSynth */
 	Synth*			getSynth() const;
+	/** \return #m_pNotePool */
+	NotePool*		getNotePool() const;
+	/** \return #m_pDspProfiler */
+	DspProfiler*	getDspProfiler() const;
 
 	/** \return Time passed since the beginning of the song*/
 	float			getElapsedTime() const;	
@@ -360,8 +369,42 @@ public:
 	const PatternList*	getPlayingPatterns() const;
 	
 	long long		getRealtimeFrames() const;
+	/** \return #m_nCycleStartFrame */
+	long long		getCycleStartFrame() const;
 
 	const struct timeval& 	getCurrentTickTime() const;
+
+	/**
+	 * Converts the timestamp of a MIDI message
+	 * (MidiMessage::m_nTimestamp) into the frame the corresponding
+	 * note has to start at.
+	 *
+	 * Events are mapped relative to the beginning of the last
+	 * processing cycle and delayed by exactly one buffer. This way
+	 * all notes triggered while a cycle was rendered start at the
+	 * same offset within the next one they had relative to the
+	 * former and MIDI input has a constant latency instead of a
+	 * jitter of up to one buffer.
+	 *
+	 * If both @a nJackFrameTime and #m_nCycleStartJackFrame are
+	 * available, the offset is computed in JACK frames instead. The
+	 * JACK MIDI and audio client are processed within the same
+	 * cycle but in no particular order. In case the MIDI client
+	 * comes first, the offset exceeds the buffer size since the
+	 * audio engine still refers to the previous cycle. Either way
+	 * the note is placed exactly one buffer after the event.
+	 *
+	 * The audio engine has to be locked.
+	 *
+	 * \param nTimestamp See MidiMessage::m_nTimestamp.
+	 * \param nJackFrameTime See MidiMessage::m_nJackFrameTime.
+	 *
+	 * \return Frame in the same domain as used by processPlayNotes()
+	 * (transport position while playing and #m_nRealtimeFrames
+	 * otherwise).
+	 */
+	long long		computeFrameFromMidiTimestamp( long long nTimestamp,
+												   long long nJackFrameTime = -1 ) const;
 	
 	/** Maximum lead lag factor in ticks.
 	 *
@@ -551,6 +594,40 @@ public:
 	 * @return true on success.
 	 */
 	bool testNoteEnqueuing();
+	/** 
+	 * Unit test checking that MIDI notes injected with scripted
+	 * timestamps start with a constant latency of one buffer.
+	 *
+	 * Defined in here since it requires access to methods and
+	 * variables private to the #AudioEngine class.
+	 *
+	 * @return true on success.
+	 */
+	bool testMidiTimestamps();
+	/**
+	 * Unit test checking that MIDI notes carrying JACK frame times
+	 * start with a constant latency of one buffer regardless of
+	 * whether the JACK MIDI client is processed before or after the
+	 * audio client within a cycle.
+	 *
+	 * Defined in here since it requires access to methods and
+	 * variables private to the #AudioEngine class.
+	 *
+	 * @return true on success.
+	 */
+	bool testMidiJackClientOrder();
+	/**
+	 * Unit test checking that quantized realtime notes lacking a
+	 * MIDI timestamp are not assigned a fixed start but are placed
+	 * by Note::computeNoteStart(), both while transport is rolling
+	 * and while it is stopped.
+	 *
+	 * Defined in here since it requires access to methods and
+	 * variables private to the #AudioEngine class.
+	 *
+	 * @return true on success.
+	 */
+	bool testRealtimeNoteWithoutTimestamp();
 	
 	/** Formatted string version for debugging purposes.
 	 * \param sPrefix String prefix which will be added in front of
@@ -615,6 +692,18 @@ private:
 	 */
 	void reset(  bool bWithJackBroadcast = true );
 
+	/**
+	 * Ensures #m_noteProgram is able to hold all notes of the
+	 * current song without allocating memory within the audio
+	 * thread.
+	 *
+	 * Called by unlock() in case the lock was acquired using lock()
+	 * or tryLock(), which are not used by the audio thread. The notes
+	 * are only counted if notes were inserted or removed since the
+	 * last call.
+	 */
+	void reserveNoteProgram();
+
 	double getDoubleTick() const;
 	static double computeDoubleTickSize(const int nSampleRate, const float fBpm, const int nResolution);
 
@@ -733,6 +822,17 @@ private:
 	 * frame-based variables might have become invalid.
 	 */
 	void handleDriverChange();
+
+	/**
+	 * Rebuilds #m_pTempoMap used by computeFrameFromTick() and
+	 * computeTickFromFrame().
+	 *
+	 * Has to be called whenever the #Timeline, the song size, or the
+	 * sample rate changed. Till then both conversions keep using the
+	 * previous map. Must not be called from within the audio thread
+	 * since it allocates memory.
+	 */
+	void updateTempoMap();
 	
 	/** Helper function */
 	bool testCheckTransportPosition( const QString& sContext ) const;
@@ -768,6 +868,14 @@ private:
 	Sampler* 			m_pSampler;
 	/** Local instance of the Synth. */
 	Synth* 				m_pSynth;
+	/** Storage of all notes in #m_songNoteQueue, #m_midiNoteQueue,
+	 * and the playing notes of the #Sampler. */
+	NotePool*			m_pNotePool;
+	/** Timing of the individual stages of audioEngine_process().*/
+	DspProfiler*		m_pDspProfiler;
+	/** Cached mapping between ticks and frames with the #Timeline
+	 * enabled. */
+	TempoMap*			m_pTempoMap;
 
 	/**
 	 * Pointer to the current instance of the audio driver.
@@ -900,6 +1008,23 @@ private:
 	 * See updatePlayingPatterns() for details.
 	 */
 	PatternList*		m_pPlayingPatterns;
+	/**
+	 * All notes of #m_pPlayingPatterns compiled into a flat array
+	 * sorted by tick. Used by updateNoteQueue().
+	 *
+	 * The program is invalidated whenever #m_pPlayingPatterns is
+	 * changed and becomes invalid on its own whenever notes are
+	 * inserted into or removed from a pattern. It is recompiled
+	 * lazily within the audio thread. Its capacity is adjusted in
+	 * reserveNoteProgram() outside of the audio thread.
+	 */
+	NoteProgram			m_noteProgram;
+	/** Whether unlock() has to call reserveNoteProgram(). Set in
+	 * lock() and tryLock().*/
+	bool				m_bReserveNoteProgram;
+	/** Pattern::get_notes_revision() at the last call to
+	 * reserveNoteProgram().*/
+	int					m_nReservedNotesRevision;
 
 	/**
 	 * Variable keeping track of the transport position in realtime.
@@ -911,6 +1036,17 @@ private:
 	 */
 	long long		m_nRealtimeFrames;
 
+	/** Time in microseconds the current processing cycle started
+	 * at. See computeFrameFromMidiTimestamp().*/
+	long long		m_nCycleStartTime;
+	/** Frame rendered first in the current processing cycle. See
+	 * computeFrameFromMidiTimestamp().*/
+	long long		m_nCycleStartFrame;
+	/** JACK frame time the current processing cycle started at or
+	 * -1 if the JackAudioDriver is not used. See
+	 * computeFrameFromMidiTimestamp().*/
+	long long		m_nCycleStartJackFrame;
+
 	/**
 	 * Current state of the H2Core::AudioEngine.
 	 */	
@@ -923,13 +1059,8 @@ private:
 	
 	audioProcessCallback m_AudioProcessCallback;
 	
-	/// Song Note FIFO
-	// overload the > operator of Note objects for priority_queue
-	struct compare_pNotes {
-		bool operator() (Note* pNote1, Note* pNote2);
-	};
-
-	std::priority_queue<Note*, std::deque<Note*>, compare_pNotes > m_songNoteQueue;
+	/// Song Note FIFO ordered by Note::getNoteStart()
+	NoteQueue			m_songNoteQueue;
 	std::deque<Note*>	m_midiNoteQueue;	///< Midi Note FIFO
 	
 	/**
@@ -1089,6 +1220,10 @@ inline void AudioEngine::setRealtimeFrames( long long nFrames ) {
 	m_nRealtimeFrames = nFrames;
 }
 
+inline long long AudioEngine::getCycleStartFrame() const {
+	return m_nCycleStartFrame;
+}
+
 inline float AudioEngine::getNextBpm() const {
 	return m_fNextBpm;
 }
@@ -0,0 +1,239 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <core/AudioEngine/DspProfiler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+namespace H2Core
+{
+
+void DspProfiler::Histogram::add( double fUs ) {
+	++nCount;
+	fTotalUs += fUs;
+	fMaxUs = std::max( fMaxUs, fUs );
+	++buckets[ DspProfiler::getBucket( fUs ) ];
+}
+
+double DspProfiler::Histogram::getMeanUs() const {
+	return nCount > 0 ? fTotalUs / nCount : 0;
+}
+
+DspProfiler::DspProfiler()
+	: m_nCycleStart( 0 )
+	, m_nBudget( 0 )
+	, m_nWriteIndex( 0 )
+	, m_nReadIndex( 0 )
+	, m_nXruns( 0 )
+	, m_nDroppedCycles( 0 )
+	, m_nLastXrunStage( -1 )
+	, m_nLastDominantStage( -1 )
+	, m_nLastCycleTicks( 0 )
+	, m_nLastLadspaTicks( 0 )
+{
+#if defined(__x86_64__) || defined(__i386__)
+	// Calibrate the time stamp counter against the monotonic clock.
+	const auto startTime = std::chrono::steady_clock::now();
+	const uint64_t nStartTicks = now();
+	std::this_thread::sleep_for( std::chrono::milliseconds( 10 ) );
+	const uint64_t nEndTicks = now();
+	const double fElapsedUs = std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - startTime ).count();
+	m_fTicksPerUs = static_cast<double>( nEndTicks - nStartTicks ) / fElapsedUs;
+	if ( ! ( m_fTicksPerUs > 0 ) ) {
+		ERRORLOG( "Unable to calibrate time stamp counter" );
+		m_fTicksPerUs = 1000;
+	}
+#else
+	// now() returns nanoseconds.
+	m_fTicksPerUs = 1000;
+#endif
+	INFOLOG( QString( "Clock runs at [%1] ticks per us" ).arg( m_fTicksPerUs ) );
+
+	memset( &m_current, 0, sizeof( m_current ) );
+	m_pRing = new CycleRecord[ nRingSize ];
+	for ( auto& nnTicks : m_instrumentTicks ) {
+		nnTicks.store( 0, std::memory_order_relaxed );
+	}
+	for ( auto& nnXruns : m_xrunsByStage ) {
+		nnXruns.store( 0, std::memory_order_relaxed );
+	}
+	std::fill( m_instrumentUs, m_instrumentUs + MAX_INSTRUMENTS, 0 );
+}
+
+DspProfiler::~DspProfiler() {
+	delete[] m_pRing;
+}
+
+void DspProfiler::beginCycle( uint64_t nStart, uint32_t nFrames, float fSampleRate ) {
+	memset( &m_current, 0, sizeof( m_current ) );
+	m_nCycleStart = nStart;
+	m_nBudget = fSampleRate > 0 ?
+		static_cast<uint64_t>( 1e6 * nFrames / fSampleRate * m_fTicksPerUs ) : 0;
+}
+
+bool DspProfiler::endCycle( uint64_t nEnd, bool bBufferMissed ) {
+	const uint64_t nTotal = nEnd - m_nCycleStart;
+	addStage( Stage::Total, nTotal );
+
+	const int nDominantStage = getDominantStage( m_current );
+	m_nLastDominantStage.store( nDominantStage, std::memory_order_relaxed );
+	m_nLastCycleTicks.store( nTotal, std::memory_order_relaxed );
+	m_nLastLadspaTicks.store( m_current.stages[ static_cast<int>(Stage::Ladspa) ],
+							  std::memory_order_relaxed );
+
+	const bool bXrun = bBufferMissed || ( m_nBudget > 0 && nTotal > m_nBudget );
+	if ( bXrun ) {
+		countXrun( nDominantStage );
+	}
+
+	const uint32_t nWriteIndex = m_nWriteIndex.load( std::memory_order_relaxed );
+	if ( nWriteIndex - m_nReadIndex.load( std::memory_order_acquire ) >= nRingSize ) {
+		m_nDroppedCycles.fetch_add( 1, std::memory_order_relaxed );
+	} else {
+		m_pRing[ nWriteIndex % nRingSize ] = m_current;
+		m_nWriteIndex.store( nWriteIndex + 1, std::memory_order_release );
+	}
+
+	return bXrun;
+}
+
+void DspProfiler::reportDriverXrun() {
+	countXrun( m_nLastDominantStage.load( std::memory_order_relaxed ) );
+}
+
+void DspProfiler::countXrun( int nStage ) {
+	m_nXruns.fetch_add( 1, std::memory_order_relaxed );
+	if ( nStage >= 0 && nStage < nStages ) {
+		m_xrunsByStage[ nStage ].fetch_add( 1, std::memory_order_relaxed );
+	}
+	m_nLastXrunStage.store( nStage, std::memory_order_relaxed );
+}
+
+int DspProfiler::getDominantStage( const CycleRecord& record ) const {
+	int nDominantStage = -1;
+	uint64_t nMax = 0;
+	for ( int ii = 0; ii < static_cast<int>(Stage::Total); ++ii ) {
+		if ( ( record.nStageMask & ( 1u << ii ) ) && record.stages[ ii ] >= nMax ) {
+			nMax = record.stages[ ii ];
+			nDominantStage = ii;
+		}
+	}
+	return nDominantStage;
+}
+
+int DspProfiler::getBucket( double fUs ) {
+	if ( fUs < 2 ) {
+		return 0;
+	}
+	return std::min( static_cast<int>( std::log2( fUs ) ), nBuckets - 1 );
+}
+
+DspProfiler::Report DspProfiler::getReport() {
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const uint32_t nWriteIndex = m_nWriteIndex.load( std::memory_order_acquire );
+	uint32_t nReadIndex = m_nReadIndex.load( std::memory_order_relaxed );
+	for ( ; nReadIndex != nWriteIndex; ++nReadIndex ) {
+		const CycleRecord& record = m_pRing[ nReadIndex % nRingSize ];
+		for ( int ii = 0; ii < nStages; ++ii ) {
+			if ( record.nStageMask & ( 1u << ii ) ) {
+				m_report.stages[ ii ].add( ticksToUs( record.stages[ ii ] ) );
+			}
+		}
+		for ( int ii = 0; ii < MAX_FX; ++ii ) {
+			if ( record.nLadspaMask & ( 1u << ii ) ) {
+				m_report.ladspa[ ii ].add( ticksToUs( record.ladspa[ ii ] ) );
+			}
+		}
+		++m_report.nCycles;
+	}
+	m_nReadIndex.store( nReadIndex, std::memory_order_release );
+
+	m_report.nXruns = m_nXruns.load( std::memory_order_relaxed );
+	m_report.nDroppedCycles = m_nDroppedCycles.load( std::memory_order_relaxed );
+	for ( int ii = 0; ii < nStages; ++ii ) {
+		m_report.xrunsByStage[ ii ] = m_xrunsByStage[ ii ].load( std::memory_order_relaxed );
+	}
+	m_report.nLastXrunStage = m_nLastXrunStage.load( std::memory_order_relaxed );
+
+	m_report.instruments.clear();
+	for ( int ii = 0; ii < MAX_INSTRUMENTS; ++ii ) {
+		m_instrumentUs[ ii ] +=
+			ticksToUs( m_instrumentTicks[ ii ].exchange( 0, std::memory_order_relaxed ) );
+		if ( m_instrumentUs[ ii ] > 0 ) {
+			m_report.instruments.push_back( std::make_pair( ii, m_instrumentUs[ ii ] ) );
+		}
+	}
+	std::sort( m_report.instruments.begin(), m_report.instruments.end(),
+			   []( const std::pair<int, double>& a, const std::pair<int, double>& b ) {
+				   return a.second > b.second; } );
+
+	return m_report;
+}
+
+void DspProfiler::reset() {
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	m_nReadIndex.store( m_nWriteIndex.load( std::memory_order_acquire ),
+						std::memory_order_release );
+	m_nXruns.store( 0, std::memory_order_relaxed );
+	m_nDroppedCycles.store( 0, std::memory_order_relaxed );
+	for ( auto& nnXruns : m_xrunsByStage ) {
+		nnXruns.store( 0, std::memory_order_relaxed );
+	}
+	m_nLastXrunStage.store( -1, std::memory_order_relaxed );
+	for ( auto& nnTicks : m_instrumentTicks ) {
+		nnTicks.store( 0, std::memory_order_relaxed );
+	}
+	std::fill( m_instrumentUs, m_instrumentUs + MAX_INSTRUMENTS, 0 );
+
+	m_report = Report();
+}
+
+QString DspProfiler::getStageName( Stage stage ) {
+	switch ( stage ) {
+	case Stage::LockWait:
+		return "LockWait";
+	case Stage::UpdateNoteQueue:
+		return "UpdateNoteQueue";
+	case Stage::ProcessPlayNotes:
+		return "ProcessPlayNotes";
+	case Stage::Sampler:
+		return "Sampler";
+	case Stage::PlaybackTrack:
+		return "PlaybackTrack";
+	case Stage::Synth:
+		return "Synth";
+	case Stage::Ladspa:
+		return "Ladspa";
+	case Stage::Metering:
+		return "Metering";
+	case Stage::Total:
+		return "Total";
+	}
+	return "Unknown";
+}
+
+};
@@ -0,0 +1,255 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef DSP_PROFILER_H
+#define DSP_PROFILER_H
+
+#include <core/Object.h>
+#include <core/config.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace H2Core
+{
+
+/**
+ * Always-on instrumentation of the processing cycles of the
+ * #AudioEngine.
+ *
+ * Each call of AudioEngine::audioEngine_process() is framed by
+ * beginCycle() and endCycle(). In between the individual stages -
+ * waiting for the engine lock, updating the note queue, rendering
+ * the notes of each instrument, the LADSPA effects etc. - report the
+ * number of clock ticks they took. Reading the clock is cheap (the
+ * time stamp counter on x86) and all calls done within the audio
+ * thread neither allocate nor lock.
+ *
+ * At the end of a cycle its durations are pushed into a single
+ * producer/single consumer ring buffer. getReport() drains it from
+ * a non-realtime thread - the GUI or the OSC server - and
+ * accumulates the durations into histograms. Whenever a cycle
+ * exceeds its budget (the duration of the buffer processed) or the
+ * engine lock could not be acquired, an xrun is attributed to the
+ * stage that took the most time within that cycle. Xruns reported by
+ * the audio driver itself via reportDriverXrun() are attributed to
+ * the most expensive stage of the last completed cycle.
+ */
+/** \ingroup docCore docAudioEngine */
+class DspProfiler : public H2Core::Object<DspProfiler>
+{
+	H2_OBJECT(DspProfiler)
+public:
+	enum class Stage {
+		/** Time spent waiting for AudioEngine::m_EngineMutex.*/
+		LockWait = 0,
+		UpdateNoteQueue,
+		ProcessPlayNotes,
+		/** Rendering and mixing the notes of the #Sampler.*/
+		Sampler,
+		PlaybackTrack,
+		Synth,
+		/** All LADSPA effects. The individual slots are tracked
+		 * separately.*/
+		Ladspa,
+		/** Master and component peak metering.*/
+		Metering,
+		/** Whole processing cycle.*/
+		Total
+	};
+	static constexpr int nStages = static_cast<int>(Stage::Total) + 1;
+	/** Bucket i of a #Histogram counts durations in [2^i, 2^(i+1))
+	 * microseconds. The first one covers everything below 2 us and
+	 * the last one everything above.*/
+	static constexpr int nBuckets = 16;
+	/** Number of cycles which can be buffered between two calls of
+	 * getReport().*/
+	static constexpr int nRingSize = 1024;
+
+	struct Histogram {
+		long long nCount = 0;
+		double fTotalUs = 0;
+		double fMaxUs = 0;
+		long long buckets[ nBuckets ] = {};
+
+		void add( double fUs );
+		double getMeanUs() const;
+	};
+
+	struct Report {
+		long long nCycles = 0;
+		/** Xruns detected by the profiler itself and reported by the
+		 * driver.*/
+		long long nXruns = 0;
+		/** Cycles which could not be stored because the ring buffer
+		 * was full. Their xruns are counted nevertheless.*/
+		long long nDroppedCycles = 0;
+		Histogram stages[ nStages ];
+		long long xrunsByStage[ nStages ] = {};
+		/** Stage blamed for the most recent xrun or -1.*/
+		int nLastXrunStage = -1;
+		Histogram ladspa[ MAX_FX ];
+		/** Instrument id and accumulated time in us spent rendering
+		 * its notes. Sorted by descending time.*/
+		std::vector<std::pair<int, double>> instruments;
+	};
+
+	DspProfiler();
+	~DspProfiler();
+
+	/** \return Current value of the monotonic clock in ticks.*/
+	static uint64_t now();
+	double ticksToUs( uint64_t nTicks ) const;
+
+	/** Starts a new cycle processing @a nFrames at @a fSampleRate.
+	 *
+	 * @a nStart - obtained via now() - marks the beginning of the
+	 * cycle.*/
+	void beginCycle( uint64_t nStart, uint32_t nFrames, float fSampleRate );
+	/** Adds @a nTicks to the time spent in @a stage within the current
+	 * cycle.*/
+	void addStage( Stage stage, uint64_t nTicks );
+	void addLadspa( int nSlot, uint64_t nTicks );
+	/** Adds @a nTicks spent rendering a note of the instrument with id
+	 * @a nInstrumentId. Can be called from the threads of the
+	 * RenderWorkerPool.*/
+	void addInstrument( int nInstrumentId, uint64_t nTicks );
+	/** Finishes the current cycle at @a nEnd.
+	 *
+	 * @param nEnd Obtained via now().
+	 * @param bBufferMissed Whether the cycle did not produce any
+	 * audio, e.g. because the engine lock could not be acquired in
+	 * time. Counts as xrun.
+	 *
+	 * \return true in case the cycle resulted in an xrun.*/
+	bool endCycle( uint64_t nEnd, bool bBufferMissed = false );
+
+	/** Attributes an xrun reported by the audio driver.*/
+	void reportDriverXrun();
+
+	/** Collects all cycles recorded since the last call and returns
+	 * the accumulated statistics.
+	 *
+	 * Must not be called from within the audio thread.*/
+	Report getReport();
+	/** Discards all statistics collected so far.*/
+	void reset();
+
+	static QString getStageName( Stage stage );
+	/** \return Duration of the last completed cycle in us.*/
+	double getLastCycleUs() const;
+	/** \return Time spent by the LADSPA effects in the last
+	 * completed cycle in us.*/
+	double getLastLadspaUs() const;
+
+private:
+	struct CycleRecord {
+		uint64_t stages[ nStages ];
+		uint64_t ladspa[ MAX_FX ];
+		/** Bit i is set in case stage i was reached.*/
+		uint32_t nStageMask;
+		uint32_t nLadspaMask;
+	};
+
+	static int getBucket( double fUs );
+	int getDominantStage( const CycleRecord& record ) const;
+	void countXrun( int nStage );
+
+	double m_fTicksPerUs;
+
+	/** Record filled during the current cycle. Only accessed by the
+	 * audio thread.*/
+	CycleRecord m_current;
+	uint64_t m_nCycleStart;
+	uint64_t m_nBudget;
+
+	CycleRecord* m_pRing;
+	std::atomic<uint32_t> m_nWriteIndex;
+	std::atomic<uint32_t> m_nReadIndex;
+
+	std::atomic<uint64_t> m_instrumentTicks[ MAX_INSTRUMENTS ];
+
+	std::atomic<long long> m_nXruns;
+	std::atomic<long long> m_nDroppedCycles;
+	std::atomic<long long> m_xrunsByStage[ nStages ];
+	std::atomic<int> m_nLastXrunStage;
+	/** Most expensive stage of the last completed cycle.*/
+	std::atomic<int> m_nLastDominantStage;
+	std::atomic<uint64_t> m_nLastCycleTicks;
+	std::atomic<uint64_t> m_nLastLadspaTicks;
+
+	/** Serializes the readers. */
+	std::mutex m_mutex;
+	Report m_report;
+	/** Time in us collected from #m_instrumentTicks.*/
+	double m_instrumentUs[ MAX_INSTRUMENTS ];
+};
+
+inline uint64_t DspProfiler::now() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch() ).count();
+#endif
+}
+
+inline double DspProfiler::ticksToUs( uint64_t nTicks ) const {
+	return static_cast<double>( nTicks ) / m_fTicksPerUs;
+}
+
+inline void DspProfiler::addStage( Stage stage, uint64_t nTicks ) {
+	const int nStage = static_cast<int>( stage );
+	m_current.stages[ nStage ] += nTicks;
+	m_current.nStageMask |= 1u << nStage;
+}
+
+inline void DspProfiler::addLadspa( int nSlot, uint64_t nTicks ) {
+	if ( nSlot >= 0 && nSlot < MAX_FX ) {
+		m_current.ladspa[ nSlot ] += nTicks;
+		m_current.nLadspaMask |= 1u << nSlot;
+	}
+}
+
+inline void DspProfiler::addInstrument( int nInstrumentId, uint64_t nTicks ) {
+	if ( nInstrumentId >= 0 && nInstrumentId < MAX_INSTRUMENTS ) {
+		m_instrumentTicks[ nInstrumentId ].fetch_add( nTicks, std::memory_order_relaxed );
+	}
+}
+
+inline double DspProfiler::getLastCycleUs() const {
+	return ticksToUs( m_nLastCycleTicks.load( std::memory_order_relaxed ) );
+}
+inline double DspProfiler::getLastLadspaUs() const {
+	return ticksToUs( m_nLastLadspaTicks.load( std::memory_order_relaxed ) );
+}
+
+};
+
+#endif
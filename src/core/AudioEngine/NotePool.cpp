@@ -0,0 +1,121 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <core/AudioEngine/NotePool.h>
+#include <core/EventQueue.h>
+
+namespace H2Core
+{
+
+NotePool::NotePool( int nCapacity )
+	: m_nCapacity( std::max( nCapacity, 1 ) )
+	, m_nUsed( 0 )
+	, m_nExhaustedCount( 0 )
+	, m_bExhaustionReported( false )
+{
+	m_pSlots = new Slot[ m_nCapacity ];
+	m_pNext = new std::atomic<uint32_t>[ m_nCapacity ];
+
+	for ( int ii = 0; ii < m_nCapacity - 1; ++ii ) {
+		m_pNext[ ii ].store( ii + 1, std::memory_order_relaxed );
+	}
+	m_pNext[ m_nCapacity - 1 ].store( nInvalidIndex, std::memory_order_relaxed );
+	m_head.store( 0, std::memory_order_release );
+
+	INFOLOG( QString( "Preallocated [%1] notes" ).arg( m_nCapacity ) );
+}
+
+NotePool::~NotePool()
+{
+	if ( m_nUsed.load() != 0 ) {
+		ERRORLOG( QString( "[%1] notes are still in use" ).arg( m_nUsed.load() ) );
+	}
+
+	delete[] m_pNext;
+	delete[] m_pSlots;
+}
+
+void* NotePool::acquireSlot()
+{
+	uint64_t nHead = m_head.load( std::memory_order_acquire );
+	while ( true ) {
+		const uint32_t nIndex = static_cast<uint32_t>( nHead & 0xFFFFFFFF );
+		if ( nIndex == nInvalidIndex ) {
+			return nullptr;
+		}
+
+		const uint64_t nNext = m_pNext[ nIndex ].load( std::memory_order_relaxed );
+		const uint64_t nNewHead = ( ( ( nHead >> 32 ) + 1 ) << 32 ) | nNext;
+		if ( m_head.compare_exchange_weak( nHead, nNewHead,
+										   std::memory_order_acq_rel,
+										   std::memory_order_acquire ) ) {
+			m_nUsed.fetch_add( 1, std::memory_order_relaxed );
+			return &m_pSlots[ nIndex ];
+		}
+	}
+}
+
+void NotePool::releaseSlot( uint32_t nIndex )
+{
+	uint64_t nHead = m_head.load( std::memory_order_relaxed );
+	uint64_t nNewHead;
+	do {
+		m_pNext[ nIndex ].store( static_cast<uint32_t>( nHead & 0xFFFFFFFF ),
+								 std::memory_order_relaxed );
+		nNewHead = ( ( ( nHead >> 32 ) + 1 ) << 32 ) | nIndex;
+	} while ( ! m_head.compare_exchange_weak( nHead, nNewHead,
+											  std::memory_order_release,
+											  std::memory_order_relaxed ) );
+
+	m_nUsed.fetch_sub( 1, std::memory_order_relaxed );
+	m_bExhaustionReported.store( false, std::memory_order_relaxed );
+}
+
+void NotePool::release( Note* pNote )
+{
+	if ( pNote == nullptr ) {
+		return;
+	}
+
+	if ( ! owns( pNote ) ) {
+		delete pNote;
+		return;
+	}
+
+	const auto nIndex = static_cast<uint32_t>(
+		reinterpret_cast<Slot*>( pNote ) - m_pSlots );
+	pNote->~Note();
+	releaseSlot( nIndex );
+}
+
+void NotePool::reportExhaustion()
+{
+	m_nExhaustedCount.fetch_add( 1, std::memory_order_relaxed );
+
+	// No logging in here since this function is usually called from
+	// within the audio thread. The event is only pushed once till a
+	// slot gets available again to not flood the EventQueue.
+	if ( ! m_bExhaustionReported.exchange( true, std::memory_order_relaxed ) ) {
+		EventQueue::get_instance()->push_event( EVENT_NOTE_POOL_EXHAUSTED, m_nCapacity );
+	}
+}
+
+};
@@ -0,0 +1,156 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef NOTE_POOL_H
+#define NOTE_POOL_H
+
+#include <core/Object.h>
+#include <core/Basics/Note.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace H2Core
+{
+
+/**
+ * Preallocated storage for all Notes handled by the #AudioEngine and
+ * the #Sampler.
+ *
+ * Every Note copied into the song note queue, every metronome and
+ * stop note, and all realtime and preview notes passed to the
+ * #Sampler are constructed in one of the slots of the pool using
+ * create() and destroyed using release(). Neither of these calls
+ * touches the heap (for the Note object itself) or takes a lock. The
+ * free slots are organized in a lock-free stack of indices whose head
+ * is tagged with a generation counter to avoid the ABA problem. This
+ * way the GUI, the MIDI driver, and the audio thread can all use the
+ * pool at the same time.
+ *
+ * The capacity is derived from Preferences::m_nMaxNotes when the
+ * #AudioEngine is created. In case all slots are in use, create()
+ * returns nullptr and an #EVENT_NOTE_POOL_EXHAUSTED is pushed to the
+ * #EventQueue instead of falling back to the heap.
+ */
+/** \ingroup docCore docAudioEngine */
+class NotePool : public H2Core::Object<NotePool>
+{
+	H2_OBJECT(NotePool)
+public:
+	/** Number of slots per note the #Sampler is allowed to play
+	 * (Preferences::m_nMaxNotes). The remaining ones are used by the
+	 * notes waiting in the song and MIDI note queues.*/
+	static constexpr int nSlotsPerVoice = 4;
+
+	NotePool( int nCapacity );
+	~NotePool();
+
+	/**
+	 * Constructs a new Note in a free slot of the pool.
+	 *
+	 * All arguments are forwarded to the corresponding constructor of
+	 * Note.
+	 *
+	 * \return Pointer to the new Note or nullptr in case the pool is
+	 * exhausted.
+	 */
+	template <typename... Args>
+	Note* create( Args&&... args );
+
+	/**
+	 * Destroys @a pNote and returns its slot to the pool.
+	 *
+	 * Notes which were not constructed by create() - e.g. the ones
+	 * passed by older parts of the code - are deleted instead.
+	 */
+	void release( Note* pNote );
+
+	/** \return true if @a pNote is located in the storage of the pool.*/
+	bool owns( const Note* pNote ) const;
+
+	int getCapacity() const;
+	/** \return Number of slots currently in use.*/
+	int getUsed() const;
+	/** \return Number of calls to create() which failed since the pool
+	 * was constructed.*/
+	int getExhaustedCount() const;
+
+private:
+	typedef typename std::aligned_storage<sizeof(Note), alignof(Note)>::type Slot;
+
+	/** Marks the end of the free list.*/
+	static constexpr uint32_t nInvalidIndex = 0xFFFFFFFF;
+
+	void* acquireSlot();
+	void releaseSlot( uint32_t nIndex );
+	void reportExhaustion();
+
+	int m_nCapacity;
+	Slot* m_pSlots;
+	/** Index of the next free slot for each free slot.*/
+	std::atomic<uint32_t>* m_pNext;
+	/** Head of the free list. The lower 32 bits hold the index of
+	 * the first free slot, the upper 32 bits a counter incremented
+	 * on each modification.*/
+	std::atomic<uint64_t> m_head;
+
+	std::atomic<int> m_nUsed;
+	std::atomic<int> m_nExhaustedCount;
+	/** Ensures only a single event is pushed until a slot gets
+	 * available again.*/
+	std::atomic<bool> m_bExhaustionReported;
+};
+
+template <typename... Args>
+inline Note* NotePool::create( Args&&... args )
+{
+	void* pSlot = acquireSlot();
+	if ( pSlot == nullptr ) {
+		reportExhaustion();
+		return nullptr;
+	}
+	return new ( pSlot ) Note( std::forward<Args>( args )... );
+}
+
+inline bool NotePool::owns( const Note* pNote ) const
+{
+	const auto nAddress = reinterpret_cast<std::uintptr_t>( pNote );
+	return nAddress >= reinterpret_cast<std::uintptr_t>( m_pSlots ) &&
+		nAddress < reinterpret_cast<std::uintptr_t>( m_pSlots + m_nCapacity );
+}
+
+inline int NotePool::getCapacity() const {
+	return m_nCapacity;
+}
+inline int NotePool::getUsed() const {
+	return m_nUsed.load( std::memory_order_relaxed );
+}
+inline int NotePool::getExhaustedCount() const {
+	return m_nExhaustedCount.load( std::memory_order_relaxed );
+}
+
+};
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/AudioEngine/NoteProgram.h>
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+
+namespace H2Core
+{
+
+NoteProgram::NoteProgram( int nCapacity )
+	: m_nCursor( 0 )
+	, m_bValid( false )
+	, m_nNotesRevision( 0 )
+{
+	m_events.reserve( nCapacity );
+}
+
+NoteProgram::~NoteProgram()
+{
+}
+
+void NoteProgram::compile( PatternList* pPatterns )
+{
+	// Retrieved before accessing the notes. Edits performed while
+	// compiling will trigger another compilation.
+	m_nNotesRevision = Pattern::get_notes_revision();
+
+	// Does not free the reserved memory.
+	m_events.clear();
+
+	if ( pPatterns != nullptr ) {
+		for ( const auto& ppPattern : *pPatterns ) {
+			if ( ppPattern == nullptr ) {
+				continue;
+			}
+			FOREACH_NOTE_CST_IT_BEGIN_END( ppPattern->get_notes(), it ) {
+				if ( it->second != nullptr ) {
+					m_events.push_back( { it->first, static_cast<int>( m_events.size() ),
+										  it->second } );
+				}
+			}
+		}
+	}
+
+	// std::stable_sort() might allocate a temporary buffer. Since
+	// this function is called from within the audio thread, the
+	// order of insertion is used as tie breaker instead.
+	std::sort( m_events.begin(), m_events.end(),
+			   []( const Event& a, const Event& b ) {
+				   return a.nTick < b.nTick ||
+					   ( a.nTick == b.nTick && a.nOrder < b.nOrder ); } );
+
+	m_nCursor = 0;
+	m_bValid = true;
+}
+
+};
@@ -0,0 +1,170 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef NOTE_PROGRAM_H
+#define NOTE_PROGRAM_H
+
+#include <core/Object.h>
+#include <core/Basics/Note.h>
+#include <core/Basics/Pattern.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace H2Core
+{
+
+class PatternList;
+
+/**
+ * Flat, tick-sorted copy of all notes of the patterns currently
+ * played back by the #AudioEngine.
+ *
+ * Instead of looking up the current tick in the note map of each
+ * playing pattern - including the ones added by
+ * Pattern::addFlattenedVirtualPatterns() - for every single tick
+ * processed, all notes are compiled once into a contiguous array.
+ * forEachNoteAt() then only has to advance a cursor through it. As
+ * long as ticks are visited in ascending order this costs constant
+ * time per tick regardless of the number of patterns. A binary search
+ * is only required after a relocation or when the pattern loops.
+ *
+ * The program holds raw pointers to the notes of the patterns. It
+ * becomes invalid as soon as notes are inserted into or removed from
+ * any pattern (see Pattern::get_notes_revision()) and has to be
+ * invalidated explicitly whenever the set of playing patterns
+ * changes. In both cases it must be recompiled before being used
+ * again.
+ */
+/** \ingroup docCore docAudioEngine */
+class NoteProgram : public H2Core::Object<NoteProgram>
+{
+	H2_OBJECT(NoteProgram)
+public:
+	struct Event {
+		/** Tick the note is located at within its pattern.*/
+		int nTick;
+		/** Position of the note within the concatenated patterns.
+		 * Used to order notes sharing the same tick.*/
+		int nOrder;
+		Note* pNote;
+	};
+
+	/** Capacity used by the #AudioEngine. Large enough to hold the
+	 * patterns of most songs without allocating additional memory.*/
+	static constexpr int nDefaultCapacity = 4096;
+
+	/** \param nCapacity Number of notes the program can hold without
+	 * allocating additional memory. */
+	NoteProgram( int nCapacity = 0 );
+	~NoteProgram();
+
+	/**
+	 * Replaces the content of the program with all notes of @a
+	 * pPatterns.
+	 *
+	 * Notes sharing the same tick are ordered as they occur in the
+	 * patterns and @a pPatterns. Memory is only allocated in case
+	 * the number of notes exceeds capacity().
+	 */
+	void compile( PatternList* pPatterns );
+	/** Marks the program outdated. It has to be compiled again
+	 * before use.*/
+	void invalidate();
+	/** \return Whether the program was compiled and no notes were
+	 * inserted into or removed from any pattern since.*/
+	bool isValid() const;
+	int size() const;
+	int capacity() const;
+	/**
+	 * Ensures the program can hold @a nCapacity notes without
+	 * allocating memory in compile().
+	 *
+	 * Must not be called from within the audio thread.
+	 */
+	void reserve( int nCapacity );
+
+	/**
+	 * Calls @a visit for all notes located at @a nTick.
+	 *
+	 * \param visit Callable taking a Note* as its only argument.
+	 */
+	template <typename Visitor>
+	void forEachNoteAt( int nTick, Visitor visit );
+
+private:
+	/** \return Index of the first event not located before @a nTick.*/
+	int seek( int nTick );
+
+	std::vector<Event> m_events;
+	/** Index of the event following the ones visited last.*/
+	int m_nCursor;
+	bool m_bValid;
+	/** Pattern::get_notes_revision() at the time of the last
+	 * compile().*/
+	int m_nNotesRevision;
+};
+
+inline void NoteProgram::invalidate() {
+	m_bValid = false;
+}
+inline bool NoteProgram::isValid() const {
+	return m_bValid && m_nNotesRevision == Pattern::get_notes_revision();
+}
+inline int NoteProgram::size() const {
+	return static_cast<int>( m_events.size() );
+}
+inline int NoteProgram::capacity() const {
+	return static_cast<int>( m_events.capacity() );
+}
+inline void NoteProgram::reserve( int nCapacity ) {
+	m_events.reserve( nCapacity );
+}
+
+inline int NoteProgram::seek( int nTick ) {
+	const int nSize = size();
+	// Ticks are usually visited in ascending order. In that case the
+	// cursor already points to the right position.
+	if ( ( m_nCursor == 0 || m_events[ m_nCursor - 1 ].nTick < nTick ) &&
+		 ( m_nCursor == nSize || m_events[ m_nCursor ].nTick >= nTick ) ) {
+		return m_nCursor;
+	}
+
+	return static_cast<int>(
+		std::lower_bound( m_events.begin(), m_events.end(), nTick,
+						  []( const Event& event, int nValue ) {
+							  return event.nTick < nValue; } ) - m_events.begin() );
+}
+
+template <typename Visitor>
+void NoteProgram::forEachNoteAt( int nTick, Visitor visit ) {
+	const int nSize = size();
+	int nIndex = seek( nTick );
+	for ( ; nIndex < nSize && m_events[ nIndex ].nTick == nTick; ++nIndex ) {
+		visit( m_events[ nIndex ].pNote );
+	}
+	m_nCursor = nIndex;
+}
+
+};
+
+#endif
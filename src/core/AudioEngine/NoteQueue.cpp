@@ -0,0 +1,117 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/AudioEngine/NoteQueue.h>
+
+#include <algorithm>
+
+namespace H2Core
+{
+
+NoteQueue::NoteQueue( int nCapacity )
+	: m_nNextSequence( 0 )
+{
+	m_entries.reserve( nCapacity );
+}
+
+NoteQueue::~NoteQueue()
+{
+}
+
+void NoteQueue::push( Note* pNote )
+{
+	m_entries.push_back( { pNote->getNoteStart(), m_nNextSequence++, pNote } );
+	siftUp( static_cast<int>( m_entries.size() ) - 1 );
+}
+
+void NoteQueue::pop()
+{
+	if ( m_entries.empty() ) {
+		return;
+	}
+
+	m_entries.front() = m_entries.back();
+	m_entries.pop_back();
+	if ( ! m_entries.empty() ) {
+		siftDown( 0 );
+	}
+}
+
+void NoteQueue::clear()
+{
+	// Does not free the reserved memory.
+	m_entries.clear();
+	m_nNextSequence = 0;
+}
+
+void NoteQueue::siftUp( int nIndex )
+{
+	const Entry entry = m_entries[ nIndex ];
+	while ( nIndex > 0 ) {
+		const int nParent = ( nIndex - 1 ) / nArity;
+		if ( ! before( entry, m_entries[ nParent ] ) ) {
+			break;
+		}
+		m_entries[ nIndex ] = m_entries[ nParent ];
+		nIndex = nParent;
+	}
+	m_entries[ nIndex ] = entry;
+}
+
+void NoteQueue::siftDown( int nIndex )
+{
+	const int nSize = static_cast<int>( m_entries.size() );
+	const Entry entry = m_entries[ nIndex ];
+	while ( true ) {
+		const int nFirstChild = nArity * nIndex + 1;
+		if ( nFirstChild >= nSize ) {
+			break;
+		}
+
+		const int nLastChild = std::min( nFirstChild + nArity, nSize );
+		int nMinChild = nFirstChild;
+		for ( int nn = nFirstChild + 1; nn < nLastChild; ++nn ) {
+			if ( before( m_entries[ nn ], m_entries[ nMinChild ] ) ) {
+				nMinChild = nn;
+			}
+		}
+
+		if ( ! before( m_entries[ nMinChild ], entry ) ) {
+			break;
+		}
+		m_entries[ nIndex ] = m_entries[ nMinChild ];
+		nIndex = nMinChild;
+	}
+	m_entries[ nIndex ] = entry;
+}
+
+void NoteQueue::heapify()
+{
+	if ( m_entries.size() < 2 ) {
+		return;
+	}
+	for ( int ii = ( static_cast<int>( m_entries.size() ) - 2 ) / nArity; ii >= 0; --ii ) {
+		siftDown( ii );
+	}
+}
+
+};
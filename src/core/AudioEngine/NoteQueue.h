@@ -0,0 +1,132 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef NOTE_QUEUE_H
+#define NOTE_QUEUE_H
+
+#include <core/Object.h>
+#include <core/Basics/Note.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace H2Core
+{
+
+/**
+ * Priority queue of all notes waiting to be passed to the #Sampler
+ * ordered by their start in frames.
+ *
+ * Instead of dereferencing two notes in each comparison - like
+ * std::priority_queue<Note*> does - the start of a note
+ * (Note::getNoteStart()) is cached next to the pointer in a flat,
+ * preallocated array which is organized as a 4-ary min-heap. Notes
+ * sharing the same start are ordered by a sequence number assigned on
+ * insertion. This way notes pushed first will be played first
+ * regardless of the internal layout of the heap.
+ *
+ * Since the start of a note is read only once in push(), it has to be
+ * computed (Note::computeNoteStart()) beforehand. In case it changes
+ * while the note is queued, e.g. due to a tempo change, the queue has
+ * to be updated using updateAll().
+ */
+/** \ingroup docCore docAudioEngine */
+class NoteQueue : public H2Core::Object<NoteQueue>
+{
+	H2_OBJECT(NoteQueue)
+public:
+	/** \param nCapacity Number of notes the queue can hold without
+	 * allocating additional memory. */
+	NoteQueue( int nCapacity = 0 );
+	~NoteQueue();
+
+	bool empty() const;
+	int size() const;
+	/** \return Note with the lowest start (first one inserted in case
+	 * of ties) or nullptr if the queue is empty. */
+	Note* top() const;
+
+	void push( Note* pNote );
+	void pop();
+	/** Removes all notes without destroying them. */
+	void clear();
+
+	/**
+	 * Applies @a modify to all queued notes and restores the order of
+	 * the queue afterwards.
+	 *
+	 * The relative order of notes with the same start is retained.
+	 *
+	 * \param modify Callable taking a Note* as its only argument. It
+	 * has to take care of calling Note::computeNoteStart() itself.
+	 */
+	template <typename Modifier>
+	void updateAll( Modifier modify );
+
+private:
+	struct Entry {
+		long long nNoteStart;
+		uint64_t nSequence;
+		Note* pNote;
+	};
+
+	/** Number of children of each node in the heap.*/
+	static constexpr int nArity = 4;
+
+	static bool before( const Entry& a, const Entry& b );
+	void siftUp( int nIndex );
+	void siftDown( int nIndex );
+	/** Restores the heap property of the whole #m_entries in linear
+	 * time.*/
+	void heapify();
+
+	std::vector<Entry> m_entries;
+	/** Sequence number assigned to the next inserted note.*/
+	uint64_t m_nNextSequence;
+};
+
+inline bool NoteQueue::empty() const {
+	return m_entries.empty();
+}
+inline int NoteQueue::size() const {
+	return static_cast<int>( m_entries.size() );
+}
+inline Note* NoteQueue::top() const {
+	return m_entries.empty() ? nullptr : m_entries.front().pNote;
+}
+inline bool NoteQueue::before( const Entry& a, const Entry& b ) {
+	return a.nNoteStart < b.nNoteStart ||
+		( a.nNoteStart == b.nNoteStart && a.nSequence < b.nSequence );
+}
+
+template <typename Modifier>
+void NoteQueue::updateAll( Modifier modify ) {
+	for ( auto& entry : m_entries ) {
+		modify( entry.pNote );
+		entry.nNoteStart = entry.pNote->getNoteStart();
+	}
+	heapify();
+}
+
+};
+
+#endif
@@ -0,0 +1,196 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/AudioEngine/TempoMap.h>
+#include <core/AudioEngine/AudioEngine.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Song.h>
+#include <core/Globals.h>
+#include <core/Timeline.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace H2Core
+{
+
+TempoMap::TempoMap()
+	: m_fSongSizeInTicks( 0 )
+	, m_fSongSizeInFrames( 0 )
+	, m_bHasTempoMarkers( false )
+	, m_nSampleRate( 0 )
+	, m_nResolution( 0 )
+	, m_nColumns( 0 )
+{
+}
+
+void TempoMap::update( std::shared_ptr<Song> pSong, std::shared_ptr<Timeline> pTimeline,
+					   double fSongSizeInTicks, int nSampleRate )
+{
+	m_segments.clear();
+	m_fSongSizeInTicks = fSongSizeInTicks;
+	m_fSongSizeInFrames = 0;
+	m_bHasTempoMarkers = false;
+	m_nSampleRate = nSampleRate;
+	m_nResolution = pSong != nullptr ? pSong->getResolution() : 0;
+	m_nColumns = pSong != nullptr ? pSong->getPatternGroupVector()->size() : 0;
+
+	if ( pSong == nullptr || pTimeline == nullptr ) {
+		return;
+	}
+
+	const auto tempoMarkers = pTimeline->getAllTempoMarkers();
+	m_bHasTempoMarkers = ! ( tempoMarkers.size() == 1 &&
+							 pTimeline->isFirstTempoMarkerSpecial() );
+	if ( ! m_bHasTempoMarkers ) {
+		return;
+	}
+
+	// The TempoMarkers are sorted by column. Instead of summing up
+	// all columns in front of each of them, the start tick of the
+	// columns is accumulated while walking through the markers.
+	const auto pColumns = pSong->getPatternGroupVector();
+	int nColumn = 0;
+	long nColumnTick = 0;
+	auto tickForColumn = [&]( int nTargetColumn ) {
+		for ( ; nColumn < nTargetColumn; ++nColumn ) {
+			PatternList* pColumn = ( *pColumns )[ nColumn ];
+			nColumnTick += pColumn->size() > 0 ?
+				pColumn->longest_pattern_length() : MAX_NOTES;
+		}
+		return static_cast<double>( nColumnTick );
+	};
+
+	double fPassedTicks = 0;
+	double fPassedFrames = 0;
+	for ( int ii = 1; ii <= tempoMarkers.size(); ++ii ) {
+		Segment segment;
+		segment.fStartTick = fPassedTicks;
+		segment.fStartFrame = fPassedFrames;
+		if ( ii == tempoMarkers.size() ||
+			 tempoMarkers[ ii ]->nColumn >= m_nColumns ) {
+			segment.fEndTick = fSongSizeInTicks;
+		} else {
+			segment.fEndTick = tickForColumn( tempoMarkers[ ii ]->nColumn );
+		}
+		segment.fTickSize =
+			AudioEngine::computeDoubleTickSize( nSampleRate, tempoMarkers[ ii - 1 ]->fBpm,
+												m_nResolution );
+		segment.fNextTickSize =
+			AudioEngine::computeDoubleTickSize( nSampleRate,
+												tempoMarkers[ ii < tempoMarkers.size() ? ii : 0 ]->fBpm,
+												m_nResolution );
+
+		fPassedFrames += ( segment.fEndTick - segment.fStartTick ) * segment.fTickSize;
+		fPassedTicks = segment.fEndTick;
+		segment.fEndFrame = fPassedFrames;
+
+		m_segments.push_back( segment );
+	}
+
+	m_fSongSizeInFrames = fPassedFrames;
+}
+
+long long TempoMap::computeFrameFromTick( double fTick, double* fTickMismatch ) const
+{
+	*fTickMismatch = 0;
+	if ( m_segments.empty() || m_fSongSizeInTicks <= 0 || fTick <= 0 ) {
+		return 0;
+	}
+
+	double fFrames = 0;
+	double fRemainingTicks = fTick;
+	if ( fTick > m_fSongSizeInTicks ) {
+		// The provided tick is larger than the song. Strip away all
+		// repetitions.
+		const double fRepetitions = std::floor( fTick / m_fSongSizeInTicks );
+		fFrames = fRepetitions * m_fSongSizeInFrames;
+		fRemainingTicks = std::fmod( fTick, m_fSongSizeInTicks );
+
+		if ( std::isinf( fFrames ) ||
+			 fFrames > static_cast<double>( std::numeric_limits<long long>::max() ) ) {
+			ERRORLOG( QString( "Provided ticks [%1] are too large." ).arg( fTick ) );
+			return 0;
+		}
+	}
+
+	// First segment ending at or after the remaining ticks.
+	auto it = std::lower_bound( m_segments.begin(), m_segments.end(), fRemainingTicks,
+								[]( const Segment& segment, double fValue ) {
+									return segment.fEndTick < fValue; } );
+	if ( it == m_segments.end() ) {
+		--it;
+	}
+
+	const double fNewFrames = fFrames + it->fStartFrame +
+		( fRemainingTicks - it->fStartTick ) * it->fTickSize;
+	const long long nNewFrames = static_cast<long long>( std::round( fNewFrames ) );
+	const double fMismatchInFrames = fNewFrames - static_cast<double>( nNewFrames );
+
+	// In case we ended at the very tick containing a tempo marker
+	// and the frame was rounded up, the mismatch resides on the other
+	// side of the marker.
+	if ( fRemainingTicks == it->fEndTick && fMismatchInFrames < 0 ) {
+		*fTickMismatch = fMismatchInFrames / it->fNextTickSize;
+	} else {
+		*fTickMismatch = fMismatchInFrames / it->fTickSize;
+	}
+
+	return nNewFrames;
+}
+
+double TempoMap::computeTickFromFrame( long long nFrame ) const
+{
+	if ( m_segments.empty() || m_fSongSizeInFrames <= 0 || nFrame <= 0 ) {
+		return 0;
+	}
+
+	const double fTargetFrames = static_cast<double>( nFrame );
+	double fTick = 0;
+	double fRemainingFrames = fTargetFrames;
+	if ( fTargetFrames > m_fSongSizeInFrames ) {
+		// The provided frame is larger than the song. Strip away all
+		// repetitions.
+		const double fRepetitions = std::floor( fTargetFrames / m_fSongSizeInFrames );
+		if ( m_fSongSizeInTicks * fRepetitions >
+			 std::numeric_limits<double>::max() ) {
+			ERRORLOG( QString( "Provided frames [%1] are too large." ).arg( nFrame ) );
+			return 0;
+		}
+		fTick = m_fSongSizeInTicks * fRepetitions;
+		fRemainingFrames = fTargetFrames - fRepetitions * m_fSongSizeInFrames;
+	}
+
+	// First segment ending at or after the remaining frames.
+	auto it = std::lower_bound( m_segments.begin(), m_segments.end(), fRemainingFrames,
+								[]( const Segment& segment, double fValue ) {
+									return segment.fEndFrame < fValue; } );
+	if ( it == m_segments.end() ) {
+		--it;
+	}
+
+	return fTick + it->fStartTick +
+		( fRemainingFrames - it->fStartFrame ) / it->fTickSize;
+}
+
+};
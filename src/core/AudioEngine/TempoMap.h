@@ -0,0 +1,139 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <core/Object.h>
+
+#include <memory>
+#include <vector>
+
+namespace H2Core
+{
+
+class Song;
+class Timeline;
+
+/**
+ * Piecewise linear mapping between ticks and frames of a Song with
+ * the #Timeline enabled.
+ *
+ * Each TempoMarker defines a segment reaching till the next one (or
+ * the end of the song) in which the tick size is constant. For each
+ * segment the first and last tick as well as the corresponding
+ * frames are cached. This way both computeFrameFromTick() and
+ * computeTickFromFrame() boil down to a binary search over the
+ * segments instead of walking all TempoMarkers and summing up the
+ * length of all preceding columns.
+ *
+ * The map has to be rebuilt using update() whenever the #Timeline,
+ * the size of the song, its resolution, or the sample rate changes.
+ * This is done by AudioEngine::updateTempoMap() outside of the audio
+ * thread. The map does not track these changes itself.
+ */
+/** \ingroup docCore docAudioEngine */
+class TempoMap : public H2Core::Object<TempoMap>
+{
+	H2_OBJECT(TempoMap)
+public:
+	TempoMap();
+
+	/**
+	 * Rebuilds all segments.
+	 *
+	 * \param pSong Provides the length of the columns and the
+	 * resolution.
+	 * \param pTimeline Provides the TempoMarkers.
+	 * \param fSongSizeInTicks Length of the song. TempoMarkers
+	 * located beyond it are ignored.
+	 * \param nSampleRate Sample rate used to convert ticks into
+	 * frames.
+	 */
+	void update( std::shared_ptr<Song> pSong, std::shared_ptr<Timeline> pTimeline,
+				 double fSongSizeInTicks, int nSampleRate );
+
+	/** \return false if the #Timeline does not contain any
+	 * TempoMarker set by the user. In this case the tempo of the
+	 * AudioEngine is used instead of the map.*/
+	bool hasTempoMarkers() const;
+
+	/**
+	 * Calculates the frame equivalent to @a fTick. Positions beyond
+	 * the end of the song are treated as if the song was looped.
+	 *
+	 * \param fTick Transport position in ticks.
+	 * \param fTickMismatch Reports by how much @a fTick exceeds the
+	 * returned frame.
+	 */
+	long long computeFrameFromTick( double fTick, double* fTickMismatch ) const;
+	/**
+	 * Calculates the tick equivalent to @a nFrame. Positions beyond
+	 * the end of the song are treated as if the song was looped.
+	 */
+	double computeTickFromFrame( long long nFrame ) const;
+
+	int getSegmentCount() const;
+	double getSongSizeInFrames() const;
+	/** \return Sample rate the map was built with.*/
+	int getSampleRate() const;
+
+private:
+	/** Part of the song with constant tick size.*/
+	struct Segment {
+		double fStartTick;
+		double fEndTick;
+		double fStartFrame;
+		double fEndFrame;
+		double fTickSize;
+		/** Tick size of the following segment. The first one
+		 * follows the last one.*/
+		double fNextTickSize;
+	};
+
+	std::vector<Segment> m_segments;
+	double m_fSongSizeInTicks;
+	double m_fSongSizeInFrames;
+	bool m_bHasTempoMarkers;
+
+	// Arguments the map was built with.
+	int m_nSampleRate;
+	int m_nResolution;
+	int m_nColumns;
+};
+
+inline bool TempoMap::hasTempoMarkers() const {
+	return m_bHasTempoMarkers;
+}
+inline int TempoMap::getSegmentCount() const {
+	return m_segments.size();
+}
+inline double TempoMap::getSongSizeInFrames() const {
+	return m_fSongSizeInFrames;
+}
+inline int TempoMap::getSampleRate() const {
+	return m_nSampleRate;
+}
+
+};
+
+#endif
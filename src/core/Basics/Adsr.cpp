@@ -83,17 +83,38 @@ ADSR::ADSR( unsigned int attack, unsigned int decay, float sustain, unsigned int
 	normalise();
 }
 
-ADSR::ADSR( const std::shared_ptr<ADSR> other ) :
-	__attack( other->__attack ),
-	__decay( other->__decay ),
-	__sustain( other->__sustain ),
-	__release( other->__release ),
-	__state( other->__state ),
-	__ticks( other->__ticks ),
-	__value( other->__value ),
-	__release_value( other->__release_value )
+ADSR::ADSR( const std::shared_ptr<ADSR> other ) : ADSR( *other )
 {
+}
+
+ADSR::ADSR( const ADSR& other ) :
+	Object( other ),
+	__attack( other.__attack ),
+	__decay( other.__decay ),
+	__sustain( other.__sustain ),
+	__release( other.__release ),
+	__state( other.__state ),
+	__ticks( other.__ticks ),
+	__value( other.__value ),
+	__release_value( other.__release_value ),
+	m_fQ( other.m_fQ )
+{
+	normalise();
+}
+
+ADSR& ADSR::operator=( const ADSR& other )
+{
+	__attack = other.__attack;
+	__decay = other.__decay;
+	__sustain = other.__sustain;
+	__release = other.__release;
+	__state = other.__state;
+	__ticks = other.__ticks;
+	__value = other.__value;
+	__release_value = other.__release_value;
+	m_fQ = other.m_fQ;
 	normalise();
+	return *this;
 }
 
 ADSR::~ADSR() { }
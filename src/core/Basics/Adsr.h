@@ -50,6 +50,10 @@ class ADSR : public Object<ADSR>
 
 		/** copy constructor */
 		ADSR( const std::shared_ptr<ADSR> other );
+		/** copy constructor */
+		ADSR( const ADSR& other );
+		/** copies both the parameters and the current state of @a other */
+		ADSR& operator=( const ADSR& other );
 
 		/** destructor */
 		~ADSR();
@@ -0,0 +1,124 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/Basics/DrumkitSampleLoader.h>
+
+#include <core/Basics/Drumkit.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentComponent.h>
+#include <core/Basics/InstrumentLayer.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Basics/Sample.h>
+#include <core/EventQueue.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+namespace H2Core
+{
+
+DrumkitSampleLoader::DrumkitSampleLoader( Drumkit* pDrumkit )
+{
+	assert( pDrumkit );
+
+	for ( const auto& pInstrument : *pDrumkit->get_instruments() ) {
+		for ( const auto& pComponent : *pInstrument->get_components() ) {
+			for ( int ii = 0; ii < InstrumentComponent::getMaxLayers(); ++ii ) {
+				auto pLayer = pComponent->get_layer( ii );
+				if ( pLayer == nullptr || pLayer->get_sample() == nullptr ) {
+					continue;
+				}
+
+				m_taskIndices[ pLayer.get() ] = m_tasks.size();
+				m_tasks.push_back( { pDrumkit->get_path() + "/" +
+									 pLayer->get_sample()->get_filename(),
+									 nullptr } );
+			}
+		}
+	}
+}
+
+DrumkitSampleLoader::~DrumkitSampleLoader()
+{
+}
+
+void DrumkitSampleLoader::load( int nThreads )
+{
+	const int nTasks = m_tasks.size();
+	if ( nTasks == 0 ) {
+		return;
+	}
+
+	if ( nThreads <= 0 ) {
+		nThreads = std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) );
+	}
+	nThreads = std::min( nThreads, nTasks );
+
+	INFOLOG( QString( "Loading [%1] samples using [%2] threads" )
+			 .arg( nTasks ).arg( nThreads ) );
+
+	EventQueue::get_instance()->push_event( EVENT_DRUMKIT_LOADING_PROGRESS, 0 );
+
+	std::atomic<int> nNextTask( 0 );
+	std::atomic<int> nFinishedTasks( 0 );
+
+	// Each worker picks the next task not yet handled. Since every
+	// task is only touched by a single worker, the results can be
+	// written without additional synchronization.
+	auto worker = [&]() {
+		int nTask;
+		while ( ( nTask = nNextTask.fetch_add( 1 ) ) < nTasks ) {
+			m_tasks[ nTask ].pSample = Sample::load( m_tasks[ nTask ].sFilepath );
+
+			const int nFinished = nFinishedTasks.fetch_add( 1 ) + 1;
+			const int nProgress = nFinished * 100 / nTasks;
+			if ( nProgress != ( nFinished - 1 ) * 100 / nTasks ) {
+				EventQueue::get_instance()->push_event( EVENT_DRUMKIT_LOADING_PROGRESS,
+														nProgress );
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	for ( int ii = 1; ii < nThreads; ++ii ) {
+		workers.emplace_back( worker );
+	}
+	// The calling thread does its share of the work too.
+	worker();
+
+	for ( auto& thread : workers ) {
+		thread.join();
+	}
+}
+
+std::shared_ptr<Sample> DrumkitSampleLoader::getSample( std::shared_ptr<InstrumentLayer> pLayer ) const
+{
+	auto it = m_taskIndices.find( pLayer.get() );
+	if ( it == m_taskIndices.end() ) {
+		return nullptr;
+	}
+	return m_tasks[ it->second ].pSample;
+}
+
+};
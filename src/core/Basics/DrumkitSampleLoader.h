@@ -0,0 +1,103 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef H2C_DRUMKIT_SAMPLE_LOADER_H
+#define H2C_DRUMKIT_SAMPLE_LOADER_H
+
+#include <core/Object.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace H2Core
+{
+
+class Drumkit;
+class InstrumentLayer;
+class Sample;
+
+/**
+ * Loads the samples of all layers of all instruments of a Drumkit
+ * using a pool of worker threads.
+ *
+ * Loading the sample data from disk is by far the most time
+ * consuming part of switching drumkits. Using this class it can be
+ * done upfront and without holding the lock of the #AudioEngine. The
+ * loaded samples are afterwards handed to
+ * Instrument::load_from( Drumkit*, std::shared_ptr<Instrument>, const DrumkitSampleLoader* )
+ * which only has to swap the resulting components into the song.
+ *
+ * The Drumkit itself is not altered and its samples are neither
+ * loaded nor shared with the instruments of the song.
+ */
+/** \ingroup docCore docDataStructure */
+class DrumkitSampleLoader : public H2Core::Object<DrumkitSampleLoader>
+{
+	H2_OBJECT(DrumkitSampleLoader)
+public:
+	DrumkitSampleLoader( Drumkit* pDrumkit );
+	~DrumkitSampleLoader();
+
+	/**
+	 * Loads all samples. There is one task per InstrumentLayer which
+	 * are distributed among @a nThreads worker threads.
+	 *
+	 * The function returns once all samples are loaded. The progress
+	 * is reported using #EVENT_DRUMKIT_LOADING_PROGRESS with values
+	 * ranging from 0 to 100.
+	 *
+	 * \param nThreads Number of worker threads. If set to 0, the
+	 * number of available hardware threads is used.
+	 */
+	void load( int nThreads = 0 );
+
+	/**
+	 * \param pLayer Layer of one of the instruments of the drumkit
+	 * passed to the constructor.
+	 *
+	 * \return Sample loaded for @a pLayer or nullptr if it could not
+	 * be loaded (or load() was not called yet).
+	 */
+	std::shared_ptr<Sample> getSample( std::shared_ptr<InstrumentLayer> pLayer ) const;
+
+	/** \return Number of samples to load.*/
+	int size() const;
+
+private:
+	struct Task {
+		QString sFilepath;
+		std::shared_ptr<Sample> pSample;
+	};
+
+	std::vector<Task> m_tasks;
+	/** Maps the layers of the drumkit onto indices in #m_tasks.*/
+	std::map<const InstrumentLayer*, int> m_taskIndices;
+};
+
+inline int DrumkitSampleLoader::size() const {
+	return static_cast<int>( m_tasks.size() );
+}
+
+};
+
+#endif
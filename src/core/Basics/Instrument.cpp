@@ -33,6 +33,7 @@
 #include <core/Basics/Sample.h>
 #include <core/Basics/Drumkit.h>
 #include <core/Basics/DrumkitComponent.h>
+#include <core/Basics/DrumkitSampleLoader.h>
 #include <core/Basics/InstrumentList.h>
 #include <core/Basics/InstrumentComponent.h>
 #include <core/Basics/InstrumentLayer.h>
@@ -147,11 +148,10 @@ std::shared_ptr<Instrument> Instrument::load_instrument( const QString& drumkit_
 	return pInstrument;
 }
 
-void Instrument::load_from( Drumkit* pDrumkit, std::shared_ptr<Instrument> pInstrument )
+void Instrument::load_from( Drumkit* pDrumkit, std::shared_ptr<Instrument> pInstrument,
+							const DrumkitSampleLoader* pLoader )
 {
-	AudioEngine* pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
-
-	this->get_components()->clear();
+	auto pComponents = new std::vector<std::shared_ptr<InstrumentComponent>>;
 	
 	set_missing_samples( false );
 
@@ -159,7 +159,7 @@ void Instrument::load_from( Drumkit* pDrumkit, std::shared_ptr<Instrument> pInst
 		auto pMyComponent = std::make_shared<InstrumentComponent>( pSrcComponent->get_drumkit_componentID() );
 		pMyComponent->set_gain( pSrcComponent->get_gain() );
 
-		this->get_components()->push_back( pMyComponent );
+		pComponents->push_back( pMyComponent );
 
 		for ( int i = 0; i < InstrumentComponent::getMaxLayers(); i++ ) {
 			auto src_layer = pSrcComponent->get_layer( i );
@@ -169,7 +169,8 @@ void Instrument::load_from( Drumkit* pDrumkit, std::shared_ptr<Instrument> pInst
 				pMyComponent->set_layer( nullptr, i );
 			} else {
 				QString sample_path =  pDrumkit->get_path() + "/" + src_layer->get_sample()->get_filename();
-				auto pSample = Sample::load( sample_path );
+				auto pSample = pLoader != nullptr ? pLoader->getSample( src_layer ) :
+					Sample::load( sample_path );
 				if ( pSample == nullptr ) {
 					_ERRORLOG( QString( "Error loading sample %1. Creating a new empty layer." ).arg( sample_path ) );
 					set_missing_samples( true );
@@ -183,6 +184,9 @@ void Instrument::load_from( Drumkit* pDrumkit, std::shared_ptr<Instrument> pInst
 		}
 	}
 
+	std::swap( __components, pComponents );
+	delete pComponents;
+
 	this->set_id( pInstrument->get_id() );
 	this->set_name( pInstrument->get_name() );
 	this->set_drumkit_name( pDrumkit->get_name() );
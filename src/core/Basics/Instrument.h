@@ -42,6 +42,7 @@ class XMLNode;
 class ADSR;
 class Drumkit;
 class DrumkitComponent;
+class DrumkitSampleLoader;
 class InstrumentLayer;
 class InstrumentComponent;
 
@@ -93,10 +94,18 @@ class Instrument : public H2Core::Object<Instrument>
 
 		/**
 		 * loads instrument from a given instrument into a `live` Instrument object.
+		 *
+		 * The new components are assembled first and swapped in
+		 * afterwards in a single step.
+		 *
 		 * \param drumkit the drumkit the instrument belongs to
 		 * \param instrument to load samples and members from
+		 * \param pLoader If not nullptr, samples already loaded by
+		 * DrumkitSampleLoader::load() are used instead of reading
+		 * them from disk.
 		 */
-		void load_from( Drumkit* drumkit, std::shared_ptr<Instrument> instrument );
+		void load_from( Drumkit* drumkit, std::shared_ptr<Instrument> instrument,
+						const DrumkitSampleLoader* pLoader = nullptr );
 
 		/**
 		 * Calls the InstrumentLayer::load_sample() member
@@ -331,7 +340,7 @@ class Instrument : public H2Core::Object<Instrument>
 		bool					__soloed;				///< is the instrument in solo mode?
 		bool					__muted;				///< is the instrument muted?
 		int						__mute_group;			///< mute group of the instrument
-		int						__queued;				///< count the number of notes queued within Sampler::__playing_notes_queue or std::priority_queue m_songNoteQueue
+		int						__queued;				///< count the number of notes queued within Sampler::__playing_notes_queue or AudioEngine::m_songNoteQueue
 		float					__fx_level[MAX_FX];		///< Ladspa FX level array
 		int						__hihat_grp;			///< the instrument is part of a hihat
 		int						__lower_cc;				///< lower cc level
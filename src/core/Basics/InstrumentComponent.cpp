@@ -65,6 +65,7 @@ InstrumentComponent::InstrumentComponent( std::shared_ptr<InstrumentComponent> o
 			__layers[i] = nullptr;
 		}
 	}
+	updateLayerSelection();
 }
 
 InstrumentComponent::~InstrumentComponent()
@@ -78,6 +79,7 @@ void InstrumentComponent::set_layer( std::shared_ptr<InstrumentLayer> layer, int
 {
 	assert( idx >= 0 && idx < m_nMaxLayers );
 	__layers[ idx ] = layer;
+	updateLayerSelection();
 }
 
 void InstrumentComponent::setMaxLayers( int layers )
@@ -26,6 +26,7 @@
 #include <cassert>
 #include <vector>
 #include <core/Object.h>
+#include <core/Basics/LayerSelectionTable.h>
 #include <memory>
 
 
@@ -56,6 +57,18 @@ class InstrumentComponent : public H2Core::Object<InstrumentComponent>
 		std::shared_ptr<InstrumentLayer>	get_layer( int idx );
 		void				set_layer( std::shared_ptr<InstrumentLayer> layer, int idx );
 
+		/** Rebuilds the velocity lookup used by selectLayer().
+		 *
+		 * It is called by set_layer() but has to be called explicitly
+		 * after altering the start or end velocity of a layer already
+		 * part of the component.*/
+		void				updateLayerSelection();
+		/** Picks the layer to play for a note of velocity @a
+		 * fVelocity. See LayerSelectionTable::select().*/
+		int					selectLayer( float fVelocity,
+										 LayerSelectionTable::Mode mode,
+										 bool* pHole = nullptr );
+
 		void				set_drumkit_componentID( int related_drumkit_componentID );
 		int					get_drumkit_componentID();
 
@@ -92,6 +105,7 @@ class InstrumentComponent : public H2Core::Object<InstrumentComponent>
 		 * Preferences::Preferences(): 16. */
 		static int			m_nMaxLayers;
 		std::vector<std::shared_ptr<InstrumentLayer>>	__layers;
+		LayerSelectionTable	m_layerSelection;
 };
 
 // DEFINITIONS
@@ -118,6 +132,18 @@ inline float InstrumentComponent::get_gain() const
 	return __gain;
 }
 
+inline void InstrumentComponent::updateLayerSelection()
+{
+	m_layerSelection.update( __layers );
+}
+
+inline int InstrumentComponent::selectLayer( float fVelocity,
+											 LayerSelectionTable::Mode mode,
+											 bool* pHole )
+{
+	return m_layerSelection.select( fVelocity, mode, pHole );
+}
+
 inline std::shared_ptr<InstrumentLayer> InstrumentComponent::operator[]( int idx )
 {
 	assert( idx >= 0 && idx < m_nMaxLayers );
@@ -0,0 +1,233 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/Basics/LayerSelectionTable.h>
+#include <core/Basics/InstrumentLayer.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace H2Core
+{
+
+LayerSelectionTable::LayerSelectionTable()
+	: m_nRandomState( 0x9E3779B9 )
+{
+	std::fill( m_bucketStart, m_bucketStart + nBuckets, 0 );
+}
+
+void LayerSelectionTable::update( const std::vector<std::shared_ptr<InstrumentLayer>>& layers )
+{
+	m_boundaries.clear();
+	m_segments.clear();
+	m_candidates.clear();
+	std::vector<float> roundRobinKeys;
+
+	for ( const auto& pLayer : layers ) {
+		if ( pLayer != nullptr ) {
+			m_boundaries.push_back( pLayer->get_start_velocity() );
+			m_boundaries.push_back( pLayer->get_end_velocity() );
+		}
+	}
+	std::sort( m_boundaries.begin(), m_boundaries.end() );
+	m_boundaries.erase( std::unique( m_boundaries.begin(), m_boundaries.end() ),
+						m_boundaries.end() );
+
+	// Holes between two layers are split at their midpoint. This
+	// way each half gets a segment of its own. The lower half is
+	// assigned to the layers ending right below the hole, the upper
+	// half - including the midpoint - to the ones starting right
+	// above it.
+	const int nLayerBoundaries = m_boundaries.size();
+	for ( int nn = 1; nn < nLayerBoundaries; ++nn ) {
+		const float fLower = m_boundaries[ nn - 1 ];
+		const float fUpper = m_boundaries[ nn ];
+		const bool bCovered = std::any_of(
+			layers.begin(), layers.end(),
+			[&]( const std::shared_ptr<InstrumentLayer>& pLayer ) {
+				return pLayer != nullptr &&
+					pLayer->get_start_velocity() <= fLower &&
+					pLayer->get_end_velocity() >= fUpper; } );
+		if ( ! bCovered ) {
+			m_boundaries.push_back( 0.5 * ( fLower + fUpper ) );
+		}
+	}
+	std::sort( m_boundaries.begin(), m_boundaries.end() );
+	m_boundaries.erase( std::unique( m_boundaries.begin(), m_boundaries.end() ),
+						m_boundaries.end() );
+
+	const int nBoundaries = m_boundaries.size();
+	if ( nBoundaries == 0 ) {
+		m_roundRobins.clear();
+		std::fill( m_bucketStart, m_bucketStart + nBuckets, 0 );
+		return;
+	}
+
+	const float fInf = std::numeric_limits<float>::infinity();
+
+	for ( int nn = 0; nn < 2 * nBoundaries + 1; ++nn ) {
+		Segment segment;
+		segment.nOffset = m_candidates.size();
+		segment.bHole = false;
+
+		// Velocity range covered by the segment. For open intervals
+		// a layer has to cover both adjacent boundaries.
+		const int nBoundary = nn / 2;
+		const bool bPoint = nn % 2 == 1;
+		const float fLower = bPoint ? m_boundaries[ nBoundary ] :
+			( nBoundary > 0 ? m_boundaries[ nBoundary - 1 ] : -fInf );
+		const float fUpper = bPoint ? m_boundaries[ nBoundary ] :
+			( nBoundary < nBoundaries ? m_boundaries[ nBoundary ] : fInf );
+
+		for ( int ii = 0; ii < static_cast<int>( layers.size() ); ++ii ) {
+			const auto& pLayer = layers[ ii ];
+			if ( pLayer != nullptr &&
+				 pLayer->get_start_velocity() <= fLower &&
+				 pLayer->get_end_velocity() >= fUpper ) {
+				m_candidates.push_back( ii );
+			}
+		}
+
+		if ( static_cast<int>( m_candidates.size() ) == segment.nOffset ) {
+			// Hole. Use the layers ending right below or starting
+			// right above the segment instead - whichever is closer.
+			// Since holes were split at their midpoint, the whole
+			// segment lies within one half. The midpoint itself
+			// belongs to the upper one.
+			segment.bHole = true;
+			float fBelow = -fInf;
+			float fAbove = fInf;
+			for ( const auto& pLayer : layers ) {
+				if ( pLayer == nullptr ) {
+					continue;
+				}
+				if ( pLayer->get_end_velocity() <= fLower ) {
+					fBelow = std::max( fBelow, pLayer->get_end_velocity() );
+				}
+				if ( pLayer->get_start_velocity() >= fUpper ) {
+					fAbove = std::min( fAbove, pLayer->get_start_velocity() );
+				}
+			}
+
+			const bool bUseAbove = fBelow == -fInf ||
+				( fAbove != fInf && fAbove - fUpper <= fLower - fBelow );
+			for ( int ii = 0; ii < static_cast<int>( layers.size() ); ++ii ) {
+				const auto& pLayer = layers[ ii ];
+				if ( pLayer != nullptr &&
+					 ( bUseAbove ? pLayer->get_start_velocity() == fAbove :
+					   pLayer->get_end_velocity() == fBelow ) ) {
+					m_candidates.push_back( ii );
+				}
+			}
+		}
+		segment.nCount = m_candidates.size() - segment.nOffset;
+
+		// Round robin cursors are shared by all segments whose last
+		// candidate has the same start velocity.
+		const float fKey =
+			layers[ m_candidates.back() ]->get_start_velocity();
+		const auto it = std::find( roundRobinKeys.begin(), roundRobinKeys.end(), fKey );
+		segment.nRoundRobin = it - roundRobinKeys.begin();
+		if ( it == roundRobinKeys.end() ) {
+			roundRobinKeys.push_back( fKey );
+		}
+
+		m_segments.push_back( segment );
+	}
+
+	m_roundRobins.assign( roundRobinKeys.size(), 0 );
+
+	m_bucketStart[ 0 ] = 0;
+	for ( int nn = 1; nn < nBuckets; ++nn ) {
+		const float fBucketStart = static_cast<float>( nn ) / nBuckets;
+		m_bucketStart[ nn ] =
+			std::lower_bound( m_boundaries.begin(), m_boundaries.end(),
+							  fBucketStart ) - m_boundaries.begin();
+	}
+}
+
+int LayerSelectionTable::findSegment( float fVelocity ) const
+{
+	const int nBoundaries = m_boundaries.size();
+	if ( nBoundaries == 0 ) {
+		return -1;
+	}
+
+	const int nBucket = std::clamp( static_cast<int>( fVelocity * nBuckets ),
+									0, nBuckets - 1 );
+	int nBoundary = m_bucketStart[ nBucket ];
+	while ( nBoundary < nBoundaries && m_boundaries[ nBoundary ] < fVelocity ) {
+		++nBoundary;
+	}
+
+	if ( nBoundary < nBoundaries && m_boundaries[ nBoundary ] == fVelocity ) {
+		return 2 * nBoundary + 1;
+	}
+	return 2 * nBoundary;
+}
+
+int LayerSelectionTable::select( float fVelocity, Mode mode, bool* pHole )
+{
+	const int nSegment = findSegment( fVelocity );
+	if ( nSegment == -1 ) {
+		return -1;
+	}
+
+	const auto& segment = m_segments[ nSegment ];
+	if ( pHole != nullptr ) {
+		*pHole = segment.bHole;
+	}
+	const int* pCandidates = m_candidates.data() + segment.nOffset;
+
+	switch ( mode ) {
+	case Mode::RoundRobin: {
+		int& nLatest = m_roundRobins[ segment.nRoundRobin ];
+		int nIndex = nLatest + 1;
+		if ( nIndex >= segment.nCount ) {
+			nIndex = 0;
+		}
+		nLatest = nIndex;
+		return pCandidates[ nIndex ];
+	}
+
+	case Mode::Random:
+		m_nRandomState ^= m_nRandomState << 13;
+		m_nRandomState ^= m_nRandomState >> 17;
+		m_nRandomState ^= m_nRandomState << 5;
+		return pCandidates[ m_nRandomState % segment.nCount ];
+
+	case Mode::Velocity:
+	default:
+		return pCandidates[ 0 ];
+	}
+}
+
+int LayerSelectionTable::getCandidateCount( float fVelocity ) const
+{
+	const int nSegment = findSegment( fVelocity );
+	if ( nSegment == -1 || m_segments[ nSegment ].bHole ) {
+		return 0;
+	}
+	return m_segments[ nSegment ].nCount;
+}
+
+};
@@ -0,0 +1,138 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef H2C_LAYER_SELECTION_TABLE_H
+#define H2C_LAYER_SELECTION_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <core/Object.h>
+
+namespace H2Core
+{
+
+class InstrumentLayer;
+
+/**
+ * Precomputed lookup from note velocity to the layers of an
+ * InstrumentComponent which could be played.
+ *
+ * The start and end velocities of all layers split the velocity range
+ * into segments - the velocities at the boundaries themselves and the
+ * open intervals in between - each holding a constant set of
+ * candidate layers. A coarse table of #nBuckets entries points to the
+ * first boundary of each bucket, so finding the segment of a velocity
+ * takes a table read and a few comparisons at most. Ranges not
+ * covered by any layer (holes) are split at their midpoint. The
+ * lower half is assigned the layers ending right below the hole and
+ * the upper half, including the midpoint itself, the ones starting
+ * right above it. Holes below the lowest or above the highest layer
+ * are assigned that layer.
+ *
+ * The table is rebuilt by update() whenever a layer is added,
+ * removed, or its velocity range is changed. select() neither
+ * allocates nor locks and is meant to be called from within the
+ * audio thread.
+ */
+/** \ingroup docCore docDataStructure */
+class LayerSelectionTable : public H2Core::Object<LayerSelectionTable>
+{
+	H2_OBJECT(LayerSelectionTable)
+public:
+	enum class Mode {
+		/** First layer (lowest index) matching the velocity.*/
+		Velocity,
+		/** Cycle through all matching layers.*/
+		RoundRobin,
+		/** Pick one of the matching layers at random.*/
+		Random
+	};
+
+	LayerSelectionTable();
+
+	/** Rebuilds the table.
+	 *
+	 * \param layers All layers of the component with empty slots
+	 * being nullptr. The resulting layer indices refer to this
+	 * vector.*/
+	void update( const std::vector<std::shared_ptr<InstrumentLayer>>& layers );
+
+	/**
+	 * \param fVelocity Velocity of the note to play.
+	 * \param mode Selection algorithm.
+	 * \param pHole If not nullptr, it is set to true in case @a
+	 *   fVelocity fell into a hole between the velocity ranges of the
+	 *   layers and an adjacent layer was picked instead.
+	 *
+	 * \return Index of the selected layer or -1 in case there are no
+	 *   layers at all.
+	 */
+	int select( float fVelocity, Mode mode, bool* pHole = nullptr );
+
+	/** \return Number of layers matching @a fVelocity. */
+	int getCandidateCount( float fVelocity ) const;
+
+private:
+	/** Number of equally sized velocity buckets in #m_bucketStart.*/
+	static constexpr int nBuckets = 128;
+
+	struct Segment {
+		/** First candidate in #m_candidates.*/
+		int nOffset;
+		int nCount;
+		/** Whether the segment is not covered by any layer.*/
+		bool bHole;
+		/** Index of the round robin cursor in #m_roundRobins.*/
+		int nRoundRobin;
+	};
+
+	/** \return Index of the segment in #m_segments @a fVelocity
+	 * falls into or -1 if there are no segments.*/
+	int findSegment( float fVelocity ) const;
+
+	/** Sorted, unique start and end velocities of all layers as well
+	 * as the midpoints of all holes in between.*/
+	std::vector<float> m_boundaries;
+	/** Segment 2i is the open interval below boundary i and segment
+	 * 2i+1 boundary i itself. The last segment covers the range above
+	 * the highest boundary.*/
+	std::vector<Segment> m_segments;
+	/** Layer indices of all segments in ascending order.*/
+	std::vector<int> m_candidates;
+	/** Number of boundaries smaller than the lower end of each bucket.*/
+	int m_bucketStart[ nBuckets ];
+
+	/** Index of the layer last played in round robin mode. Segments
+	 * whose last candidate shares the same start velocity share a
+	 * cursor.
+	 *
+	 * Only accessed from within the audio thread.*/
+	std::vector<int> m_roundRobins;
+	/** State of the xorshift generator used in random mode.*/
+	uint32_t m_nRandomState;
+};
+
+};
+
+#endif
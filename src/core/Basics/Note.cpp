@@ -22,6 +22,7 @@
 
 #include <core/Basics/Note.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include <core/Helpers/Xml.h>
@@ -50,11 +51,12 @@ Note::Note( std::shared_ptr<Instrument> instrument, int position, float velocity
 	  __pitch( pitch ),
 	  __key( C ),
 	  __octave( P8 ),
-	  __adsr( nullptr ),
+	  __adsr(),
 	  __lead_lag( 0.0 ),
 	  __cut_off( 1.0 ),
 	  __resonance( 0.0 ),
 	  __humanize_delay( 0 ),
+	  __layers_selected_count( 0 ),
 	  __bpfb_l( 0.0 ),
 	  __bpfb_r( 0.0 ),
 	  __lpfb_l( 0.0 ),
@@ -65,20 +67,11 @@ Note::Note( std::shared_ptr<Instrument> instrument, int position, float velocity
 	  __just_recorded( false ),
 	  __probability( 1.0f ),
 	  m_nNoteStart( 0 ),
+	  m_bFixedNoteStart( false ),
 	  m_fUsedTickSize( std::nan("") )
 {
 	if ( __instrument != nullptr ) {
-		__adsr = __instrument->copy_adsr();
-		__instrument_id = __instrument->get_id();
-
-		for ( const auto& pCompo : *__instrument->get_components() ) {
-
-			std::shared_ptr<SelectedLayerInfo> sampleInfo = std::make_shared<SelectedLayerInfo>();
-			sampleInfo->SelectedLayer = -1;
-			sampleInfo->SamplePosition = 0;
-
-			__layers_selected[ pCompo->get_drumkit_componentID() ] = sampleInfo;
-		}
+		initInstrumentState();
 	}
 
 	setPan( pan ); // this checks the boundaries
@@ -96,11 +89,12 @@ Note::Note( Note* other, std::shared_ptr<Instrument> instrument )
 	  __pitch( other->get_pitch() ),
 	  __key( other->get_key() ),
 	  __octave( other->get_octave() ),
-	  __adsr( nullptr ),
+	  __adsr(),
 	  __lead_lag( other->get_lead_lag() ),
 	  __cut_off( other->get_cut_off() ),
 	  __resonance( other->get_resonance() ),
 	  __humanize_delay( other->get_humanize_delay() ),
+	  __layers_selected_count( other->__layers_selected_count ),
 	  __bpfb_l( other->get_bpfb_l() ),
 	  __bpfb_r( other->get_bpfb_r() ),
 	  __lpfb_l( other->get_lpfb_l() ),
@@ -111,21 +105,18 @@ Note::Note( Note* other, std::shared_ptr<Instrument> instrument )
 	  __just_recorded( other->get_just_recorded() ),
 	  __probability( other->get_probability() ),
 	  m_nNoteStart( other->getNoteStart() ),
+	  m_bFixedNoteStart( other->hasFixedNoteStart() ),
 	  m_fUsedTickSize( other->getUsedTickSize() )
 {
 	if ( instrument != nullptr ) __instrument = instrument;
 	if ( __instrument != nullptr ) {
-		__adsr = __instrument->copy_adsr();
+		__adsr = *__instrument->get_adsr();
 		__instrument_id = __instrument->get_id();
 	}
 
-	for ( const auto& mm : other->__layers_selected ) {
-		std::shared_ptr<SelectedLayerInfo> pSampleInfo = std::make_shared<SelectedLayerInfo>();
-		pSampleInfo->SelectedLayer = mm.second->SelectedLayer;
-		pSampleInfo->SamplePosition = mm.second->SamplePosition;
-		
-		__layers_selected[ mm.first ] = pSampleInfo;
-	}
+	std::copy( other->__layers_selected,
+			   other->__layers_selected + __layers_selected_count,
+			   __layers_selected );
 }
 
 Note::~Note()
@@ -151,6 +142,26 @@ void Note::setPan( float val ) {
 	m_fPan = check_boundary( val, -1.0f, 1.0f );
 }
 
+void Note::initInstrumentState()
+{
+	__adsr = *__instrument->get_adsr();
+	__instrument_id = __instrument->get_id();
+
+	__layers_selected_count = 0;
+	for ( const auto& pCompo : *__instrument->get_components() ) {
+		if ( __layers_selected_count >= MAX_COMPONENTS ) {
+			ERRORLOG( QString( "Instrument [%1] holds more than [%2] components" )
+					  .arg( __instrument->get_name() ).arg( MAX_COMPONENTS ) );
+			break;
+		}
+
+		auto& layerInfo = __layers_selected[ __layers_selected_count++ ];
+		layerInfo.ComponentID = pCompo->get_drumkit_componentID();
+		layerInfo.SelectedLayer = -1;
+		layerInfo.SamplePosition = 0;
+	}
+}
+
 void Note::map_instrument( InstrumentList* instruments )
 {
 	assert( instruments );
@@ -158,8 +169,10 @@ void Note::map_instrument( InstrumentList* instruments )
 	if( !instr ) {
 		ERRORLOG( QString( "Instrument with ID: '%1' not found. Using empty instrument." ).arg( __instrument_id ) );
 		__instrument = std::make_shared<Instrument>();
+		__layers_selected_count = 0;
 	} else {
 		__instrument = instr;
+		initInstrumentState();
 	}
 }
 
@@ -190,8 +203,8 @@ void Note::set_key_octave( const QString& str )
 bool Note::isPartiallyRendered() const {
 	bool bRes = false;
 
-	for ( auto ll : __layers_selected ) {
-		if ( ll.second->SamplePosition > 0 ) {
+	for ( int ii = 0; ii < __layers_selected_count; ++ii ) {
+		if ( __layers_selected[ ii ].SamplePosition > 0 ) {
 			bRes = true;
 			break;
 		}
@@ -203,8 +216,9 @@ bool Note::isPartiallyRendered() const {
 void Note::computeNoteStart() {
 	// Notes not inserted via the audio engine but directly, using
 	// e.g. the GUI, will be insert at position 0 and don't require a
-	// specific start position.
-	if ( __position == 0 ) {
+	// specific start position. Realtime notes placed using their MIDI
+	// timestamp keep the start they were assigned.
+	if ( __position == 0 || m_bFixedNoteStart ) {
 		return;
 	}
 	
@@ -239,13 +253,6 @@ std::shared_ptr<Sample> Note::getSample( int nComponentID, int nSelectedLayer )
 		return nullptr;
 	}
 
-	auto pInstrCompo = __instrument->get_component( nComponentID );
-	if ( pInstrCompo == nullptr ) {
-		ERRORLOG( QString( "Unable to retrieve component [%1] of instrument [%2]" )
-				  .arg( nComponentID ).arg( __instrument->get_name() ) );
-		return nullptr;
-	}
-	
 	auto pSelectedLayer = get_layer_selected( nComponentID );
 	if ( pSelectedLayer == nullptr ) {
 		WARNINGLOG( QString( "No SelectedLayer for component ID [%1] of instrument [%2]" )
@@ -253,6 +260,24 @@ std::shared_ptr<Sample> Note::getSample( int nComponentID, int nSelectedLayer )
 		return nullptr;
 	}
 
+	// The entries in #__layers_selected are ordered like the
+	// components of the instrument. Only fall back to searching by ID
+	// in case the instrument was altered in the meantime.
+	std::shared_ptr<InstrumentComponent> pInstrCompo;
+	const auto pComponents = __instrument->get_components();
+	const int nSlot = pSelectedLayer - __layers_selected;
+	if ( nSlot < static_cast<int>( pComponents->size() ) &&
+		 ( *pComponents )[ nSlot ]->get_drumkit_componentID() == nComponentID ) {
+		pInstrCompo = ( *pComponents )[ nSlot ];
+	} else {
+		pInstrCompo = __instrument->get_component( nComponentID );
+	}
+	if ( pInstrCompo == nullptr ) {
+		ERRORLOG( QString( "Unable to retrieve component [%1] of instrument [%2]" )
+				  .arg( nComponentID ).arg( __instrument->get_name() ) );
+		return nullptr;
+	}
+
 	if( pSelectedLayer->SelectedLayer != -1 ||
 		nSelectedLayer != -1 ) {
 		// This function was already called for this note and a
@@ -282,110 +307,51 @@ std::shared_ptr<Sample> Note::getSample( int nComponentID, int nSelectedLayer )
 			
 	} else {
 		// Select an instrument layer.
-		std::vector<int> possibleLayersVector;
-		float fRoundRobinID;
-		auto pSong = Hydrogen::get_instance()->getSong();
-		
-		for ( unsigned nLayer = 0; nLayer < InstrumentComponent::getMaxLayers(); ++nLayer ) {
-			auto pLayer = pInstrCompo->get_layer( nLayer );
-			if ( pLayer == nullptr ) {
-				continue;
-			}
-
-			if ( ( __velocity >= pLayer->get_start_velocity() ) &&
-				 ( __velocity <= pLayer->get_end_velocity() ) ) {
-
-				possibleLayersVector.push_back( nLayer );
-				if ( __instrument->sample_selection_alg() == Instrument::VELOCITY ) {
-					break;
-				} else if ( __instrument->sample_selection_alg() == Instrument::ROUND_ROBIN ) {
-					fRoundRobinID = pLayer->get_start_velocity();
-				}
-			}
+		LayerSelectionTable::Mode mode;
+		switch ( __instrument->sample_selection_alg() ) {
+		case Instrument::VELOCITY:
+			mode = LayerSelectionTable::Mode::Velocity;
+			break;
+		case Instrument::RANDOM:
+			mode = LayerSelectionTable::Mode::Random;
+			break;
+		case Instrument::ROUND_ROBIN:
+			mode = LayerSelectionTable::Mode::RoundRobin;
+			break;
+		default:
+			ERRORLOG( QString( "Unknown selection algorithm [%1] for instrument [%2]" )
+					  .arg( __instrument->sample_selection_alg() )
+					  .arg( __instrument->get_name() ) );
+			return nullptr;
 		}
 
 		// In some instruments the start and end velocities of a layer
 		// are not set perfectly giving rise to some 'holes'.
-		// Occasionally the velocity of a note can fall into it
-		// causing the sampler to just skip it. Instead, we will
-		// search for the nearest sample and play this one instead.
-		if ( possibleLayersVector.size() == 0 ){
+		// Occasionally the velocity of a note can fall into it. Instead
+		// of skipping it, the table provides the nearest sample.
+		bool bHole = false;
+		const int nLayerPicked = pInstrCompo->selectLayer( __velocity, mode, &bHole );
+		if ( nLayerPicked == -1 ) {
+			ERRORLOG( QString( "No sample found for component [%1] of instrument [%2]" )
+					  .arg( nComponentID ).arg( __instrument->get_name() ) );
+			return nullptr;
+		}
+		if ( bHole ) {
 			WARNINGLOG( QString( "Velocity [%1] did fall into a hole between the instrument layers for component [%2] of instrument [%3]." )
 						.arg( __velocity )
 						.arg( nComponentID )
 						.arg( __instrument->get_name() ) );
-			
-			float shortestDistance = 1.0f;
-			int nearestLayer = -1;
-			for ( unsigned nLayer = 0; nLayer < InstrumentComponent::getMaxLayers(); ++nLayer ){
-				auto pLayer = pInstrCompo->get_layer( nLayer );
-				if ( pLayer == nullptr ){
-					continue;
-				}
-							
-				if ( std::min( abs( pLayer->get_start_velocity() - __velocity ),
-							   abs( pLayer->get_start_velocity() - __velocity ) ) <
-					 shortestDistance ){
-					shortestDistance =
-						std::min( abs( pLayer->get_start_velocity() - __velocity ),
-								  abs( pLayer->get_start_velocity() - __velocity ) );
-					nearestLayer = nLayer;
-				}
-			}
-
-			// Check whether the search was successful and assign the results.
-			if ( nearestLayer > -1 ){
-				possibleLayersVector.push_back( nearestLayer );
-				if ( __instrument->sample_selection_alg() == Instrument::ROUND_ROBIN ) {
-					fRoundRobinID =
-						pInstrCompo->get_layer( nearestLayer )->get_start_velocity();
-				}
-			} else {
-				ERRORLOG( QString( "No sample found for component [%1] of instrument [%2]" )
-						  .arg( nComponentID ).arg( __instrument->get_name() ) );
-				return nullptr;
-			}
 		}
 
-		if( possibleLayersVector.size() > 0 ) {
-
-			int nLayerPicked;
-			switch ( __instrument->sample_selection_alg() ) {
-			case Instrument::VELOCITY: 
-				nLayerPicked = possibleLayersVector[ 0 ];
-				break;
-				
-			case Instrument::RANDOM:
-				nLayerPicked = possibleLayersVector[ rand() %
-													 possibleLayersVector.size() ];
-				break;
-
-			case Instrument::ROUND_ROBIN: {
-				fRoundRobinID = __instrument->get_id() * 10 + fRoundRobinID;
-				int nIndex = pSong->getLatestRoundRobin( fRoundRobinID ) + 1;
-				if ( nIndex >= possibleLayersVector.size() ) {
-					nIndex = 0;
-				}
-
-				pSong->setLatestRoundRobin( fRoundRobinID, nIndex );
-				nLayerPicked = possibleLayersVector[ nIndex ];
-				break;
-			}
-				
-			default:
-				ERRORLOG( QString( "Unknown selection algorithm [%1] for instrument [%2]" )
-						  .arg( __instrument->sample_selection_alg() )
-						  .arg( __instrument->get_name() ) );
-				return nullptr;
-			} 
-
-			pSelectedLayer->SelectedLayer = nLayerPicked;
-			auto pLayer = pInstrCompo->get_layer( nLayerPicked );
-			pSample = pLayer->get_sample();
-
-		} else {
-			ERRORLOG( "No samples found during random layer selection. This is a bug and shoul dn't happen!" );
+		auto pLayer = pInstrCompo->get_layer( nLayerPicked );
+		if ( pLayer == nullptr ) {
+			ERRORLOG( QString( "Layer selection of component [%1] of instrument [%2] is outdated" )
+					  .arg( nComponentID ).arg( __instrument->get_name() ) );
+			return nullptr;
 		}
+
+		pSelectedLayer->SelectedLayer = nLayerPicked;
+		pSample = pLayer->get_sample();
 	}
 
 	return pSample;
@@ -436,6 +402,41 @@ Note* Note::load_from( XMLNode* node, InstrumentList* instruments )
 	return note;
 }
 
+Note* Note::load_from( XMLStreamReader* pReader, InstrumentList* instruments )
+{
+	pReader->read_properties();
+
+	bool bFound, bFound2;
+	float fPan = pReader->read_float( "pan", 0.f, &bFound );
+	if ( !bFound ) {
+		// check if pan is expressed in the old fashion (version <= 1.1 ) with the pair (pan_L, pan_R)
+		float fPanL = pReader->read_float( "pan_L", 1.f, &bFound );
+		float fPanR = pReader->read_float( "pan_R", 1.f, &bFound2 );
+		if ( bFound == true && bFound2 == true ) { // found nodes pan_L and pan_R
+			fPan = Sampler::getRatioPan( fPanL, fPanR );  // convert to single pan parameter
+		}
+	}
+
+	Note* note = new Note(
+		nullptr,
+		pReader->read_int( "position", 0 ),
+		pReader->read_float( "velocity", 0.8f ),
+		fPan,
+		pReader->read_int( "length", -1 ),
+		pReader->read_float( "pitch", 0.0f )
+	);
+	note->set_lead_lag( pReader->read_float( "leadlag", 0 ) );
+	note->set_key_octave( pReader->read_string( "key", "C0" ) );
+	note->set_note_off( pReader->read_bool( "note_off", false ) );
+	note->set_instrument_id( pReader->read_int( "instrument", EMPTY_INSTR_ID ) );
+	if ( instruments != nullptr ) {
+		note->map_instrument( instruments );
+	}
+	note->set_probability( pReader->read_float( "probability", 1.0f ) );
+
+	return note;
+}
+
 QString Note::toQString( const QString& sPrefix, bool bShort ) const {
 	QString s = Base::sPrintIndention;
 	QString sOutput;
@@ -452,12 +453,8 @@ QString Note::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( "%1%2pitch: %3\n" ).arg( sPrefix ).arg( s ).arg( __pitch ) )
 			.append( QString( "%1%2key: %3\n" ).arg( sPrefix ).arg( s ).arg( __key ) )
 			.append( QString( "%1%2octave: %3\n" ).arg( sPrefix ).arg( s ).arg( __octave ) );
-		if ( __adsr != nullptr ) {
-			sOutput.append( QString( "%1" )
-							.arg( __adsr->toQString( sPrefix + s, bShort ) ) );
-		} else {
-			sOutput.append( QString( "%1%2adsr: nullptr\n" ).arg( sPrefix ).arg( s ) );
-		}
+		sOutput.append( QString( "%1" )
+						.arg( __adsr.toQString( sPrefix + s, bShort ) ) );
 
 		sOutput.append( QString( "%1%2lead_lag: %3\n" ).arg( sPrefix ).arg( s ).arg( __lead_lag ) )
 			.append( QString( "%1%2cut_off: %3\n" ).arg( sPrefix ).arg( s ).arg( __cut_off ) )
@@ -476,12 +473,13 @@ QString Note::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( "%1" ).arg( __instrument->toQString( sPrefix + s, bShort ) ) );
 		sOutput.append( QString( "%1%2layers_selected:\n" )
 						.arg( sPrefix ).arg( s ) );
-		for ( auto ll : __layers_selected ) {
+		for ( int ii = 0; ii < __layers_selected_count; ++ii ) {
+			const auto& layerInfo = __layers_selected[ ii ];
 			sOutput.append( QString( "%1%2[component: %3, selected layer: %4, sample position: %5]\n" )
 							.arg( sPrefix ).arg( s + s )
-							.arg( ll.first )
-							.arg( ll.second->SelectedLayer )
-							.arg( ll.second->SamplePosition ) );
+							.arg( layerInfo.ComponentID )
+							.arg( layerInfo.SelectedLayer )
+							.arg( layerInfo.SamplePosition ) );
 		}
 	} else {
 
@@ -497,13 +495,9 @@ QString Note::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( ", pitch: %1" ).arg( __pitch ) )
 			.append( QString( ", key: %1" ).arg( __key ) )
 			.append( QString( ", octave: %1" ).arg( __octave ) );
-		if ( __adsr != nullptr ) {
-			sOutput.append( QString( ", [%1" )
-							.arg( __adsr->toQString( sPrefix + s, bShort )
-								  .replace( "\n", "]" ) ) );
-		} else {
-			sOutput.append( ", adsr: nullptr" );
-		}
+		sOutput.append( QString( ", [%1" )
+						.arg( __adsr.toQString( sPrefix + s, bShort )
+							  .replace( "\n", "]" ) ) );
 
 		sOutput.append( QString( ", lead_lag: %1" ).arg( __lead_lag ) )
 			.append( QString( ", cut_off: %1" ).arg( __cut_off ) )
@@ -521,11 +515,12 @@ QString Note::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( ", probability: %1" ).arg( __probability ) )
 			.append( QString( ", instrument: %1" ).arg( __instrument->get_name() ) )
 			.append( QString( ", layers_selected: " ) );
-		for ( auto ll : __layers_selected ) {
+		for ( int ii = 0; ii < __layers_selected_count; ++ii ) {
+			const auto& layerInfo = __layers_selected[ ii ];
 			sOutput.append( QString( "[component: %1, selected layer: %2, sample position: %3] " )
-							.arg( ll.first )
-							.arg( ll.second->SelectedLayer )
-							.arg( ll.second->SamplePosition ) );
+							.arg( layerInfo.ComponentID )
+							.arg( layerInfo.SelectedLayer )
+							.arg( layerInfo.SamplePosition ) );
 		}
 	}
 	return sOutput;
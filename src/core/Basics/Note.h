@@ -25,6 +25,7 @@
 
 #include <memory>
 
+#include <core/config.h>
 #include <core/Object.h>
 #include <core/Basics/Instrument.h>
 #include <core/Basics/Sample.h>
@@ -54,11 +55,14 @@ namespace H2Core
 {
 
 class XMLNode;
-class ADSR;
+class XMLStreamReader;
 class Instrument;
 class InstrumentList;
 
 struct SelectedLayerInfo {
+	/** Drumkit component ID (InstrumentComponent::get_drumkit_componentID())
+	 * this entry belongs to.*/
+	int ComponentID;
 	/** Selected layer during layer selection
 	 * 
 	 * If set to -1 (during creation), Sampler::renderNote() will
@@ -116,6 +120,16 @@ class Note : public H2Core::Object<Note>
 		 * \return a new Note instance
 		 */
 		static Note* load_from( XMLNode* node, InstrumentList* instruments );
+		/**
+		 * load a note from the \<note\> element @a pReader is
+		 * positioned at
+		 * \param pReader the XMLStreamReader to read from
+		 * \param instruments the current instrument list to search
+		 * instrument into. If nullptr, only the instrument id is set
+		 * and map_instrument() has to be called later on.
+		 * \return a new Note instance
+		 */
+		static Note* load_from( XMLStreamReader* pReader, InstrumentList* instruments );
 
 		/**
 		 * find the corresponding instrument and point to it, or an empty instrument
@@ -216,7 +230,13 @@ class Note : public H2Core::Object<Note>
 		/*
 		 * selected sample
 		 * */
-	std::shared_ptr<SelectedLayerInfo> get_layer_selected( int CompoID );
+	/** \return Layer selection and playback position of the
+	 * component @a CompoID or nullptr if the note does not hold
+	 * one. Contrary to a map lookup this never allocates and can be
+	 * used within the audio thread.*/
+	SelectedLayerInfo* get_layer_selected( int CompoID );
+	/** Number of components stored in #__layers_selected.*/
+	int get_layer_selected_count() const;
 
 
 		void set_probability( float value );
@@ -287,7 +307,7 @@ class Note : public H2Core::Object<Note>
 		void set_midi_info( Key key, Octave octave, int msg );
 
 		/** get the ADSR of the note */
-		std::shared_ptr<ADSR> get_adsr() const;
+		ADSR* get_adsr();
 		/** call release on adsr */
 		//float release_adsr() const              { return __adsr->release(); }
 		/** call get value on adsr */
@@ -311,6 +331,15 @@ class Note : public H2Core::Object<Note>
 		void compute_lr_values( float* val_l, float* val_r );
 
 	long long getNoteStart() const;
+	/**
+	 * Sets #m_nNoteStart of a realtime note directly.
+	 *
+	 * The value is kept regardless of the position of the note.
+	 * computeNoteStart() does not alter it anymore.
+	 */
+	void setNoteStart( long long nNoteStart );
+	/** \return #m_bFixedNoteStart */
+	bool hasFixedNoteStart() const;
 	float getUsedTickSize() const;
 
 	/** 
@@ -378,6 +407,10 @@ class Note : public H2Core::Object<Note>
 	std::shared_ptr<Sample> getSample( int nComponentID, int nSelectedLayer = -1 );
 
 	private:
+		/** Copies the ADSR and ID of #__instrument and creates one
+		 * entry in #__layers_selected per component.*/
+		void initInstrumentState();
+
 		std::shared_ptr<Instrument>		__instrument;   ///< the instrument to be played by this note
 		int				__instrument_id;        ///< the id of the instrument played by this note
 		int				__specific_compo_id;    ///< play a specific component, -1 if playing all
@@ -396,7 +429,7 @@ class Note : public H2Core::Object<Note>
 		float			__pitch;              ///< the frequency of the note
 		Key				__key;                  ///< the key, [0;11]==[C;B]
 		Octave			 __octave;            ///< the octave [-3;3]
-		std::shared_ptr<ADSR>			__adsr;               ///< attack decay sustain release
+		ADSR			__adsr;               ///< attack decay sustain release
 		float			__lead_lag;           ///< lead or lag offset of the note
 		float			__cut_off;            ///< filter cutoff [0;1]
 		float			__resonance;          ///< filter resonant
@@ -411,7 +444,11 @@ class Note : public H2Core::Object<Note>
 		 * It is incorporated in the #m_nNoteStart.
 		 */
 		int				__humanize_delay;
-	std::map< int, std::shared_ptr<SelectedLayerInfo>> __layers_selected;
+	/** Per-component layer selection and sample position stored
+	 * inline in the order of the components of #__instrument. Only
+	 * the first #__layers_selected_count entries are valid.*/
+	SelectedLayerInfo __layers_selected[ MAX_COMPONENTS ];
+	int __layers_selected_count;
 		float			__bpfb_l;             ///< left band pass filter buffer
 		float			__bpfb_r;             ///< right band pass filter buffer
 		float			__lpfb_l;             ///< left low pass filter buffer
@@ -430,6 +467,9 @@ class Note : public H2Core::Object<Note>
 	 * during processing and not written to disk.
 	*/
 	long long m_nNoteStart;
+	/** Whether #m_nNoteStart was set using setNoteStart() and must
+	 * not be derived from #__position anymore.*/
+	bool m_bFixedNoteStart;
 	/**
 	 * TransportInfo::m_fTickSize used to calculate #m_nNoteStart.
 	 *
@@ -448,9 +488,9 @@ class Note : public H2Core::Object<Note>
 
 // DEFINITIONS
 
-inline std::shared_ptr<ADSR> Note::get_adsr() const
+inline ADSR* Note::get_adsr()
 {
-	return __adsr;
+	return &__adsr;
 }
 
 inline std::shared_ptr<Instrument> Note::get_instrument()
@@ -573,9 +613,19 @@ inline void Note::set_probability( float value )
 	__probability = value;
 }
 
-inline std::shared_ptr<SelectedLayerInfo> Note::get_layer_selected( int CompoID )
+inline SelectedLayerInfo* Note::get_layer_selected( int CompoID )
 {
-	return __layers_selected[ CompoID ];
+	for ( int ii = 0; ii < __layers_selected_count; ++ii ) {
+		if ( __layers_selected[ ii ].ComponentID == CompoID ) {
+			return &__layers_selected[ ii ];
+		}
+	}
+	return nullptr;
+}
+
+inline int Note::get_layer_selected_count() const
+{
+	return __layers_selected_count;
 }
 
 inline void Note::set_humanize_delay( int value )
@@ -703,6 +753,13 @@ inline void Note::compute_lr_values( float* val_l, float* val_r )
 inline long long Note::getNoteStart() const {
 	return m_nNoteStart;
 }
+inline void Note::setNoteStart( long long nNoteStart ) {
+	m_nNoteStart = nNoteStart;
+	m_bFixedNoteStart = true;
+}
+inline bool Note::hasFixedNoteStart() const {
+	return m_bFixedNoteStart;
+}
 inline float Note::getUsedTickSize() const {
 	return m_fUsedTickSize;
 }
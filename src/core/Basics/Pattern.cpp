@@ -23,6 +23,7 @@
 #include <core/Basics/Pattern.h>
 
 #include <cassert>
+#include <QtCore/QLocale>
 
 #include <core/Basics/Note.h>
 #include <core/Basics/PatternList.h>
@@ -36,6 +37,8 @@
 namespace H2Core
 {
 
+std::atomic<int> Pattern::__notes_revision( 0 );
+
 Pattern::Pattern( const QString& name, const QString& info, const QString& category, int length, int denominator )
 	: __length( length )
 	, __denominator( denominator)
@@ -55,6 +58,9 @@ Pattern::Pattern( Pattern* other )
 	FOREACH_NOTE_CST_IT_BEGIN_END( other->get_notes(),it ) {
 		__notes.insert( std::make_pair( it->first, new Note( it->second ) ) );
 	}
+	if ( __notes.size() > 0 ) {
+		++__notes_revision;
+	}
 }
 
 Pattern::~Pattern()
@@ -62,27 +68,34 @@ Pattern::~Pattern()
 	for( notes_cst_it_t it=__notes.begin(); it!=__notes.end(); it++ ) {
 		delete it->second;
 	}
+	if ( __notes.size() > 0 ) {
+		++__notes_revision;
+	}
 }
 
 Pattern* Pattern::load_file( const QString& pattern_path, InstrumentList* instruments )
 {
 	INFOLOG( QString( "Load pattern %1" ).arg( pattern_path ) );
 	if ( !Filesystem::file_readable( pattern_path ) ) return nullptr;
-	XMLDoc doc;
-	if( !doc.read( pattern_path, Filesystem::pattern_xsd_path() ) ) {
+	if( !XMLDoc::validate( pattern_path, Filesystem::pattern_xsd_path() ) ) {
 		return Legacy::load_drumkit_pattern( pattern_path, instruments );
 	}
-	XMLNode root = doc.firstChildElement( "drumkit_pattern" );
-	if ( root.isNull() ) {
-		ERRORLOG( "drumkit_pattern node not found" );
+	XMLStreamReader reader;
+	if ( !reader.open( pattern_path ) ) {
 		return nullptr;
 	}
-	XMLNode pattern_node = root.firstChildElement( "pattern" );
-	if ( pattern_node.isNull() ) {
-		ERRORLOG( "pattern node not found" );
+	if ( !reader.readNextStartElement() || reader.name() != "drumkit_pattern" ) {
+		ERRORLOG( "drumkit_pattern node not found" );
 		return nullptr;
 	}
-	return load_from( &pattern_node, instruments );
+	while ( reader.readNextStartElement() ) {
+		if ( reader.name() == "pattern" ) {
+			return load_from( &reader, instruments );
+		}
+		reader.skipCurrentElement();
+	}
+	ERRORLOG( "pattern node not found" );
+	return nullptr;
 }
 
 Pattern* Pattern::load_from( XMLNode* node, InstrumentList* instruments )
@@ -112,6 +125,50 @@ Pattern* Pattern::load_from( XMLNode* node, InstrumentList* instruments )
 	return pattern;
 }
 
+Pattern* Pattern::load_from( XMLStreamReader* pReader, InstrumentList* instruments )
+{
+	Pattern* pattern = new Pattern( nullptr, "", "unknown", -1, 4 );
+	QString sLegacyName;
+
+	while ( pReader->readNextStartElement() ) {
+		const QStringRef name = pReader->name();
+		if ( name == "noteList" ) {
+			while ( pReader->readNextStartElement() ) {
+				if ( pReader->name() != "note" ) {
+					pReader->skipCurrentElement();
+					continue;
+				}
+				pattern->insert_note( Note::load_from( pReader, instruments ) );
+			}
+			continue;
+		}
+
+		const QString sProperty = name.toString();
+		const QString sValue = pReader->readElementText( QXmlStreamReader::SkipChildElements );
+		if ( sValue.isEmpty() ) {
+			continue;
+		}
+		if ( sProperty == "name" ) {
+			pattern->set_name( sValue );
+		} else if ( sProperty == "pattern_name" ) {
+			sLegacyName = sValue;
+		} else if ( sProperty == "info" ) {
+			pattern->set_info( sValue );
+		} else if ( sProperty == "category" ) {
+			pattern->set_category( sValue );
+		} else if ( sProperty == "size" ) {
+			pattern->set_length( QLocale::c().toInt( sValue ) );
+		} else if ( sProperty == "denominator" ) {
+			pattern->set_denominator( QLocale::c().toInt( sValue ) );
+		}
+	}
+	// FIXME support legacy xml element pattern_name, should once be removed
+	if ( pattern->get_name().isEmpty() ) {
+		pattern->set_name( sLegacyName.isEmpty() ? "unknown" : sLegacyName );
+	}
+	return pattern;
+}
+
 bool Pattern::save_file( const QString& drumkit_name, const QString& author, const QString& license, const QString& pattern_path, bool overwrite ) const
 {
 	INFOLOG( QString( "Saving pattern into %1" ).arg( pattern_path ) );
@@ -205,6 +262,7 @@ void Pattern::remove_note( Note* note )
 	for( notes_it_t it=__notes.lower_bound( pos ); it!=__notes.end() && it->first == pos; ++it ) {
 		if( it->second==note ) {
 			__notes.erase( it );
+			++__notes_revision;
 			break;
 		}
 	}
@@ -236,6 +294,7 @@ void Pattern::purge_instrument( std::shared_ptr<Instrument> instr, bool bRequire
 			}
 			slate.push_back( note );
 			__notes.erase( it++ );
+			++__notes_revision;
 		} else {
 			++it;
 		}
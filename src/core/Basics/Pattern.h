@@ -23,6 +23,7 @@
 #ifndef H2C_PATTERN_H
 #define H2C_PATTERN_H
 
+#include <atomic>
 #include <set>
 #include <memory>
 #include <core/Object.h>
@@ -32,6 +33,7 @@ namespace H2Core
 {
 
 class XMLNode;
+class XMLStreamReader;
 class Instrument;
 class InstrumentList;
 class PatternList;
@@ -109,6 +111,13 @@ class Pattern : public H2Core::Object<Pattern>
 		int get_denominator() const;
 		///< get the note multimap
 		const notes_t* get_notes() const;
+		/**
+		 * Revision of the notes of all patterns. It is incremented
+		 * whenever a note is inserted into or removed from any
+		 * pattern and used by the #AudioEngine to detect edits of the
+		 * patterns it plays back.
+		 */
+		static int get_notes_revision();
 		///< get the virtual pattern set
 		const virtual_patterns_t* get_virtual_patterns() const;
 		///< get the flattened virtual pattern set
@@ -222,6 +231,7 @@ class Pattern : public H2Core::Object<Pattern>
 		notes_t __notes;                                        ///< a multimap (hash with possible multiple values for one key) of note
 		virtual_patterns_t __virtual_patterns;                  ///< a list of patterns directly referenced by this one
 		virtual_patterns_t __flattened_virtual_patterns;        ///< the complete list of virtual patterns
+		static std::atomic<int> __notes_revision;               ///< see get_notes_revision()
 		/**
 		 * load a pattern from an XMLNode
 		 * \param node the XMLDode to read from
@@ -229,6 +239,14 @@ class Pattern : public H2Core::Object<Pattern>
 		 * \return a new Pattern instance
 		 */
 		static Pattern* load_from( XMLNode* node, InstrumentList* instruments );
+		/**
+		 * load a pattern from the \<pattern\> element @a pReader is
+		 * positioned at
+		 * \param pReader the XMLStreamReader to read from
+		 * \param instruments the current instrument list to search instrument into
+		 * \return a new Pattern instance
+		 */
+		static Pattern* load_from( XMLStreamReader* pReader, InstrumentList* instruments );
 };
 
 #define FOREACH_NOTE_CST_IT_BEGIN_END(_notes,_it) \
@@ -300,6 +318,11 @@ inline const Pattern::notes_t* Pattern::get_notes() const
 	return &__notes;
 }
 
+inline int Pattern::get_notes_revision()
+{
+	return __notes_revision.load();
+}
+
 inline const Pattern::virtual_patterns_t* Pattern::get_virtual_patterns() const
 {
 	return &__virtual_patterns;
@@ -313,6 +336,7 @@ inline const Pattern::virtual_patterns_t* Pattern::get_flattened_virtual_pattern
 inline void Pattern::insert_note( Note* note )
 {
 	__notes.insert( std::make_pair( note->get_position(), note ) );
+	++__notes_revision;
 }
 
 inline bool Pattern::virtual_patterns_empty() const
@@ -23,6 +23,7 @@
 #include <core/Preferences/Preferences.h>
 #include <core/Hydrogen.h>
 #include <core/Basics/Playlist.h>
+#include <core/Basics/Song.h>
 #include <core/Helpers/Filesystem.h>
 #include <core/Helpers/Legacy.h>
 #include <core/Helpers/Xml.h>
@@ -39,6 +40,7 @@ Playlist::Playlist()
 	m_nSelectedSongNumber = -1;
 	m_nActiveSongNumber = -1;
 	m_bIsModified = false;
+	m_nPrefetchedSongNumber = -1;
 }
 
 Playlist::~Playlist()
@@ -176,6 +178,64 @@ void Playlist::activateSong( int songNumber )
 	setActiveSongNumber( songNumber );
 
 	execScript( songNumber );
+
+	if ( songNumber + 1 < size() ) {
+		prefetchSong( songNumber + 1 );
+	}
+}
+
+void Playlist::prefetchSong( int nSongNumber )
+{
+	QString sFilename;
+	if ( nSongNumber < 0 || ! getSongFilenameByNumber( nSongNumber, sFilename ) ||
+		 ! get( nSongNumber )->fileExists ) {
+		return;
+	}
+
+	if ( m_prefetchedSong.valid() && nSongNumber == m_nPrefetchedSongNumber &&
+		 sFilename == m_sPrefetchedFilename ) {
+		// Already in progress.
+		return;
+	}
+
+	// The global settings, like the LADSPA effects, must not be
+	// touched till the song is actually used.
+	auto pReader = std::make_shared<SongReader>();
+	pReader->setDeferGlobalSettings( true );
+
+	m_pPrefetchReader = pReader;
+	m_nPrefetchedSongNumber = nSongNumber;
+	m_sPrefetchedFilename = sFilename;
+	m_prefetchTime = QDateTime::currentDateTime();
+	m_prefetchedSong = std::async( std::launch::async, [pReader, sFilename]() {
+		return pReader->readSong( sFilename );
+	} );
+
+	INFOLOG( QString( "Prefetching [%1]" ).arg( sFilename ) );
+}
+
+std::shared_ptr<Song> Playlist::getPrefetchedSong( int nSongNumber )
+{
+	QString sFilename;
+	if ( ! m_prefetchedSong.valid() || nSongNumber != m_nPrefetchedSongNumber ||
+		 ! getSongFilenameByNumber( nSongNumber, sFilename ) ||
+		 sFilename != m_sPrefetchedFilename ) {
+		return nullptr;
+	}
+
+	auto pSong = m_prefetchedSong.get();
+	auto pReader = m_pPrefetchReader;
+	m_pPrefetchReader = nullptr;
+	m_nPrefetchedSongNumber = -1;
+
+	if ( pSong == nullptr ||
+		 QFileInfo( sFilename ).lastModified() > m_prefetchTime ) {
+		return nullptr;
+	}
+
+	pReader->applyGlobalSettings();
+
+	return pSong;
 }
 
 bool Playlist::getSongFilenameByNumber( int songNumber, QString& filename)
@@ -25,9 +25,17 @@
 
 #include <core/Object.h>
 
+#include <QDateTime>
+
+#include <future>
+#include <memory>
+
 namespace H2Core
 {
 
+class Song;
+class SongReader;
+
 /**
  * Drumkit info
 */
@@ -61,8 +69,35 @@ class Playlist : public H2Core::Object<Playlist>
 
 		~Playlist();
 
+		/**
+		 * Marks @a SongNumber as the current song, runs its script,
+		 * and starts prefetching the next entry of the playlist.
+		 */
 		void	activateSong (int SongNumber );
 
+		/**
+		 * Loads the song of entry @a nSongNumber including all its
+		 * samples in a background thread.
+		 *
+		 * Only a single song is prefetched at a time. Calling this
+		 * function while another song is still loading blocks till
+		 * the latter is done.
+		 */
+		void	prefetchSong( int nSongNumber );
+		/**
+		 * Hands over the song prefetched using prefetchSong() and
+		 * applies its global settings, like the LADSPA effects.
+		 *
+		 * Waits for the prefetch to finish in case it is still
+		 * running.
+		 *
+		 * \return nullptr in case @a nSongNumber was not prefetched,
+		 * loading it failed, or the file was changed in the
+		 * meantime. The caller has to load the song itself in this
+		 * case.
+		 */
+		std::shared_ptr<Song> getPrefetchedSong( int nSongNumber );
+
 		int		size() const;
 		Entry*	get( int idx );
 
@@ -112,6 +147,14 @@ class Playlist : public H2Core::Object<Playlist>
 
 		bool m_bIsModified;
 
+		/** Song loaded by prefetchSong().*/
+		std::future<std::shared_ptr<Song>> m_prefetchedSong;
+		/** Holds the global settings of the prefetched song.*/
+		std::shared_ptr<SongReader> m_pPrefetchReader;
+		int m_nPrefetchedSongNumber;
+		QString m_sPrefetchedFilename;
+		QDateTime m_prefetchTime;
+
 		Playlist();
 
 		void execScript( int index );
@@ -22,14 +22,30 @@
 
 
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <limits>
 #include <memory>
+#include <vector>
+
+#include <QCryptographicHash>
+#include <QDir>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include <core/Hydrogen.h>
 #include <core/Preferences/Preferences.h>
 #include <core/Helpers/Filesystem.h>
 #include <core/Basics/Sample.h>
 #include <core/Basics/Note.h>
+#include <core/Sampler/PolyphaseResampler.h>
+#include <core/Sampler/SamplePrefetcher.h>
 
 #if defined(H2CORE_HAVE_RUBBERBAND) || _DOXYGEN_
 #include <rubberband/RubberBandStretcher.h>
@@ -41,6 +57,7 @@ namespace H2Core
 {
 
 const std::vector<QString> Sample::__loop_modes = { "forward", "reverse", "pingpong" };
+std::atomic<int> Sample::m_nStreamedSamples( 0 );
 
 #if defined(H2CORE_HAVE_RUBBERBAND) || _DOXYGEN_
 static double compute_pitch_scale( const Sample::Rubberband& r );
@@ -69,7 +86,9 @@ Sample::Sample( const QString& filepath,  int frames, int sample_rate, float* da
 	__sample_rate( sample_rate ),
 	__data_l( data_l ),
 	__data_r( data_r ),
-	__is_modified( false )
+	__is_modified( false ),
+	m_pMapping( nullptr ),
+	m_nMappingSize( 0 )
 {
 	assert( filepath.lastIndexOf( "/" ) >0 );
 }
@@ -82,7 +101,9 @@ Sample::Sample( std::shared_ptr<Sample> pOther ): Object( *pOther ),
 	__data_r( nullptr ),
 	__is_modified( pOther->get_is_modified() ),
 	__loops( pOther->__loops ),
-	__rubberband( pOther->__rubberband )
+	__rubberband( pOther->__rubberband ),
+	m_pMapping( nullptr ),
+	m_nMappingSize( 0 )
 {
 
 	__data_l = new float[__frames];
@@ -108,12 +129,25 @@ Sample::Sample( std::shared_ptr<Sample> pOther ): Object( *pOther ),
 
 Sample::~Sample()
 {
-	if ( __data_l != nullptr ) {
-		delete[] __data_l;
-	}
-	if ( __data_r != nullptr ) {
-		delete[] __data_r;
+	freeData();
+}
+
+void Sample::freeData()
+{
+#ifndef WIN32
+	if ( m_pMapping != nullptr ) {
+		munmap( m_pMapping, m_nMappingSize );
+		--m_nStreamedSamples;
+		m_pMapping = nullptr;
+		m_nMappingSize = 0;
+		__data_l = __data_r = nullptr;
+		return;
 	}
+#endif
+
+	delete[] __data_l;
+	delete[] __data_r;
+	__data_l = __data_r = nullptr;
 }
 
 void Sample::set_filename( const QString& filename )
@@ -143,6 +177,21 @@ std::shared_ptr<Sample> Sample::load( const QString& sFilepath )
 	return pSample;
 }
 
+std::shared_ptr<Sample> Sample::loadConverted( const QString& sFilepath, int nSampleRate )
+{
+	if( !Filesystem::file_readable( sFilepath ) ) {
+		ERRORLOG( QString( "Unable to read %1" ).arg( sFilepath ) );
+		return nullptr;
+	}
+
+	auto pSample = std::make_shared<Sample>( sFilepath );
+	if( !pSample->decode( nSampleRate, true ) ) {
+		return nullptr;
+	}
+
+	return pSample;
+}
+
 std::shared_ptr<Sample> Sample::load( const QString& filepath, const Loops& loops, const Rubberband& rubber, const VelocityEnvelope& velocity, const PanEnvelope& pan, float fBpm )
 {
 	auto pSample = Sample::load( filepath );
@@ -166,7 +215,102 @@ void Sample::apply( const Loops& loops, const Rubberband& rubber, const Velocity
 #endif
 }
 
+/** Reads @a nFrames frames of @a file in chunks and splits them into
+ * @a pData_L and @a pData_R. Mono files are copied into both
+ * channels and channels beyond #SAMPLE_CHANNELS are dropped. Frames
+ * missing in @a file are set to zero.
+ *
+ * \return Number of frames read.*/
+static sf_count_t read_frames( SNDFILE* file, int nChannels, float* pData_L,
+							   float* pData_R, sf_count_t nFrames )
+{
+	const sf_count_t nChunkFrames = 65536;
+	std::vector<float> buffer( nChunkFrames * nChannels );
+
+	sf_count_t nRead = 0;
+	while ( nRead < nFrames ) {
+		const sf_count_t nCount =
+			sf_readf_float( file, buffer.data(),
+							std::min( nChunkFrames, nFrames - nRead ) );
+		if ( nCount <= 0 ) {
+			break;
+		}
+
+		for ( sf_count_t ii = 0; ii < nCount; ++ii ) {
+			pData_L[ nRead + ii ] = buffer[ ii * nChannels ];
+			pData_R[ nRead + ii ] = buffer[ ii * nChannels + ( nChannels > 1 ? 1 : 0 ) ];
+		}
+		nRead += nCount;
+	}
+
+	if ( nRead < nFrames ) {
+		memset( pData_L + nRead, 0, ( nFrames - nRead ) * sizeof( float ) );
+		memset( pData_R + nRead, 0, ( nFrames - nRead ) * sizeof( float ) );
+	}
+
+	return nRead;
+}
+
+/** Same as read_frames() but converts the content of @a file using
+ * @a pResampler.
+ *
+ * \return Number of frames written.*/
+static sf_count_t read_frames_resampled( SNDFILE* file, int nChannels,
+										 PolyphaseResampler* pResampler,
+										 float* pData_L, float* pData_R,
+										 sf_count_t nFrames )
+{
+	const sf_count_t nChunkFrames = 65536;
+	std::vector<float> buffer( nChunkFrames * nChannels );
+	std::vector<float> chunk_L( nChunkFrames );
+	std::vector<float> chunk_R( nChunkFrames );
+
+	sf_count_t nWritten = 0;
+	while ( nWritten < nFrames ) {
+		const sf_count_t nCount = sf_readf_float( file, buffer.data(), nChunkFrames );
+		if ( nCount <= 0 ) {
+			break;
+		}
+
+		for ( sf_count_t ii = 0; ii < nCount; ++ii ) {
+			chunk_L[ ii ] = buffer[ ii * nChannels ];
+			chunk_R[ ii ] = buffer[ ii * nChannels + ( nChannels > 1 ? 1 : 0 ) ];
+		}
+		nWritten += pResampler->process( chunk_L.data(), chunk_R.data(), nCount,
+										 pData_L + nWritten, pData_R + nWritten,
+										 static_cast<int>( nFrames - nWritten ) );
+	}
+	if ( nWritten < nFrames ) {
+		nWritten += pResampler->flush( pData_L + nWritten, pData_R + nWritten,
+									   static_cast<int>( nFrames - nWritten ) );
+	}
+
+	if ( nWritten < nFrames ) {
+		memset( pData_L + nWritten, 0, ( nFrames - nWritten ) * sizeof( float ) );
+		memset( pData_R + nWritten, 0, ( nFrames - nWritten ) * sizeof( float ) );
+	}
+
+	return nWritten;
+}
+
+/** Calls read_frames_resampled() if @a pResampler is set and
+ * read_frames() otherwise.*/
+static sf_count_t decode_frames( SNDFILE* file, int nChannels,
+								 PolyphaseResampler* pResampler,
+								 float* pData_L, float* pData_R, sf_count_t nFrames )
+{
+	if ( pResampler != nullptr ) {
+		return read_frames_resampled( file, nChannels, pResampler, pData_L, pData_R, nFrames );
+	}
+	return read_frames( file, nChannels, pData_L, pData_R, nFrames );
+}
+
 bool Sample::load()
+{
+	return decode( 0, false );
+}
+
+bool Sample::decode( int nSampleRate, bool bStream )
 {
 	// Will contain a bunch of metadata about the loaded sample.
 	SF_INFO sound_info = {0};
@@ -182,33 +326,12 @@ bool Sample::load()
 	// core/include/hydrogen/globals.h and set to 2.
 	if ( sound_info.channels > SAMPLE_CHANNELS ) {
 		WARNINGLOG( QString( "can't handle %1 channels, only 2 will be used" ).arg( sound_info.channels ) );
-		sound_info.channels = SAMPLE_CHANNELS;
 	}
-	if ( sound_info.frames > ( std::numeric_limits<int>::max()/sound_info.channels ) ) {
-		WARNINGLOG( QString( "sample frames count (%1) and channels (%2) are too much, truncate it." ).arg( sound_info.frames ).arg( sound_info.channels ) );
-		sound_info.frames = ( std::numeric_limits<int>::max()/sound_info.channels );
+	if ( sound_info.frames > std::numeric_limits<int>::max() ) {
+		WARNINGLOG( QString( "sample frames count (%1) is too much, truncate it." ).arg( sound_info.frames ) );
+		sound_info.frames = std::numeric_limits<int>::max();
 	}
 
-	// Create an array, which will hold the block of samples read
-	// from file.
-	float* buffer = new float[ sound_info.frames * sound_info.channels ];
-	
-	//memset( buffer, 0, sound_info.frames *sound_info.channels );
-	
-	// Read all frames into `buffer'. Libsndfile does seamlessly
-	// convert the format of the underlying data on the fly. The
-	// output will be an array of floats regardless of file's
-	// encoding (e.g. 16 bit PCM).
-	sf_count_t count = sf_read_float( file, buffer, sound_info.frames * sound_info.channels );
-	if( count==0 ){
-		WARNINGLOG( QString( "%1 is an empty sample" ).arg( __filepath ) );
-	}
-	
-	// Deallocate the handler.
-	if ( sf_close( file ) != 0 ){
-		WARNINGLOG( QString( "Unable to close sample file %1" ).arg( __filepath ) );
-	}
-	
 	// Flush the current content of the left and right channel and
 	// the current metadata.
 	unload();
@@ -218,25 +341,262 @@ bool Sample::load()
 	__frames = sound_info.frames;
 	__sample_rate = sound_info.samplerate;
 
-	// Split the loaded frames into left and right channel. 
-	// If only one channels was present in the underlying data,
-	// duplicate its content.
-	__data_l = new float[ sound_info.frames ];
-	__data_r = new float[ sound_info.frames ];
-	if ( sound_info.channels == 1 ) {
-		memcpy( __data_l, buffer, __frames * sizeof( float ) );
-		memcpy( __data_r, buffer, __frames * sizeof( float ) );
-	} else if ( sound_info.channels == SAMPLE_CHANNELS ) {
-		for ( int i = 0; i < __frames; i++ ) {
-			__data_l[i] = buffer[i * SAMPLE_CHANNELS ];
-			__data_r[i] = buffer[i * SAMPLE_CHANNELS + 1 ];
+	std::unique_ptr<PolyphaseResampler> pResampler;
+	if ( nSampleRate > 0 && nSampleRate != sound_info.samplerate ) {
+		pResampler = std::make_unique<PolyphaseResampler>( sound_info.samplerate, nSampleRate );
+		long long nFrames = pResampler->getOutputFrames( sound_info.frames );
+		if ( nFrames > std::numeric_limits<int>::max() ) {
+			WARNINGLOG( QString( "sample frames count (%1) after conversion is too much, truncate it." )
+						.arg( nFrames ) );
+			nFrames = std::numeric_limits<int>::max();
+		}
+		__frames = nFrames;
+		__sample_rate = nSampleRate;
+	}
+
+	bool bLoaded = false;
+#ifndef WIN32
+	Preferences* pPref = Preferences::get_instance();
+	if ( pPref->m_bUseSampleStreaming || bStream ) {
+		const long long nPreloadFrames = static_cast<long long>(
+			pPref->m_nSampleStreamingPreloadMs ) * __sample_rate / 1000;
+		if ( __frames > nPreloadFrames || bStream ) {
+			bLoaded = loadStreamed( file, sound_info.channels, nPreloadFrames,
+									pResampler.get() );
 		}
 	}
-	delete[] buffer;
+#endif
+
+	if ( ! bLoaded ) {
+		// Read the frames directly into the left and right channel
+		// in chunks instead of keeping a second copy of the whole
+		// interleaved sample around. Libsndfile does seamlessly
+		// convert the format of the underlying data on the fly. The
+		// output will be an array of floats regardless of file's
+		// encoding (e.g. 16 bit PCM).
+		__data_l = new float[ __frames ];
+		__data_r = new float[ __frames ];
+		if ( decode_frames( file, sound_info.channels, pResampler.get(),
+							__data_l, __data_r, __frames ) == 0 ) {
+			WARNINGLOG( QString( "%1 is an empty sample" ).arg( __filepath ) );
+		}
+	}
+	
+	// Deallocate the handler.
+	if ( sf_close( file ) != 0 ){
+		WARNINGLOG( QString( "Unable to close sample file %1" ).arg( __filepath ) );
+	}
 
 	return true;
 }
 
+#ifndef WIN32
+/** Header of the files in Filesystem::sample_cache_dir(). It is
+ * followed by the left and the right channel, each starting at a
+ * page boundary.*/
+struct SampleCacheHeader {
+	char sMagic[ 8 ];
+	uint32_t nVersion;
+	int32_t nFrames;
+	int32_t nSampleRate;
+};
+static const char sSampleCacheMagic[ 8 ] = { 'H', '2', 'S', 'M', 'P', 'L', 0, 0 };
+static const uint32_t nSampleCacheVersion = 1;
+
+bool Sample::loadStreamed( SNDFILE* file, int nChannels, int nPreloadFrames,
+						   PolyphaseResampler* pResampler )
+{
+	const size_t nPageSize = static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+	const size_t nChannelSize = static_cast<size_t>( __frames ) * sizeof( float );
+	const size_t nOffset_L = nPageSize;
+	const size_t nOffset_R = nOffset_L +
+		( nChannelSize + nPageSize - 1 ) / nPageSize * nPageSize;
+	const size_t nMappingSize = nOffset_R + nChannelSize;
+
+	// The cache entry is identified by the path of the sample as well
+	// as its size and time of modification. This way altered files
+	// get a new entry instead of mapping outdated data.
+	struct stat sourceInfo;
+	if ( stat( __filepath.toLocal8Bit(), &sourceInfo ) != 0 ) {
+		return false;
+	}
+	QString sKey = QString( "%1|%2|%3" ).arg( QFileInfo( __filepath ).absoluteFilePath() )
+		.arg( static_cast<qlonglong>( sourceInfo.st_size ) )
+		.arg( static_cast<qlonglong>( sourceInfo.st_mtime ) );
+	if ( pResampler != nullptr ) {
+		// Each target sample rate gets an entry of its own.
+		sKey.append( QString( "|%1" ).arg( __sample_rate ) );
+	}
+	const QString sCachePath = Filesystem::sample_cache_dir() +
+		QCryptographicHash::hash( sKey.toUtf8(), QCryptographicHash::Sha1 ).toHex() +
+		".h2sample";
+
+	// Check for a valid cache entry.
+	int fd = open( sCachePath.toLocal8Bit(), O_RDONLY );
+	if ( fd >= 0 ) {
+		SampleCacheHeader header;
+		struct stat cacheInfo;
+		if ( fstat( fd, &cacheInfo ) != 0 ||
+			 static_cast<size_t>( cacheInfo.st_size ) != nMappingSize ||
+			 pread( fd, &header, sizeof( header ), 0 ) != static_cast<ssize_t>( sizeof( header ) ) ||
+			 memcmp( header.sMagic, sSampleCacheMagic, sizeof( sSampleCacheMagic ) ) != 0 ||
+			 header.nVersion != nSampleCacheVersion ||
+			 header.nFrames != __frames || header.nSampleRate != __sample_rate ) {
+			WARNINGLOG( QString( "Invalid sample cache entry [%1] for [%2]" )
+						.arg( sCachePath ).arg( __filepath ) );
+			close( fd );
+			fd = -1;
+		}
+		else {
+			// Mark the entry as recently used.
+			futimens( fd, nullptr );
+		}
+	}
+
+	bool bNewEntry = false;
+	if ( fd < 0 ) {
+		// Decode into a temporary file first and move it to its final
+		// location afterwards. This way no other instance - or other
+		// loader thread - will ever map an incomplete entry.
+		if ( ! Filesystem::path_usable( Filesystem::sample_cache_dir(), true, true ) ) {
+			ERRORLOG( QString( "Sample cache [%1] is not usable" )
+					  .arg( Filesystem::sample_cache_dir() ) );
+			return false;
+		}
+		QByteArray sTmpPath = ( sCachePath + ".XXXXXX" ).toLocal8Bit();
+		const int tmpFd = mkstemp( sTmpPath.data() );
+		if ( tmpFd < 0 ) {
+			ERRORLOG( QString( "Unable to create sample cache entry [%1]" ).arg( sCachePath ) );
+			return false;
+		}
+
+		// Reserve the space upfront. Writing to a mapping of a sparse
+		// file on a full disk would result in a SIGBUS.
+		void* pTmpMapping = MAP_FAILED;
+		if ( posix_fallocate( tmpFd, 0, nMappingSize ) == 0 ) {
+			pTmpMapping = mmap( nullptr, nMappingSize, PROT_READ | PROT_WRITE,
+								MAP_SHARED, tmpFd, 0 );
+		}
+		if ( pTmpMapping == MAP_FAILED ) {
+			ERRORLOG( QString( "Unable to write sample cache entry [%1]" ).arg( sCachePath ) );
+			close( tmpFd );
+			unlink( sTmpPath.constData() );
+			return false;
+		}
+
+		char* pData = static_cast<char*>( pTmpMapping );
+		if ( decode_frames( file, nChannels, pResampler,
+							reinterpret_cast<float*>( pData + nOffset_L ),
+							reinterpret_cast<float*>( pData + nOffset_R ), __frames ) == 0 ) {
+			WARNINGLOG( QString( "%1 is an empty sample" ).arg( __filepath ) );
+		}
+		SampleCacheHeader header;
+		memcpy( header.sMagic, sSampleCacheMagic, sizeof( sSampleCacheMagic ) );
+		header.nVersion = nSampleCacheVersion;
+		header.nFrames = __frames;
+		header.nSampleRate = __sample_rate;
+		memcpy( pData, &header, sizeof( header ) );
+
+		munmap( pTmpMapping, nMappingSize );
+		close( tmpFd );
+		if ( std::rename( sTmpPath.constData(), sCachePath.toLocal8Bit().constData() ) != 0 ) {
+			ERRORLOG( QString( "Unable to move sample cache entry [%1]" ).arg( sCachePath ) );
+			unlink( sTmpPath.constData() );
+			return false;
+		}
+
+		fd = open( sCachePath.toLocal8Bit(), O_RDONLY );
+		if ( fd < 0 ) {
+			return false;
+		}
+		bNewEntry = true;
+	}
+
+	// A private mapping allows the apply_*() functions to alter the
+	// sample in place without writing back to the cache.
+	void* pMapping = mmap( nullptr, nMappingSize, PROT_READ | PROT_WRITE,
+						   MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( pMapping == MAP_FAILED ) {
+		ERRORLOG( QString( "Unable to map sample cache entry [%1]" ).arg( sCachePath ) );
+		return false;
+	}
+
+	m_pMapping = pMapping;
+	m_nMappingSize = nMappingSize;
+	++m_nStreamedSamples;
+	__data_l = reinterpret_cast<float*>( static_cast<char*>( pMapping ) + nOffset_L );
+	__data_r = reinterpret_cast<float*>( static_cast<char*>( pMapping ) + nOffset_R );
+
+	if ( bNewEntry ) {
+		const qint64 nMaxBytes = static_cast<qint64>(
+			Preferences::get_instance()->m_nSampleCacheSizeMb ) * 1024 * 1024;
+		pruneSampleCache( nMaxBytes, sCachePath );
+	}
+
+	// Keep the beginning of both channels resident. Rendering starts
+	// from there and the SamplePrefetcher takes over afterwards. The
+	// preload covers whole chunks since the prefetcher requests no
+	// less than that.
+	static std::atomic<bool> bLockFailureReported( false );
+	const size_t nPreloadChunks =
+		( static_cast<size_t>( std::max( nPreloadFrames, 1 ) ) +
+		  SamplePrefetcher::nChunkFrames - 1 ) / SamplePrefetcher::nChunkFrames;
+	const size_t nPreloadSize =
+		std::min( nPreloadChunks * SamplePrefetcher::nChunkFrames * sizeof( float ),
+				  nChannelSize );
+	for ( float* pData : { __data_l, __data_r } ) {
+		if ( mlock( pData, nPreloadSize ) != 0 ) {
+			if ( ! bLockFailureReported.exchange( true ) ) {
+				WARNINGLOG( "Unable to lock streamed samples in memory. Consider raising RLIMIT_MEMLOCK." );
+			}
+			madvise( pData, nPreloadSize, MADV_WILLNEED );
+		}
+	}
+
+	return true;
+}
+#else
+bool Sample::loadStreamed( SNDFILE* file, int nChannels, int nPreloadFrames,
+						   PolyphaseResampler* pResampler )
+{
+	UNUSED( file );
+	UNUSED( nChannels );
+	UNUSED( nPreloadFrames );
+	UNUSED( pResampler );
+	return false;
+}
+#endif
+
+void Sample::pruneSampleCache( qint64 nMaxBytes, const QString& sKeep )
+{
+	QDir cacheDir( Filesystem::sample_cache_dir() );
+	// Sorted by the time of modification, most recent first.
+	const QFileInfoList entries =
+		cacheDir.entryInfoList( QStringList() << "*.h2sample", QDir::Files, QDir::Time );
+
+	const QString sKeepPath = QFileInfo( sKeep ).absoluteFilePath();
+	qint64 nTotalBytes = 0;
+	for ( const auto& entry : entries ) {
+		nTotalBytes += entry.size();
+	}
+
+	for ( int ii = entries.size() - 1; ii >= 0 && nTotalBytes > nMaxBytes; --ii ) {
+		const QFileInfo& entry = entries.at( ii );
+		if ( ! sKeep.isEmpty() && entry.absoluteFilePath() == sKeepPath ) {
+			continue;
+		}
+		INFOLOG( QString( "Removing sample cache entry [%1]" ).arg( entry.absoluteFilePath() ) );
+		if ( cacheDir.remove( entry.fileName() ) ) {
+			nTotalBytes -= entry.size();
+		}
+		else {
+			WARNINGLOG( QString( "Unable to remove sample cache entry [%1]" )
+						.arg( entry.absoluteFilePath() ) );
+		}
+	}
+}
+
 bool Sample::apply_loops( const Loops& lo )
 {
 	if( __loops == lo ) {
@@ -327,8 +687,7 @@ bool Sample::apply_loops( const Loops& lo )
 		assert( x==new_length );
 	}
 	__loops = lo;
-	delete[] __data_l;
-	delete[] __data_r;
+	freeData();
 	__data_l = new_data_l;
 	__data_r = new_data_r;
 	__frames = new_length;
@@ -570,8 +929,7 @@ void Sample::apply_rubberband( const Rubberband& rb, float fBpm ) {
 		retrieved += n;
 	}
 	
-	delete [] __data_l;
-	delete [] __data_r;
+	freeData();
 	__data_l = new float[ retrieved ];
 	__data_r = new float[ retrieved ];
 	memcpy( __data_l, out_data_l, retrieved*sizeof( float ) );
@@ -653,12 +1011,19 @@ bool Sample::exec_rubberband_cli( const Rubberband& rb, float fBpm )
 
 		QFile( rubberResultPath ).remove();
 
+		freeData();
 		__frames = p_Rubberbanded->get_frames();
 
+		// Take over the data - mapped or not - of the temporary
+		// sample.
 		__data_l = p_Rubberbanded->get_data_l();
 		__data_r = p_Rubberbanded->get_data_r();
+		m_pMapping = p_Rubberbanded->m_pMapping;
+		m_nMappingSize = p_Rubberbanded->m_nMappingSize;
 		p_Rubberbanded->__data_l = nullptr;
 		p_Rubberbanded->__data_r = nullptr;
+		p_Rubberbanded->m_pMapping = nullptr;
+		p_Rubberbanded->m_nMappingSize = 0;
 
 		__is_modified = true;
 		__rubberband = rb;
@@ -23,6 +23,7 @@
 #ifndef H2C_SAMPLE_H
 #define H2C_SAMPLE_H
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <sndfile.h>
@@ -32,6 +33,8 @@
 namespace H2Core
 {
 
+class PolyphaseResampler;
+
 /**
  * A container for a sample, being able to apply modifications on it
  */
@@ -185,6 +188,44 @@ class Sample : public H2Core::Object<Sample>
 		 * \overload load(const QString& filepath, const Loops& loops, const Rubberband& rubber, const VelocityEnvelope& velocity, const PanEnvelope& pan)
 		 */
 		static std::shared_ptr<Sample> load( const QString& filepath, const Loops& loops, const Rubberband& rubber, const VelocityEnvelope& velocity, const PanEnvelope& pan, float fBpm );
+		/**
+		 * Loads @a sFilepath converted to @a nSampleRate.
+		 *
+		 * Instead of being interpolated on the fly while
+		 * rendering, the content is converted once using a
+		 * #PolyphaseResampler. Where supported the result is
+		 * streamed (see isStreamed()) regardless of
+		 * Preferences::m_bUseSampleStreaming. The converted
+		 * content is kept in the sample cache and reused the
+		 * next time the same file is requested at the same
+		 * rate.
+		 *
+		 * Intended for long files played back as a whole, like
+		 * the playback track.
+		 *
+		 * \return Pointer to the newly loaded Sample. If
+		 * @a sFilepath is not readable, a nullptr is returned
+		 * instead.
+		 */
+		static std::shared_ptr<Sample> loadConverted( const QString& sFilepath, int nSampleRate );
+
+		/**
+		 * Removes the least recently used entries of
+		 * Filesystem::sample_cache_dir() till their total
+		 * size does not exceed @a nMaxBytes anymore.
+		 *
+		 * Samples still mapping a removed entry are not
+		 * affected. Its content stays accessible till they
+		 * are unloaded.
+		 *
+		 * \param nMaxBytes Upper limit of the cache size.
+		 * \param sKeep Path of an entry which must not be
+		 * removed.
+		 */
+		static void pruneSampleCache( qint64 nMaxBytes, const QString& sKeep = "" );
+		/** \return Number of samples currently streamed (see
+		 * isStreamed()).*/
+		static int getStreamedSamples();
 
 		/**
 		 * Load the sample stored in #__filepath into
@@ -207,6 +248,14 @@ class Sample : public H2Core::Object<Sample>
 		 * truncated and a warning log message will be
 		 * displayed.
 		 *
+		 * If Preferences::m_bUseSampleStreaming is set and
+		 * the sample is longer than
+		 * Preferences::m_nSampleStreamingPreloadMs, its
+		 * content is decoded into a file in
+		 * Filesystem::sample_cache_dir() (or an existing one
+		 * is reused) and memory-mapped instead of being read
+		 * into memory. See isStreamed().
+		 *
 		 * \fn load()
 		 */
 		bool load();
@@ -267,6 +316,19 @@ class Sample : public H2Core::Object<Sample>
 
 		/** \return true if both data channels are null pointers */
 		bool is_empty() const;
+		/**
+		 * \return true if #__data_l and #__data_r point into a
+		 * memory-mapped copy of the sample in the sample cache.
+		 *
+		 * Only the first Preferences::m_nSampleStreamingPreloadMs
+		 * of both channels are guaranteed to be resident. The
+		 * remaining pages are read on demand and should be
+		 * requested in advance using the #SamplePrefetcher.
+		 * Modifying the data is still allowed. The affected pages
+		 * are copied on write and the cache file is left
+		 * untouched.
+		 */
+		bool isStreamed() const;
 		/** \return #__filepath */
 		const QString get_filepath() const;
 		/** \return Filename part of #__filepath */
@@ -329,6 +391,39 @@ class Sample : public H2Core::Object<Sample>
 		 * \return String presentation of current object.*/
 		QString toQString( const QString& sPrefix, bool bShort = true ) const override;
 	private:
+		/** Releases #__data_l and #__data_r, regardless of
+		 * whether they were allocated or mapped.*/
+		void freeData();
+		/**
+		 * Maps the decoded content of @a file from the sample
+		 * cache into #__data_l and #__data_r. The cache entry is
+		 * created first in case it does not exist yet.
+		 *
+		 * \param file Opened sample file.
+		 * \param nChannels Number of channels in @a file.
+		 * \param nPreloadFrames Number of frames at the beginning
+		 * of each channel locked in memory. It is rounded up to
+		 * whole SamplePrefetcher::nChunkFrames.
+		 * \param pResampler If not nullptr, converts the
+		 * content of @a file to #__sample_rate.
+		 *
+		 * \return false if the sample could not be mapped. The
+		 * caller has to load it into memory instead.
+		 */
+		bool loadStreamed( SNDFILE* file, int nChannels, int nPreloadFrames,
+						   PolyphaseResampler* pResampler );
+		/**
+		 * Implementation of load().
+		 *
+		 * \param nSampleRate If positive and different from the
+		 * one of the file, the content is converted to this
+		 * rate.
+		 * \param bStream Whether to stream the sample regardless
+		 * of its length and Preferences::m_bUseSampleStreaming.
+		 */
+		bool decode( int nSampleRate, bool bStream );
+
+
 		QString				__filepath;          ///< filepath of the sample
 		int					__frames;            ///< number of frames in this sample
 		int					__sample_rate;       ///< samplerate for this sample
@@ -339,26 +434,22 @@ class Sample : public H2Core::Object<Sample>
 		VelocityEnvelope	__velocity_envelope; ///< velocity envelope vector
 		Loops				__loops;             ///< set of loop parameters
 		Rubberband			__rubberband;        ///< set of rubberband parameters
+		void*				m_pMapping;          ///< cache file mapping holding both channels, if streamed
+		size_t				m_nMappingSize;      ///< size of #m_pMapping in bytes
 		/** loop modes string */
 		static const std::vector<QString> __loop_modes;
+		/** See getStreamedSamples().*/
+		static std::atomic<int> m_nStreamedSamples;
 };
 
 // DEFINITIONS
 
 inline void Sample::unload()
 {
-	if ( __data_l != nullptr ) {
-		delete [] __data_l;
-	}
-	
-	if ( __data_r != nullptr ) {
-		delete [] __data_r;
-	}
+	freeData();
 	__frames = __sample_rate = 0;
 	/** #__is_modified = false; leave this unchanged as pan,
 	    velocity, loop and rubberband are kept unchanged */
-
-	__data_l = __data_r = nullptr;
 }
 
 inline bool Sample::is_empty() const
@@ -366,6 +457,16 @@ inline bool Sample::is_empty() const
 	return ( __data_l == 0 && __data_r == 0 );
 }
 
+inline int Sample::getStreamedSamples()
+{
+	return m_nStreamedSamples.load();
+}
+
+inline bool Sample::isStreamed() const
+{
+	return m_pMapping != nullptr;
+}
+
 inline const QString Sample::get_filepath() const
 {
 	return __filepath;
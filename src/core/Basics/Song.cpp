@@ -43,6 +43,7 @@
 #include <core/Basics/Note.h>
 #include <core/Basics/AutomationPath.h>
 #include <core/AutomationPathSerializer.h>
+#include <core/Helpers/SongCache.h>
 #include <core/Helpers/Xml.h>
 #include <core/Helpers/Filesystem.h>
 #include <core/Hydrogen.h>
@@ -53,6 +54,7 @@
 #endif
 
 #include <QDomDocument>
+#include <QLocale>
 #include <QDir>
 
 namespace
@@ -638,7 +640,8 @@ void Song::setPanLawKNorm( float fKNorm ) {
 	}
 }
 
-void Song::loadDrumkit( Drumkit *pDrumkit, bool bConditional ) {
+void Song::loadDrumkit( Drumkit *pDrumkit, bool bConditional,
+						const DrumkitSampleLoader* pLoader ) {
 	assert ( pDrumkit );
 	auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
 
@@ -708,7 +711,7 @@ void Song::loadDrumkit( Drumkit *pDrumkit, bool bConditional ) {
 		}
 		nMaxID = std::max( nID, nMaxID );
 
-		pInstr->load_from( pDrumkit, pNewInstr );
+		pInstr->load_from( pDrumkit, pNewInstr, pLoader );
 		pInstr->set_id( nID );
 	}
 
@@ -851,11 +854,7 @@ QString Song::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( "%1%2m_fHumanizeVelocityValue: %3\n" ).arg( sPrefix ).arg( s ).arg( m_fHumanizeVelocityValue ) )
 			.append( QString( "%1%2m_fSwingFactor: %3\n" ).arg( sPrefix ).arg( s ).arg( m_fSwingFactor ) )
 			.append( QString( "%1%2m_bIsModified: %3\n" ).arg( sPrefix ).arg( s ).arg( m_bIsModified ) )
-			.append( QString( "%1%2m_latestRoundRobins\n" ).arg( sPrefix ).arg( s ) );
-		for ( auto mm : m_latestRoundRobins ) {
-			sOutput.append( QString( "%1%2%3 : %4\n" ).arg( sPrefix ).arg( s ).arg( mm.first ).arg( mm.second ) );
-		}
-		sOutput.append( QString( "%1%2m_songMode: %3\n" ).arg( sPrefix ).arg( s )
+			.append( QString( "%1%2m_songMode: %3\n" ).arg( sPrefix ).arg( s )
 						.arg( static_cast<int>(m_mode )) )
 			.append( QString( "%1%2m_sPlaybackTrackFilename: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sPlaybackTrackFilename ) )
 			.append( QString( "%1%2m_bPlaybackTrackEnabled: %3\n" ).arg( sPrefix ).arg( s ).arg( m_bPlaybackTrackEnabled ) )
@@ -906,11 +905,7 @@ QString Song::toQString( const QString& sPrefix, bool bShort ) const {
 			.append( QString( ", m_fHumanizeVelocityValue: %1" ).arg( m_fHumanizeVelocityValue ) )
 			.append( QString( ", m_fSwingFactor: %1" ).arg( m_fSwingFactor ) )
 			.append( QString( ", m_bIsModified: %1" ).arg( m_bIsModified ) )
-			.append( QString( ", m_latestRoundRobins" ) );
-		for ( auto mm : m_latestRoundRobins ) {
-			sOutput.append( QString( ", %1 : %4" ).arg( mm.first ).arg( mm.second ) );
-		}
-		sOutput.append( QString( ", m_mode: %1" )
+			.append( QString( ", m_mode: %1" )
 						.arg( static_cast<int>(m_mode) ) )
 			.append( QString( ", m_sPlaybackTrackFilename: %1" ).arg( m_sPlaybackTrackFilename ) )
 			.append( QString( ", m_bPlaybackTrackEnabled: %1" ).arg( m_bPlaybackTrackEnabled ) )
@@ -939,6 +934,11 @@ QString Song::toQString( const QString& sPrefix, bool bShort ) const {
 //-----------------------------------------------------------------------------
 
 SongReader::SongReader()
+	: m_bUseStreamReader( true )
+	, m_bUseCache( true )
+	, m_bDeferGlobalSettings( false )
+	, m_bContainsIsTimelineActivated( false )
+	, m_bIsTimelineActivated( false )
 {
 //	infoLog("init");
 }
@@ -985,14 +985,48 @@ std::shared_ptr<Song> SongReader::readSong( const QString& sFileName )
 
 	auto pPreferences = Preferences::get_instance();
 
+	m_ladspaFX.clear();
+	m_bContainsIsTimelineActivated = false;
+
+	QByteArray hash;
+	if ( m_bUseCache ) {
+		hash = SongCache::hash( sFilename );
+		auto pCachedSong = SongCache::load( sFilename, hash, &m_ladspaFX,
+											&m_bContainsIsTimelineActivated );
+		if ( pCachedSong != nullptr ) {
+			if ( ! m_bContainsIsTimelineActivated ) {
+				pCachedSong->setIsTimelineActivated( pPreferences->getUseTimelineBpm() );
+			}
+			m_bIsTimelineActivated = pCachedSong->getIsTimelineActivated();
+			if ( ! m_bDeferGlobalSettings ) {
+				applyGlobalSettings();
+			}
+			pCachedSong->setFilename( sFilename );
+			pCachedSong->setIsModified( false );
+			return pCachedSong;
+		}
+	}
+
 	INFOLOG( "Reading " + sFilename );
 	std::shared_ptr<Song> pSong = nullptr;
 
-	QDomDocument doc = LocalFileMng::openXmlDocument( sFilename );
+	QDomDocument doc;
+	PatternList* pStreamedPatternList = nullptr;
+	if ( m_bUseStreamReader &&
+		 ! LocalFileMng::checkTinyXMLCompatMode( sFilename ) ) {
+		pStreamedPatternList = new PatternList();
+		if ( ! readSongStreamed( sFilename, &doc, pStreamedPatternList ) ) {
+			delete pStreamedPatternList;
+			return nullptr;
+		}
+	} else {
+		doc = LocalFileMng::openXmlDocument( sFilename );
+	}
 	QDomNodeList nodeList = doc.elementsByTagName( "song" );
 
 	if( nodeList.isEmpty() ) {
 		ERRORLOG( "Error reading song: song node not found" );
+		delete pStreamedPatternList;
 		return nullptr;
 	}
 
@@ -1055,9 +1089,9 @@ std::shared_ptr<Song> SongReader::readSong( const QString& sFileName )
 		// Hydrogen. Using the Timeline state in the
 		// Preferences as a fallback.
 		bIsTimelineActivated = pPreferences->getUseTimelineBpm();
-	} else {
-		pPreferences->setUseTimelineBpm( bIsTimelineActivated );
 	}
+	m_bContainsIsTimelineActivated = bContainsIsTimelineActivated;
+	m_bIsTimelineActivated = bIsTimelineActivated;
 
 	pSong = std::make_shared<Song>( sName, sAuthor, fBpm, fVolume );
 	pSong->setMetronomeVolume( fMetronomeVolume );
@@ -1495,27 +1529,54 @@ std::shared_ptr<Song> SongReader::readSong( const QString& sFileName )
 	} else {
 		ERRORLOG( "Error reading song: instrumentList node not found" );
 		delete pInstrList;
+		delete pStreamedPatternList;
 		return nullptr;
 	}
 
 	// Pattern list
-	QDomNode patterns = songNode.firstChildElement( "patternList" );
-
-	PatternList* pPatternList = new PatternList();
+	PatternList* pPatternList = nullptr;
 	int pattern_count = 0;
 
-	QDomNode patternNode =  patterns.firstChildElement( "pattern" );
-	while (  !patternNode.isNull()  ) {
-		pattern_count++;
-		Pattern* pPattern = getPattern( patternNode, pInstrList );
-		if ( pPattern ) {
-			pPatternList->add( pPattern );
-		} else {
-			ERRORLOG( "Error loading pattern" );
-			delete pPatternList;
-			return nullptr;
+	if ( pStreamedPatternList != nullptr ) {
+		pPatternList = pStreamedPatternList;
+		pattern_count = pPatternList->size();
+
+		// Associate the streamed notes with their instruments.
+		for ( const auto& pPattern : *pPatternList ) {
+			std::vector<Note*> invalidNotes;
+			for ( const auto& it : *pPattern->get_notes() ) {
+				Note* ppNote = it.second;
+				if ( pInstrList->find( ppNote->get_instrument_id() ) == nullptr ) {
+					ERRORLOG( QString( "Instrument with ID: '%1' not found. Note skipped." )
+							  .arg( ppNote->get_instrument_id() ) );
+					invalidNotes.push_back( ppNote );
+				} else {
+					ppNote->map_instrument( pInstrList );
+				}
+			}
+			for ( const auto& ppNote : invalidNotes ) {
+				pPattern->remove_note( ppNote );
+				delete ppNote;
+			}
+		}
+	} else {
+		QDomNode patterns = songNode.firstChildElement( "patternList" );
+
+		pPatternList = new PatternList();
+
+		QDomNode patternNode =  patterns.firstChildElement( "pattern" );
+		while (  !patternNode.isNull()  ) {
+			pattern_count++;
+			Pattern* pPattern = getPattern( patternNode, pInstrList );
+			if ( pPattern ) {
+				pPatternList->add( pPattern );
+			} else {
+				ERRORLOG( "Error loading pattern" );
+				delete pPatternList;
+				return nullptr;
+			}
+			patternNode = ( QDomNode ) patternNode.nextSiblingElement( "pattern" );
 		}
-		patternNode = ( QDomNode ) patternNode.nextSiblingElement( "pattern" );
 	}
 	if ( pattern_count == 0 ) {
 		WARNINGLOG( "0 patterns?" );
@@ -1643,51 +1704,25 @@ std::shared_ptr<Song> SongReader::readSong( const QString& sFileName )
 
 	pSong->setPatternGroupVector( pPatternGroupVector );
 
-#ifdef H2CORE_HAVE_LADSPA
-	// reset FX
-	for ( int fx = 0; fx < MAX_FX; ++fx ) {
-		//LadspaFX* pFX = Effects::get_instance()->getLadspaFX( fx );
-		//delete pFX;
-		Effects::get_instance()->setLadspaFX( nullptr, fx );
-	}
-#endif
-
-	// LADSPA FX
+	// LADSPA FX. They are loaded in applyGlobalSettings().
 	QDomNode ladspaNode = songNode.firstChildElement( "ladspa" );
 	if ( !ladspaNode.isNull() ) {
-		int nFX = 0;
 		QDomNode fxNode = ladspaNode.firstChildElement( "fx" );
 		while (  !fxNode.isNull()  ) {
-			QString sName = LocalFileMng::readXmlString( fxNode, "name", "" );
-			QString sFilename = LocalFileMng::readXmlString( fxNode, "filename", "" );
-			bool bEnabled = LocalFileMng::readXmlBool( fxNode, "enabled", false );
-			float fVolume = LocalFileMng::readXmlFloat( fxNode, "volume", 1.0 );
-
-			if ( sName != "no plugin" ) {
-				// FIXME: il caricamento va fatto fare all'engine, solo lui sa il samplerate esatto
-#ifdef H2CORE_HAVE_LADSPA
-				LadspaFX* pFX = LadspaFX::load( sFilename, sName, 44100 );
-				Effects::get_instance()->setLadspaFX( pFX, nFX );
-				if ( pFX ) {
-					pFX->setEnabled( bEnabled );
-					pFX->setVolume( fVolume );
-					QDomNode inputControlNode = fxNode.firstChildElement( "inputControlPort" );
-					while ( !inputControlNode.isNull() ) {
-						QString sName = LocalFileMng::readXmlString( inputControlNode, "name", "" );
-						float fValue = LocalFileMng::readXmlFloat( inputControlNode, "value", 0.0 );
-
-						for ( unsigned nPort = 0; nPort < pFX->inputControlPorts.size(); nPort++ ) {
-							LadspaControlPort* port = pFX->inputControlPorts[ nPort ];
-							if ( QString( port->sName ) == sName ) {
-								port->fControlValue = fValue;
-							}
-						}
-						inputControlNode = ( QDomNode ) inputControlNode.nextSiblingElement( "inputControlPort" );
-					}
-				}
-#endif
+			LadspaFXSettings fx;
+			fx.sName = LocalFileMng::readXmlString( fxNode, "name", "" );
+			fx.sFilename = LocalFileMng::readXmlString( fxNode, "filename", "" );
+			fx.bEnabled = LocalFileMng::readXmlBool( fxNode, "enabled", false );
+			fx.fVolume = LocalFileMng::readXmlFloat( fxNode, "volume", 1.0 );
+
+			QDomNode inputControlNode = fxNode.firstChildElement( "inputControlPort" );
+			while ( !inputControlNode.isNull() ) {
+				fx.inputControlPorts.push_back(
+					std::make_pair( LocalFileMng::readXmlString( inputControlNode, "name", "" ),
+									LocalFileMng::readXmlFloat( inputControlNode, "value", 0.0 ) ) );
+				inputControlNode = ( QDomNode ) inputControlNode.nextSiblingElement( "inputControlPort" );
 			}
-			nFX++;
+			m_ladspaFX.push_back( fx );
 			fxNode = ( QDomNode ) fxNode.nextSiblingElement( "fx" );
 		}
 	} else {
@@ -1743,12 +1778,70 @@ std::shared_ptr<Song> SongReader::readSong( const QString& sFileName )
 		}
 	}
 
+	if ( ! m_bDeferGlobalSettings ) {
+		applyGlobalSettings();
+	}
+
+	if ( m_bUseCache && ! hash.isEmpty() ) {
+		SongCache::save( sFilename, hash, pSong, m_ladspaFX,
+						 m_bContainsIsTimelineActivated );
+	}
+
 	pSong->setFilename( sFilename );
 	pSong->setIsModified( false );
 
 	return pSong;
 }
 
+void SongReader::setDeferGlobalSettings( bool bDeferGlobalSettings )
+{
+	m_bDeferGlobalSettings = bDeferGlobalSettings;
+}
+
+void SongReader::setUseCache( bool bUseCache )
+{
+	m_bUseCache = bUseCache;
+}
+
+void SongReader::applyGlobalSettings()
+{
+#ifdef H2CORE_HAVE_LADSPA
+	// reset FX
+	for ( int fx = 0; fx < MAX_FX; ++fx ) {
+		//LadspaFX* pFX = Effects::get_instance()->getLadspaFX( fx );
+		//delete pFX;
+		Effects::get_instance()->setLadspaFX( nullptr, fx );
+	}
+
+	for ( int nFX = 0; nFX < static_cast<int>( m_ladspaFX.size() ) && nFX < MAX_FX; ++nFX ) {
+		const auto& fx = m_ladspaFX[ nFX ];
+		if ( fx.sName == "no plugin" ) {
+			continue;
+		}
+
+		// FIXME: il caricamento va fatto fare all'engine, solo lui sa il samplerate esatto
+		LadspaFX* pFX = LadspaFX::load( fx.sFilename, fx.sName, 44100 );
+		Effects::get_instance()->setLadspaFX( pFX, nFX );
+		if ( pFX ) {
+			pFX->setEnabled( fx.bEnabled );
+			pFX->setVolume( fx.fVolume );
+			for ( const auto& controlPort : fx.inputControlPorts ) {
+				for ( unsigned nPort = 0; nPort < pFX->inputControlPorts.size(); nPort++ ) {
+					LadspaControlPort* port = pFX->inputControlPorts[ nPort ];
+					if ( QString( port->sName ) == controlPort.first ) {
+						port->fControlValue = controlPort.second;
+					}
+				}
+			}
+		}
+	}
+#endif
+
+	if ( m_bContainsIsTimelineActivated ) {
+		Preferences::get_instance()->setUseTimelineBpm( m_bIsTimelineActivated );
+	}
+}
+
 Pattern* SongReader::getPattern( QDomNode pattern, InstrumentList* pInstrList )
 {
 	Pattern* pPattern = nullptr;
@@ -1863,4 +1956,124 @@ Pattern* SongReader::getPattern( QDomNode pattern, InstrumentList* pInstrList )
 
 	return pPattern;
 }
+void SongReader::setUseStreamReader( bool bUseStreamReader )
+{
+	m_bUseStreamReader = bUseStreamReader;
+}
+
+bool SongReader::readSongStreamed( const QString& sFilename, QDomDocument* pDoc,
+								   PatternList* pPatternList )
+{
+	XMLStreamReader reader;
+	if ( ! reader.open( sFilename ) ) {
+		return false;
+	}
+
+	if ( ! reader.readNextStartElement() || reader.name() != "song" ) {
+		ERRORLOG( "Error reading song: song node not found" );
+		return false;
+	}
+
+	QDomElement songElement = pDoc->createElement( "song" );
+	while ( reader.readNextStartElement() ) {
+		if ( reader.name() == "patternList" ) {
+			while ( reader.readNextStartElement() ) {
+				if ( reader.name() != "pattern" ) {
+					reader.skipCurrentElement();
+					continue;
+				}
+				pPatternList->add( getPattern( &reader ) );
+			}
+		} else {
+			songElement.appendChild( reader.readNode( pDoc ) );
+		}
+	}
+	pDoc->appendChild( songElement );
+
+	if ( reader.hasError() ) {
+		ERRORLOG( QString( "Unable to read XML document %1: %2" )
+				  .arg( sFilename ).arg( reader.errorString() ) );
+		return false;
+	}
+
+	return true;
+}
+
+Pattern* SongReader::getPattern( XMLStreamReader* pReader )
+{
+	Pattern* pPattern = new Pattern( QString(), QString(), QString(), -1, 4 );
+
+	while ( pReader->readNextStartElement() ) {
+		const QStringRef name = pReader->name();
+		if ( name == "name" ) {
+			pPattern->set_name( pReader->readElementText() );
+		}
+		else if ( name == "info" ) {
+			pPattern->set_info( pReader->readElementText() );
+		}
+		else if ( name == "category" ) {
+			pPattern->set_category( pReader->readElementText() );
+		}
+		else if ( name == "size" || name == "denominator" ) {
+			const bool bSize = name == "size";
+			const QString sValue = pReader->readElementText();
+			if ( ! sValue.isEmpty() ) {
+				if ( bSize ) {
+					pPattern->set_length( QLocale::c().toInt( sValue ) );
+				} else {
+					pPattern->set_denominator( QLocale::c().toInt( sValue ) );
+				}
+			}
+		}
+		else if ( name == "noteList" ) {
+			while ( pReader->readNextStartElement() ) {
+				if ( pReader->name() != "note" ) {
+					pReader->skipCurrentElement();
+					continue;
+				}
+				pPattern->insert_note( Note::load_from( pReader, nullptr ) );
+			}
+		}
+		else if ( name == "sequenceList" ) {
+			// Back compatibility code. Version < 0.9.4
+			while ( pReader->readNextStartElement() ) {
+				if ( pReader->name() != "sequence" ) {
+					pReader->skipCurrentElement();
+					continue;
+				}
+				while ( pReader->readNextStartElement() ) {
+					if ( pReader->name() != "noteList" ) {
+						pReader->skipCurrentElement();
+						continue;
+					}
+					while ( pReader->readNextStartElement() ) {
+						if ( pReader->name() != "note" ) {
+							pReader->skipCurrentElement();
+							continue;
+						}
+						pReader->read_properties();
+						const float fPan = Sampler::getRatioPan(
+							pReader->read_float( "pan_L", 0.5 ),
+							pReader->read_float( "pan_R", 0.5 ) );
+						Note* pNote = new Note( nullptr,
+												pReader->read_int( "position", 0 ),
+												pReader->read_float( "velocity", 0.8f ),
+												fPan,
+												pReader->read_int( "length", -1 ),
+												pReader->read_float( "pitch", 0.0 ) );
+						pNote->set_lead_lag( pReader->read_float( "leadlag", 0.0 ) );
+						pNote->set_instrument_id( pReader->read_int( "instrument", -1 ) );
+						pPattern->insert_note( pNote );
+					}
+				}
+			}
+		}
+		else {
+			pReader->skipCurrentElement();
+		}
+	}
+
+	return pPattern;
+}
+
 };
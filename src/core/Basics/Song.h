@@ -29,6 +29,7 @@
 #include <vector>
 #include <map>
 #include <memory>
+#include <utility>
 
 #include <core/Object.h>
 #include <core/Helpers/Filesystem.h>
@@ -46,10 +47,12 @@ class InstrumentList;
 class Pattern;
 class Song;
 class Drumkit;
+class DrumkitSampleLoader;
 class DrumkitComponent;
 class PatternList;
 class AutomationPath;
 class Timeline;
+class XMLStreamReader;
 
 /**
 \ingroup H2CORE
@@ -60,16 +63,82 @@ class SongReader : public H2Core::Object<SongReader>
 {
 		H2_OBJECT(SongReader)
 	public:
+		/** Settings of a LADSPA effect stored in a song.*/
+		struct LadspaFXSettings {
+			QString sName;
+			QString sFilename;
+			bool bEnabled;
+			float fVolume;
+			/** Name and value of all input control ports.*/
+			std::vector<std::pair<QString, float>> inputControlPorts;
+		};
+
 		SongReader();
 		~SongReader();
 		const QString getPath( const QString& filename ) const;
+		/**
+		 * Reads a song either from its binary snapshot stored in the
+		 * SongCache or by parsing the .h2song file. In the latter
+		 * case a new snapshot is written.
+		 *
+		 * \return nullptr on error.
+		 */
 		std::shared_ptr<Song> readSong( const QString& filename );
 
+		/**
+		 * Besides the Song itself, a .h2song file also contains
+		 * global settings: the LADSPA effects and whether the
+		 * Timeline is used. By default these are applied at the end
+		 * of readSong(). When deferred, they are kept by the reader
+		 * till applyGlobalSettings() is called. This allows to read a
+		 * song in the background without altering the state of the
+		 * song currently played back.
+		 */
+		void setDeferGlobalSettings( bool bDeferGlobalSettings );
+		/** Applies the global settings read during the last call of
+		 * readSong(). */
+		void applyGlobalSettings();
+
+		/** Whether readSong() is allowed to use the SongCache
+		 * (default).*/
+		void setUseCache( bool bUseCache );
+
+		/**
+		 * Whether the pattern list of a song - which holds the vast
+		 * majority of its content - is read using a XMLStreamReader
+		 * (default) or by walking a DOM of the whole file. The latter
+		 * is still used for files written by TinyXML.
+		 */
+		void setUseStreamReader( bool bUseStreamReader );
+
 	private:
 		QString m_sSongVersion;
+		bool m_bUseStreamReader;
+		bool m_bUseCache;
+		bool m_bDeferGlobalSettings;
+
+		std::vector<LadspaFXSettings> m_ladspaFX;
+		/** Whether the song explicitly states if the Timeline is
+		 * activated. Only then the corresponding Preferences option
+		 * is updated.*/
+		bool m_bContainsIsTimelineActivated;
+		bool m_bIsTimelineActivated;
 
 		/// Dato un XmlNode restituisce un oggetto Pattern
 		Pattern* getPattern( QDomNode pattern, InstrumentList* instrList );
+		/**
+		 * Reads a \<pattern\> element from @a pReader. The notes are
+		 * not associated with an instrument yet since the instrument
+		 * list is constructed afterwards.
+		 */
+		Pattern* getPattern( XMLStreamReader* pReader );
+		/**
+		 * Reads @a sFilename in a single pass. All patterns are
+		 * streamed into @a pPatternList while the remainder of the
+		 * \<song\> element is stored in @a pDoc.
+		 */
+		bool readSongStreamed( const QString& sFilename, QDomDocument* pDoc,
+							   PatternList* pPatternList );
 };
 
 /**
@@ -246,8 +315,6 @@ class Song : public H2Core::Object<Song>, public std::enable_shared_from_this<So
 		QString			copyInstrumentLineToString( int nSelectedPattern, int selectedInstrument );
 		bool			pasteInstrumentLineFromString( const QString& sSerialized, int nSelectedPattern, int nSelectedInstrument, std::list<Pattern *>& pPatterns );
 							
-		int			getLatestRoundRobin( float fStartVelocity );
-		void			setLatestRoundRobin( float fStartVelocity, int nLatestRoundRobin );
 		/** \return #m_sPlaybackTrackFilename */
 		const QString&		getPlaybackTrackFilename() const;
 		/** \param sFilename Sets #m_sPlaybackTrackFilename. */
@@ -285,7 +352,16 @@ class Song : public H2Core::Object<Song>, public std::enable_shared_from_this<So
 
 	std::shared_ptr<Timeline> getTimeline() const;
 
-	void loadDrumkit( Drumkit* pDrumkit, bool bConditional );
+	/**
+	 * Replaces the instruments and components of the song by the ones
+	 * of @a pDrumkit.
+	 *
+	 * \param pLoader If not nullptr, the samples already loaded by
+	 * it are used instead of reading them from disk. See
+	 * Instrument::load_from().
+	 */
+	void loadDrumkit( Drumkit* pDrumkit, bool bConditional,
+					  const DrumkitSampleLoader* pLoader = nullptr );
 	void removeInstrument( int nInstrumentNumber, bool bConditional );
 
 	std::vector<std::shared_ptr<Note>> getAllNotes() const;
@@ -356,7 +432,6 @@ private:
 		float			m_fHumanizeVelocityValue;
 		float			m_fSwingFactor;
 		bool			m_bIsModified;
-		std::map< float, int> 	m_latestRoundRobins;
 		Mode			m_mode;
 		
 		/** Name of the file to be loaded as playback track.
@@ -638,20 +713,6 @@ inline AutomationPath* Song::getVelocityAutomationPath() const
 	return m_pVelocityAutomationPath;
 }
 
-inline int Song::getLatestRoundRobin( float fStartVelocity )
-{
-	if ( m_latestRoundRobins.find( fStartVelocity ) == m_latestRoundRobins.end() ) {
-		return 0;
-	} else {
-		return m_latestRoundRobins[ fStartVelocity ];
-	}
-}
-
-inline void Song::setLatestRoundRobin( float fStartVelocity, int nLatestRoundRobin )
-{
-	m_latestRoundRobins[ fStartVelocity ] = nLatestRoundRobin;
-}
-
 inline const QString& Song::getPlaybackTrackFilename() const
 {
 	return m_sPlaybackTrackFilename;
@@ -886,10 +886,11 @@ bool CoreActionController::loadDrumkit( const QString& sDrumkitName, bool bCondi
 	return nRet;
 }
 
-bool CoreActionController::loadDrumkit( Drumkit* pDrumkit, bool bConditional ) {
+bool CoreActionController::loadDrumkit( Drumkit* pDrumkit, bool bConditional,
+										DrumkitSampleLoader* pLoader ) {
 
 	if ( pDrumkit != nullptr ) {
-		if ( Hydrogen::get_instance()->loadDrumkit( pDrumkit, bConditional ) == 0 ) {
+		if ( Hydrogen::get_instance()->loadDrumkit( pDrumkit, bConditional, pLoader ) == 0 ) {
 			EventQueue::get_instance()->push_event( EVENT_DRUMKIT_LOADED, 0 );
 		} else {
 			ERRORLOG( "Unable to load drumkit" );
@@ -1504,6 +1505,15 @@ bool CoreActionController::toggleGridCell( int nColumn, int nRow ){
 	return true;
 }
 
+DspProfiler::Report CoreActionController::getDspProfile() {
+	return Hydrogen::get_instance()->getAudioEngine()->getDspProfiler()->getReport();
+}
+
+bool CoreActionController::resetDspProfile() {
+	Hydrogen::get_instance()->getAudioEngine()->getDspProfiler()->reset();
+	return true;
+}
+
 void CoreActionController::insertRecentFile( const QString sFilename ){
 
 	auto pPref = Preferences::get_instance();
@@ -26,11 +26,13 @@
 #include <vector>
 
 #include <core/Object.h>
+#include <core/AudioEngine/DspProfiler.h>
 #include <core/Basics/Song.h>
 
 namespace H2Core
 {
 	class Drumkit;
+	class DrumkitSampleLoader;
 
 /** \ingroup docCore docAutomation */
 class CoreActionController : public H2Core::Object<CoreActionController> {
@@ -272,8 +274,11 @@ class CoreActionController : public H2Core::Object<CoreActionController> {
 	 * \param pDrumkit Full-fledged H2Core::Drumkit to load.
 	 * \param bConditional Whether to remove all redundant
 	 * H2Core::Instrument regardless of their content.
+	 * \param pLoader Samples of @a pDrumkit loaded upfront. See
+	 * Hydrogen::loadDrumkit().
 	 */
-	bool loadDrumkit( Drumkit* pDrumkit, bool bConditional = true );
+	bool loadDrumkit( Drumkit* pDrumkit, bool bConditional = true,
+					  DrumkitSampleLoader* pLoader = nullptr );
 	/** 
 	 * Upgrades the drumkit found at absolute path @a sDrumkitPath.
 	 *
@@ -359,6 +364,21 @@ class CoreActionController : public H2Core::Object<CoreActionController> {
 		 * @return bool true on success
 		 */
     	bool toggleGridCell( int nColumn, int nRow );
+
+		/**
+		 * Collects the timing statistics of the audio engine
+		 * recorded since the last call.
+		 *
+		 * \return Histograms of the individual processing stages
+		 * and the number of xruns attributed to each of them.
+		 */
+		DspProfiler::Report getDspProfile();
+		/**
+		 * Discards all timing statistics recorded so far.
+		 *
+		 * @return bool true on success
+		 */
+		bool resetDspProfile();
 	private:
 		
 		/**
@@ -36,15 +36,26 @@ void EventQueue::create_instance()
 
 
 EventQueue::EventQueue()
-		: __read_index( 0 )
-		, __write_index( 0 )
+		: m_nReadIndex( 0 )
+		, m_nWriteIndex( 0 )
+		, m_nDroppedEvents( 0 )
+		, m_nUnreportedDroppedEvents( 0 )
+		, m_bCoalescing( false )
+		, m_midiActivityPending( false )
 		, m_bSilent( false )
 {
 	__instance = this;
 
-	for ( int i = 0; i < MAX_EVENTS; ++i ) {
-		__events_buffer[ i ].type = EVENT_NONE;
-		__events_buffer[ i ].value = 0;
+	for ( unsigned int i = 0; i < MAX_EVENTS; ++i ) {
+		m_cells[ i ].nSequence.store( i, std::memory_order_relaxed );
+		m_cells[ i ].event.type = EVENT_NONE;
+		m_cells[ i ].event.value = 0;
+	}
+	for ( auto& bPending : m_noteOnPending ) {
+		bPending.store( false, std::memory_order_relaxed );
+	}
+	for ( auto& bPending : m_metronomePending ) {
+		bPending.store( false, std::memory_order_relaxed );
 	}
 }
 
@@ -54,50 +65,122 @@ EventQueue::~EventQueue()
 //	infoLog( "DESTROY" );
 }
 
+std::atomic<bool>* EventQueue::pendingFlag( const Event& ev )
+{
+	switch ( ev.type ) {
+	case EVENT_NOTEON:
+		if ( ev.value >= 0 && ev.value < MAX_INSTRUMENTS ) {
+			return &m_noteOnPending[ ev.value ];
+		}
+		return nullptr;
+	case EVENT_METRONOME:
+		return &m_metronomePending[ ev.value == 1 ? 1 : 0 ];
+	case EVENT_MIDI_ACTIVITY:
+		return &m_midiActivityPending;
+	default:
+		return nullptr;
+	}
+}
+
+bool EventQueue::tryPush( const Event& ev )
+{
+	unsigned int nPos = m_nWriteIndex.load( std::memory_order_relaxed );
+	while ( true ) {
+		Cell& cell = m_cells[ nPos % MAX_EVENTS ];
+		const unsigned int nSequence = cell.nSequence.load( std::memory_order_acquire );
+		const int nDiff = static_cast<int>( nSequence - nPos );
+		if ( nDiff == 0 ) {
+			if ( m_nWriteIndex.compare_exchange_weak( nPos, nPos + 1,
+													  std::memory_order_relaxed ) ) {
+				cell.event = ev;
+				cell.nSequence.store( nPos + 1, std::memory_order_release );
+				return true;
+			}
+		}
+		else if ( nDiff < 0 ) {
+			// Queue is full.
+			return false;
+		}
+		else {
+			nPos = m_nWriteIndex.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+bool EventQueue::tryPop( Event& ev )
+{
+	unsigned int nPos = m_nReadIndex.load( std::memory_order_relaxed );
+	while ( true ) {
+		Cell& cell = m_cells[ nPos % MAX_EVENTS ];
+		const unsigned int nSequence = cell.nSequence.load( std::memory_order_acquire );
+		const int nDiff = static_cast<int>( nSequence - ( nPos + 1 ) );
+		if ( nDiff == 0 ) {
+			if ( m_nReadIndex.compare_exchange_weak( nPos, nPos + 1,
+													 std::memory_order_relaxed ) ) {
+				ev = cell.event;
+				cell.nSequence.store( nPos + MAX_EVENTS, std::memory_order_release );
+
+				// From now on an equal event can be queued again.
+				auto pPending = pendingFlag( ev );
+				if ( pPending != nullptr ) {
+					pPending->store( false, std::memory_order_release );
+				}
+				return true;
+			}
+		}
+		else if ( nDiff < 0 ) {
+			// Queue is empty.
+			return false;
+		}
+		else {
+			nPos = m_nReadIndex.load( std::memory_order_relaxed );
+		}
+	}
+}
 
 void EventQueue::push_event( const EventType type, const int nValue )
 {
-	std::lock_guard< std::mutex > lock( m_mutex );
-	unsigned int nIndex = ++__write_index;
-	nIndex = nIndex % MAX_EVENTS;
 	Event ev;
 	ev.type = type;
 	ev.value = nValue;
-//	INFOLOG( QString( "[pushEvent] %1 : %2 %3" ).arg( nIndex ).arg( ev.type ).arg( ev.value ) );
-
-	/* If the event queue is full, log an error. We could drop the old event, or the new event we're trying to
-	   place. It's preferrable to drop the oldest event in the queue, on the basis that many
-	   change-of-state-events are probably no longer relevant or redundant based on newer events in the queue,
-	   so we keep the new event. However, since the new event has overwritten the oldest event in the queue,
-	   we also adjust the read pointer, otherwise pop_event would return this newest event on the next call,
-	   then subsequent calls would get newer entries. */
-
-	if ( ! m_bSilent &&
-		 __write_index > __read_index + MAX_EVENTS ) {
-		ERRORLOG( QString( "Event queue full, lost event type %1 value %2" )
-				  .arg( __events_buffer[nIndex].type )
-				  .arg( __events_buffer[nIndex].value ));
-		__read_index++;
-	}
 
-	__events_buffer[ nIndex ] = ev;
+	if ( m_bCoalescing.load( std::memory_order_relaxed ) ) {
+		auto pPending = pendingFlag( ev );
+		if ( pPending != nullptr &&
+			 pPending->exchange( true, std::memory_order_acq_rel ) ) {
+			// An equal event is still waiting to be handled.
+			return;
+		}
+	}
 
+	// If the event queue is full, we drop the oldest event in the
+	// queue to make room for the new one. Since this function might
+	// be called from within the realtime audio thread, we do not log
+	// the loss right away but leave it to pop_event().
+	while ( ! tryPush( ev ) ) {
+		Event droppedEvent;
+		if ( tryPop( droppedEvent ) ) {
+			m_nDroppedEvents.fetch_add( 1, std::memory_order_relaxed );
+			m_nUnreportedDroppedEvents.fetch_add( 1, std::memory_order_relaxed );
+		}
+	}
 }
 
 
 Event EventQueue::pop_event()
 {
-	std::lock_guard< std::mutex > lock( m_mutex );
-	if ( __read_index == __write_index ) {
-		Event ev;
+	const int nDropped =
+		m_nUnreportedDroppedEvents.exchange( 0, std::memory_order_relaxed );
+	if ( nDropped > 0 && ! m_bSilent ) {
+		ERRORLOG( QString( "Event queue full, lost [%1] events" ).arg( nDropped ) );
+	}
+
+	Event ev;
+	if ( ! tryPop( ev ) ) {
 		ev.type = EVENT_NONE;
 		ev.value = 0;
-		return ev;
 	}
-	unsigned int nIndex = ++__read_index;
-	nIndex = nIndex % MAX_EVENTS;
-//	INFOLOG( QString( "[popEvent] %1 : %2 %3" ).arg( nIndex ).arg( __events_buffer[ nIndex ].type ).arg( __events_buffer[ nIndex ].value ) );
-	return __events_buffer[ nIndex ];
+	return ev;
 }
 
 };
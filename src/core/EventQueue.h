@@ -23,13 +23,15 @@
 #ifndef EVENT_QUEUE_H
 #define EVENT_QUEUE_H
 
+#include <core/config.h>
 #include <core/Object.h>
 #include <core/Basics/Note.h>
+#include <atomic>
 #include <cassert>
 #include <mutex>
 
 /** Maximum number of events to be stored in the
-    H2Core::EventQueue::__events_buffer.*/
+    H2Core::EventQueue::m_cells. Has to be a power of two.*/
 #define MAX_EVENTS 1024
 
 namespace H2Core
@@ -166,7 +168,14 @@ enum EventType {
 	EVENT_RELOCATION,
 	EVENT_SONG_SIZE_CHANGED,
 	EVENT_DRIVER_CHANGED,
-	EVENT_PLAYBACK_TRACK_CHANGED
+	EVENT_PLAYBACK_TRACK_CHANGED,
+	/** All slots of the #NotePool are in use and a new note had to
+	 * be dropped. The value of the event is the capacity of the
+	 * pool. Pushed only once until a slot gets available again.*/
+	EVENT_NOTE_POOL_EXHAUSTED,
+	/** Progress of loading the samples of a drumkit in percent
+	 * (0-100). See DrumkitSampleLoader::load().*/
+	EVENT_DRUMKIT_LOADING_PROGRESS
 };
 
 /** Basic building block for the communication between the core of
@@ -218,17 +227,21 @@ public:/**
 	/**
 	 * Queues the next event into the EventQueue.
 	 *
-	 * The event itself will be constructed inside the function
-	 * and will be two properties: an EventType @a type and a
-	 * value @a nValue. Since the event written to the queue most
-	 * recently is indexed with #__write_index, this variable is
-	 * incremented once and its modulo with respect to #MAX_EVENTS
-	 * is calculated to determine the position of insertion into
-	 * #__events_buffer.
+	 * This function neither locks nor allocates memory and is thus
+	 * safe to be called from within the realtime audio thread. It can
+	 * be called by multiple threads at once.
 	 *
-	 * The modulo operation is necessary because #__write_index
-	 * will be only incremented and does not respect the actual
-	 * length of #__events_buffer itself.
+	 * If the queue is full, the oldest event in the queue will be
+	 * dropped in favour of the new one, on the basis that many
+	 * change-of-state-events are probably no longer relevant or
+	 * redundant based on newer events in the queue. Dropped events
+	 * are counted in #m_nDroppedEvents and reported in pop_event()
+	 * instead of being logged right away.
+	 *
+	 * If coalescing is enabled (see setCoalescing()), an
+	 * #H2Core::EVENT_NOTEON, #H2Core::EVENT_METRONOME, or
+	 * #H2Core::EVENT_MIDI_ACTIVITY is discarded if an identical one
+	 * (same type and value) is still waiting in the queue.
 	 *
 	 * \param type Type of the event, which will be queued.
 	 * \param nValue Value specifying the content of the new event.
@@ -237,19 +250,20 @@ public:/**
 	/**
 	 * Reads out the next event of the EventQueue.
 	 *
-	 * Since the event read out most recently is indexed with
-	 * #__read_index, this variable is incremented once and its
-	 * modulo with respect to #MAX_EVENTS is calculated to
-	 * determine the event returned from #__events_buffer. 
-	 *
-	 * The modulo operation is necessary because #__read_index
-	 * will be only incremented and does not respect the actual
-	 * length of #__events_buffer itself.
-	 *
-	 * \return Next event in line.
+	 * \return Next event in line or an event of type
+	 * #H2Core::EVENT_NONE if the queue is empty.
 	 */
 	Event pop_event();
 
+	/** \return Number of events dropped since the creation of the
+	 * EventQueue because the queue was full.*/
+	int getDroppedEvents() const;
+
+	bool getCoalescing() const;
+	/** Whether to merge redundant high-rate events within one drain
+	 * interval of the queue. See push_event().*/
+	void setCoalescing( bool bCoalescing );
+
 	struct AddMidiNoteVector {
 		int m_column;       //position
 		int m_row;          //instrument row
@@ -271,7 +285,7 @@ private:
 	/**
 	 * Constructor of the EventQueue class.
 	 *
-	 * It fills all #MAX_EVENTS slots of the #__events_buffer with
+	 * It fills all #MAX_EVENTS slots of the #m_cells with
 	 * #H2Core::EVENT_NONE and assigns itself to #__instance. Called by
 	 * create_instance().
 	 */
@@ -283,37 +297,68 @@ private:
 	 */
 	static EventQueue *__instance;
 
-	/**
-	 * Continuously growing number indexing the event, which has
-	 * been read from the EventQueue most recently.
+	/** Slot of the ring buffer. #nSequence indicates whether the
+	 * slot is ready to be written (equals the write index) or to be
+	 * read (equals the read index plus one).*/
+	struct Cell {
+		std::atomic<unsigned int> nSequence;
+		Event event;
+	};
+
+	/** Lock-free insertion of @a ev into #m_cells.
+	 *
+	 * \return false if the queue is full.*/
+	bool tryPush( const Event& ev );
+	/** Lock-free removal of the oldest event in #m_cells.
 	 *
-	 * It is incremented with each call to pop_event(). 
+	 * \return false if the queue is empty.*/
+	bool tryPop( Event& ev );
+	/** \return Flag indicating whether an event equal to @a ev is
+	 * currently waiting in the queue or nullptr in case events of
+	 * this type are never coalesced.*/
+	std::atomic<bool>* pendingFlag( const Event& ev );
+
+	/**
+	 * Continuously growing number indexing the next event to be
+	 * read from the EventQueue.
 	 */
-	volatile unsigned int __read_index;
+	std::atomic<unsigned int> m_nReadIndex;
 	/**
-	 * Continuously growing number indexing the event, which has
-	 * been written to the EventQueue most recently.
-	 *
-	 * It is incremented with each call to push_event(). 
+	 * Continuously growing number indexing the next event to be
+	 * written to the EventQueue.
 	 */
-	volatile unsigned int __write_index;
+	std::atomic<unsigned int> m_nWriteIndex;
 	/**
-	 * Array of all events contained in the EventQueue.
+	 * Ring buffer holding all events contained in the EventQueue.
 	 *
-	 * Its length is set to #MAX_EVENTS and it gets initialized
-	 * with #H2Core::EVENT_NONE in EventQueue().
+	 * Its length is set to #MAX_EVENTS.
 	 */
-	Event __events_buffer[ MAX_EVENTS ];
+	Cell m_cells[ MAX_EVENTS ];
 
-	/**
-	 * Mutex to lock access to queue.
-	 */
-	std::mutex m_mutex;
+	std::atomic<int> m_nDroppedEvents;
+	/** Dropped events not reported in the log yet.*/
+	std::atomic<int> m_nUnreportedDroppedEvents;
+
+	std::atomic<bool> m_bCoalescing;
+	std::atomic<bool> m_noteOnPending[ MAX_INSTRUMENTS ];
+	/** One flag for the first beat of a bar and one for all
+	 * others.*/
+	std::atomic<bool> m_metronomePending[ 2 ];
+	std::atomic<bool> m_midiActivityPending;
 
 	/** Whether or not to push log messages.*/
 	bool m_bSilent;
 };
 
+inline int EventQueue::getDroppedEvents() const {
+	return m_nDroppedEvents.load( std::memory_order_relaxed );
+}
+inline bool EventQueue::getCoalescing() const {
+	return m_bCoalescing.load( std::memory_order_relaxed );
+}
+inline void EventQueue::setCoalescing( bool bCoalescing ) {
+	m_bCoalescing.store( bCoalescing, std::memory_order_relaxed );
+}
 inline bool EventQueue::getSilent() const {
 	return m_bSilent;
 }
@@ -0,0 +1,377 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/Helpers/DrumkitIndex.h>
+
+#include <core/Basics/Drumkit.h>
+#include <core/Basics/DrumkitComponent.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentList.h>
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSaveFile>
+
+#include <set>
+
+namespace H2Core
+{
+
+DrumkitIndex* DrumkitIndex::__instance = nullptr;
+
+/** Identifies the file written by DrumkitIndex::save(). The version
+ * has to be incremented whenever the layout of an Entry changes.*/
+static const quint32 nDrumkitIndexMagic = 0x48324458; // "H2DX"
+static const quint32 nDrumkitIndexVersion = 1;
+
+/** Same criterion as Drumkit::isUserDrumkit() but independent of
+ * trailing slashes.*/
+static bool isUserDrumkitPath( const QString& sPath )
+{
+	return ! QDir::cleanPath( sPath ).startsWith(
+		QDir::cleanPath( Filesystem::sys_drumkits_dir() ) );
+}
+
+void DrumkitIndex::create_instance()
+{
+	if ( __instance == nullptr ) {
+		__instance = new DrumkitIndex( Filesystem::cache_dir() + "drumkit_index.bin" );
+	}
+}
+
+DrumkitIndex::DrumkitIndex( const QString& sIndexPath )
+	: m_sIndexPath( sIndexPath )
+	, m_bModified( false )
+	, m_nParseCount( 0 )
+	, m_pWatcher( nullptr )
+{
+	load();
+}
+
+DrumkitIndex::~DrumkitIndex()
+{
+	save();
+	delete m_pWatcher;
+
+	if ( __instance == this ) {
+		__instance = nullptr;
+	}
+}
+
+bool DrumkitIndex::load()
+{
+	QFile file( m_sIndexPath );
+	if ( ! file.exists() || file.size() == 0 ) {
+		return false;
+	}
+	if ( ! file.open( QIODevice::ReadOnly ) ) {
+		WARNINGLOG( QString( "Unable to open drumkit index [%1]" ).arg( m_sIndexPath ) );
+		return false;
+	}
+
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+
+	quint32 nMagic, nVersion, nEntries;
+	stream >> nMagic >> nVersion >> nEntries;
+	if ( stream.status() != QDataStream::Ok ||
+		 nMagic != nDrumkitIndexMagic || nVersion != nDrumkitIndexVersion ) {
+		// An outdated or corrupted index is just rebuilt.
+		WARNINGLOG( QString( "Discarding incompatible drumkit index [%1]" )
+					.arg( m_sIndexPath ) );
+		return false;
+	}
+
+	std::map<QString, Entry> entries;
+	for ( quint32 ii = 0; ii < nEntries; ++ii ) {
+		Entry entry;
+		stream >> entry.sPath >> entry.nSize >> entry.nModified
+			   >> entry.sName >> entry.sAuthor >> entry.sLicense
+			   >> entry.sImage >> entry.sImageLicense
+			   >> entry.instruments >> entry.components
+			   >> entry.bIsUserDrumkit;
+		if ( stream.status() != QDataStream::Ok ) {
+			WARNINGLOG( QString( "Drumkit index [%1] is truncated" )
+						.arg( m_sIndexPath ) );
+			return false;
+		}
+		entries[ entry.sPath ] = entry;
+	}
+
+	m_entries.swap( entries );
+	INFOLOG( QString( "Loaded [%1] drumkits from index [%2]" )
+			 .arg( m_entries.size() ).arg( m_sIndexPath ) );
+	return true;
+}
+
+bool DrumkitIndex::save()
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	if ( ! m_bModified ) {
+		return true;
+	}
+
+	if ( ! Filesystem::path_usable( QFileInfo( m_sIndexPath ).absolutePath(), true, true ) ) {
+		ERRORLOG( QString( "Unable to create folder for drumkit index [%1]" )
+				  .arg( m_sIndexPath ) );
+		return false;
+	}
+
+	// QSaveFile writes to a temporary file and renames it on
+	// commit(). Another instance reading the index in the meantime
+	// will never see an incomplete one.
+	QSaveFile file( m_sIndexPath );
+	if ( ! file.open( QIODevice::WriteOnly ) ) {
+		ERRORLOG( QString( "Unable to write drumkit index [%1]" ).arg( m_sIndexPath ) );
+		return false;
+	}
+
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	stream << nDrumkitIndexMagic << nDrumkitIndexVersion
+		   << static_cast<quint32>( m_entries.size() );
+	for ( const auto& it : m_entries ) {
+		const Entry& entry = it.second;
+		stream << entry.sPath << entry.nSize << entry.nModified
+			   << entry.sName << entry.sAuthor << entry.sLicense
+			   << entry.sImage << entry.sImageLicense
+			   << entry.instruments << entry.components
+			   << entry.bIsUserDrumkit;
+	}
+
+	if ( ! file.commit() ) {
+		ERRORLOG( QString( "Unable to write drumkit index [%1]" ).arg( m_sIndexPath ) );
+		return false;
+	}
+
+	m_bModified = false;
+	return true;
+}
+
+const DrumkitIndex::Entry* DrumkitIndex::update( const QString& sDrumkitPath,
+												 bool bIsUserDrumkit )
+{
+	const QString sPath = QDir::cleanPath( QFileInfo( sDrumkitPath ).absoluteFilePath() );
+	const QFileInfo fileInfo( Filesystem::drumkit_file( sPath ) );
+
+	if ( ! fileInfo.exists() ) {
+		if ( m_entries.erase( sPath ) > 0 ) {
+			m_bModified = true;
+		}
+		return nullptr;
+	}
+
+	auto it = m_entries.find( sPath );
+	if ( it != m_entries.end() &&
+		 it->second.nSize == fileInfo.size() &&
+		 it->second.nModified == fileInfo.lastModified().toMSecsSinceEpoch() &&
+		 it->second.bIsUserDrumkit == bIsUserDrumkit ) {
+		return &it->second;
+	}
+
+	// Cache miss. Parse the drumkit just as the consumers of the index
+	// would have done.
+	++m_nParseCount;
+	Drumkit* pDrumkit = Drumkit::load( sPath, false, true, true );
+	if ( pDrumkit == nullptr ) {
+		if ( m_entries.erase( sPath ) > 0 ) {
+			m_bModified = true;
+		}
+		return nullptr;
+	}
+
+	Entry entry;
+	entry.sPath = sPath;
+	entry.sName = pDrumkit->get_name();
+	entry.sAuthor = pDrumkit->get_author();
+	entry.sLicense = pDrumkit->get_license();
+	entry.sImage = pDrumkit->get_image();
+	entry.sImageLicense = pDrumkit->get_image_license();
+	entry.bIsUserDrumkit = bIsUserDrumkit;
+	for ( const auto& pInstrument : *pDrumkit->get_instruments() ) {
+		entry.instruments << pInstrument->get_name();
+	}
+	for ( const auto& pComponent : *pDrumkit->get_components() ) {
+		entry.components << pComponent->get_name();
+	}
+	delete pDrumkit;
+
+	// Legacy kits are upgraded in place while loading. Use the
+	// properties of the resulting file.
+	const QFileInfo upgradedFileInfo( Filesystem::drumkit_file( sPath ) );
+	entry.nSize = upgradedFileInfo.size();
+	entry.nModified = upgradedFileInfo.lastModified().toMSecsSinceEpoch();
+
+	m_entries[ sPath ] = entry;
+	m_bModified = true;
+
+	return &m_entries[ sPath ];
+}
+
+std::vector<DrumkitIndex::Entry> DrumkitIndex::getDrumkits( const QString& sDrumkitsDir,
+															bool bIsUserDrumkit )
+{
+	std::vector<Entry> drumkits;
+	QStringList watchedPaths;
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+
+		const QString sDir = QDir::cleanPath( QFileInfo( sDrumkitsDir ).absoluteFilePath() );
+		std::set<QString> presentPaths;
+
+		for ( const auto& sDrumkit : Filesystem::drumkit_list( sDir + "/" ) ) {
+			const Entry* pEntry = update( sDir + "/" + sDrumkit, bIsUserDrumkit );
+			if ( pEntry != nullptr ) {
+				drumkits.push_back( *pEntry );
+				presentPaths.insert( pEntry->sPath );
+				watchedPaths << Filesystem::drumkit_file( pEntry->sPath );
+			}
+		}
+
+		// Drop all kits which were removed from the folder.
+		for ( auto it = m_entries.begin(); it != m_entries.end(); ) {
+			if ( QFileInfo( it->first ).absolutePath() == sDir &&
+				 presentPaths.find( it->first ) == presentPaths.end() ) {
+				it = m_entries.erase( it );
+				m_bModified = true;
+			} else {
+				++it;
+			}
+		}
+
+		watchedPaths << sDrumkitsDir;
+	}
+
+	watch( watchedPaths );
+	save();
+
+	return drumkits;
+}
+
+std::vector<DrumkitIndex::Entry> DrumkitIndex::getSystemDrumkits()
+{
+	return getDrumkits( Filesystem::sys_drumkits_dir(), false );
+}
+
+std::vector<DrumkitIndex::Entry> DrumkitIndex::getUserDrumkits()
+{
+	return getDrumkits( Filesystem::usr_drumkits_dir(), true );
+}
+
+bool DrumkitIndex::getDrumkit( const QString& sDrumkitPath, Entry* pEntry )
+{
+	std::lock_guard<std::mutex> lock( m_mutex );
+
+	const Entry* pIndexed = update( sDrumkitPath, isUserDrumkitPath( sDrumkitPath ) );
+	if ( pIndexed == nullptr ) {
+		return false;
+	}
+
+	*pEntry = *pIndexed;
+	return true;
+}
+
+bool DrumkitIndex::findDrumkit( const QString& sDrumkitName, Filesystem::Lookup lookup,
+								Entry* pEntry )
+{
+	std::vector<Entry> drumkits;
+	if ( lookup == Filesystem::Lookup::user ||
+		 lookup == Filesystem::Lookup::stacked ) {
+		drumkits = getUserDrumkits();
+	}
+	if ( lookup == Filesystem::Lookup::system ||
+		 lookup == Filesystem::Lookup::stacked ) {
+		const auto systemDrumkits = getSystemDrumkits();
+		drumkits.insert( drumkits.end(), systemDrumkits.begin(), systemDrumkits.end() );
+	}
+
+	for ( const auto& entry : drumkits ) {
+		if ( entry.sName == sDrumkitName ) {
+			*pEntry = entry;
+			return true;
+		}
+	}
+	return false;
+}
+
+void DrumkitIndex::watch( const QStringList& paths )
+{
+	// The watcher requires an event loop. Without one - e.g. in
+	// h2cli - the index is still kept up to date by comparing the
+	// size and time of modification on each lookup.
+	if ( QCoreApplication::instance() == nullptr ) {
+		return;
+	}
+
+	if ( m_pWatcher == nullptr ) {
+		m_pWatcher = new QFileSystemWatcher();
+		QObject::connect( m_pWatcher, &QFileSystemWatcher::directoryChanged,
+						  [this]( const QString& sPath ) { onDirectoryChanged( sPath ); } );
+		QObject::connect( m_pWatcher, &QFileSystemWatcher::fileChanged,
+						  [this]( const QString& sPath ) { onFileChanged( sPath ); } );
+	}
+
+	QStringList newPaths;
+	const QStringList watchedPaths = m_pWatcher->files() + m_pWatcher->directories();
+	for ( const auto& sPath : paths ) {
+		if ( ! watchedPaths.contains( sPath ) ) {
+			newPaths << sPath;
+		}
+	}
+	if ( ! newPaths.isEmpty() ) {
+		m_pWatcher->addPaths( newPaths );
+	}
+}
+
+void DrumkitIndex::onDirectoryChanged( const QString& sPath )
+{
+	// A drumkit was installed or removed. Only the new kits are
+	// parsed.
+	INFOLOG( QString( "Updating drumkit index for [%1]" ).arg( sPath ) );
+	getDrumkits( sPath, isUserDrumkitPath( sPath ) );
+}
+
+void DrumkitIndex::onFileChanged( const QString& sPath )
+{
+	const QString sDrumkitPath = QFileInfo( sPath ).absolutePath();
+	INFOLOG( QString( "Updating drumkit index for [%1]" ).arg( sDrumkitPath ) );
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		update( sDrumkitPath, isUserDrumkitPath( sDrumkitPath ) );
+	}
+
+	// Files replaced by renaming - as done by most editors - are
+	// dropped from the watcher.
+	if ( Filesystem::file_exists( sPath, true ) ) {
+		watch( QStringList() << sPath );
+	}
+	save();
+}
+
+};
@@ -0,0 +1,167 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef H2C_DRUMKIT_INDEX_H
+#define H2C_DRUMKIT_INDEX_H
+
+#include <core/Object.h>
+#include <core/Helpers/Filesystem.h>
+
+#include <QString>
+#include <QStringList>
+
+#include <cassert>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class QFileSystemWatcher;
+
+namespace H2Core
+{
+
+/**
+ * Persistent index of the metadata of all installed drumkits.
+ *
+ * Listing the installed drumkits using Drumkit::load() requires a
+ * full DOM parse and XSD validation of each drumkit.xml. Instead, the
+ * index stores the properties required to present the kits - name,
+ * author, license, image, instrument and component names - in a
+ * small binary file in Filesystem::cache_dir(). Each entry is keyed
+ * by the path of the drumkit and is only valid as long as size and
+ * time of modification of its drumkit.xml file still match the stored
+ * ones. Only new or altered kits are parsed again.
+ *
+ * In addition, a QFileSystemWatcher keeps track of the system and
+ * user drumkit folders as well as of all indexed drumkit.xml files
+ * and updates the affected entries as soon as a kit is installed,
+ * altered, or removed. This way refreshing the sound library does not
+ * have to parse any XML at all.
+ */
+/** \ingroup docCore docDataStructure */
+class DrumkitIndex : public H2Core::Object<DrumkitIndex>
+{
+	H2_OBJECT(DrumkitIndex)
+public:
+	/** Metadata of a single drumkit.*/
+	struct Entry {
+		/** Absolute path of the drumkit folder. Can be passed to
+		 * Drumkit::load().*/
+		QString sPath;
+		/** Size of the drumkit.xml file in bytes.*/
+		qint64 nSize;
+		/** Time of the last modification of drumkit.xml in
+		 * milliseconds since epoch.*/
+		qint64 nModified;
+		QString sName;
+		QString sAuthor;
+		QString sLicense;
+		QString sImage;
+		QString sImageLicense;
+		/** Names of all instruments in the order of the kit.*/
+		QStringList instruments;
+		/** Names of all drumkit components.*/
+		QStringList components;
+		bool bIsUserDrumkit;
+	};
+
+	/**
+	 * If #__instance equals 0, a new DrumkitIndex singleton using
+	 * a file in Filesystem::cache_dir() is created and stored in
+	 * #__instance.
+	 */
+	static void create_instance();
+	static DrumkitIndex* get_instance() { assert(__instance); return __instance; }
+
+	/**
+	 * \param sIndexPath File the index is read from and written to.
+	 */
+	DrumkitIndex( const QString& sIndexPath );
+	~DrumkitIndex();
+
+	/** \return Entries of all usable drumkits in
+	 * Filesystem::sys_drumkits_dir() in the order of
+	 * Filesystem::sys_drumkit_list().*/
+	std::vector<Entry> getSystemDrumkits();
+	/** \return Entries of all usable drumkits in
+	 * Filesystem::usr_drumkits_dir() in the order of
+	 * Filesystem::usr_drumkit_list().*/
+	std::vector<Entry> getUserDrumkits();
+
+	/**
+	 * Looks up a single drumkit.
+	 *
+	 * \param sDrumkitPath Folder of the drumkit.
+	 * \param pEntry Filled with the metadata of the drumkit.
+	 *
+	 * \return false in case @a sDrumkitPath does not hold a valid
+	 * drumkit.
+	 */
+	bool getDrumkit( const QString& sDrumkitPath, Entry* pEntry );
+
+	/**
+	 * Searches the drumkit folders indicated by @a lookup for a kit
+	 * with a name property of @a sDrumkitName. In case of
+	 * Filesystem::Lookup::stacked the user drumkits take precedence.
+	 *
+	 * \return false if no matching drumkit was found.
+	 */
+	bool findDrumkit( const QString& sDrumkitName, Filesystem::Lookup lookup,
+					  Entry* pEntry );
+
+	/** Writes the index to disk in case it was altered.*/
+	bool save();
+
+	/** \return Number of drumkit.xml files parsed since the index
+	 * was created.*/
+	int getParseCount() const;
+
+private:
+	static DrumkitIndex* __instance;
+
+	bool load();
+	std::vector<Entry> getDrumkits( const QString& sDrumkitsDir, bool bIsUserDrumkit );
+	/** Returns the entry of @a sDrumkitPath and parses the
+	 * drumkit.xml file in case it is either not indexed yet or
+	 * outdated. Has to be called with #m_mutex being locked.
+	 *
+	 * \return nullptr if @a sDrumkitPath is not a valid drumkit.*/
+	const Entry* update( const QString& sDrumkitPath, bool bIsUserDrumkit );
+	void watch( const QStringList& paths );
+	void onDirectoryChanged( const QString& sPath );
+	void onFileChanged( const QString& sPath );
+
+	QString m_sIndexPath;
+	std::map<QString, Entry> m_entries;
+	bool m_bModified;
+	int m_nParseCount;
+	QFileSystemWatcher* m_pWatcher;
+	std::mutex m_mutex;
+};
+
+inline int DrumkitIndex::getParseCount() const {
+	return m_nParseCount;
+}
+
+};
+
+#endif
@@ -180,6 +180,9 @@ namespace H2Core
 		static QString cache_dir();
 		/** returns user repository cache path */
 		static QString repositories_cache_dir();
+		/** returns user cache path of the decoded samples used
+		 * for streaming */
+		static QString sample_cache_dir();
 		/** returns system demos path */
 		static QString demos_dir();
 		/** returns system xsd path */
@@ -206,6 +209,11 @@ namespace H2Core
 		static QStringList sys_drumkit_list( );
 		/** returns list of usable user drumkits ( see Filesystem::drumkit_list ) */
 		static QStringList usr_drumkit_list( );
+		/**
+		 * \return a list of usable drumkits, which means having a readable drumkit.xml file
+		 * \param path the path to search in for drumkits
+		 */
+		static QStringList drumkit_list( const QString& path );
 		/**
 		 * returns true if the drumkit exists within usable system or user drumkits
 		 * \param dk_name the drumkit name
@@ -428,11 +436,6 @@ namespace H2Core
 		 * If this variable is non-empty, its content will be used as
 		 * an alternative to store and load the preferences.*/
 		static QString m_sPreferencesOverwritePath;
-		/**
-		 * \return a list of usable drumkits, which means having a readable drumkit.xml file
-		 * \param path the path to search in for drumkits
-		 */
-		static QStringList drumkit_list( const QString& path );
 		/**
 		 * \return true if all the asked permissions are ok
 		 * \param path the path to the file to check
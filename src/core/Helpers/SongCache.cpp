@@ -0,0 +1,697 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+
+#include <core/Helpers/SongCache.h>
+
+#include <core/Basics/Adsr.h>
+#include <core/Basics/AutomationPath.h>
+#include <core/Basics/DrumkitComponent.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentComponent.h>
+#include <core/Basics/InstrumentLayer.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Basics/Note.h>
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Sample.h>
+#include <core/Helpers/Filesystem.h>
+#include <core/Timeline.h>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <thread>
+
+namespace H2Core
+{
+
+/** Identifies the files written by SongCache::save(). The version
+ * has to be incremented whenever the layout of the snapshot
+ * changes.*/
+static const quint32 nSongCacheMagic = 0x48325343; // "H2SC"
+static const quint32 nSongCacheVersion = 1;
+
+/** Layout of a single note within the note array of a pattern.*/
+struct PackedNote {
+	qint32 nPosition;
+	qint32 nInstrumentId;
+	qint32 nLength;
+	float fVelocity;
+	float fPan;
+	float fPitch;
+	float fLeadLag;
+	float fProbability;
+	qint8 nKey;
+	qint8 nOctave;
+	qint8 nNoteOff;
+	qint8 nPadding;
+};
+static_assert( sizeof( PackedNote ) == 36, "Unexpected padding in PackedNote" );
+
+/** Sample of a layer to be loaded once the whole snapshot was read.*/
+struct SampleTask {
+	std::shared_ptr<InstrumentLayer> pLayer;
+	QString sFilepath;
+	bool bIsModified;
+	Sample::Loops loops;
+	Sample::Rubberband rubberband;
+	Sample::VelocityEnvelope velocity;
+	Sample::PanEnvelope pan;
+};
+
+static void writeEnvelope( QDataStream& stream, const std::vector<EnvelopePoint>* pEnvelope )
+{
+	stream << static_cast<quint32>( pEnvelope->size() );
+	for ( const auto& point : *pEnvelope ) {
+		stream << static_cast<qint32>( point.frame ) << static_cast<qint32>( point.value );
+	}
+}
+
+static std::vector<EnvelopePoint> readEnvelope( QDataStream& stream )
+{
+	std::vector<EnvelopePoint> envelope;
+	quint32 nPoints;
+	stream >> nPoints;
+	for ( quint32 ii = 0; ii < nPoints && stream.status() == QDataStream::Ok; ++ii ) {
+		qint32 nFrame, nValue;
+		stream >> nFrame >> nValue;
+		envelope.push_back( EnvelopePoint( nFrame, nValue ) );
+	}
+	return envelope;
+}
+
+QByteArray SongCache::hash( const QString& sSongPath )
+{
+	QFile file( sSongPath );
+	if ( ! file.open( QIODevice::ReadOnly ) ) {
+		return QByteArray();
+	}
+
+	QCryptographicHash hash( QCryptographicHash::Sha1 );
+	if ( ! hash.addData( &file ) ) {
+		return QByteArray();
+	}
+	return hash.result();
+}
+
+QString SongCache::getCachePath( const QString& sSongPath )
+{
+	const QByteArray key = QCryptographicHash::hash(
+		QFileInfo( sSongPath ).absoluteFilePath().toUtf8(),
+		QCryptographicHash::Sha1 ).toHex();
+	return Filesystem::cache_dir() + "songs/" + QString::fromLatin1( key ) + ".bin";
+}
+
+bool SongCache::save( const QString& sSongPath, const QByteArray& hash,
+					  std::shared_ptr<Song> pSong,
+					  const std::vector<SongReader::LadspaFXSettings>& ladspaFX,
+					  bool bContainsIsTimelineActivated )
+{
+	auto pInstrumentList = pSong->getInstrumentList();
+	auto pPatternList = pSong->getPatternList();
+	for ( const auto& pInstrument : *pInstrumentList ) {
+		if ( pInstrument->has_missing_samples() ) {
+			return false;
+		}
+	}
+
+	const QString sCachePath = getCachePath( sSongPath );
+	QDir().mkpath( QFileInfo( sCachePath ).absolutePath() );
+	QSaveFile file( sCachePath );
+	if ( ! file.open( QIODevice::WriteOnly ) ) {
+		WARNINGLOG( QString( "Unable to write song cache [%1]" ).arg( sCachePath ) );
+		return false;
+	}
+
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	stream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+	stream << nSongCacheMagic << nSongCacheVersion << hash;
+
+	stream << pSong->getName() << pSong->getAuthor() << pSong->getBpm()
+		   << pSong->getVolume() << pSong->getMetronomeVolume()
+		   << pSong->getNotes() << pSong->getLicense()
+		   << static_cast<qint32>( pSong->getLoopMode() )
+		   << static_cast<qint32>( pSong->getPatternMode() )
+		   << static_cast<qint32>( pSong->getMode() )
+		   << pSong->getHumanizeTimeValue() << pSong->getHumanizeVelocityValue()
+		   << pSong->getSwingFactor()
+		   << pSong->getPlaybackTrackFilename() << pSong->getPlaybackTrackEnabled()
+		   << pSong->getPlaybackTrackVolume()
+		   << static_cast<qint32>( pSong->getActionMode() )
+		   << pSong->getIsPatternEditorLocked() << pSong->getIsTimelineActivated()
+		   << bContainsIsTimelineActivated
+		   << static_cast<qint32>( pSong->getPanLawType() ) << pSong->getPanLawKNorm()
+		   << pSong->getCurrentDrumkitName()
+		   << static_cast<qint32>( pSong->getCurrentDrumkitLookup() );
+
+	stream << static_cast<quint32>( pSong->getComponents()->size() );
+	for ( const auto& pComponent : *pSong->getComponents() ) {
+		stream << static_cast<qint32>( pComponent->get_id() ) << pComponent->get_name()
+			   << pComponent->get_volume();
+	}
+
+	// Instruments including the references to their samples.
+	stream << static_cast<quint32>( pInstrumentList->size() );
+	for ( const auto& pInstrument : *pInstrumentList ) {
+		auto pAdsr = pInstrument->get_adsr();
+		stream << static_cast<qint32>( pInstrument->get_id() ) << pInstrument->get_name()
+			   << pInstrument->get_drumkit_name()
+			   << pAdsr->get_attack() << pAdsr->get_decay() << pAdsr->get_sustain()
+			   << pAdsr->get_release()
+			   << pInstrument->get_volume() << pInstrument->is_muted()
+			   << pInstrument->is_soloed() << pInstrument->getPan()
+			   << pInstrument->get_apply_velocity();
+		for ( int nFX = 0; nFX < MAX_FX; ++nFX ) {
+			stream << pInstrument->get_fx_level( nFX );
+		}
+		stream << pInstrument->get_pitch_offset() << pInstrument->get_random_pitch_factor()
+			   << pInstrument->is_filter_active() << pInstrument->get_filter_cutoff()
+			   << pInstrument->get_filter_resonance() << pInstrument->get_gain()
+			   << static_cast<qint32>( pInstrument->get_mute_group() )
+			   << pInstrument->is_stop_notes()
+			   << static_cast<qint32>( pInstrument->get_hihat_grp() )
+			   << static_cast<qint32>( pInstrument->get_lower_cc() )
+			   << static_cast<qint32>( pInstrument->get_higher_cc() )
+			   << static_cast<qint32>( pInstrument->sample_selection_alg() )
+			   << static_cast<qint32>( pInstrument->get_midi_out_channel() )
+			   << static_cast<qint32>( pInstrument->get_midi_out_note() );
+
+		stream << static_cast<quint32>( pInstrument->get_components()->size() );
+		for ( const auto& pComponent : *pInstrument->get_components() ) {
+			stream << static_cast<qint32>( pComponent->get_drumkit_componentID() )
+				   << pComponent->get_gain();
+
+			std::vector<int> layers;
+			for ( int nLayer = 0; nLayer < InstrumentComponent::getMaxLayers(); ++nLayer ) {
+				if ( pComponent->get_layer( nLayer ) != nullptr ) {
+					layers.push_back( nLayer );
+				}
+			}
+			stream << static_cast<quint32>( layers.size() );
+			for ( const int nLayer : layers ) {
+				auto pLayer = pComponent->get_layer( nLayer );
+				auto pSample = pLayer->get_sample();
+				stream << static_cast<qint32>( nLayer ) << pLayer->get_start_velocity()
+					   << pLayer->get_end_velocity() << pLayer->get_gain()
+					   << pLayer->get_pitch() << ( pSample != nullptr );
+				if ( pSample == nullptr ) {
+					continue;
+				}
+
+				const auto loops = pSample->get_loops();
+				const auto rubberband = pSample->get_rubberband();
+				stream << pSample->get_filepath() << pSample->get_is_modified()
+					   << static_cast<qint32>( loops.start_frame )
+					   << static_cast<qint32>( loops.loop_frame )
+					   << static_cast<qint32>( loops.end_frame )
+					   << static_cast<qint32>( loops.count )
+					   << static_cast<qint32>( loops.mode )
+					   << rubberband.use << rubberband.divider << rubberband.pitch
+					   << static_cast<qint32>( rubberband.c_settings );
+				writeEnvelope( stream, pSample->get_velocity_envelope() );
+				writeEnvelope( stream, pSample->get_pan_envelope() );
+			}
+		}
+	}
+
+	// Patterns. The notes are written as a single block per pattern.
+	std::vector<PackedNote> notes;
+	stream << static_cast<quint32>( pPatternList->size() );
+	for ( const auto& pPattern : *pPatternList ) {
+		stream << pPattern->get_name() << pPattern->get_info() << pPattern->get_category()
+			   << static_cast<qint32>( pPattern->get_length() )
+			   << static_cast<qint32>( pPattern->get_denominator() );
+
+		notes.clear();
+		for ( const auto& it : *pPattern->get_notes() ) {
+			Note* pNote = it.second;
+			PackedNote packedNote;
+			packedNote.nPosition = pNote->get_position();
+			packedNote.nInstrumentId = pNote->get_instrument_id();
+			packedNote.nLength = pNote->get_length();
+			packedNote.fVelocity = pNote->get_velocity();
+			packedNote.fPan = pNote->getPan();
+			packedNote.fPitch = pNote->get_pitch();
+			packedNote.fLeadLag = pNote->get_lead_lag();
+			packedNote.fProbability = pNote->get_probability();
+			packedNote.nKey = static_cast<qint8>( pNote->get_key() );
+			packedNote.nOctave = static_cast<qint8>( pNote->get_octave() );
+			packedNote.nNoteOff = pNote->get_note_off() ? 1 : 0;
+			packedNote.nPadding = 0;
+			notes.push_back( packedNote );
+		}
+		stream << static_cast<quint32>( notes.size() );
+		stream.writeRawData( reinterpret_cast<const char*>( notes.data() ),
+							 notes.size() * sizeof( PackedNote ) );
+	}
+
+	for ( const auto& pPattern : *pPatternList ) {
+		stream << static_cast<quint32>( pPattern->get_virtual_patterns()->size() );
+		for ( const auto& pVirtualPattern : *pPattern->get_virtual_patterns() ) {
+			stream << static_cast<qint32>( pPatternList->index( pVirtualPattern ) );
+		}
+	}
+
+	auto pPatternGroupVector = pSong->getPatternGroupVector();
+	stream << static_cast<quint32>( pPatternGroupVector->size() );
+	for ( const auto& pColumn : *pPatternGroupVector ) {
+		stream << static_cast<quint32>( pColumn->size() );
+		for ( const auto& pPattern : *pColumn ) {
+			stream << static_cast<qint32>( pPatternList->index( pPattern ) );
+		}
+	}
+
+	stream << static_cast<quint32>( ladspaFX.size() );
+	for ( const auto& fx : ladspaFX ) {
+		stream << fx.sName << fx.sFilename << fx.bEnabled << fx.fVolume
+			   << static_cast<quint32>( fx.inputControlPorts.size() );
+		for ( const auto& port : fx.inputControlPorts ) {
+			stream << port.first << port.second;
+		}
+	}
+
+	auto pTimeline = pSong->getTimeline();
+	const auto tempoMarkers = pTimeline->getAllTempoMarkers();
+	const int nFirstTempoMarker = pTimeline->isFirstTempoMarkerSpecial() ? 1 : 0;
+	stream << static_cast<quint32>( std::max( 0, static_cast<int>( tempoMarkers.size() ) -
+											   nFirstTempoMarker ) );
+	for ( int ii = nFirstTempoMarker; ii < static_cast<int>( tempoMarkers.size() ); ++ii ) {
+		stream << static_cast<qint32>( tempoMarkers[ ii ]->nColumn ) << tempoMarkers[ ii ]->fBpm;
+	}
+	const auto tags = pTimeline->getAllTags();
+	stream << static_cast<quint32>( tags.size() );
+	for ( const auto& pTag : tags ) {
+		stream << static_cast<qint32>( pTag->nColumn ) << pTag->sTag;
+	}
+
+	const auto pVelocityAutomationPath = pSong->getVelocityAutomationPath();
+	stream << static_cast<quint32>( std::distance( pVelocityAutomationPath->begin(),
+												   pVelocityAutomationPath->end() ) );
+	for ( const auto& point : *pVelocityAutomationPath ) {
+		stream << point.first << point.second;
+	}
+
+	// Allows to detect truncated files.
+	stream << nSongCacheMagic;
+
+	if ( stream.status() != QDataStream::Ok || ! file.commit() ) {
+		WARNINGLOG( QString( "Unable to write song cache [%1]" ).arg( sCachePath ) );
+		return false;
+	}
+
+	return true;
+}
+
+std::shared_ptr<Song> SongCache::load( const QString& sSongPath, const QByteArray& hash,
+									   std::vector<SongReader::LadspaFXSettings>* pLadspaFX,
+									   bool* pContainsIsTimelineActivated )
+{
+	if ( hash.isEmpty() ) {
+		return nullptr;
+	}
+
+	const QString sCachePath = getCachePath( sSongPath );
+	QFile file( sCachePath );
+	if ( ! file.exists() || ! file.open( QIODevice::ReadOnly ) ) {
+		return nullptr;
+	}
+	const qint64 nSize = file.size();
+	uchar* pData = nSize > 0 ? file.map( 0, nSize ) : nullptr;
+	if ( pData == nullptr ) {
+		return nullptr;
+	}
+
+	// The stream operates directly on the mapped file.
+	const QByteArray data = QByteArray::fromRawData( reinterpret_cast<const char*>( pData ),
+													 static_cast<int>( nSize ) );
+	QDataStream stream( data );
+	stream.setVersion( QDataStream::Qt_5_0 );
+	stream.setFloatingPointPrecision( QDataStream::SinglePrecision );
+
+	quint32 nMagic, nVersion;
+	QByteArray storedHash;
+	stream >> nMagic >> nVersion >> storedHash;
+	if ( stream.status() != QDataStream::Ok || nMagic != nSongCacheMagic ||
+		 nVersion != nSongCacheVersion || storedHash != hash ) {
+		// Outdated snapshots are replaced after parsing the song.
+		return nullptr;
+	}
+
+	QString sName, sAuthor, sNotes, sLicense, sPlaybackTrack, sDrumkitName;
+	float fBpm, fVolume, fMetronomeVolume, fHumanizeTime, fHumanizeVelocity,
+		fSwingFactor, fPlaybackTrackVolume, fPanLawKNorm;
+	qint32 nLoopMode, nPatternMode, nMode, nActionMode, nPanLawType, nLookup;
+	bool bPlaybackTrackEnabled, bIsPatternEditorLocked, bIsTimelineActivated;
+	stream >> sName >> sAuthor >> fBpm >> fVolume >> fMetronomeVolume >> sNotes
+		   >> sLicense >> nLoopMode >> nPatternMode >> nMode
+		   >> fHumanizeTime >> fHumanizeVelocity >> fSwingFactor
+		   >> sPlaybackTrack >> bPlaybackTrackEnabled >> fPlaybackTrackVolume
+		   >> nActionMode >> bIsPatternEditorLocked >> bIsTimelineActivated
+		   >> *pContainsIsTimelineActivated
+		   >> nPanLawType >> fPanLawKNorm >> sDrumkitName >> nLookup;
+
+	auto pSong = std::make_shared<Song>( sName, sAuthor, fBpm, fVolume );
+	pSong->setMetronomeVolume( fMetronomeVolume );
+	pSong->setNotes( sNotes );
+	pSong->setLicense( sLicense );
+	pSong->setLoopMode( static_cast<Song::LoopMode>( nLoopMode ) );
+	pSong->setPatternMode( static_cast<Song::PatternMode>( nPatternMode ) );
+	pSong->setMode( static_cast<Song::Mode>( nMode ) );
+	pSong->setHumanizeTimeValue( fHumanizeTime );
+	pSong->setHumanizeVelocityValue( fHumanizeVelocity );
+	pSong->setSwingFactor( fSwingFactor );
+	pSong->setPlaybackTrackFilename( sPlaybackTrack );
+	pSong->setPlaybackTrackEnabled( bPlaybackTrackEnabled );
+	pSong->setPlaybackTrackVolume( fPlaybackTrackVolume );
+	pSong->setActionMode( static_cast<Song::ActionMode>( nActionMode ) );
+	pSong->setIsPatternEditorLocked( bIsPatternEditorLocked );
+	pSong->setIsTimelineActivated( bIsTimelineActivated );
+	pSong->setPanLawType( nPanLawType );
+	pSong->setPanLawKNorm( fPanLawKNorm );
+	pSong->setCurrentDrumkitName( sDrumkitName );
+	pSong->setCurrentDrumkitLookup( static_cast<Filesystem::Lookup>( nLookup ) );
+
+	quint32 nComponents;
+	stream >> nComponents;
+	for ( quint32 ii = 0; ii < nComponents && stream.status() == QDataStream::Ok; ++ii ) {
+		qint32 nId;
+		QString sComponentName;
+		float fComponentVolume;
+		stream >> nId >> sComponentName >> fComponentVolume;
+		auto pComponent = new DrumkitComponent( nId, sComponentName );
+		pComponent->set_volume( fComponentVolume );
+		pSong->getComponents()->push_back( pComponent );
+	}
+
+	InstrumentList* pInstrumentList = new InstrumentList();
+	pSong->setInstrumentList( pInstrumentList );
+	std::map<int, std::shared_ptr<Instrument>> instruments;
+	std::vector<SampleTask> sampleTasks;
+
+	quint32 nInstruments;
+	stream >> nInstruments;
+	for ( quint32 ii = 0; ii < nInstruments && stream.status() == QDataStream::Ok; ++ii ) {
+		qint32 nId, nMuteGroup, nHihatGrp, nLowerCC, nHigherCC, nSelectionAlg,
+			nMidiOutChannel, nMidiOutNote;
+		QString sInstrumentName, sInstrumentDrumkit;
+		quint32 nAttack, nDecay, nRelease;
+		float fSustain, fInstrumentVolume, fPan, fPitchOffset, fRandomPitchFactor,
+			fFilterCutoff, fFilterResonance, fGain;
+		bool bMuted, bSoloed, bApplyVelocity, bFilterActive, bStopNotes;
+		float fxLevels[ MAX_FX ];
+
+		stream >> nId >> sInstrumentName >> sInstrumentDrumkit
+			   >> nAttack >> nDecay >> fSustain >> nRelease
+			   >> fInstrumentVolume >> bMuted >> bSoloed >> fPan >> bApplyVelocity;
+		for ( int nFX = 0; nFX < MAX_FX; ++nFX ) {
+			stream >> fxLevels[ nFX ];
+		}
+		stream >> fPitchOffset >> fRandomPitchFactor >> bFilterActive >> fFilterCutoff
+			   >> fFilterResonance >> fGain >> nMuteGroup >> bStopNotes >> nHihatGrp
+			   >> nLowerCC >> nHigherCC >> nSelectionAlg >> nMidiOutChannel >> nMidiOutNote;
+
+		auto pInstrument = std::make_shared<Instrument>(
+			nId, sInstrumentName,
+			std::make_shared<ADSR>( nAttack, nDecay, fSustain, nRelease ) );
+		pInstrument->set_drumkit_name( sInstrumentDrumkit );
+		pInstrument->set_volume( fInstrumentVolume );
+		pInstrument->set_muted( bMuted );
+		pInstrument->set_soloed( bSoloed );
+		pInstrument->setPan( fPan );
+		pInstrument->set_apply_velocity( bApplyVelocity );
+		for ( int nFX = 0; nFX < MAX_FX; ++nFX ) {
+			pInstrument->set_fx_level( fxLevels[ nFX ], nFX );
+		}
+		pInstrument->set_pitch_offset( fPitchOffset );
+		pInstrument->set_random_pitch_factor( fRandomPitchFactor );
+		pInstrument->set_filter_active( bFilterActive );
+		pInstrument->set_filter_cutoff( fFilterCutoff );
+		pInstrument->set_filter_resonance( fFilterResonance );
+		pInstrument->set_gain( fGain );
+		pInstrument->set_mute_group( nMuteGroup );
+		pInstrument->set_stop_notes( bStopNotes );
+		pInstrument->set_hihat_grp( nHihatGrp );
+		pInstrument->set_lower_cc( nLowerCC );
+		pInstrument->set_higher_cc( nHigherCC );
+		pInstrument->set_sample_selection_alg(
+			static_cast<Instrument::SampleSelectionAlgo>( nSelectionAlg ) );
+		pInstrument->set_midi_out_channel( nMidiOutChannel );
+		pInstrument->set_midi_out_note( nMidiOutNote );
+
+		quint32 nInstrumentComponents;
+		stream >> nInstrumentComponents;
+		for ( quint32 cc = 0; cc < nInstrumentComponents && stream.status() == QDataStream::Ok; ++cc ) {
+			qint32 nComponentId;
+			float fComponentGain;
+			quint32 nLayers;
+			stream >> nComponentId >> fComponentGain >> nLayers;
+
+			auto pComponent = std::make_shared<InstrumentComponent>( nComponentId );
+			pComponent->set_gain( fComponentGain );
+
+			for ( quint32 ll = 0; ll < nLayers && stream.status() == QDataStream::Ok; ++ll ) {
+				qint32 nLayer;
+				float fStartVelocity, fEndVelocity, fLayerGain, fLayerPitch;
+				bool bHasSample;
+				stream >> nLayer >> fStartVelocity >> fEndVelocity >> fLayerGain
+					   >> fLayerPitch >> bHasSample;
+				if ( nLayer < 0 || nLayer >= InstrumentComponent::getMaxLayers() ) {
+					return nullptr;
+				}
+
+				auto pLayer = std::make_shared<InstrumentLayer>( nullptr );
+				pLayer->set_start_velocity( fStartVelocity );
+				pLayer->set_end_velocity( fEndVelocity );
+				pLayer->set_gain( fLayerGain );
+				pLayer->set_pitch( fLayerPitch );
+				pComponent->set_layer( pLayer, nLayer );
+
+				if ( bHasSample ) {
+					SampleTask task;
+					task.pLayer = pLayer;
+					qint32 nStartFrame, nLoopFrame, nEndFrame, nCount, nLoopMode, nCSettings;
+					stream >> task.sFilepath >> task.bIsModified
+						   >> nStartFrame >> nLoopFrame >> nEndFrame >> nCount >> nLoopMode
+						   >> task.rubberband.use >> task.rubberband.divider
+						   >> task.rubberband.pitch >> nCSettings;
+					task.loops.start_frame = nStartFrame;
+					task.loops.loop_frame = nLoopFrame;
+					task.loops.end_frame = nEndFrame;
+					task.loops.count = nCount;
+					task.loops.mode = static_cast<Sample::Loops::LoopMode>( nLoopMode );
+					task.rubberband.c_settings = nCSettings;
+					task.velocity = readEnvelope( stream );
+					task.pan = readEnvelope( stream );
+					sampleTasks.push_back( task );
+				}
+			}
+			pInstrument->get_components()->push_back( pComponent );
+		}
+
+		pInstrumentList->add( pInstrument );
+		instruments[ nId ] = pInstrument;
+	}
+
+	PatternList* pPatternList = new PatternList();
+	pSong->setPatternList( pPatternList );
+
+	std::vector<PackedNote> notes;
+	quint32 nPatterns;
+	stream >> nPatterns;
+	for ( quint32 ii = 0; ii < nPatterns && stream.status() == QDataStream::Ok; ++ii ) {
+		QString sPatternName, sInfo, sCategory;
+		qint32 nLength, nDenominator;
+		quint32 nNotes;
+		stream >> sPatternName >> sInfo >> sCategory >> nLength >> nDenominator >> nNotes;
+
+		// The note count is taken from the file and must not exceed
+		// what is left of the snapshot before anything is allocated.
+		const qint64 nBytes = static_cast<qint64>( nNotes ) *
+			static_cast<qint64>( sizeof( PackedNote ) );
+		if ( stream.status() != QDataStream::Ok ||
+			 nBytes > stream.device()->bytesAvailable() ) {
+			WARNINGLOG( QString( "Discarding corrupted song cache [%1]" ).arg( sCachePath ) );
+			return nullptr;
+		}
+		notes.resize( nNotes );
+		if ( stream.readRawData( reinterpret_cast<char*>( notes.data() ),
+								 static_cast<int>( nBytes ) ) != nBytes ) {
+			return nullptr;
+		}
+
+		Pattern* pPattern = new Pattern( sPatternName, sInfo, sCategory, nLength, nDenominator );
+		pPatternList->add( pPattern );
+		for ( const auto& packedNote : notes ) {
+			auto it = instruments.find( packedNote.nInstrumentId );
+			if ( it == instruments.end() ) {
+				return nullptr;
+			}
+			Note* pNote = new Note( it->second, packedNote.nPosition, packedNote.fVelocity,
+									packedNote.fPan, packedNote.nLength, packedNote.fPitch );
+			pNote->set_key_octave( static_cast<Note::Key>( packedNote.nKey ),
+								   static_cast<Note::Octave>( packedNote.nOctave ) );
+			pNote->set_lead_lag( packedNote.fLeadLag );
+			pNote->set_note_off( packedNote.nNoteOff != 0 );
+			pNote->set_probability( packedNote.fProbability );
+			pPattern->insert_note( pNote );
+		}
+	}
+
+	for ( quint32 ii = 0; ii < nPatterns && stream.status() == QDataStream::Ok; ++ii ) {
+		quint32 nVirtualPatterns;
+		stream >> nVirtualPatterns;
+		for ( quint32 vv = 0; vv < nVirtualPatterns && stream.status() == QDataStream::Ok; ++vv ) {
+			qint32 nIndex;
+			stream >> nIndex;
+			if ( nIndex < 0 || nIndex >= pPatternList->size() ) {
+				return nullptr;
+			}
+			pPatternList->get( ii )->virtual_patterns_add( pPatternList->get( nIndex ) );
+		}
+	}
+	pPatternList->flattened_virtual_patterns_compute();
+
+	auto pPatternGroupVector = new std::vector<PatternList*>;
+	pSong->setPatternGroupVector( pPatternGroupVector );
+	quint32 nColumns;
+	stream >> nColumns;
+	for ( quint32 ii = 0; ii < nColumns && stream.status() == QDataStream::Ok; ++ii ) {
+		PatternList* pColumn = new PatternList();
+		pPatternGroupVector->push_back( pColumn );
+		quint32 nColumnPatterns;
+		stream >> nColumnPatterns;
+		for ( quint32 pp = 0; pp < nColumnPatterns && stream.status() == QDataStream::Ok; ++pp ) {
+			qint32 nIndex;
+			stream >> nIndex;
+			if ( nIndex < 0 || nIndex >= pPatternList->size() ) {
+				return nullptr;
+			}
+			pColumn->add( pPatternList->get( nIndex ) );
+		}
+	}
+
+	pLadspaFX->clear();
+	quint32 nFX;
+	stream >> nFX;
+	for ( quint32 ii = 0; ii < nFX && stream.status() == QDataStream::Ok; ++ii ) {
+		SongReader::LadspaFXSettings fx;
+		quint32 nPorts;
+		stream >> fx.sName >> fx.sFilename >> fx.bEnabled >> fx.fVolume >> nPorts;
+		for ( quint32 pp = 0; pp < nPorts && stream.status() == QDataStream::Ok; ++pp ) {
+			QString sPortName;
+			float fValue;
+			stream >> sPortName >> fValue;
+			fx.inputControlPorts.push_back( std::make_pair( sPortName, fValue ) );
+		}
+		pLadspaFX->push_back( fx );
+	}
+
+	auto pTimeline = std::make_shared<Timeline>();
+	quint32 nTempoMarkers, nTags;
+	stream >> nTempoMarkers;
+	for ( quint32 ii = 0; ii < nTempoMarkers && stream.status() == QDataStream::Ok; ++ii ) {
+		qint32 nColumn;
+		float fTempo;
+		stream >> nColumn >> fTempo;
+		pTimeline->addTempoMarker( nColumn, fTempo );
+	}
+	stream >> nTags;
+	for ( quint32 ii = 0; ii < nTags && stream.status() == QDataStream::Ok; ++ii ) {
+		qint32 nColumn;
+		QString sTag;
+		stream >> nColumn >> sTag;
+		pTimeline->addTag( nColumn, sTag );
+	}
+	pSong->setTimeline( pTimeline );
+
+	quint32 nPoints;
+	stream >> nPoints;
+	for ( quint32 ii = 0; ii < nPoints && stream.status() == QDataStream::Ok; ++ii ) {
+		float fX, fY;
+		stream >> fX >> fY;
+		pSong->getVelocityAutomationPath()->add_point( fX, fY );
+	}
+
+	stream >> nMagic;
+	if ( stream.status() != QDataStream::Ok || nMagic != nSongCacheMagic ) {
+		WARNINGLOG( QString( "Discarding corrupted song cache [%1]" ).arg( sCachePath ) );
+		return nullptr;
+	}
+
+	// The sample data itself is loaded in parallel. Each worker picks
+	// the next task not yet handled.
+	const int nTasks = sampleTasks.size();
+	std::atomic<int> nNextTask( 0 );
+	std::atomic<bool> bMissingSamples( false );
+	auto worker = [&]() {
+		int nTask;
+		while ( ( nTask = nNextTask.fetch_add( 1 ) ) < nTasks ) {
+			const auto& task = sampleTasks[ nTask ];
+			std::shared_ptr<Sample> pSample;
+			if ( ! task.bIsModified ) {
+				pSample = Sample::load( task.sFilepath );
+			} else {
+				pSample = Sample::load( task.sFilepath, task.loops, task.rubberband,
+										task.velocity, task.pan, fBpm );
+			}
+			if ( pSample == nullptr ) {
+				bMissingSamples = true;
+			}
+			task.pLayer->set_sample( pSample );
+		}
+	};
+
+	const int nThreads = std::min(
+		nTasks, std::max( 1, static_cast<int>( std::thread::hardware_concurrency() ) ) );
+	std::vector<std::thread> workers;
+	for ( int ii = 1; ii < nThreads; ++ii ) {
+		workers.emplace_back( worker );
+	}
+	worker();
+	for ( auto& thread : workers ) {
+		thread.join();
+	}
+
+	if ( bMissingSamples ) {
+		// Parsing the song will take care of muting the affected
+		// instruments.
+		WARNINGLOG( QString( "Samples referenced in song cache [%1] could not be loaded" )
+					.arg( sCachePath ) );
+		return nullptr;
+	}
+
+	INFOLOG( QString( "Song [%1] restored from cache" ).arg( sSongPath ) );
+
+	return pSong;
+}
+
+};
@@ -0,0 +1,100 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+
+#ifndef H2C_SONG_CACHE_H
+#define H2C_SONG_CACHE_H
+
+#include <core/Object.h>
+#include <core/Basics/Song.h>
+
+#include <QByteArray>
+#include <QString>
+
+#include <memory>
+#include <vector>
+
+namespace H2Core
+{
+
+/**
+ * Binary snapshots of songs.
+ *
+ * Parsing a .h2song file is slow for large songs. Instead, the
+ * SongReader stores a compact binary snapshot of each song it read
+ * in Filesystem::cache_dir(). It holds the song properties, the
+ * parameters of all instruments including the references to their
+ * samples, the note arrays of all patterns, the pattern sequence,
+ * the Timeline, and the LADSPA settings.
+ *
+ * The snapshot is read by mapping the file into memory and is only
+ * used in case the hash of the .h2song file matches the one stored
+ * within it. The samples are loaded in parallel.
+ *
+ * Snapshots are not portable and are neither meant to be shared nor
+ * to be edited.
+ */
+/** \ingroup docCore */
+class SongCache : public H2Core::Object<SongCache>
+{
+	H2_OBJECT(SongCache)
+public:
+	/** \return Hash of the content of @a sSongPath or an empty
+	 * array in case the file could not be read.*/
+	static QByteArray hash( const QString& sSongPath );
+
+	/** \return Path of the snapshot of @a sSongPath.*/
+	static QString getCachePath( const QString& sSongPath );
+
+	/**
+	 * Constructs a song from the snapshot of @a sSongPath.
+	 *
+	 * \param sSongPath Path of the .h2song file.
+	 * \param hash Hash of the current content of @a sSongPath.
+	 * \param pLadspaFX Filled with the LADSPA settings of the song.
+	 * \param pContainsIsTimelineActivated Set to whether the
+	 * .h2song file contains the state of the Timeline.
+	 *
+	 * \return nullptr in case there is no snapshot, it is outdated,
+	 * or not all samples could be loaded.
+	 */
+	static std::shared_ptr<Song> load( const QString& sSongPath, const QByteArray& hash,
+									   std::vector<SongReader::LadspaFXSettings>* pLadspaFX,
+									   bool* pContainsIsTimelineActivated );
+
+	/**
+	 * Stores a snapshot of @a pSong, which was just read from
+	 * @a sSongPath.
+	 *
+	 * Songs referencing samples which could not be loaded are not
+	 * stored in order to pick up the samples once they are
+	 * available.
+	 */
+	static bool save( const QString& sSongPath, const QByteArray& hash,
+					  std::shared_ptr<Song> pSong,
+					  const std::vector<SongReader::LadspaFXSettings>& ladspaFX,
+					  bool bContainsIsTimelineActivated );
+};
+
+};
+
+#endif
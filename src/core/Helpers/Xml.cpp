@@ -22,7 +22,9 @@
 
 #include <core/Helpers/Xml.h>
 
+#include <QtCore/QDateTime>
 #include <QtCore/QFile>
+#include <QtCore/QFileInfo>
 #include <QtCore/QLocale>
 #include <QtCore/QString>
 #include <QtCore/QTextStream>
@@ -30,6 +32,9 @@
 #include <QtXmlPatterns/QXmlSchemaValidator>
 #include <QAbstractMessageHandler>
 
+#include <map>
+#include <mutex>
+
 #define XMLNS_BASE "http://www.hydrogen-music.org/"
 #define XMLNS_XSI "http://www.w3.org/2001/XMLSchema-instance"
 
@@ -238,58 +243,96 @@ XMLDoc::XMLDoc( ) { }
 
 bool XMLDoc::read( const QString& filepath, const QString& schemapath, bool bSilent )
 {
-	SilentMessageHandler Handler;
-	QXmlSchema schema;
-	schema.setMessageHandler( &Handler );
-	
-	bool schema_usable = false;
+	QFile file( filepath );
+	if ( !file.open( QIODevice::ReadOnly ) ) {
+		ERRORLOG( QString( "Unable to open %1 for reading" ).arg( filepath ) );
+		return false;
+	}
+	// The file is read only once and both the validation and the
+	// parsing are done on the very same buffer.
+	const QByteArray content = file.readAll();
+	file.close();
+
+	if ( schemapath != nullptr &&
+		 ! validate( filepath, content, schemapath, bSilent ) ) {
+		return false;
+	}
 	
-	if( schemapath!=nullptr ) {
-		QFile file( schemapath );
-		if ( !file.open( QIODevice::ReadOnly ) ) {
-			ERRORLOG( QString( "Unable to open XML schema %1 for reading" ).arg( schemapath ) );
-		} else {
-			schema.load( &file, QUrl::fromLocalFile( file.fileName() ) );
-			file.close();
-			if ( schema.isValid() ) {
-				schema_usable = true;
-			} else {
-				ERRORLOG( QString( "%2 XML schema is not valid" ).arg( schemapath ) );
-			}
-		}
+	if( !setContent( content ) ) {
+		ERRORLOG( QString( "Unable to read XML document %1" ).arg( filepath ) );
+		return false;
 	}
 	
+	return true;
+}
+
+bool XMLDoc::validate( const QString& filepath, const QString& schemapath, bool bSilent )
+{
 	QFile file( filepath );
 	if ( !file.open( QIODevice::ReadOnly ) ) {
 		ERRORLOG( QString( "Unable to open %1 for reading" ).arg( filepath ) );
 		return false;
 	}
-	
-	if ( schema_usable ) {
-		QXmlSchemaValidator validator( schema );
-		if ( !validator.validate( &file, QUrl::fromLocalFile( file.fileName() ) ) ) {
-			WARNINGLOG( QString( "XML document %1 is not valid (%2), loading may fail" ).arg( filepath ).arg( schemapath ) );
-			file.close();
-			return false;
-		} else {
-			if ( ! bSilent ) {
-				INFOLOG( QString( "XML document %1 is valid (%2)" )
-						 .arg( filepath ).arg( schemapath ) );
-			}
+	const QByteArray content = file.readAll();
+	file.close();
+
+	return validate( filepath, content, schemapath, bSilent );
+}
+
+bool XMLDoc::validate( const QString& filepath, const QByteArray& content,
+					   const QString& schemapath, bool bSilent )
+{
+	struct ValidationResult {
+		qint64 nSize;
+		QDateTime lastModified;
+		bool bValid;
+	};
+	static std::mutex mutex;
+	static std::map<QString, ValidationResult> cache;
+
+	const QFileInfo info( filepath );
+	const QString sKey = info.absoluteFilePath() + "|" + schemapath;
+	{
+		std::lock_guard<std::mutex> lock( mutex );
+		const auto it = cache.find( sKey );
+		if ( it != cache.end() &&
+			 it->second.nSize == info.size() &&
+			 it->second.lastModified == info.lastModified() ) {
+			return it->second.bValid;
 		}
-		file.seek( 0 );
-	} else {
-		WARNINGLOG( "Unable to validate drumkit XML using schema file." );
 	}
+
+	SilentMessageHandler Handler;
+	QXmlSchema schema;
+	schema.setMessageHandler( &Handler );
 	
-	if( !setContent( &file ) ) {
-		ERRORLOG( QString( "Unable to read XML document %1" ).arg( filepath ) );
-		file.close();
-		return false;
+	QFile schemaFile( schemapath );
+	if ( !schemaFile.open( QIODevice::ReadOnly ) ) {
+		ERRORLOG( QString( "Unable to open XML schema %1 for reading" ).arg( schemapath ) );
+		WARNINGLOG( "Unable to validate drumkit XML using schema file." );
+		return true;
 	}
-	file.close();
+	schema.load( &schemaFile, QUrl::fromLocalFile( schemaFile.fileName() ) );
+	schemaFile.close();
+	if ( ! schema.isValid() ) {
+		ERRORLOG( QString( "%2 XML schema is not valid" ).arg( schemapath ) );
+		WARNINGLOG( "Unable to validate drumkit XML using schema file." );
+		return true;
+	}
+
+	QXmlSchemaValidator validator( schema );
+	const bool bValid = validator.validate( content, QUrl::fromLocalFile( filepath ) );
+	if ( ! bValid ) {
+		WARNINGLOG( QString( "XML document %1 is not valid (%2), loading may fail" ).arg( filepath ).arg( schemapath ) );
+	} else if ( ! bSilent ) {
+		INFOLOG( QString( "XML document %1 is valid (%2)" )
+				 .arg( filepath ).arg( schemapath ) );
+	}
+
+	std::lock_guard<std::mutex> lock( mutex );
+	cache[ sKey ] = { info.size(), info.lastModified(), bValid };
 	
-	return true;
+	return bValid;
 }
 
 bool XMLDoc::write( const QString& filepath )
@@ -327,4 +370,133 @@ XMLNode XMLDoc::set_root( const QString& node_name, const QString& xmlns )
 	return root;
 }
 
+XMLStreamReader::XMLStreamReader()
+	: m_nProperties( 0 )
+{
+}
+
+bool XMLStreamReader::open( const QString& filepath )
+{
+	QFile file( filepath );
+	if ( !file.open( QIODevice::ReadOnly ) ) {
+		ERRORLOG( QString( "Unable to open %1 for reading" ).arg( filepath ) );
+		return false;
+	}
+	m_content = file.readAll();
+	file.close();
+
+	clear();
+	addData( m_content );
+	m_nProperties = 0;
+
+	return true;
+}
+
+void XMLStreamReader::read_properties()
+{
+	m_nProperties = 0;
+
+	while ( readNextStartElement() ) {
+		const QStringRef name = QXmlStreamReader::name();
+		if ( m_nProperties == static_cast<int>( m_properties.size() ) ) {
+			m_properties.emplace_back( name.toString(), QString() );
+		}
+		else if ( m_properties[ m_nProperties ].first != name ) {
+			// Children of uniform elements, like the notes of a
+			// pattern, are almost always written in the same
+			// order. Only allocate a new name if this is not the
+			// case.
+			m_properties[ m_nProperties ].first = name.toString();
+		}
+		m_properties[ m_nProperties ].second =
+			readElementText( QXmlStreamReader::SkipChildElements );
+		++m_nProperties;
+	}
+}
+
+const QString* XMLStreamReader::find_property( const QString& node ) const
+{
+	for ( int ii = 0; ii < m_nProperties; ++ii ) {
+		if ( m_properties[ ii ].first == node ) {
+			if ( m_properties[ ii ].second.isEmpty() ) {
+				return nullptr;
+			}
+			return &m_properties[ ii ].second;
+		}
+	}
+	return nullptr;
+}
+
+QString XMLStreamReader::read_string( const QString& node, const QString& default_value, bool* pFound ) const
+{
+	const QString* pValue = find_property( node );
+	if ( pFound != nullptr ) {
+		*pFound = pValue != nullptr;
+	}
+	if ( pValue == nullptr ) {
+		return default_value;
+	}
+	return *pValue;
+}
+
+int XMLStreamReader::read_int( const QString& node, int default_value, bool* pFound ) const
+{
+	const QString* pValue = find_property( node );
+	if ( pFound != nullptr ) {
+		*pFound = pValue != nullptr;
+	}
+	if ( pValue == nullptr ) {
+		return default_value;
+	}
+	return QLocale::c().toInt( *pValue );
+}
+
+float XMLStreamReader::read_float( const QString& node, float default_value, bool* pFound ) const
+{
+	const QString* pValue = find_property( node );
+	if ( pFound != nullptr ) {
+		*pFound = pValue != nullptr;
+	}
+	if ( pValue == nullptr ) {
+		return default_value;
+	}
+	return QLocale::c().toFloat( *pValue );
+}
+
+bool XMLStreamReader::read_bool( const QString& node, bool default_value, bool* pFound ) const
+{
+	const QString* pValue = find_property( node );
+	if ( pFound != nullptr ) {
+		*pFound = pValue != nullptr;
+	}
+	if ( pValue == nullptr ) {
+		return default_value;
+	}
+	return *pValue == "true";
+}
+
+XMLNode XMLStreamReader::readNode( QDomDocument* pDoc )
+{
+	QDomElement element = pDoc->createElement( name().toString() );
+	for ( const auto& attribute : attributes() ) {
+		element.setAttribute( attribute.name().toString(),
+							  attribute.value().toString() );
+	}
+
+	while ( ! atEnd() ) {
+		const auto token = readNext();
+		if ( token == QXmlStreamReader::StartElement ) {
+			element.appendChild( readNode( pDoc ) );
+		}
+		else if ( token == QXmlStreamReader::Characters && ! isWhitespace() ) {
+			element.appendChild( pDoc->createTextNode( text().toString() ) );
+		}
+		else if ( token == QXmlStreamReader::EndElement ) {
+			break;
+		}
+	}
+
+	return XMLNode( element );
+}
+
 };
@@ -25,8 +25,12 @@
 
 #include <core/Object.h>
 #include <QtCore/QString>
+#include <QtCore/QXmlStreamReader>
 #include <QtXml/QDomDocument>
 
+#include <utility>
+#include <vector>
+
 namespace H2Core
 {
 
@@ -178,6 +182,23 @@ class XMLDoc : public H2Core::Object<XMLDoc>, public QDomDocument
 		 * when anomalies are encountered while reading the XML nodes.
 		 */
 	bool read( const QString& filepath, const QString& schemapath=nullptr, bool bSilent = false );
+		/**
+		 * Validates an xml file against an XML Schema without parsing
+		 * it into a DOM.
+		 *
+		 * Validation is expensive. Therefore, the result is cached
+		 * using the path, size, and time of the last modification
+		 * of @a filepath and a file is only validated again once it
+		 * was altered.
+		 *
+		 * \param filepath the path to the file to validate
+		 * \param schemapath the path to the XML Schema file
+		 * \param bSilent Whether debug and info messages should be logged
+		 *
+		 * \return false if the file is not valid. In case the schema
+		 * itself could not be loaded, true is returned.
+		 */
+		static bool validate( const QString& filepath, const QString& schemapath, bool bSilent = false );
 		/**
 		 * write itself into a file
 		 * \param filepath the path to the file to write to
@@ -189,6 +210,78 @@ class XMLDoc : public H2Core::Object<XMLDoc>, public QDomDocument
 		 * \param xmlns the xml namespace prefix to add after XMLNS_BASE
 		 */
 		XMLNode set_root( const QString& node_name, const QString& xmlns = nullptr );
+
+	private:
+		static bool validate( const QString& filepath, const QByteArray& content,
+							  const QString& schemapath, bool bSilent );
+};
+
+/**
+ * XMLStreamReader is a forward-only reader for xml files based on
+ * QXmlStreamReader.
+ *
+ * In contrast to XMLDoc it reads the file only once, does not
+ * perform any schema validation, and does not build a DOM of the
+ * whole document. Elements with lots of uniform children - like the
+ * notes of a pattern - are meant to be read directly into the
+ * corresponding objects. The remaining, small parts of a document
+ * can be converted using readNode() and passed to the existing
+ * XMLNode based loading code.
+ *
+ * The text of all children of a flat element, like \<note\>, is
+ * read at once using read_properties() and can afterwards be
+ * accessed using the read_* methods.
+ */
+/** \ingroup docCore*/
+class XMLStreamReader : public H2Core::Object<XMLStreamReader>, public QXmlStreamReader
+{
+		H2_OBJECT(XMLStreamReader)
+	public:
+		XMLStreamReader();
+
+		/**
+		 * Reads the content of an xml file into memory.
+		 * \param filepath the path to the file to read from
+		 */
+		bool open( const QString& filepath );
+
+		/**
+		 * Reads the text of all children of the current element. The
+		 * reader is positioned at the end of the current element
+		 * afterwards. Nested elements are skipped.
+		 */
+		void read_properties();
+
+		/**
+		 * reads a string read using read_properties()
+		 * \param node the name of the child node
+		 * \param default_value the value returned if the child node is either
+		 * missing or empty
+		 * \param pFound if not nullptr, set to whether the child node was present
+		 */
+		QString read_string( const QString& node, const QString& default_value, bool* pFound = nullptr ) const;
+		int read_int( const QString& node, int default_value, bool* pFound = nullptr ) const;
+		float read_float( const QString& node, float default_value, bool* pFound = nullptr ) const;
+		bool read_bool( const QString& node, bool default_value, bool* pFound = nullptr ) const;
+
+		/**
+		 * Converts the current element including all its children
+		 * into a node of @a pDoc. The reader is positioned at the end
+		 * of the element afterwards.
+		 */
+		XMLNode readNode( QDomDocument* pDoc );
+
+	private:
+		/** \return the text stored for @a node or nullptr if either
+		 * missing or empty.*/
+		const QString* find_property( const QString& node ) const;
+
+		QByteArray m_content;
+		/** Name and text of the children read by
+		 * read_properties(). The strings are reused for all
+		 * subsequent elements to avoid allocations.*/
+		std::vector<std::pair<QString, QString>> m_properties;
+		int m_nProperties;
 };
 
 };
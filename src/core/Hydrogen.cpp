@@ -42,11 +42,14 @@
 
 #include <QtCore/QMutex>
 #include <QtCore/QMutexLocker>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 
 #include <core/EventQueue.h>
 #include <core/Basics/Adsr.h>
 #include <core/Basics/Drumkit.h>
 #include <core/Basics/DrumkitComponent.h>
+#include <core/Basics/DrumkitSampleLoader.h>
 #include <core/H2Exception.h>
 #include <core/AudioEngine/AudioEngine.h>
 #include <core/AudioEngine/TransportInfo.h>
@@ -62,6 +65,7 @@
 #include <core/Basics/PatternList.h>
 #include <core/Basics/Note.h>
 #include <core/Helpers/Filesystem.h>
+#include <core/Helpers/DrumkitIndex.h>
 #include <core/FX/LadspaFX.h>
 #include <core/FX/Effects.h>
 
@@ -180,6 +184,7 @@ void Hydrogen::create_instance()
 	Preferences::create_instance();
 	EventQueue::create_instance();
 	MidiActionManager::create_instance();
+	DrumkitIndex::create_instance();
 
 #ifdef H2CORE_HAVE_OSC
 	NsmClient::create_instance();
@@ -345,7 +350,9 @@ void Hydrogen::addRealtimeNote(	int		nInstrument,
 								float	fVelocity,
 								float	fPan,
 								bool	bNoteOff,
-								int		nNote )
+								int		nNote,
+								long long	nTimestamp,
+								long long	nJackFrameTime )
 {
 	
 	AudioEngine* pAudioEngine = m_pAudioEngine;
@@ -573,7 +580,16 @@ void Hydrogen::addRealtimeNote(	int		nInstrument,
 	}
 
 
-	// Play back the note.
+	// Play back the note. Only notes carrying timing information
+	// get a fixed start. All others are placed by
+	// Note::computeNoteStart().
+	const bool bFixedNoteStart = nTimestamp != 0 || nJackFrameTime >= 0;
+	long long nNoteStart = 0;
+	if ( bFixedNoteStart ) {
+		nNoteStart = pAudioEngine->computeFrameFromMidiTimestamp( nTimestamp,
+																  nJackFrameTime );
+	}
+
 	if ( bPlaySelectedInstrument ) {
 		if ( bNoteOff ) {
 			if ( pAudioEngine->getSampler()->isInstrumentPlaying( pInstr ) ) {
@@ -581,27 +597,44 @@ void Hydrogen::addRealtimeNote(	int		nInstrument,
 			}
 		}
 		else { // note on
-			Note *pNote2 = new Note( pInstr, nRealColumn, fVelocity, fPan, -1, 0 );
-
-			int divider = nNote / 12;
-			Note::Octave octave = (Note::Octave)(divider -3);
-			Note::Key notehigh = (Note::Key)(nNote - (12 * divider));
+			Note *pNote2 = pAudioEngine->getNotePool()->
+				create( pInstr, nRealColumn, fVelocity, fPan, -1, 0 );
+			if ( pNote2 != nullptr ) {
+				int divider = nNote / 12;
+				Note::Octave octave = (Note::Octave)(divider -3);
+				Note::Key notehigh = (Note::Key)(nNote - (12 * divider));
 
-			pNote2->set_midi_info( notehigh, octave, nNote );
-			midi_noteOn( pNote2 );
+				pNote2->set_midi_info( notehigh, octave, nNote );
+				if ( bFixedNoteStart ) {
+					pNote2->setNoteStart( nNoteStart );
+				}
+				midi_noteOn( pNote2 );
+			}
 		}
 	}
 	else {
 		if ( bNoteOff ) {
 			if ( pAudioEngine->getSampler()->isInstrumentPlaying( pInstr ) ) {
-				Note *pNoteOff = new Note( pInstr, 0.0, 0.0, 0.0, -1, 0 );
-				pNoteOff->set_note_off( true );
-				midi_noteOn( pNoteOff );
+				Note *pNoteOff = pAudioEngine->getNotePool()->
+					create( pInstr, 0.0, 0.0, 0.0, -1, 0 );
+				if ( pNoteOff != nullptr ) {
+					pNoteOff->set_note_off( true );
+					if ( bFixedNoteStart ) {
+						pNoteOff->setNoteStart( nNoteStart );
+					}
+					midi_noteOn( pNoteOff );
+				}
 			}
 		}
 		else { // note on
-			Note *pNote2 = new Note( pInstr, nRealColumn, fVelocity, fPan, -1, 0 );
-			midi_noteOn( pNote2 );
+			Note *pNote2 = pAudioEngine->getNotePool()->
+				create( pInstr, nRealColumn, fVelocity, fPan, -1, 0 );
+			if ( pNote2 != nullptr ) {
+				if ( bFixedNoteStart ) {
+					pNote2->setNoteStart( nNoteStart );
+				}
+				midi_noteOn( pNote2 );
+			}
 		}
 	}
 
@@ -681,18 +714,87 @@ bool Hydrogen::startExportSession( int nSampleRate, int nSampleDepth )
 }
 
 /// Export a song to a wav file
-void Hydrogen::startExportSong( const QString& filename)
+void Hydrogen::startExportSong( const QString& filename,
+								const std::vector<DiskWriterDriver::Stem>& stems )
 {
 	AudioEngine* pAudioEngine = m_pAudioEngine;
 	getCoreActionController()->locateToTick( 0 );
 	pAudioEngine->play();
 	pAudioEngine->getSampler()->stopPlayingNotes();
 
+	// Instruments not armed for export are muted in the Sampler.
+	InstrumentList* pInstrumentList = getSong()->getInstrumentList();
+	for ( const auto& stem : stems ) {
+		auto pInstrument = pInstrumentList->find( stem.nInstrumentId );
+		if ( pInstrument != nullptr ) {
+			pInstrument->set_currently_exported( true );
+		}
+	}
+
 	DiskWriterDriver* pDiskWriterDriver = static_cast<DiskWriterDriver*>(pAudioEngine->getAudioDriver());
 	pDiskWriterDriver->setFileName( filename );
+
+	pAudioEngine->lock( RIGHT_HERE );
+	pDiskWriterDriver->setStems( stems );
+	pAudioEngine->getSampler()->setStemOutputs( pDiskWriterDriver->getStemOutputs() );
+	pAudioEngine->unlock();
+
 	pDiskWriterDriver->write();
 }
 
+std::vector<DiskWriterDriver::Stem> Hydrogen::getExportStems( const QString& sFilename ) const
+{
+	std::vector<DiskWriterDriver::Stem> stems;
+
+	std::shared_ptr<Song> pSong = getSong();
+	if ( pSong == nullptr ) {
+		return stems;
+	}
+	InstrumentList* pInstrumentList = pSong->getInstrumentList();
+	PatternList* pPatternList = pSong->getPatternList();
+
+	QFileInfo fileInfo( sFilename );
+	const QString sBaseName = fileInfo.dir().filePath( fileInfo.completeBaseName() );
+
+	for ( int ii = 0; ii < pInstrumentList->size(); ++ii ) {
+		auto pInstrument = pInstrumentList->get( ii );
+
+		bool bHasNotes = false;
+		for ( int nPattern = 0; nPattern < pPatternList->size() && ! bHasNotes; ++nPattern ) {
+			const Pattern::notes_t* pNotes = pPatternList->get( nPattern )->get_notes();
+			FOREACH_NOTE_CST_IT_BEGIN_END( pNotes, it ) {
+				if ( it->second->get_instrument()->get_id() == pInstrument->get_id() ) {
+					bHasNotes = true;
+					break;
+				}
+			}
+		}
+		if ( ! bHasNotes ) {
+			continue;
+		}
+
+		int nOccurrences = 0;
+		for ( int nOther = 0; nOther < pInstrumentList->size(); ++nOther ) {
+			if ( pInstrumentList->get( nOther )->get_name() == pInstrument->get_name() ) {
+				++nOccurrences;
+			}
+		}
+
+		QString sName = pInstrument->get_name();
+		if ( nOccurrences > 1 ) {
+			sName.append( QString( "_%1" ).arg( pInstrument->get_id() ) );
+		}
+
+		DiskWriterDriver::Stem stem;
+		stem.nInstrumentId = pInstrument->get_id();
+		stem.sFilename = QString( "%1-%2.%3" )
+			.arg( sBaseName ).arg( sName ).arg( fileInfo.suffix() );
+		stems.push_back( stem );
+	}
+
+	return stems;
+}
+
 void Hydrogen::stopExportSong()
 {
 	AudioEngine* pAudioEngine = m_pAudioEngine;
@@ -711,6 +813,11 @@ void Hydrogen::stopExportSession()
 	}
 	
 	AudioEngine* pAudioEngine = m_pAudioEngine;
+
+	// The stem buffers are owned by the DiskWriterDriver.
+	pAudioEngine->lock( RIGHT_HERE );
+	pAudioEngine->getSampler()->setStemOutputs( {} );
+	pAudioEngine->unlock();
 	
  	pAudioEngine->restartAudioDrivers();
 	if ( pAudioEngine->getAudioDriver() == nullptr ) {
@@ -737,7 +844,8 @@ MidiOutput* Hydrogen::getMidiOutput() const
 }
 
 
-int Hydrogen::loadDrumkit( Drumkit *pDrumkitInfo, bool bConditional )
+int Hydrogen::loadDrumkit( Drumkit *pDrumkitInfo, bool bConditional,
+						   DrumkitSampleLoader* pLoader )
 {
 	assert ( pDrumkitInfo );
 	auto pSong = getSong();
@@ -747,9 +855,20 @@ int Hydrogen::loadDrumkit( Drumkit *pDrumkitInfo, bool bConditional )
 
 		INFOLOG( pDrumkitInfo->get_name() );
 
+		// Reading the samples from disk takes by far the most time
+		// and is done in parallel without holding the lock of the
+		// audio engine. This way playback continues while switching
+		// drumkits.
+		std::unique_ptr<DrumkitSampleLoader> pOwnLoader;
+		if ( pLoader == nullptr ) {
+			pOwnLoader = std::make_unique<DrumkitSampleLoader>( pDrumkitInfo );
+			pOwnLoader->load();
+			pLoader = pOwnLoader.get();
+		}
+
 		m_pAudioEngine->lock( RIGHT_HERE );
 		
-		pSong->loadDrumkit( pDrumkitInfo, bConditional );
+		pSong->loadDrumkit( pDrumkitInfo, bConditional, pLoader );
 		if ( m_nSelectedInstrumentNumber >=
 			 pSong->getInstrumentList()->size() ) {
 			setSelectedInstrumentNumber( std::max( 0, pSong->getInstrumentList()->size() -1 ) );
@@ -757,6 +876,11 @@ int Hydrogen::loadDrumkit( Drumkit *pDrumkitInfo, bool bConditional )
 
 		renameJackPorts( getSong() );
 		m_pAudioEngine->unlock();
+
+		// The samples of the new kit are streamed depending on the
+		// current preferences. The ones replaced might have been the
+		// last streamed ones.
+		m_pAudioEngine->getSampler()->updateSamplePrefetcher();
 	
 		m_pCoreActionController->initExternalControlInterfaces();
 
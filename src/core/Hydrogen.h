@@ -28,6 +28,7 @@
 #include <core/Object.h>
 #include <core/Timeline.h>
 #include <core/IO/AudioOutput.h>
+#include <core/IO/DiskWriterDriver.h>
 #include <core/IO/MidiInput.h>
 #include <core/IO/MidiOutput.h>
 #include <core/IO/JackAudioDriver.h>
@@ -45,6 +46,7 @@ namespace H2Core
 {
 	class CoreActionController;
 	class AudioEngine;
+	class DrumkitSampleLoader;
 ///
 /// Hydrogen Audio Engine.
 ///
@@ -194,11 +196,26 @@ public:
 
 	void updateSongSize();
 
+		/**
+		 * Plays back and optionally records a note triggered in
+		 * realtime, e.g. via MIDI or the virtual keyboard.
+		 *
+		 * \param nTimestamp Point in time the note was triggered as
+		 * provided by MidiMessage::m_nTimestamp. If non-zero, the
+		 * note starts at the corresponding frame (see
+		 * AudioEngine::computeFrameFromMidiTimestamp()) instead of
+		 * the beginning of the next processing cycle.
+		 * \param nJackFrameTime JACK frame time the note was
+		 * triggered at as provided by
+		 * MidiMessage::m_nJackFrameTime or -1.
+		 */
 		void			addRealtimeNote ( int instrument,
 							  float velocity,
 							  float fPan = 0.0f,
 							  bool noteoff=false,
-							  int msg1=0 );
+							  int msg1=0,
+							  long long nTimestamp = 0,
+							  long long nJackFrameTime = -1 );
 
 		void			restartDrivers();
 
@@ -223,13 +240,25 @@ public:
 		 * name "drumkit" in the folder
 		 * NsmClient::m_sSessionFolderPath.
 		 *
+		 * The samples of @a pDrumkitInfo are loaded in parallel
+		 * using a DrumkitSampleLoader before the audio engine gets
+		 * locked, so playback is not interrupted.
+		 *
 		 * \param pDrumkit Full-fledged H2Core::Drumkit to load.
 		 * \param bConditional Whether to remove all redundant
 		 * H2Core::Instrument regardless of their content.
+		 * \param pLoader Loader for @a pDrumkit on which
+		 * DrumkitSampleLoader::load() was already called. This
+		 * allows callers to load the samples in a separate thread
+		 * while their own one stays responsive, e.g. to show the
+		 * progress. If nullptr, the samples are loaded within this
+		 * function and the calling thread is blocked until they are
+		 * done.
 		 *
 		 * \returns 0 on success.
 		 */
-		int			loadDrumkit( Drumkit* pDrumkit, bool bConditional = true );
+		int			loadDrumkit( Drumkit* pDrumkit, bool bConditional = true,
+								 DrumkitSampleLoader* pLoader = nullptr );
 
 		/** Test if an Instrument has some Note in the Pattern (used to
 		    test before deleting an Instrument)*/
@@ -312,7 +341,12 @@ void			previewSample( Sample *pSample );
 		 * port number. 
 		 */
 		OSC_CANNOT_CONNECT_TO_PORT,
-		PLAYBACK_TRACK_INVALID
+		PLAYBACK_TRACK_INVALID,
+		/**
+		 * Unable to open one of the files of a song export in
+		 * the DiskWriterDriver.
+		 */
+		EXPORT_CANNOT_OPEN_FILE
 	};
 
 	void			onTapTempoAccelEvent();
@@ -382,8 +416,26 @@ void			previewSample( Sample *pSample );
 	/** \return true on success.*/
 	bool			startExportSession( int rate, int depth );
 	void			stopExportSession();
-	void			startExportSong( const QString& filename );
+	/**
+	 * Exports the song to @a filename and each instrument listed in
+	 * @a stems to a separate file.
+	 *
+	 * All files are written while rendering the song only once. A
+	 * stem holds the signal its instrument contributes to the main
+	 * mix, without the sends to the LADSPA effects. If @a filename
+	 * is empty, only the stems are written.
+	 */
+	void			startExportSong( const QString& filename,
+									 const std::vector<DiskWriterDriver::Stem>& stems = {} );
 	void			stopExportSong();
+	/**
+	 * \return One stem for each instrument of the current song
+	 * having notes. The name of its file is @a sFilename with a dash
+	 * and the name of the instrument appended to the base name. In
+	 * case several instruments share a name, their id is appended
+	 * as well.
+	 */
+	std::vector<DiskWriterDriver::Stem> getExportStems( const QString& sFilename ) const;
 	
 	CoreActionController* 	getCoreActionController() const;
 
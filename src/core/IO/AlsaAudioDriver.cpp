@@ -25,32 +25,136 @@
 #if defined(H2CORE_HAVE_ALSA) || _DOXYGEN_
 
 #include <pthread.h>
-#include <iostream>
+#include <core/AudioEngine/AudioEngine.h>
 #include <core/Preferences/Preferences.h>
 #include <core/EventQueue.h>
+#include <core/Hydrogen.h>
 
 namespace H2Core
 {
 
 pthread_t alsaAudioDriverThread;
 
-static int alsa_xrun_recovery( snd_pcm_t *handle, int err )
+/** Handles a negative return value of the ALSA API used in the
+ * process loop and reports the xrun. */
+static void alsa_handle_xrun( AlsaAudioDriver* pDriver, int err )
 {
-	if ( err == -EPIPE ) {  /* under-run */
-		err = snd_pcm_prepare( handle );
-	} else if ( err == -ESTRPIPE ) {
-		while ( ( err = snd_pcm_resume( handle ) ) == -EAGAIN ) {
-			sleep( 1 );     /* wait until the suspend flag is released */
+	pDriver->m_nXRuns++;
+	Hydrogen::get_instance()->getAudioEngine()->getDspProfiler()->reportDriverXrun();
+	EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
+
+	if ( ( err = snd_pcm_recover( pDriver->m_pPlayback_handle, err, 1 ) ) < 0 ) {
+		___ERRORLOG( QString( "Can't recover from XRUN: %1" )
+					 .arg( snd_strerror( err ) ) );
+	}
+}
+
+/**
+ * Waits till there is room for @a nFrames in the buffer of the
+ * playback stream. The stream is started as soon as the buffer was
+ * filled completely.
+ *
+ * \return false in case the stream is not ready (yet).
+ */
+static bool alsa_wait_for_room( AlsaAudioDriver* pDriver, snd_pcm_uframes_t nFrames )
+{
+	snd_pcm_t* pHandle = pDriver->m_pPlayback_handle;
+	const int nTimeoutInMilliseconds = 100;
+	int err;
+
+	while ( pDriver->m_bIsRunning ) {
+		const snd_pcm_sframes_t nAvail = snd_pcm_avail_update( pHandle );
+		if ( nAvail < 0 ) {
+			alsa_handle_xrun( pDriver, nAvail );
+			return false;
 		}
-		if ( err < 0 ) {
-			err = snd_pcm_prepare( handle );
-			if ( err < 0 ) {
-				std::cerr << "Can't recover from suspend, prepare failed: " << snd_strerror( err ) << std::endl;
+		if ( static_cast<snd_pcm_uframes_t>(nAvail) >= nFrames ) {
+			return true;
+		}
+
+		if ( snd_pcm_state( pHandle ) == SND_PCM_STATE_PREPARED ) {
+			// Buffer is filled. In mmap mode the stream is not
+			// started automatically.
+			if ( ( err = snd_pcm_start( pHandle ) ) < 0 ) {
+				alsa_handle_xrun( pDriver, err );
+				return false;
+			}
+			continue;
+		}
+
+		// Check whether the playback stream is ready to process
+		// input. We do not block forever since this would prevent the
+		// audio driver to be stopped and thus prevents the user from
+		// selecting a different/working version.
+		if ( ( err = snd_pcm_wait( pHandle, nTimeoutInMilliseconds ) ) < 1 ) {
+			if ( err == 0 ) {
+				___ERRORLOG( QString( "timeout after [%1] milliseconds" )
+							 .arg( nTimeoutInMilliseconds ) );
+				pDriver->m_nXRuns++;
+				EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
+			} else {
+				___ERRORLOG( QString( "Error while waiting for playback stream: %1" )
+							 .arg( snd_strerror( err ) ) );
+				alsa_handle_xrun( pDriver, err );
 			}
+			return false;
 		}
-		return 0;
 	}
-	return err;
+
+	return false;
+}
+
+/** Converts the output buffers of @a pDriver directly into the
+ * memory-mapped ring buffer of the device. */
+static void alsa_write_mmap( AlsaAudioDriver* pDriver, snd_pcm_uframes_t nFrames )
+{
+	snd_pcm_t* pHandle = pDriver->m_pPlayback_handle;
+	const snd_pcm_channel_area_t* pAreas;
+	snd_pcm_uframes_t nOffset, nWritten = 0;
+	int err;
+
+	while ( nWritten < nFrames ) {
+		// The area might wrap around the end of the ring buffer. In
+		// this case fewer frames than requested are provided.
+		snd_pcm_uframes_t nChunk = nFrames - nWritten;
+		if ( ( err = snd_pcm_mmap_begin( pHandle, &pAreas, &nOffset, &nChunk ) ) < 0 ) {
+			alsa_handle_xrun( pDriver, err );
+			return;
+		}
+
+		// Interleaved access: all channels share the same area
+		// with a step of a whole frame.
+		uint8_t* pDst = static_cast<uint8_t*>( pAreas[ 0 ].addr ) +
+			pAreas[ 0 ].first / 8 + nOffset * ( pAreas[ 0 ].step / 8 );
+		SampleConversion::interleave( pDriver->m_sampleFormat,
+									  pDriver->m_pOut_L + nWritten,
+									  pDriver->m_pOut_R + nWritten,
+									  pDst, nChunk );
+
+		const snd_pcm_sframes_t nCommitted =
+			snd_pcm_mmap_commit( pHandle, nOffset, nChunk );
+		if ( nCommitted < 0 ||
+			 static_cast<snd_pcm_uframes_t>(nCommitted) != nChunk ) {
+			alsa_handle_xrun( pDriver, nCommitted >= 0 ? -EPIPE : nCommitted );
+			return;
+		}
+		nWritten += nChunk;
+	}
+}
+
+static void alsa_write_rw( AlsaAudioDriver* pDriver, snd_pcm_uframes_t nFrames )
+{
+	snd_pcm_t* pHandle = pDriver->m_pPlayback_handle;
+	SampleConversion::interleave( pDriver->m_sampleFormat,
+								  pDriver->m_pOut_L, pDriver->m_pOut_R,
+								  pDriver->m_pInterleavedBuffer, nFrames );
+
+	snd_pcm_sframes_t err;
+	if ( ( err = snd_pcm_writei( pHandle, pDriver->m_pInterleavedBuffer, nFrames ) ) < 0 ) {
+		___ERRORLOG( QString( "Error while writing playback stream: %1" )
+					 .arg( snd_strerror( err ) ) );
+		alsa_handle_xrun( pDriver, err );
+	}
 }
 
 void* alsaAudioDriver_processCaller( void* param )
@@ -68,80 +172,36 @@ void* alsaAudioDriver_processCaller( void* param )
 	}
 	__INFOLOG( QString( "Scheduling priority = %1" ).arg( sched.sched_priority ) );
 
-	sleep( 1 );
-
 	int err;
 	if ( ( err = snd_pcm_prepare( pDriver->m_pPlayback_handle ) ) < 0 ) {
 		__ERRORLOG( QString( "Cannot prepare audio interface for use: %1" )
 					.arg( snd_strerror ( err ) ) );
 	}
 
-	int nFrames = pDriver->m_nBufferSize;
+	const snd_pcm_uframes_t nFrames = pDriver->m_nBufferSize;
 	__INFOLOG( QString( "nFrames: %1" ).arg( nFrames ) );
-	short pBuffer[ nFrames * 2 ];
-
-	float *pOut_L = pDriver->m_pOut_L;
-	float *pOut_R = pDriver->m_pOut_R;
-
-	int nTimeoutInMilliseconds = 100;
 
 	while ( pDriver->m_bIsRunning ) {
+		// Rendering the audio only after there is room for it in the
+		// buffer of the device keeps the latency as small as
+		// possible.
+		if ( ! alsa_wait_for_room( pDriver, nFrames ) ) {
+			continue;
+		}
+
 		// prepare the audio data
 		pDriver->m_processCallback( nFrames, nullptr );
 
-		for ( int i = 0; i < nFrames; ++i ) {
-			pBuffer[ i * 2 ] = ( short )( pOut_L[ i ] * 32768.0 );
-			pBuffer[ i * 2 + 1 ] = ( short )( pOut_R[ i ] * 32768.0 );
-		}
-
-		// Check whether the playback stream is ready to process
-		// input.
-		if ( ( err = snd_pcm_wait( pDriver->m_pPlayback_handle,
-								   nTimeoutInMilliseconds ) ) < 1 ) {
-			// Playback stream is not ready. Since we opened the stream
-			// in blocking mode, the call to snd_pcm_writei() may take
-			// forever and cause the audio engine to stop working
-			// entirely. In addition, this also prevents the audio
-			// driver to be stopped and thus prevents the user from
-			// selecting a different/working version.
-			if ( err == 0 ) {
-				___ERRORLOG( QString( "timeout after [%1] milliseconds" )
-							 .arg( nTimeoutInMilliseconds ) );
-			} else {
-				___ERRORLOG( QString( "Error while waiting for playback stream: %1" )
-							 .arg( snd_strerror( err ) ) );
-			}
-			pDriver->m_nXRuns++;
-			EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
+		if ( pDriver->m_bUseMmap ) {
+			alsa_write_mmap( pDriver, nFrames );
 		} else {
+			alsa_write_rw( pDriver, nFrames );
+		}
 
-			// Playback stream is ready, let's write out the audio
-			// buffer.
-			if ( ( err = snd_pcm_writei( pDriver->m_pPlayback_handle, pBuffer, nFrames ) ) < 0 ) {
-				___ERRORLOG( QString( "Error while writing playback stream: %1" )
-							 .arg( snd_strerror( err ) ) );
-
-				// Try to bring the playback device in a nice state
-				// again and retry writing the output buffer.
-				if ( ( err = snd_pcm_recover( pDriver->m_pPlayback_handle, err, 0 ) ) == 0 ) {
-					___INFOLOG( "Successfully recovered from error. Attempt to write buffer again." );
-					if ( ( err = snd_pcm_writei( pDriver->m_pPlayback_handle, pBuffer, nFrames ) ) < 0 ) {
-						___ERRORLOG( QString( "Unable to write playback stream again: %1" )
-									 .arg( snd_strerror( err ) ) );
-						pDriver->m_nXRuns++;
-						EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
-						if ( ( err = snd_pcm_recover( pDriver->m_pPlayback_handle, err, 0 ) ) < 0 ) {
-							__ERRORLOG( QString( "Can't recover from XRUN: %1" )
-										.arg( snd_strerror( err ) ) );
-						}
-					}
-				} else {
-					__ERRORLOG( QString( "Can't recover from XRUN: %1" )
-								.arg( snd_strerror( err ) ) );
-					pDriver->m_nXRuns++;
-					EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
-				}
-			}
+		// Number of frames till the last one written will be audible.
+		snd_pcm_sframes_t nDelay;
+		if ( snd_pcm_delay( pDriver->m_pPlayback_handle, &nDelay ) == 0 ) {
+			pDriver->m_nLatency.store( nDelay, std::memory_order_relaxed );
 		}
 	}
 	return nullptr;
@@ -189,6 +249,10 @@ AlsaAudioDriver::AlsaAudioDriver( audioProcessCallback processCallback )
 		, m_nBufferSize( 0 )
 		, m_pPlayback_handle( nullptr )
 		, m_processCallback( processCallback )
+		, m_sampleFormat( SampleConversion::Format::S16 )
+		, m_bUseMmap( false )
+		, m_pInterleavedBuffer( nullptr )
+		, m_nLatency( 0 )
 {
 	m_nSampleRate = Preferences::get_instance()->m_nSampleRate;
 	m_sAlsaAudioDevice = Preferences::get_instance()->m_sAlsaAudioDevice;
@@ -268,21 +332,51 @@ int AlsaAudioDriver::connect()
 				  .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
 		return 1;
 	}
-//	snd_pcm_hw_params_set_access( m_pPlayback_handle, hw_params, SND_PCM_ACCESS_MMAP_INTERLEAVED  );
-
+	// Memory-mapped access allows to convert the samples directly
+	// into the buffer of the device.
+	m_bUseMmap = true;
 	if ( ( err = snd_pcm_hw_params_set_access( m_pPlayback_handle,
 											   hw_params,
-											   SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 ) {
-		ERRORLOG( QString( "error in snd_pcm_hw_params_set_access: %1" )
-				  .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
-		return 1;
+											   SND_PCM_ACCESS_MMAP_INTERLEAVED ) ) < 0 ) {
+		INFOLOG( QString( "mmap access not supported [%1]. Using read/write access instead." )
+				 .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
+		m_bUseMmap = false;
+
+		if ( ( err = snd_pcm_hw_params_set_access( m_pPlayback_handle,
+												   hw_params,
+												   SND_PCM_ACCESS_RW_INTERLEAVED ) ) < 0 ) {
+			ERRORLOG( QString( "error in snd_pcm_hw_params_set_access: %1" )
+					  .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
+			return 1;
+		}
 	}
 
-	if ( ( err = snd_pcm_hw_params_set_format( m_pPlayback_handle,
-											   hw_params,
-											   SND_PCM_FORMAT_S16_LE ) ) < 0 ) {
-		ERRORLOG( QString( "error in snd_pcm_hw_params_set_format: %1" )
-				  .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
+	// Use the sample format with the highest resolution supported by
+	// the device. S16 is supported by virtually all of them.
+	struct {
+		snd_pcm_format_t alsaFormat;
+		SampleConversion::Format format;
+	} const formats[] = {
+		{ SND_PCM_FORMAT_FLOAT, SampleConversion::Format::Float },
+		{ SND_PCM_FORMAT_S32, SampleConversion::Format::S32 },
+		{ SND_PCM_FORMAT_S24_3LE, SampleConversion::Format::S24_3 },
+		{ SND_PCM_FORMAT_S16, SampleConversion::Format::S16 } };
+
+	bool bFormatFound = false;
+	for ( const auto& ffFormat : formats ) {
+		if ( snd_pcm_hw_params_test_format( m_pPlayback_handle, hw_params,
+											ffFormat.alsaFormat ) == 0 &&
+			 snd_pcm_hw_params_set_format( m_pPlayback_handle, hw_params,
+										   ffFormat.alsaFormat ) == 0 ) {
+			m_sampleFormat = ffFormat.format;
+			INFOLOG( QString( "Using sample format [%1]" )
+					 .arg( snd_pcm_format_name( ffFormat.alsaFormat ) ) );
+			bFormatFound = true;
+			break;
+		}
+	}
+	if ( ! bFormatFound ) {
+		ERRORLOG( "None of the supported sample formats (FLOAT, S32, S24_3LE, S16) is accepted by the device" );
 		return 1;
 	}
 
@@ -302,10 +396,10 @@ int AlsaAudioDriver::connect()
 	// "BufferSize" setting defines the user's intention for the
 	// number of frames processed in a callback period. In ALSA, this
 	// is the "period", whereas the actual buffer (as reported by
-	// *_get_buffer_size) is sized to keep at least 2 periods' worth
-	// of data.
+	// *_get_buffer_size) is sized to keep at least
+	// Preferences::m_nAlsaPeriods periods' worth of data.
 	//
-	unsigned nPeriods = 2;
+	unsigned nPeriods = std::max( Preferences::get_instance()->m_nAlsaPeriods, 2 );
 	if ( ( err = snd_pcm_hw_params_set_periods_near( m_pPlayback_handle,
 													 hw_params,
 													 &nPeriods,
@@ -335,12 +429,32 @@ int AlsaAudioDriver::connect()
 	}
 
 	snd_pcm_hw_params_get_rate( hw_params, &m_nSampleRate, nullptr );
+	snd_pcm_hw_params_get_periods( hw_params, &nPeriods, nullptr );
+	snd_pcm_uframes_t buffer_size = nPeriods * m_nBufferSize;
+	snd_pcm_hw_params_get_buffer_size( hw_params, &buffer_size );
 
 	INFOLOG( QString( "*** PERIOD SIZE: %1" ).arg( period_size ) );
 	INFOLOG( QString( "*** SAMPLE RATE: %1" ).arg( m_nSampleRate ) );
-	INFOLOG( QString( "*** BUFFER SIZE: %1" ).arg( nPeriods * m_nBufferSize ) );
+	INFOLOG( QString( "*** BUFFER SIZE: %1" ).arg( buffer_size ) );
+
+	// Start the stream once its buffer is filled and wake up the
+	// process thread as soon as a whole period can be written.
+	snd_pcm_sw_params_t *sw_params;
+	snd_pcm_sw_params_alloca( &sw_params );
+	if ( ( err = snd_pcm_sw_params_current( m_pPlayback_handle, sw_params ) ) < 0 ||
+		 ( err = snd_pcm_sw_params_set_start_threshold( m_pPlayback_handle, sw_params,
+														buffer_size ) ) < 0 ||
+		 ( err = snd_pcm_sw_params_set_avail_min( m_pPlayback_handle, sw_params,
+												  period_size ) ) < 0 ||
+		 ( err = snd_pcm_sw_params( m_pPlayback_handle, sw_params ) ) < 0 ) {
+		ERRORLOG( QString( "error while setting software parameters: %1" )
+				  .arg( QString::fromLocal8Bit(snd_strerror(err)) ) );
+		return 1;
+	}
 
-	//snd_pcm_hw_params_free( hw_params );
+	// Will be replaced by the measured value once the process thread
+	// is running.
+	m_nLatency = buffer_size;
 
 	m_pOut_L = new float[ m_nBufferSize ];
 	m_pOut_R = new float[ m_nBufferSize ];
@@ -348,6 +462,11 @@ int AlsaAudioDriver::connect()
 	memset( m_pOut_L, 0, m_nBufferSize * sizeof( float ) );
 	memset( m_pOut_R, 0, m_nBufferSize * sizeof( float ) );
 
+	if ( ! m_bUseMmap ) {
+		m_pInterleavedBuffer = new uint8_t[ m_nBufferSize * 2 *
+							SampleConversion::getBytesPerSample( m_sampleFormat ) ];
+	}
+
 	m_bIsRunning = true;
 
 	// start the main thread
@@ -376,6 +495,9 @@ void AlsaAudioDriver::disconnect()
 
 	delete[] m_pOut_R;
 	m_pOut_R = nullptr;
+
+	delete[] m_pInterleavedBuffer;
+	m_pInterleavedBuffer = nullptr;
 }
 
 unsigned AlsaAudioDriver::getBufferSize()
@@ -397,6 +519,11 @@ float* AlsaAudioDriver::getOut_R()
 {
 	return m_pOut_R;
 }
+
+int AlsaAudioDriver::getLatency()
+{
+	return m_nLatency.load( std::memory_order_relaxed );
+}
 };
 
 #endif // H2CORE_HAVE_ALSA
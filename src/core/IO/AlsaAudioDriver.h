@@ -24,9 +24,11 @@
 
 #include <core/IO/AudioOutput.h>
 #include <core/IO/NullDriver.h>
+#include <core/IO/SampleConversion.h>
 
 #if defined(H2CORE_HAVE_ALSA) || _DOXYGEN_
 
+#include <atomic>
 #include <inttypes.h>
 #include <alsa/asoundlib.h>
 
@@ -46,6 +48,16 @@ public:
 	QString m_sAlsaAudioDevice;
 	audioProcessCallback m_processCallback;
 	int m_nXRuns;
+	/** Format negotiated with the device in connect().*/
+	SampleConversion::Format m_sampleFormat;
+	/** Whether the samples are converted directly into the
+	 * memory-mapped buffer of the device. If not, they are written
+	 * via #m_pInterleavedBuffer.*/
+	bool m_bUseMmap;
+	uint8_t* m_pInterleavedBuffer;
+	/** Output latency in frames as reported by snd_pcm_delay() after
+	 * each period written.*/
+	std::atomic<int> m_nLatency;
 
 	AlsaAudioDriver( audioProcessCallback processCallback );
 	~AlsaAudioDriver();
@@ -57,6 +69,8 @@ public:
 	virtual unsigned getSampleRate() override;
 	virtual float* getOut_L() override;
 	virtual float* getOut_R() override;
+	/** \return Measured output latency in frames. */
+	virtual int getLatency() override;
 	static QStringList getDevices();
 
 	virtual int getXRuns() const override { return m_nXRuns; }
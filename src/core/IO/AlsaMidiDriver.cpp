@@ -53,6 +53,9 @@ struct pollfd *pfd;
 int portId;
 int clientId;
 int outPortId;
+/** Queue used to stamp all incoming events with their time of
+ * arrival.*/
+int queueId = -1;
 
 
 void* alsaMidiDriver_thread( void* param )
@@ -98,6 +101,25 @@ void* alsaMidiDriver_thread( void* param )
 
 	clientId = snd_seq_client_id( seq_handle );
 
+	// Let the sequencer stamp all events arriving at the input port
+	// with the real time of a dedicated queue. Without it the
+	// events could only be timed when they are read.
+	queueId = snd_seq_alloc_queue( seq_handle );
+	if ( queueId >= 0 ) {
+		snd_seq_port_info_t *pinfo;
+		snd_seq_port_info_alloca( &pinfo );
+		if ( snd_seq_get_port_info( seq_handle, portId, pinfo ) >= 0 ) {
+			snd_seq_port_info_set_timestamping( pinfo, 1 );
+			snd_seq_port_info_set_timestamp_real( pinfo, 1 );
+			snd_seq_port_info_set_timestamp_queue( pinfo, queueId );
+			snd_seq_set_port_info( seq_handle, portId, pinfo );
+		}
+		snd_seq_start_queue( seq_handle, queueId, nullptr );
+		snd_seq_drain_output( seq_handle );
+	} else {
+		__WARNINGLOG( "Unable to allocate sequencer queue. MIDI input won't be sample-accurate." );
+	}
+
 #ifdef H2CORE_HAVE_LASH
 	if ( Preferences::get_instance()->useLash() ){
 		LashClient* lashClient = LashClient::get_instance();
@@ -135,6 +157,13 @@ void* alsaMidiDriver_thread( void* param )
 		snd_seq_port_subscribe_set_sender( subs, &sender );
 		snd_seq_port_subscribe_set_dest( subs, &dest );
 
+		/* stamp events with the real time of our queue */
+		if ( queueId >= 0 ) {
+			snd_seq_port_subscribe_set_queue( subs, queueId );
+			snd_seq_port_subscribe_set_time_update( subs, 1 );
+			snd_seq_port_subscribe_set_time_real( subs, 1 );
+		}
+
 		/* subscribe */
 		int ret = snd_seq_subscribe_port( seq_handle, subs );
 		if ( ret < 0 ) {
@@ -187,6 +216,10 @@ void* alsaMidiDriver_thread( void* param )
 			pDriver->midi_action( seq_handle );
 		}
 	}
+	if ( queueId >= 0 ) {
+		snd_seq_free_queue( seq_handle, queueId );
+		queueId = -1;
+	}
 	snd_seq_close ( seq_handle );
 	seq_handle = nullptr;
 	__INFOLOG( "MIDI Thread DESTROY" );
@@ -248,6 +281,22 @@ void AlsaMidiDriver::midi_action( snd_seq_t *seq_handle )
 
 //	bool useMidiTransport = true;
 
+	// Current real time of the queue stamping the incoming events
+	// and the corresponding MIDI timestamp. Used to convert the time
+	// stamps of the events.
+	long long nQueueTime = -1;
+	long long nCurrentTimestamp = 0;
+	if ( seq_handle != nullptr && queueId >= 0 ) {
+		snd_seq_queue_status_t *status;
+		snd_seq_queue_status_alloca( &status );
+		if ( snd_seq_get_queue_status( seq_handle, queueId, status ) >= 0 ) {
+			const snd_seq_real_time_t* pRealTime = snd_seq_queue_status_get_real_time( status );
+			nQueueTime = static_cast<long long>( pRealTime->tv_sec ) * 1000000 +
+				pRealTime->tv_nsec / 1000;
+			nCurrentTimestamp = MidiMessage::currentTimestamp();
+		}
+	}
+
 	snd_seq_event_t *ev;
 	do {
 		if ( !seq_handle ) {
@@ -258,6 +307,12 @@ void AlsaMidiDriver::midi_action( snd_seq_t *seq_handle )
 		if ( m_bActive && ev != nullptr ) {
 
 			MidiMessage msg;
+			if ( nQueueTime >= 0 && snd_seq_ev_is_real( ev ) ) {
+				const long long nEventTime =
+					static_cast<long long>( ev->time.time.tv_sec ) * 1000000 +
+					ev->time.time.tv_nsec / 1000;
+				msg.m_nTimestamp = nCurrentTimestamp - ( nQueueTime - nEventTime );
+			}
 
 			switch ( ev->type ) {
 			case SND_SEQ_EVENT_NOTEON:
@@ -0,0 +1,234 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <core/IO/AudioFileWriter.h>
+
+#include <algorithm>
+
+namespace H2Core
+{
+
+AudioFileWriter::AudioFileWriter( const QString& sFilename, int nSampleRate,
+								  int nSampleDepth, int nBlockSize )
+	: m_sFilename( sFilename )
+	, m_nSampleRate( nSampleRate )
+	, m_nSampleDepth( nSampleDepth )
+	, m_nBlockSize( std::max( nBlockSize, 1 ) )
+	, m_pFile( nullptr )
+	, m_nWriteBlock( 0 )
+	, m_nReadBlock( 0 )
+	, m_nFilledBlocks( 0 )
+	, m_bClosing( false )
+	, m_bError( false )
+{
+}
+
+AudioFileWriter::~AudioFileWriter()
+{
+	close();
+}
+
+int AudioFileWriter::getFormat( const QString& sFilename, int nSampleDepth )
+{
+	//default format
+	int sfformat = 0x010000; //wav format (default)
+	int bits = 0x0002; //16 bit PCM (default)
+	//sf_format switch
+	if( sFilename.endsWith(".aiff") || sFilename.endsWith(".AIFF") ){
+		sfformat =  0x020000; //Apple/SGI AIFF format (big endian)
+	}
+	if( sFilename.endsWith(".flac") || sFilename.endsWith(".FLAC") ){
+		sfformat =  0x170000; //FLAC lossless file format
+	}
+	if( ( nSampleDepth == 8 ) && ( sFilename.endsWith(".aiff") || sFilename.endsWith(".AIFF") ) ){
+		bits = 0x0001; //Signed 8 bit data works with aiff
+	}
+	if( ( nSampleDepth == 8 ) && ( sFilename.endsWith(".wav") || sFilename.endsWith(".WAV") ) ){
+		bits = 0x0005; //Unsigned 8 bit data needed for Microsoft WAV format
+	}
+	if( nSampleDepth == 16 ){
+		bits = 0x0002; //Signed 16 bit data
+	}
+	if( nSampleDepth == 24 ){
+		bits = 0x0003; //Signed 24 bit data
+	}
+	if( nSampleDepth == 32 ){
+		bits = 0x0004; ////Signed 32 bit data
+	}
+
+	//ogg vorbis option
+	if( sFilename.endsWith( ".ogg" ) | sFilename.endsWith( ".OGG" ) ) {
+		return SF_FORMAT_OGG | SF_FORMAT_VORBIS;
+	}
+
+///formats
+//          SF_FORMAT_WAV          = 0x010000,     /* Microsoft WAV format (little endian). */
+//          SF_FORMAT_AIFF         = 0x020000,     /* Apple/SGI AIFF format (big endian). */
+//          SF_FORMAT_AU           = 0x030000,     /* Sun/NeXT AU format (big endian). */
+//          SF_FORMAT_RAW          = 0x040000,     /* RAW PCM data. */
+//          SF_FORMAT_PAF          = 0x050000,     /* Ensoniq PARIS file format. */
+//          SF_FORMAT_SVX          = 0x060000,     /* Amiga IFF / SVX8 / SV16 format. */
+//          SF_FORMAT_NIST         = 0x070000,     /* Sphere NIST format. */
+//          SF_FORMAT_VOC          = 0x080000,     /* VOC files. */
+//          SF_FORMAT_IRCAM        = 0x0A0000,     /* Berkeley/IRCAM/CARL */
+//          SF_FORMAT_W64          = 0x0B0000,     /* Sonic Foundry's 64 bit RIFF/WAV */
+//          SF_FORMAT_MAT4         = 0x0C0000,     /* Matlab (tm) V4.2 / GNU Octave 2.0 */
+//          SF_FORMAT_MAT5         = 0x0D0000,     /* Matlab (tm) V5.0 / GNU Octave 2.1 */
+//          SF_FORMAT_PVF          = 0x0E0000,     /* Portable Voice Format */
+//          SF_FORMAT_XI           = 0x0F0000,     /* Fasttracker 2 Extended Instrument */
+//          SF_FORMAT_HTK          = 0x100000,     /* HMM Tool Kit format */
+//          SF_FORMAT_SDS          = 0x110000,     /* Midi Sample Dump Standard */
+//          SF_FORMAT_AVR          = 0x120000,     /* Audio Visual Research */
+//          SF_FORMAT_WAVEX        = 0x130000,     /* MS WAVE with WAVEFORMATEX */
+//          SF_FORMAT_SD2          = 0x160000,     /* Sound Designer 2 */
+//          SF_FORMAT_FLAC         = 0x170000,     /* FLAC lossless file format */
+//          SF_FORMAT_CAF          = 0x180000,     /* Core Audio File format */
+//	    SF_FORMAT_OGG
+///bits
+//          SF_FORMAT_PCM_S8       = 0x0001,       /* Signed 8 bit data */
+//          SF_FORMAT_PCM_16       = 0x0002,       /* Signed 16 bit data */
+//          SF_FORMAT_PCM_24       = 0x0003,       /* Signed 24 bit data */
+//          SF_FORMAT_PCM_32       = 0x0004,       /* Signed 32 bit data */
+///used for ogg
+//          SF_FORMAT_VORBIS
+
+	return sfformat|bits;
+}
+
+bool AudioFileWriter::open()
+{
+	SF_INFO soundInfo;
+	soundInfo.samplerate = m_nSampleRate;
+	soundInfo.channels = 2;
+	soundInfo.format = getFormat( m_sFilename, m_nSampleDepth );
+
+	if ( !sf_format_check( &soundInfo ) ) {
+		ERRORLOG( "Error in soundInfo" );
+		return false;
+	}
+
+	m_pFile = sf_open( m_sFilename.toLocal8Bit(), SFM_WRITE, &soundInfo );
+	if ( m_pFile == nullptr ) {
+		ERRORLOG( QString( "Unable to open [%1]: %2" )
+				  .arg( m_sFilename ).arg( sf_strerror( nullptr ) ) );
+		return false;
+	}
+
+	m_blocks.resize( nBlocks );
+	for ( auto& block : m_blocks ) {
+		block.data_L.resize( m_nBlockSize );
+		block.data_R.resize( m_nBlockSize );
+		block.nFrames = 0;
+	}
+	m_nWriteBlock = 0;
+	m_nReadBlock = 0;
+	m_nFilledBlocks = 0;
+	m_bClosing = false;
+
+	m_encoder = std::thread( &AudioFileWriter::encode, this );
+
+	return true;
+}
+
+void AudioFileWriter::write( const float* pData_L, const float* pData_R, int nFrames )
+{
+	if ( m_pFile == nullptr ) {
+		return;
+	}
+
+	while ( nFrames > 0 ) {
+		const int nBlockFrames = std::min( nFrames, m_nBlockSize );
+
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_blockFreed.wait( lock, [&]() { return m_nFilledBlocks < nBlocks; } );
+		Block& block = m_blocks[ m_nWriteBlock ];
+		lock.unlock();
+
+		// The encoder does not touch blocks which are not filled.
+		std::copy( pData_L, pData_L + nBlockFrames, block.data_L.begin() );
+		std::copy( pData_R, pData_R + nBlockFrames, block.data_R.begin() );
+		block.nFrames = nBlockFrames;
+
+		lock.lock();
+		m_nWriteBlock = ( m_nWriteBlock + 1 ) % nBlocks;
+		++m_nFilledBlocks;
+		lock.unlock();
+		m_blockFilled.notify_one();
+
+		pData_L += nBlockFrames;
+		pData_R += nBlockFrames;
+		nFrames -= nBlockFrames;
+	}
+}
+
+void AudioFileWriter::close()
+{
+	if ( m_pFile == nullptr ) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock( m_mutex );
+		m_bClosing = true;
+	}
+	m_blockFilled.notify_one();
+	m_encoder.join();
+
+	sf_close( m_pFile );
+	m_pFile = nullptr;
+}
+
+void AudioFileWriter::encode()
+{
+	std::vector<float> interleaved( m_nBlockSize * 2 );	// always stereo
+
+	while ( true ) {
+		std::unique_lock<std::mutex> lock( m_mutex );
+		m_blockFilled.wait( lock, [&]() { return m_nFilledBlocks > 0 || m_bClosing; } );
+		if ( m_nFilledBlocks == 0 ) {
+			// Closing and all blocks are written.
+			return;
+		}
+		const Block& block = m_blocks[ m_nReadBlock ];
+		lock.unlock();
+
+		const float* pData_L = block.data_L.data();
+		const float* pData_R = block.data_R.data();
+		for ( int ii = 0; ii < block.nFrames; ++ii ) {
+			interleaved[ ii * 2 ] = std::min( std::max( pData_L[ ii ], -1.0f ), 1.0f );
+			interleaved[ ii * 2 + 1 ] = std::min( std::max( pData_R[ ii ], -1.0f ), 1.0f );
+		}
+
+		const sf_count_t nWritten = sf_writef_float( m_pFile, interleaved.data(), block.nFrames );
+		if ( nWritten != block.nFrames ) {
+			ERRORLOG( QString( "Error during sf_write_float: %1" ).arg( sf_strerror( m_pFile ) ) );
+			m_bError = true;
+		}
+
+		lock.lock();
+		m_nReadBlock = ( m_nReadBlock + 1 ) % nBlocks;
+		--m_nFilledBlocks;
+		lock.unlock();
+		m_blockFreed.notify_one();
+	}
+}
+
+};
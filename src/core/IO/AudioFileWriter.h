@@ -0,0 +1,133 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef AUDIO_FILE_WRITER_H
+#define AUDIO_FILE_WRITER_H
+
+#include <sndfile.h>
+
+#include <core/Object.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace H2Core
+{
+
+/**
+ * Writes stereo audio to a file while decoupling the rendering from
+ * the encoding.
+ *
+ * Buffers handed over using write() are copied into one of
+ * #nBlocks preallocated blocks. A dedicated thread clamps and
+ * interleaves them and passes them to libsndfile. The caller only
+ * blocks in case all blocks are still waiting to be encoded. This
+ * way rendering the next buffer and encoding - which might be
+ * expensive for e.g. FLAC and Ogg/Vorbis - as well as writing the
+ * previous ones happen in parallel.
+ *
+ * The format of the file is derived from the suffix of its name.
+ */
+/** \ingroup docCore docAudioDriver */
+class AudioFileWriter : public H2Core::Object<AudioFileWriter>
+{
+	H2_OBJECT(AudioFileWriter)
+public:
+	/** Number of blocks in the queue between caller and encoder.*/
+	static constexpr int nBlocks = 16;
+
+	/**
+	 * \param sFilename Path to the file to be written.
+	 * \param nSampleRate Sample rate of the file.
+	 * \param nSampleDepth Bit depth of the file (8, 16, 24, or 32).
+	 * \param nBlockSize Number of frames per block. Larger calls to
+	 * write() are split.
+	 */
+	AudioFileWriter( const QString& sFilename, int nSampleRate, int nSampleDepth,
+					 int nBlockSize );
+	/** Calls close().*/
+	~AudioFileWriter();
+
+	/** Opens the file and starts the encoder thread.
+	 *
+	 * \return false if the format is not supported or the file could
+	 * not be opened.*/
+	bool open();
+
+	/** Enqueues @a nFrames frames of both channels to be written. */
+	void write( const float* pData_L, const float* pData_R, int nFrames );
+
+	/** Waits for all pending blocks to be written and closes the
+	 * file.*/
+	void close();
+
+	/** \return true if a write to the file failed.*/
+	bool hasError() const;
+	const QString& getFilename() const;
+
+	/** \return libsndfile format corresponding to the suffix of
+	 * @a sFilename and @a nSampleDepth.*/
+	static int getFormat( const QString& sFilename, int nSampleDepth );
+
+private:
+	struct Block {
+		std::vector<float> data_L;
+		std::vector<float> data_R;
+		int nFrames;
+	};
+
+	/** Main loop of #m_encoder.*/
+	void encode();
+
+	QString m_sFilename;
+	int m_nSampleRate;
+	int m_nSampleDepth;
+	int m_nBlockSize;
+	SNDFILE* m_pFile;
+
+	std::vector<Block> m_blocks;
+	/** Index of the next block to be filled by write().*/
+	int m_nWriteBlock;
+	/** Index of the next block to be encoded.*/
+	int m_nReadBlock;
+	/** Number of blocks waiting to be encoded.*/
+	int m_nFilledBlocks;
+	bool m_bClosing;
+	std::atomic<bool> m_bError;
+	std::mutex m_mutex;
+	std::condition_variable m_blockFilled;
+	std::condition_variable m_blockFreed;
+	std::thread m_encoder;
+};
+
+inline bool AudioFileWriter::hasError() const {
+	return m_bError;
+}
+inline const QString& AudioFileWriter::getFilename() const {
+	return m_sFilename;
+}
+
+};
+
+#endif
@@ -30,9 +30,11 @@
 #include <core/Basics/Pattern.h>
 #include <core/Basics/PatternList.h>
 #include <core/IO/DiskWriterDriver.h>
+#include <core/IO/AudioFileWriter.h>
 
 #include <pthread.h>
 #include <cassert>
+#include <memory>
 
 #if defined(WIN32) || _DOXYGEN_
 #include <windows.h>
@@ -62,89 +64,42 @@ void* diskWriterDriver_thread( void* param )
 	
 	__INFOLOG( "DiskWriterDriver thread start" );
 
-	// always rolling, no user interaction
-	pAudioEngine->play();
-	SF_INFO soundInfo;
-	soundInfo.samplerate = pDriver->m_nSampleRate;
-//	soundInfo.frames = -1;//getNFrames();		///\todo: da terminare
-	soundInfo.channels = 2;
-	//default format
-	int sfformat = 0x010000; //wav format (default)
-	int bits = 0x0002; //16 bit PCM (default)
-	//sf_format switch
-	if( pDriver->m_sFilename.endsWith(".aiff") || pDriver->m_sFilename.endsWith(".AIFF") ){
-		sfformat =  0x020000; //Apple/SGI AIFF format (big endian)
-	}
-	if( pDriver->m_sFilename.endsWith(".flac") || pDriver->m_sFilename.endsWith(".FLAC") ){
-		sfformat =  0x170000; //FLAC lossless file format
-	}
-	if( ( pDriver->m_nSampleDepth == 8 ) && ( pDriver->m_sFilename.endsWith(".aiff") || pDriver->m_sFilename.endsWith(".AIFF") ) ){
-		bits = 0x0001; //Signed 8 bit data works with aiff
-	}
-	if( ( pDriver->m_nSampleDepth == 8 ) && ( pDriver->m_sFilename.endsWith(".wav") || pDriver->m_sFilename.endsWith(".WAV") ) ){
-		bits = 0x0005; //Unsigned 8 bit data needed for Microsoft WAV format
+	// Encoding and writing the rendered buffers is done in separate
+	// threads. The main out is written first, followed by one file
+	// per stem. All of them are rendered in a single pass.
+	std::vector<std::unique_ptr<AudioFileWriter>> writers;
+	std::vector<const float*> outs_L, outs_R;
+	if ( ! pDriver->m_sFilename.isEmpty() ) {
+		writers.push_back( std::make_unique<AudioFileWriter>(
+			pDriver->m_sFilename, pDriver->m_nSampleRate,
+			pDriver->m_nSampleDepth, pDriver->m_nBufferSize ) );
+		outs_L.push_back( pDriver->m_pOut_L );
+		outs_R.push_back( pDriver->m_pOut_R );
 	}
-	if( pDriver->m_nSampleDepth == 16 ){
-		bits = 0x0002; //Signed 16 bit data
-	}
-	if( pDriver->m_nSampleDepth == 24 ){
-		bits = 0x0003; //Signed 24 bit data
-	}
-	if( pDriver->m_nSampleDepth == 32 ){
-		bits = 0x0004; ////Signed 32 bit data
-	}
-
-	soundInfo.format =  sfformat|bits;
-
-//	#ifdef HAVE_OGGVORBIS
-
-	//ogg vorbis option
-	if( pDriver->m_sFilename.endsWith( ".ogg" ) | pDriver->m_sFilename.endsWith( ".OGG" ) ) {
-		soundInfo.format = SF_FORMAT_OGG | SF_FORMAT_VORBIS;
+	for ( int ii = 0; ii < static_cast<int>( pDriver->getStems().size() ); ++ii ) {
+		writers.push_back( std::make_unique<AudioFileWriter>(
+			pDriver->getStems()[ ii ].sFilename, pDriver->m_nSampleRate,
+			pDriver->m_nSampleDepth, pDriver->m_nBufferSize ) );
+		outs_L.push_back( pDriver->getStemOutputs()[ ii ].pOut_L );
+		outs_R.push_back( pDriver->getStemOutputs()[ ii ].pOut_R );
 	}
-//	#endif
-
-
-///formats
-//          SF_FORMAT_WAV          = 0x010000,     /* Microsoft WAV format (little endian). */
-//          SF_FORMAT_AIFF         = 0x020000,     /* Apple/SGI AIFF format (big endian). */
-//          SF_FORMAT_AU           = 0x030000,     /* Sun/NeXT AU format (big endian). */
-//          SF_FORMAT_RAW          = 0x040000,     /* RAW PCM data. */
-//          SF_FORMAT_PAF          = 0x050000,     /* Ensoniq PARIS file format. */
-//          SF_FORMAT_SVX          = 0x060000,     /* Amiga IFF / SVX8 / SV16 format. */
-//          SF_FORMAT_NIST         = 0x070000,     /* Sphere NIST format. */
-//          SF_FORMAT_VOC          = 0x080000,     /* VOC files. */
-//          SF_FORMAT_IRCAM        = 0x0A0000,     /* Berkeley/IRCAM/CARL */
-//          SF_FORMAT_W64          = 0x0B0000,     /* Sonic Foundry's 64 bit RIFF/WAV */
-//          SF_FORMAT_MAT4         = 0x0C0000,     /* Matlab (tm) V4.2 / GNU Octave 2.0 */
-//          SF_FORMAT_MAT5         = 0x0D0000,     /* Matlab (tm) V5.0 / GNU Octave 2.1 */
-//          SF_FORMAT_PVF          = 0x0E0000,     /* Portable Voice Format */
-//          SF_FORMAT_XI           = 0x0F0000,     /* Fasttracker 2 Extended Instrument */
-//          SF_FORMAT_HTK          = 0x100000,     /* HMM Tool Kit format */
-//          SF_FORMAT_SDS          = 0x110000,     /* Midi Sample Dump Standard */
-//          SF_FORMAT_AVR          = 0x120000,     /* Audio Visual Research */
-//          SF_FORMAT_WAVEX        = 0x130000,     /* MS WAVE with WAVEFORMATEX */
-//          SF_FORMAT_SD2          = 0x160000,     /* Sound Designer 2 */
-//          SF_FORMAT_FLAC         = 0x170000,     /* FLAC lossless file format */
-//          SF_FORMAT_CAF          = 0x180000,     /* Core Audio File format */
-//	    SF_FORMAT_OGG
-///bits
-//          SF_FORMAT_PCM_S8       = 0x0001,       /* Signed 8 bit data */
-//          SF_FORMAT_PCM_16       = 0x0002,       /* Signed 16 bit data */
-//          SF_FORMAT_PCM_24       = 0x0003,       /* Signed 24 bit data */
-//          SF_FORMAT_PCM_32       = 0x0004,       /* Signed 32 bit data */
-///used for ogg
-//          SF_FORMAT_VORBIS
-
-	if ( !sf_format_check( &soundInfo ) ) {
-		__ERRORLOG( "Error in soundInfo" );
-		return nullptr;
+	// Open all files before the transport starts rolling. This way a
+	// failure neither leaves the engine playing nor the export dialog
+	// waiting for progress.
+	for ( auto& pWriter : writers ) {
+		if ( ! pWriter->open() ) {
+			__ERRORLOG( "Unable to open all export files. Export aborted." );
+			// Closes the files which could be opened.
+			writers.clear();
+			EventQueue::get_instance()->push_event(
+				EVENT_ERROR, Hydrogen::EXPORT_CANNOT_OPEN_FILE );
+			EventQueue::get_instance()->push_event( EVENT_PROGRESS, 100 );
+			return nullptr;
+		}
 	}
 
-
-	SNDFILE* m_file = sf_open( pDriver->m_sFilename.toLocal8Bit(), SFM_WRITE, &soundInfo );
-
-	float *pData = new float[ pDriver->m_nBufferSize * 2 ];	// always stereo
+	// always rolling, no user interaction
+	pAudioEngine->play();
 
 	float *pData_L = pDriver->m_pOut_L;
 	float *pData_R = pDriver->m_pOut_R;
@@ -205,10 +160,25 @@ void* diskWriterDriver_thread( void* param )
 
 			int ret = pDriver->m_processCallback( nUsedBuffer, nullptr );
 			
-			// In case the DiskWriter couldn't aquire the lock of the AudioEngine.
-			while( ret != 0 ) {
+			// In case the DiskWriter couldn't aquire the lock of the
+			// AudioEngine. Unlike with a real-time driver the cycle
+			// must not be dropped, as it would leave a gap in the
+			// exported files. Since the lock is held while the driver
+			// is disconnected, retrying has to stop as soon as the
+			// export is aborted.
+			//
+			// The number of retries is not capped. Each attempt blocks
+			// in tryLockFor() for at most the duration of one buffer,
+			// so this does not spin, and the loop is left either once
+			// the lock was acquired or once disconnect() set
+			// m_bAbort.
+			while( ret == 2 && ! pDriver->m_bAbort ) {
 				ret = pDriver->m_processCallback( nUsedBuffer, nullptr );
 			}
+			if ( pDriver->m_bAbort ) {
+				__INFOLOG( "Export aborted" );
+				break;
+			}
 
 			if ( patternPosition == nColumns - 1 &&
 				 nPatternLengthInFrames - nFrameNumber < nUsedBuffer ) {
@@ -246,28 +216,9 @@ void* diskWriterDriver_thread( void* param )
 			}
 			
 			nFrameNumber += nBufferWriteLength;
-			
-			for ( unsigned ii = 0; ii < nBufferWriteLength; ii++ ) {
-				if( pData_L[ ii ] > 1 ) {
-					pData[ ii * 2 ] = 1;
-				} else if( pData_L[ ii ] < -1 ) {
-					pData[ ii * 2 ] = -1;
-				} else {
-					pData[ ii * 2 ] = pData_L[ ii ];
-				}
-				
-				if( pData_R[ ii ] > 1 ){
-					pData[ ii * 2 + 1 ] = 1;
-				} else if ( pData_R[ ii ] < -1 ) {
-					pData[ ii * 2 + 1 ] = -1;
-				} else {
-					pData[ ii * 2 + 1 ] = pData_R[ ii ];
-				}
-			}
-			
-			int res = sf_writef_float( m_file, pData, nBufferWriteLength );
-			if ( res != ( int )nBufferWriteLength ) {
-				__ERRORLOG( "Error during sf_write_float" );
+
+			for ( int ii = 0; ii < static_cast<int>( writers.size() ); ++ii ) {
+				writers[ ii ]->write( outs_L[ ii ], outs_R[ ii ], nBufferWriteLength );
 			}
 
 			// Sampler is still rendering notes put we seem to have
@@ -277,15 +228,20 @@ void* diskWriterDriver_thread( void* param )
 				break;
 			}
 		}
+
+		if ( pDriver->m_bAbort ) {
+			break;
+		}
 		
 		// this progress bar method is not exact but ok enough to give users a usable visible progress feedback
 		float fPercent = ( float )(patternPosition +1) / ( float )nColumns * 100.0;
 		EventQueue::get_instance()->push_event( EVENT_PROGRESS, ( int )fPercent );
 	}
-	delete[] pData;
-	pData = nullptr;
 
-	sf_close( m_file );
+	// Wait for all buffers to be written.
+	for ( auto& pWriter : writers ) {
+		pWriter->close();
+	}
 
 	__INFOLOG( "DiskWriterDriver thread end" );
 
@@ -302,12 +258,14 @@ DiskWriterDriver::DiskWriterDriver( audioProcessCallback processCallback )
 		, m_processCallback( processCallback )
 		, m_nBufferSize( 1024 )
 		, m_pOut_L( nullptr )
-		, m_pOut_R( nullptr ) {
+		, m_pOut_R( nullptr )
+		, m_bAbort( false ) {
 }
 
 
 
 DiskWriterDriver::~DiskWriterDriver() {
+	freeStemOutputs();
 }
 
 
@@ -333,6 +291,8 @@ void DiskWriterDriver::write()
 {
 	INFOLOG( "" );
 	
+	m_bAbort = false;
+
 	pthread_attr_t attr;
 	pthread_attr_init( &attr );
 
@@ -344,6 +304,9 @@ void DiskWriterDriver::disconnect()
 {
 	INFOLOG( "" );
 
+	// The audio engine is locked while disconnecting. Tell a still
+	// running export to stop instead of waiting for the lock.
+	m_bAbort = true;
 	pthread_join( diskWriterDriverThread, NULL );
 
 	delete[] m_pOut_L;
@@ -352,6 +315,31 @@ void DiskWriterDriver::disconnect()
 	delete[] m_pOut_R;
 	m_pOut_R = nullptr;
 
+	freeStemOutputs();
+}
+
+void DiskWriterDriver::setStems( const std::vector<Stem>& stems )
+{
+	freeStemOutputs();
+
+	m_stems = stems;
+	for ( const auto& stem : m_stems ) {
+		Sampler::StemOutput output;
+		output.nInstrumentId = stem.nInstrumentId;
+		output.pOut_L = new float[ m_nBufferSize ];
+		output.pOut_R = new float[ m_nBufferSize ];
+		m_stemOutputs.push_back( output );
+	}
+}
+
+void DiskWriterDriver::freeStemOutputs()
+{
+	for ( auto& output : m_stemOutputs ) {
+		delete[] output.pOut_L;
+		delete[] output.pOut_R;
+	}
+	m_stemOutputs.clear();
+	m_stems.clear();
 }
 
 unsigned DiskWriterDriver::getSampleRate()
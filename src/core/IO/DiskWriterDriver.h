@@ -25,10 +25,13 @@
 
 #include <sndfile.h>
 
+#include <atomic>
 #include <inttypes.h>
+#include <vector>
 
 #include <core/IO/AudioOutput.h>
 #include <core/Object.h>
+#include <core/Sampler/Sampler.h>
 
 namespace H2Core
 {
@@ -50,6 +53,15 @@ class DiskWriterDriver : public Object<DiskWriterDriver>, public AudioOutput
 		audioProcessCallback	m_processCallback;
 		float*					m_pOut_L;
 		float*					m_pOut_R;
+		/** Set in disconnect() to stop an export in progress.*/
+		std::atomic<bool>		m_bAbort;
+
+		/** Per-instrument file written along with the main out.*/
+		struct Stem {
+			/** Instrument::__id of the exported instrument.*/
+			int nInstrumentId;
+			QString sFilename;
+		};
 
 		DiskWriterDriver( audioProcessCallback processCallback );
 		~DiskWriterDriver();
@@ -80,11 +92,35 @@ class DiskWriterDriver : public Object<DiskWriterDriver>, public AudioOutput
 			return m_pOut_R;
 		}
 		
+		/** \param sFilename File the main out is written to. If
+		 * empty, only the stems are written.*/
 		void  setFileName( const QString& sFilename ){
 			m_sFilename = sFilename;
 		}
 
+		/**
+		 * Sets the instruments written to separate files during the
+		 * next write().
+		 *
+		 * Allocates one pair of buffers per stem. Their
+		 * Sampler::StemOutput have to be passed to the #Sampler
+		 * before starting the export using write().
+		 */
+		void setStems( const std::vector<Stem>& stems );
+		const std::vector<Stem>& getStems() const {
+			return m_stems;
+		}
+		const std::vector<Sampler::StemOutput>& getStemOutputs() const {
+			return m_stemOutputs;
+		}
+
 	private:
+		void freeStemOutputs();
+
+		std::vector<Stem>		m_stems;
+		/** Buffers filled by the #Sampler, one for each of
+		 * #m_stems.*/
+		std::vector<Sampler::StemOutput> m_stemOutputs;
 
 
 };
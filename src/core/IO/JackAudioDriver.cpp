@@ -86,6 +86,7 @@ void JackAudioDriver::jackDriverShutdown( void* arg )
 int JackAudioDriver::jackXRunCallback( void *arg ) {
 	UNUSED( arg );
 	++JackAudioDriver::jackServerXRuns;
+	Hydrogen::get_instance()->getAudioEngine()->getDspProfiler()->reportDriverXrun();
 	EventQueue::get_instance()->push_event( EVENT_XRUN, 0 );
 	return 0;
 }
@@ -251,6 +252,14 @@ unsigned JackAudioDriver::getSampleRate()
 	return JackAudioDriver::jackServerSampleRate;
 }
 
+long long JackAudioDriver::getCycleFrameTime() const
+{
+	if ( m_pClient == nullptr ) {
+		return -1;
+	}
+	return static_cast<long long>( jack_last_frame_time( m_pClient ) );
+}
+
 void JackAudioDriver::clearPerTrackAudioBuffers( uint32_t nFrames )
 {
 	if ( m_pClient != nullptr &&
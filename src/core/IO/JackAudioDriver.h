@@ -156,6 +156,11 @@ public:
 	virtual unsigned getBufferSize() override;
 	/** \return Global variable #jackServerSampleRate. */
 	virtual unsigned getSampleRate() override;
+	/** \return JACK frame time at the beginning of the current
+	 * process cycle (see _jack_last_frame_time()_ in jack/jack.h) or
+	 * -1 if there is no client. Only valid within the process
+	 * callback.*/
+	long long getCycleFrameTime() const;
 
 	virtual int getXRuns() const override;
 
@@ -613,6 +618,7 @@ public:
 	// need to be build even if no JACK support is desired.
 	void updateTransportInfo() {}
 	void relocateUsingBBT() {}
+	long long getCycleFrameTime() const { return -1; }
 };
 
 }; // H2Core namespace
@@ -32,9 +32,13 @@
 #include <core/Hydrogen.h>
 #include <core/Globals.h>
 #include <core/EventQueue.h>
+#include <core/AudioEngine/AudioEngine.h>
 #include <core/Basics/Note.h>
 #include <core/Basics/Instrument.h>
 #include <core/Basics/InstrumentList.h>
+#include <core/IO/JackAudioDriver.h>
+
+#include <algorithm>
 
 #ifdef H2CORE_HAVE_LASH
 #include <core/Lash/LashClient.h>
@@ -43,18 +47,6 @@
 namespace H2Core
 {
 
-void
-JackMidiDriver::lock(void)
-{
-	pthread_mutex_lock(&mtx);
-}
-
-void
-JackMidiDriver::unlock(void)
-{
-	pthread_mutex_unlock(&mtx);
-}
-
 void
 JackMidiDriver::JackMidiWrite(jack_nframes_t nframes)
 {
@@ -80,6 +72,13 @@ JackMidiDriver::JackMidiWrite(jack_nframes_t nframes)
 	events = jack_midi_get_event_count(buf);
 #endif
 
+	// The events are stamped with their offset within the current
+	// cycle. These reference points are used to convert them into
+	// MIDI timestamps.
+	const jack_nframes_t nCycleStart = jack_last_frame_time(jack_client);
+	const long long nJackTime = static_cast<long long>(jack_get_time());
+	const long long nCurrentTimestamp = MidiMessage::currentTimestamp();
+
 	for (i = 0; i < events; i++) {
 		MidiMessage msg;
 
@@ -104,6 +103,11 @@ JackMidiDriver::JackMidiWrite(jack_nframes_t nframes)
 		memset(buffer, 0, sizeof(buffer));
 		memcpy(buffer, event.buffer, error);
 
+		msg.m_nTimestamp = nCurrentTimestamp - nJackTime +
+			static_cast<long long>(jack_frames_to_time(jack_client, nCycleStart + event.time));
+		msg.m_nJackFrameTime = static_cast<long long>(
+			static_cast<jack_nframes_t>(nCycleStart + event.time));
+
 		switch (buffer[0] >> 4) {
 		case 0x8:	 /* note off */
 			msg.m_type = MidiMessage::NOTE_OFF;
@@ -217,12 +221,12 @@ JackMidiDriver::handleOutgoingControlChange( int param, int value, int channel )
 		return;
 	}
 
-	buffer[0] = 0xB0 | channel;	/* note off */
+	buffer[0] = 0xB0 | channel;	/* control change */
 	buffer[1] = param;
 	buffer[2] = value;
 	buffer[3] = 0;
 
-	JackMidiOutEvent(buffer, 3);
+	JackMidiOutEvent(buffer, 3, computeOutFrame(0));
 }
 
 void
@@ -230,9 +234,6 @@ JackMidiDriver::JackMidiRead(jack_nframes_t nframes)
 {
 	uint8_t *buffer;
 	void *buf;
-	jack_nframes_t t;
-	uint8_t data[1];
-	uint8_t len;
 
 	if (output_port == nullptr) {
 		return;
@@ -249,68 +250,116 @@ JackMidiDriver::JackMidiRead(jack_nframes_t nframes)
 	jack_midi_clear_buffer(buf);
 #endif
 
-	t = 0;
-	lock();
-	while ((t < nframes) &&
-		   (rx_out_pos != rx_in_pos)) {
+	// Collect all messages due within this cycle. Since messages
+	// queued by different threads or for different notes do not
+	// necessarily arrive in order, they are sorted by their offset
+	// (insertion sort, they are mostly in order already).
+	const int nMaxEvents = 256;
+	OutEvent events[ nMaxEvents ];
+	jack_nframes_t offsets[ nMaxEvents ];
+	int nEvents = 0;
+
+	const jack_nframes_t nCycleStart = jack_last_frame_time(jack_client);
+	while (nEvents < nMaxEvents) {
+		OutEventCell& cell = m_outEvents[ m_nOutReadIndex % nOutEventRingSize ];
+		if (cell.nSequence.load(std::memory_order_acquire) != m_nOutReadIndex + 1) {
+			// Empty
+			break;
+		}
 
-				len = jack_buffer[4 * rx_in_pos];
-		if (len == 0) {
-			rx_in_pos++;
-			if (rx_in_pos >= JACK_MIDI_BUFFER_MAX) {
-				rx_in_pos = 0;
-			}
-			continue;
+		const int32_t nOffset = static_cast<int32_t>(cell.event.nFrame - nCycleStart);
+		if (nOffset >= static_cast<int32_t>(nframes)) {
+			// The oldest message is due in a later cycle.
+			break;
 		}
 
+		int nPos = nEvents;
+		const jack_nframes_t nEventOffset = static_cast<jack_nframes_t>(std::max(nOffset, 0));
+		while (nPos > 0 && offsets[ nPos - 1 ] > nEventOffset) {
+			events[ nPos ] = events[ nPos - 1 ];
+			offsets[ nPos ] = offsets[ nPos - 1 ];
+			--nPos;
+		}
+		events[ nPos ] = cell.event;
+		offsets[ nPos ] = nEventOffset;
+		++nEvents;
+
+		cell.nSequence.store(m_nOutReadIndex + nOutEventRingSize, std::memory_order_release);
+		++m_nOutReadIndex;
+	}
+
+	for (int i = 0; i < nEvents; i++) {
 #ifdef JACK_MIDI_NEEDS_NFRAMES
-		buffer = jack_midi_event_reserve(buf, t, len, nframes);
+		buffer = jack_midi_event_reserve(buf, offsets[i], events[i].nLength, nframes);
 #else
-		buffer = jack_midi_event_reserve(buf, t, len);
+		buffer = jack_midi_event_reserve(buf, offsets[i], events[i].nLength);
 #endif
 		if (buffer == nullptr) {
+			m_nDroppedOutEvents.fetch_add(nEvents - i, std::memory_order_relaxed);
 			break;
 		}
-		t++;
-		rx_in_pos++;
-		if (rx_in_pos >= JACK_MIDI_BUFFER_MAX) {
-			rx_in_pos = 0;
-		}
-		memcpy(buffer, jack_buffer + (4 * rx_in_pos) + 1, len);
+		memcpy(buffer, events[i].data, events[i].nLength);
 	}
-	unlock();
 }
 
 void
-JackMidiDriver::JackMidiOutEvent(uint8_t buf[4], uint8_t len)
+JackMidiDriver::JackMidiOutEvent(uint8_t buf[4], uint8_t len, jack_nframes_t nFrame)
 {
-	uint32_t next_pos;
-
-	lock();
-
-	next_pos = rx_out_pos + 1;
-	if (next_pos >= JACK_MIDI_BUFFER_MAX) {
-		next_pos = 0;
+	if (len > 3) {
+		len = 3;
 	}
 
-	if (next_pos == rx_in_pos) {
-		/* buffer is full */
-		unlock();
-		return;
+	unsigned int nPos = m_nOutWriteIndex.load(std::memory_order_relaxed);
+	while (true) {
+		OutEventCell& cell = m_outEvents[ nPos % nOutEventRingSize ];
+		const unsigned int nSequence = cell.nSequence.load(std::memory_order_acquire);
+		const int nDiff = static_cast<int>(nSequence - nPos);
+		if (nDiff == 0) {
+			if (m_nOutWriteIndex.compare_exchange_weak(nPos, nPos + 1,
+													   std::memory_order_relaxed)) {
+				cell.event.nFrame = nFrame;
+				cell.event.nLength = len;
+				memcpy(cell.event.data, buf, len);
+				cell.nSequence.store(nPos + 1, std::memory_order_release);
+				return;
+			}
+		}
+		else if (nDiff < 0) {
+			/* buffer is full */
+			m_nDroppedOutEvents.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		else {
+			nPos = m_nOutWriteIndex.load(std::memory_order_relaxed);
+		}
 	}
+}
 
-	if (len > 3) {
-		len = 3;
+jack_nframes_t
+JackMidiDriver::computeOutFrame(long long nOffset)
+{
+	if (jack_client == nullptr) {
+		return 0;
 	}
 
-	jack_buffer[(4 * next_pos)] = len;
-	jack_buffer[(4 * next_pos) + 1] = buf[0];
-	jack_buffer[(4 * next_pos) + 2] = buf[1];
-	jack_buffer[(4 * next_pos) + 3] = buf[2];
-
-	rx_out_pos = next_pos;
+	jack_nframes_t nBase;
+	AudioOutput* pAudioDriver = Hydrogen::get_instance()->getAudioOutput();
+	if (dynamic_cast<JackAudioDriver*>(pAudioDriver) != nullptr) {
+		// Both clients are processed within the same JACK cycle.
+		nBase = jack_last_frame_time(jack_client);
+	} else {
+		nBase = jack_frame_time(jack_client);
+		if (pAudioDriver != nullptr && pAudioDriver->getSampleRate() > 0) {
+			nOffset = nOffset * static_cast<long long>(jack_get_sample_rate(jack_client)) /
+				static_cast<long long>(pAudioDriver->getSampleRate());
+		}
+	}
 
-	unlock();
+	// Delay all messages by one period. Otherwise the ones queued
+	// after the MIDI client was already processed in the current
+	// cycle would be sent later than the others.
+	return nBase + jack_get_buffer_size(jack_client) +
+		static_cast<jack_nframes_t>(std::max(nOffset, 0LL));
 }
 
 static int
@@ -338,11 +387,14 @@ JackMidiShutdown(void *arg)
 JackMidiDriver::JackMidiDriver()
 	: MidiInput(), MidiOutput(), Object<JackMidiDriver>()
 {
-	pthread_mutex_init(&mtx, nullptr);
-
 	running = 0;
-	rx_in_pos = 0;
-	rx_out_pos = 0;
+	m_nOutWriteIndex = 0;
+	m_nOutReadIndex = 0;
+	m_nDroppedOutEvents = 0;
+	for (int i = 0; i < nOutEventRingSize; i++) {
+		m_outEvents[ i ].nSequence.store(i, std::memory_order_relaxed);
+	}
+	jack_client = nullptr;
 	output_port = nullptr;
 	input_port = nullptr;
 
@@ -405,8 +457,11 @@ JackMidiDriver::~JackMidiDriver()
 			ERRORLOG("Failed close jack midi client");
 		}
 	}
-	pthread_mutex_destroy(&mtx);
 
+	if (m_nDroppedOutEvents.load() > 0) {
+		WARNINGLOG(QString("[%1] outgoing MIDI messages were lost")
+				   .arg(m_nDroppedOutEvents.load()));
+	}
 }
 
 void
@@ -477,19 +532,28 @@ void JackMidiDriver::handleQueueNote(Note* pNote)
 		return;
 	}
 
+	// Position of the note within the buffer currently rendered.
+	auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
+	long long nOffset = pNote->getNoteStart() - pAudioEngine->getCycleStartFrame();
+	AudioOutput* pAudioDriver = pAudioEngine->getAudioDriver();
+	if (pAudioDriver != nullptr) {
+		nOffset = std::min(nOffset, static_cast<long long>(pAudioDriver->getBufferSize()) - 1);
+	}
+	const jack_nframes_t nFrame = computeOutFrame(nOffset);
+
 	buffer[0] = 0x80 | channel;	/* note off */
 	buffer[1] = key;
 	buffer[2] = 0;
 	buffer[3] = 0;
 
-	JackMidiOutEvent(buffer, 3);
+	JackMidiOutEvent(buffer, 3, nFrame);
 
 	buffer[0] = 0x90 | channel;	/* note on */
 	buffer[1] = key;
 	buffer[2] = vel;
 	buffer[3] = 0;
 
-	JackMidiOutEvent(buffer, 3);
+	JackMidiOutEvent(buffer, 3, nFrame);
 }
 
 void
@@ -514,7 +578,7 @@ JackMidiDriver::handleQueueNoteOff(int channel, int key, int vel)
 	buffer[2] = 0;
 	buffer[3] = 0;
 
-	JackMidiOutEvent(buffer, 3);
+	JackMidiOutEvent(buffer, 3, computeOutFrame(0));
 }
 
 void JackMidiDriver::handleQueueAllNoteOff()
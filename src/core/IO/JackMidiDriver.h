@@ -32,7 +32,7 @@
 
 #if defined(H2CORE_HAVE_JACK) || _DOXYGEN_
 
-#include <pthread.h>
+#include <atomic>
 
 #include <jack/jack.h>
 #include <jack/midiport.h>
@@ -41,11 +41,20 @@
 #include <string>
 #include <vector>
 
-#define	JACK_MIDI_BUFFER_MAX 64	/* events */
-
 namespace H2Core
 {
 
+/**
+ * MIDI input and output using a dedicated JACK client.
+ *
+ * Outgoing messages are stamped with the JACK frame they have to be
+ * sent at and stored in a lock-free ring buffer. Notes triggered by
+ * the #Sampler are placed at the offset they start at within the
+ * buffer rendered by the #AudioEngine and delayed by exactly one
+ * period. This way their timing is sample accurate and does not
+ * depend on whether the MIDI client is processed before or after
+ * the audio one. All other messages are sent as soon as possible.
+ */
 /** \ingroup docCore docMIDI */
 class JackMidiDriver : public Object<JackMidiDriver>, public virtual MidiInput, public virtual MidiOutput
 {
@@ -68,20 +77,46 @@ public:
 	virtual void handleQueueAllNoteOff() override;
 	virtual void handleOutgoingControlChange( int param, int value, int channel ) override;
 
-private:
-	void JackMidiOutEvent(uint8_t *buf, uint8_t len);
+	/** Maximum number of outgoing messages waiting to be sent.*/
+	static constexpr int nOutEventRingSize = 1024;
 
-	void lock();
-	void unlock();
+private:
+	struct OutEvent {
+		/** JACK frame the message has to be sent at.*/
+		jack_nframes_t nFrame;
+		uint8_t nLength;
+		uint8_t data[3];
+	};
+	/** Slot of #m_outEvents. Works the same way as the ones of the
+	 * #EventQueue.*/
+	struct OutEventCell {
+		std::atomic<unsigned int> nSequence;
+		OutEvent event;
+	};
+
+	/** Queues @a len bytes of @a buf to be sent at JACK frame @a
+	 * nFrame. Can be called from any thread and does neither lock
+	 * nor allocate.*/
+	void JackMidiOutEvent( uint8_t *buf, uint8_t len, jack_nframes_t nFrame );
+	/** \return JACK frame a message @a nOffset frames into the
+	 * buffer currently rendered by the #AudioEngine has to be sent
+	 * at.*/
+	jack_nframes_t computeOutFrame( long long nOffset );
 
 	jack_port_t *output_port;
 	jack_port_t *input_port;
 	jack_client_t *jack_client;
-	pthread_mutex_t mtx;
 	int running;
-		uint8_t jack_buffer[JACK_MIDI_BUFFER_MAX * 4];
-	uint32_t rx_in_pos;
-	uint32_t rx_out_pos;
+
+	OutEventCell m_outEvents[ nOutEventRingSize ];
+	/** Continuously growing index of the next slot to be written.*/
+	std::atomic<unsigned int> m_nOutWriteIndex;
+	/** Continuously growing index of the next slot to be read. Only
+	 * accessed by the JACK process callback.*/
+	unsigned int m_nOutReadIndex;
+	/** Messages lost because the ring buffer or the JACK port buffer
+	 * was full.*/
+	std::atomic<int> m_nDroppedOutEvents;
 };
 
 };
@@ -25,6 +25,7 @@
 
 #include <core/config.h>
 #include <core/Object.h>
+#include <chrono>
 #include <string>
 #include <vector>
 
@@ -58,12 +59,42 @@ public:
 	int m_nData2;
 	int m_nChannel;
 	std::vector<unsigned char> m_sysexData;
+	/**
+	 * Point in time the message was received in microseconds as
+	 * returned by currentTimestamp().
+	 *
+	 * It is set by the MIDI driver based on the timing information
+	 * provided by the backend, like the frame offset of a JACK
+	 * event or the real time of the ALSA queue, and used to place
+	 * the resulting notes sample-accurately. 0 if the driver does
+	 * not provide any timing information.
+	 */
+	long long m_nTimestamp;
+	/**
+	 * JACK frame time (see _jack_last_frame_time()_ in jack/jack.h)
+	 * the message was received at. Only set by the JackMidiDriver
+	 * and -1 otherwise.
+	 *
+	 * When using the JackAudioDriver as well, it is used instead of
+	 * #m_nTimestamp since both are processed in the same JACK cycle
+	 * but in no particular order.
+	 */
+	long long m_nJackFrameTime;
 
 	MidiMessage()
 			: m_type( UNKNOWN )
 			, m_nData1( -1 )
 			, m_nData2( -1 )
-			, m_nChannel( -1 ) {}
+			, m_nChannel( -1 )
+			, m_nTimestamp( 0 )
+			, m_nJackFrameTime( -1 ) {}
+
+	/** \return Current time of the monotonic clock all MIDI
+	 * timestamps refer to in microseconds.*/
+	static long long currentTimestamp() {
+		return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch() ).count();
+	}
 };
 
 
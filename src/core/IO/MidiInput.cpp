@@ -51,12 +51,12 @@ MidiInput::~MidiInput()
 
 void MidiInput::handleMidiMessage( const MidiMessage& msg )
 {
+		// This function is called from within the MIDI drivers - in
+		// case of JACK even from within the process callback. The
+		// handling of note, CC, and program change messages must
+		// therefore neither log, lock, nor allocate.
 		EventQueue::get_instance()->push_event( EVENT_MIDI_ACTIVITY, -1 );
 
-		INFOLOG( QString( "[start of handleMidiMessage] channel: %1, val1: %2, val2: %3" )
-				 .arg( msg.m_nChannel ).arg( msg.m_nData1 )
-				 .arg( msg.m_nData2 ) );
-
 		// midi channel filter for all messages
 		bool bIsChannelValid = true;
 		Preferences* pPref = Preferences::get_instance();
@@ -96,31 +96,22 @@ void MidiInput::handleMidiMessage( const MidiMessage& msg )
 				break;
 
 		case MidiMessage::NOTE_ON:
-				INFOLOG("This is a NOTE ON message.");
 				handleNoteOnMessage( msg );
 				break;
 
 		case MidiMessage::NOTE_OFF:
-				INFOLOG("This is a NOTE OFF message.");
 				handleNoteOffMessage( msg, false );
 				break;
 
 		case MidiMessage::POLYPHONIC_KEY_PRESSURE:
-				//ERRORLOG( "POLYPHONIC_KEY_PRESSURE event not handled yet" );
-				INFOLOG( QString( "[handleMidiMessage] POLYPHONIC_KEY_PRESSURE Parameter: %1, Value: %2")
-					.arg( msg.m_nData1 ).arg( msg.m_nData2 ) );
 				handlePolyphonicKeyPressureMessage( msg );
 				break;
 
 		case MidiMessage::CONTROL_CHANGE:
-				INFOLOG( QString( "[handleMidiMessage] CONTROL_CHANGE Parameter: %1, Value: %2")
-					.arg( msg.m_nData1 ).arg( msg.m_nData2 ) );
 				handleControlChangeMessage( msg );
 				break;
 
 		case MidiMessage::PROGRAM_CHANGE:
-				INFOLOG( QString( "[handleMidiMessage] PROGRAM_CHANGE Value: %1" )
-					.arg( msg.m_nData1 ) );
 				handleProgramChangeMessage( msg );
 				break;
 
@@ -173,44 +164,32 @@ void MidiInput::handleMidiMessage( const MidiMessage& msg )
 		default:
 				ERRORLOG( QString( "unhandled midi message type: %1" ).arg( msg.m_type ) );
 		}
-		INFOLOG("[end of handleMidiMessage]");
 }
 
 void MidiInput::handleControlChangeMessage( const MidiMessage& msg )
 {
 	//INFOLOG( QString( "[handleMidiMessage] CONTROL_CHANGE Parameter: %1, Value: %2" ).arg( msg.m_nData1 ).arg( msg.m_nData2 ) );
+	static const QString sEvent( "CC" );
 	Hydrogen *pHydrogen = Hydrogen::get_instance();
-	MidiActionManager *pMidiActionManager = MidiActionManager::get_instance();
-	MidiMap *pMidiMap = MidiMap::get_instance();
-
-	for ( auto action : pMidiMap->getCCActions( msg.m_nData1 ) ) {
-		action->setValue( QString::number( msg.m_nData2 ) );
 
-		pMidiActionManager->handleAction( action );
-	}
+	MidiActionManager::get_instance()->handleCCActions( msg.m_nData1, msg.m_nData2 );
 
 	if(msg.m_nData1 == 04){
 		__hihat_cc_openess = msg.m_nData2;
 	}
 
-	pHydrogen->m_LastMidiEvent = "CC";
+	pHydrogen->m_LastMidiEvent = sEvent;
 	pHydrogen->m_nLastMidiEventParameter = msg.m_nData1;
 }
 
 void MidiInput::handleProgramChangeMessage( const MidiMessage& msg )
 {
+	static const QString sEvent( "PROGRAM_CHANGE" );
 	Hydrogen *pHydrogen = Hydrogen::get_instance();
-	MidiActionManager *pMidiActionManager = MidiActionManager::get_instance();
-	MidiMap *pMidiMap = MidiMap::get_instance();
 
-	for ( auto action : pMidiMap->getPCActions() ) {
-		if ( action->getType() != "NOTHING" ) {
-			action->setValue( QString::number( msg.m_nData1 ) );
-			pMidiActionManager->handleAction( action );
-		}
-	}
+	MidiActionManager::get_instance()->handlePCActions( msg.m_nData1 );
 
-	pHydrogen->m_LastMidiEvent = "PROGRAM_CHANGE";
+	pHydrogen->m_LastMidiEvent = sEvent;
 	pHydrogen->m_nLastMidiEventParameter = 0;
 }
 
@@ -226,16 +205,14 @@ void MidiInput::handleNoteOnMessage( const MidiMessage& msg )
 		return;
 	}
 
-	MidiActionManager * pMidiActionManager = MidiActionManager::get_instance();
-	MidiMap * pMidiMap = MidiMap::get_instance();
+	static const QString sEvent( "NOTE" );
 	Hydrogen *pHydrogen = Hydrogen::get_instance();
-	AudioEngine* pAudioEngine = pHydrogen->getAudioEngine();
 	auto pPref = Preferences::get_instance();
 
-	pHydrogen->m_LastMidiEvent = "NOTE";
+	pHydrogen->m_LastMidiEvent = sEvent;
 	pHydrogen->m_nLastMidiEventParameter = msg.m_nData1;
 
-	bool bActionSuccess = pMidiActionManager->handleActions( pMidiMap->getNoteActions( msg.m_nData1 ) );
+	bool bActionSuccess = MidiActionManager::get_instance()->handleNoteActions( msg.m_nData1 );
 
 	if ( bActionSuccess && pPref->m_bMidiDiscardNoteAfterAction ) {
 		return;
@@ -293,7 +270,8 @@ void MidiInput::handleNoteOnMessage( const MidiMessage& msg )
 		}
 	}
 
-	pHydrogen->addRealtimeNote( nInstrument, fVelocity, fPan, false, nNote );
+	pHydrogen->addRealtimeNote( nInstrument, fVelocity, fPan, false, nNote,
+								 msg.m_nTimestamp, msg.m_nJackFrameTime );
 }
 
 /*
@@ -345,7 +323,8 @@ void MidiInput::handleNoteOffMessage( const MidiMessage& msg, bool CymbalChoke )
 		return;
 	}
 
-	Hydrogen::get_instance()->addRealtimeNote( nInstrument, 0.0, 0.0, true, nNote );
+	Hydrogen::get_instance()->addRealtimeNote( nInstrument, 0.0, 0.0, true, nNote,
+											   msg.m_nTimestamp, msg.m_nJackFrameTime );
 }
 
 void MidiInput::handleSysexMessage( const MidiMessage& msg )
@@ -0,0 +1,201 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef SAMPLE_CONVERSION_H
+#define SAMPLE_CONVERSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace H2Core
+{
+
+/**
+ * Conversion of the two float channels rendered by the #AudioEngine
+ * into the interleaved integer or float formats expected by the audio
+ * hardware.
+ *
+ * All integer conversions saturate. Samples exceeding [-1,1] are
+ * clipped to the largest representable value instead of wrapping
+ * around. The functions do neither allocate nor lock and can be used
+ * from within the audio thread.
+ */
+namespace SampleConversion
+{
+	enum class Format {
+		/** 32 bit IEEE float. Written as is without clipping.*/
+		Float,
+		S32,
+		/** 24 bit integer packed into 3 bytes.*/
+		S24_3,
+		S16
+	};
+
+	inline int getBytesPerSample( Format format ) {
+		switch ( format ) {
+		case Format::Float:
+		case Format::S32:
+			return 4;
+		case Format::S24_3:
+			return 3;
+		case Format::S16:
+			return 2;
+		}
+		return 0;
+	}
+
+	/** Largest float smaller than 2^31. Used to clip S32 samples
+	 * since 2^31 itself can not be represented by int32_t.*/
+	static constexpr float fMaxS32 = 2147483520.f;
+
+	/** Scales and clips @a fSample to [-@a fScale, @a fMax] and rounds
+	 * to the nearest integer. NaN is mapped to 0.*/
+	inline int32_t saturate( float fSample, float fScale, float fMax ) {
+		float fValue = fSample * fScale;
+		if ( fValue > fMax ) {
+			fValue = fMax;
+		} else if ( fValue < -fScale ) {
+			fValue = -fScale;
+		} else if ( std::isnan( fValue ) ) {
+			fValue = 0;
+		}
+		return static_cast<int32_t>( std::lrint( fValue ) );
+	}
+
+#if defined(__SSE2__)
+	/** SIMD version of saturate() without the rounding.*/
+	inline __m128 saturate( __m128 samples, __m128 scale, __m128 min, __m128 max ) {
+		const __m128 values = _mm_mul_ps( samples, scale );
+		// Zero NaNs. Otherwise _mm_cvtps_epi32() would turn them into
+		// the 0x80000000 "integer indefinite" value.
+		return _mm_min_ps( _mm_max_ps( _mm_and_ps( values, _mm_cmpord_ps( values, values ) ),
+									   min ), max );
+	}
+#endif
+
+	/**
+	 * Converts @a nFrames of @a pL and @a pR into @a nFrames
+	 * interleaved stereo 32 bit integers at @a pDst scaled by @a
+	 * fScale and clipped to [-@a fScale, @a fMax].
+	 */
+	inline void interleaveInt32( const float* pL, const float* pR, int32_t* pDst,
+								int nFrames, float fScale, float fMax ) {
+		int ii = 0;
+#if defined(__SSE2__)
+		const __m128 scale = _mm_set1_ps( fScale );
+		const __m128 max = _mm_set1_ps( fMax );
+		const __m128 min = _mm_set1_ps( -fScale );
+		for ( ; ii + 4 <= nFrames; ii += 4 ) {
+			const __m128 l = saturate( _mm_loadu_ps( pL + ii ), scale, min, max );
+			const __m128 r = saturate( _mm_loadu_ps( pR + ii ), scale, min, max );
+			const __m128i nL = _mm_cvtps_epi32( l );
+			const __m128i nR = _mm_cvtps_epi32( r );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + 2 * ii ),
+							  _mm_unpacklo_epi32( nL, nR ) );
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + 2 * ii + 4 ),
+							  _mm_unpackhi_epi32( nL, nR ) );
+		}
+#endif
+		for ( ; ii < nFrames; ++ii ) {
+			pDst[ 2 * ii ] = saturate( pL[ ii ], fScale, fMax );
+			pDst[ 2 * ii + 1 ] = saturate( pR[ ii ], fScale, fMax );
+		}
+	}
+
+	inline void interleaveS16( const float* pL, const float* pR, int16_t* pDst,
+							   int nFrames ) {
+		int ii = 0;
+#if defined(__SSE2__)
+		const __m128 scale = _mm_set1_ps( 32768.f );
+		const __m128 max = _mm_set1_ps( 32767.f );
+		const __m128 min = _mm_set1_ps( -32768.f );
+		for ( ; ii + 4 <= nFrames; ii += 4 ) {
+			const __m128 l = saturate( _mm_loadu_ps( pL + ii ), scale, min, max );
+			const __m128 r = saturate( _mm_loadu_ps( pR + ii ), scale, min, max );
+			const __m128i nLR = _mm_packs_epi32( _mm_cvtps_epi32( l ), _mm_cvtps_epi32( r ) );
+			// nLR holds l0..l3 followed by r0..r3.
+			_mm_storeu_si128( reinterpret_cast<__m128i*>( pDst + 2 * ii ),
+							  _mm_unpacklo_epi16( nLR, _mm_srli_si128( nLR, 8 ) ) );
+		}
+#endif
+		for ( ; ii < nFrames; ++ii ) {
+			pDst[ 2 * ii ] = static_cast<int16_t>( saturate( pL[ ii ], 32768.f, 32767.f ) );
+			pDst[ 2 * ii + 1 ] = static_cast<int16_t>( saturate( pR[ ii ], 32768.f, 32767.f ) );
+		}
+	}
+
+	/**
+	 * Writes @a nFrames of @a pL and @a pR interleaved and converted
+	 * to @a format into @a pDst.
+	 *
+	 * @a pDst must provide room for
+	 * 2 * @a nFrames * getBytesPerSample() bytes.
+	 */
+	inline void interleave( Format format, const float* pL, const float* pR,
+							void* pDst, int nFrames ) {
+		switch ( format ) {
+		case Format::Float: {
+			float* pOut = static_cast<float*>( pDst );
+			for ( int ii = 0; ii < nFrames; ++ii ) {
+				pOut[ 2 * ii ] = pL[ ii ];
+				pOut[ 2 * ii + 1 ] = pR[ ii ];
+			}
+			break;
+		}
+		case Format::S32:
+			interleaveInt32( pL, pR, static_cast<int32_t*>( pDst ), nFrames,
+							 2147483648.f, fMaxS32 );
+			break;
+		case Format::S24_3: {
+			// Convert chunk-wise into a small buffer on the stack
+			// and pack the lower three bytes of each value
+			// afterwards.
+			static constexpr int nChunk = 64;
+			int32_t buffer[ 2 * nChunk ];
+			uint8_t* pOut = static_cast<uint8_t*>( pDst );
+			for ( int nStart = 0; nStart < nFrames; nStart += nChunk ) {
+				const int nCount = std::min( nChunk, nFrames - nStart );
+				interleaveInt32( pL + nStart, pR + nStart, buffer, nCount,
+								 8388608.f, 8388607.f );
+				for ( int ii = 0; ii < 2 * nCount; ++ii ) {
+					const uint32_t nValue = static_cast<uint32_t>( buffer[ ii ] );
+					*pOut++ = nValue & 0xFF;
+					*pOut++ = ( nValue >> 8 ) & 0xFF;
+					*pOut++ = ( nValue >> 16 ) & 0xFF;
+				}
+			}
+			break;
+		}
+		case Format::S16:
+			interleaveS16( pL, pR, static_cast<int16_t*>( pDst ), nFrames );
+			break;
+		}
+	}
+};
+
+};
+
+#endif
@@ -36,6 +36,7 @@
 
 #include <core/Preferences/Preferences.h>
 #include <core/MidiAction.h>
+#include <core/MidiMap.h>
 
 #include <core/Basics/Drumkit.h>
 
@@ -72,7 +73,7 @@ Action::Action( QString sType ) {
 	m_sParameter1 = "0";
 	m_sParameter2 = "0";
 	m_sParameter3 = "0";
-	m_sValue = "0";
+	m_nValue = 0;
 }
 
 QString Action::toQString( const QString& sPrefix, bool bShort ) const {
@@ -81,14 +82,14 @@ QString Action::toQString( const QString& sPrefix, bool bShort ) const {
 	if ( ! bShort ) {
 		sOutput = QString( "%1[Action]\n" ).arg( sPrefix )
 			.append( QString( "%1%2m_sType: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sType ) )
-			.append( QString( "%1%2m_sValue: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sValue ) )
+			.append( QString( "%1%2m_nValue: %3\n" ).arg( sPrefix ).arg( s ).arg( m_nValue ) )
 			.append( QString( "%1%2m_sParameter1: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sParameter1 ) )
 			.append( QString( "%1%2m_sParameter2: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sParameter2 ) )
 			.append( QString( "%1%2m_sParameter3: %3\n" ).arg( sPrefix ).arg( s ).arg( m_sParameter3 ) );
 	} else {
 		sOutput = QString( "[Action]" )
 			.append( QString( "m_sType: %1\n" ).arg( m_sType ) )
-			.append( QString( "m_sValue: %1\n" ).arg( m_sValue ) )
+			.append( QString( "m_nValue: %1\n" ).arg( m_nValue ) )
 			.append( QString( "m_sParameter1: %1\n" ).arg( m_sParameter1 ) )
 			.append( QString( "m_sParameter2: %1\n" ).arg( m_sParameter2 ) )
 			.append( QString( "m_sParameter3: %1\n" ).arg( m_sParameter3 ) );
@@ -172,6 +173,7 @@ MidiActionManager::MidiActionManager() {
 	m_actionList <<"";
 	for ( const auto& ppAction : m_actionMap ) {
 		m_actionList << ppAction.first;
+		m_actionHandlers.push_back( ppAction.second.first );
 	}
 
 	m_eventList << ""
@@ -198,6 +200,10 @@ MidiActionManager::~MidiActionManager() {
 void MidiActionManager::create_instance() {
 	if ( __instance == nullptr ) {
 		__instance = new MidiActionManager;
+
+		if ( MidiMap::__instance != nullptr ) {
+			MidiMap::get_instance()->updateActionTable();
+		}
 	}
 }
 
@@ -460,8 +466,7 @@ bool MidiActionManager::select_next_pattern_cc_absolute( std::shared_ptr<Action>
 		return false;
 	}
 	
-	bool ok;
-	int row = pAction->getValue().toInt(&ok,10);
+	int row = pAction->getIntValue();
 	
 	if( row > pHydrogen->getSong()->getPatternList()->size() - 1 ||
 		row < 0 ) {
@@ -505,8 +510,7 @@ bool MidiActionManager::select_instrument( std::shared_ptr<Action> pAction, Hydr
 		return false;
 	}
 	
-	bool ok;
-	int  nInstrumentNumber = pAction->getValue().toInt(&ok,10) ;
+	int  nInstrumentNumber = pAction->getIntValue() ;
 	
 
 	if ( pHydrogen->getSong()->getInstrumentList()->size() < nInstrumentNumber ) {
@@ -528,7 +532,7 @@ bool MidiActionManager::effect_level_absolute( std::shared_ptr<Action> pAction,
 	
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int fx_param = pAction->getValue().toInt(&ok,10);
+	int fx_param = pAction->getIntValue();
 	int fx_id = pAction->getParameter2().toInt(&ok,10);
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
@@ -566,7 +570,7 @@ bool MidiActionManager::effect_level_relative( std::shared_ptr<Action> pAction,
 	
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int fx_param = pAction->getValue().toInt(&ok,10);
+	int fx_param = pAction->getIntValue();
 	int fx_id = pAction->getParameter2().toInt(&ok,10);
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
@@ -604,8 +608,7 @@ bool MidiActionManager::master_volume_absolute( std::shared_ptr<Action> pAction,
 		return false;
 	}
 
-	bool ok;
-	int vol_param = pAction->getValue().toInt(&ok,10);
+	int vol_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> song = pHydrogen->getSong();
 
@@ -626,8 +629,7 @@ bool MidiActionManager::master_volume_relative( std::shared_ptr<Action> pAction,
 		return false;
 	}
 
-	bool ok;
-	int vol_param = pAction->getValue().toInt(&ok,10);
+	int vol_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> song = pHydrogen->getSong();
 
@@ -656,7 +658,7 @@ bool MidiActionManager::strip_volume_absolute( std::shared_ptr<Action> pAction,
 
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int vol_param = pAction->getValue().toInt(&ok,10);
+	int vol_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -693,7 +695,7 @@ bool MidiActionManager::strip_volume_relative( std::shared_ptr<Action> pAction,
 
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int vol_param = pAction->getValue().toInt(&ok,10);
+	int vol_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -736,7 +738,7 @@ bool MidiActionManager::pan_absolute( std::shared_ptr<Action> pAction, Hydrogen*
 
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int pan_param = pAction->getValue().toInt(&ok,10);
+	int pan_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -771,7 +773,7 @@ bool MidiActionManager::pan_absolute_sym( std::shared_ptr<Action> pAction, Hydro
 
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int pan_param = pAction->getValue().toInt(&ok,10);
+	int pan_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -808,7 +810,7 @@ bool MidiActionManager::pan_relative( std::shared_ptr<Action> pAction, Hydrogen*
 
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int pan_param = pAction->getValue().toInt(&ok,10);
+	int pan_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -848,7 +850,7 @@ bool MidiActionManager::gain_level_absolute( std::shared_ptr<Action> pAction, Hy
 	
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int gain_param = pAction->getValue().toInt(&ok,10);
+	int gain_param = pAction->getIntValue();
 	int component_id = pAction->getParameter2().toInt(&ok,10);
 	int layer_id = pAction->getParameter3().toInt(&ok,10);
 
@@ -900,7 +902,7 @@ bool MidiActionManager::pitch_level_absolute( std::shared_ptr<Action> pAction, H
 	
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int pitch_param = pAction->getValue().toInt(&ok,10);
+	int pitch_param = pAction->getIntValue();
 	int component_id = pAction->getParameter2().toInt(&ok,10);
 	int layer_id = pAction->getParameter3().toInt(&ok,10);
 
@@ -951,7 +953,7 @@ bool MidiActionManager::filter_cutoff_level_absolute( std::shared_ptr<Action> pA
 	
 	bool ok;
 	int nLine = pAction->getParameter1().toInt(&ok,10);
-	int filter_cutoff_param = pAction->getValue().toInt(&ok,10);
+	int filter_cutoff_param = pAction->getIntValue();
 
 	std::shared_ptr<Song> pSong = pHydrogen->getSong();
 	InstrumentList *pInstrList = pSong->getInstrumentList();
@@ -999,7 +1001,7 @@ bool MidiActionManager::bpm_cc_relative( std::shared_ptr<Action> pAction, Hydrog
 	bool ok;
 	int mult = pAction->getParameter1().toInt(&ok,10);
 	//this value should be 1 to decrement and something other then 1 to increment the bpm
-	int cc_param = pAction->getValue().toInt(&ok,10);
+	int cc_param = pAction->getIntValue();
 
 	if( m_nLastBpmChangeCCParameter == -1) {
 		m_nLastBpmChangeCCParameter = cc_param;
@@ -1045,7 +1047,7 @@ bool MidiActionManager::bpm_fine_cc_relative( std::shared_ptr<Action> pAction, H
 	bool ok;
 	int mult = pAction->getParameter1().toInt(&ok,10);
 	//this value should be 1 to decrement and something other then 1 to increment the bpm
-	int cc_param = pAction->getValue().toInt(&ok,10);
+	int cc_param = pAction->getIntValue();
 
 	if( m_nLastBpmChangeCCParameter == -1) {
 		m_nLastBpmChangeCCParameter = cc_param;
@@ -1306,3 +1308,68 @@ bool MidiActionManager::handleAction(  std::shared_ptr<Action> pAction ) {
 
 	return false;
 }
+
+int MidiActionManager::resolveAction( const QString& sActionType ) const {
+	auto foundActionPair = m_actionMap.find( sActionType );
+	if ( foundActionPair == m_actionMap.end() ) {
+		return -1;
+	}
+
+	return std::distance( m_actionMap.begin(), foundActionPair );
+}
+
+bool MidiActionManager::handleResolvedAction( int nHandler,
+											  const std::shared_ptr<Action>& pAction ) {
+	if ( nHandler < 0 || nHandler >= static_cast<int>(m_actionHandlers.size()) ) {
+		return handleAction( pAction );
+	}
+
+	action_f action = m_actionHandlers[ nHandler ];
+	return (this->*action)( pAction, Hydrogen::get_instance() );
+}
+
+bool MidiActionManager::handleNoteActions( int nNote ) {
+	if ( nNote < 0 || nNote > 127 ) {
+		return false;
+	}
+
+	bool bResult = true;
+	MidiMap::ActionTableReader pTable( MidiMap::get_instance() );
+	for ( const auto& binding : pTable->noteBindings[ nNote ] ) {
+		if ( ! handleResolvedAction( binding.nHandler, binding.pAction ) ) {
+			bResult = false;
+		}
+	}
+
+	return bResult;
+}
+
+bool MidiActionManager::handleCCActions( int nParameter, int nValue ) {
+	if ( nParameter < 0 || nParameter > 127 ) {
+		return false;
+	}
+
+	bool bResult = true;
+	MidiMap::ActionTableReader pTable( MidiMap::get_instance() );
+	for ( const auto& binding : pTable->ccBindings[ nParameter ] ) {
+		binding.pAction->setValue( nValue );
+		if ( ! handleResolvedAction( binding.nHandler, binding.pAction ) ) {
+			bResult = false;
+		}
+	}
+
+	return bResult;
+}
+
+bool MidiActionManager::handlePCActions( int nValue ) {
+	bool bResult = true;
+	MidiMap::ActionTableReader pTable( MidiMap::get_instance() );
+	for ( const auto& binding : pTable->pcBindings ) {
+		binding.pAction->setValue( nValue );
+		if ( ! handleResolvedAction( binding.nHandler, binding.pAction ) ) {
+			bResult = false;
+		}
+	}
+
+	return bResult;
+}
@@ -25,6 +25,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <vector>
 #include <cassert>
 
 /** \ingroup docCore docMIDI */
@@ -46,7 +47,12 @@ class Action : public H2Core::Object<Action> {
 		}
 
 		void setValue( QString text ){
-			m_sValue = text;
+			m_nValue = text.toInt();
+		}
+
+		/** Realtime-safe version used by the MIDI input handling.*/
+		void setValue( int nValue ){
+			m_nValue = nValue;
 		}
 
 		QString getParameter1() const {
@@ -62,7 +68,11 @@ class Action : public H2Core::Object<Action> {
 		}
 
 		QString getValue() const {
-			return m_sValue;
+			return QString::number( m_nValue );
+		}
+
+		int getIntValue() const {
+			return m_nValue;
 		}
 
 		QString getType() const {
@@ -84,7 +94,10 @@ class Action : public H2Core::Object<Action> {
 		QString m_sParameter1;
 		QString m_sParameter2;
 		QString m_sParameter3;
-		QString m_sValue;
+		/** All values passed to an action are MIDI data bytes. Storing
+		 * them as integer avoids string conversions in the MIDI
+		 * input handling.*/
+		int m_nValue;
 };
 
 namespace H2Core
@@ -121,6 +134,12 @@ class MidiActionManager : public H2Core::Object<MidiActionManager>
 		 * many additional Action parameters are required to do so.
 		 */
 	std::map<QString, std::pair<action_f,int>> m_actionMap;
+		/**
+		 * Handlers of #m_actionMap in the order of its keys. Indices
+		 * into this vector are handed out by resolveAction() and
+		 * allow to dispatch actions without comparing strings.
+		 */
+		std::vector<action_f> m_actionHandlers;
 		bool play(std::shared_ptr<Action> , H2Core::Hydrogen * );
 		bool play_stop_pause_toggle(std::shared_ptr<Action> , H2Core::Hydrogen * );
 		bool stop(std::shared_ptr<Action> , H2Core::Hydrogen * );
@@ -187,6 +206,36 @@ class MidiActionManager : public H2Core::Object<MidiActionManager>
 		 * are needed to carry the desired action.
 		 */
 		bool handleAction( std::shared_ptr<Action> );
+
+		/**
+		 * \return Handler index of @a sActionType to be used with
+		 * handleResolvedAction() or -1 in case it is not supported.
+		 */
+		int resolveAction( const QString& sActionType ) const;
+		/**
+		 * Executes @a pAction using the handler previously retrieved
+		 * via resolveAction(). Falls back to handleAction() for
+		 * unresolved ones.
+		 */
+		bool handleResolvedAction( int nHandler, const std::shared_ptr<Action>& pAction );
+
+		/**
+		 * Execute all actions linked to a MIDI event using the
+		 * lock-free MidiMap::ActionTable.
+		 *
+		 * These functions neither lock, allocate, nor work on strings
+		 * themselves and are thus safe to be called by the MIDI
+		 * drivers. (Whether the individual actions are is a different
+		 * story.)
+		 *
+		 * \return true - in case all actions were successul, false - otherwise.
+		 */
+		bool handleNoteActions( int nNote );
+		/** \param nValue Value of the control change message passed to
+		 * all linked actions.*/
+		bool handleCCActions( int nParameter, int nValue );
+		/** \param nValue Program number passed to all linked actions.*/
+		bool handlePCActions( int nValue );
 		/**
 		 * If #__instance equals 0, a new MidiActionManager
 		 * singleton will be created and stored in it.
@@ -199,6 +248,7 @@ class MidiActionManager : public H2Core::Object<MidiActionManager>
 		 * singleton stored in #__instance.
 		 */
 		static MidiActionManager* get_instance() { assert(__instance); return __instance; }
+		static bool instanceExists() { return __instance != nullptr; }
 
 		QStringList getActionList(){
 			return m_actionList;
@@ -44,6 +44,8 @@
 MidiMap * MidiMap::__instance = nullptr;
 
 MidiMap::MidiMap()
+	: m_pActionTable( nullptr )
+	, m_nActionTableReaders( 0 )
 {
 	__instance = this;
 	QMutexLocker mx(&__mutex);
@@ -51,12 +53,20 @@ MidiMap::MidiMap()
 	// Constructor
 	m_pcActionVector.resize( 1 );
 	m_pcActionVector[ 0 ] = std::make_shared<Action>("NOTHING");
+
+	rebuildActionTable();
 }
 
 MidiMap::~MidiMap()
 {
 	QMutexLocker mx(&__mutex);
 
+	delete m_pActionTable.exchange( nullptr );
+	for ( auto pTable : m_retiredActionTables ) {
+		delete pTable;
+	}
+	m_retiredActionTables.clear();
+
 	__instance = nullptr;
 }
 
@@ -89,6 +99,8 @@ void MidiMap::reset()
 	m_pcActionVector.clear();
 	m_pcActionVector.resize( 1 );
 	m_pcActionVector[ 0 ] = std::make_shared<Action>("NOTHING");
+
+	rebuildActionTable();
 }
 
 void MidiMap::registerMMCEvent( QString sEventString, std::shared_ptr<Action> pAction )
@@ -128,6 +140,7 @@ void MidiMap::registerNoteEvent( int nNote, std::shared_ptr<Action> pAction )
 	}
 
 	m_noteActionMap.insert( { nNote, pAction } );
+	rebuildActionTable();
 }
 
 void MidiMap::registerCCEvent( int nParameter, std::shared_ptr<Action> pAction ){
@@ -149,6 +162,7 @@ void MidiMap::registerCCEvent( int nParameter, std::shared_ptr<Action> pAction )
 	}
 
 	m_ccActionMap.insert( { nParameter, pAction } );
+	rebuildActionTable();
 }
 
 void MidiMap::registerPCEvent( std::shared_ptr<Action> pAction ){
@@ -163,6 +177,7 @@ void MidiMap::registerPCEvent( std::shared_ptr<Action> pAction ){
 	}
 
 	m_pcActionVector.push_back( pAction );
+	rebuildActionTable();
 }
 
 std::vector<std::shared_ptr<Action>> MidiMap::getMMCActions( QString sEventString )
@@ -235,3 +250,58 @@ std::vector<int> MidiMap::findCCValuesByActionType( QString sActionType ) {
 	
 	return std::move( values );
 }
+
+void MidiMap::updateActionTable() {
+	QMutexLocker mx(&__mutex);
+	rebuildActionTable();
+}
+
+void MidiMap::rebuildActionTable() {
+	// The MidiActionManager is created after the MidiMap. Bindings
+	// created before are resolved in updateActionTable().
+	MidiActionManager* pManager = MidiActionManager::instanceExists() ?
+		MidiActionManager::get_instance() : nullptr;
+	auto resolve = [&]( std::shared_ptr<Action> pAction ) {
+		const int nHandler = pManager != nullptr ?
+			pManager->resolveAction( pAction->getType() ) : -1;
+		return Binding{ pAction, nHandler };
+	};
+
+	auto pTable = new ActionTable;
+	for ( const auto& it : m_noteActionMap ) {
+		pTable->noteBindings[ it.first ].push_back( resolve( it.second ) );
+	}
+	for ( const auto& it : m_ccActionMap ) {
+		pTable->ccBindings[ it.first ].push_back( resolve( it.second ) );
+	}
+	for ( const auto& pAction : m_pcActionVector ) {
+		if ( pAction != nullptr && pAction->getType() != "NOTHING" ) {
+			pTable->pcBindings.push_back( resolve( pAction ) );
+		}
+	}
+
+	ActionTable* pOldTable = m_pActionTable.exchange( pTable );
+	if ( pOldTable != nullptr ) {
+		m_retiredActionTables.push_back( pOldTable );
+	}
+
+	// Readers register themselves before loading the table. If there
+	// are none right after the exchange, no one can still access any
+	// of the retired tables.
+	if ( m_nActionTableReaders.load() == 0 ) {
+		for ( auto pRetiredTable : m_retiredActionTables ) {
+			delete pRetiredTable;
+		}
+		m_retiredActionTables.clear();
+	}
+}
+
+MidiMap::ActionTableReader::ActionTableReader( MidiMap* pMidiMap )
+	: m_pMidiMap( pMidiMap ) {
+	m_pMidiMap->m_nActionTableReaders.fetch_add( 1 );
+	m_pTable = m_pMidiMap->m_pActionTable.load();
+}
+
+MidiMap::ActionTableReader::~ActionTableReader() {
+	m_pMidiMap->m_nActionTableReaders.fetch_sub( 1 );
+}
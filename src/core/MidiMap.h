@@ -22,6 +22,7 @@
 #ifndef MIDIMAP_H
 #define MIDIMAP_H
 
+#include <atomic>
 #include <memory>
 #include <vector>
 #include <map>
@@ -44,6 +45,51 @@ public:
 	 */
 	static MidiMap* __instance;
 	~MidiMap();
+
+	/** Action linked to an event together with the handler resolved
+	 * by MidiActionManager::resolveAction().*/
+	struct Binding {
+		std::shared_ptr<Action> pAction;
+		/** -1 in case the action type could not be resolved (yet).*/
+		int nHandler;
+	};
+
+	/**
+	 * Immutable snapshot of all note, CC, and program change actions
+	 * indexed by note number or CC parameter.
+	 *
+	 * It is rebuilt each time the mapping changes and accessed by the
+	 * MIDI input handling using an ActionTableReader. This way the
+	 * driver threads - including the JACK process callback - never
+	 * have to lock #__mutex, copy the multimaps, or compare action
+	 * type strings. The MIDI channel is not part of the key since the
+	 * map itself is channel-agnostic and channel filtering is done in
+	 * MidiInput::handleMidiMessage().
+	 */
+	struct ActionTable {
+		std::vector<Binding> noteBindings[ 128 ];
+		std::vector<Binding> ccBindings[ 128 ];
+		std::vector<Binding> pcBindings;
+	};
+
+	/**
+	 * Provides lock-free access to the current ActionTable for the
+	 * lifetime of the object. Tables replaced in the meantime are not
+	 * freed till all readers are done.
+	 */
+	class ActionTableReader {
+	public:
+		ActionTableReader( MidiMap* pMidiMap );
+		~ActionTableReader();
+
+		const ActionTable* operator->() const {
+			return m_pTable;
+		}
+
+	private:
+		MidiMap* m_pMidiMap;
+		const ActionTable* m_pTable;
+	};
 		
 	/**
 	 * If #__instance equals 0, a new MidiMap singleton will
@@ -89,14 +135,32 @@ public:
 		
 	std::vector<int> findCCValuesByActionParam1( QString sActionType, QString sParam1 );
 	std::vector<int> findCCValuesByActionType( QString sActionType );
+
+	/**
+	 * Resolves the handlers of all registered actions again.
+	 *
+	 * Called by MidiActionManager::create_instance() since the
+	 * mapping is usually loaded from the Preferences before the
+	 * MidiActionManager exists.
+	 */
+	void updateActionTable();
 private:
 	MidiMap();
 
+	/** Builds a new ActionTable from the multimaps and publishes
+	 * it. Has to be called with #__mutex locked.*/
+	void rebuildActionTable();
+
 	std::multimap<int, std::shared_ptr<Action>> m_noteActionMap;
 	std::multimap<int, std::shared_ptr<Action>> m_ccActionMap;
 	std::multimap<QString, std::shared_ptr<Action>> m_mmcActionMap;
 	std::vector<std::shared_ptr<Action>> m_pcActionVector;
 
+	std::atomic<ActionTable*> m_pActionTable;
+	/** Number of ActionTableReader currently alive.*/
+	std::atomic<int> m_nActionTableReaders;
+	/** Replaced tables which might still be in use by a reader.*/
+	std::vector<ActionTable*> m_retiredActionTables;
 
 	QMutex __mutex;
 };
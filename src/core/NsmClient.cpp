@@ -27,6 +27,7 @@
 #include "core/Hydrogen.h"
 #include "core/Basics/Song.h"
 #include "core/AudioEngine/AudioEngine.h"
+#include "core/Sampler/Sampler.h"
 #include "core/NsmClient.h"
 
 #include <QDir>
@@ -188,6 +189,8 @@ void NsmClient::copyPreferences( const char* name ) {
 		}
 	}
 
+	pHydrogen->getAudioEngine()->getSampler()->updateSamplePrefetcher();
+
 	// If the GUI is active, we have to update it to reflect the
 	// changes in the preferences.
 	if ( pHydrogen->getGUIState() == H2Core::Hydrogen::GUIState::ready ) {
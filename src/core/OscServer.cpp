@@ -24,6 +24,7 @@
 #include "core/Helpers/Filesystem.h"
 #include "core/Preferences/Preferences.h"
 
+#include <cstring>
 #include <pthread.h>
 #include <unistd.h>
 
@@ -145,7 +146,254 @@ QString OscServer::qPrettyPrint(lo_type type,void * data)
 }
 
 
-/* catch any incoming messages and display them. returning 1 means that the
+const std::unordered_map<std::string_view, OscServer::Command>& OscServer::commandTable()
+{
+	// Paths ending in a strip number. These are used by TouchOSC
+	// multi-fader widgets.
+	static const std::pair<const char*, StripHandler> stripMethods[] = {
+		{ "STRIP_VOLUME_ABSOLUTE", []( int nStrip, float fValue ) {
+			STRIP_VOLUME_ABSOLUTE_Handler( nStrip, fValue ); } },
+		{ "STRIP_VOLUME_RELATIVE", []( int nStrip, float fValue ) {
+			STRIP_VOLUME_RELATIVE_Handler( QString::number( nStrip ),
+										   QString::number( fValue, 'f', 0 ) ); } },
+		{ "PAN_ABSOLUTE", []( int nStrip, float fValue ) {
+			H2Core::Hydrogen::get_instance()->getCoreActionController()->
+				setStripPan( nStrip, fValue, false ); } },
+		{ "PAN_ABSOLUTE_SYM", []( int nStrip, float fValue ) {
+			H2Core::Hydrogen::get_instance()->getCoreActionController()->
+				setStripPanSym( nStrip, fValue, false ); } },
+		{ "PAN_RELATIVE", []( int nStrip, float fValue ) {
+			std::shared_ptr<Action> pAction = std::make_shared<Action>("PAN_RELATIVE");
+			pAction->setParameter1( QString::number( nStrip ) );
+			pAction->setParameter2( QString::number( fValue, 'f', 0 ) );
+			MidiActionManager::get_instance()->handleAction( pAction ); } },
+		{ "FILTER_CUTOFF_LEVEL_ABSOLUTE", []( int nStrip, float fValue ) {
+			FILTER_CUTOFF_LEVEL_ABSOLUTE_Handler( QString::number( nStrip ),
+												  QString::number( fValue, 'f', 0 ) ); } },
+		{ "STRIP_MUTE_TOGGLE", []( int nStrip, float ) {
+			H2Core::Hydrogen::get_instance()->getCoreActionController()->
+				toggleStripIsMuted( nStrip ); } },
+		{ "STRIP_SOLO_TOGGLE", []( int nStrip, float ) {
+			H2Core::Hydrogen::get_instance()->getCoreActionController()->
+				toggleStripIsSoloed( nStrip ); } },
+	};
+
+	// Commands registered without argument also accept a float
+	// because of the limitations of TouchOSC.
+	static const std::tuple<const char*, const char*, Handler> methods[] = {
+		{ "PLAY", "", PLAY_Handler },
+		{ "PLAY", "f", PLAY_Handler },
+		{ "PLAY_STOP_TOGGLE", "", PLAY_STOP_TOGGLE_Handler },
+		{ "PLAY_STOP_TOGGLE", "f", PLAY_STOP_TOGGLE_Handler },
+		{ "PLAY_PAUSE_TOGGLE", "", PLAY_PAUSE_TOGGLE_Handler },
+		{ "PLAY_PAUSE_TOGGLE", "f", PLAY_PAUSE_TOGGLE_Handler },
+		{ "STOP", "", STOP_Handler },
+		{ "STOP", "f", STOP_Handler },
+		{ "PAUSE", "", PAUSE_Handler },
+		{ "PAUSE", "f", PAUSE_Handler },
+
+		{ "RECORD_READY", "", RECORD_READY_Handler },
+		{ "RECORD_READY", "f", RECORD_READY_Handler },
+		{ "RECORD_STROBE_TOGGLE", "", RECORD_STROBE_TOGGLE_Handler },
+		{ "RECORD_STROBE_TOGGLE", "f", RECORD_STROBE_TOGGLE_Handler },
+		{ "RECORD_STROBE", "", RECORD_STROBE_Handler },
+		{ "RECORD_STROBE", "f", RECORD_STROBE_Handler },
+		{ "RECORD_EXIT", "", RECORD_EXIT_Handler },
+		{ "RECORD_EXIT", "f", RECORD_EXIT_Handler },
+
+		{ "MUTE", "", MUTE_Handler },
+		{ "MUTE", "f", MUTE_Handler },
+		{ "UNMUTE", "", UNMUTE_Handler },
+		{ "UNMUTE", "f", UNMUTE_Handler },
+		{ "MUTE_TOGGLE", "", MUTE_TOGGLE_Handler },
+		{ "MUTE_TOGGLE", "f", MUTE_TOGGLE_Handler },
+
+		{ "NEXT_BAR", "", NEXT_BAR_Handler },
+		{ "NEXT_BAR", "f", NEXT_BAR_Handler },
+		{ "PREVIOUS_BAR", "", PREVIOUS_BAR_Handler },
+		{ "PREVIOUS_BAR", "f", PREVIOUS_BAR_Handler },
+
+		{ "BPM", "f", BPM_Handler },
+		{ "BPM_DECR", "f", BPM_DECR_Handler },
+		{ "BPM_INCR", "f", BPM_INCR_Handler },
+
+		{ "MASTER_VOLUME_ABSOLUTE", "f", MASTER_VOLUME_ABSOLUTE_Handler },
+		{ "MASTER_VOLUME_RELATIVE", "f", MASTER_VOLUME_RELATIVE_Handler },
+
+		{ "SELECT_NEXT_PATTERN", "f", SELECT_NEXT_PATTERN_Handler },
+		{ "SELECT_AND_PLAY_PATTERN", "f", SELECT_AND_PLAY_PATTERN_Handler },
+
+		{ "BEATCOUNTER", "", BEATCOUNTER_Handler },
+		{ "BEATCOUNTER", "f", BEATCOUNTER_Handler },
+
+		{ "TAP_TEMPO", "", TAP_TEMPO_Handler },
+		{ "TAP_TEMPO", "f", TAP_TEMPO_Handler },
+
+		{ "PLAYLIST_SONG", "f", PLAYLIST_SONG_Handler },
+		{ "PLAYLIST_NEXT_SONG", "", PLAYLIST_NEXT_SONG_Handler },
+		{ "PLAYLIST_NEXT_SONG", "f", PLAYLIST_NEXT_SONG_Handler },
+		{ "PLAYLIST_PREV_SONG", "", PLAYLIST_PREV_SONG_Handler },
+		{ "PLAYLIST_PREV_SONG", "f", PLAYLIST_PREV_SONG_Handler },
+
+		{ "TOGGLE_METRONOME", "", TOGGLE_METRONOME_Handler },
+		{ "TOGGLE_METRONOME", "f", TOGGLE_METRONOME_Handler },
+
+		{ "SELECT_INSTRUMENT", "f", SELECT_INSTRUMENT_Handler },
+
+		{ "UNDO_ACTION", "", UNDO_ACTION_Handler },
+		{ "UNDO_ACTION", "f", UNDO_ACTION_Handler },
+		{ "REDO_ACTION", "", REDO_ACTION_Handler },
+		{ "REDO_ACTION", "f", REDO_ACTION_Handler },
+
+		{ "NEW_SONG", "s", NEW_SONG_Handler },
+		{ "OPEN_SONG", "s", OPEN_SONG_Handler },
+		{ "SAVE_SONG", "", SAVE_SONG_Handler },
+		{ "SAVE_SONG", "f", SAVE_SONG_Handler },
+		{ "SAVE_SONG_AS", "s", SAVE_SONG_AS_Handler },
+		{ "SAVE_PREFERENCES", "", SAVE_SONG_Handler },
+		{ "SAVE_PREFERENCES", "f", SAVE_SONG_Handler },
+		{ "QUIT", "", QUIT_Handler },
+		{ "QUIT", "f", QUIT_Handler },
+
+		{ "TIMELINE_ACTIVATION", "f", TIMELINE_ACTIVATION_Handler },
+		{ "TIMELINE_ADD_MARKER", "ff", TIMELINE_ADD_MARKER_Handler },
+		{ "TIMELINE_DELETE_MARKER", "f", TIMELINE_DELETE_MARKER_Handler },
+
+		{ "JACK_TRANSPORT_ACTIVATION", "f", JACK_TRANSPORT_ACTIVATION_Handler },
+		{ "JACK_TIMEBASE_MASTER_ACTIVATION", "f", JACK_TIMEBASE_MASTER_ACTIVATION_Handler },
+		{ "SONG_MODE_ACTIVATION", "f", SONG_MODE_ACTIVATION_Handler },
+		{ "LOOP_MODE_ACTIVATION", "f", LOOP_MODE_ACTIVATION_Handler },
+		{ "RELOCATE", "f", RELOCATE_Handler },
+		{ "NEW_PATTERN", "s", NEW_PATTERN_Handler },
+		{ "OPEN_PATTERN", "s", OPEN_PATTERN_Handler },
+		{ "REMOVE_PATTERN", "f", REMOVE_PATTERN_Handler },
+		{ "SONG_EDITOR_TOGGLE_GRID_CELL", "ff", SONG_EDITOR_TOGGLE_GRID_CELL_Handler },
+		{ "LOAD_DRUMKIT", "s", LOAD_DRUMKIT_Handler },
+		{ "LOAD_DRUMKIT", "sf", LOAD_DRUMKIT_Handler },
+		{ "UPGRADE_DRUMKIT", "s", UPGRADE_DRUMKIT_Handler },
+		{ "UPGRADE_DRUMKIT", "ss", UPGRADE_DRUMKIT_Handler },
+		{ "VALIDATE_DRUMKIT", "s", VALIDATE_DRUMKIT_Handler },
+		{ "EXTRACT_DRUMKIT", "s", EXTRACT_DRUMKIT_Handler },
+		{ "EXTRACT_DRUMKIT", "ss", EXTRACT_DRUMKIT_Handler },
+		{ "DSP_PROFILE", "", DSP_PROFILE_Handler },
+		{ "DSP_PROFILE", "f", DSP_PROFILE_Handler },
+		{ "DSP_PROFILE_RESET", "", DSP_PROFILE_RESET_Handler },
+		{ "DSP_PROFILE_RESET", "f", DSP_PROFILE_RESET_Handler },
+	};
+
+	// Built once on first use. Keys point to the static string
+	// literals above.
+	static const std::unordered_map<std::string_view, Command> table = []() {
+		std::unordered_map<std::string_view, Command> table;
+		auto getCommand = [&]( const char* sName ) -> Command& {
+			auto& command = table[ sName ];
+			if ( command.sPath.empty() ) {
+				command.sPath = std::string( "/Hydrogen/" ) + sName;
+				command.stripHandler = nullptr;
+			}
+			return command;
+		};
+
+		for ( const auto& [ sName, sTypes, handler ] : methods ) {
+			getCommand( sName ).handlers.push_back( { sTypes, handler } );
+		}
+		for ( const auto& [ sName, handler ] : stripMethods ) {
+			getCommand( sName ).stripHandler = handler;
+		}
+		return table;
+	}();
+
+	return table;
+}
+
+const OscServer::Command* OscServer::lookupPath( const char* sPath, int* pStrip )
+{
+	static constexpr std::string_view sPrefix( "/Hydrogen/" );
+
+	*pStrip = -1;
+	if ( sPath == nullptr ||
+		 std::strncmp( sPath, sPrefix.data(), sPrefix.size() ) != 0 ) {
+		return nullptr;
+	}
+
+	const char* sName = sPath + sPrefix.size();
+	const char* sSlash = std::strchr( sName, '/' );
+	const std::string_view name( sName, sSlash != nullptr ?
+								 sSlash - sName : std::strlen( sName ) );
+
+	const auto& table = commandTable();
+	const auto it = table.find( name );
+	if ( it == table.end() ) {
+		return nullptr;
+	}
+
+	if ( sSlash != nullptr ) {
+		// Strip number. Only digits are allowed and they must not
+		// exceed the range of an int.
+		const char* sDigits = sSlash + 1;
+		if ( *sDigits == '\0' || it->second.stripHandler == nullptr ) {
+			return nullptr;
+		}
+		int nStrip = 0;
+		for ( const char* c = sDigits; *c != '\0'; ++c ) {
+			if ( *c < '0' || *c > '9' || nStrip > 100000 ) {
+				return nullptr;
+			}
+			nStrip = nStrip * 10 + ( *c - '0' );
+		}
+		*pStrip = nStrip;
+	}
+
+	return &it->second;
+}
+
+bool OscServer::dispatch( const Command& command, const char* types,
+						  lo_arg** argv, int argc )
+{
+	const int nTypes = std::strlen( types );
+
+	// Prefer an exact match of the typespec but also accept numerical
+	// arguments of different type the same way liblo does.
+	for ( const bool bCoerce : { false, true } ) {
+		for ( const auto& [ sTypes, handler ] : command.handlers ) {
+			if ( static_cast<int>( sTypes.size() ) != argc || nTypes != argc ) {
+				continue;
+			}
+			if ( ! bCoerce ) {
+				if ( sTypes == types ) {
+					handler( argv, argc );
+					return true;
+				}
+				continue;
+			}
+
+			lo_arg coerced[ nMaxArguments ];
+			lo_arg* args[ nMaxArguments ];
+			bool bMatch = argc <= nMaxArguments;
+			for ( int ii = 0; bMatch && ii < argc; ++ii ) {
+				const lo_type typeTo = static_cast<lo_type>( sTypes[ ii ] );
+				const lo_type typeFrom = static_cast<lo_type>( types[ ii ] );
+				if ( typeTo == typeFrom ) {
+					args[ ii ] = argv[ ii ];
+				} else if ( lo_is_numerical_type( typeTo ) &&
+							lo_is_numerical_type( typeFrom ) &&
+							lo_coerce( typeTo, &coerced[ ii ], typeFrom, argv[ ii ] ) ) {
+					args[ ii ] = &coerced[ ii ];
+				} else {
+					bMatch = false;
+				}
+			}
+			if ( bMatch ) {
+				handler( args, argc );
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/* catch any incoming messages and dispatch them. returning 1 means that the
  * message has not been fully handled and the server should try other methods */
 int OscServer::generic_handler(const char *	path,
 							   const char *	types,
@@ -155,115 +403,53 @@ int OscServer::generic_handler(const char *	path,
 							   void *		user_data)
 {
 	auto pHydrogen = H2Core::Hydrogen::get_instance();
-	auto pController = pHydrogen->getCoreActionController();
 	auto pSong = pHydrogen->getSong();
 
 	if ( pSong == nullptr ) {
 		ERRORLOG( "No song set yet" );
 		return 0;
 	}
-	
-	int nNumberOfStrips = pHydrogen->getSong()->getInstrumentList()->size();
-	
-	//First we're trying to map TouchOSC messages from multi-fader widgets
-	QString oscPath( path );
-	QRegExp rxStripVol( "/Hydrogen/STRIP_VOLUME_ABSOLUTE/(\\d+)" );
-	int pos = rxStripVol.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripVol.cap(1).toInt() -1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				STRIP_VOLUME_ABSOLUTE_Handler( nStrip , argv[0]->f );
-			}
-		}
-	}
 
-	QRegExp rxStripVolRel( "/Hydrogen/STRIP_VOLUME_RELATIVE/(\\d+)" );
-	pos = rxStripVolRel.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripVolRel.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				STRIP_VOLUME_RELATIVE_Handler( QString::number( nStrip ) , QString::number( argv[0]->f, 'f', 0 ) );
-			}
-		}
-	}
-	
-	QRegExp rxStripPanAbs( "/Hydrogen/PAN_ABSOLUTE/(\\d+)" );
-	pos = rxStripPanAbs.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripPanAbs.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				pController->setStripPan( nStrip, argv[0]->f, false );
-			}
+	if ( __logger->should_log( H2Core::Logger::Info ) ) {
+		INFOLOG( QString( "Incoming OSC Message for path %1" ).arg( path ) );
+		for ( int ii = 0; ii < argc; ii++) {
+			QString formattedArgument = qPrettyPrint( (lo_type)types[ii], argv[ii] );
+			INFOLOG(QString("Argument %1: %2 %3").arg(ii).arg(types[ii]).arg(formattedArgument));
 		}
 	}
 
-	QRegExp rxStripPanAbsSym( "/Hydrogen/PAN_ABSOLUTE_SYM/(\\d+)" );
-	pos = rxStripPanAbsSym.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripPanAbsSym.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				pController->setStripPanSym( nStrip, argv[0]->f, false );
-			}
+	int nStrip;
+	const auto pCommand = lookupPath( path, &nStrip );
+	if ( pCommand != nullptr ) {
+		if ( nStrip == -1 ) {
+			return dispatch( *pCommand, types, argv, argc ) ? 0 : 1;
 		}
-	}
-	
-	QRegExp rxStripPanRel( "/Hydrogen/PAN_RELATIVE/(\\d+)" );
-	pos = rxStripPanRel.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripPanRel.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				std::shared_ptr<Action> pAction = std::make_shared<Action>("PAN_RELATIVE");
-				pAction->setParameter1( QString::number( nStrip ) );
-				pAction->setParameter2( QString::number( argv[0]->f, 'f', 0 ) );
-				MidiActionManager::get_instance()->handleAction( pAction );
-			}
+
+		// Strip numbers start at 1.
+		nStrip -= 1;
+		if ( argc == 1 && lo_is_numerical_type( static_cast<lo_type>( types[0] ) ) &&
+			 nStrip > -1 && nStrip < pSong->getInstrumentList()->size() ) {
+			lo_arg value;
+			lo_coerce( LO_FLOAT, &value, static_cast<lo_type>( types[0] ), argv[0] );
+			pCommand->stripHandler( nStrip, value.f );
 		}
+		return 0;
 	}
-	
-	QRegExp rxStripFilterCutoffAbs( "/Hydrogen/FILTER_CUTOFF_LEVEL_ABSOLUTE/(\\d+)" );
-	pos = rxStripFilterCutoffAbs.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripFilterCutoffAbs.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				FILTER_CUTOFF_LEVEL_ABSOLUTE_Handler( QString::number( nStrip ) , QString::number( argv[0]->f, 'f', 0 ) );
+
+	// The address might be an OSC pattern, like /Hydrogen/PLAY*,
+	// matching several commands.
+	if ( std::strpbrk( path, "*?[{" ) != nullptr ) {
+		bool bHandled = false;
+		for ( const auto& [ sName, command ] : commandTable() ) {
+			if ( lo_pattern_match( command.sPath.c_str(), path ) ) {
+				bHandled = dispatch( command, types, argv, argc ) || bHandled;
 			}
 		}
-	}
-	
-	QRegExp rxStripMute( "/Hydrogen/STRIP_MUTE_TOGGLE/(\\d+)" );
-	pos = rxStripMute.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripMute.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				pController->toggleStripIsMuted( nStrip );
-			}
+		if ( bHandled ) {
+			return 0;
 		}
 	}
 	
-	QRegExp rxStripSolo( "/Hydrogen/STRIP_SOLO_TOGGLE/(\\d+)" );
-	pos = rxStripSolo.indexIn( oscPath );
-	if ( pos > -1 ) {
-		if( argc == 1 ){
-			int nStrip = rxStripSolo.cap(1).toInt() - 1;
-			if ( nStrip > -1 && nStrip < nNumberOfStrips ) {
-				pController->toggleStripIsSoloed( nStrip );
-			}
-		}
-	}
-
-	INFOLOG( QString( "Incoming OSC Message for path %1" ).arg( path ) );
-	for ( int ii = 0; ii < argc; ii++) {
-		QString formattedArgument = qPrettyPrint( (lo_type)types[ii], argv[ii] );
-		INFOLOG(QString("Argument %1: %2 %3").arg(ii).arg(types[ii]).arg(formattedArgument));
-	}
-	
 	// Returning 1 means that the message has not been fully handled
 	// and the server should try other methods.
 	return 1;
@@ -908,6 +1094,50 @@ void OscServer::EXTRACT_DRUMKIT_Handler(lo_arg **argv, int argc) {
 	pController->extractDrumkit( QString::fromUtf8( &argv[0]->s ), sTargetDir );
 }
 
+void OscServer::DSP_PROFILE_Handler(lo_arg **argv, int argc) {
+	auto pController = H2Core::Hydrogen::get_instance()->getCoreActionController();
+	const auto report = pController->getDspProfile();
+
+	auto sendHistogram = []( const QString& sName,
+							 const H2Core::DspProfiler::Histogram& histogram,
+							 long long nXruns ) {
+		lo_message reply = lo_message_new();
+		lo_message_add_string( reply, sName.toUtf8().constData() );
+		lo_message_add_int64( reply, histogram.nCount );
+		lo_message_add_float( reply, histogram.getMeanUs() );
+		lo_message_add_float( reply, histogram.fMaxUs );
+		lo_message_add_int64( reply, nXruns );
+		for ( const auto& nnCount : histogram.buckets ) {
+			lo_message_add_int64( reply, nnCount );
+		}
+		OscServer::get_instance()->broadcastMessage( "/Hydrogen/DSP_PROFILE", reply );
+		lo_message_free( reply );
+	};
+
+	for ( int ii = 0; ii < H2Core::DspProfiler::nStages; ++ii ) {
+		sendHistogram( H2Core::DspProfiler::getStageName(
+						   static_cast<H2Core::DspProfiler::Stage>( ii ) ),
+					   report.stages[ ii ], report.xrunsByStage[ ii ] );
+	}
+	for ( int ii = 0; ii < MAX_FX; ++ii ) {
+		if ( report.ladspa[ ii ].nCount > 0 ) {
+			sendHistogram( QString( "Ladspa%1" ).arg( ii ), report.ladspa[ ii ], 0 );
+		}
+	}
+
+	for ( const auto& [ nInstrumentId, fUs ] : report.instruments ) {
+		lo_message reply = lo_message_new();
+		lo_message_add_int32( reply, nInstrumentId );
+		lo_message_add_float( reply, fUs );
+		OscServer::get_instance()->broadcastMessage( "/Hydrogen/DSP_PROFILE_INSTRUMENT", reply );
+		lo_message_free( reply );
+	}
+}
+
+void OscServer::DSP_PROFILE_RESET_Handler(lo_arg **argv, int argc) {
+	H2Core::Hydrogen::get_instance()->getCoreActionController()->resetDspProfile();
+}
+
 // -------------------------------------------------------------------
 // Helper functions
 
@@ -1098,103 +1328,10 @@ bool OscServer::init()
 									return 1;
 								});
 
+	// All other methods are dispatched by the generic handler using
+	// a lookup table.
 	m_pServerThread->add_method(nullptr, nullptr, generic_handler, nullptr);
 
-	m_pServerThread->add_method("/Hydrogen/PLAY", "", PLAY_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAY", "f", PLAY_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAY_STOP_TOGGLE", "", PLAY_STOP_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAY_STOP_TOGGLE", "f", PLAY_STOP_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAY_PAUSE_TOGGLE", "", PLAY_PAUSE_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAY_PAUSE_TOGGLE", "f", PLAY_PAUSE_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/STOP", "", STOP_Handler);
-	m_pServerThread->add_method("/Hydrogen/STOP", "f", STOP_Handler);
-	m_pServerThread->add_method("/Hydrogen/PAUSE", "", PAUSE_Handler);
-	m_pServerThread->add_method("/Hydrogen/PAUSE", "f", PAUSE_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/RECORD_READY", "", RECORD_READY_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_READY", "f", RECORD_READY_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_STROBE_TOGGLE", "", RECORD_STROBE_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_STROBE_TOGGLE", "f", RECORD_STROBE_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_STROBE", "", RECORD_STROBE_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_STROBE", "f", RECORD_STROBE_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_EXIT", "", RECORD_EXIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/RECORD_EXIT", "f", RECORD_EXIT_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/MUTE", "", MUTE_Handler);
-	m_pServerThread->add_method("/Hydrogen/MUTE", "f", MUTE_Handler);
-	m_pServerThread->add_method("/Hydrogen/UNMUTE", "", UNMUTE_Handler);
-	m_pServerThread->add_method("/Hydrogen/UNMUTE", "f", UNMUTE_Handler);
-	m_pServerThread->add_method("/Hydrogen/MUTE_TOGGLE", "", MUTE_TOGGLE_Handler);
-	m_pServerThread->add_method("/Hydrogen/MUTE_TOGGLE", "f", MUTE_TOGGLE_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/NEXT_BAR", "", NEXT_BAR_Handler);
-	m_pServerThread->add_method("/Hydrogen/NEXT_BAR", "f", NEXT_BAR_Handler);
-	m_pServerThread->add_method("/Hydrogen/PREVIOUS_BAR", "", PREVIOUS_BAR_Handler);
-	m_pServerThread->add_method("/Hydrogen/PREVIOUS_BAR", "f", PREVIOUS_BAR_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/BPM", "f", BPM_Handler);
-	m_pServerThread->add_method("/Hydrogen/BPM_DECR", "f", BPM_DECR_Handler);
-	m_pServerThread->add_method("/Hydrogen/BPM_INCR", "f", BPM_INCR_Handler);
-
-	m_pServerThread->add_method("/Hydrogen/MASTER_VOLUME_ABSOLUTE", "f", MASTER_VOLUME_ABSOLUTE_Handler);
-	m_pServerThread->add_method("/Hydrogen/MASTER_VOLUME_RELATIVE", "f", MASTER_VOLUME_RELATIVE_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/SELECT_NEXT_PATTERN", "f", SELECT_NEXT_PATTERN_Handler);
-	m_pServerThread->add_method("/Hydrogen/SELECT_AND_PLAY_PATTERN", "f", SELECT_AND_PLAY_PATTERN_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/BEATCOUNTER", "", BEATCOUNTER_Handler);
-	m_pServerThread->add_method("/Hydrogen/BEATCOUNTER", "f", BEATCOUNTER_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/TAP_TEMPO", "", TAP_TEMPO_Handler);
-	m_pServerThread->add_method("/Hydrogen/TAP_TEMPO", "f", TAP_TEMPO_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/PLAYLIST_SONG", "f", PLAYLIST_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAYLIST_NEXT_SONG", "", PLAYLIST_NEXT_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAYLIST_NEXT_SONG", "f", PLAYLIST_NEXT_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAYLIST_PREV_SONG", "", PLAYLIST_PREV_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/PLAYLIST_PREV_SONG", "f", PLAYLIST_PREV_SONG_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/TOGGLE_METRONOME", "", TOGGLE_METRONOME_Handler);
-	m_pServerThread->add_method("/Hydrogen/TOGGLE_METRONOME", "f", TOGGLE_METRONOME_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/SELECT_INSTRUMENT", "f", SELECT_INSTRUMENT_Handler);
-	
-	m_pServerThread->add_method("/Hydrogen/UNDO_ACTION", "", UNDO_ACTION_Handler);
-	m_pServerThread->add_method("/Hydrogen/UNDO_ACTION", "f", UNDO_ACTION_Handler);
-	m_pServerThread->add_method("/Hydrogen/REDO_ACTION", "", REDO_ACTION_Handler);
-	m_pServerThread->add_method("/Hydrogen/REDO_ACTION", "f", REDO_ACTION_Handler);
-
-	m_pServerThread->add_method("/Hydrogen/NEW_SONG", "s", NEW_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/OPEN_SONG", "s", OPEN_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/SAVE_SONG", "", SAVE_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/SAVE_SONG", "f", SAVE_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/SAVE_SONG_AS", "s", SAVE_SONG_AS_Handler);
-	m_pServerThread->add_method("/Hydrogen/SAVE_PREFERENCES", "", SAVE_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/SAVE_PREFERENCES", "f", SAVE_SONG_Handler);
-	m_pServerThread->add_method("/Hydrogen/QUIT", "", QUIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/QUIT", "f", QUIT_Handler);
-
-	m_pServerThread->add_method("/Hydrogen/TIMELINE_ACTIVATION", "f", TIMELINE_ACTIVATION_Handler);
-	m_pServerThread->add_method("/Hydrogen/TIMELINE_ADD_MARKER", "ff", TIMELINE_ADD_MARKER_Handler);
-	m_pServerThread->add_method("/Hydrogen/TIMELINE_DELETE_MARKER", "f", TIMELINE_DELETE_MARKER_Handler);
-
-	m_pServerThread->add_method("/Hydrogen/JACK_TRANSPORT_ACTIVATION", "f", JACK_TRANSPORT_ACTIVATION_Handler);
-	m_pServerThread->add_method("/Hydrogen/JACK_TIMEBASE_MASTER_ACTIVATION", "f", JACK_TIMEBASE_MASTER_ACTIVATION_Handler);
-	m_pServerThread->add_method("/Hydrogen/SONG_MODE_ACTIVATION", "f", SONG_MODE_ACTIVATION_Handler);
-	m_pServerThread->add_method("/Hydrogen/LOOP_MODE_ACTIVATION", "f", LOOP_MODE_ACTIVATION_Handler);
-	m_pServerThread->add_method("/Hydrogen/RELOCATE", "f", RELOCATE_Handler);
-	m_pServerThread->add_method("/Hydrogen/NEW_PATTERN", "s", NEW_PATTERN_Handler);
-	m_pServerThread->add_method("/Hydrogen/OPEN_PATTERN", "s", OPEN_PATTERN_Handler);
-	m_pServerThread->add_method("/Hydrogen/REMOVE_PATTERN", "f", REMOVE_PATTERN_Handler);
-	m_pServerThread->add_method("/Hydrogen/SONG_EDITOR_TOGGLE_GRID_CELL", "ff", SONG_EDITOR_TOGGLE_GRID_CELL_Handler);
-	m_pServerThread->add_method("/Hydrogen/LOAD_DRUMKIT", "s", LOAD_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/LOAD_DRUMKIT", "sf", LOAD_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/UPGRADE_DRUMKIT", "s", UPGRADE_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/UPGRADE_DRUMKIT", "ss", UPGRADE_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/VALIDATE_DRUMKIT", "s", VALIDATE_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/EXTRACT_DRUMKIT", "s", EXTRACT_DRUMKIT_Handler);
-	m_pServerThread->add_method("/Hydrogen/EXTRACT_DRUMKIT", "ss", EXTRACT_DRUMKIT_Handler);
-
 	m_bInitialized = true;
 	
 	return true;
@@ -30,6 +30,11 @@
 
 #include <core/Object.h>
 #include <cassert>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace lo
 {
@@ -77,6 +82,10 @@ namespace H2Core
 * true. H2Core::Preferences::m_nOscServerPort contains the port number
 * the OSC server will be started at.
 *
+* All handlers are stored in a lookup table keyed by the command name
+* following the \e /Hydrogen/ prefix, see lookupPath(), and are
+* dispatched by generic_handler().
+*
 * Please note that the way generic_handler() is implemented, the
 * additional registration of commands without argument to require a
 * float input, and the usage of float arguments instead of int are all
@@ -122,6 +131,40 @@ class OscServer : public H2Core::Object<OscServer>
 		 */
 		static OscServer* get_instance() { assert(__instance); return __instance; }
 
+		/** Handler of a fixed path, like \e /Hydrogen/PLAY.*/
+		typedef void (*Handler)( lo_arg** argv, int argc );
+		/** Handler of a path ending in a strip number, like \e
+		 * /Hydrogen/PAN_ABSOLUTE/[x].
+		 *
+		 * \param nStrip Zero-based index of the instrument.
+		 * \param fValue Argument of the message.*/
+		typedef void (*StripHandler)( int nStrip, float fValue );
+
+		/** All handlers registered for a single command name.*/
+		struct Command {
+			/** Full path, like \e /Hydrogen/PLAY.*/
+			std::string sPath;
+			/** Typespecs and the handlers registered for them.*/
+			std::vector<std::pair<std::string, Handler>> handlers;
+			/** Handler used in case the path is followed by a strip
+			 * number or nullptr.*/
+			StripHandler stripHandler;
+		};
+
+		/**
+		 * Resolves an OSC path using a hash table of the command
+		 * names built once. Strip numbers are parsed by hand instead
+		 * of by regular expressions.
+		 *
+		 * \param sPath Path of an incoming message.
+		 * \param pStrip Set to the strip number (starting at 1) in case
+		 * @a sPath ends in one and to -1 otherwise.
+		 *
+		 * \return Command registered for @a sPath or nullptr if there
+		 * is none.
+		 */
+		static const Command* lookupPath( const char* sPath, int* pStrip );
+
 		/**
 		 * Converts a data @a data of type @a type into a printable
 		 * QString.
@@ -789,9 +832,32 @@ class OscServer : public H2Core::Object<OscServer>
 		 * in the user's drumkit data folder.
 		 */
 	static void EXTRACT_DRUMKIT_Handler( lo_arg **argv, int argc );
+		/**
+		 * Triggers CoreActionController::getDspProfile() and
+		 * broadcasts the timing statistics of the audio engine.
+		 *
+		 * For each stage of DspProfiler::Stage and each active
+		 * LADSPA slot a \e /Hydrogen/DSP_PROFILE message is sent
+		 * containing the name of the stage, the number of cycles it
+		 * was measured in, its mean and maximum duration in
+		 * microseconds, the number of xruns attributed to it, and
+		 * the DspProfiler::nBuckets counts of its histogram. In
+		 * addition, a \e /Hydrogen/DSP_PROFILE_INSTRUMENT message
+		 * containing the instrument id and the total time spent
+		 * rendering it in microseconds is sent for each instrument.
+		 */
+	static void DSP_PROFILE_Handler( lo_arg **argv, int argc );
+		/**
+		 * Triggers CoreActionController::resetDspProfile().
+		 */
+	static void DSP_PROFILE_RESET_Handler( lo_arg **argv, int argc );
 		/** 
 		 * Catches any incoming messages and display them. 
 		 *
+		 * All handlers are dispatched using lookupPath(). In case the
+		 * typespec of the message does not match the one of a
+		 * handler, numerical arguments are coerced.
+		 *
 		 * It is also responsible for catching OSC messages at the
 		 * following paths and invoking the corresponding functions
 		 * (if only a single argument is present.)
@@ -815,8 +881,9 @@ class OscServer : public H2Core::Object<OscServer>
 		 * \param data Unused.
 		 * \param user_data Unused.
 		 *
-		 * \return 1 - means that the message has not been fully
-		 * handled and the server should try other methods */
+		 * \return 0 - if the message was handled and 1 - means that
+		 * the message has not been fully handled and the server
+		 * should try other methods */
 		static int  generic_handler(const char *path, const char *types, lo_arg ** argv,
 								int argc, lo_message data, void *user_data);
 
@@ -836,6 +903,16 @@ class OscServer : public H2Core::Object<OscServer>
 		/** Helper function which sends a message with msgText to all 
 		 * connected clients. **/
 		void broadcastMessage( const char* msgText, lo_message message);
+
+		/** Maximum number of arguments of all registered handlers.*/
+		static constexpr int nMaxArguments = 4;
+		/** Table of all commands keyed by their name, like \e PLAY.*/
+		static const std::unordered_map<std::string_view, Command>& commandTable();
+		/** Calls the handler of @a command matching @a types.
+		 *
+		 * \return true if a matching handler was found.*/
+		static bool dispatch( const Command& command, const char* types,
+							  lo_arg** argv, int argc );
 	
 		/** Pointer to the H2Core::Preferences singleton. Although it
 		 * could be accessed internally using
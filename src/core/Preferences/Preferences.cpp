@@ -146,6 +146,10 @@ Preferences::Preferences()
 	m_nMaxNotes = 256;
 	m_nBufferSize = 1024;
 	m_nSampleRate = 44100;
+	m_bUseSampleStreaming = false;
+	m_nSampleStreamingPreloadMs = 500;
+	m_nSampleCacheSizeMb = 2048;
+	m_nRenderThreads = 0;
 
 	//___ oss driver properties ___
 	m_sOSSDevice = QString("/dev/dsp");
@@ -202,6 +206,7 @@ Preferences::Preferences()
 #else
 	m_sAlsaAudioDevice = "hw:0";
 #endif
+	m_nAlsaPeriods = 2;
 
 	//___  jack driver properties ___
 	m_sJackPortName1 = QString("alsa_pcm:playback_1");
@@ -428,6 +433,10 @@ void Preferences::loadPreferences( bool bGlobal )
 				m_nMaxNotes = LocalFileMng::readXmlInt( audioEngineNode, "maxNotes", m_nMaxNotes );
 				m_nBufferSize = LocalFileMng::readXmlInt( audioEngineNode, "buffer_size", m_nBufferSize );
 				m_nSampleRate = LocalFileMng::readXmlInt( audioEngineNode, "samplerate", m_nSampleRate );
+				m_bUseSampleStreaming = LocalFileMng::readXmlBool( audioEngineNode, "sample_streaming", m_bUseSampleStreaming );
+				m_nSampleStreamingPreloadMs = LocalFileMng::readXmlInt( audioEngineNode, "sample_streaming_preload", m_nSampleStreamingPreloadMs );
+				m_nSampleCacheSizeMb = LocalFileMng::readXmlInt( audioEngineNode, "sample_cache_size", m_nSampleCacheSizeMb );
+				m_nRenderThreads = LocalFileMng::readXmlInt( audioEngineNode, "render_threads", m_nRenderThreads );
 
 				//// OSS DRIVER ////
 				QDomNode ossDriverNode = audioEngineNode.firstChildElement( "oss_driver" );
@@ -520,6 +529,7 @@ void Preferences::loadPreferences( bool bGlobal )
 					recreate = true;
 				} else {
 					m_sAlsaAudioDevice = LocalFileMng::readXmlString( alsaAudioDriverNode, "alsa_audio_device", m_sAlsaAudioDevice );
+					m_nAlsaPeriods = LocalFileMng::readXmlInt( alsaAudioDriverNode, "alsa_periods", m_nAlsaPeriods );
 				}
 
 				/// MIDI DRIVER ///
@@ -928,6 +938,10 @@ void Preferences::savePreferences()
 		LocalFileMng::writeXmlString( audioEngineNode, "maxNotes", QString("%1").arg( m_nMaxNotes ) );
 		LocalFileMng::writeXmlString( audioEngineNode, "buffer_size", QString("%1").arg( m_nBufferSize ) );
 		LocalFileMng::writeXmlString( audioEngineNode, "samplerate", QString("%1").arg( m_nSampleRate ) );
+		LocalFileMng::writeXmlString( audioEngineNode, "sample_streaming", m_bUseSampleStreaming ? "true": "false" );
+		LocalFileMng::writeXmlString( audioEngineNode, "sample_streaming_preload", QString("%1").arg( m_nSampleStreamingPreloadMs ) );
+		LocalFileMng::writeXmlString( audioEngineNode, "sample_cache_size", QString("%1").arg( m_nSampleCacheSizeMb ) );
+		LocalFileMng::writeXmlString( audioEngineNode, "render_threads", QString("%1").arg( m_nRenderThreads ) );
 
 		//// OSS DRIVER ////
 		QDomNode ossDriverNode = doc.createElement( "oss_driver" );
@@ -1016,6 +1030,7 @@ void Preferences::savePreferences()
 		QDomNode alsaAudioDriverNode = doc.createElement( "alsa_audio_driver" );
 		{
 			LocalFileMng::writeXmlString( alsaAudioDriverNode, "alsa_audio_device", m_sAlsaAudioDevice );
+			LocalFileMng::writeXmlString( alsaAudioDriverNode, "alsa_periods", QString::number( m_nAlsaPeriods ) );
 		}
 		audioEngineNode.appendChild( alsaAudioDriverNode );
 
@@ -201,6 +201,35 @@ public:
 	 * rate of the freshly opened JACK client.
 	 */
 	unsigned			m_nSampleRate;
+	/**
+	 * If set to true, samples longer than
+	 * #m_nSampleStreamingPreloadMs are not loaded into memory as a
+	 * whole but memory-mapped from a decoded copy in
+	 * Filesystem::sample_cache_dir(). Only their beginning is kept
+	 * resident while the rest is read on demand by the
+	 * SamplePrefetcher.
+	 *
+	 * Takes effect for all samples loaded afterwards. The
+	 * SamplePrefetcher, however, is only started right away if the
+	 * option is already set when the Sampler is created.
+	 */
+	bool				m_bUseSampleStreaming;
+	/** Length in milliseconds of the beginning of each streamed
+	 * sample kept in memory. It is rounded up to whole
+	 * SamplePrefetcher::nChunkFrames.*/
+	int					m_nSampleStreamingPreloadMs;
+	/** Maximum size in megabytes of Filesystem::sample_cache_dir().
+	 * The least recently used entries are removed whenever a new
+	 * one was created. See Sample::pruneSampleCache().*/
+	int					m_nSampleCacheSizeMb;
+	/**
+	 * Number of threads rendering the playing notes in addition to
+	 * the audio thread. If set to 0, all notes are rendered in the
+	 * audio thread.
+	 *
+	 * Takes effect after restarting Hydrogen.
+	 */
+	int					m_nRenderThreads;
 
 	//	OSS driver properties ___
 	QString				m_sOSSDevice;		///< Device used for output
@@ -273,6 +302,9 @@ public:
 
 	//	alsa audio driver properties ___
 	QString				m_sAlsaAudioDevice;
+	/** Number of periods of Preferences::m_nBufferSize frames the
+	 * ALSA buffer is made of. At least 2.*/
+	int					m_nAlsaPeriods;
 
 	// PortAudio properties
 	QString				m_sPortAudioDevice;
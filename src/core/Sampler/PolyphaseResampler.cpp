@@ -0,0 +1,184 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/Sampler/PolyphaseResampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace H2Core
+{
+
+/** Zeroth order modified Bessel function of the first kind.*/
+static double besselI0( double fX )
+{
+	double fSum = 1;
+	double fTerm = 1;
+	for ( int ii = 1; ii < 50; ++ii ) {
+		fTerm *= ( fX / ( 2 * ii ) ) * ( fX / ( 2 * ii ) );
+		fSum += fTerm;
+		if ( fTerm < fSum * 1e-12 ) {
+			break;
+		}
+	}
+	return fSum;
+}
+
+PolyphaseResampler::PolyphaseResampler( int nSourceRate, int nTargetRate )
+	: m_nBufferStart( 0 )
+	, m_nInputPosition( 0 )
+	, m_nPhase( 0 )
+	, m_nInputFrames( 0 )
+	, m_nOutputFrames( 0 )
+{
+	if ( nSourceRate <= 0 || nTargetRate <= 0 ) {
+		ERRORLOG( QString( "Invalid sample rates [%1] -> [%2]" )
+				  .arg( nSourceRate ).arg( nTargetRate ) );
+		nSourceRate = nTargetRate = 1;
+	}
+	const int nGcd = std::gcd( nSourceRate, nTargetRate );
+	m_nUp = nTargetRate / nGcd;
+	m_nDown = nSourceRate / nGcd;
+	m_nPhases = std::min( m_nUp, nMaxPhases );
+
+	// Cutoff relative to the Nyquist frequency of the input. When
+	// downsampling it has to be lowered to the one of the output to
+	// prevent aliasing. The transition band lies just below.
+	const double fCutoff = 0.95 * std::min( 1.0, static_cast<double>( m_nUp ) / m_nDown );
+	const int nHalfTaps = static_cast<int>( std::ceil( nZeroCrossings / fCutoff ) );
+	m_nTaps = 2 * nHalfTaps;
+
+	// Stopband attenuation of about 80 dB.
+	const double fBeta = 8.0;
+	const double fNorm = besselI0( fBeta );
+
+	m_coefficients.resize( static_cast<size_t>( m_nPhases ) * m_nTaps );
+	for ( int nnPhase = 0; nnPhase < m_nPhases; ++nnPhase ) {
+		const double fFraction = static_cast<double>( nnPhase ) / m_nPhases;
+		float* pCoefficients = &m_coefficients[ static_cast<size_t>( nnPhase ) * m_nTaps ];
+		double fSum = 0;
+		for ( int nnTap = 0; nnTap < m_nTaps; ++nnTap ) {
+			// Distance in input frames between the output frame and
+			// the input frame the coefficient is applied to.
+			const double fDistance = nnTap - ( nHalfTaps - 1 ) - fFraction;
+			const double fX = fDistance / nHalfTaps;
+			double fValue = 0;
+			if ( std::fabs( fX ) < 1 ) {
+				const double fArg = M_PI * fCutoff * fDistance;
+				const double fSinc = std::fabs( fArg ) < 1e-9 ? 1 : std::sin( fArg ) / fArg;
+				fValue = fCutoff * fSinc *
+					besselI0( fBeta * std::sqrt( 1 - fX * fX ) ) / fNorm;
+			}
+			pCoefficients[ nnTap ] = static_cast<float>( fValue );
+			fSum += fValue;
+		}
+		// Unity gain at DC for every phase.
+		for ( int nnTap = 0; nnTap < m_nTaps; ++nnTap ) {
+			pCoefficients[ nnTap ] = static_cast<float>( pCoefficients[ nnTap ] / fSum );
+		}
+	}
+
+	// Frames preceding the first input frame are treated as silence.
+	m_nBufferStart = -( nHalfTaps - 1 );
+	m_buffer_L.assign( nHalfTaps - 1, 0.f );
+	m_buffer_R.assign( nHalfTaps - 1, 0.f );
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+long long PolyphaseResampler::getOutputFrames( long long nInputFrames ) const
+{
+	return ( nInputFrames * m_nUp + m_nDown - 1 ) / m_nDown;
+}
+
+int PolyphaseResampler::getMaxOutputFrames( int nFrames ) const
+{
+	return static_cast<int>( getOutputFrames( nFrames ) ) + 1;
+}
+
+int PolyphaseResampler::process( const float* pIn_L, const float* pIn_R, int nFrames,
+								 float* pOut_L, float* pOut_R, int nMaxOut )
+{
+	m_buffer_L.insert( m_buffer_L.end(), pIn_L, pIn_L + nFrames );
+	m_buffer_R.insert( m_buffer_R.end(), pIn_R, pIn_R + nFrames );
+	m_nInputFrames += nFrames;
+
+	return render( pOut_L, pOut_R, nMaxOut, getOutputFrames( m_nInputFrames ) );
+}
+
+int PolyphaseResampler::flush( float* pOut_L, float* pOut_R, int nMaxOut )
+{
+	// Pad with silence to complete the window of the last frames.
+	const int nHalfTaps = m_nTaps / 2;
+	m_buffer_L.insert( m_buffer_L.end(), nHalfTaps, 0.f );
+	m_buffer_R.insert( m_buffer_R.end(), nHalfTaps, 0.f );
+
+	return render( pOut_L, pOut_R, nMaxOut, getOutputFrames( m_nInputFrames ) );
+}
+
+int PolyphaseResampler::render( float* pOut_L, float* pOut_R, int nMaxOut, long long nTotal )
+{
+	const int nHalfTaps = m_nTaps / 2;
+	const long long nBufferEnd = m_nBufferStart + static_cast<long long>( m_buffer_L.size() );
+
+	int nWritten = 0;
+	while ( nWritten < nMaxOut && m_nOutputFrames < nTotal &&
+			m_nInputPosition + nHalfTaps < nBufferEnd ) {
+		const size_t nPhase = m_nPhases == m_nUp ? m_nPhase :
+			m_nPhase * m_nPhases / m_nUp;
+		const float* pCoefficients = &m_coefficients[ nPhase * m_nTaps ];
+		const size_t nOffset = m_nInputPosition - ( nHalfTaps - 1 ) - m_nBufferStart;
+		const float* pData_L = &m_buffer_L[ nOffset ];
+		const float* pData_R = &m_buffer_R[ nOffset ];
+
+		float fValue_L = 0;
+		float fValue_R = 0;
+		for ( int nnTap = 0; nnTap < m_nTaps; ++nnTap ) {
+			fValue_L += pData_L[ nnTap ] * pCoefficients[ nnTap ];
+			fValue_R += pData_R[ nnTap ] * pCoefficients[ nnTap ];
+		}
+		pOut_L[ nWritten ] = fValue_L;
+		pOut_R[ nWritten ] = fValue_R;
+		++nWritten;
+		++m_nOutputFrames;
+
+		m_nPhase += m_nDown;
+		m_nInputPosition += m_nPhase / m_nUp;
+		m_nPhase %= m_nUp;
+	}
+
+	// Drop all frames not required by the next output frame anymore.
+	const long long nDiscard = std::min( m_nInputPosition - ( nHalfTaps - 1 ) - m_nBufferStart,
+										 static_cast<long long>( m_buffer_L.size() ) );
+	if ( nDiscard > 0 ) {
+		m_buffer_L.erase( m_buffer_L.begin(), m_buffer_L.begin() + nDiscard );
+		m_buffer_R.erase( m_buffer_R.begin(), m_buffer_R.begin() + nDiscard );
+		m_nBufferStart += nDiscard;
+	}
+
+	return nWritten;
+}
+
+};
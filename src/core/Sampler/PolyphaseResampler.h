@@ -0,0 +1,130 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef POLYPHASE_RESAMPLER_H
+#define POLYPHASE_RESAMPLER_H
+
+#include <core/Object.h>
+
+#include <vector>
+
+namespace H2Core
+{
+
+/**
+ * Offline sample rate converter based on a windowed-sinc polyphase
+ * filter bank.
+ *
+ * The ratio of the two sample rates is reduced to L/M and for each
+ * of the L possible fractional positions of an output frame between
+ * two input frames a dedicated set of filter coefficients is
+ * precomputed. Each output frame thus costs a single dot product.
+ * In case L is very large - for odd sample rates - the positions are
+ * truncated to the closest preceding one of #nMaxPhases phases.
+ *
+ * The low-pass filter is a Kaiser-windowed sinc with its cutoff
+ * slightly below the lower of the two Nyquist frequencies and
+ * #nZeroCrossings zero crossings on each side. This is considerably
+ * more expensive than the interpolation used by the #Sampler while
+ * rendering notes and is intended to convert whole files once, e.g.
+ * the playback track, instead of being run in the audio thread.
+ *
+ * Input is passed in blocks of arbitrary size via process() and the
+ * remaining output is obtained by flush() once the whole input was
+ * processed. The first output frame is aligned with the first input
+ * frame.
+ */
+/** \ingroup docCore docAudioEngine */
+class PolyphaseResampler : public H2Core::Object<PolyphaseResampler>
+{
+	H2_OBJECT(PolyphaseResampler)
+public:
+	static constexpr int nMaxPhases = 1024;
+	static constexpr int nZeroCrossings = 16;
+
+	PolyphaseResampler( int nSourceRate, int nTargetRate );
+	~PolyphaseResampler();
+
+	/** \return Total number of frames produced for @a nInputFrames
+	 * input frames.*/
+	long long getOutputFrames( long long nInputFrames ) const;
+	/** \return Upper bound of the number of frames produced by a
+	 * single call to process() with @a nFrames input frames.*/
+	int getMaxOutputFrames( int nFrames ) const;
+	/** \return Number of coefficients per phase.*/
+	int getTaps() const;
+
+	/**
+	 * Resamples @a nFrames frames of both channels.
+	 *
+	 * \param pOut_L, pOut_R Have to provide room for at least
+	 * @a nMaxOut frames.
+	 * \param nMaxOut Maximum number of frames written. Frames
+	 * exceeding it are dropped.
+	 *
+	 * \return Number of frames written.
+	 */
+	int process( const float* pIn_L, const float* pIn_R, int nFrames,
+				 float* pOut_L, float* pOut_R, int nMaxOut );
+	/** Writes the frames still pending after all input was passed to
+	 * process().
+	 *
+	 * \return Number of frames written.*/
+	int flush( float* pOut_L, float* pOut_R, int nMaxOut );
+
+private:
+	/** Computes output frames as long as the input buffered is
+	 * sufficient and #m_nOutputFrames is below @a nTotal.*/
+	int render( float* pOut_L, float* pOut_R, int nMaxOut, long long nTotal );
+
+	/** Reduced upsampling factor L.*/
+	int m_nUp;
+	/** Reduced downsampling factor M.*/
+	int m_nDown;
+	int m_nPhases;
+	int m_nTaps;
+	/** #m_nPhases times #m_nTaps coefficients.*/
+	std::vector<float> m_coefficients;
+
+	/** Buffered input frames. The first one corresponds to input
+	 * frame #m_nBufferStart.*/
+	std::vector<float> m_buffer_L;
+	std::vector<float> m_buffer_R;
+	long long m_nBufferStart;
+
+	/** Input frame preceding the position of the next output
+	 * frame.*/
+	long long m_nInputPosition;
+	/** Fractional part of the position of the next output frame
+	 * in units of 1 / #m_nUp.*/
+	long long m_nPhase;
+	long long m_nInputFrames;
+	long long m_nOutputFrames;
+};
+
+inline int PolyphaseResampler::getTaps() const {
+	return m_nTaps;
+}
+
+};
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <core/Sampler/RenderWorkerPool.h>
+#include <core/Sampler/Semaphore.h>
+
+#include <algorithm>
+
+#ifndef WIN32
+#include <pthread.h>
+#endif
+
+namespace H2Core
+{
+
+RenderWorkerPool::RenderWorkerPool( int nWorkers )
+	: m_pSemaphore( new Semaphore )
+	, m_pDoneSemaphore( new Semaphore )
+	, m_bRunning( true )
+	, m_jobFunc( nullptr )
+	, m_pContext( nullptr )
+	, m_nJobs( 0 )
+	, m_nNextJob( 0 )
+	, m_nWokenWorkers( 0 )
+	, m_nFinishedWorkers( 0 )
+	, m_nPolicy( 0 )
+	, m_nPriority( 0 )
+	, m_nPriorityGeneration( 0 )
+{
+	const int nCores = std::thread::hardware_concurrency();
+	if ( nCores > 0 ) {
+		nWorkers = std::min( nWorkers, nCores - 1 );
+	}
+	nWorkers = std::max( nWorkers, 0 );
+
+	m_workers.reserve( nWorkers );
+	for ( int ii = 0; ii < nWorkers; ++ii ) {
+		m_workers.emplace_back( &RenderWorkerPool::work, this );
+	}
+
+	INFOLOG( QString( "Started [%1] render workers" ).arg( nWorkers ) );
+}
+
+RenderWorkerPool::~RenderWorkerPool()
+{
+	m_bRunning.store( false, std::memory_order_release );
+	m_pSemaphore->post( m_workers.size() );
+	for ( auto& worker : m_workers ) {
+		worker.join();
+	}
+	delete m_pSemaphore;
+	delete m_pDoneSemaphore;
+}
+
+void RenderWorkerPool::runJobs( int nJobs, JobFunc jobFunc, void* pContext )
+{
+	if ( nJobs <= 0 ) {
+		return;
+	}
+
+#ifndef WIN32
+	// The audio thread changes each time the driver is restarted.
+	if ( std::this_thread::get_id() != m_audioThreadId ) {
+		m_audioThreadId = std::this_thread::get_id();
+		int nPolicy;
+		struct sched_param param;
+		if ( pthread_getschedparam( pthread_self(), &nPolicy, &param ) == 0 ) {
+			m_nPolicy.store( nPolicy, std::memory_order_relaxed );
+			m_nPriority.store( param.sched_priority, std::memory_order_relaxed );
+			m_nPriorityGeneration.fetch_add( 1, std::memory_order_release );
+		}
+	}
+#endif
+
+	m_jobFunc = jobFunc;
+	m_pContext = pContext;
+	m_nJobs = nJobs;
+	m_nNextJob.store( 0, std::memory_order_relaxed );
+	m_nFinishedWorkers.store( 0, std::memory_order_relaxed );
+
+	// Posting the semaphore publishes the job description.
+	const int nWoken = std::min( static_cast<int>( m_workers.size() ), nJobs - 1 );
+	m_nWokenWorkers = nWoken;
+	m_pSemaphore->post( nWoken );
+
+	processJobs();
+
+	if ( nWoken == 0 ) {
+		return;
+	}
+
+	// Each post of the semaphore results in exactly one pass of a
+	// worker through processJobs(). Once all of them reported back,
+	// the job description can be safely altered again. The remaining
+	// jobs are already in progress and usually finish soon. But a
+	// worker sharing the core with the audio thread would never get
+	// to run while the latter spins. Hence the bound.
+	for ( int ii = 0; ii < nSpinCount; ++ii ) {
+		if ( m_nFinishedWorkers.load( std::memory_order_acquire ) == nWoken ) {
+			break;
+		}
+	}
+
+	// The last worker posts exactly once per call. Waiting even if
+	// spinning was successful keeps the semaphore balanced and does
+	// not block in that case.
+	m_pDoneSemaphore->wait();
+}
+
+void RenderWorkerPool::processJobs()
+{
+	while ( true ) {
+		const int nJob = m_nNextJob.fetch_add( 1, std::memory_order_relaxed );
+		if ( nJob >= m_nJobs ) {
+			return;
+		}
+		m_jobFunc( m_pContext, nJob );
+	}
+}
+
+void RenderWorkerPool::work()
+{
+	int nAppliedGeneration = 0;
+	while ( true ) {
+		m_pSemaphore->wait();
+		if ( ! m_bRunning.load( std::memory_order_acquire ) ) {
+			return;
+		}
+
+		updatePriority( nAppliedGeneration );
+		processJobs();
+		if ( m_nFinishedWorkers.fetch_add( 1, std::memory_order_acq_rel ) + 1 ==
+			 m_nWokenWorkers ) {
+			m_pDoneSemaphore->post();
+		}
+	}
+}
+
+void RenderWorkerPool::updatePriority( int& nAppliedGeneration )
+{
+#ifndef WIN32
+	const int nGeneration = m_nPriorityGeneration.load( std::memory_order_acquire );
+	if ( nGeneration == nAppliedGeneration ) {
+		return;
+	}
+	nAppliedGeneration = nGeneration;
+
+	struct sched_param param;
+	param.sched_priority = m_nPriority.load( std::memory_order_relaxed );
+	const int nRes = pthread_setschedparam( pthread_self(),
+											m_nPolicy.load( std::memory_order_relaxed ),
+											&param );
+	if ( nRes != 0 ) {
+		WARNINGLOG( QString( "Unable to set the priority of render worker to [%1]: %2" )
+					.arg( param.sched_priority ).arg( nRes ) );
+	}
+#endif
+}
+
+};
@@ -0,0 +1,141 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef RENDER_WORKER_POOL_H
+#define RENDER_WORKER_POOL_H
+
+#include <core/Object.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace H2Core
+{
+
+class Semaphore;
+
+/**
+ * Set of threads the #Sampler uses to render its voices in parallel.
+ *
+ * The audio thread hands over a number of jobs using run() and
+ * processes jobs itself till none is left. Waking up the workers is
+ * done using a semaphore and distributing the jobs using an atomic
+ * counter. Neither of them requires a lock or allocation in the audio
+ * thread. Afterwards the audio thread spins for a short while for
+ * the workers to finish and blocks on a second semaphore, posted by
+ * the last one of them, if they take longer.
+ *
+ * The workers adopt the scheduling policy and priority of the thread
+ * calling run(). When used with JACK or the ALSA driver they thus
+ * share the real-time priority of the audio thread.
+ */
+/** \ingroup docCore docAudioEngine */
+class RenderWorkerPool : public H2Core::Object<RenderWorkerPool>
+{
+	H2_OBJECT(RenderWorkerPool)
+public:
+	/** \param nWorkers Number of threads to create in addition to
+	 * the audio thread. It will be capped by the number of available
+	 * cores minus one.*/
+	RenderWorkerPool( int nWorkers );
+	~RenderWorkerPool();
+
+	/**
+	 * Calls @a func for each job index in [0, @a nJobs) and returns
+	 * once all of them are done.
+	 *
+	 * The jobs are distributed among the workers and the calling
+	 * thread in no particular order. Different jobs must therefore
+	 * not write to the same memory.
+	 *
+	 * \param nJobs Number of jobs.
+	 * \param func Callable taking the job index as `int`.
+	 */
+	template <typename Func>
+	void run( int nJobs, Func& func );
+
+	int getWorkerCount() const;
+
+private:
+	typedef void (*JobFunc)( void* pContext, int nJob );
+
+	/** Number of times the audio thread checks for the workers to
+	 * finish before blocking.*/
+	static constexpr int nSpinCount = 2000;
+
+	template <typename Func>
+	static void callJob( void* pContext, int nJob );
+
+	void runJobs( int nJobs, JobFunc jobFunc, void* pContext );
+	/** Processes jobs till none is left.*/
+	void processJobs();
+	/** Main loop of the worker threads.*/
+	void work();
+	/** Adopts the scheduling of the audio thread in the calling
+	 * worker.*/
+	void updatePriority( int& nAppliedGeneration );
+
+	std::vector<std::thread> m_workers;
+	Semaphore* m_pSemaphore;
+	/** Posted by the last worker finishing its pass through the jobs
+	 * of the current call to run().*/
+	Semaphore* m_pDoneSemaphore;
+	std::atomic<bool> m_bRunning;
+
+	/** Jobs of the current call to run(). Only written while no
+	 * worker is active.*/
+	JobFunc m_jobFunc;
+	void* m_pContext;
+	int m_nJobs;
+	std::atomic<int> m_nNextJob;
+	/** Number of workers woken up in the current call to run().*/
+	int m_nWokenWorkers;
+	/** Number of workers which woke up and ran out of jobs during the
+	 * current call to run().*/
+	std::atomic<int> m_nFinishedWorkers;
+
+	/** Scheduling of the audio thread.*/
+	std::thread::id m_audioThreadId;
+	std::atomic<int> m_nPolicy;
+	std::atomic<int> m_nPriority;
+	std::atomic<int> m_nPriorityGeneration;
+};
+
+template <typename Func>
+inline void RenderWorkerPool::run( int nJobs, Func& func )
+{
+	runJobs( nJobs, &RenderWorkerPool::callJob<Func>, &func );
+}
+
+template <typename Func>
+inline void RenderWorkerPool::callJob( void* pContext, int nJob )
+{
+	( *static_cast<Func*>( pContext ) )( nJob );
+}
+
+inline int RenderWorkerPool::getWorkerCount() const {
+	return m_workers.size();
+}
+
+};
+
+#endif
@@ -0,0 +1,382 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef RESAMPLE_KERNELS_H
+#define RESAMPLE_KERNELS_H
+
+#include <core/Sampler/Interpolation.h>
+
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace H2Core
+{
+
+namespace Interpolation
+{
+	/**
+	 * Minimal arithmetic interface shared by the scalar and the SIMD
+	 * code paths. Each kernel below is written once against it and
+	 * instantiated for every available vector width.
+	 */
+	struct ScalarOps {
+		typedef float Vec;
+		static constexpr int nWidth = 1;
+		static inline Vec set1( float f ) { return f; }
+		static inline Vec add( Vec a, Vec b ) { return a + b; }
+		static inline Vec sub( Vec a, Vec b ) { return a - b; }
+		static inline Vec mul( Vec a, Vec b ) { return a * b; }
+		static inline Vec load( const float* p ) { return *p; }
+		static inline void store( float* p, Vec v ) { *p = v; }
+		static inline Vec gather( const float* p, const int* pIdx ) {
+			return p[ pIdx[ 0 ] ];
+		}
+	};
+
+#if defined(__SSE2__)
+	struct Sse2Ops {
+		typedef __m128 Vec;
+		static constexpr int nWidth = 4;
+		static inline Vec set1( float f ) { return _mm_set1_ps( f ); }
+		static inline Vec add( Vec a, Vec b ) { return _mm_add_ps( a, b ); }
+		static inline Vec sub( Vec a, Vec b ) { return _mm_sub_ps( a, b ); }
+		static inline Vec mul( Vec a, Vec b ) { return _mm_mul_ps( a, b ); }
+		static inline Vec load( const float* p ) { return _mm_loadu_ps( p ); }
+		static inline void store( float* p, Vec v ) { _mm_storeu_ps( p, v ); }
+		static inline Vec gather( const float* p, const int* pIdx ) {
+			return _mm_setr_ps( p[ pIdx[ 0 ] ], p[ pIdx[ 1 ] ],
+								p[ pIdx[ 2 ] ], p[ pIdx[ 3 ] ] );
+		}
+	};
+#endif
+
+#if defined(__AVX2__)
+	struct Avx2Ops {
+		typedef __m256 Vec;
+		static constexpr int nWidth = 8;
+		static inline Vec set1( float f ) { return _mm256_set1_ps( f ); }
+		static inline Vec add( Vec a, Vec b ) { return _mm256_add_ps( a, b ); }
+		static inline Vec sub( Vec a, Vec b ) { return _mm256_sub_ps( a, b ); }
+		static inline Vec mul( Vec a, Vec b ) { return _mm256_mul_ps( a, b ); }
+		static inline Vec load( const float* p ) { return _mm256_loadu_ps( p ); }
+		static inline void store( float* p, Vec v ) { _mm256_storeu_ps( p, v ); }
+		static inline Vec gather( const float* p, const int* pIdx ) {
+			return _mm256_i32gather_ps( p, _mm256_loadu_si256(
+											reinterpret_cast<const __m256i*>( pIdx ) ), 4 );
+		}
+	};
+#endif
+
+	/**
+	 * Per-#InterpolateMode kernel.
+	 *
+	 * - nTapsBefore/nTapsAfter: number of sample frames required in
+	 *   front of/behind the integer sample position.
+	 * - prepareMu(): maps the fractional sample position onto the
+	 *   weight actually used by the kernel. This is where the
+	 *   non-polynomial part of the cosine interpolation is done so
+	 *   that the vectorised part only consists of multiply-adds.
+	 * - interpolate(): the same formulas as the *_Interpolate()
+	 *   functions in Interpolation.h.
+	 */
+	template <InterpolateMode mode> struct Kernel;
+
+	template <> struct Kernel<InterpolateMode::Linear> {
+		static constexpr int nTapsBefore = 0;
+		static constexpr int nTapsAfter = 1;
+		static inline float prepareMu( double fMu ) {
+			return static_cast<float>( fMu );
+		}
+		template <class Ops>
+		static inline typename Ops::Vec interpolate( typename Ops::Vec y0,
+													 typename Ops::Vec y1,
+													 typename Ops::Vec y2,
+													 typename Ops::Vec y3,
+													 typename Ops::Vec mu ) {
+			return Ops::add( Ops::mul( y1, Ops::sub( Ops::set1( 1.f ), mu ) ),
+							 Ops::mul( y2, mu ) );
+		}
+	};
+
+	template <> struct Kernel<InterpolateMode::Cosine> {
+		static constexpr int nTapsBefore = 0;
+		static constexpr int nTapsAfter = 1;
+		static inline float prepareMu( double fMu ) {
+			return static_cast<float>( ( 1 - cos( fMu * 3.14159 ) ) / 2 );
+		}
+		template <class Ops>
+		static inline typename Ops::Vec interpolate( typename Ops::Vec y0,
+													 typename Ops::Vec y1,
+													 typename Ops::Vec y2,
+													 typename Ops::Vec y3,
+													 typename Ops::Vec mu ) {
+			return Kernel<InterpolateMode::Linear>::interpolate<Ops>( y0, y1, y2, y3, mu );
+		}
+	};
+
+	template <> struct Kernel<InterpolateMode::Third> {
+		static constexpr int nTapsBefore = 1;
+		static constexpr int nTapsAfter = 2;
+		static inline float prepareMu( double fMu ) {
+			return static_cast<float>( fMu );
+		}
+		template <class Ops>
+		static inline typename Ops::Vec interpolate( typename Ops::Vec y0,
+													 typename Ops::Vec y1,
+													 typename Ops::Vec y2,
+													 typename Ops::Vec y3,
+													 typename Ops::Vec mu ) {
+			const auto half = Ops::set1( 0.5f );
+			auto c0 = y1;
+			auto c1 = Ops::mul( half, Ops::sub( y2, y0 ) );
+			auto c3 = Ops::add( Ops::mul( Ops::set1( 1.5f ), Ops::sub( y1, y2 ) ),
+								Ops::mul( half, Ops::sub( y3, y0 ) ) );
+			auto c2 = Ops::sub( Ops::add( Ops::sub( y0, y1 ), c1 ), c3 );
+			return Ops::add( Ops::mul( Ops::add( Ops::mul( Ops::add( Ops::mul( c3, mu ), c2 ),
+														   mu ), c1 ), mu ), c0 );
+		}
+	};
+
+	template <> struct Kernel<InterpolateMode::Cubic> {
+		static constexpr int nTapsBefore = 1;
+		static constexpr int nTapsAfter = 2;
+		static inline float prepareMu( double fMu ) {
+			return static_cast<float>( fMu );
+		}
+		template <class Ops>
+		static inline typename Ops::Vec interpolate( typename Ops::Vec y0,
+													 typename Ops::Vec y1,
+													 typename Ops::Vec y2,
+													 typename Ops::Vec y3,
+													 typename Ops::Vec mu ) {
+			auto a0 = Ops::add( Ops::sub( Ops::sub( y3, y2 ), y0 ), y1 );
+			auto a1 = Ops::sub( Ops::sub( y0, y1 ), a0 );
+			auto a2 = Ops::sub( y2, y0 );
+			auto a3 = y1;
+			// Horner form of a0 * mu^3 + a1 * mu^2 + a2 * mu + a3
+			return Ops::add( Ops::mul( Ops::add( Ops::mul( Ops::add( Ops::mul( a0, mu ), a1 ),
+														   mu ), a2 ), mu ), a3 );
+		}
+	};
+
+	template <> struct Kernel<InterpolateMode::Hermite> {
+		static constexpr int nTapsBefore = 1;
+		static constexpr int nTapsAfter = 2;
+		static inline float prepareMu( double fMu ) {
+			return static_cast<float>( fMu );
+		}
+		template <class Ops>
+		static inline typename Ops::Vec interpolate( typename Ops::Vec y0,
+													 typename Ops::Vec y1,
+													 typename Ops::Vec y2,
+													 typename Ops::Vec y3,
+													 typename Ops::Vec mu ) {
+			const auto half = Ops::set1( 0.5f );
+			const auto oneAndHalf = Ops::set1( 1.5f );
+			// -0.5 * y0 + 1.5 * y1 - 1.5 * y2 + 0.5 * y3
+			auto a0 = Ops::add( Ops::mul( half, Ops::sub( y3, y0 ) ),
+								Ops::mul( oneAndHalf, Ops::sub( y1, y2 ) ) );
+			// y0 - 2.5 * y1 + 2 * y2 - 0.5 * y3
+			auto a1 = Ops::sub( Ops::add( Ops::sub( y0, Ops::mul( Ops::set1( 2.5f ), y1 ) ),
+										  Ops::add( y2, y2 ) ),
+								Ops::mul( half, y3 ) );
+			// -0.5 * y0 + 0.5 * y2
+			auto a2 = Ops::mul( half, Ops::sub( y2, y0 ) );
+			auto a3 = y1;
+			return Ops::add( Ops::mul( Ops::add( Ops::mul( Ops::add( Ops::mul( a0, mu ), a1 ),
+														   mu ), a2 ), mu ), a3 );
+		}
+	};
+
+	/**
+	 * Renders a block of Ops::nWidth consecutive output frames whose
+	 * interpolation taps are all known to lie within the sample.
+	 */
+	template <InterpolateMode mode, class Ops>
+	inline void resampleBlock( const float* pSample_data_L, const float* pSample_data_R,
+							   double fSamplePos, double fStep,
+							   float* pBuffer_L, float* pBuffer_R )
+	{
+		typedef Kernel<mode> K;
+		int idx[ Ops::nWidth ];
+		float mu[ Ops::nWidth ];
+		for ( int ii = 0; ii < Ops::nWidth; ++ii ) {
+			const double fPos = fSamplePos + ii * fStep;
+			idx[ ii ] = static_cast<int>( fPos );
+			mu[ ii ] = K::prepareMu( fPos - idx[ ii ] );
+		}
+		const auto vMu = Ops::load( mu );
+
+		typename Ops::Vec l0, l3, r0, r3;
+		if constexpr ( K::nTapsBefore > 0 ) {
+			l0 = Ops::gather( pSample_data_L - 1, idx );
+			r0 = Ops::gather( pSample_data_R - 1, idx );
+		} else {
+			l0 = r0 = Ops::set1( 0.f );
+		}
+		const auto l1 = Ops::gather( pSample_data_L, idx );
+		const auto r1 = Ops::gather( pSample_data_R, idx );
+		const auto l2 = Ops::gather( pSample_data_L + 1, idx );
+		const auto r2 = Ops::gather( pSample_data_R + 1, idx );
+		if constexpr ( K::nTapsAfter > 1 ) {
+			l3 = Ops::gather( pSample_data_L + 2, idx );
+			r3 = Ops::gather( pSample_data_R + 2, idx );
+		} else {
+			l3 = r3 = Ops::set1( 0.f );
+		}
+
+		Ops::store( pBuffer_L, K::template interpolate<Ops>( l0, l1, l2, l3, vMu ) );
+		Ops::store( pBuffer_R, K::template interpolate<Ops>( r0, r1, r2, r3, vMu ) );
+	}
+
+	/**
+	 * Renders a single output frame. Taps falling outside of the
+	 * sample are treated as silence.
+	 */
+	template <InterpolateMode mode>
+	inline void resampleFrame( const float* pSample_data_L, const float* pSample_data_R,
+							   int nSampleFrames, double fSamplePos,
+							   float* pBuffer_L, float* pBuffer_R )
+	{
+		typedef Kernel<mode> K;
+		const int nSamplePos = static_cast<int>( fSamplePos );
+		if ( ( nSamplePos - 1 ) >= nSampleFrames ) {
+			//we reach the last audioframe.
+			//set this last frame to zero do nothing wrong.
+			*pBuffer_L = 0.0;
+			*pBuffer_R = 0.0;
+			return;
+		}
+
+		float l[ 4 ] = { 0.0, 0.0, 0.0, 0.0 };
+		float r[ 4 ] = { 0.0, 0.0, 0.0, 0.0 };
+		for ( int ii = 0; ii < 4; ++ii ) {
+			const int nPos = nSamplePos - 1 + ii;
+			if ( nPos >= 0 && nPos < nSampleFrames ) {
+				l[ ii ] = pSample_data_L[ nPos ];
+				r[ ii ] = pSample_data_R[ nPos ];
+			}
+		}
+
+		const float fMu = K::prepareMu( fSamplePos - nSamplePos );
+		*pBuffer_L = K::template interpolate<ScalarOps>( l[ 0 ], l[ 1 ], l[ 2 ], l[ 3 ], fMu );
+		*pBuffer_R = K::template interpolate<ScalarOps>( r[ 0 ], r[ 1 ], r[ 2 ], r[ 3 ], fMu );
+	}
+
+	/**
+	 * Checks whether all taps of the Ops::nWidth frames starting at
+	 * @a fSamplePos are located within the sample.
+	 */
+	template <InterpolateMode mode, class Ops>
+	inline bool blockIsInside( int nSampleFrames, double fSamplePos, double fStep )
+	{
+		typedef Kernel<mode> K;
+		return static_cast<int>( fSamplePos ) >= K::nTapsBefore &&
+			static_cast<int>( fSamplePos + ( Ops::nWidth - 1 ) * fStep ) +
+			K::nTapsAfter < nSampleFrames;
+	}
+
+	/**
+	 * Resamples the frames [@a nFrom, @a nTo) of the output buffers
+	 * from a stereo sample starting at sample position @a
+	 * fSamplePos and advancing by @a fStep sample frames per output
+	 * frame.
+	 *
+	 * The interpolation method is a template parameter so that the
+	 * caller has to dispatch only once per note instead of once per
+	 * frame. Wherever all taps of a block of consecutive frames are
+	 * inside the sample, the widest available SIMD path (AVX2, SSE2)
+	 * is used. Frames at the edges of the sample are handled by the
+	 * scalar resampleFrame().
+	 *
+	 * \return Sample position after the last rendered frame.
+	 */
+	template <InterpolateMode mode>
+	inline double resample( const float* pSample_data_L, const float* pSample_data_R,
+							int nSampleFrames, double fSamplePos, double fStep,
+							float* pBuffer_L, float* pBuffer_R, int nFrom, int nTo )
+	{
+		int nBufferPos = nFrom;
+		while ( nBufferPos < nTo ) {
+#if defined(__AVX2__)
+			if ( nTo - nBufferPos >= Avx2Ops::nWidth &&
+				 blockIsInside<mode, Avx2Ops>( nSampleFrames, fSamplePos, fStep ) ) {
+				resampleBlock<mode, Avx2Ops>( pSample_data_L, pSample_data_R,
+											  fSamplePos, fStep,
+											  pBuffer_L + nBufferPos, pBuffer_R + nBufferPos );
+				nBufferPos += Avx2Ops::nWidth;
+				fSamplePos += Avx2Ops::nWidth * fStep;
+				continue;
+			}
+#endif
+#if defined(__SSE2__)
+			if ( nTo - nBufferPos >= Sse2Ops::nWidth &&
+				 blockIsInside<mode, Sse2Ops>( nSampleFrames, fSamplePos, fStep ) ) {
+				resampleBlock<mode, Sse2Ops>( pSample_data_L, pSample_data_R,
+											  fSamplePos, fStep,
+											  pBuffer_L + nBufferPos, pBuffer_R + nBufferPos );
+				nBufferPos += Sse2Ops::nWidth;
+				fSamplePos += Sse2Ops::nWidth * fStep;
+				continue;
+			}
+#endif
+			resampleFrame<mode>( pSample_data_L, pSample_data_R, nSampleFrames, fSamplePos,
+								 pBuffer_L + nBufferPos, pBuffer_R + nBufferPos );
+			++nBufferPos;
+			fSamplePos += fStep;
+		}
+		return fSamplePos;
+	}
+
+	/**
+	 * Function pointer type of resample() used to select the kernel
+	 * once per note.
+	 */
+	typedef double (*ResampleFunc)( const float*, const float*, int, double, double,
+									float*, float*, int, int );
+
+	inline ResampleFunc getResampleFunc( InterpolateMode mode )
+	{
+		switch ( mode ) {
+		case InterpolateMode::Cosine:
+			return &resample<InterpolateMode::Cosine>;
+		case InterpolateMode::Third:
+			return &resample<InterpolateMode::Third>;
+		case InterpolateMode::Cubic:
+			return &resample<InterpolateMode::Cubic>;
+		case InterpolateMode::Hermite:
+			return &resample<InterpolateMode::Hermite>;
+		case InterpolateMode::Linear:
+		default:
+			return &resample<InterpolateMode::Linear>;
+		}
+	}
+};
+
+}
+
+#endif // RESAMPLE_KERNELS_H
@@ -0,0 +1,266 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <core/Sampler/SamplePrefetcher.h>
+#include <core/Sampler/Semaphore.h>
+#include <core/Basics/Sample.h>
+#include <core/Globals.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#ifndef WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace H2Core
+{
+
+SamplePrefetcher::SamplePrefetcher()
+	: m_nWriteIndex( 0 )
+	, m_nReadIndex( 0 )
+	, m_bRunning( false )
+	, m_nDroppedRequests( 0 )
+	, m_nPageSize( 4096 )
+	, m_pSemaphore( new Semaphore )
+{
+	for ( unsigned int ii = 0; ii < nQueueSize; ++ii ) {
+		m_cells[ ii ].nSequence.store( ii, std::memory_order_relaxed );
+	}
+
+#ifndef WIN32
+	const long nPageSize = sysconf( _SC_PAGESIZE );
+	if ( nPageSize > 0 ) {
+		m_nPageSize = static_cast<size_t>( nPageSize );
+	}
+#endif
+}
+
+SamplePrefetcher::~SamplePrefetcher()
+{
+	stop();
+	delete m_pSemaphore;
+
+	const int nDropped = getDroppedRequests();
+	if ( nDropped > 0 ) {
+		WARNINGLOG( QString( "[%1] prefetch requests were dropped" ).arg( nDropped ) );
+	}
+}
+
+void SamplePrefetcher::start()
+{
+	std::lock_guard<std::mutex> lock( m_threadMutex );
+	if ( m_thread.joinable() ) {
+		return;
+	}
+
+	INFOLOG( "Starting sample prefetcher" );
+	m_bRunning.store( true, std::memory_order_release );
+	m_thread = std::thread( &SamplePrefetcher::run, this );
+}
+
+void SamplePrefetcher::stop()
+{
+	std::lock_guard<std::mutex> lock( m_threadMutex );
+	if ( ! m_thread.joinable() ) {
+		return;
+	}
+
+	INFOLOG( "Stopping sample prefetcher" );
+	m_bRunning.store( false, std::memory_order_release );
+	m_pSemaphore->post();
+	m_thread.join();
+}
+
+void SamplePrefetcher::prefetch( const Sample* pSample, double fPreviousPosition,
+								 double fPosition )
+{
+	if ( pSample == nullptr || ! pSample->isStreamed() ) {
+		return;
+	}
+
+	const long long nFrames = pSample->get_frames();
+	const long long nPreviousChunk =
+		static_cast<long long>( fPreviousPosition ) / nChunkFrames;
+	const long long nChunk = static_cast<long long>( fPosition ) / nChunkFrames;
+	if ( fPreviousPosition > 0 && nChunk == nPreviousChunk ) {
+		return;
+	}
+
+	// The current chunk is included too. Only the preloaded part at
+	// the beginning of the sample is locked in memory and it does
+	// not necessarily cover the whole first chunk.
+	const long long nStart = nChunk * nChunkFrames;
+	request( pSample, nStart, std::min( nStart + 3 * nChunkFrames, nFrames ) );
+}
+
+void SamplePrefetcher::prefetchFrom( const Sample* pSample, long long nFrame )
+{
+	if ( pSample == nullptr || ! pSample->isStreamed() || nFrame < 0 ) {
+		return;
+	}
+
+	const long long nStart = nFrame / nChunkFrames * nChunkFrames;
+	request( pSample, nStart, std::min( nStart + 3 * nChunkFrames,
+										static_cast<long long>( pSample->get_frames() ) ) );
+}
+
+bool SamplePrefetcher::isResident( const Sample* pSample, long long nStart,
+								   long long nEnd ) const
+{
+	if ( pSample == nullptr || ! pSample->isStreamed() ) {
+		return true;
+	}
+
+	nStart = std::max( 0LL, nStart );
+	nEnd = std::min( nEnd, static_cast<long long>( pSample->get_frames() ) );
+	if ( nStart >= nEnd ) {
+		return true;
+	}
+
+	const size_t nBytes = ( nEnd - nStart ) * sizeof( float );
+	return isResident( pSample->get_data_l() + nStart, nBytes ) &&
+		isResident( pSample->get_data_r() + nStart, nBytes );
+}
+
+bool SamplePrefetcher::isResident( const void* pAddress, size_t nBytes ) const
+{
+#ifndef WIN32
+	// mincore() requires a page-aligned start address as well.
+	const auto nAddress = reinterpret_cast<std::uintptr_t>( pAddress );
+	auto nAligned = nAddress & ~( static_cast<std::uintptr_t>( m_nPageSize ) - 1 );
+	size_t nLength = nBytes + ( nAddress - nAligned );
+
+	// One entry per page. The range is checked in slices to get by
+	// with a buffer on the stack.
+	constexpr size_t nSlicePages = 16;
+#ifdef __APPLE__
+	char residency[ nSlicePages ];
+#else
+	unsigned char residency[ nSlicePages ];
+#endif
+	while ( nLength > 0 ) {
+		const size_t nSlice = std::min( nLength, nSlicePages * m_nPageSize );
+		if ( mincore( reinterpret_cast<void*>( nAligned ), nSlice, residency ) != 0 ) {
+			return true;
+		}
+		const size_t nPages = ( nSlice + m_nPageSize - 1 ) / m_nPageSize;
+		for ( size_t ii = 0; ii < nPages; ++ii ) {
+			if ( ( residency[ ii ] & 1 ) == 0 ) {
+				return false;
+			}
+		}
+		nAligned += nSlice;
+		nLength -= nSlice;
+	}
+#else
+	UNUSED( pAddress );
+	UNUSED( nBytes );
+#endif
+	return true;
+}
+
+void SamplePrefetcher::request( const Sample* pSample, long long nStart, long long nEnd )
+{
+	if ( nStart >= nEnd ) {
+		return;
+	}
+
+	const size_t nBytes = ( nEnd - nStart ) * sizeof( float );
+	if ( ! tryPush( pSample->get_data_l() + nStart, nBytes ) ||
+		 ! tryPush( pSample->get_data_r() + nStart, nBytes ) ) {
+		// No logging in here since this function is called from
+		// within the audio thread.
+		m_nDroppedRequests.fetch_add( 1, std::memory_order_relaxed );
+	}
+	m_pSemaphore->post();
+}
+
+bool SamplePrefetcher::tryPush( const void* pAddress, size_t nBytes )
+{
+	unsigned int nPos = m_nWriteIndex.load( std::memory_order_relaxed );
+	while ( true ) {
+		Cell& cell = m_cells[ nPos % nQueueSize ];
+		const unsigned int nSequence = cell.nSequence.load( std::memory_order_acquire );
+		const int nDiff = static_cast<int>( nSequence - nPos );
+		if ( nDiff == 0 ) {
+			if ( m_nWriteIndex.compare_exchange_weak( nPos, nPos + 1,
+													  std::memory_order_relaxed ) ) {
+				cell.request.pAddress = pAddress;
+				cell.request.nBytes = nBytes;
+				cell.nSequence.store( nPos + 1, std::memory_order_release );
+				return true;
+			}
+		}
+		else if ( nDiff < 0 ) {
+			// Queue is full.
+			return false;
+		}
+		else {
+			nPos = m_nWriteIndex.load( std::memory_order_relaxed );
+		}
+	}
+}
+
+bool SamplePrefetcher::tryPop( Request& request )
+{
+	// There is just a single consumer.
+	const unsigned int nPos = m_nReadIndex.load( std::memory_order_relaxed );
+	Cell& cell = m_cells[ nPos % nQueueSize ];
+	const unsigned int nSequence = cell.nSequence.load( std::memory_order_acquire );
+	if ( static_cast<int>( nSequence - ( nPos + 1 ) ) < 0 ) {
+		// Queue is empty.
+		return false;
+	}
+
+	request = cell.request;
+	m_nReadIndex.store( nPos + 1, std::memory_order_relaxed );
+	cell.nSequence.store( nPos + nQueueSize, std::memory_order_release );
+	return true;
+}
+
+void SamplePrefetcher::run()
+{
+	Request request;
+	while ( true ) {
+		m_pSemaphore->wait();
+		if ( ! m_bRunning.load( std::memory_order_acquire ) ) {
+			return;
+		}
+		// There might be more requests than posts of the semaphore
+		// in case pushing one of them failed. Surplus posts just
+		// find the queue empty.
+		while ( tryPop( request ) ) {
+#ifndef WIN32
+			// madvise() requires a page-aligned start address.
+			const auto nAddress = reinterpret_cast<std::uintptr_t>( request.pAddress );
+			const auto nAligned = nAddress & ~( static_cast<std::uintptr_t>( m_nPageSize ) - 1 );
+			madvise( reinterpret_cast<void*>( nAligned ),
+					 request.nBytes + ( nAddress - nAligned ), MADV_WILLNEED );
+#else
+			UNUSED( request );
+#endif
+		}
+	}
+}
+
+};
@@ -0,0 +1,168 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef SAMPLE_PREFETCHER_H
+#define SAMPLE_PREFETCHER_H
+
+#include <core/Object.h>
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace H2Core
+{
+
+class Sample;
+class Semaphore;
+
+/**
+ * Background reader keeping the pages of streamed samples (see
+ * Sample::isStreamed()) ahead of the playing notes resident.
+ *
+ * While only the beginning of a streamed sample is locked in memory,
+ * the remainder is read on demand from the memory-mapped sample
+ * cache. To avoid page faults - and thus disk access - within the
+ * audio thread, the #Sampler announces the part of each streamed
+ * sample it is about to render using prefetch(). The requests are
+ * passed to a worker thread via a bounded lock-free queue and the
+ * worker asks the kernel to read the corresponding pages in
+ * advance.
+ *
+ * The worker only uses `madvise()` and never touches the memory
+ * itself. This way it is harmless if a sample was already unloaded
+ * by the time its request is handled. It sleeps on a semaphore
+ * while there is nothing to do and is only running - see start()
+ * and stop() - while streamed samples are in use.
+ */
+/** \ingroup docCore docAudioEngine */
+class SamplePrefetcher : public H2Core::Object<SamplePrefetcher>
+{
+	H2_OBJECT(SamplePrefetcher)
+public:
+	/** Granularity in frames at which requests are issued. Each
+	 * request covers the current chunk and the two following
+	 * ones.*/
+	static constexpr int nChunkFrames = 32768;
+
+	SamplePrefetcher();
+	~SamplePrefetcher();
+
+	/** Starts the worker thread unless it is already running.
+	 *
+	 * Must not be called from within the audio thread. Requests
+	 * issued before are handled once it is started.*/
+	void start();
+	/** Stops the worker thread in case it is running.
+	 *
+	 * Must not be called from within the audio thread. Requests
+	 * issued afterwards are kept till the next start() or dropped
+	 * once the queue is full.*/
+	void stop();
+	bool isRunning() const;
+
+	/**
+	 * Requests the chunk containing @a fPosition of @a pSample and
+	 * the two following ones to be read in advance.
+	 *
+	 * Does neither lock nor allocate and is safe to be called from
+	 * the audio thread. A request is only issued if @a pSample is
+	 * streamed and either rendering just started or the playhead
+	 * crossed a chunk boundary since @a fPreviousPosition.
+	 *
+	 * \param pSample Sample currently rendered.
+	 * \param fPreviousPosition Position in frames within @a pSample
+	 * before rendering the current cycle.
+	 * \param fPosition Position in frames within @a pSample after
+	 * rendering the current cycle.
+	 */
+	void prefetch( const Sample* pSample, double fPreviousPosition, double fPosition );
+	/**
+	 * Requests the chunk containing @a nFrame of @a pSample and the
+	 * two following ones to be read in advance.
+	 *
+	 * Intended for jumps of the playhead, e.g. a relocation of the
+	 * playback track, where prefetch() would skip the current
+	 * chunk. Same constraints as prefetch().
+	 */
+	void prefetchFrom( const Sample* pSample, long long nFrame );
+	/**
+	 * Checks whether frames [@a nStart, @a nEnd) of both channels of
+	 * @a pSample can be accessed without reading from disk.
+	 *
+	 * Uses `mincore()`, which neither blocks nor allocates, and is
+	 * safe to be called from the audio thread. Samples not streamed,
+	 * platforms lacking `mincore()`, and failing calls are reported
+	 * as resident.
+	 */
+	bool isResident( const Sample* pSample, long long nStart, long long nEnd ) const;
+
+	/** \return Number of requests dropped since the queue was full.*/
+	int getDroppedRequests() const;
+
+private:
+	struct Request {
+		const void* pAddress;
+		size_t nBytes;
+	};
+	/** Slot of the request queue. Works the same way as the one used
+	 * in #EventQueue.*/
+	struct Cell {
+		std::atomic<unsigned int> nSequence;
+		Request request;
+	};
+	static constexpr unsigned int nQueueSize = 256;
+
+	/** Queues frames [@a nStart, @a nEnd) of both channels of @a
+	 * pSample.*/
+	void request( const Sample* pSample, long long nStart, long long nEnd );
+	bool isResident( const void* pAddress, size_t nBytes ) const;
+	bool tryPush( const void* pAddress, size_t nBytes );
+	bool tryPop( Request& request );
+	/** Main loop of #m_thread.*/
+	void run();
+
+	Cell m_cells[ nQueueSize ];
+	std::atomic<unsigned int> m_nWriteIndex;
+	std::atomic<unsigned int> m_nReadIndex;
+
+	/** Whether #m_thread should keep running.*/
+	std::atomic<bool> m_bRunning;
+	std::atomic<int> m_nDroppedRequests;
+	size_t m_nPageSize;
+	/** Posted once per request.*/
+	Semaphore* m_pSemaphore;
+	/** Serializes start() and stop().*/
+	std::mutex m_threadMutex;
+	std::thread m_thread;
+};
+
+inline bool SamplePrefetcher::isRunning() const {
+	return m_bRunning.load( std::memory_order_acquire );
+}
+inline int SamplePrefetcher::getDroppedRequests() const {
+	return m_nDroppedRequests.load( std::memory_order_relaxed );
+}
+
+};
+
+#endif
@@ -20,6 +20,7 @@
  *
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
@@ -47,6 +48,9 @@
 
 #include <core/FX/Effects.h>
 #include <core/Sampler/Sampler.h>
+#include <core/Sampler/ResampleKernels.h>
+#include <core/Sampler/RenderWorkerPool.h>
+#include <core/Sampler/SamplePrefetcher.h>
 
 #include <iostream>
 #include <QDebug>
@@ -88,6 +92,29 @@ Sampler::Sampler()
 	// dummy instrument used for playback track
 	m_pPlaybackTrackInstrument = createInstrument( PLAYBACK_INSTR_ID, sEmptySampleFilename, 0.8 );
 	m_nPlayBackSamplePosition = 0;
+	m_bPlaybackTrackSeeking = false;
+	m_nPlaybackTrackFadeIn = 0;
+
+	// Scratch space for rendering the voices of the playing notes.
+	// It holds two voices per note at a buffer size of 1024 and any
+	// single note at the maximum buffer size.
+	auto pPref = Preferences::get_instance();
+
+	m_pSamplePrefetcher = new SamplePrefetcher();
+	updateSamplePrefetcher();
+	const int nMaxVoices = std::max( static_cast<int>( pPref->m_nMaxNotes ) * 2,
+									 MAX_COMPONENTS );
+	m_voices.resize( nMaxVoices );
+	m_noteJobs.resize( nMaxVoices );
+	m_nScratchBufferSize = std::max( nMaxVoices * 2 * 1024,
+									 MAX_COMPONENTS * 2 * MAX_BUFFER_SIZE );
+	m_pScratchBuffer = new float[ m_nScratchBufferSize ];
+	memset( m_pScratchBuffer, 0, m_nScratchBufferSize * sizeof( float ) );
+
+	m_pRenderWorkerPool = nullptr;
+	if ( pPref->m_nRenderThreads > 0 ) {
+		m_pRenderWorkerPool = new RenderWorkerPool( pPref->m_nRenderThreads );
+	}
 }
 
 
@@ -98,6 +125,10 @@ Sampler::~Sampler()
 	delete[] m_pMainOut_L;
 	delete[] m_pMainOut_R;
 
+	delete m_pRenderWorkerPool;
+	delete m_pSamplePrefetcher;
+	delete[] m_pScratchBuffer;
+
 	m_pPreviewInstrument = nullptr;
 	m_pPlaybackTrackInstrument = nullptr;
 }
@@ -109,40 +140,129 @@ float const Sampler::K_NORM_DEFAULT = 1.33333333333333;
 
 void Sampler::process( uint32_t nFrames, std::shared_ptr<Song> pSong )
 {
+	if ( nFrames == 0 ) {
+		// Nothing to render. The scratch buffer layout below would
+		// divide by zero otherwise.
+		return;
+	}
+
 	AudioOutput* pAudioOutpout = Hydrogen::get_instance()->getAudioOutput();
 	assert( pAudioOutpout );
 
+	auto pProfiler = Hydrogen::get_instance()->getAudioEngine()->getDspProfiler();
+	const uint64_t nProcessStart = DspProfiler::now();
+
 	memset( m_pMainOut_L, 0, nFrames * sizeof( float ) );
 	memset( m_pMainOut_R, 0, nFrames * sizeof( float ) );
 
 	// Track output queues are zeroed by
 	// audioEngine_process_clearAudioBuffers()
 
+	for ( const auto& stem : m_stemOutputs ) {
+		memset( stem.pOut_L, 0, nFrames * sizeof( float ) );
+		memset( stem.pOut_R, 0, nFrames * sizeof( float ) );
+	}
+
+	auto pNotePool = Hydrogen::get_instance()->getAudioEngine()->getNotePool();
+
 	// Max notes limit
 	int m_nMaxNotes = Preferences::get_instance()->m_nMaxNotes;
 	while ( ( int )m_playingNotesQueue.size() > m_nMaxNotes ) {
 		Note * pOldNote = m_playingNotesQueue[ 0 ];
 		m_playingNotesQueue.erase( m_playingNotesQueue.begin() );
 		pOldNote->get_instrument()->dequeue();
-		delete  pOldNote;	// FIXME: send note-off instead of removing the note from the list?
+		pNotePool->release( pOldNote );	// FIXME: send note-off instead of removing the note from the list?
 	}
 
 	for ( auto& pComponent : *pSong->getComponents() ) {
 		pComponent->reset_outs(nFrames);
 	}
 
-	// eseguo tutte le note nella lista di note in esecuzione
-	unsigned i = 0;
+	// Render all notes in the playing notes queue. This is done in
+	// three steps. First, all notes are prepared in order within
+	// this thread. Second, their voices are rendered into the
+	// scratch buffers - in parallel in case the RenderWorkerPool is
+	// enabled. Finally, all voices are mixed into the outputs in
+	// order. This way the result does not depend on the number of
+	// threads used. If the scratch buffer does not suffice to hold
+	// all voices at once, the notes are processed in several batches.
+	const int nMaxVoices = std::min( static_cast<int>( m_voices.size() ),
+									 m_nScratchBufferSize / ( 2 * static_cast<int>( nFrames ) ) );
 	Note* pNote;
-	while ( i < m_playingNotesQueue.size() ) {
-		pNote = m_playingNotesQueue[ i ];		// recupero una nuova nota
-		if ( renderNote( pNote, nFrames, pSong ) ) {	// la nota e' finita
-			m_playingNotesQueue.erase( m_playingNotesQueue.begin() + i );
-			pNote->get_instrument()->dequeue();
-			m_queuedNoteOffs.push_back( pNote );
+	unsigned nNote = 0;
+	while ( nNote < m_playingNotesQueue.size() ) {
+		const unsigned nBatchStart = nNote;
+		int nJobs = 0;
+		int nVoices = 0;
+
+		while ( nNote < m_playingNotesQueue.size() &&
+				nJobs < static_cast<int>( m_noteJobs.size() ) ) {
+			pNote = m_playingNotesQueue[ nNote ];
+			const int nComponents = pNote->get_instrument() != nullptr ?
+				pNote->get_instrument()->get_components()->size() : 0;
+			if ( nVoices + nComponents > nMaxVoices ) {
+				if ( nJobs > 0 ) {
+					// Continue in the next batch.
+					break;
+				}
+				ERRORLOG( QString( "Note with [%1] components exceeds the render buffer" )
+						  .arg( nComponents ) );
+				m_noteJobs[ nJobs ].pNote = pNote;
+				m_noteJobs[ nJobs ].nFirstVoice = nVoices;
+				m_noteJobs[ nJobs ].nVoices = 0;
+				m_noteJobs[ nJobs ].bEnded = true;
+			}
+			else {
+				prepareNote( pNote, nFrames, pSong, m_noteJobs[ nJobs ], nVoices );
+			}
+			++nJobs;
+			++nNote;
+		}
+
+		auto renderJob = [&]( int nJob ) {
+			const uint64_t nRenderStart = DspProfiler::now();
+			renderNoteJob( m_noteJobs[ nJob ] );
+			auto pInstr = m_noteJobs[ nJob ].pNote->get_instrument();
+			if ( pInstr != nullptr ) {
+				pProfiler->addInstrument( pInstr->get_id(), DspProfiler::now() - nRenderStart );
+			}
+		};
+		if ( m_pRenderWorkerPool != nullptr && nJobs > 1 ) {
+			m_pRenderWorkerPool->run( nJobs, renderJob );
 		} else {
-			++i; // carico la prox nota
+			for ( int ii = 0; ii < nJobs; ++ii ) {
+				renderJob( ii );
+			}
 		}
+
+		// Mix the voices and remove all notes which are finished.
+		unsigned nKept = nBatchStart;
+		for ( int ii = 0; ii < nJobs; ++ii ) {
+			auto& job = m_noteJobs[ ii ];
+			for ( int nVoice = job.nFirstVoice; nVoice < job.nFirstVoice + job.nVoices; ++nVoice ) {
+				auto& voice = m_voices[ nVoice ];
+				mixVoice( job.pNote, voice, pSong );
+				job.bEnded = job.bEnded && voice.bEnded;
+
+				// Do not keep the sample alive till the voice is reused.
+				voice.pSample = nullptr;
+				voice.pSelectedLayerInfo = nullptr;
+				voice.pCompo = nullptr;
+			}
+
+			if ( job.bEnded ) {	// la nota e' finita
+				if ( job.pNote->get_instrument() != nullptr ) {
+					job.pNote->get_instrument()->dequeue();
+				}
+				m_queuedNoteOffs.push_back( job.pNote );
+			} else {
+				m_playingNotesQueue[ nKept ] = job.pNote;
+				++nKept;
+			}
+		}
+		m_playingNotesQueue.erase( m_playingNotesQueue.begin() + nKept,
+								   m_playingNotesQueue.begin() + nNote );
+		nNote = nKept;
 	}
 
 	//Queue midi note off messages for notes that have a length specified for them
@@ -159,13 +279,17 @@ void Sampler::process( uint32_t nFrames, std::shared_ptr<Song> pSong )
 		m_queuedNoteOffs.erase( m_queuedNoteOffs.begin() );
 		
 		if( pNote != nullptr ){
-			delete pNote;
+			pNotePool->release( pNote );
 		}
 		
 		pNote = nullptr;
 	}//while
 
+	const uint64_t nPlaybackTrackStart = DspProfiler::now();
+	pProfiler->addStage( DspProfiler::Stage::Sampler, nPlaybackTrackStart - nProcessStart );
 	processPlaybackTrack(nFrames);
+	pProfiler->addStage( DspProfiler::Stage::PlaybackTrack,
+						 DspProfiler::now() - nPlaybackTrackStart );
 }
 
 bool Sampler::isRenderingNotes() const {
@@ -228,7 +352,7 @@ void Sampler::noteOff(Note* pNote )
 		}
 	}
 	
-	delete pNote;
+	Hydrogen::get_instance()->getAudioEngine()->getNotePool()->release( pNote );
 }
 
 
@@ -441,17 +565,28 @@ void Sampler::handleSongSizeChange() {
 
 //------------------------------------------------------------------
 
-/// Render a note
-/// Return false: the note is not ended
-/// Return true: the note is ended
-bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Song> pSong )
+/// Prepare the rendering of all components of a note
+///
+/// Selects the samples and computes all parameters required by
+/// renderVoice() and mixVoice(). Everything accessing state shared
+/// between notes is done in here.
+///
+/// Sets NoteJob::bEnded to false if the note is not ended yet
+/// regardless of the outcome of the upcoming rendering.
+void Sampler::prepareNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Song> pSong,
+						   NoteJob& job, int& nVoices )
 {
 	assert( pSong );
 
+	job.pNote = pNote;
+	job.nFirstVoice = nVoices;
+	job.nVoices = 0;
+	job.bEnded = true;
+
 	auto pInstr = pNote->get_instrument();
 	if ( pInstr == nullptr ) {
 		ERRORLOG( "NULL instrument" );
-		return 1;
+		return;
 	}
 
 	long long nFrames;
@@ -490,11 +625,12 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 					// this note is not valid. it's in the future...let's skip it....
 					ERRORLOG( QString( "Note pos in the future?? Current frames: %1, note frame pos: %2" ).arg( nFrames ).arg( pNote->getNoteStart() ) );
 
-					return true;
+					return;
 				}
 				// delay note execution
 				// DEBUGLOG("delayed");
-				return false;
+				job.bEnded = false;
+				return;
 			}
 		}
 	}
@@ -525,22 +661,24 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 	float fPan_L = panLaw( fPan, pSong );
 	float fPan_R = panLaw( -fPan, pSong );
 	//---------------------------------------------------------
-	auto components = pInstr->get_components();
-	bool nReturnValues[ components->size() ];
 
-	for(int i = 0; i < components->size(); i++){
-		nReturnValues[i] = false;
+	// Stem the note is mixed into in addition to the main out.
+	int nStem = -1;
+	for ( int ii = 0; ii < static_cast<int>( m_stemOutputs.size() ); ++ii ) {
+		if ( m_stemOutputs[ ii ].nInstrumentId == pInstr->get_id() ) {
+			nStem = ii;
+			break;
+		}
 	}
 
-	int nReturnValueIndex = 0;
+	auto components = pInstr->get_components();
 	int nAlreadySelectedLayer = -1;
 
 	for ( const auto& pCompo : *components ) {
-		nReturnValues[nReturnValueIndex] = false;
 		DrumkitComponent* pMainCompo = nullptr;
 
 		if( pNote->get_specific_compo_id() != -1 && pNote->get_specific_compo_id() != pCompo->get_drumkit_componentID() ) {
-			nReturnValueIndex++;
+			job.bEnded = false;
 			continue;
 		}
 
@@ -562,8 +700,6 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 		auto pSample = pNote->getSample( pCompo->get_drumkit_componentID(),
 										 nAlreadySelectedLayer );
 		if ( pSample == nullptr ) {
-			nReturnValues[nReturnValueIndex] = true;
-			nReturnValueIndex++;
 			continue;
 		}
 
@@ -579,8 +715,6 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 
 		if( pSelectedLayer->SelectedLayer == -1 ) {
 			ERRORLOG( "Sample selection did not work." );
-			nReturnValues[nReturnValueIndex] = true;
-			nReturnValueIndex++;
 			continue;
 		}
 		auto pLayer = pCompo->get_layer( pSelectedLayer->SelectedLayer );
@@ -589,8 +723,6 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 
 		if ( pSelectedLayer->SamplePosition >= pSample->get_frames() ) {
 			WARNINGLOG( "sample position out of bounds. The layer has been resized during note play?" );
-			nReturnValues[nReturnValueIndex] = true;
-			nReturnValueIndex++;
 			continue;
 		}
 
@@ -674,21 +806,80 @@ bool Sampler::renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Son
 			}
 		}
 
-		if ( fTotalPitch == 0.0 &&
-			 pSample->get_sample_rate() == pAudioDriver->getSampleRate() ) { // NO RESAMPLE
-			nReturnValues[nReturnValueIndex] = renderNoteNoResample( pSample, pNote, pSelectedLayer, pCompo, pMainCompo, nBufferSize, nInitialSilence, cost_L, cost_R, cost_track_L, cost_track_R, pSong );
+		Voice& voice = m_voices[ nVoices ];
+		voice.pSample = pSample;
+		voice.pSelectedLayerInfo = pSelectedLayer;
+		voice.pCompo = pCompo;
+		voice.pDrumCompo = pMainCompo;
+		voice.nBufferSize = nBufferSize;
+		voice.nInitialSilence = nInitialSilence;
+		voice.fCost_L = cost_L;
+		voice.fCost_R = cost_R;
+		voice.fCostTrack_L = cost_track_L;
+		voice.fCostTrack_R = cost_track_R;
+		voice.bResample = fTotalPitch != 0.0 ||
+			pSample->get_sample_rate() != pAudioDriver->getSampleRate();
+		voice.nNoteLength = -1;
+		voice.fStep = 1.0;
+
+		int nEffectiveDelay = 0;
+		if ( pNote->get_humanize_delay() < 0 ) {
+			nEffectiveDelay = pNote->get_humanize_delay();
+		}
+		double fTickMismatch;
+		if ( ! voice.bResample ) { // NO RESAMPLE
+			if ( pNote->get_length() != -1 ) {
+				voice.nNoteLength =
+					pAudioEngine->computeFrameFromTick( pNote->get_position() +
+														nEffectiveDelay +
+														pNote->get_length(), &fTickMismatch ) -
+					pNote->getNoteStart();
+			}
 		} else { // RESAMPLE
-			nReturnValues[nReturnValueIndex] = renderNoteResample( pSample, pNote, pSelectedLayer, pCompo, pMainCompo, nBufferSize, nInitialSilence, cost_L, cost_R, cost_track_L, cost_track_R, fLayerPitch, pSong );
+			// Note is not located at the very beginning of the song
+			// and is enqueued by the AudioEngine. Take possible
+			// changes in tempo into account
+			if ( pNote->get_length() != -1 ) {
+				voice.nNoteLength =
+					pAudioEngine->computeFrameFromTick( pNote->get_position() +
+														nEffectiveDelay +
+														pNote->get_length(), &fTickMismatch,
+														pSample->get_sample_rate() ) -
+					pAudioEngine->computeFrameFromTick( pNote->get_position() +
+														nEffectiveDelay, &fTickMismatch,
+														pSample->get_sample_rate() );
+			}
+
+			voice.fStep = Note::pitchToFrequency( fTotalPitch );
+			// Adjust for audio driver sample rate
+			voice.fStep *= static_cast<float>(pSample->get_sample_rate()) /
+				static_cast<float>(pAudioDriver->getSampleRate());
 		}
 
-		nReturnValueIndex++;
+		// The scratch buffers are assigned in the order of the
+		// voices. Right channel follows left one.
+		voice.pBuffer_L = m_pScratchBuffer + nVoices * 2 * nBufferSize;
+		voice.pBuffer_R = voice.pBuffer_L + nBufferSize;
+		voice.nStem = nStem;
+
+		++nVoices;
+		++job.nVoices;
 	}
-	for ( unsigned i = 0 ; i < components->size() ; i++ ) {
-		if ( !nReturnValues[i] ) {
-			return false;
-		}
+}
+
+void Sampler::setStemOutputs( const std::vector<StemOutput>& stems )
+{
+	m_stemOutputs = stems;
+}
+
+void Sampler::updateSamplePrefetcher()
+{
+	if ( Preferences::get_instance()->m_bUseSampleStreaming ||
+		 Sample::getStreamedSamples() > 0 ) {
+		m_pSamplePrefetcher->start();
+	} else {
+		m_pSamplePrefetcher->stop();
 	}
-	return true;
 }
 
 bool Sampler::processPlaybackTrack(int nBufferSize)
@@ -723,49 +914,61 @@ bool Sampler::processPlaybackTrack(int nBufferSize)
 		return true;
 	}
 
-	float fVal_L;
-	float fVal_R;
-
-	auto pSample_data_L = pSample->get_data_l();
-	auto pSample_data_R = pSample->get_data_r();
+	const float* pSample_data_L = pSample->get_data_l();
+	const float* pSample_data_R = pSample->get_data_r();
+	const long long nSampleFrames = pSample->get_frames();
+	const float fVolume = pSong->getPlaybackTrackVolume();
 	
 	float fInstrPeak_L = m_pPlaybackTrackInstrument->get_peak_l(); // this value will be reset to 0 by the mixer..
 	float fInstrPeak_R = m_pPlaybackTrackInstrument->get_peak_r(); // this value will be reset to 0 by the mixer..
 
-	int nAvail_bytes = 0;
-	int	nInitialBufferPos = 0;
+	// The position within the track is derived from the transport
+	// position in every cycle. This way relocations are picked up
+	// right away and no rounding errors accumulate.
+	const long long nFrame = pAudioEngine->getFrames() -
+		pAudioEngine->getFrameOffset();
+	if ( nFrame < 0 ) {
+		return true;
+	}
 
-	if(pSample->get_sample_rate() == pAudioDriver->getSampleRate()){
-		//No resampling	
-		m_nPlayBackSamplePosition = pAudioEngine->getFrames() -
-			pAudioEngine->getFrameOffset();
-	
-		nAvail_bytes = pSample->get_frames() - m_nPlayBackSamplePosition;
-		
-		if ( nAvail_bytes > nBufferSize ) {
-			nAvail_bytes = nBufferSize;
+	if ( pSample->get_sample_rate() == pAudioDriver->getSampleRate() ) {
+		// The track was already converted to the sample rate of the
+		// driver while loading.
+		if ( nFrame != m_nPlayBackSamplePosition ) {
+			// Transport was relocated. Jumping within the mapped
+			// track is free but the pages at the new position have
+			// to be read in.
+			m_pSamplePrefetcher->prefetchFrom( pSample.get(), nFrame );
+			m_bPlaybackTrackSeeking = true;
 		}
 
-		int nInitialSamplePos = ( int ) m_nPlayBackSamplePosition;
-		int nSamplePos = nInitialSamplePos;
-	
-		int nTimes = nInitialBufferPos + nAvail_bytes;
-	
-		if(m_nPlayBackSamplePosition > pSample->get_frames()){
-			//playback track has ended..
-			return true;
+		const int nFrames = static_cast<int>(
+			std::max( 0LL, std::min( nSampleFrames - nFrame,
+									 static_cast<long long>( nBufferSize ) ) ) );
+
+		// Accessing pages not read in yet would block the audio
+		// thread until the disk delivered them.
+		int nFramesToMix = nFrames;
+		if ( m_bPlaybackTrackSeeking ) {
+			if ( m_pSamplePrefetcher->isResident( pSample.get(), nFrame,
+												  nFrame + nFrames ) ) {
+				m_bPlaybackTrackSeeking = false;
+			} else {
+				nFramesToMix = 0;
+				m_nPlaybackTrackFadeIn = nPlaybackTrackFadeInFrames;
+			}
 		}
-	
-		for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
-			fVal_L = pSample_data_L[ nSamplePos ];
-			fVal_R = pSample_data_R[ nSamplePos ];
-	
-			fVal_L = fVal_L * 1.0f * pSong->getPlaybackTrackVolume(); //costr
-			fVal_R = fVal_R * 1.0f * pSong->getPlaybackTrackVolume(); //cost l
-	
-			//pDrumCompo->set_outs( nBufferPos, fVal_L, fVal_R );
-	
-			// to main mix
+
+		for ( int nBufferPos = 0; nBufferPos < nFramesToMix; ++nBufferPos ) {
+			float fGain = fVolume;
+			if ( m_nPlaybackTrackFadeIn > 0 ) {
+				fGain *= 1.0f - static_cast<float>( m_nPlaybackTrackFadeIn ) /
+					static_cast<float>( nPlaybackTrackFadeInFrames );
+				--m_nPlaybackTrackFadeIn;
+			}
+			const float fVal_L = pSample_data_L[ nFrame + nBufferPos ] * fGain;
+			const float fVal_R = pSample_data_R[ nFrame + nBufferPos ] * fGain;
+
 			if ( fVal_L > fInstrPeak_L ) {
 				fInstrPeak_L = fVal_L;
 			}
@@ -775,77 +978,29 @@ bool Sampler::processPlaybackTrack(int nBufferSize)
 			
 			m_pMainOut_L[nBufferPos] += fVal_L;
 			m_pMainOut_R[nBufferPos] += fVal_R;
-			
-			++nSamplePos;
-		}
-	} else {
-		//Perform resampling
-		double	fSamplePos = 0;
-		int		nSampleFrames = pSample->get_frames();
-		float	fStep = 1;
-		fStep *= ( float )pSample->get_sample_rate() / pAudioDriver->getSampleRate(); // Adjust for audio driver sample rate
-		
-		
-		if( pAudioEngine->getFrames() == 0){
-			fSamplePos = 0;
-		} else {
-			fSamplePos = ( ( ( pAudioEngine->getFrames() - pAudioEngine->getFrameOffset() )
-							 /nBufferSize) * (nBufferSize * fStep));
-		}
-		
-		nAvail_bytes = ( int )( ( float )( pSample->get_frames() - fSamplePos ) / fStep );
-	
-		if ( nAvail_bytes > nBufferSize ) {
-			nAvail_bytes = nBufferSize;
 		}
 
-		int nTimes = nInitialBufferPos + nAvail_bytes;
-	
-		for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
-			int nSamplePos = ( int ) fSamplePos;
-			double fDiff = fSamplePos - nSamplePos;
-			if ( ( nSamplePos + 1 ) >= nSampleFrames ) {
-				//we reach the last audioframe.
-				//set this last frame to zero do nothing wrong.
-							fVal_L = 0.0;
-							fVal_R = 0.0;
-			} else {
-				// some interpolation methods need 4 frames data.
-					float last_l;
-					float last_r;
-					if ( ( nSamplePos + 2 ) >= nSampleFrames ) {
-						last_l = 0.0;
-						last_r = 0.0;
-					} else {
-						last_l =  pSample_data_L[nSamplePos + 2];
-						last_r =  pSample_data_R[nSamplePos + 2];
-					}
-	
-					switch( m_interpolateMode ){
-	
-						case Interpolation::InterpolateMode::Linear:
-								fVal_L = pSample_data_L[nSamplePos] * (1 - fDiff ) + pSample_data_L[nSamplePos + 1] * fDiff;
-								fVal_R = pSample_data_R[nSamplePos] * (1 - fDiff ) + pSample_data_R[nSamplePos + 1] * fDiff;
-								break;
-						case Interpolation::InterpolateMode::Cosine:
-								fVal_L = Interpolation::cosine_Interpolate( pSample_data_L[nSamplePos], pSample_data_L[nSamplePos + 1], fDiff);
-								fVal_R = Interpolation::cosine_Interpolate( pSample_data_R[nSamplePos], pSample_data_R[nSamplePos + 1], fDiff);
-								break;
-						case Interpolation::InterpolateMode::Third:
-								fVal_L = Interpolation::third_Interpolate( pSample_data_L[ nSamplePos -1], pSample_data_L[nSamplePos], pSample_data_L[nSamplePos + 1], last_l, fDiff);
-								fVal_R = Interpolation::third_Interpolate( pSample_data_R[ nSamplePos -1], pSample_data_R[nSamplePos], pSample_data_R[nSamplePos + 1], last_r, fDiff);
-								break;
-						case Interpolation::InterpolateMode::Cubic:
-								fVal_L = Interpolation::cubic_Interpolate( pSample_data_L[ nSamplePos -1], pSample_data_L[nSamplePos], pSample_data_L[nSamplePos + 1], last_l, fDiff);
-								fVal_R = Interpolation::cubic_Interpolate( pSample_data_R[ nSamplePos -1], pSample_data_R[nSamplePos], pSample_data_R[nSamplePos + 1], last_r, fDiff);
-								break;
-						case Interpolation::InterpolateMode::Hermite:
-								fVal_L = Interpolation::hermite_Interpolate( pSample_data_L[ nSamplePos -1], pSample_data_L[nSamplePos], pSample_data_L[nSamplePos + 1], last_l, fDiff);
-								fVal_R = Interpolation::hermite_Interpolate( pSample_data_R[ nSamplePos -1], pSample_data_R[nSamplePos], pSample_data_R[nSamplePos + 1], last_r, fDiff);
-								break;
-					}
+		m_pSamplePrefetcher->prefetch( pSample.get(), nFrame, nFrame + nFrames );
+	} else {
+		// The driver changed its sample rate after the track was
+		// loaded. Interpolate linearly until
+		// updatePlaybackTrackSampleRate() converted it again.
+		const double fStep = static_cast<double>( pSample->get_sample_rate() ) /
+			static_cast<double>( pAudioDriver->getSampleRate() );
+		const double fStart = static_cast<double>( nFrame ) * fStep;
+
+		for ( int nBufferPos = 0; nBufferPos < nBufferSize; ++nBufferPos ) {
+			const double fSamplePos = fStart + nBufferPos * fStep;
+			const long long nSamplePos = static_cast<long long>( fSamplePos );
+			if ( nSamplePos + 1 >= nSampleFrames ) {
+				break;
 			}
-			
+			const float fDiff = static_cast<float>( fSamplePos - nSamplePos );
+			const float fVal_L = ( pSample_data_L[ nSamplePos ] * ( 1 - fDiff ) +
+								   pSample_data_L[ nSamplePos + 1 ] * fDiff ) * fVolume;
+			const float fVal_R = ( pSample_data_R[ nSamplePos ] * ( 1 - fDiff ) +
+								   pSample_data_R[ nSamplePos + 1 ] * fDiff ) * fVolume;
+
 			if ( fVal_L > fInstrPeak_L ) {
 				fInstrPeak_L = fVal_L;
 			}
@@ -855,11 +1010,9 @@ bool Sampler::processPlaybackTrack(int nBufferSize)
 
 			m_pMainOut_L[nBufferPos] += fVal_L;
 			m_pMainOut_R[nBufferPos] += fVal_R;
-
-
-			fSamplePos += fStep;
-		} //for
+		}
 	}
+	m_nPlayBackSamplePosition = nFrame + nBufferSize;
 	
 	m_pPlaybackTrackInstrument->set_peak_l( fInstrPeak_L );
 	m_pPlaybackTrackInstrument->set_peak_r( fInstrPeak_R );
@@ -867,111 +1020,100 @@ bool Sampler::processPlaybackTrack(int nBufferSize)
 	return true;
 }
 
-bool Sampler::renderNoteNoResample(
-	std::shared_ptr<Sample> pSample,
-	Note *pNote,
-	std::shared_ptr<SelectedLayerInfo> pSelectedLayerInfo,
-	std::shared_ptr<InstrumentComponent> pCompo,
-	DrumkitComponent *pDrumCompo,
-	int nBufferSize,
-	int nInitialSilence,
-	float cost_L,
-	float cost_R,
-	float cost_track_L,
-	float cost_track_R,
-	std::shared_ptr<Song> pSong
-)
+/// Render all voices of a note into their scratch buffers
+///
+/// Only the state of the note itself is altered in here. This way
+/// different notes can be rendered in parallel.
+void Sampler::renderNoteJob( NoteJob& job )
 {
-	auto pAudioDriver = Hydrogen::get_instance()->getAudioOutput();
-	auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
-	auto pInstrument = pNote->get_instrument();
-	bool retValue = true; // the note is ended
+	for ( int ii = job.nFirstVoice; ii < job.nFirstVoice + job.nVoices; ++ii ) {
+		renderVoice( job.pNote, m_voices[ ii ] );
+	}
+}
 
-	int nNoteLength = -1;
-	if ( pNote->get_length() != -1 ) {
+void Sampler::renderVoice( Note* pNote, Voice& voice )
+{
+	auto pInstrument = pNote->get_instrument();
+	const auto& pSample = voice.pSample;
+	const auto& pSelectedLayerInfo = voice.pSelectedLayerInfo;
+	const int nBufferSize = voice.nBufferSize;
+	const int nInitialSilence = voice.nInitialSilence;
+	const int nSampleFrames = pSample->get_frames();
+	voice.bEnded = true; // the note is ended
 
-		int nEffectiveDelay = 0;
-		if ( pNote->get_humanize_delay() < 0 ) {
-			nEffectiveDelay = pNote->get_humanize_delay();
-		}
-		
-		double fTickMismatch;
-		nNoteLength =
-			pAudioEngine->computeFrameFromTick( pNote->get_position() +
-												nEffectiveDelay +
-												pNote->get_length(), &fTickMismatch ) -
-			pNote->getNoteStart();
+	// verifico il numero di frame disponibili ancora da eseguire
+	int nAvail_bytes;
+	if ( ! voice.bResample ) {
+		nAvail_bytes = nSampleFrames - ( int )pSelectedLayerInfo->SamplePosition;
+	} else {
+		nAvail_bytes = ( int )( ( float )( nSampleFrames - pSelectedLayerInfo->SamplePosition ) / voice.fStep );
 	}
 
-	int nAvail_bytes = pSample->get_frames() - ( int )pSelectedLayerInfo->SamplePosition;	// verifico il numero di frame disponibili ancora da eseguire
-
 	if ( nAvail_bytes > nBufferSize - nInitialSilence ) {	// il sample e' piu' grande del buffersize
 		// imposto il numero dei bytes disponibili uguale al buffersize
 		nAvail_bytes = nBufferSize - nInitialSilence;
-		retValue = false; // the note is not ended yet
+		voice.bEnded = false; // the note is not ended yet
 	} else if ( pInstrument->is_filter_active() && pNote->filter_sustain() ) {
 		// If filter is causing note to ring, process more samples.
 		nAvail_bytes = nBufferSize - nInitialSilence;
 	}
 
 	int nInitialBufferPos = nInitialSilence;
-	int nInitialSamplePos = ( int )pSelectedLayerInfo->SamplePosition;
-	int nSamplePos = nInitialSamplePos;
 	int nTimes = nInitialBufferPos + nAvail_bytes;
 
 	auto pSample_data_L = pSample->get_data_l();
 	auto pSample_data_R = pSample->get_data_r();
+	float* buffer_L = voice.pBuffer_L;
+	float* buffer_R = voice.pBuffer_R;
 
-	float fInstrPeak_L = pInstrument->get_peak_l(); // this value will be reset to 0 by the mixer..
-	float fInstrPeak_R = pInstrument->get_peak_r(); // this value will be reset to 0 by the mixer..
-
-	auto pADSR = pNote->get_adsr();
-	float fADSRValue;
-	float fVal_L;
-	float fVal_R;
-
-#ifdef H2CORE_HAVE_JACK
-	float *		pTrackOutL = nullptr;
-	float *		pTrackOutR = nullptr;
+	int nNoteEnd;
+	if ( ! voice.bResample ) { // NO RESAMPLE
+		if ( voice.nNoteLength == -1) {
+			nNoteEnd = pSelectedLayerInfo->SamplePosition + nTimes + 1;
+		}
+		else {
+			nNoteEnd = voice.nNoteLength - pSelectedLayerInfo->SamplePosition;
+		}
 
-	if ( Preferences::get_instance()->m_bJackTrackOuts ) {
-		auto pJackAudioDriver = dynamic_cast<JackAudioDriver*>( pAudioDriver );
-		if( pJackAudioDriver ) {
-			pTrackOutL = pJackAudioDriver->getTrackOut_L( pInstrument, pCompo );
-			pTrackOutR = pJackAudioDriver->getTrackOut_R( pInstrument, pCompo );
+		int nSamplePos = ( int )pSelectedLayerInfo->SamplePosition;
+		int nCopyFrames = std::min( nTimes,
+									( nInitialSilence + nSampleFrames
+									  - ( int )pSelectedLayerInfo->SamplePosition ) );
+		for ( int nBufferPos = nInitialBufferPos; nBufferPos < nCopyFrames; ++nBufferPos ) {
+			buffer_L[ nBufferPos ] = pSample_data_L[ nSamplePos ];
+			buffer_R[ nBufferPos ] = pSample_data_R[ nSamplePos ];
+			nSamplePos++;
+		}
+		for ( int nBufferPos = nCopyFrames; nBufferPos < nTimes; ++nBufferPos ) {
+			buffer_L[ nBufferPos ] = buffer_R[ nBufferPos ] = 0.0;
 		}
 	}
-#endif
+	else { // RESAMPLE
+		if ( voice.nNoteLength == -1) {
+			nNoteEnd = nSampleFrames + 1;
+		}
+		else {
+			nNoteEnd = voice.nNoteLength - pSelectedLayerInfo->SamplePosition;
+		}
 
-	float buffer_L[ MAX_BUFFER_SIZE ];
-	float buffer_R[ MAX_BUFFER_SIZE ];
-	int nNoteEnd;
-	if ( nNoteLength == -1) {
-		nNoteEnd = pSelectedLayerInfo->SamplePosition + nTimes + 1;
-	}
-	else {
-		nNoteEnd = nNoteLength - pSelectedLayerInfo->SamplePosition;
+		// The interpolation kernel is selected once per note and
+		// vectorised for all frames whose taps are located within
+		// the sample (see ResampleKernels.h).
+		Interpolation::getResampleFunc( m_interpolateMode )( pSample_data_L, pSample_data_R,
+															 nSampleFrames,
+															 pSelectedLayerInfo->SamplePosition,
+															 voice.fStep, buffer_L, buffer_R,
+															 nInitialBufferPos, nTimes );
 	}
 
-	int nSampleFrames = std::min( nTimes,
-								  ( nInitialSilence + pSample->get_frames()
-								    - ( int )pSelectedLayerInfo->SamplePosition ) );
-	for ( int nBufferPos = nInitialBufferPos; nBufferPos < nSampleFrames; ++nBufferPos ) {
-		buffer_L[ nBufferPos ] = pSample_data_L[ nSamplePos ];
-		buffer_R[ nBufferPos ] = pSample_data_R[ nSamplePos ];
-		nSamplePos++;
-	}
-	for ( int nBufferPos = nSampleFrames; nBufferPos < nTimes; ++nBufferPos ) {
-		buffer_L[ nBufferPos ] = buffer_R[ nBufferPos ] = 0.0;
+	if ( pNote->get_adsr()->applyADSR( buffer_L, buffer_R, nTimes, nNoteEnd, 1 ) ) {
+		voice.bEnded = true;
 	}
 
-	if ( pADSR->applyADSR( buffer_L, buffer_R, nTimes, nNoteEnd, 1 ) ) {
-		retValue = true;
-	}
-	bool bFilterIsActive = pInstrument->is_filter_active();
 	// Low pass resonant filter
-
-	if ( bFilterIsActive ) {
+	if ( pInstrument->is_filter_active() ) {
+		float fVal_L;
+		float fVal_R;
 		for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
 
 			fVal_L = buffer_L[ nBufferPos ];
@@ -981,298 +1123,79 @@ bool Sampler::renderNoteNoResample(
 
 			buffer_L[ nBufferPos ] = fVal_L;
 			buffer_R[ nBufferPos ] = fVal_R;
-
-		}
-	}
-
-	for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
-
-		fVal_L = buffer_L[ nBufferPos ];
-		fVal_R = buffer_R[ nBufferPos ];
-
-
-#ifdef H2CORE_HAVE_JACK
-		if(  pTrackOutL ) {
-			 pTrackOutL[nBufferPos] += fVal_L * cost_track_L;
-		}
-		if( pTrackOutR ) {
-			pTrackOutR[nBufferPos] += fVal_R * cost_track_R;
 		}
-#endif
-
-		fVal_L = fVal_L * cost_L;
-		fVal_R = fVal_R * cost_R;
 
-		// update instr peak
-		if ( fVal_L > fInstrPeak_L ) {
-			fInstrPeak_L = fVal_L;
+		if ( pNote->filter_sustain() ) {
+			// Note is still ringing, do not end.
+			voice.bEnded = false;
 		}
-		if ( fVal_R > fInstrPeak_R ) {
-			fInstrPeak_R = fVal_R;
-		}
-
-		pDrumCompo->set_outs( nBufferPos, fVal_L, fVal_R );
-
-		// to main mix
-		m_pMainOut_L[nBufferPos] += fVal_L;
-		m_pMainOut_R[nBufferPos] += fVal_R;
-
-	}
-	if ( pInstrument->is_filter_active() && pNote->filter_sustain() ) {
-		// Note is still ringing, do not end.
-		retValue = false;
 	}
 
-	pSelectedLayerInfo->SamplePosition += nAvail_bytes;
-	pInstrument->set_peak_l( fInstrPeak_L );
-	pInstrument->set_peak_r( fInstrPeak_R );
-
-
-#ifdef H2CORE_HAVE_LADSPA
-	// LADSPA
-	// change the below return logic if you add code after that ifdef
-	if (pInstrument->is_muted() || pSong->getIsMuted() ) return retValue;
-	float masterVol =  pSong->getVolume();
-	for ( unsigned nFX = 0; nFX < MAX_FX; ++nFX ) {
-		LadspaFX *pFX = Effects::get_instance()->getLadspaFX( nFX );
-
-		float fLevel = pInstrument->get_fx_level( nFX );
-
-		if ( ( pFX ) && ( fLevel != 0.0 ) ) {
-			fLevel = fLevel * pFX->getVolume();
-			float *pBuf_L = pFX->m_pBuffer_L;
-			float *pBuf_R = pFX->m_pBuffer_R;
-
-			float fFXCost_L = fLevel * masterVol;
-			float fFXCost_R = fLevel * masterVol;
-
-			int nBufferPos = nInitialBufferPos;
-			int nSamplePos = nInitialSamplePos;
-			for ( int i = 0; i < nAvail_bytes; ++i ) {
-				pBuf_L[ nBufferPos ] += pSample_data_L[ nSamplePos ] * fFXCost_L;
-				pBuf_R[ nBufferPos ] += pSample_data_R[ nSamplePos ] * fFXCost_R;
-				++nSamplePos;
-				++nBufferPos;
-			}
-		}
+	voice.fInitialSamplePosition = pSelectedLayerInfo->SamplePosition;
+	voice.nAvailFrames = nAvail_bytes;
+	voice.nTimes = nTimes;
+	if ( ! voice.bResample ) {
+		pSelectedLayerInfo->SamplePosition += nAvail_bytes;
+	} else {
+		pSelectedLayerInfo->SamplePosition += nAvail_bytes * voice.fStep;
 	}
-	// ~LADSPA
-#endif
-
-	return retValue;
 }
 
-bool Sampler::renderNoteResample(
-	std::shared_ptr<Sample> pSample,
-	Note *pNote,
-	std::shared_ptr<SelectedLayerInfo> pSelectedLayerInfo,
-	std::shared_ptr<InstrumentComponent> pCompo,
-	DrumkitComponent *pDrumCompo,
-	int nBufferSize,
-	int nInitialSilence,
-	float cost_L,
-	float cost_R,
-	float cost_track_L,
-	float cost_track_R,
-	float fLayerPitch,
-	std::shared_ptr<Song> pSong
-)
+/// Mix a rendered voice into the main, component, track, and FX
+/// outputs
+void Sampler::mixVoice( Note* pNote, const Voice& voice, std::shared_ptr<Song> pSong )
 {
-	auto pAudioDriver = Hydrogen::get_instance()->getAudioOutput();
-	auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
 	auto pInstrument = pNote->get_instrument();
-
-	int nNoteLength = -1;
-	// Note is not located at the very beginning of the song and is
-	// enqueued by the AudioEngine. Take possible changes in tempo
-	// into account
-	if ( pNote->get_length() != -1 ) {
-		double fTickMismatch;
-
-		int nEffectiveDelay = 0;
-		if ( pNote->get_humanize_delay() < 0 ) {
-			nEffectiveDelay = pNote->get_humanize_delay();
-		}
-		
-		nNoteLength =
-			pAudioEngine->computeFrameFromTick( pNote->get_position() +
-												nEffectiveDelay +
-												pNote->get_length(), &fTickMismatch,
-												pSample->get_sample_rate() ) -
-			pAudioEngine->computeFrameFromTick( pNote->get_position() +
-												nEffectiveDelay, &fTickMismatch,
-												pSample->get_sample_rate() );
-	}
-
-	float fNotePitch = pNote->get_total_pitch() + fLayerPitch;
-	float fStep = Note::pitchToFrequency( fNotePitch );
-
-	fStep *= static_cast<float>(pSample->get_sample_rate()) /
-		static_cast<float>(pAudioDriver->getSampleRate()); // Adjust for audio driver sample rate
-
-	// verifico il numero di frame disponibili ancora da eseguire
-	int nAvail_bytes = ( int )( ( float )( pSample->get_frames() - pSelectedLayerInfo->SamplePosition ) / fStep );
-
-
-	bool retValue = true; // the note is ended
-	if ( nAvail_bytes > nBufferSize - nInitialSilence ) {	// il sample e' piu' grande del buffersize
-		// imposto il numero dei bytes disponibili uguale al buffersize
-		nAvail_bytes = nBufferSize - nInitialSilence;
-		retValue = false; // the note is not ended yet
-	} else if ( pInstrument->is_filter_active() && pNote->filter_sustain() ) {
-		// If filter is causing note to ring, process more samples.
-		nAvail_bytes = nBufferSize - nInitialSilence;
+	const auto& pSample = voice.pSample;
+	DrumkitComponent* pDrumCompo = voice.pDrumCompo;
+	const float* buffer_L = voice.pBuffer_L;
+	const float* buffer_R = voice.pBuffer_R;
+	const int nInitialBufferPos = voice.nInitialSilence;
+	const int nTimes = voice.nTimes;
+	const int nAvail_bytes = voice.nAvailFrames;
+	float* pStemOut_L = nullptr;
+	float* pStemOut_R = nullptr;
+	if ( voice.nStem >= 0 ) {
+		pStemOut_L = m_stemOutputs[ voice.nStem ].pOut_L;
+		pStemOut_R = m_stemOutputs[ voice.nStem ].pOut_R;
 	}
 
-	int nInitialBufferPos = nInitialSilence;
-	//float fInitialSamplePos = pNote->get_sample_position( pCompo->get_drumkit_componentID() );
-	double fSamplePos = pSelectedLayerInfo->SamplePosition;
-	int nTimes = nInitialBufferPos + nAvail_bytes;
-
-	auto pSample_data_L = pSample->get_data_l();
-	auto pSample_data_R = pSample->get_data_r();
-
 	float fInstrPeak_L = pInstrument->get_peak_l(); // this value will be reset to 0 by the mixer..
 	float fInstrPeak_R = pInstrument->get_peak_r(); // this value will be reset to 0 by the mixer..
 
-	auto pADSR = pNote->get_adsr();
-	float fADSRValue = 1.0;
 	float fVal_L;
 	float fVal_R;
-	int nSampleFrames = pSample->get_frames();
-	int nNoteEnd;
-	if ( nNoteLength == -1) {
-		nNoteEnd = nSampleFrames + 1;
-	}
-	else {
-		nNoteEnd = nNoteLength - pSelectedLayerInfo->SamplePosition;
-	}
-
 
 #ifdef H2CORE_HAVE_JACK
 	float *		pTrackOutL = nullptr;
 	float *		pTrackOutR = nullptr;
 
 	if ( Preferences::get_instance()->m_bJackTrackOuts ) {
-		auto pJackAudioDriver = dynamic_cast<JackAudioDriver*>( pAudioDriver );
+		auto pJackAudioDriver = dynamic_cast<JackAudioDriver*>( Hydrogen::get_instance()->getAudioOutput() );
 		if( pJackAudioDriver ) {
-			pTrackOutL = pJackAudioDriver->getTrackOut_L( pInstrument, pCompo );
-			pTrackOutR = pJackAudioDriver->getTrackOut_R( pInstrument, pCompo );
+			pTrackOutL = pJackAudioDriver->getTrackOut_L( pInstrument, voice.pCompo );
+			pTrackOutR = pJackAudioDriver->getTrackOut_R( pInstrument, voice.pCompo );
 		}
 	}
 #endif
 
-	float buffer_L[MAX_BUFFER_SIZE];
-	float buffer_R[MAX_BUFFER_SIZE];
-
-
-	// Main rendering loop.
-	// With some re-work, more of this could likely be vectorised fairly easily.
-	//   - assert no buffer aliasing
-	//   - template and multiple instantiations for is_filter_active x each interpolation method
-	//   - iterate LP IIR filter coefficients to longer IIR filter to fit vector width
-	//
 	for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
 
-		int nSamplePos = ( int )fSamplePos;
-		double fDiff = fSamplePos - nSamplePos;
-		if ( ( nSamplePos - 1 ) >= nSampleFrames ) {
-			//we reach the last audioframe.
-			//set this last frame to zero do nothing wrong.
-			fVal_L = 0.0;
-			fVal_R = 0.0;
-		} else {
-			// Gather frame samples
-			float l0, l1, l2, l3, r0, r1, r2, r3;
-			// Short-circuit: the common case is that all required frames are within the sample.
-			if ( nSamplePos >= 1 && nSamplePos + 2 < nSampleFrames ) {
-				l0 = pSample_data_L[ nSamplePos-1 ];
-				l1 = pSample_data_L[ nSamplePos ];
-				l2 = pSample_data_L[ nSamplePos+1 ];
-				l3 = pSample_data_L[ nSamplePos+2 ];
-				r0 = pSample_data_R[ nSamplePos-1 ];
-				r1 = pSample_data_R[ nSamplePos ];
-				r2 = pSample_data_R[ nSamplePos+1 ];
-				r3 = pSample_data_R[ nSamplePos+2 ];
-			} else {
-				l0 = l1 = l2 = l3 = r0 = r1 = r2 = r3 = 0.0;
-				// Some required frames are off the beginning or end of the sample.
-				if ( nSamplePos >= 1 && nSamplePos < nSampleFrames + 1 ) {
-					l0 = pSample_data_L[ nSamplePos-1 ];
-					r0 = pSample_data_R[ nSamplePos-1 ];
-				}
-				// Each successive frame may be past the end of the sample so check individually.
-				if ( nSamplePos < nSampleFrames ) {
-					l1 = pSample_data_L[ nSamplePos ];
-					r1 = pSample_data_R[ nSamplePos ];
-					if ( nSamplePos+1 < nSamplePos ) {
-						l2 = pSample_data_L[ nSamplePos+1 ];
-						r2 = pSample_data_R[ nSamplePos+1 ];
-						if ( nSamplePos+2 < nSamplePos ) {
-							l3 = pSample_data_L[ nSamplePos+2 ];
-							r3 = pSample_data_R[ nSamplePos+2 ];
-						}
-					}
-				}
-			}
-
-			// Interpolate frame values from Sample domain to audio output range
-			switch ( m_interpolateMode ) {
-			case Interpolation::InterpolateMode::Linear:
-				fVal_L = l1 * (1 - fDiff ) + l2 * fDiff;
-				fVal_R = r1 * (1 - fDiff ) + r2 * fDiff;
-				break;
-			case Interpolation::InterpolateMode::Cosine:
-				fVal_L = Interpolation::cosine_Interpolate( l1, l2, fDiff);
-				fVal_R = Interpolation::cosine_Interpolate( r1, r2, fDiff);
-				break;
-			case Interpolation::InterpolateMode::Third:
-				fVal_L = Interpolation::third_Interpolate( l0, l1, l2, l3, fDiff);
-				fVal_R = Interpolation::third_Interpolate( r0, r1, r2, r3, fDiff);
-				break;
-			case Interpolation::InterpolateMode::Cubic:
-				fVal_L = Interpolation::cubic_Interpolate( l0, l1, l2, l3, fDiff);
-				fVal_R = Interpolation::cubic_Interpolate( r0, r1, r2, r3, fDiff);
-				break;
-			case Interpolation::InterpolateMode::Hermite:
-				fVal_L = Interpolation::hermite_Interpolate( l0, l1, l2, l3, fDiff);
-				fVal_R = Interpolation::hermite_Interpolate( r0, r1, r2, r3, fDiff);
-				break;
-			}
-		}
-
-		buffer_L[nBufferPos] = fVal_L;
-		buffer_R[nBufferPos] = fVal_R;
-
-		fSamplePos += fStep;
-	}
-
-	if ( pADSR->applyADSR( buffer_L, buffer_R, nTimes, nNoteEnd, 1 ) ) {
-		retValue = true;
-	}
-
-	// Mix rendered sample buffer to track and mixer output
-	for ( int nBufferPos = nInitialBufferPos; nBufferPos < nTimes; ++nBufferPos ) {
-
-		fVal_L = buffer_L[nBufferPos];
-		fVal_R = buffer_R[nBufferPos];
+		fVal_L = buffer_L[ nBufferPos ];
+		fVal_R = buffer_R[ nBufferPos ];
 
-		// Low pass resonant filter
-		if ( pInstrument->is_filter_active() ) {
-			pNote->compute_lr_values( &fVal_L, &fVal_R );
-		}
 
 #ifdef H2CORE_HAVE_JACK
-		if ( pTrackOutL ) {
-			pTrackOutL[nBufferPos] += fVal_L * cost_track_L;
+		if(  pTrackOutL ) {
+			 pTrackOutL[nBufferPos] += fVal_L * voice.fCostTrack_L;
 		}
-		if ( pTrackOutR ) {
-			pTrackOutR[nBufferPos] += fVal_R * cost_track_R;
+		if( pTrackOutR ) {
+			pTrackOutR[nBufferPos] += fVal_R * voice.fCostTrack_R;
 		}
 #endif
 
-		fVal_L = fVal_L * cost_L;
-		fVal_R = fVal_R * cost_R;
+		fVal_L = fVal_L * voice.fCost_L;
+		fVal_R = fVal_R * voice.fCost_R;
 
 		// update instr peak
 		if ( fVal_L > fInstrPeak_L ) {
@@ -1288,24 +1211,29 @@ bool Sampler::renderNoteResample(
 		m_pMainOut_L[nBufferPos] += fVal_L;
 		m_pMainOut_R[nBufferPos] += fVal_R;
 
+		if ( pStemOut_L != nullptr ) {
+			pStemOut_L[nBufferPos] += fVal_L;
+			pStemOut_R[nBufferPos] += fVal_R;
+		}
 	}
 
-	if ( pInstrument->is_filter_active() && pNote->filter_sustain() ) {
-		// Note is still ringing, do not end.
-		retValue = false;
-	}
-	
-	pSelectedLayerInfo->SamplePosition += nAvail_bytes * fStep;
 	pInstrument->set_peak_l( fInstrPeak_L );
 	pInstrument->set_peak_r( fInstrPeak_R );
 
+	// Stay ahead of the playhead in samples not residing in
+	// memory as a whole.
+	if ( pSample->isStreamed() && ! voice.bEnded ) {
+		m_pSamplePrefetcher->prefetch( pSample.get(), voice.fInitialSamplePosition,
+									   voice.pSelectedLayerInfo->SamplePosition );
+	}
 
 #ifdef H2CORE_HAVE_LADSPA
 	// LADSPA
-	// change the below return logic if you add code after that ifdef
 	if ( pInstrument->is_muted() || pSong->getIsMuted() ) {
-		return retValue;
+		return;
 	}
+	auto pSample_data_L = pSample->get_data_l();
+	auto pSample_data_R = pSample->get_data_r();
 	float masterVol = pSong->getVolume();
 	for ( unsigned nFX = 0; nFX < MAX_FX; ++nFX ) {
 		LadspaFX *pFX = Effects::get_instance()->getLadspaFX( nFX );
@@ -1320,30 +1248,38 @@ bool Sampler::renderNoteResample(
 			float fFXCost_R = fLevel * masterVol;
 
 			int nBufferPos = nInitialBufferPos;
-			for ( int i = 0; i < nAvail_bytes; ++i ) {
-
-				fVal_L = buffer_L[ nBufferPos ];
-				fVal_R = buffer_R[ nBufferPos ];
-
-				pBuf_L[ nBufferPos ] += fVal_L * fFXCost_L;
-				pBuf_R[ nBufferPos ] += fVal_R * fFXCost_R;
-				++nBufferPos;
+			if ( ! voice.bResample ) {
+				// The dry sample is send to the effects.
+				int nSamplePos = ( int )voice.fInitialSamplePosition;
+				for ( int i = 0; i < nAvail_bytes; ++i ) {
+					pBuf_L[ nBufferPos ] += pSample_data_L[ nSamplePos ] * fFXCost_L;
+					pBuf_R[ nBufferPos ] += pSample_data_R[ nSamplePos ] * fFXCost_R;
+					++nSamplePos;
+					++nBufferPos;
+				}
+			} else {
+				for ( int i = 0; i < nAvail_bytes; ++i ) {
+					pBuf_L[ nBufferPos ] += buffer_L[ nBufferPos ] * fFXCost_L;
+					pBuf_R[ nBufferPos ] += buffer_R[ nBufferPos ] * fFXCost_R;
+					++nBufferPos;
+				}
 			}
 		}
 	}
+	// ~LADSPA
 #endif
-	return retValue;
 }
 
 
 void Sampler::stopPlayingNotes( std::shared_ptr<Instrument> pInstr )
 {
+	auto pNotePool = Hydrogen::get_instance()->getAudioEngine()->getNotePool();
 	if ( pInstr ) { // stop all notes using this instrument
 		for ( unsigned i = 0; i < m_playingNotesQueue.size(); ) {
 			Note *pNote = m_playingNotesQueue[ i ];
 			assert( pNote );
 			if ( pNote->get_instrument() == pInstr ) {
-				delete pNote;
+				pNotePool->release( pNote );
 				pInstr->dequeue();
 				m_playingNotesQueue.erase( m_playingNotesQueue.begin() + i );
 			}
@@ -1354,7 +1290,7 @@ void Sampler::stopPlayingNotes( std::shared_ptr<Instrument> pInstr )
 		for ( unsigned i = 0; i < m_playingNotesQueue.size(); ++i ) {
 			Note *pNote = m_playingNotesQueue[i];
 			pNote->get_instrument()->dequeue();
-			delete pNote;
+			pNotePool->release( pNote );
 		}
 		m_playingNotesQueue.clear();
 	}
@@ -1372,10 +1308,13 @@ void Sampler::preview_sample(std::shared_ptr<Sample> pSample, int length )
 
 		pLayer->set_sample( pSample );
 
-		Note *pPreviewNote = new Note( m_pPreviewInstrument, 0, 1.0, 0.f, length, 0 );
-
 		stopPlayingNotes( m_pPreviewInstrument );
-		noteOn( pPreviewNote );
+
+		Note *pPreviewNote = Hydrogen::get_instance()->getAudioEngine()->getNotePool()->
+			create( m_pPreviewInstrument, 0, 1.0, 0.f, length, 0 );
+		if ( pPreviewNote != nullptr ) {
+			noteOn( pPreviewNote );
+		}
 
 	}
 
@@ -1395,9 +1334,11 @@ void Sampler::preview_instrument( std::shared_ptr<Instrument> pInstr )
 	m_pPreviewInstrument = pInstr;
 	pInstr->set_is_preview_instrument(true);
 
-	Note *pPreviewNote = new Note( m_pPreviewInstrument, 0, 1.0, 0.f, MAX_NOTES, 0 );
-
-	noteOn( pPreviewNote );	// exclusive note
+	Note *pPreviewNote = Hydrogen::get_instance()->getAudioEngine()->getNotePool()->
+		create( m_pPreviewInstrument, 0, 1.0, 0.f, MAX_NOTES, 0 );
+	if ( pPreviewNote != nullptr ) {
+		noteOn( pPreviewNote );	// exclusive note
+	}
 	Hydrogen::get_instance()->getAudioEngine()->unlock();
 }
 
@@ -1443,13 +1384,43 @@ void Sampler::reinitializePlaybackTrack()
 	}
 
 	if( pHydrogen->getPlaybackTrackState() != Song::PlaybackTrack::Unavailable ){
-		pSample = Sample::load( pSong->getPlaybackTrackFilename() );
+		// Converting the sample rate once while loading is both
+		// cheaper and of higher quality than interpolating in each
+		// cycle.
+		pSample = Sample::loadConverted( pSong->getPlaybackTrackFilename(),
+										 getPlaybackTrackSampleRate() );
 	}
 	
 	auto  pPlaybackTrackLayer = std::make_shared<InstrumentLayer>( pSample );
 
 	m_pPlaybackTrackInstrument->get_components()->front()->set_layer( pPlaybackTrackLayer, 0 );
+	// Both the new and the replaced track might be streamed.
+	updateSamplePrefetcher();
 	m_nPlayBackSamplePosition = 0;
+	m_bPlaybackTrackSeeking = false;
+	m_nPlaybackTrackFadeIn = 0;
+}
+
+void Sampler::updatePlaybackTrackSampleRate()
+{
+	auto pLayer = m_pPlaybackTrackInstrument->get_components()->front()->get_layer( 0 );
+	if ( pLayer == nullptr || pLayer->get_sample() == nullptr ||
+		 pLayer->get_sample()->get_sample_rate() == getPlaybackTrackSampleRate() ) {
+		return;
+	}
+
+	INFOLOG( QString( "Converting playback track to [%1] Hz" )
+			 .arg( getPlaybackTrackSampleRate() ) );
+	reinitializePlaybackTrack();
+}
+
+int Sampler::getPlaybackTrackSampleRate() const
+{
+	auto pAudioDriver = Hydrogen::get_instance()->getAudioOutput();
+	if ( pAudioDriver != nullptr && pAudioDriver->getSampleRate() > 0 ) {
+		return static_cast<int>( pAudioDriver->getSampleRate() );
+	}
+	return static_cast<int>( Preferences::get_instance()->m_nSampleRate );
 }
 
 };
@@ -38,6 +38,8 @@ namespace H2Core
 class Note;
 class Song;
 class Sample;
+class SamplePrefetcher;
+class RenderWorkerPool;
 class DrumkitComponent;
 class Instrument;
 struct SelectedLayerInfo;
@@ -219,9 +221,27 @@ public:
 	 * new InstrumentLayer containing the loaded Sample. If
 	 * Song::__playback_track_filename is empty, the layer will be
 	 * loaded with a nullptr instead.
+	 *
+	 * The track is converted to the sample rate of the current audio
+	 * driver and streamed from the sample cache (see
+	 * Sample::loadConverted()).
 	 */
 	void reinitializePlaybackTrack();
 
+	/**
+	 * Starts the #SamplePrefetcher while
+	 * Preferences::m_bUseSampleStreaming is set or streamed samples
+	 * are still loaded (see Sample::getStreamedSamples()) and stops
+	 * it otherwise.
+	 *
+	 * Has to be called whenever the preference changes. Must not be
+	 * called from within the audio thread.
+	 */
+	void updateSamplePrefetcher();
+	/** Reloads the playback track in case it does not match the
+	 * sample rate of the current audio driver anymore.*/
+	void updatePlaybackTrackSampleRate();
+
 	/** 
 	 * Recalculates all note starts to make them valid again after a
 	 * TempoMarker was added to or deleted from the #Timeline or the
@@ -236,6 +256,30 @@ public:
 	void handleSongSizeChange();
 
 	const std::vector<Note*> getPlayingNotesQueue() const;
+
+	/** Additional output of a single instrument used to export
+	 * stems.*/
+	struct StemOutput {
+		/** Instrument::__id of the instrument mixed into the buffers.*/
+		int nInstrumentId;
+		float* pOut_L;
+		float* pOut_R;
+	};
+
+	/**
+	 * Sets buffers the voices of particular instruments are mixed
+	 * into in addition to the main out.
+	 *
+	 * Used by the #DiskWriterDriver to export the stems of all
+	 * instruments in a single pass. The buffers are zeroed at the
+	 * beginning of each process() cycle and receive the same signal
+	 * the instrument contributes to the main out, without the sends
+	 * to the LADSPA effects. An empty vector disables the stem
+	 * outputs.
+	 *
+	 * Must not be called while process() is running.
+	 */
+	void setStemOutputs( const std::vector<StemOutput>& stems );
 	
 private:
 	std::vector<Note*> m_playingNotesQueue;
@@ -254,7 +298,22 @@ private:
 	    assigned in Preferences::Preferences(): 16.*/
 	int m_nMaxLayers;
 	
-	int m_nPlayBackSamplePosition;
+	/** Frame of the playback track following the ones rendered in
+	 * the last cycle. Used to detect relocations.*/
+	long long m_nPlayBackSamplePosition;
+	/** Whether the playback track was relocated and the frames at
+	 * the new position were not resident yet.*/
+	bool m_bPlaybackTrackSeeking;
+	/** Remaining frames of the fade-in following a relocation of the
+	 * playback track which had to wait for the disk.*/
+	int m_nPlaybackTrackFadeIn;
+	/** Length of the fade-in in frames. See
+	 * #m_nPlaybackTrackFadeIn.*/
+	static constexpr int nPlaybackTrackFadeInFrames = 256;
+
+	/** Reads ahead the streamed samples of all playing notes and of
+	 * the playback track.*/
+	SamplePrefetcher* m_pSamplePrefetcher;
 	
 	/** function to direct the computation to the selected pan law function
 	 */
@@ -262,44 +321,89 @@ private:
 
 
 
+	/**
+	 * Mixes the playback track into the main outputs.
+	 *
+	 * Its position is derived from the transport position. Jumping
+	 * within the track is free since it is streamed from the
+	 * memory-mapped sample cache. But after a relocation the frames
+	 * at the new position might have to be read from disk first.
+	 * Instead of blocking the audio thread, the track stays silent
+	 * until the #SamplePrefetcher has read them in - usually a few
+	 * cycles, depending on the disk - and is faded in over
+	 * #nPlaybackTrackFadeInFrames afterwards. The beginning of the
+	 * track is locked in memory and always plays right away.
+	 */
 	bool processPlaybackTrack(int nBufferSize);
+	/** \return Sample rate the playback track is converted to.*/
+	int getPlaybackTrackSampleRate() const;
 	
 	bool isAnyInstrumentSoloed() const;
 	
-	bool renderNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Song> pSong );
+	/** Parameters and results of rendering a single component of a
+	 * playing note.*/
+	struct Voice {
+		std::shared_ptr<Sample> pSample;
+		SelectedLayerInfo* pSelectedLayerInfo;
+		std::shared_ptr<InstrumentComponent> pCompo;
+		DrumkitComponent* pDrumCompo;
+		int nBufferSize;
+		int nInitialSilence;
+		float fCost_L;
+		float fCost_R;
+		float fCostTrack_L;
+		float fCostTrack_R;
+		bool bResample;
+		/** Step size used to move through the sample.*/
+		float fStep;
+		/** Length of the note in frames or -1 if it has none.*/
+		int nNoteLength;
+		/** Section of #m_pScratchBuffer the voice is rendered into.*/
+		float* pBuffer_L;
+		float* pBuffer_R;
+		/** Index of the stem output in #m_stemOutputs or -1.*/
+		int nStem;
+
+		// Set by renderVoice()
+		double fInitialSamplePosition;
+		int nAvailFrames;
+		/** Index of the buffer frame following the rendered ones.*/
+		int nTimes;
+		bool bEnded;
+	};
+
+	/** All voices of a playing note. Different notes can be rendered
+	 * in parallel.*/
+	struct NoteJob {
+		Note* pNote;
+		/** Index of the first voice in #m_voices.*/
+		int nFirstVoice;
+		int nVoices;
+		/** Whether the note is done after all voices are rendered.*/
+		bool bEnded;
+	};
+
+	void prepareNote( Note* pNote, unsigned nBufferSize, std::shared_ptr<Song> pSong,
+					  NoteJob& job, int& nVoices );
+	void renderNoteJob( NoteJob& job );
+	void renderVoice( Note* pNote, Voice& voice );
+	void mixVoice( Note* pNote, const Voice& voice, std::shared_ptr<Song> pSong );
 
 	Interpolation::InterpolateMode m_interpolateMode;
 
-	bool renderNoteNoResample(
-		std::shared_ptr<Sample> pSample,
-		Note *pNote,
-		std::shared_ptr<SelectedLayerInfo> pSelectedLayerInfo,
-		std::shared_ptr<InstrumentComponent> pCompo,
-		DrumkitComponent *pDrumCompo,
-		int nBufferSize,
-		int nInitialSilence,
-		float cost_L,
-		float cost_R,
-		float cost_track_L,
-		float cost_track_R,
-		std::shared_ptr<Song> pSong
-	);
-
-	bool renderNoteResample(
-		std::shared_ptr<Sample> pSample,
-		Note *pNote,
-		std::shared_ptr<SelectedLayerInfo> pSelectedLayerInfo,
-		std::shared_ptr<InstrumentComponent> pCompo,
-		DrumkitComponent *pDrumCompo,
-		int nBufferSize,
-		int nInitialSilence,
-		float cost_L,
-		float cost_R,
-		float cost_track_L,
-		float cost_track_R,
-		float fLayerPitch,
-		std::shared_ptr<Song> pSong
-	);
+	/** Preallocated voices and jobs of the current batch of notes.*/
+	std::vector<Voice> m_voices;
+	std::vector<NoteJob> m_noteJobs;
+	/** Holds the rendered output of all voices of the current batch
+	 * of notes.*/
+	float* m_pScratchBuffer;
+	int m_nScratchBufferSize;
+	/** Renders the notes in parallel. nullptr if
+	 * Preferences::m_nRenderThreads is 0.*/
+	RenderWorkerPool* m_pRenderWorkerPool;
+
+	/** Set by setStemOutputs().*/
+	std::vector<StemOutput> m_stemOutputs;
 };
 
 inline const std::vector<Note*> Sampler::getPlayingNotesQueue() const {
@@ -0,0 +1,81 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <core/Sampler/Semaphore.h>
+
+#ifdef WIN32
+#include <windows.h>
+#include <climits>
+#endif
+
+namespace H2Core
+{
+
+Semaphore::Semaphore() {
+#ifdef WIN32
+	m_semaphore = CreateSemaphore( nullptr, 0, LONG_MAX, nullptr );
+#elif defined(__APPLE__)
+	m_semaphore = dispatch_semaphore_create( 0 );
+#else
+	sem_init( &m_semaphore, 0, 0 );
+#endif
+}
+
+Semaphore::~Semaphore() {
+#ifdef WIN32
+	CloseHandle( m_semaphore );
+#elif defined(__APPLE__)
+	dispatch_release( m_semaphore );
+#else
+	sem_destroy( &m_semaphore );
+#endif
+}
+
+void Semaphore::post( int nCount ) {
+#ifdef WIN32
+	if ( nCount > 0 ) {
+		ReleaseSemaphore( m_semaphore, nCount, nullptr );
+	}
+#else
+	for ( int ii = 0; ii < nCount; ++ii ) {
+#ifdef __APPLE__
+		dispatch_semaphore_signal( m_semaphore );
+#else
+		sem_post( &m_semaphore );
+#endif
+	}
+#endif
+}
+
+void Semaphore::wait() {
+#ifdef WIN32
+	WaitForSingleObject( m_semaphore, INFINITE );
+#elif defined(__APPLE__)
+	dispatch_semaphore_wait( m_semaphore, DISPATCH_TIME_FOREVER );
+#else
+	while ( sem_wait( &m_semaphore ) != 0 ) {
+		// Interrupted by a signal.
+	}
+#endif
+}
+
+};
@@ -0,0 +1,70 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef SEMAPHORE_H
+#define SEMAPHORE_H
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif ! defined(WIN32)
+#include <semaphore.h>
+#endif
+
+namespace H2Core
+{
+
+/**
+ * Counting semaphore which can be posted from the audio thread.
+ *
+ * Posting neither locks nor allocates. It only enters the kernel in
+ * case another thread is waiting.
+ */
+/** \ingroup docCore docAudioEngine */
+class Semaphore
+{
+public:
+	Semaphore();
+	~Semaphore();
+
+	Semaphore( const Semaphore& ) = delete;
+	Semaphore& operator=( const Semaphore& ) = delete;
+
+	/** Increments the counter by @a nCount and wakes up to @a nCount
+	 * waiting threads.*/
+	void post( int nCount = 1 );
+	/** Blocks till the counter is positive and decrements it.*/
+	void wait();
+
+private:
+#ifdef WIN32
+	/** HANDLE of the Windows semaphore.*/
+	void* m_semaphore;
+#elif defined(__APPLE__)
+	dispatch_semaphore_t m_semaphore;
+#else
+	sem_t m_semaphore;
+#endif
+};
+
+};
+
+#endif
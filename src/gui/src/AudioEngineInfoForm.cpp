@@ -28,8 +28,11 @@
 
 #include "HydrogenApp.h"
 
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentList.h>
 #include <core/Basics/Pattern.h>
 #include <core/Basics/PatternList.h>
+#include <core/CoreActionController.h>
 #include <core/Preferences/Preferences.h>
 #include <core/Hydrogen.h>
 #include <core/IO/MidiInput.h>
@@ -43,6 +46,8 @@ AudioEngineInfoForm::AudioEngineInfoForm(QWidget* parent)
  , Object()
 {
 	setupUi( this );
+	m_pDspProfileLbl->setFont( QFontDatabase::systemFont( QFontDatabase::FixedFont ) );
+	connect( m_pDspProfileResetBtn, SIGNAL( clicked() ), this, SLOT( resetDspProfile() ) );
 	adjustSize();
 	setFixedSize( width(), height() );	// not resizable
 
@@ -203,6 +208,70 @@ void AudioEngineInfoForm::updateInfo()
 	// Synth
 	Synth *pSynth = pAudioEngine->getSynth();
 	synth_playingNotesLbl->setText( QString( "%1" ).arg( pSynth->getPlayingNotesNumber() ) );
+
+	updateDspProfile();
+}
+
+void AudioEngineInfoForm::updateDspProfile()
+{
+	Hydrogen *pHydrogen = Hydrogen::get_instance();
+	const auto report = pHydrogen->getCoreActionController()->getDspProfile();
+
+	QString sLastXrun = "N/A";
+	if ( report.nLastXrunStage >= 0 ) {
+		sLastXrun = DspProfiler::getStageName(
+			static_cast<DspProfiler::Stage>( report.nLastXrunStage ) );
+	}
+	QString sText = QString( "Cycles: %1  Xruns: %2  Dropped: %3  Last xrun: %4\n\n" )
+		.arg( report.nCycles ).arg( report.nXruns ).arg( report.nDroppedCycles )
+		.arg( sLastXrun );
+	sText.append( QString( "%1 %2 %3 %4\n" )
+				  .arg( "Stage", -18 ).arg( "mean [us]", 10 )
+				  .arg( "max [us]", 10 ).arg( "xruns", 7 ) );
+
+	auto addLine = [&]( const QString& sName, const DspProfiler::Histogram& histogram,
+						long long nXruns ) {
+		sText.append( QString( "%1 %2 %3 %4\n" )
+					  .arg( sName, -18 )
+					  .arg( histogram.getMeanUs(), 10, 'f', 1 )
+					  .arg( histogram.fMaxUs, 10, 'f', 1 )
+					  .arg( nXruns, 7 ) );
+	};
+	for ( int ii = 0; ii < DspProfiler::nStages; ++ii ) {
+		addLine( DspProfiler::getStageName( static_cast<DspProfiler::Stage>( ii ) ),
+				 report.stages[ ii ], report.xrunsByStage[ ii ] );
+	}
+	for ( int ii = 0; ii < MAX_FX; ++ii ) {
+		if ( report.ladspa[ ii ].nCount > 0 ) {
+			addLine( QString( "  Ladspa slot %1" ).arg( ii ), report.ladspa[ ii ], 0 );
+		}
+	}
+
+	// Instruments taking the most time to render.
+	auto pSong = pHydrogen->getSong();
+	const int nMaxInstruments = 3;
+	for ( int ii = 0; ii < std::min( nMaxInstruments,
+									 static_cast<int>( report.instruments.size() ) ); ++ii ) {
+		const auto& instrument = report.instruments[ ii ];
+		QString sName = QString::number( instrument.first );
+		if ( pSong != nullptr ) {
+			auto pInstr = pSong->getInstrumentList()->find( instrument.first );
+			if ( pInstr != nullptr ) {
+				sName = pInstr->get_name();
+			}
+		}
+		sText.append( QString( "\n%1 %2 ms total" )
+					  .arg( sName.left( 18 ), -18 )
+					  .arg( instrument.second / 1000.0, 10, 'f', 1 ) );
+	}
+
+	m_pDspProfileLbl->setText( sText );
+}
+
+void AudioEngineInfoForm::resetDspProfile()
+{
+	Hydrogen::get_instance()->getCoreActionController()->resetDspProfile();
+	updateDspProfile();
 }
 
 
@@ -59,9 +59,12 @@ class AudioEngineInfoForm :  public QWidget, public Ui_AudioEngineInfoForm_UI, p
 
 	public slots:
 		void updateInfo();
+		void resetDspProfile();
 
 	private:
 		void updateAudioEngineState();
+		/** Displays the statistics of the DspProfiler.*/
+		void updateDspProfile();
 };
 
 #endif
@@ -63,6 +63,8 @@ class EventListener
 	virtual void songSizeChangedEvent(){}
 	virtual void driverChangedEvent(){}
 	virtual void playbackTrackChangedEvent(){}
+	virtual void notePoolExhaustedEvent( int nCapacity ){ UNUSED( nCapacity ); }
+	virtual void drumkitLoadingProgressEvent( int nProgress ){ UNUSED( nProgress ); }
 
 		virtual ~EventListener() {}
 };
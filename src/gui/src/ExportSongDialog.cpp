@@ -102,8 +102,6 @@ ExportSongDialog::ExportSongDialog(QWidget* parent)
 	m_pProgressBar->setValue( 0 );
 	
 	m_bQfileDialog = false;
-	m_bExportTrackouts = false;
-	m_nInstrument = 0;
 	m_sExtension = ".wav";
 	m_bOverwriteFiles = false;
 	m_bOldRubberbandBatchMode = m_pPreferences->getRubberBandBatchMode();
@@ -305,14 +303,14 @@ void ExportSongDialog::on_okBtn_clicked()
 
 	m_bOverwriteFiles = false;
 
-	if( exportTypeCombo->currentIndex() == EXPORT_TO_SINGLE_TRACK || exportTypeCombo->currentIndex() == EXPORT_TO_BOTH ){
-		m_bExportTrackouts = false;
+	const int nExportType = exportTypeCombo->currentIndex();
+	QString filename = exportNameTxt->text();
 
-		QString filename = exportNameTxt->text();
+	if( nExportType == EXPORT_TO_SINGLE_TRACK || nExportType == EXPORT_TO_BOTH ){
 		if ( QFileInfo( filename ).exists() == true && m_bQfileDialog == false ) {
 
 			int res;
-			if( exportTypeCombo->currentIndex() == EXPORT_TO_SINGLE_TRACK ){
+			if( nExportType == EXPORT_TO_SINGLE_TRACK ){
 				res = QMessageBox::information( this, "Hydrogen", tr( "The file %1 exists. \nOverwrite the existing file?").arg(filename), QMessageBox::Yes | QMessageBox::No );
 			} else {
 				res = QMessageBox::information( this, "Hydrogen", tr( "The file %1 exists. \nOverwrite the existing file?").arg(filename), QMessageBox::Yes | QMessageBox::No | QMessageBox::YesToAll);
@@ -326,135 +324,46 @@ void ExportSongDialog::on_okBtn_clicked()
 				return;
 			}
 		}
+	}
 
-		if( exportTypeCombo->currentIndex() == EXPORT_TO_BOTH ){
-			m_bExportTrackouts = true;
-		}
-		
-		/* arm all tracks for export */
-		for (auto i = 0; i < pInstrumentList->size(); i++) {
-			pInstrumentList->get(i)->set_currently_exported( true );
-		}
-
-		if ( ! m_pHydrogen->startExportSession( sampleRateCombo->currentText().toInt(),
-												sampleDepthCombo->currentText().toInt()) ) {
-			QMessageBox::critical( this, "Hydrogen", tr( "Unable to export song" ) );
+	// The separate tracks are rendered in the same pass as the main
+	// mix and written to one file per instrument.
+	std::vector<DiskWriterDriver::Stem> stems;
+	if( nExportType == EXPORT_TO_SEPARATE_TRACKS || nExportType == EXPORT_TO_BOTH ){
+		stems = m_pHydrogen->getExportStems( filename );
+		if ( ! confirmOverwriteStems( stems ) ) {
 			return;
 		}
-		m_pHydrogen->startExportSong( filename );
-		return;
 	}
 
-	if( exportTypeCombo->currentIndex() == EXPORT_TO_SEPARATE_TRACKS ){
-		m_bExportTrackouts = true;
-		m_pHydrogen->startExportSession(sampleRateCombo->currentText().toInt(), sampleDepthCombo->currentText().toInt());
-		exportTracks();
-		return;
+	if( nExportType == EXPORT_TO_SEPARATE_TRACKS ){
+		filename.clear();
 	}
-
-}
-
-bool ExportSongDialog::currentInstrumentHasNotes()
-{
-	std::shared_ptr<Song> pSong = m_pHydrogen->getSong();
-	unsigned nPatterns = pSong->getPatternList()->size();
-	
-	bool bInstrumentHasNotes = false;
-	
-	for ( unsigned i = 0; i < nPatterns; i++ ) {
-		Pattern *pPattern = pSong->getPatternList()->get( i );
-		const Pattern::notes_t* notes = pPattern->get_notes();
-		FOREACH_NOTE_CST_IT_BEGIN_END(notes,it) {
-			Note *pNote = it->second;
-			assert( pNote );
-
-			if( pNote->get_instrument()->get_id() == pSong->getInstrumentList()->get(m_nInstrument)->get_id() ){
-				bInstrumentHasNotes = true;
-				break;
-			}
-		}
+		
+	/* arm all tracks for export */
+	for (auto i = 0; i < pInstrumentList->size(); i++) {
+		pInstrumentList->get(i)->set_currently_exported( true );
 	}
-	
-	return bInstrumentHasNotes;
-}
 
-QString ExportSongDialog::findUniqueExportFilenameForInstrument( std::shared_ptr<Instrument> pInstrument )
-{
-	std::shared_ptr<Song> pSong = m_pHydrogen->getSong();
-	QString uniqueInstrumentName;
-	
-	int instrumentOccurence = 0;
-	for(int i=0; i  < pSong->getInstrumentList()->size(); i++ ){
-		if( pSong->getInstrumentList()->get(m_nInstrument)->get_name() == pInstrument->get_name()){
-			instrumentOccurence++;
-		}
-	}
-	
-	if(instrumentOccurence >= 2){
-		uniqueInstrumentName = pInstrument->get_name() + QString("_") + QString::number( pInstrument->get_id() );
-	} else {
-		uniqueInstrumentName = pInstrument->get_name();
+	if ( ! m_pHydrogen->startExportSession( sampleRateCombo->currentText().toInt(),
+											sampleDepthCombo->currentText().toInt()) ) {
+		QMessageBox::critical( this, "Hydrogen", tr( "Unable to export song" ) );
+		return;
 	}
-	
-	return uniqueInstrumentName;
+	m_pHydrogen->startExportSong( filename, stems );
 }
 
-void ExportSongDialog::exportTracks()
+bool ExportSongDialog::confirmOverwriteStems( const std::vector<DiskWriterDriver::Stem>& stems )
 {
-	std::shared_ptr<Song> pSong = m_pHydrogen->getSong();
-	InstrumentList *pInstrumentList = pSong->getInstrumentList();
-	
-	if( m_nInstrument < pInstrumentList->size() ){
-		
-		//if a instrument contains no notes we jump to the next instrument
-		bool bInstrumentHasNotes = currentInstrumentHasNotes();
-
-		if( !bInstrumentHasNotes ){
-			if( m_nInstrument == pInstrumentList->size() -1 ){
-				m_bExportTrackouts = false;
-				m_nInstrument = 0;
-				return;
-			} else {
-				m_nInstrument++;
-				exportTracks();
-				return;
-			}
-		}
-
-		QStringList filenameList =  exportNameTxt->text().split( m_sExtension );
-
-		QString firstItem;
-		if( !filenameList.isEmpty() ){
-			firstItem = filenameList.first();
-		}
-		QString newItem = firstItem + "-" + findUniqueExportFilenameForInstrument( pInstrumentList->get( m_nInstrument ) );
-
-		QString filename = newItem.append( m_sExtension );
-
-		if ( QFile( filename ).exists() == true && m_bQfileDialog == false && !m_bOverwriteFiles) {
-			int res = QMessageBox::information( this, "Hydrogen", tr( "The file %1 exists. \nOverwrite the existing file?").arg(filename), QMessageBox::Yes | QMessageBox::No | QMessageBox::YesToAll );
-			if (res == QMessageBox::No ) return;
+	for ( const auto& stem : stems ) {
+		if ( QFile( stem.sFilename ).exists() == true && m_bQfileDialog == false && !m_bOverwriteFiles) {
+			int res = QMessageBox::information( this, "Hydrogen", tr( "The file %1 exists. \nOverwrite the existing file?").arg(stem.sFilename), QMessageBox::Yes | QMessageBox::No | QMessageBox::YesToAll );
+			if (res == QMessageBox::No ) return false;
 			if (res == QMessageBox::YesToAll ) m_bOverwriteFiles = true;
 		}
-		
-		if( m_nInstrument > 0 ){
-			m_pHydrogen->stopExportSong();
-			m_bExporting = false;
-		}
-		
-		for (auto i = 0; i < pInstrumentList->size(); i++) {
-			pInstrumentList->get(i)->set_currently_exported( false );
-		}
-		
-		pSong->getInstrumentList()->get(m_nInstrument)->set_currently_exported( true );
-		
-		m_pHydrogen->startExportSong( filename );
-
-		if(! (m_nInstrument == pInstrumentList->size()) ){
-			m_nInstrument++;
-		}
 	}
-    
+
+	return true;
 }
 
 void ExportSongDialog::closeEvent( QCloseEvent *event ) {
@@ -649,15 +558,6 @@ void ExportSongDialog::progressEvent( int nValue )
 	if ( nValue == 100 ) {
 
 		m_bExporting = false;
-
-		if( m_nInstrument == Hydrogen::get_instance()->getSong()->getInstrumentList()->size()){
-			m_nInstrument = 0;
-			m_bExportTrackouts = false;
-		}
-
-		if( m_bExportTrackouts ){
-			exportTracks();
-		}
 	}
 
 	if ( nValue < 100 ) {
@@ -25,10 +25,12 @@
 #define EXPORT_SONG_DIALOG_H
 
 #include <memory>
+#include <vector>
 
 #include "ui_ExportSongDialog_UI.h"
 #include "EventListener.h"
 #include <core/Object.h>
+#include <core/IO/DiskWriterDriver.h>
 #include <core/Sampler/Sampler.h>
 
 using InterpolateMode = H2Core::Interpolation::InterpolateMode;
@@ -74,19 +76,18 @@ private:
 	void		saveSettingsToPreferences();
 	void		restoreSettingsFromPreferences();
 	
-	bool		currentInstrumentHasNotes();
-	QString		findUniqueExportFilenameForInstrument( std::shared_ptr<H2Core::Instrument> pInstrument );
-
-	void		exportTracks();
+	/** Asks the user whether existing files of @a stems should be
+	 * overwritten.
+	 *
+	 * \return false if the export was canceled.*/
+	bool		confirmOverwriteStems( const std::vector<H2Core::DiskWriterDriver::Stem>& stems );
 	bool 		validateUserInput();
 	QString		createDefaultFilename();
 
 	void		closeExport();
 	
 	bool					m_bExporting;
-	bool					m_bExportTrackouts;
 	bool					m_bOverwriteFiles;
-	uint					m_nInstrument;
 	QString					m_sExtension;
 	bool					m_bOldRubberbandBatchMode;
 	bool					m_bOldTimeLineBPMMode;
@@ -0,0 +1,139 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include "GuiBenchmark.h"
+#include "HydrogenApp.h"
+#include "SongEditor/SongEditor.h"
+#include "SongEditor/SongEditorPanel.h"
+
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Song.h>
+#include <core/CoreActionController.h>
+#include <core/Hydrogen.h>
+#include <core/Preferences/Preferences.h>
+
+#include <QtGui>
+#include <QtWidgets>
+
+using namespace H2Core;
+
+std::shared_ptr<Song> GuiBenchmark::createSong( int nColumns )
+{
+	auto pSong = Song::getEmptySong();
+
+	auto pPatternList = pSong->getPatternList();
+	for ( int ii = pPatternList->size(); ii < nPatterns; ++ii ) {
+		pPatternList->add( new Pattern( QString( "synthetic %1" ).arg( ii ),
+										"", "benchmark", 192, 4 ) );
+	}
+
+	// A couple of diagonal bands across the whole arrangement. Some
+	// patterns are shorter to get cells of varying width.
+	auto pColumns = pSong->getPatternGroupVector();
+	for ( auto pColumn : *pColumns ) {
+		pColumn->clear();
+		delete pColumn;
+	}
+	pColumns->clear();
+	for ( int nColumn = 0; nColumn < nColumns; ++nColumn ) {
+		auto pColumn = new PatternList();
+		for ( int nn = 0; nn < nPatternsPerColumn; ++nn ) {
+			pColumn->add( pPatternList->get( ( nColumn + nn * nPatterns / nPatternsPerColumn ) %
+											 nPatterns ) );
+		}
+		pColumns->push_back( pColumn );
+	}
+	for ( int ii = 0; ii < nPatterns; ii += 3 ) {
+		pPatternList->get( ii )->set_length( 96 );
+	}
+
+	return pSong;
+}
+
+void GuiBenchmark::songEditorBenchmark()
+{
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pHydrogenApp = HydrogenApp::get_instance();
+	auto pSongEditorPanel = pHydrogenApp->getSongEditorPanel();
+	auto pSongEditor = pSongEditorPanel->getSongEditor();
+	auto pScrollArea = pSongEditorPanel->getEditorScrollView();
+
+	if ( ! pSongEditor->isVisible() ) {
+		___ERRORLOG( "SongEditor is not visible. Skipping benchmark." );
+		return;
+	}
+
+	const int nColumns = Preferences::get_instance()->getMaxBars();
+	pHydrogen->getCoreActionController()->setSong( createSong( nColumns ) );
+	// Deliver the song change to the GUI right away.
+	pHydrogenApp->onEventQueueTimer();
+
+	QElapsedTimer timer;
+	timer.start();
+	pScrollArea->viewport()->repaint();
+	const double fInitial = timer.nsecsElapsed() / 1e6;
+
+	// Scroll diagonally through the whole arrangement.
+	auto pHScrollBar = pScrollArea->horizontalScrollBar();
+	auto pVScrollBar = pScrollArea->verticalScrollBar();
+	timer.restart();
+	for ( int ii = 0; ii <= nScrollSteps; ++ii ) {
+		pHScrollBar->setValue( pHScrollBar->maximum() * ii / nScrollSteps );
+		pVScrollBar->setValue( pVScrollBar->maximum() * ii / nScrollSteps );
+		pScrollArea->viewport()->repaint();
+	}
+	const double fScroll = timer.nsecsElapsed() / 1e6 / ( nScrollSteps + 1 );
+
+	// Toggle cells within the visible part of the grid. Each of them
+	// is toggled twice in order to restore the arrangement.
+	pHScrollBar->setValue( pHScrollBar->maximum() / 2 );
+	pVScrollBar->setValue( pVScrollBar->maximum() / 2 );
+	pScrollArea->viewport()->repaint();
+	const QPoint origin( pHScrollBar->value() / pSongEditor->getGridWidth(),
+						 pVScrollBar->value() / pSongEditor->getGridHeight() );
+	timer.restart();
+	for ( int ii = 0; ii < nEdits; ++ii ) {
+		const int nCell = ii / 2;
+		pHydrogen->getCoreActionController()->toggleGridCell( origin.x() + nCell % 16,
+															  origin.y() + nCell / 16 );
+		pHydrogenApp->onEventQueueTimer();
+		pScrollArea->viewport()->repaint();
+	}
+	const double fEdit = timer.nsecsElapsed() / 1e6 / nEdits;
+
+	qDebug() << "\n=== SongEditor benchmark ===";
+	qDebug() << QString( "%1 patterns x %2 columns, viewport %3x%4" )
+		.arg( nPatterns ).arg( nColumns )
+		.arg( pScrollArea->viewport()->width() ).arg( pScrollArea->viewport()->height() );
+	qDebug() << QString( "Initial paint:      %1 ms" ).arg( fInitial, 0, 'f', 2 );
+	qDebug() << QString( "Scroll and repaint: %1 ms" ).arg( fScroll, 0, 'f', 2 );
+	qDebug() << QString( "Toggle and repaint: %1 ms" ).arg( fEdit, 0, 'f', 2 );
+}
+
+void GuiBenchmark::run()
+{
+	songEditorBenchmark();
+
+	// Quit without being asked to save the synthetic song.
+	Hydrogen::get_instance()->setIsModified( false );
+	QTimer::singleShot( 1, QApplication::instance(), &QApplication::closeAllWindows );
+}
@@ -0,0 +1,55 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#ifndef GUI_BENCHMARK_H
+#define GUI_BENCHMARK_H
+
+#include <memory>
+
+namespace H2Core {
+	class Song;
+}
+
+/// GUI benchmark
+///
+/// Replaces the current song by a synthetic one holding a large arrangement, measures the time
+/// required to repaint the SongEditor while scrolling through it and while toggling cells, prints the
+/// results, and quits Hydrogen. Enabled using the \e --benchmark option.
+///
+/** \ingroup docGUI*/
+class GuiBenchmark {
+public:
+	/// Runs all benchmarks. Has to be called from within the event loop once the GUI is set up.
+	static void run();
+
+private:
+	/// Number of patterns in the synthetic song.
+	static constexpr int nPatterns = 300;
+	/// Number of patterns active in each column.
+	static constexpr int nPatternsPerColumn = 12;
+	static constexpr int nScrollSteps = 200;
+	static constexpr int nEdits = 200;
+
+	static std::shared_ptr<H2Core::Song> createSong( int nColumns );
+	static void songEditorBenchmark();
+};
+
+#endif
@@ -87,6 +87,9 @@ HydrogenApp::HydrogenApp( MainForm *pMainForm )
 	m_pEventQueueTimer = new QTimer(this);
 	connect( m_pEventQueueTimer, SIGNAL( timeout() ), this, SLOT( onEventQueueTimer() ) );
 	m_pEventQueueTimer->start( QUEUE_TIMER_PERIOD );
+	// The GUI only needs to know whether a note-on, metronome, or
+	// MIDI event occurred since the last drain of the queue.
+	EventQueue::get_instance()->setCoalescing( true );
 
 	// Wait for m_nPreferenceUpdateTimeout milliseconds of no update
 	// signal before propagating the update. Else importing/reseting a
@@ -593,6 +596,11 @@ void HydrogenApp::XRunEvent() {
 						 5000 );
 }
 
+void HydrogenApp::notePoolExhaustedEvent( int nCapacity ) {
+	setStatusBarMessage( tr( "Note pool [%1] exhausted. Notes were dropped!" )
+						 .arg( nCapacity ), 5000 );
+}
+
 void HydrogenApp::updateWindowTitle()
 {
 	auto pSong = Hydrogen::get_instance()->getSong();
@@ -700,6 +708,12 @@ void HydrogenApp::drumkitLoadedEvent(){
 						 .arg( Hydrogen::get_instance()->getCurrentDrumkitName() ), 2000 );
 }
 
+void HydrogenApp::drumkitLoadingProgressEvent( int nProgress ){
+	if ( nProgress < 100 ) {
+		setStatusBarMessage( tr( "Loading drumkit [%1%]" ).arg( nProgress ), 2000 );
+	}
+}
+
 void HydrogenApp::songModifiedEvent()
 {
 	updateWindowTitle();
@@ -861,6 +875,14 @@ void HydrogenApp::onEventQueueTimer()
 				pListener->playbackTrackChangedEvent();
 				break;
 
+			case EVENT_NOTE_POOL_EXHAUSTED:
+				pListener->notePoolExhaustedEvent( event.value );
+				break;
+
+			case EVENT_DRUMKIT_LOADING_PROGRESS:
+				pListener->drumkitLoadingProgressEvent( event.value );
+				break;
+
 			default:
 				ERRORLOG( QString("[onEventQueueTimer] Unhandled event: %1").arg( event.type ) );
 			}
@@ -195,6 +195,10 @@ signals:
 		     EventListener::errorEvent()
 		 * - H2Core::EVENT_XRUN -> 
 		     EventListener::XRunEvent()
+		 * - H2Core::EVENT_NOTE_POOL_EXHAUSTED -> 
+		     EventListener::notePoolExhaustedEvent()
+		 * - H2Core::EVENT_DRUMKIT_LOADING_PROGRESS -> 
+		     EventListener::drumkitLoadingProgressEvent()
 		 * - H2Core::EVENT_METRONOME -> 
 		     EventListener::metronomeEvent()
 		 * - H2Core::EVENT_PROGRESS -> 
@@ -267,6 +271,7 @@ private slots:
 		void setupSinglePanedInterface();
 		virtual void songModifiedEvent() override;
 	virtual void XRunEvent() override;
+	virtual void notePoolExhaustedEvent( int nCapacity ) override;
 
 		/** Handles the loading and saving of the H2Core::Preferences
 		 * from the core part of H2Core::Hydrogen.
@@ -298,6 +303,7 @@ private slots:
 		 */
 		virtual void updateSongEvent( int nValue ) override;
 	virtual void drumkitLoadedEvent() override;
+	virtual void drumkitLoadingProgressEvent( int nProgress ) override;
 	
 };
 
@@ -1079,6 +1079,7 @@ void InstrumentEditor::setAutoVelocity()
 			++nLayer;
 		}
 	}
+	pCompo->updateLayerSelection();
 }
 
 void InstrumentEditor::labelCompoClicked( ClickableLabel* pRef )
@@ -326,9 +326,13 @@ void LayerPreview::mousePressEvent(QMouseEvent *ev)
 	if ( ev->y() < 20 ) {
 		float fVelocity = (float)ev->x() / (float)width();
 
-		Note * pNote = new Note( m_pInstrument, nPosition, fVelocity, fPan, nLength, fPitch );
-		pNote->set_specific_compo_id( m_nSelectedComponent );
-		Hydrogen::get_instance()->getAudioEngine()->getSampler()->noteOn(pNote);
+		auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
+		Note * pNote = pAudioEngine->getNotePool()->
+			create( m_pInstrument, nPosition, fVelocity, fPan, nLength, fPitch );
+		if ( pNote != nullptr ) {
+			pNote->set_specific_compo_id( m_nSelectedComponent );
+			pAudioEngine->getSampler()->noteOn(pNote);
+		}
 		
 		for ( int i = 0; i < InstrumentComponent::getMaxLayers(); i++ ) {
 			auto pCompo = m_pInstrument->get_component(m_nSelectedComponent);
@@ -357,9 +361,13 @@ void LayerPreview::mousePressEvent(QMouseEvent *ev)
 		if(pCompo) {
 			auto pLayer = pCompo->get_layer( m_nSelectedLayer );
 			if ( pLayer ) {
-				Note *note = new Note( m_pInstrument , nPosition, m_pInstrument->get_component(m_nSelectedComponent)->get_layer( m_nSelectedLayer )->get_end_velocity() - 0.01, fPan, nLength, fPitch );
-				note->set_specific_compo_id( m_nSelectedComponent );
-				Hydrogen::get_instance()->getAudioEngine()->getSampler()->noteOn(note);
+				auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
+				Note *note = pAudioEngine->getNotePool()->
+					create( m_pInstrument , nPosition, m_pInstrument->get_component(m_nSelectedComponent)->get_layer( m_nSelectedLayer )->get_end_velocity() - 0.01, fPan, nLength, fPitch );
+				if ( note != nullptr ) {
+					note->set_specific_compo_id( m_nSelectedComponent );
+					pAudioEngine->getSampler()->noteOn(note);
+				}
 				
 				int x1 = (int)( pLayer->get_start_velocity() * width() );
 				int x2 = (int)( pLayer->get_end_velocity() * width() );
@@ -426,6 +434,11 @@ void LayerPreview::mouseMoveEvent( QMouseEvent *ev )
 				}
 
 				if ( bChanged ) {
+					auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
+					pAudioEngine->lock( RIGHT_HERE );
+					m_pInstrument->get_component( m_nSelectedComponent )->updateLayerSelection();
+					pAudioEngine->unlock();
+
 					update();
 					Hydrogen::get_instance()->setIsModified( true );
 				}
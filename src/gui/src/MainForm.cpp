@@ -26,6 +26,7 @@
 #include <core/AudioEngine/AudioEngine.h>
 #include <core/Smf/SMF.h>
 #include <core/Timeline.h>
+#include <core/Helpers/DrumkitIndex.h>
 #include <core/Helpers/Files.h>
 #include <core/Basics/Pattern.h>
 #include <core/Basics/PatternList.h>
@@ -1276,44 +1277,11 @@ void MainForm::action_instruments_saveLibrary()
 	Filesystem::Lookup lookup = Hydrogen::get_instance()->getCurrentDrumkitLookup();
 	Drumkit *pDrumkitInfo = nullptr;
 
-	if ( lookup == Filesystem::Lookup::system ||
-		 lookup == Filesystem::Lookup::stacked ) {
-		// System drumkit list
-		QStringList sys_dks = Filesystem::sys_drumkit_list();
-		for (int i = 0; i < sys_dks.size(); ++i) {
-			QString absPath = Filesystem::sys_drumkits_dir() + sys_dks[i];
-			Drumkit *pInfo = Drumkit::load( absPath, false );
-			if (pInfo) {
-				if ( QString( pInfo->get_name() ) == sDrumkitName ){
-					pDrumkitInfo = pInfo;
-					break;
-				}
-			}
-		
-			// Since Drumkit::load() calls New Drumkit() internally, we
-			// have to take care of destroying it manually.
-			delete pInfo;
-		}
-	}
-
-	if ( lookup == Filesystem::Lookup::user ||
-		 lookup == Filesystem::Lookup::stacked ) {
-		//User drumkit list
-		QStringList usr_dks = Filesystem::usr_drumkit_list();
-		for (int i = 0; i < usr_dks.size(); ++i) {
-			QString absPath = Filesystem::usr_drumkits_dir() + usr_dks[i];
-			Drumkit *pInfo = Drumkit::load( absPath, false );
-			if (pInfo) {
-				if ( QString(pInfo->get_name() ) == sDrumkitName ){
-					pDrumkitInfo = pInfo;
-					break;
-				}
-			}
-		
-			// Since Drumkit::load() calls New Drumkit() internally, we
-			// have to take care of destroying it manually.
-			delete pInfo;
-		}
+	// Use the metadata index to find the folder of the drumkit
+	// instead of parsing all installed ones.
+	DrumkitIndex::Entry drumkit;
+	if ( DrumkitIndex::get_instance()->findDrumkit( sDrumkitName, lookup, &drumkit ) ) {
+		pDrumkitInfo = Drumkit::load( drumkit.sPath, false );
 	}
 	
 	if ( pDrumkitInfo != nullptr ){
@@ -1335,8 +1303,6 @@ void MainForm::action_instruments_saveLibrary()
 
 	HydrogenApp::get_instance()->getInstrumentRack()->getSoundLibraryPanel()->updateDrumkitList();
 
-	// Cleaning up the last pInfo we did not deleted due to the break
-	// statement.
 	delete pDrumkitInfo;
 }
 
@@ -2002,6 +1968,10 @@ void MainForm::errorEvent( int nErrorCode )
 		msg = tr( "Playback track couldn't be read" );
 		break;
 
+	case Hydrogen::EXPORT_CANNOT_OPEN_FILE:
+		msg = tr( "Export file couldn't be opened" );
+		break;
+
 	default:
 		msg = QString( tr( "Unknown error %1" ) ).arg( nErrorCode );
 	}
@@ -2017,7 +1987,13 @@ void MainForm::playlistLoadSongEvent (int nIndex)
 		return;
 	}
 	
-	HydrogenApp::get_instance()->openSong( songFilename );
+	// Songs already loaded in the background are just swapped in.
+	auto pSong = pPlaylist->getPrefetchedSong( nIndex );
+	if ( pSong != nullptr ) {
+		HydrogenApp::get_instance()->openSong( pSong );
+	} else {
+		HydrogenApp::get_instance()->openSong( songFilename );
+	}
 	
 	pPlaylist->activateSong( nIndex );
 
@@ -2339,44 +2315,9 @@ void MainForm::action_banks_properties()
 	Filesystem::Lookup lookup = Hydrogen::get_instance()->getCurrentDrumkitLookup();
 	Drumkit *pDrumkitInfo = nullptr;
 
-	if ( lookup == Filesystem::Lookup::system ||
-		 lookup == Filesystem::Lookup::stacked ) {
-		//System drumkit list
-		QStringList sys_dks = Filesystem::sys_drumkit_list();
-		for (int i = 0; i < sys_dks.size(); ++i) {
-			QString absPath = Filesystem::sys_drumkits_dir() + sys_dks[i];
-			Drumkit *pInfo = Drumkit::load( absPath );
-			if (pInfo) {
-				if ( QString( pInfo->get_name() ) == sDrumkitName ){
-					pDrumkitInfo = pInfo;
-					break;
-				}
-			}
-		
-			// Since Drumkit::load() calls New Drumkit() internally, we
-			// have to take care of destroying it manually.
-			delete pInfo;
-		}
-	}
-	
-	if ( lookup == Filesystem::Lookup::user ||
-		 lookup == Filesystem::Lookup::stacked ) {
-		//User drumkit list
-		QStringList usr_dks = Filesystem::usr_drumkit_list();
-		for (int i = 0; i < usr_dks.size(); ++i) {
-			QString absPath = Filesystem::usr_drumkits_dir() + usr_dks[i];
-			Drumkit *pInfo = Drumkit::load( absPath );
-			if (pInfo) {
-				if ( QString(pInfo->get_name() ) == sDrumkitName ){
-					pDrumkitInfo = pInfo;
-					break;
-				}
-			}
-		
-			// Since Drumkit::load() calls New Drumkit() internally, we
-			// have to take care of destroying it manually.
-			delete pInfo;
-		}
+	DrumkitIndex::Entry drumkit;
+	if ( DrumkitIndex::get_instance()->findDrumkit( sDrumkitName, lookup, &drumkit ) ) {
+		pDrumkitInfo = Drumkit::load( drumkit.sPath, false );
 	}
 
 	if( pDrumkitInfo ) {
@@ -2387,8 +2328,6 @@ void MainForm::action_banks_properties()
 		QMessageBox::warning( this, "Hydrogen", sMessage.append( QString( " [%1]").arg( sDrumkitName ) ) );
 	}
 
-	// Cleaning up the last pInfo we did not deleted due to the break
-	// statement.
 	delete pDrumkitInfo;
 }
 
@@ -48,6 +48,7 @@
 #include <math.h>
 #include <cassert>
 #include <algorithm>
+#include <functional>
 #include <stack>
 
 using namespace H2Core;
@@ -105,6 +106,7 @@ void DrumPatternEditor::updateEditor( bool bPatternOnly )
 
 	// redraw all
 	createBackground();
+	updateNoteLayers();
 	update( 0, 0, width(), height() );
 }
 
@@ -407,7 +409,7 @@ void DrumPatternEditor::addOrDeleteNoteAction(	int nColumn,
 					  && pNote->get_octave() == oldOctaveKeyVal
 					  && pNote->get_velocity() == oldVelocity
 					  && pNote->get_probability() == fProbability ) ) {
-				notes->erase( it );
+				pPattern->remove_note( pNote );
 				delete pNote;
 				bFound = true;
 				break;
@@ -453,8 +455,11 @@ void DrumPatternEditor::addOrDeleteNoteAction(	int nColumn,
 		// hear note
 		if ( listen && !isNoteOff ) {
 			fPitch = pSelectedInstrument->get_pitch_offset();
-			Note *pNote2 = new Note( pSelectedInstrument, 0, fVelocity, fPan, nLength, fPitch);
-			m_pAudioEngine->getSampler()->noteOn(pNote2);
+			Note *pNote2 = m_pAudioEngine->getNotePool()->
+				create( pSelectedInstrument, 0, fVelocity, fPan, nLength, fPitch);
+			if ( pNote2 != nullptr ) {
+				m_pAudioEngine->getSampler()->noteOn(pNote2);
+			}
 		}
 	}
 	pHydrogen->setIsModified( true );
@@ -1041,107 +1046,104 @@ void DrumPatternEditor::paste()
 
 
 ///
-/// Draws a pattern
+/// Draws the notes of a single pattern into its note layer
 ///
-void DrumPatternEditor::drawPattern(QPainter& painter)
+void DrumPatternEditor::drawPatternNotes( QPainter& painter, Pattern* pPattern, bool bIsForeground )
 {
 	auto pPref = H2Core::Preferences::get_instance();
 
 	std::shared_ptr<Song> pSong = Hydrogen::get_instance()->getSong();
 	InstrumentList * pInstrList = pSong->getInstrumentList();
 
-	/*
-		BUGFIX
-
-		if m_pPattern is not renewed every time we draw a note,
-		hydrogen will crash after you save a song and create a new one.
-		-smoors
-	*/
-	updatePatternInfo();
-	validateSelection();
-
-
-	for ( Pattern *pPattern : getPatternsToShow() ) {
-		const Pattern::notes_t *pNotes = pPattern->get_notes();
-		if ( pNotes->size() == 0 ) {
-			continue;
-		}
-		bool bIsForeground = ( pPattern == m_pPattern );
+	const Pattern::notes_t *pNotes = pPattern->get_notes();
+	if ( pNotes->size() == 0 ) {
+		return;
+	}
 
-		std::vector< int > noteCount; // instrument_id -> count
-		std::stack<std::shared_ptr<Instrument>> instruments;
+	const QFont font( pPref->getApplicationFontFamily(), getPointSize( pPref->getFontSize() ) );
 
-		// Process notes in batches by note position, counting the notes at each instrument so we can display
-		// markers for instruments which have more than one note in the same position (a chord or genuine
-		// duplicates)
-		for ( auto posIt = pNotes->begin(); posIt != pNotes->end(); ) {
-			int nPosition = posIt->second->get_position();
+	std::vector< int > noteCount; // instrument_id -> count
+	std::stack<std::shared_ptr<Instrument>> instruments;
 
-			// Process all notes at this position
-			auto noteIt = posIt;
-			while ( noteIt != pNotes->end() && noteIt->second->get_position() == nPosition ) {
-				Note *pNote = noteIt->second;
+	// Process notes in batches by note position, counting the notes at each instrument so we can display
+	// markers for instruments which have more than one note in the same position (a chord or genuine
+	// duplicates)
+	for ( auto posIt = pNotes->begin(); posIt != pNotes->end(); ) {
+		int nPosition = posIt->second->get_position();
 
-				int nInstrumentID = pNote->get_instrument_id();
-				if ( nInstrumentID >= noteCount.size() ) {
-					noteCount.resize( nInstrumentID+1, 0 );
-				}
+		// Process all notes at this position
+		auto noteIt = posIt;
+		while ( noteIt != pNotes->end() && noteIt->second->get_position() == nPosition ) {
+			Note *pNote = noteIt->second;
 
-				if ( ++noteCount[ nInstrumentID ] == 1) {
-					instruments.push( pNote->get_instrument() );
-				}
+			int nInstrumentID = pNote->get_instrument_id();
+			if ( nInstrumentID >= noteCount.size() ) {
+				noteCount.resize( nInstrumentID+1, 0 );
+			}
 
-				drawNote( pNote, painter, bIsForeground );
-				++noteIt;
+			if ( ++noteCount[ nInstrumentID ] == 1) {
+				instruments.push( pNote->get_instrument() );
 			}
 
-			// Go through used instruments list, drawing markers for superimposed notes and zero'ing the
-			// counts.
-			while ( ! instruments.empty() ) {
-				auto pInstrument = instruments.top();
-				int nInstrumentID = pInstrument->get_id();
-				if ( noteCount[ nInstrumentID ] >  1 ) {
-					// Draw "2x" text to the left of the note
-					int nInstrument = pInstrList->index( pInstrument );
-					int x = PatternEditor::nMargin + (nPosition * m_fGridWidth);
-					int y = ( nInstrument * m_nGridHeight);
-					const int boxWidth = 128;
-
-					QFont font( pPref->getApplicationFontFamily(), getPointSize( pPref->getFontSize() ) );
-					painter.setFont( font );
-					painter.setPen( QColor( 0, 0, 0 ) );
-
-					painter.drawText( QRect( x-boxWidth-6, y, boxWidth, m_nGridHeight),
-									  Qt::AlignRight | Qt::AlignVCenter,
-									  ( QString( "%1" ) + QChar( 0x00d7 )).arg( noteCount[ nInstrumentID ] ) );
-				}
-				noteCount[ nInstrumentID ] = 0;
-				instruments.pop();
+			const QPoint pos = getNotePosition( pNote );
+			if ( pos.x() < 0 ) {
+				ERRORLOG( "Instrument not found..skipping note" );
+			} else {
+				drawNoteSymbol( painter, pos, pNote, bIsForeground, false );
 			}
+			++noteIt;
+		}
 
-			posIt = noteIt;
+		// Go through used instruments list, drawing markers for superimposed notes and zero'ing the
+		// counts.
+		while ( ! instruments.empty() ) {
+			auto pInstrument = instruments.top();
+			int nInstrumentID = pInstrument->get_id();
+			if ( noteCount[ nInstrumentID ] >  1 ) {
+				// Draw "2x" text to the left of the note
+				int nInstrument = pInstrList->index( pInstrument );
+				int x = PatternEditor::nMargin + (nPosition * m_fGridWidth);
+				int y = ( nInstrument * m_nGridHeight);
+				const int boxWidth = 128;
+
+				painter.setFont( font );
+				painter.setPen( QColor( 0, 0, 0 ) );
+
+				painter.drawText( QRect( x-boxWidth-6, y, boxWidth, m_nGridHeight),
+								  Qt::AlignRight | Qt::AlignVCenter,
+								  ( QString( "%1" ) + QChar( 0x00d7 )).arg( noteCount[ nInstrumentID ] ) );
+			}
+			noteCount[ nInstrumentID ] = 0;
+			instruments.pop();
 		}
+
+		posIt = noteIt;
 	}
 }
 
-
-
-///
-/// Draws a note
-///
-void DrumPatternEditor::drawNote( Note *note, QPainter& p, bool bIsForeground )
+QPoint DrumPatternEditor::getNotePosition( Note* pNote ) const
 {
 	InstrumentList *pInstrList = Hydrogen::get_instance()->getSong()->getInstrumentList();
-	int nInstrument = pInstrList->index( note->get_instrument() );
+	int nInstrument = pInstrList->index( pNote->get_instrument() );
 	if ( nInstrument == -1 ) {
-		ERRORLOG( "Instrument not found..skipping note" );
-		return;
+		return QPoint( -1, -1 );
 	}
 
-	QPoint pos ( PatternEditor::nMargin + note->get_position() * m_fGridWidth,
-				 ( nInstrument * m_nGridHeight) + (m_nGridHeight / 2) - 3 );
+	return QPoint( PatternEditor::nMargin + pNote->get_position() * m_fGridWidth,
+				   ( nInstrument * m_nGridHeight) + (m_nGridHeight / 2) - 3 );
+}
+
+size_t DrumPatternEditor::getLayoutFingerprint() const
+{
+	size_t nFingerprint = PatternEditor::getLayoutFingerprint();
 
-	drawNoteSymbol( p, pos, note, bIsForeground );
+	// Notes are placed in the row of their instrument.
+	InstrumentList *pInstrList = Hydrogen::get_instance()->getSong()->getInstrumentList();
+	for ( int ii = 0; ii < pInstrList->size(); ++ii ) {
+		hashCombine( nFingerprint, std::hash<Instrument*>()( pInstrList->get( ii ).get() ) );
+	}
+
+	return nFingerprint;
 }
 
 void DrumPatternEditor::drawBackground( QPainter& p)
@@ -1252,8 +1254,6 @@ void DrumPatternEditor::createBackground() {
 	QPainter painter( m_pBackgroundPixmap );
 
 	drawBackground( painter );
-	
-	drawPattern( painter );
 }
 
 void DrumPatternEditor::paintEvent( QPaintEvent* ev )
@@ -1267,13 +1267,11 @@ void DrumPatternEditor::paintEvent( QPaintEvent* ev )
 	qreal pixelRatio = devicePixelRatio();
 	if ( pixelRatio != m_pBackgroundPixmap->devicePixelRatio() ) {
 		createBackground();
+		updateNoteLayers();
 	}
 	
 	QPainter painter( this );
-	painter.drawPixmap( ev->rect(), *m_pBackgroundPixmap, QRectF( pixelRatio * ev->rect().x(),
-															pixelRatio * ev->rect().y(),
-															pixelRatio * ev->rect().width(),
-															pixelRatio * ev->rect().height() ) );
+	drawNoteLayers( painter, ev->rect() );
 
 	// Draw playhead
 	if ( m_nTick != -1 ) {
@@ -1421,6 +1419,7 @@ void DrumPatternEditor::onPreferencesChanged( H2Core::Preferences::Changes chang
 {
 	if ( changes & ( H2Core::Preferences::Changes::Colors |
 					 H2Core::Preferences::Changes::Font ) ) {
+		invalidateNoteLayers();
 		updateEditor();
 	}
 }
@@ -1495,7 +1494,7 @@ void DrumPatternEditor::functionPasteNotesUndoAction(std::list<H2Core::Pattern*>
 					Note *pFoundNote = it->second;
 					if (pFoundNote->get_instrument() == pNote->get_instrument())
 					{
-						notes->erase(it);
+						pat->remove_note(pFoundNote);
 						delete pFoundNote;
 						break;
 					}
@@ -1600,7 +1599,7 @@ void DrumPatternEditor::functionFillNotesUndoAction( QStringList noteList, int n
 			assert( pNote );
 			if ( pNote->get_instrument() == pSelectedInstrument ) {
 				// the note exists...remove it!
-				notes->erase( it );
+				pPattern->remove_note( pNote );
 				delete pNote;
 				break;
 			}
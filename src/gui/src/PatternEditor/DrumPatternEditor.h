@@ -125,6 +125,11 @@ class DrumPatternEditor : public PatternEditor, protected WidgetWithScalableFont
 
 		virtual QRect getKeyboardCursorRect() override;
 
+		//! Selected notes are drawn on top of the cached note layers.
+		virtual void updateWidget() override {
+			update();
+		}
+
 	public slots:
 		virtual void updateEditor( bool bPatternOnly = false ) override;
 		virtual void selectAll() override;
@@ -134,8 +139,11 @@ class DrumPatternEditor : public PatternEditor, protected WidgetWithScalableFont
 
 	private:
 	void createBackground() override;
-		void drawNote( H2Core::Note* note, QPainter& painter, bool bIsForeground = true );
-		void drawPattern( QPainter& painter );
+		virtual QPoint getNotePosition( H2Core::Note* pNote ) const override;
+		virtual void drawPatternNotes( QPainter& painter, H2Core::Pattern* pPattern,
+									   bool bIsForeground ) override;
+		//! Includes the order of the instruments.
+		virtual size_t getLayoutFingerprint() const override;
 		void drawBackground( QPainter& pointer );
 		void drawFocus( QPainter& painter );
 
@@ -44,6 +44,8 @@
 #include "PatternEditorPanel.h"
 #include "UndoActions.h"
 
+#include <functional>
+
 
 using namespace std;
 using namespace H2Core;
@@ -100,6 +102,7 @@ void PatternEditor::onPreferencesChanged( H2Core::Preferences::Changes changes )
 {
 	if ( changes & H2Core::Preferences::Changes::Colors ) {
 		
+		invalidateNoteLayers();
 		update( 0, 0, width(), height() );
 		m_pPatternEditorPanel->updateEditors();
 	}
@@ -187,7 +190,8 @@ QColor PatternEditor::computeNoteColor( float fVelocity ) {
 }
 
 
-void PatternEditor::drawNoteSymbol( QPainter &p, QPoint pos, H2Core::Note *pNote, bool bIsForeground ) const
+void PatternEditor::drawNoteSymbol( QPainter &p, QPoint pos, H2Core::Note *pNote, bool bIsForeground,
+									bool bShowSelection ) const
 {
 	auto pPref = H2Core::Preferences::get_instance();
 	
@@ -203,7 +207,7 @@ void PatternEditor::drawNoteSymbol( QPainter &p, QPoint pos, H2Core::Note *pNote
 	uint w = 8, h =  8;
 	uint x_pos = pos.x(), y_pos = pos.y();
 
-	bool bSelected = m_selection.isSelected( pNote );
+	bool bSelected = bShowSelection && m_selection.isSelected( pNote );
 
 	if ( bSelected ) {
 		QPen selectedPen( selectedNoteColor() );
@@ -546,7 +550,8 @@ void PatternEditor::deselectAndOverwriteNotes( std::vector< H2Core::Note *> &sel
 				++it;
 			} else if ( pSelectedNote->match( pNote ) && pNote->get_position() == pSelectedNote->get_position() ) {
 				// Something else occupying the same position (which may or may not be an exact duplicate)
-				it = pNotes->erase( it );
+				++it;
+				m_pPattern->remove_note( pNote );
 				delete pNote;
 			} else {
 				// Any other note
@@ -825,6 +830,102 @@ void PatternEditor::focusOutEvent( QFocusEvent *ev ) {
 void PatternEditor::createBackground() {
 }
 
+void PatternEditor::updateNoteLayers() {
+	validateSelection();
+
+	const qreal pixelRatio = devicePixelRatio();
+	const size_t nLayoutFingerprint = getLayoutFingerprint();
+
+	m_layerPatterns = getPatternsToShow();
+
+	std::map< Pattern*, NoteLayer > layers;
+	for ( Pattern* pPattern : m_layerPatterns ) {
+		const bool bIsForeground = pPattern == m_pPattern;
+		size_t nFingerprint = getNotesFingerprint( pPattern );
+		hashCombine( nFingerprint, nLayoutFingerprint );
+		hashCombine( nFingerprint, bIsForeground );
+
+		auto it = m_noteLayers.find( pPattern );
+		if ( it != m_noteLayers.end() && it->second.nFingerprint == nFingerprint ) {
+			layers[ pPattern ] = it->second;
+			continue;
+		}
+
+		NoteLayer& layer = layers[ pPattern ];
+		layer.nFingerprint = nFingerprint;
+		layer.pixmap = QPixmap( width() * pixelRatio, height() * pixelRatio );
+		layer.pixmap.setDevicePixelRatio( pixelRatio );
+		layer.pixmap.fill( Qt::transparent );
+
+		QPainter painter( &layer.pixmap );
+		drawPatternNotes( painter, pPattern, bIsForeground );
+	}
+	m_noteLayers.swap( layers );
+}
+
+void PatternEditor::drawNoteLayers( QPainter& painter, const QRect& rect ) {
+	const qreal pixelRatio = devicePixelRatio();
+	const QRectF sourceRect( pixelRatio * rect.x(), pixelRatio * rect.y(),
+							 pixelRatio * rect.width(), pixelRatio * rect.height() );
+
+	painter.drawPixmap( rect, *m_pBackgroundPixmap, sourceRect );
+	for ( Pattern* pPattern : m_layerPatterns ) {
+		auto it = m_noteLayers.find( pPattern );
+		if ( it != m_noteLayers.end() ) {
+			painter.drawPixmap( rect, it->second.pixmap, sourceRect );
+		}
+	}
+
+	// The selection only refers to notes of the current pattern
+	// (see validateSelection()).
+	if ( m_pPattern == nullptr ) {
+		return;
+	}
+
+	const bool bMoving = m_selection.isMoving();
+	for ( Note* pNote : m_selection ) {
+		const QPoint pos = getNotePosition( pNote );
+		if ( pos.x() < 0 ) {
+			continue;
+		}
+		// The tail of a note can extend arbitrarily far to the right
+		// and a note being moved is drawn at its new position too.
+		if ( ! bMoving && ( pos.x() - 6 > rect.right() ||
+							pos.y() - 2 > rect.bottom() ||
+							pos.y() + 10 < rect.top() ) ) {
+			continue;
+		}
+		drawNoteSymbol( painter, pos, pNote );
+	}
+}
+
+size_t PatternEditor::getLayoutFingerprint() const {
+	size_t nFingerprint = 0;
+	hashCombine( nFingerprint, std::hash<float>()( m_fGridWidth ) );
+	hashCombine( nFingerprint, m_nGridHeight );
+	hashCombine( nFingerprint, m_nActiveWidth );
+	hashCombine( nFingerprint, width() );
+	hashCombine( nFingerprint, height() );
+	hashCombine( nFingerprint, std::hash<qreal>()( devicePixelRatio() ) );
+	return nFingerprint;
+}
+
+size_t PatternEditor::getNotesFingerprint( Pattern* pPattern ) {
+	size_t nFingerprint = pPattern->get_notes()->size();
+	FOREACH_NOTE_CST_IT_BEGIN_END( pPattern->get_notes(), it ) {
+		Note* pNote = it->second;
+		hashCombine( nFingerprint, pNote->get_position() );
+		hashCombine( nFingerprint, std::hash<Instrument*>()( pNote->get_instrument().get() ) );
+		hashCombine( nFingerprint, pNote->get_instrument_id() );
+		hashCombine( nFingerprint, std::hash<float>()( pNote->get_velocity() ) );
+		hashCombine( nFingerprint, pNote->get_length() );
+		hashCombine( nFingerprint, pNote->get_key() );
+		hashCombine( nFingerprint, pNote->get_octave() );
+		hashCombine( nFingerprint, pNote->get_note_off() );
+	}
+	return nFingerprint;
+}
+
 //! Get notes to show in pattern editor.
 //! This may include "background" notes that are in currently-playing patterns
 //! rather than the current pattern.
@@ -874,8 +975,23 @@ void PatternEditor::stackedModeActivationEvent( int nValue )
 }
 
 void PatternEditor::updatePosition( float fTick ) {
+	if ( m_nTick == static_cast<int>(fTick) ) {
+		return;
+	}
+	if ( m_nTick != -1 ) {
+		update( getPlayheadRect( m_nTick ) );
+	}
 	m_nTick = fTick;
-	update();
+	if ( m_nTick != -1 ) {
+		update( getPlayheadRect( m_nTick ) );
+	}
+}
+
+QRect PatternEditor::getPlayheadRect( int nTick ) const {
+	int nX = static_cast<int>(static_cast<float>(PatternEditor::nMargin) +
+							  static_cast<float>(nTick) * m_fGridWidth );
+	// Some slack for the width of the pen and antialiasing.
+	return QRect( nX - 2, 0, 5, height() );
 }
 
 void PatternEditor::storeNoteProperties( const Note* pNote ) {
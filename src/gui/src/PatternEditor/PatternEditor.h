@@ -28,6 +28,9 @@
 #include <core/Object.h>
 #include <core/Preferences/Preferences.h>
 
+#include <map>
+#include <vector>
+
 #include <QtGui>
 #if QT_VERSION >= 0x050000
 #  include <QtWidgets>
@@ -160,7 +163,8 @@ public:
 	static constexpr int nMargin = 20;
 
 	/** Caches the AudioEngine::m_nPatternTickPosition in the member
-		variable #m_nTick and triggeres an update(). */
+		variable #m_nTick and repaints the areas covered by the old
+		and the new playhead. */
 	void updatePosition( float fTick );
 	void editNoteLengthAction( int nColumn,
 							   int nRealColumn,
@@ -184,10 +188,10 @@ public:
 	static void triggerStatusMessage( H2Core::Note* pNote, Mode mode );
 
 	// Pitch / line conversions
-	int lineToPitch( int nLine ) {
+	int lineToPitch( int nLine ) const {
 		return 12 * (OCTAVE_MIN+m_nOctaves) - 1 - nLine;
 	}
-	int pitchToLine( int nPitch ) {
+	int pitchToLine( int nPitch ) const {
 		return 12 * (OCTAVE_MIN+m_nOctaves) - 1 - nPitch;
 	}
 
@@ -258,7 +262,12 @@ protected:
 	QColor selectedNoteColor() const;
 
 	//! Draw a note
-	void drawNoteSymbol( QPainter &p, QPoint pos, H2Core::Note *pNote, bool bIsForeground = true ) const;
+	//!
+	//! @param bShowSelection Whether to highlight the note in case
+	//!   it is selected or being moved. Notes drawn into the note
+	//!   layers are never highlighted.
+	void drawNoteSymbol( QPainter &p, QPoint pos, H2Core::Note *pNote, bool bIsForeground = true,
+						 bool bShowSelection = true ) const;
 
 	//! Get notes to show in pattern editor.
 	//! This may include "background" notes that are in currently-playing patterns
@@ -272,6 +281,57 @@ protected:
 	virtual void createBackground();
 	QPixmap *m_pBackgroundPixmap;
 
+	//! @name Note layers
+	//!
+	//! The notes of each pattern shown are rendered into a
+	//! transparent pixmap of their own on top of
+	//! #m_pBackgroundPixmap. Since notes are altered in a lot of
+	//! places without any dedicated event, a layer is not
+	//! invalidated explicitly. Instead it is redrawn whenever the
+	//! fingerprint of the properties of its notes and of the editor
+	//! layout differs from the one it was drawn with. Selected notes
+	//! are drawn on top while painting, so changing or moving the
+	//! selection does not require to redraw any layer.
+	//! @{
+	struct NoteLayer {
+		QPixmap pixmap;
+		size_t nFingerprint;
+	};
+	std::map< H2Core::Pattern*, NoteLayer > m_noteLayers;
+	//! Patterns returned by getPatternsToShow() during the last
+	//! updateNoteLayers() in the order their layers are composed.
+	std::vector< H2Core::Pattern* > m_layerPatterns;
+
+	//! Validates the selection and redraws the layers of all
+	//! patterns which changed since the last call. Layers of
+	//! patterns not shown anymore are dropped.
+	void updateNoteLayers();
+	//! Forces all layers to be redrawn, e.g. after the colors
+	//! changed.
+	void invalidateNoteLayers() {
+		m_noteLayers.clear();
+	}
+	//! Composes background, note layers, and selected notes within
+	//! @a rect.
+	void drawNoteLayers( QPainter& painter, const QRect& rect );
+	//! Draws all notes of @a pPattern shown in the editor without
+	//! highlighting the selection.
+	virtual void drawPatternNotes( QPainter& painter, H2Core::Pattern* pPattern,
+								   bool bIsForeground ) {}
+	//! \return Position of the symbol of @a pNote or (-1,-1) in case
+	//! it is not shown in the editor.
+	virtual QPoint getNotePosition( H2Core::Note* pNote ) const {
+		return QPoint( -1, -1 );
+	}
+	//! \return Fingerprint of the state of the editor affecting the
+	//! appearance of all layers.
+	virtual size_t getLayoutFingerprint() const;
+	static size_t getNotesFingerprint( H2Core::Pattern* pPattern );
+	static void hashCombine( size_t& nSeed, size_t nValue ) {
+		nSeed ^= nValue + 0x9e3779b9 + ( nSeed << 6 ) + ( nSeed >> 2 );
+	}
+	//! @}
+
 	/** Indicates whether the mouse pointer entered the widget.*/
 	bool m_bEntered;
 	virtual void enterEvent( QEvent *ev ) override;
@@ -280,6 +340,8 @@ protected:
 	virtual void focusOutEvent( QFocusEvent *ev ) override;
 
 	int m_nTick;
+	//! Area covered by the playhead at @a nTick.
+	QRect getPlayheadRect( int nTick ) const;
 		
 	unsigned m_nOctaves = 7;
 
@@ -342,8 +342,12 @@ void InstrumentLine::mousePressEvent(QMouseEvent *ev)
 		auto pInstr = pSong->getInstrumentList()->get( m_nInstrumentNumber );
 		const float fPitch = pInstr->get_pitch_offset();
 
-		Note *pNote = new Note( pInstr, 0, velocity, fPan, nLength, fPitch);
-		Hydrogen::get_instance()->getAudioEngine()->getSampler()->noteOn(pNote);
+		auto pAudioEngine = Hydrogen::get_instance()->getAudioEngine();
+		Note *pNote = pAudioEngine->getNotePool()->
+			create( pInstr, 0, velocity, fPan, nLength, fPitch);
+		if ( pNote != nullptr ) {
+			pAudioEngine->getSampler()->noteOn(pNote);
+		}
 		
 	} else if (ev->button() == Qt::RightButton ) {
 
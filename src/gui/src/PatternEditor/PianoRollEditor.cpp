@@ -26,6 +26,7 @@
 #include "PatternEditorInstrumentList.h"
 #include "UndoActions.h"
 #include <cassert>
+#include <functional>
 
 #include <core/Hydrogen.h>
 #include <core/Basics/Instrument.h>
@@ -55,8 +56,6 @@ PianoRollEditor::PianoRollEditor( QWidget *pParent, PatternEditorPanel *panel,
 
 	m_nEditorHeight = m_nOctaves * 12 * m_nGridHeight;
 
-	m_pTemp = new QPixmap( m_nEditorWidth, m_nEditorHeight );
-
 	m_nCursorPitch = 0;
 
 	resize( m_nEditorWidth, m_nEditorHeight );
@@ -122,9 +121,8 @@ void PianoRollEditor::finishUpdateEditor()
 
 	if ( m_bNeedsBackgroundUpdate ) {
 		createBackground();
-	} else {
-		drawPattern();
 	}
+	updateNoteLayers();
 	
 	//	ERRORLOG(QString("update editor %1").arg(m_nEditorWidth));
 	m_bNeedsUpdate = false;
@@ -156,17 +154,14 @@ void PianoRollEditor::paintEvent(QPaintEvent *ev)
 	qreal pixelRatio = devicePixelRatio();
 	if ( pixelRatio != m_pBackgroundPixmap->devicePixelRatio() ) {
 		createBackground();
+		updateNoteLayers();
 	}
 
 	QPainter painter( this );
 	if ( m_bNeedsUpdate ) {
 		finishUpdateEditor();
 	}
-	painter.drawPixmap( ev->rect(), *m_pTemp,
-						QRectF( pixelRatio * ev->rect().x(),
-								pixelRatio * ev->rect().y(),
-								pixelRatio * ev->rect().width(),
-								pixelRatio * ev->rect().height() ) );
+	drawNoteLayers( painter, ev->rect() );
 
 	// Draw playhead
 	if ( m_nTick != -1 ) {
@@ -253,9 +248,6 @@ void PianoRollEditor::createBackground()
 		delete m_pBackgroundPixmap;
 		m_pBackgroundPixmap = new QPixmap( width()  * pixelRatio , height() * pixelRatio );
 		m_pBackgroundPixmap->setDevicePixelRatio( pixelRatio );
-		delete m_pTemp;
-		m_pTemp = new QPixmap( width()  * pixelRatio , height() * pixelRatio );
-		m_pTemp->setDevicePixelRatio( pixelRatio );
 	}
 
 	m_pBackgroundPixmap->fill( backgroundInactiveColor );
@@ -349,52 +341,53 @@ void PianoRollEditor::createBackground()
 	}
 
 	drawGridLines( p, Qt::DashLine );
-	drawPattern();
 	
 	p.setPen( QPen( lineColor, 2, Qt::SolidLine ) );
 	p.drawLine( m_nEditorWidth, 0, m_nEditorWidth, m_nEditorHeight );
 }
 
 
-void PianoRollEditor::drawPattern()
+void PianoRollEditor::drawPatternNotes( QPainter& painter, Pattern* pPattern, bool bIsForeground )
 {
-	//INFOLOG( "draw pattern" );
+	const Pattern::notes_t* notes = pPattern->get_notes();
+	FOREACH_NOTE_CST_IT_BEGIN_END( notes, it ) {
+		Note *pNote = it->second;
+		assert( pNote );
+		const QPoint pos = getNotePosition( pNote );
+		if ( pos.x() >= 0 ) {
+			drawNoteSymbol( painter, pos, pNote, bIsForeground, false );
+		}
+	}
+}
 
-	validateSelection();
 
-	qreal pixelRatio = devicePixelRatio();
-	
-	QPainter p( m_pTemp );
-	// copy the background image
-	p.drawPixmap( rect(), *m_pBackgroundPixmap,
-						QRectF( pixelRatio * rect().x(),
-								pixelRatio * rect().y(),
-								pixelRatio * rect().width(),
-								pixelRatio * rect().height() ) );
-
-	// for each note...
-	for ( Pattern *pPattern : getPatternsToShow() ) {
-		bool bIsForeground = ( pPattern == m_pPattern );
-		const Pattern::notes_t* notes = pPattern->get_notes();
-		FOREACH_NOTE_CST_IT_BEGIN_END( notes, it ) {
-			Note *note = it->second;
-			assert( note );
-			drawNote( note, &p, bIsForeground );
-		}
+QPoint PianoRollEditor::getNotePosition( Note* pNote ) const
+{
+	Hydrogen *pHydrogen = Hydrogen::get_instance();
+	InstrumentList * pInstrList = pHydrogen->getSong()->getInstrumentList();
+	if ( pInstrList->index( pNote->get_instrument() ) != pHydrogen->getSelectedInstrumentNumber() ) {
+		return QPoint( -1, -1 );
 	}
 
+	return QPoint( PatternEditor::nMargin + pNote->get_position() * m_fGridWidth,
+				   m_nGridHeight * pitchToLine( pNote->get_notekey_pitch() ) + 1 );
 }
 
 
-void PianoRollEditor::drawNote( Note *pNote, QPainter *pPainter, bool bIsForeground )
+size_t PianoRollEditor::getLayoutFingerprint() const
 {
+	size_t nFingerprint = PatternEditor::getLayoutFingerprint();
+
 	Hydrogen *pHydrogen = Hydrogen::get_instance();
 	InstrumentList * pInstrList = pHydrogen->getSong()->getInstrumentList();
-	if ( pInstrList->index( pNote->get_instrument() ) == pHydrogen->getSelectedInstrumentNumber() ) {
-		QPoint pos ( PatternEditor::nMargin + pNote->get_position() * m_fGridWidth,
-					 m_nGridHeight * pitchToLine( pNote->get_notekey_pitch() ) + 1);
-		drawNoteSymbol( *pPainter, pos, pNote, bIsForeground );
+	const int nSelectedInstrument = pHydrogen->getSelectedInstrumentNumber();
+	hashCombine( nFingerprint, nSelectedInstrument );
+	if ( nSelectedInstrument >= 0 && nSelectedInstrument < pInstrList->size() ) {
+		hashCombine( nFingerprint, std::hash<Instrument*>()(
+						 pInstrList->get( nSelectedInstrument ).get() ) );
 	}
+
+	return nFingerprint;
 }
 
 
@@ -446,9 +439,12 @@ void PianoRollEditor::addOrRemoveNote( int nColumn, int nRealColumn, int nLine,
 		Preferences *pref = Preferences::get_instance();
 		if ( pref->getHearNewNotes() ) {
 			const float fPitch = pSelectedInstrument->get_pitch_offset();
-			Note *pNote2 = new Note( pSelectedInstrument, 0, fVelocity, fPan, nLength, fPitch );
-			pNote2->set_key_octave( notekey, octave );
-			m_pAudioEngine->getSampler()->noteOn( pNote2 );
+			Note *pNote2 = m_pAudioEngine->getNotePool()->
+				create( pSelectedInstrument, 0, fVelocity, fPan, nLength, fPitch );
+			if ( pNote2 != nullptr ) {
+				pNote2->set_key_octave( notekey, octave );
+				m_pAudioEngine->getSampler()->noteOn( pNote2 );
+			}
 		}
 	}
 
@@ -1248,6 +1244,8 @@ void PianoRollEditor::onPreferencesChanged( H2Core::Preferences::Changes changes
 	if ( changes & ( H2Core::Preferences::Changes::Colors |
 					 H2Core::Preferences::Changes::Font ) ) {
 		createBackground();
+		invalidateNoteLayers();
+		updateNoteLayers();
 		update();
 	}
 }
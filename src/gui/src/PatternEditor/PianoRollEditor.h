@@ -86,6 +86,11 @@ class PianoRollEditor: public PatternEditor, protected WidgetWithScalableFont<7,
 		virtual void selectionMoveEndEvent( QInputEvent *ev ) override;
 		virtual QRect getKeyboardCursorRect() override;
 
+		//! Selected notes are drawn on top of the cached note layers.
+		virtual void updateWidget() override {
+			update();
+		}
+
 
 	public slots:
 		virtual void updateEditor( bool bPatternOnly = false ) override;
@@ -96,9 +101,13 @@ class PianoRollEditor: public PatternEditor, protected WidgetWithScalableFont<7,
 
 	private:
 		void createBackground() override;
-		void drawPattern();
 		void drawFocus( QPainter& painter );
-		void drawNote( H2Core::Note *pNote, QPainter *pPainter, bool bIsForeground );
+		virtual QPoint getNotePosition( H2Core::Note* pNote ) const override;
+		virtual void drawPatternNotes( QPainter& painter, H2Core::Pattern* pPattern,
+									   bool bIsForeground ) override;
+		//! Includes the selected instrument, the only one whose notes
+		//! are shown.
+		virtual size_t getLayoutFingerprint() const override;
 
 		void addOrRemoveNote( int nColumn, int nRealColumn, int nLine,
 							  int nNotekey, int nOctave,
@@ -113,7 +122,6 @@ class PianoRollEditor: public PatternEditor, protected WidgetWithScalableFont<7,
 		bool m_bNeedsBackgroundUpdate;
 
 		QPixmap *m_pBackground;
-		QPixmap *m_pTemp;
 
 		// Note pitch position of cursor
 		int m_nCursorPitch;
@@ -764,11 +764,15 @@ void PlaylistDialog::nodePlayBTN()
 
 		QTreeWidget* m_pPlaylist = m_pPlaylistTree;
 		int index = m_pPlaylist->indexOfTopLevelItem ( m_pPlaylistItem );
-		Playlist::get_instance()->setActiveSongNumber( index );
+		Playlist* pPlaylist = Playlist::get_instance();
+		pPlaylist->setActiveSongNumber( index );
 
-		if ( ! pH2App->openSong( sFilename ) ) {
+		auto pSong = pPlaylist->getPrefetchedSong( index );
+		if ( ! ( pSong != nullptr ? pH2App->openSong( pSong ) :
+				 pH2App->openSong( sFilename ) ) ) {
 			m_pPlayBtn->setChecked(false);
 		}
+		pPlaylist->prefetchSong( index + 1 );
 
 		pHydrogen->sequencer_play();
 	}else
@@ -816,7 +820,13 @@ void PlaylistDialog::on_m_pPlaylistTree_itemDoubleClicked ()
 
 	m_pPlayBtn->setChecked(false);
 
-	pH2App->openSong( sFilename );
+	auto pSong = Playlist::get_instance()->getPrefetchedSong( index );
+	if ( pSong != nullptr ) {
+		pH2App->openSong( pSong );
+	} else {
+		pH2App->openSong( sFilename );
+	}
+	Playlist::get_instance()->prefetchSong( index + 1 );
 
 	pH2App->setStatusBarMessage( tr( "Playlist: set song no. %1" ).arg( index +1 ), 5000 );
 
@@ -651,6 +651,7 @@ void PreferencesDialog::on_cancelBtn_clicked()
 	
 	H2Core::Preferences::get_instance()->setTheme( m_pPreviousTheme );
 	HydrogenApp::get_instance()->changePreferences( H2Core::Preferences::Changes::Colors );
+	Hydrogen::get_instance()->getAudioEngine()->getSampler()->updateSamplePrefetcher();
 
 	reject();
 }
@@ -905,6 +906,7 @@ void PreferencesDialog::on_okBtn_clicked()
 	}
 	
 	pPref->savePreferences();
+	Hydrogen::get_instance()->getAudioEngine()->getSampler()->updateSamplePrefetcher();
 	accept();
 }
 
@@ -79,6 +79,7 @@ SongEditor::SongEditor( QWidget *parent, QScrollArea *pScrollView, SongEditorPan
  , m_pHydrogen( nullptr )
  , m_pAudioEngine( nullptr )
  , m_bEntered( false )
+ , m_fTick( -1 )
 {
 	m_pHydrogen = Hydrogen::get_instance();
 	m_pAudioEngine = m_pHydrogen->getAudioEngine();
@@ -674,7 +675,9 @@ void SongEditor::focusInEvent( QFocusEvent *ev )
 
 	// If there are some patterns selected, we have to switch their
 	// border color inactive <-> active.
-	createBackground();
+	for ( const auto& cell : m_drawnSelection ) {
+		invalidateCell( cell );
+	}
 	update();
 	
 	if ( ! HydrogenApp::get_instance()->hideKeyboardCursor() ) {
@@ -690,7 +693,9 @@ void SongEditor::focusOutEvent( QFocusEvent *ev )
 
 	// If there are some patterns selected, we have to switch their
 	// border color inactive <-> active.
-	createBackground();
+	for ( const auto& cell : m_drawnSelection ) {
+		invalidateCell( cell );
+	}
 	update();
 	
 	if ( ! HydrogenApp::get_instance()->hideKeyboardCursor() ) {
@@ -961,22 +966,53 @@ void SongEditor::updateWidget() {
 }
 
 void SongEditor::updatePosition( float fTick ) {
+	if ( fTick == m_fTick ) {
+		return;
+	}
+
+	// Only the areas covered by the old and the new playhead have to
+	// be repainted. The remainder is still valid.
+	if ( m_fTick != -1 ) {
+		update( getPlayheadRect( m_fTick ) );
+	}
 	m_fTick = fTick;
-	update();
+	if ( m_fTick != -1 ) {
+		update( getPlayheadRect( m_fTick ) );
+	}
+}
+
+QRect SongEditor::getPlayheadRect( float fTick ) const {
+	int nX = static_cast<int>( static_cast<float>(SongEditor::nMargin) + 1 +
+							   fTick * static_cast<float>(m_nGridWidth) -
+							   static_cast<float>(Skin::nPlayheadWidth) / 2 );
+	// Some slack for the width of the pen and antialiasing.
+	return QRect( nX + Skin::getPlayheadShaftOffset() - 2, 0, 5, height() );
 }
 
 void SongEditor::paintEvent( QPaintEvent *ev )
 {
-	// ridisegno tutto solo se sono cambiate le note
+	// Only the tiles of cells which were added, removed, or changed
+	// their selection state have to be redrawn.
 	if (m_bSequenceChanged) {
 		m_bSequenceChanged = false;
-		drawSequence();
+		updateGridCells();
+		updateSelectedCells();
 	}
 	
 	auto pPref = Preferences::get_instance();
 
 	QPainter painter(this);
-	painter.drawPixmap( ev->rect(), *m_pSequencePixmap, ev->rect() );
+
+	const QRect rect = ev->rect().intersected( QRect( 0, 0, width(), height() ) );
+	if ( ! rect.isEmpty() ) {
+		for ( int nTileY = rect.top() / nTileSize; nTileY <= rect.bottom() / nTileSize; ++nTileY ) {
+			for ( int nTileX = rect.left() / nTileSize; nTileX <= rect.right() / nTileSize; ++nTileX ) {
+				painter.drawPixmap( nTileX * nTileSize, nTileY * nTileSize,
+									getTile( QPoint( nTileX, nTileY ) ) );
+			}
+		}
+	}
+	pruneTiles();
 
 	// Draw moving selected cells
 	QColor patternColor( 0, 0, 0 );
@@ -1068,33 +1104,102 @@ void SongEditor::leaveEvent( QEvent *ev ) {
 
 void SongEditor::createBackground()
 {
-	auto pPref = H2Core::Preferences::get_instance();
-	std::shared_ptr<Song> pSong = m_pHydrogen->getSong();
-
-	uint nPatterns = pSong->getPatternList()->size();
-	int nSelectedPatternNumber = m_pHydrogen->getSelectedPatternNumber();
-	int nMaxPatternSequence = pPref->getMaxBars();
+	uint nPatterns = m_pHydrogen->getSong()->getPatternList()->size();
 
-	static int nOldHeight = -1;
 	int nNewHeight = m_nGridHeight * nPatterns;
+	if ( nNewHeight == 0 ) {
+		nNewHeight = 1;	// the widget should not be empty
+	}
+	if ( nNewHeight != height() ) {
+		this->resize( QSize( width(), nNewHeight ) );
+	}
+
+	// The tiles are rendered again once they get exposed.
+	m_tiles.clear();
+	m_bSequenceChanged = true;
+}
 
-	if (nOldHeight != nNewHeight) {
-		// cambiamento di dimensioni...
-		if (nNewHeight == 0) {
-			nNewHeight = 1;	// the pixmap should not be empty
+void SongEditor::cleanUp(){
+
+	m_tiles.clear();
+}
+
+template<typename F>
+void SongEditor::forEachCellIn( const QRect& rect, F f )
+{
+	// Cells are sorted by column first and by row second.
+	const int nFirstColumn = std::max( ( rect.left() - SongEditor::nMargin ) /
+									   static_cast<int>(m_nGridWidth) - 1, 0 );
+	const int nLastColumn = ( rect.right() - SongEditor::nMargin ) /
+		static_cast<int>(m_nGridWidth);
+	const int nFirstRow = std::max( rect.top() / static_cast<int>(m_nGridHeight) - 1, 0 );
+	const int nLastRow = rect.bottom() / static_cast<int>(m_nGridHeight);
+
+	for ( int nColumn = nFirstColumn; nColumn <= nLastColumn; ++nColumn ) {
+		for ( auto it = m_gridCells.lower_bound( QPoint( nColumn, nFirstRow ) );
+			  it != m_gridCells.end() && it->first.x() == nColumn &&
+				  it->first.y() <= nLastRow; ++it ) {
+			f( it->first, it->second );
 		}
+	}
+}
 
-		m_pBackgroundPixmap = new QPixmap( width(), nNewHeight );	// initialize the pixmap
-		m_pSequencePixmap = new QPixmap( width(), nNewHeight );	// initialize the pixmap
-		this->resize( QSize( width(), nNewHeight ) );
+const QPixmap& SongEditor::getTile( const QPoint& tile )
+{
+	const qreal pixelRatio = devicePixelRatio();
+
+	auto it = m_tiles.find( tile );
+	if ( it != m_tiles.end() && it->second.devicePixelRatio() == pixelRatio ) {
+		return it->second;
 	}
 
-	
-	m_pBackgroundPixmap->fill( pPref->getColorTheme()->m_songEditor_backgroundColor );
+	QPixmap pixmap( nTileSize * pixelRatio, nTileSize * pixelRatio );
+	pixmap.setDevicePixelRatio( pixelRatio );
+	drawTile( &pixmap, QRect( tile * nTileSize, QSize( nTileSize, nTileSize ) ) );
 
-	QPainter p( m_pBackgroundPixmap );
-	
-	for ( int ii = 0; ii < nPatterns + 1; ii++) {
+	if ( it != m_tiles.end() ) {
+		it->second = pixmap;
+		return it->second;
+	}
+	return m_tiles.emplace( tile, pixmap ).first->second;
+}
+
+void SongEditor::drawTile( QPixmap* pPixmap, const QRect& rect )
+{
+	QPainter p( pPixmap );
+	p.translate( -rect.topLeft() );
+
+	drawBackground( p, rect );
+
+	// Draw using GridCells representation
+	forEachCellIn( rect, [&]( const QPoint& cell, const GridCell& gridCell ) {
+		if ( ! m_selection.isSelected( cell ) ) {
+			drawPattern( p, cell.x(), cell.y(), gridCell.m_bDrawnVirtual, gridCell.m_fWidth );
+		}
+	});
+	// We draw all selected patterns in a second run to ensure their
+	// border does have the proper color (else the bottom and left one
+	// could be overwritten by an adjecent, unselected pattern).
+	forEachCellIn( rect, [&]( const QPoint& cell, const GridCell& gridCell ) {
+		if ( m_selection.isSelected( cell ) ) {
+			drawPattern( p, cell.x(), cell.y(), gridCell.m_bDrawnVirtual, gridCell.m_fWidth );
+		}
+	});
+}
+
+void SongEditor::drawBackground( QPainter& p, const QRect& rect )
+{
+	auto pPref = H2Core::Preferences::get_instance();
+
+	int nPatterns = m_pHydrogen->getSong()->getPatternList()->size();
+	int nSelectedPatternNumber = m_pHydrogen->getSelectedPatternNumber();
+	int nMaxPatternSequence = pPref->getMaxBars();
+
+	p.fillRect( rect, pPref->getColorTheme()->m_songEditor_backgroundColor );
+
+	const int nFirstRow = std::max( rect.top() / static_cast<int>(m_nGridHeight), 0 );
+	const int nLastRow = std::min( rect.bottom() / static_cast<int>(m_nGridHeight), nPatterns );
+	for ( int ii = nFirstRow; ii <= nLastRow; ii++) {
 		if ( ( ii % 2 ) == 0 &&
 			 ii != nSelectedPatternNumber ) {
 			continue;
@@ -1115,32 +1220,62 @@ void SongEditor::createBackground()
 					Qt::SolidLine ) );
 
 	// vertical lines
-	for ( float ii = 0; ii <= nMaxPatternSequence + 1; ii++) {
-		float x = SongEditor::nMargin + ii * m_nGridWidth;
+	const int nFirstColumn = std::max( ( rect.left() - SongEditor::nMargin ) /
+									   static_cast<int>(m_nGridWidth), 0 );
+	const int nLastColumn = std::min( ( rect.right() - SongEditor::nMargin ) /
+									  static_cast<int>(m_nGridWidth) + 1,
+									  nMaxPatternSequence + 1 );
+	for ( int ii = nFirstColumn; ii <= nLastColumn; ii++) {
+		int x = SongEditor::nMargin + ii * m_nGridWidth;
 		p.drawLine( x, 0, x, m_nGridHeight * nPatterns );
 	}
 	
 	// horizontal lines
-	for (uint i = 0; i < nPatterns; i++) {
-		uint y = m_nGridHeight * i;
+	for ( int ii = nFirstRow; ii <= std::min( nLastRow, nPatterns - 1 ); ii++) {
+		int y = m_nGridHeight * ii;
 
 		p.drawLine( 0, y, (nMaxPatternSequence * m_nGridWidth), y );
 	}
+}
 
-	//~ celle
-	m_bSequenceChanged = true;
+void SongEditor::invalidateCell( const QPoint& cell )
+{
+	// Including the border drawn on the right and bottom edge.
+	const QRect rect( columnRowToXy( cell ), QSize( m_nGridWidth + 1, m_nGridHeight + 1 ) );
+	if ( rect.right() < 0 || rect.bottom() < 0 ) {
+		return;
+	}
+	for ( int nTileY = std::max( rect.top(), 0 ) / nTileSize;
+		  nTileY <= rect.bottom() / nTileSize; ++nTileY ) {
+		for ( int nTileX = std::max( rect.left(), 0 ) / nTileSize;
+			  nTileX <= rect.right() / nTileSize; ++nTileX ) {
+			m_tiles.erase( QPoint( nTileX, nTileY ) );
+		}
+	}
 }
 
-void SongEditor::cleanUp(){
+void SongEditor::pruneTiles()
+{
+	if ( static_cast<int>( m_tiles.size() ) <= nMaxCachedTiles ) {
+		return;
+	}
 
-	delete m_pBackgroundPixmap;
-	delete m_pSequencePixmap;
+	const QRect visibleRect = visibleRegion().boundingRect();
+	for ( auto it = m_tiles.begin(); it != m_tiles.end(); ) {
+		if ( ! visibleRect.intersects( QRect( it->first * nTileSize,
+											  QSize( nTileSize, nTileSize ) ) ) ) {
+			it = m_tiles.erase( it );
+		} else {
+			++it;
+		}
+	}
 }
 
 // Update the GridCell representation.
 void SongEditor::updateGridCells() {
 
-	m_gridCells.clear();
+	std::map< QPoint, GridCell > oldGridCells;
+	oldGridCells.swap( m_gridCells );
 	std::shared_ptr<Song> pSong = Hydrogen::get_instance()->getSong();
 	PatternList *pPatternList = pSong->getPatternList();
 	std::vector< PatternList* > *pColumns = pSong->getPatternGroupVector();
@@ -1164,6 +1299,47 @@ void SongEditor::updateGridCells() {
 			}
 		}
 	}
+
+	// Both maps are sorted. Walk them in parallel and invalidate all
+	// cells present in only one of them or differing in between.
+	auto itOld = oldGridCells.begin();
+	auto itNew = m_gridCells.begin();
+	while ( itOld != oldGridCells.end() || itNew != m_gridCells.end() ) {
+		if ( itNew == m_gridCells.end() ||
+			 ( itOld != oldGridCells.end() && itOld->first < itNew->first ) ) {
+			invalidateCell( itOld->first );
+			++itOld;
+		} else if ( itOld == oldGridCells.end() || itNew->first < itOld->first ) {
+			invalidateCell( itNew->first );
+			++itNew;
+		} else {
+			if ( itOld->second != itNew->second ) {
+				invalidateCell( itNew->first );
+			}
+			++itOld;
+			++itNew;
+		}
+	}
+}
+
+void SongEditor::updateSelectedCells()
+{
+	std::set< QPoint > selection( m_selection.begin(), m_selection.end() );
+	if ( selection == m_drawnSelection ) {
+		return;
+	}
+
+	for ( const auto& cell : selection ) {
+		if ( m_drawnSelection.find( cell ) == m_drawnSelection.end() ) {
+			invalidateCell( cell );
+		}
+	}
+	for ( const auto& cell : m_drawnSelection ) {
+		if ( selection.find( cell ) == selection.end() ) {
+			invalidateCell( cell );
+		}
+	}
+	m_drawnSelection.swap( selection );
 }
 
 // Return grid offset (in cell coordinate space) of moving selection
@@ -1183,38 +1359,8 @@ QPoint SongEditor::movingGridOffset( ) const {
 }
 
 
-void SongEditor::drawSequence()
-{
-	QPainter p;
-	p.begin( m_pSequencePixmap );
-	p.drawPixmap( rect(), *m_pBackgroundPixmap, rect() );
-	p.end();
-
-	updateGridCells();
-
-	// Draw using GridCells representation
-	for ( auto it : m_gridCells ) {
-		if ( ! m_selection.isSelected( QPoint( it.first.x(), it.first.y() ) ) ) {
-			drawPattern( it.first.x(), it.first.y(),
-						 it.second.m_bDrawnVirtual, it.second.m_fWidth );
-		}
-	}
-	// We draw all selected patterns in a second run to ensure their
-	// border does have the proper color (else the bottom and left one
-	// could be overwritten by an adjecent, unselected pattern).
-	for ( auto it : m_gridCells ) {
-		if ( m_selection.isSelected( QPoint( it.first.x(), it.first.y() ) ) ) {
-			drawPattern( it.first.x(), it.first.y(),
-						 it.second.m_bDrawnVirtual, it.second.m_fWidth );
-		}
-	}
-}
-
-
-
-void SongEditor::drawPattern( int nPos, int nNumber, bool bInvertColour, double fWidth )
+void SongEditor::drawPattern( QPainter& p, int nPos, int nNumber, bool bInvertColour, double fWidth )
 {
-	QPainter p( m_pSequencePixmap );
 	/*
 	 * The default color of the cubes in rgb is 97,167,251.
 	 */
@@ -1285,14 +1431,14 @@ void SongEditor::drawPattern( int nPos, int nNumber, bool bInvertColour, double
 std::vector<SongEditor::SelectionIndex> SongEditor::elementsIntersecting( QRect r )
 {
 	std::vector<SelectionIndex> elems;
-	for ( auto it : m_gridCells ) {
-		if ( r.intersects( QRect( columnRowToXy( it.first ),
+	forEachCellIn( r, [&]( const QPoint& cell, const GridCell& gridCell ) {
+		if ( r.intersects( QRect( columnRowToXy( cell ),
 								  QSize( m_nGridWidth, m_nGridHeight) ) ) ) {
-			if ( ! it.second.m_bDrawnVirtual ) {
-				elems.push_back( it.first );
+			if ( ! gridCell.m_bDrawnVirtual ) {
+				elems.push_back( cell );
 			}
 		}
-	}
+	});
 	return elems;
 }
 
@@ -25,6 +25,8 @@
 
 #include <vector>
 #include <memory>
+#include <map>
+#include <set>
 
 #include <unistd.h>
 
@@ -77,12 +79,21 @@ class SongEditor : public QWidget
 			bool m_bActive;
 			bool m_bDrawnVirtual;
 			float m_fWidth;
+
+			bool operator!=( const GridCell& other ) const {
+				return m_bActive != other.m_bActive ||
+					m_bDrawnVirtual != other.m_bDrawnVirtual ||
+					m_fWidth != other.m_fWidth;
+			}
 		};
 	
 	public:
 		SongEditor( QWidget *parent, QScrollArea *pScrollView, SongEditorPanel *pSongEditorPanel );
 		~SongEditor();
 
+		//! Adapts the size of the widget to the number of patterns
+		//! and discards all cached tiles. They are rendered again
+		//! once they get exposed.
 		void createBackground();
 	void updatePosition( float fTick );
 		
@@ -145,16 +156,34 @@ class SongEditor : public QWidget
 		QMenu *					m_pPopupMenu;
 
 
-		//! @name Background pixmap caching
+		//! @name Tile caching
 		//!
-		//! To make painting the song editor sequence grid more efficient, the drawing uses multiple levels of lazy painting.
-		//!   * The grid background pixmap is only updated when the size of the pattern grid changes.
-		//!   * The sequence pixmap are only updated when cells are added/removed or selections change
-		//!       * the cached grid background pixmap is used when repainting the pattern
-		//!   * selections and moving cells are painted on top of the cached sequence pixmap
+		//! To keep painting large arrangements cheap, the grid background and the pattern cells are rendered
+		//! into square tiles of #nTileSize pixels which are created lazily for the exposed region only.
+		//!   * All tiles are discarded when the grid itself changes (size, selected pattern, colours, focus).
+		//!   * When cells are added/removed or the selection changes, only the tiles covering the affected
+		//!     cells are discarded (see updateGridCells() and updateSelectedCells()).
+		//!   * Moving cells, the playhead, the lasso and the cursor are painted on top of the cached tiles.
+		//!   * Once more than #nMaxCachedTiles are held, tiles outside the visible area are dropped.
 		//! @{
-		QPixmap *				m_pBackgroundPixmap;
-		QPixmap *				m_pSequencePixmap;
+		static constexpr int	nTileSize = 256;
+		static constexpr int	nMaxCachedTiles = 64;
+		std::map< QPoint, QPixmap >	m_tiles;
+		//! Selected cells as drawn into #m_tiles.
+		std::set< QPoint >		m_drawnSelection;
+
+		//! \return Tile with index @a tile, rendered on demand.
+		const QPixmap& getTile( const QPoint& tile );
+		void drawTile( QPixmap* pPixmap, const QRect& rect );
+		void drawBackground( QPainter& painter, const QRect& rect );
+		//! Discards all tiles covering @a cell.
+		void invalidateCell( const QPoint& cell );
+		//! Drops tiles not intersecting the visible part of the widget.
+		void pruneTiles();
+		//! Calls @a f for all cells in #m_gridCells overlapping @a rect
+		//! in widget coordinates.
+		template<typename F>
+		void forEachCellIn( const QRect& rect, F f );
 		//! @}
 
 		//! @name Position of the keyboard input cursor
@@ -204,13 +233,19 @@ class SongEditor : public QWidget
     	void togglePatternActive( int nColumn, int nRow );
 		void setPatternActive( int nColumn, int nRow, bool bActivate );
 
-		void drawSequence();
-  
-		void drawPattern( int pos, int number, bool invertColour, double width );
+		//! Discards the tiles of all cells whose selection state
+		//! changed since they were drawn.
+		void updateSelectedCells();
+
+		void drawPattern( QPainter& painter, int pos, int number, bool invertColour, double width );
 		void drawFocus( QPainter& painter );
 
 		std::map< QPoint, GridCell > m_gridCells;
+		//! Rebuilds #m_gridCells from the song and discards the tiles
+		//! of all cells which differ from the previous state.
 		void updateGridCells();
+		//! \return Area covered by the playhead at @a fTick.
+		QRect getPlayheadRect( float fTick ) const;
 		bool m_bEntered;
 	
 	/** Cached position of the playhead.*/
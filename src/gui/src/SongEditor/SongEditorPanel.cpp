@@ -1138,7 +1138,11 @@ void SongEditorPanel::setTimelineEnabled( bool bEnabled ) {
 }
 
 void SongEditorPanel::gridCellToggledEvent() {
-	updateAll();
+	// The SongEditor figures out which cells changed on its own and
+	// redraws only those. The grid itself stays the same.
+	m_pSongEditor->updateEditorandSetTrue();
+	updatePositionRuler();
+	patternModifiedEvent();
 }
 
 void SongEditorPanel::patternChangedEvent() {
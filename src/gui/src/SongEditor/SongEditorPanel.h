@@ -54,6 +54,7 @@ class SongEditorPanel :  public QWidget, public EventListener,  public H2Core::O
 		~SongEditorPanel();
 
 		SongEditor* getSongEditor() const { return m_pSongEditor; }
+		QScrollArea* getEditorScrollView() const { return m_pEditorScrollView; }
 		SongEditorPatternList* getSongEditorPatternList() const { return m_pPatternList; }
 		SongEditorPositionRuler* getSongEditorPositionRuler() const { return m_pPositionRuler; }
 		AutomationPathView* getAutomationPathView() const { return m_pAutomationPathView; }
@@ -82,12 +82,6 @@ SoundLibraryExportDialog::SoundLibraryExportDialog( QWidget* pParent,  const QSt
 SoundLibraryExportDialog::~SoundLibraryExportDialog()
 {
 	INFOLOG( "DESTROY" );
-
-	for (uint i = 0; i < m_pDrumkitInfoList.size(); i++ ) {
-		Drumkit* info = m_pDrumkitInfoList[i];
-		delete info;
-	}
-	m_pDrumkitInfoList.clear();
 }
 
 
@@ -105,18 +99,18 @@ void SoundLibraryExportDialog::on_exportBtn_clicked()
 	// it's important to retrieve the kit from the list of drumkits
 	// used to create the different choices presented in the GUI.
 	Drumkit* pDrumkit = nullptr;
-	for ( const auto& ppKit : m_pDrumkitInfoList ) {
-		if ( ppKit->isUserDrumkit() ) {
-			if ( ppKit->get_name().compare( drumkitList->currentText() ) == 0 ) {
-				pDrumkit = ppKit;
+	for ( const auto& kit : m_drumkitInfoList ) {
+		if ( kit.bIsUserDrumkit ) {
+			if ( kit.sName.compare( drumkitList->currentText() ) == 0 ) {
+				pDrumkit = Drumkit::load( kit.sPath, false );
 				break;
 			}
 		} else {
 			QString	sChosenName = drumkitList->currentText();
 			if ( sChosenName.contains( m_sSysDrumkitSuffix ) ) {
 				sChosenName.replace( m_sSysDrumkitSuffix, "" );
-				if ( ppKit->get_name().compare( sChosenName ) == 0 ) {
-					pDrumkit = ppKit;
+				if ( kit.sName.compare( sChosenName ) == 0 ) {
+					pDrumkit = Drumkit::load( kit.sPath, false );
 					break;
 				}
 			}
@@ -159,6 +153,7 @@ void SoundLibraryExportDialog::on_exportBtn_clicked()
 		msgBox.setDefaultButton(QMessageBox::Ok);
 
 		if ( msgBox.exec() == QMessageBox::Cancel ) {
+			delete pDrumkit;
 			return;
 		}
 	}
@@ -170,9 +165,11 @@ void SoundLibraryExportDialog::on_exportBtn_clicked()
 							   bRecentVersion ) ) {
 		QApplication::restoreOverrideCursor();
 		QMessageBox::critical( this, "Hydrogen", tr("Unable to export drumkit") );
+		delete pDrumkit;
 		return;
 	}
 
+	delete pDrumkit;
 	QApplication::restoreOverrideCursor();
 	QMessageBox::information( this, "Hydrogen",
 							  tr("Drumkit exported to") + "\n" +
@@ -244,43 +241,22 @@ void SoundLibraryExportDialog::updateDrumkitList()
 
 	drumkitList->clear();
 
-	for ( auto pDrumkitInfo : m_pDrumkitInfoList ) {
-		delete pDrumkitInfo;
-	}
-	m_pDrumkitInfoList.clear();
+	auto pDrumkitIndex = DrumkitIndex::get_instance();
+	m_drumkitInfoList = pDrumkitIndex->getSystemDrumkits();
 
-	QStringList sysDrumkits = Filesystem::sys_drumkit_list();
 	QString sDrumkitName;
-	for (int i = 0; i < sysDrumkits.size(); ++i) {
-		QString absPath = Filesystem::sys_drumkits_dir() + sysDrumkits.at(i);
-		Drumkit *info = Drumkit::load( absPath, false );
-		if (info) {
-			m_pDrumkitInfoList.push_back( info );
-			sDrumkitName = info->get_name() + m_sSysDrumkitSuffix;
-			drumkitList->addItem( sDrumkitName );
-			QStringList p_components;
-			for ( auto pComponent : *(info->get_components() ) ) {
-				p_components.append( pComponent->get_name() );
-			}
-			m_kit_components[ sDrumkitName ] = p_components;
-		}
+	for ( const auto& kit : m_drumkitInfoList ) {
+		sDrumkitName = kit.sName + m_sSysDrumkitSuffix;
+		drumkitList->addItem( sDrumkitName );
+		m_kit_components[ sDrumkitName ] = kit.components;
 	}
 
 	drumkitList->insertSeparator( drumkitList->count() );
 
-	QStringList userDrumkits = Filesystem::usr_drumkit_list();
-	for (int i = 0; i < userDrumkits.size(); ++i) {
-		QString absPath = Filesystem::usr_drumkits_dir() + userDrumkits.at(i);
-		Drumkit *info = Drumkit::load( absPath, false );
-		if (info) {
-			m_pDrumkitInfoList.push_back( info );
-			drumkitList->addItem( info->get_name() );
-			QStringList p_components;
-			for ( auto pComponent : *(info->get_components() ) ) {
-				p_components.append(pComponent->get_name());
-			}
-			m_kit_components[info->get_name()] = p_components;
-		}
+	for ( const auto& kit : pDrumkitIndex->getUserDrumkits() ) {
+		m_drumkitInfoList.push_back( kit );
+		drumkitList->addItem( kit.sName );
+		m_kit_components[ kit.sName ] = kit.components;
 	}
 
 	/*
@@ -28,6 +28,7 @@
 #include <core/Object.h>
 #include <core/Basics/Song.h>
 #include <core/Basics/Drumkit.h>
+#include <core/Helpers/DrumkitIndex.h>
 #include <core/Helpers/Filesystem.h>
 
 #include <vector>
@@ -53,7 +54,7 @@ private slots:
 	void on_drumkitPathTxt_textChanged( QString str );
 	void updateDrumkitList();
 private:
-	std::vector<H2Core::Drumkit*> m_pDrumkitInfoList;
+	std::vector<H2Core::DrumkitIndex::Entry> m_drumkitInfoList;
 	QString m_sPreselectedKit;
 	H2Core::Filesystem::Lookup m_preselectedKitLookup;
 	QString m_sSysDrumkitSuffix;
@@ -46,6 +46,7 @@
 
 #include <core/LocalFileMng.h>
 #include <core/Basics/Adsr.h>
+#include <core/Basics/DrumkitSampleLoader.h>
 #include <core/AudioEngine/AudioEngine.h>
 #include <core/H2Exception.h>
 #include <core/Hydrogen.h>
@@ -55,11 +56,13 @@
 #include <core/Basics/PatternList.h>
 #include <core/Basics/Sample.h>
 #include <core/Basics/Song.h>
+#include <core/Helpers/DrumkitIndex.h>
 #include <core/Helpers/Filesystem.h>
 
 using namespace H2Core;
 
 #include <cassert>
+#include <thread>
 
 SoundLibraryPanel::SoundLibraryPanel( QWidget *pParent, bool bInItsOwnDialog )
  : QWidget( pParent )
@@ -140,17 +143,6 @@ SoundLibraryPanel::SoundLibraryPanel( QWidget *pParent, bool bInItsOwnDialog )
 SoundLibraryPanel::~SoundLibraryPanel()
 {
 	HydrogenApp::get_instance()->removeEventListener( this );
-
-	for (uint i = 0; i < __system_drumkit_info_list.size(); ++i ) {
-		delete __system_drumkit_info_list[i];
-	}
-	__system_drumkit_info_list.clear();
-
-	for (uint i = 0; i < __user_drumkit_info_list.size(); ++i ) {
-		delete __user_drumkit_info_list[i];
-	}
-	__user_drumkit_info_list.clear();
-
 }
 
 
@@ -179,59 +171,34 @@ void SoundLibraryPanel::updateDrumkitList()
 	__user_drumkits_item->setText( 0, tr( "User drumkits" ) );
 	__user_drumkits_item->setExpanded( true );
 	__user_drumkits_item->setFont( 0, boldFont );
-	
-
-	for (uint i = 0; i < __system_drumkit_info_list.size(); ++i ) {
-		delete __system_drumkit_info_list[i];
-	}
-	__system_drumkit_info_list.clear();
 
-	for (uint i = 0; i < __user_drumkit_info_list.size(); ++i ) {
-		delete __user_drumkit_info_list[i];
-	}
-	__user_drumkit_info_list.clear();
-
-	//User drumkit list
-	QStringList usr_dks = Filesystem::usr_drumkit_list();
-	for (int i = 0; i < usr_dks.size(); ++i) {
-		QString absPath = Filesystem::usr_drumkits_dir() + usr_dks[i];
-		Drumkit *pInfo = Drumkit::load( absPath, false );
-		if (pInfo) {
-			__user_drumkit_info_list.push_back( pInfo );
-			QTreeWidgetItem* pDrumkitItem = new QTreeWidgetItem( __user_drumkits_item );
-			pDrumkitItem->setText( 0, pInfo->get_name() );
+	// The metadata of the kits is retrieved from the DrumkitIndex.
+	// Only kits installed or altered since the last refresh are
+	// parsed.
+	auto pDrumkitIndex = DrumkitIndex::get_instance();
+	__user_drumkit_info_list = pDrumkitIndex->getUserDrumkits();
+	__system_drumkit_info_list = pDrumkitIndex->getSystemDrumkits();
+
+	auto addDrumkitItems = [&]( QTreeWidgetItem* pParent,
+								const std::vector<DrumkitIndex::Entry>& drumkits ) {
+		for ( const auto& drumkit : drumkits ) {
+			QTreeWidgetItem* pDrumkitItem = new QTreeWidgetItem( pParent );
+			pDrumkitItem->setText( 0, drumkit.sName );
 			if ( ! m_bInItsOwnDialog ) {
-				InstrumentList *pInstrList = pInfo->get_instruments();
-				for ( uint nInstr = 0; nInstr < pInstrList->size(); ++nInstr ) {
-					auto pInstr = pInstrList->get( nInstr );
+				for ( int nInstr = 0; nInstr < drumkit.instruments.size(); ++nInstr ) {
 					QTreeWidgetItem* pInstrumentItem = new QTreeWidgetItem( pDrumkitItem );
-					pInstrumentItem->setText( 0, QString( "[%1] " ).arg( nInstr + 1 ) + pInstr->get_name() );
-					pInstrumentItem->setToolTip( 0, pInstr->get_name() );
+					pInstrumentItem->setText( 0, QString( "[%1] " ).arg( nInstr + 1 ) + drumkit.instruments[ nInstr ] );
+					pInstrumentItem->setToolTip( 0, drumkit.instruments[ nInstr ] );
 				}
 			}
 		}
-	}
+	};
+
+	//User drumkit list
+	addDrumkitItems( __user_drumkits_item, __user_drumkit_info_list );
 
 	//System drumkit list
-	QStringList sys_dks = Filesystem::sys_drumkit_list();
-	for (int i = 0; i < sys_dks.size(); ++i) {
-		QString absPath = Filesystem::sys_drumkits_dir() + sys_dks[i];
-		Drumkit *pInfo = Drumkit::load( absPath, false );
-		if (pInfo) {
-			__system_drumkit_info_list.push_back( pInfo );
-			QTreeWidgetItem* pDrumkitItem = new QTreeWidgetItem( __system_drumkits_item );
-			pDrumkitItem->setText( 0, pInfo->get_name() );
-			if ( ! m_bInItsOwnDialog ) {
-				InstrumentList *pInstrList = pInfo->get_instruments();
-				for ( uint nInstr = 0; nInstr < pInstrList->size(); ++nInstr ) {
-					auto pInstr = pInstrList->get( nInstr );
-					QTreeWidgetItem* pInstrumentItem = new QTreeWidgetItem( pDrumkitItem );
-					pInstrumentItem->setText( 0, QString( "[%1] " ).arg( nInstr + 1 ) + pInstr->get_name() );
-					pInstrumentItem->setToolTip( 0, pInstr->get_name() );
-				}
-			}
-		}
-	}
+	addDrumkitItems( __system_drumkits_item, __system_drumkit_info_list );
 
 	if ( ! m_bInItsOwnDialog ) {
 		//Songlist
@@ -510,35 +477,18 @@ void SoundLibraryPanel::on_drumkitLoadAction()
 	// Whether we deal with a system or a user drumkit.
 	QString sDrumkitType = __sound_library_tree->currentItem()->parent()->text(0);
 
-	Drumkit *pDrumkitInfo = nullptr;
-
 	// Find the drumkit in the list. If the drumkit was listed as a
 	// "System drumkit", it won't be searched in the user ones and
 	// vice versa.
-	if ( sDrumkitType == __system_drumkits_item->text(0) ) {
-		
-		for ( uint i = 0; i < __system_drumkit_info_list.size(); i++ ) {
-			Drumkit *pInfo = __system_drumkit_info_list[i];
-			if ( pInfo->get_name() == sDrumkitName ) {
-				pDrumkitInfo = pInfo;
-				break;
-			}
-		}
-	} else if ( sDrumkitType == __user_drumkits_item->text(0) ) {
-		
-		for ( uint i = 0; i < __user_drumkit_info_list.size(); i++ ) {
-			Drumkit *pInfo = __user_drumkit_info_list[i];
-			if ( pInfo->get_name() == sDrumkitName ) {
-				pDrumkitInfo = pInfo;
-				break;
-			}
-		}
-	} else {
+	if ( sDrumkitType != __system_drumkits_item->text(0) &&
+		 sDrumkitType != __user_drumkits_item->text(0) ) {
 		ERRORLOG( QString( "Unknown drumkit type [%1] for drumkit [%2]" )
 				  .arg( sDrumkitType ).arg( sDrumkitName ) );
 		return;
 	}
-	
+
+	Drumkit *pDrumkitInfo =
+		loadDrumkit( sDrumkitName, sDrumkitType == __system_drumkits_item->text(0) );
 	if( !pDrumkitInfo ) {
 		ERRORLOG( QString( "Unable to find drumkit [%1]" ).arg( sDrumkitName ) );
 		return;
@@ -603,6 +553,7 @@ void SoundLibraryPanel::on_drumkitLoadAction()
 
 				case QMessageBox::Cancel:
 					// Cancel
+					delete pDrumkitInfo;
 					return;
 			}
 		}
@@ -612,7 +563,23 @@ void SoundLibraryPanel::on_drumkitLoadAction()
 
 	QApplication::setOverrideCursor(Qt::WaitCursor);
 
-	pHydrogen->getCoreActionController()->loadDrumkit( pDrumkitInfo, conditionalLoad );
+	// The samples are read in a separate thread while the GUI keeps
+	// processing events. Otherwise the progress reported by the
+	// loader would only be displayed after it is already done.
+	// User input is excluded to not trigger another load in the
+	// meantime.
+	DrumkitSampleLoader loader( pDrumkitInfo );
+	QEventLoop eventLoop;
+	std::thread loaderThread( [&]() {
+		loader.load();
+		QMetaObject::invokeMethod( &eventLoop, "quit", Qt::QueuedConnection );
+	} );
+	eventLoop.exec( QEventLoop::ExcludeUserInputEvents );
+	loaderThread.join();
+
+	pHydrogen->getCoreActionController()->loadDrumkit( pDrumkitInfo, conditionalLoad,
+													   &loader );
+	delete pDrumkitInfo;
 
 	QApplication::restoreOverrideCursor();
 }
@@ -733,35 +700,18 @@ void SoundLibraryPanel::on_drumkitPropertiesAction()
 	// Whether we deal with a system or a user drumkit.
 	QString sDrumkitType = __sound_library_tree->currentItem()->parent()->text(0);
 
-	Drumkit* pDrumkitInfo = nullptr;
-
 	// Find the selected drumkit in the drumkit tree. If it was listed
 	// as a "System drumkit", it won't be searched in the user ones
 	// and vice versa.
-	if ( sDrumkitType == __system_drumkits_item->text(0) ) {
-		
-		for ( uint i = 0; i < __system_drumkit_info_list.size(); i++ ) {
-			Drumkit *pInfo = __system_drumkit_info_list[i];
-			if ( pInfo->get_name() == sDrumkitName ) {
-				pDrumkitInfo = pInfo;
-				break;
-			}
-		}
-	} else if ( sDrumkitType == __user_drumkits_item->text(0) ) {
-		
-		for ( uint i = 0; i < __user_drumkit_info_list.size(); i++ ) {
-			Drumkit*pInfo = __user_drumkit_info_list[i];
-			if ( pInfo->get_name() == sDrumkitName ) {
-				pDrumkitInfo = pInfo;
-				break;
-			}
-		}
-	} else {
+	if ( sDrumkitType != __system_drumkits_item->text(0) &&
+		 sDrumkitType != __user_drumkits_item->text(0) ) {
 		ERRORLOG( QString( "Unknown drumkit type [%1] for drumkit [%2]" )
 				  .arg( sDrumkitType ).arg( sDrumkitName ) );
 		return;
 	}
-	
+
+	Drumkit* pDrumkitInfo =
+		loadDrumkit( sDrumkitName, sDrumkitType == __system_drumkits_item->text(0) );
 	if( ! pDrumkitInfo ) {
 		ERRORLOG( QString( "Unable to find drumkit [%1]" ).arg( sDrumkitName ) );
 		return;
@@ -769,31 +719,16 @@ void SoundLibraryPanel::on_drumkitPropertiesAction()
 
 	QString sPreDrumkitName = Hydrogen::get_instance()->getCurrentDrumkitName();
 
-	Drumkit* pPreDrumkitInfo = nullptr;
-
 	// Find the currently loaded drumkit in the drumkit tree and use
 	// the current lookup to decide whether to search in the system or
 	// the user folder.
-	if ( Hydrogen::get_instance()->getCurrentDrumkitLookup() == Filesystem::Lookup::system ) {
-		for ( uint i = 0; i < __system_drumkit_info_list.size(); i++ ) {
-			Drumkit *prInfo = __system_drumkit_info_list[i];
-			if ( prInfo->get_name() == sPreDrumkitName ) {
-				pPreDrumkitInfo = prInfo;
-				break;
-			}
-		}
-	} else {
-		for ( uint i = 0; i < __user_drumkit_info_list.size(); i++ ) {
-			Drumkit *prInfo = __user_drumkit_info_list[i];
-			if ( prInfo->get_name() == sPreDrumkitName ) {
-				pPreDrumkitInfo = prInfo;
-				break;
-			}
-		}
-	}
+	Drumkit* pPreDrumkitInfo =
+		loadDrumkit( sPreDrumkitName,
+					 Hydrogen::get_instance()->getCurrentDrumkitLookup() == Filesystem::Lookup::system );
 
 	if ( pPreDrumkitInfo == nullptr ){
 		QMessageBox::warning( this, "Hydrogen", QString( "%1 [%2]").arg( m_sMessageFailedPreDrumkitLoad ).arg(sPreDrumkitName) );
+		delete pDrumkitInfo;
 		return;
 	}
 	assert( pPreDrumkitInfo );
@@ -801,6 +736,22 @@ void SoundLibraryPanel::on_drumkitPropertiesAction()
 	//open the soundlibrary save dialog
 	SoundLibraryPropertiesDialog dialog( this , pDrumkitInfo, pPreDrumkitInfo );
 	dialog.exec();
+
+	delete pDrumkitInfo;
+	delete pPreDrumkitInfo;
+}
+
+Drumkit* SoundLibraryPanel::loadDrumkit( const QString& sDrumkitName, bool bSystemDrumkit ) const
+{
+	const auto& drumkits = bSystemDrumkit ?
+		__system_drumkit_info_list : __user_drumkit_info_list;
+
+	for ( const auto& drumkit : drumkits ) {
+		if ( drumkit.sName == sDrumkitName ) {
+			return Drumkit::load( drumkit.sPath, false );
+		}
+	}
+	return nullptr;
 }
 
 
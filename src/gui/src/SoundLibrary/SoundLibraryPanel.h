@@ -30,6 +30,7 @@
 #include <vector>
 
 #include <core/Object.h>
+#include <core/Helpers/DrumkitIndex.h>
 #include <core/Preferences/Preferences.h>
 
 #include "../Widgets/WidgetWithScalableFont.h"
@@ -100,12 +101,18 @@ private:
 	QTreeWidgetItem* __pattern_item;
 	QTreeWidgetItem* __pattern_item_list;
 
-	std::vector<H2Core::Drumkit*> __system_drumkit_info_list;
-	std::vector<H2Core::Drumkit*> __user_drumkit_info_list;
+	std::vector<H2Core::DrumkitIndex::Entry> __system_drumkit_info_list;
+	std::vector<H2Core::DrumkitIndex::Entry> __user_drumkit_info_list;
 	bool __expand_pattern_list;
 	bool __expand_songs_list;
 	void restore_background_color();
 	void change_background_color();
+	/** Loads the drumkit - without its samples - listed as
+	 * @a sDrumkitName in either the system or the user drumkit
+	 * tree. The caller takes ownership.
+	 *
+	 * \return nullptr if the drumkit could not be found.*/
+	H2Core::Drumkit* loadDrumkit( const QString& sDrumkitName, bool bSystemDrumkit ) const;
 
 	/** Whether the dialog was constructed via a click in the MainForm
 	 * or as part of the GUI.
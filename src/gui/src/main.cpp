@@ -29,6 +29,7 @@
 #include <core/Preferences/Theme.h>
 #include <getopt.h>
 
+#include "GuiBenchmark.h"
 #include "ShotList.h"
 #include "SplashScreen.h"
 #include "HydrogenApp.h"
@@ -237,6 +238,7 @@ int main(int argc, char *argv[])
 		QCommandLineOption verboseOption( QStringList() << "V" << "verbose", "Level, if present, may be None, Error, Warning, Info, Debug, Constructors, Locks, or 0xHHHH", "Level" );
 		QCommandLineOption shotListOption( QStringList() << "t" << "shotlist", "Shot list of widgets to grab", "ShotList" );
 		QCommandLineOption uiLayoutOption( QStringList() << "layout", "UI layout ('tabbed' or 'single')", "Layout" );
+		QCommandLineOption benchmarkOption( QStringList() << "benchmark", "Run the GUI benchmarks on a synthetic song and quit" );
 		
 		parser.addHelpOption();
 		parser.addVersionOption();
@@ -250,6 +252,7 @@ int main(int argc, char *argv[])
 		parser.addOption( verboseOption );
 		parser.addOption( shotListOption );
 		parser.addOption( uiLayoutOption );
+		parser.addOption( benchmarkOption );
 		parser.addPositionalArgument( "file", "Song, playlist or Drumkit file" );
 		
 		// Evaluate the options
@@ -264,6 +267,7 @@ int main(int argc, char *argv[])
 		QString sVerbosityString = parser.value( verboseOption );
 		QString sShotList = parser.value( shotListOption );
 		QString sUiLayout = parser.value( uiLayoutOption );
+		bool	bBenchmark = parser.isSet( benchmarkOption );
 		
 		unsigned logLevelOpt = H2Core::Logger::Error;
 		if( parser.isSet(verboseOption) ){
@@ -533,6 +537,12 @@ int main(int argc, char *argv[])
 			sl->shoot();
 		}
 
+		if ( bBenchmark ) {
+			// Start once the event loop is running and all widgets
+			// are laid out.
+			QTimer::singleShot( 0, &GuiBenchmark::run );
+		}
+
 		// All GUI setup is complete, any spurious widget-driven
 		// flagging of song modified state will be complete, so clear
 		// the modification flag. This does not apply in case we are
@@ -0,0 +1,111 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <core/Basics/Drumkit.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Helpers/DrumkitIndex.h>
+#include <core/Helpers/Filesystem.h>
+
+#include <QDir>
+#include <QFile>
+
+#include "TestHelper.h"
+
+using namespace H2Core;
+
+class DrumkitIndexTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( DrumkitIndexTest );
+	CPPUNIT_TEST( testWarmLookup );
+	CPPUNIT_TEST( testOutdatedEntry );
+	CPPUNIT_TEST_SUITE_END();
+
+	void testWarmLookup()
+	{
+		const QString sIndexPath = Filesystem::tmp_file_path( "drumkit_index.bin" );
+		const QString sDrumkitPath = H2TEST_FILE( "/drumkits/baseKit" );
+
+		Drumkit* pDrumkit = Drumkit::load( sDrumkitPath, false );
+		CPPUNIT_ASSERT( pDrumkit != nullptr );
+
+		{
+			DrumkitIndex index( sIndexPath );
+			DrumkitIndex::Entry entry;
+			CPPUNIT_ASSERT( index.getDrumkit( sDrumkitPath, &entry ) );
+			CPPUNIT_ASSERT( index.getDrumkit( sDrumkitPath, &entry ) );
+			CPPUNIT_ASSERT_EQUAL( 1, index.getParseCount() );
+			CPPUNIT_ASSERT( index.save() );
+		}
+
+		// A new index reads all entries from disk and does not parse
+		// the drumkit again.
+		DrumkitIndex index( sIndexPath );
+		DrumkitIndex::Entry entry;
+		CPPUNIT_ASSERT( index.getDrumkit( sDrumkitPath, &entry ) );
+		CPPUNIT_ASSERT_EQUAL( 0, index.getParseCount() );
+
+		CPPUNIT_ASSERT( entry.sName == pDrumkit->get_name() );
+		CPPUNIT_ASSERT( entry.sLicense == pDrumkit->get_license() );
+		CPPUNIT_ASSERT( entry.sImage == pDrumkit->get_image() );
+		CPPUNIT_ASSERT_EQUAL( static_cast<int>( pDrumkit->get_instruments()->size() ),
+							  entry.instruments.size() );
+		for ( int ii = 0; ii < entry.instruments.size(); ++ii ) {
+			CPPUNIT_ASSERT( entry.instruments[ ii ] ==
+							pDrumkit->get_instruments()->get( ii )->get_name() );
+		}
+
+		delete pDrumkit;
+		QFile::remove( sIndexPath );
+	}
+
+	void testOutdatedEntry()
+	{
+		const QString sIndexPath = Filesystem::tmp_file_path( "drumkit_index.bin" );
+		const QString sDrumkitPath = Filesystem::tmp_dir() + "/drumkitIndexTestKit";
+		QDir().mkpath( sDrumkitPath );
+		QFile::remove( Filesystem::drumkit_file( sDrumkitPath ) );
+		CPPUNIT_ASSERT( QFile::copy( Filesystem::drumkit_file( H2TEST_FILE( "/drumkits/baseKit" ) ),
+									 Filesystem::drumkit_file( sDrumkitPath ) ) );
+
+		DrumkitIndex index( sIndexPath );
+		DrumkitIndex::Entry entry;
+		CPPUNIT_ASSERT( index.getDrumkit( sDrumkitPath, &entry ) );
+		CPPUNIT_ASSERT_EQUAL( 1, index.getParseCount() );
+
+		// Altering the size of drumkit.xml invalidates the entry.
+		QFile file( Filesystem::drumkit_file( sDrumkitPath ) );
+		CPPUNIT_ASSERT( file.open( QIODevice::Append ) );
+		file.write( "\n" );
+		file.close();
+
+		CPPUNIT_ASSERT( index.getDrumkit( sDrumkitPath, &entry ) );
+		CPPUNIT_ASSERT_EQUAL( 2, index.getParseCount() );
+
+		// Removed kits are dropped.
+		QFile::remove( Filesystem::drumkit_file( sDrumkitPath ) );
+		CPPUNIT_ASSERT( ! index.getDrumkit( sDrumkitPath, &entry ) );
+
+		QDir( sDrumkitPath ).removeRecursively();
+		QFile::remove( sIndexPath );
+	}
+};
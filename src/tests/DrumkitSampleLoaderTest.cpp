@@ -0,0 +1,82 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <core/Basics/Drumkit.h>
+#include <core/Basics/DrumkitSampleLoader.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentComponent.h>
+#include <core/Basics/InstrumentLayer.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Basics/Sample.h>
+
+#include "TestHelper.h"
+
+using namespace H2Core;
+
+class DrumkitSampleLoaderTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( DrumkitSampleLoaderTest );
+	CPPUNIT_TEST( testParallelLoading );
+	CPPUNIT_TEST_SUITE_END();
+
+	void testParallelLoading()
+	{
+		Drumkit* pDrumkit = Drumkit::load( H2TEST_FILE( "/drumkits/baseKit" ), false );
+		CPPUNIT_ASSERT( pDrumkit != nullptr );
+
+		for ( const int nThreads : { 1, 4 } ) {
+			DrumkitSampleLoader loader( pDrumkit );
+			CPPUNIT_ASSERT( loader.size() > 0 );
+			loader.load( nThreads );
+
+			int nLayers = 0;
+			for ( const auto& pInstrument : *pDrumkit->get_instruments() ) {
+				for ( const auto& pComponent : *pInstrument->get_components() ) {
+					for ( int ii = 0; ii < InstrumentComponent::getMaxLayers(); ++ii ) {
+						auto pLayer = pComponent->get_layer( ii );
+						if ( pLayer == nullptr ) {
+							continue;
+						}
+						++nLayers;
+
+						auto pSample = loader.getSample( pLayer );
+						CPPUNIT_ASSERT( pSample != nullptr );
+						CPPUNIT_ASSERT( pSample->get_data_l() != nullptr );
+
+						// The samples of the drumkit itself are not
+						// touched.
+						CPPUNIT_ASSERT( pSample != pLayer->get_sample() );
+						CPPUNIT_ASSERT( pLayer->get_sample()->get_data_l() == nullptr );
+
+						auto pReference = Sample::load( pSample->get_filepath() );
+						CPPUNIT_ASSERT( pReference != nullptr );
+						CPPUNIT_ASSERT_EQUAL( pReference->get_frames(), pSample->get_frames() );
+					}
+				}
+			}
+			CPPUNIT_ASSERT_EQUAL( nLayers, loader.size() );
+		}
+
+		delete pDrumkit;
+	}
+};
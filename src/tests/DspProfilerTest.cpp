@@ -0,0 +1,156 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/AudioEngine/DspProfiler.h>
+
+using namespace H2Core;
+
+class DspProfilerTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( DspProfilerTest );
+	CPPUNIT_TEST( testXrunAttribution );
+	CPPUNIT_TEST( testRingOverflow );
+	CPPUNIT_TEST_SUITE_END();
+
+	typedef DspProfiler::Stage Stage;
+
+	/** Converts @a fUs into ticks of the clock of @a pProfiler.*/
+	static uint64_t ticks( DspProfiler* pProfiler, double fUs ) {
+		return static_cast<uint64_t>( fUs * 1e6 / pProfiler->ticksToUs( 1000000 ) );
+	}
+
+	static int index( Stage stage ) {
+		return static_cast<int>( stage );
+	}
+
+	void testXrunAttribution()
+	{
+		auto pProfiler = new DspProfiler();
+		const double fTolerance = 0.1;
+
+		// 48 frames at 48kHz leave a budget of 1 ms.
+		uint64_t nStart = 1000;
+		pProfiler->beginCycle( nStart, 48, 48000 );
+		pProfiler->addStage( Stage::LockWait, ticks( pProfiler, 10 ) );
+		pProfiler->addStage( Stage::Sampler, ticks( pProfiler, 300 ) );
+		pProfiler->addStage( Stage::Synth, ticks( pProfiler, 100 ) );
+		CPPUNIT_ASSERT( ! pProfiler->endCycle( nStart + ticks( pProfiler, 500 ) ) );
+
+		nStart += ticks( pProfiler, 1000 );
+		pProfiler->beginCycle( nStart, 48, 48000 );
+		pProfiler->addStage( Stage::LockWait, ticks( pProfiler, 50 ) );
+		pProfiler->addStage( Stage::Sampler, ticks( pProfiler, 200 ) );
+		pProfiler->addStage( Stage::Ladspa, ticks( pProfiler, 900 ) );
+		pProfiler->addLadspa( 0, ticks( pProfiler, 850 ) );
+		CPPUNIT_ASSERT( pProfiler->endCycle( nStart + ticks( pProfiler, 1200 ) ) );
+
+		// A missed buffer is an xrun even if the budget was not
+		// exceeded.
+		nStart += ticks( pProfiler, 2000 );
+		pProfiler->beginCycle( nStart, 48, 48000 );
+		pProfiler->addStage( Stage::LockWait, ticks( pProfiler, 20 ) );
+		CPPUNIT_ASSERT( pProfiler->endCycle( nStart + ticks( pProfiler, 30 ), true ) );
+
+		pProfiler->addInstrument( 3, ticks( pProfiler, 100 ) );
+		pProfiler->addInstrument( 3, ticks( pProfiler, 100 ) );
+		pProfiler->addInstrument( 5, ticks( pProfiler, 300 ) );
+		// Ids out of range are ignored.
+		pProfiler->addInstrument( -2, ticks( pProfiler, 1000 ) );
+
+		auto report = pProfiler->getReport();
+		CPPUNIT_ASSERT_EQUAL( 3LL, report.nCycles );
+		CPPUNIT_ASSERT_EQUAL( 2LL, report.nXruns );
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.nDroppedCycles );
+		CPPUNIT_ASSERT_EQUAL( 1LL, report.xrunsByStage[ index( Stage::Ladspa ) ] );
+		CPPUNIT_ASSERT_EQUAL( 1LL, report.xrunsByStage[ index( Stage::LockWait ) ] );
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.xrunsByStage[ index( Stage::Sampler ) ] );
+		CPPUNIT_ASSERT_EQUAL( index( Stage::LockWait ), report.nLastXrunStage );
+
+		const auto& sampler = report.stages[ index( Stage::Sampler ) ];
+		CPPUNIT_ASSERT_EQUAL( 2LL, sampler.nCount );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 250, sampler.getMeanUs(), fTolerance );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 300, sampler.fMaxUs, fTolerance );
+		// 200 us fall into [128, 256) and 300 us into [256, 512).
+		CPPUNIT_ASSERT_EQUAL( 1LL, sampler.buckets[ 7 ] );
+		CPPUNIT_ASSERT_EQUAL( 1LL, sampler.buckets[ 8 ] );
+
+		CPPUNIT_ASSERT_EQUAL( 3LL, report.stages[ index( Stage::LockWait ) ].nCount );
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.stages[ index( Stage::Metering ) ].nCount );
+		CPPUNIT_ASSERT_EQUAL( 3LL, report.stages[ index( Stage::Total ) ].nCount );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 1200, report.stages[ index( Stage::Total ) ].fMaxUs,
+									  fTolerance );
+		CPPUNIT_ASSERT_EQUAL( 1LL, report.ladspa[ 0 ].nCount );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 850, report.ladspa[ 0 ].fMaxUs, fTolerance );
+
+		CPPUNIT_ASSERT_EQUAL( size_t( 2 ), report.instruments.size() );
+		CPPUNIT_ASSERT_EQUAL( 5, report.instruments[ 0 ].first );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 300, report.instruments[ 0 ].second, fTolerance );
+		CPPUNIT_ASSERT_EQUAL( 3, report.instruments[ 1 ].first );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 200, report.instruments[ 1 ].second, fTolerance );
+
+		// Xruns of the driver are blamed on the most expensive stage
+		// of the last cycle.
+		pProfiler->reportDriverXrun();
+		report = pProfiler->getReport();
+		CPPUNIT_ASSERT_EQUAL( 3LL, report.nCycles );
+		CPPUNIT_ASSERT_EQUAL( 3LL, report.nXruns );
+		CPPUNIT_ASSERT_EQUAL( 2LL, report.xrunsByStage[ index( Stage::LockWait ) ] );
+
+		pProfiler->reset();
+		report = pProfiler->getReport();
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.nCycles );
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.nXruns );
+		CPPUNIT_ASSERT_EQUAL( -1, report.nLastXrunStage );
+		CPPUNIT_ASSERT( report.instruments.empty() );
+
+		delete pProfiler;
+	}
+
+	void testRingOverflow()
+	{
+		auto pProfiler = new DspProfiler();
+		const int nExtraCycles = 10;
+
+		uint64_t nStart = 0;
+		for ( int ii = 0; ii < DspProfiler::nRingSize + nExtraCycles; ++ii ) {
+			pProfiler->beginCycle( nStart, 1024, 48000 );
+			pProfiler->addStage( Stage::UpdateNoteQueue, ticks( pProfiler, 5 ) );
+			nStart += ticks( pProfiler, 10 );
+			pProfiler->endCycle( nStart );
+		}
+
+		auto report = pProfiler->getReport();
+		CPPUNIT_ASSERT_EQUAL( static_cast<long long>( DspProfiler::nRingSize ),
+							  report.nCycles );
+		CPPUNIT_ASSERT_EQUAL( static_cast<long long>( nExtraCycles ),
+							  report.nDroppedCycles );
+		CPPUNIT_ASSERT_EQUAL( 0LL, report.nXruns );
+
+		// The ring is usable again after being drained.
+		pProfiler->beginCycle( nStart, 1024, 48000 );
+		pProfiler->endCycle( nStart + ticks( pProfiler, 10 ) );
+		report = pProfiler->getReport();
+		CPPUNIT_ASSERT_EQUAL( static_cast<long long>( DspProfiler::nRingSize + 1 ),
+							  report.nCycles );
+
+		delete pProfiler;
+	}
+};
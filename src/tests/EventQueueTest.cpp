@@ -42,6 +42,8 @@ class EventQueueTest : public CppUnit::TestCase {
 	CPPUNIT_TEST( testPushPop );
 	CPPUNIT_TEST( testOverflow );
 	CPPUNIT_TEST( testThreadedAccess );
+	CPPUNIT_TEST( testDroppedEvents );
+	CPPUNIT_TEST( testCoalescing );
 	CPPUNIT_TEST_SUITE_END();
 
 	EventQueue *m_pQ;
@@ -62,6 +64,7 @@ public:
 
 	void tearDown() override {
 		EventQueue::get_instance()->setSilent( true );
+		EventQueue::get_instance()->setCoalescing( false );
 	}
 	
 	void testPushPop() {
@@ -134,6 +137,67 @@ public:
 		CPPUNIT_ASSERT( ev.type == EVENT_NONE );
 	}
 
+	void testDroppedEvents() {
+		m_pQ->setSilent( true );
+		const int nDroppedBefore = m_pQ->getDroppedEvents();
+
+		for ( int i = 0; i < MAX_EVENTS + 10; i++) {
+			m_pQ->push_event( EVENT_PROGRESS, i );
+		}
+		CPPUNIT_ASSERT_EQUAL( nDroppedBefore + 10, m_pQ->getDroppedEvents() );
+
+		Event ev;
+		do {
+			ev = m_pQ->pop_event();
+		} while ( ev.type != EVENT_NONE );
+	}
+
+	void testCoalescing() {
+		Event ev;
+		m_pQ->setCoalescing( true );
+
+		for ( int i = 0; i < 10; i++ ) {
+			m_pQ->push_event( EVENT_NOTEON, 3 );
+			m_pQ->push_event( EVENT_NOTEON, 4 );
+			m_pQ->push_event( EVENT_METRONOME, 1 );
+			m_pQ->push_event( EVENT_METRONOME, 0 );
+			m_pQ->push_event( EVENT_MIDI_ACTIVITY, -1 );
+			m_pQ->push_event( EVENT_PROGRESS, i );
+		}
+
+		// Redundant events are merged while all others are kept.
+		int nNoteOn = 0, nMetronome = 0, nMidiActivity = 0, nProgress = 0;
+		while ( ( ev = m_pQ->pop_event() ).type != EVENT_NONE ) {
+			switch ( ev.type ) {
+			case EVENT_NOTEON:
+				nNoteOn++;
+				break;
+			case EVENT_METRONOME:
+				nMetronome++;
+				break;
+			case EVENT_MIDI_ACTIVITY:
+				nMidiActivity++;
+				break;
+			case EVENT_PROGRESS:
+				CPPUNIT_ASSERT_EQUAL( nProgress, ev.value );
+				nProgress++;
+				break;
+			default:
+				CPPUNIT_FAIL( "Unexpected event" );
+			}
+		}
+		CPPUNIT_ASSERT_EQUAL( 2, nNoteOn );
+		CPPUNIT_ASSERT_EQUAL( 2, nMetronome );
+		CPPUNIT_ASSERT_EQUAL( 1, nMidiActivity );
+		CPPUNIT_ASSERT_EQUAL( 10, nProgress );
+
+		// Once drained, the same event can be queued again.
+		m_pQ->push_event( EVENT_NOTEON, 3 );
+		ev = m_pQ->pop_event();
+		CPPUNIT_ASSERT( ev.type == EVENT_NOTEON && ev.value == 3 );
+		CPPUNIT_ASSERT( m_pQ->pop_event().type == EVENT_NONE );
+	}
+
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION( EventQueueTest );
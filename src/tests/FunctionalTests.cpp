@@ -47,12 +47,16 @@
 
 #include <chrono>
 #include <memory>
+#include <vector>
+
+#include <sndfile.h>
 
 using namespace H2Core;
 
 class FunctionalTest : public CppUnit::TestCase {
 	CPPUNIT_TEST_SUITE( FunctionalTest );
 	CPPUNIT_TEST( testExportAudio );
+	CPPUNIT_TEST( testExportStemsAudio );
 	CPPUNIT_TEST( testExportMIDISMF0 );
 	CPPUNIT_TEST( testExportMIDISMF1Single );
 	CPPUNIT_TEST( testExportMIDISMF1Multi );
@@ -159,6 +163,51 @@ public:
 		Filesystem::rm( outFile );
 	}
 
+	void testExportStemsAudio()
+	{
+		auto songFile = H2TEST_FILE("functional/test.h2song");
+		auto outFile = Filesystem::tmp_file_path("test.wav");
+		auto refFile = H2TEST_FILE("functional/test.ref.flac");
+
+		std::vector<DiskWriterDriver::Stem> stems;
+		exportSong( songFile, outFile, &stems );
+		CPPUNIT_ASSERT( stems.size() > 1 );
+
+		// Rendering the stems must not alter the main mix.
+		H2TEST_ASSERT_AUDIO_FILES_EQUAL( refFile, outFile );
+
+		// The stems have to add up to the main mix. Each of them was
+		// quantized to 16 bit separately.
+		SF_INFO info = { 0 };
+		SNDFILE* pMainFile = sf_open( outFile.toLocal8Bit(), SFM_READ, &info );
+		CPPUNIT_ASSERT( pMainFile != nullptr );
+		std::vector<float> main( info.frames * info.channels );
+		CPPUNIT_ASSERT_EQUAL( info.frames, sf_readf_float( pMainFile, main.data(), info.frames ) );
+		sf_close( pMainFile );
+
+		std::vector<float> sum( main.size(), 0.0 );
+		for ( const auto& stem : stems ) {
+			SF_INFO stemInfo = { 0 };
+			SNDFILE* pStemFile = sf_open( stem.sFilename.toLocal8Bit(), SFM_READ, &stemInfo );
+			CPPUNIT_ASSERT( pStemFile != nullptr );
+			CPPUNIT_ASSERT_EQUAL( info.frames, stemInfo.frames );
+			std::vector<float> data( stemInfo.frames * stemInfo.channels );
+			sf_readf_float( pStemFile, data.data(), stemInfo.frames );
+			sf_close( pStemFile );
+			for ( int ii = 0; ii < static_cast<int>( data.size() ); ++ii ) {
+				sum[ ii ] += data[ ii ];
+			}
+			Filesystem::rm( stem.sFilename );
+		}
+
+		const float fTolerance = stems.size() * 2.0 / 32768.0;
+		for ( int ii = 0; ii < static_cast<int>( main.size() ); ++ii ) {
+			CPPUNIT_ASSERT_DOUBLES_EQUAL( main[ ii ], sum[ ii ], fTolerance );
+		}
+
+		Filesystem::rm( outFile );
+	}
+
 	void testExportMIDISMF1Single()
 	{
 		auto songFile = H2TEST_FILE("functional/test.h2song");
@@ -249,8 +298,11 @@ private:
 	 * \brief Export Hydrogon song to audio file
 	 * \param songFile Path to Hydrogen file
 	 * \param fileName Output file name
+	 * \param pStems If not nullptr, the stems of all instruments
+	 * are exported as well and stored in here.
 	 **/
-	void exportSong( const QString &songFile, const QString &fileName )
+	void exportSong( const QString &songFile, const QString &fileName,
+					 std::vector<DiskWriterDriver::Stem>* pStems = nullptr )
 	{
 		auto t0 = std::chrono::high_resolution_clock::now();
 
@@ -271,8 +323,14 @@ private:
 			pInstrumentList->get(i)->set_currently_exported( true );
 		}
 
+		std::vector<DiskWriterDriver::Stem> stems;
+		if ( pStems != nullptr ) {
+			stems = pHydrogen->getExportStems( fileName );
+			*pStems = stems;
+		}
+
 		pHydrogen->startExportSession( 44100, 16 );
-		pHydrogen->startExportSong( fileName );
+		pHydrogen->startExportSong( fileName, stems );
 
 		bool done = false;
 		while ( ! done ) {
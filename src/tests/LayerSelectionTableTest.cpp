@@ -0,0 +1,172 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/Basics/InstrumentLayer.h>
+#include <core/Basics/LayerSelectionTable.h>
+
+#include <memory>
+#include <set>
+#include <vector>
+
+using namespace H2Core;
+
+class LayerSelectionTableTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( LayerSelectionTableTest );
+	CPPUNIT_TEST( testVelocity );
+	CPPUNIT_TEST( testHoles );
+	CPPUNIT_TEST( testGapBetweenLayers );
+	CPPUNIT_TEST( testRoundRobin );
+	CPPUNIT_TEST( testRandom );
+	CPPUNIT_TEST_SUITE_END();
+
+	static std::shared_ptr<InstrumentLayer> makeLayer( float fStart, float fEnd ) {
+		auto pLayer = std::make_shared<InstrumentLayer>( nullptr );
+		pLayer->set_start_velocity( fStart );
+		pLayer->set_end_velocity( fEnd );
+		return pLayer;
+	}
+
+	/** Brute force reference of the candidates matching a velocity.*/
+	static std::vector<int> reference( const std::vector<std::shared_ptr<InstrumentLayer>>& layers,
+									   float fVelocity ) {
+		std::vector<int> candidates;
+		for ( int ii = 0; ii < static_cast<int>( layers.size() ); ++ii ) {
+			if ( layers[ ii ] != nullptr &&
+				 fVelocity >= layers[ ii ]->get_start_velocity() &&
+				 fVelocity <= layers[ ii ]->get_end_velocity() ) {
+				candidates.push_back( ii );
+			}
+		}
+		return candidates;
+	}
+
+	void testVelocity()
+	{
+		std::vector<std::shared_ptr<InstrumentLayer>> layers = {
+			makeLayer( 0.0, 0.25 ), nullptr, makeLayer( 0.25, 0.8 ),
+			makeLayer( 0.5, 1.0 ), makeLayer( 0.8, 1.0 ), nullptr };
+		LayerSelectionTable table;
+		table.update( layers );
+
+		for ( int nn = 0; nn <= 1000; ++nn ) {
+			const float fVelocity = static_cast<float>( nn ) / 1000;
+			const auto candidates = reference( layers, fVelocity );
+			CPPUNIT_ASSERT( ! candidates.empty() );
+			CPPUNIT_ASSERT_EQUAL( static_cast<int>( candidates.size() ),
+								  table.getCandidateCount( fVelocity ) );
+			CPPUNIT_ASSERT_EQUAL( candidates[ 0 ],
+								  table.select( fVelocity, LayerSelectionTable::Mode::Velocity ) );
+		}
+		for ( const float fVelocity : { 0.25f, 0.5f, 0.8f, 1.0f } ) {
+			CPPUNIT_ASSERT_EQUAL( reference( layers, fVelocity )[ 0 ],
+								  table.select( fVelocity, LayerSelectionTable::Mode::Velocity ) );
+		}
+
+		table.update( {} );
+		CPPUNIT_ASSERT_EQUAL( -1, table.select( 0.5, LayerSelectionTable::Mode::Velocity ) );
+	}
+
+	void testHoles()
+	{
+		std::vector<std::shared_ptr<InstrumentLayer>> layers = {
+			makeLayer( 0.2, 0.4 ), makeLayer( 0.7, 0.9 ) };
+		LayerSelectionTable table;
+		table.update( layers );
+
+		bool bHole = false;
+		CPPUNIT_ASSERT_EQUAL( 0, table.select( 0.3, LayerSelectionTable::Mode::Velocity, &bHole ) );
+		CPPUNIT_ASSERT( ! bHole );
+		CPPUNIT_ASSERT_EQUAL( 0, table.select( 0.1, LayerSelectionTable::Mode::Velocity, &bHole ) );
+		CPPUNIT_ASSERT( bHole );
+		CPPUNIT_ASSERT_EQUAL( 0, table.getCandidateCount( 0.1 ) );
+		CPPUNIT_ASSERT_EQUAL( 1, table.select( 0.95, LayerSelectionTable::Mode::Velocity, &bHole ) );
+		CPPUNIT_ASSERT( bHole );
+	}
+
+	void testGapBetweenLayers()
+	{
+		// The gap (0.4, 0.7) is split at 0.55. The lower half is
+		// assigned the layer below, the upper half - including the
+		// midpoint itself - the layer above.
+		std::vector<std::shared_ptr<InstrumentLayer>> layers = {
+			makeLayer( 0.7, 0.9 ), makeLayer( 0.2, 0.4 ), makeLayer( 0.7, 0.9 ) };
+		LayerSelectionTable table;
+		table.update( layers );
+
+		bool bHole = false;
+		for ( const float fVelocity : { 0.41f, 0.5f, 0.54f } ) {
+			CPPUNIT_ASSERT_EQUAL( 1, table.select( fVelocity, LayerSelectionTable::Mode::Velocity,
+												   &bHole ) );
+			CPPUNIT_ASSERT( bHole );
+		}
+		for ( const float fVelocity : { 0.55f, 0.6f, 0.69f } ) {
+			CPPUNIT_ASSERT_EQUAL( 0, table.select( fVelocity, LayerSelectionTable::Mode::Velocity,
+												   &bHole ) );
+			CPPUNIT_ASSERT( bHole );
+			CPPUNIT_ASSERT_EQUAL( 0, table.getCandidateCount( fVelocity ) );
+		}
+
+		// Both layers starting above the gap take turns.
+		std::set<int> picked;
+		for ( int nn = 0; nn < 4; ++nn ) {
+			picked.insert( table.select( 0.6, LayerSelectionTable::Mode::RoundRobin ) );
+		}
+		CPPUNIT_ASSERT( picked == std::set<int>( { 0, 2 } ) );
+
+		// The boundaries of the layers are not affected.
+		CPPUNIT_ASSERT_EQUAL( 1, table.select( 0.4, LayerSelectionTable::Mode::Velocity, &bHole ) );
+		CPPUNIT_ASSERT( ! bHole );
+		CPPUNIT_ASSERT_EQUAL( 0, table.select( 0.7, LayerSelectionTable::Mode::Velocity, &bHole ) );
+		CPPUNIT_ASSERT( ! bHole );
+	}
+
+	void testRoundRobin()
+	{
+		std::vector<std::shared_ptr<InstrumentLayer>> layers = {
+			makeLayer( 0.0, 1.0 ), makeLayer( 0.0, 1.0 ), makeLayer( 0.0, 1.0 ) };
+		LayerSelectionTable table;
+		table.update( layers );
+
+		// Matches the cycling of the previous implementation which
+		// started with the second layer.
+		for ( const int nExpected : { 1, 2, 0, 1, 2, 0 } ) {
+			CPPUNIT_ASSERT_EQUAL( nExpected,
+								  table.select( 0.6, LayerSelectionTable::Mode::RoundRobin ) );
+		}
+	}
+
+	void testRandom()
+	{
+		std::vector<std::shared_ptr<InstrumentLayer>> layers = {
+			makeLayer( 0.0, 0.5 ), makeLayer( 0.0, 1.0 ),
+			makeLayer( 0.0, 1.0 ), makeLayer( 0.6, 1.0 ) };
+		LayerSelectionTable table;
+		table.update( layers );
+
+		std::set<int> picked;
+		for ( int nn = 0; nn < 200; ++nn ) {
+			picked.insert( table.select( 0.3, LayerSelectionTable::Mode::Random ) );
+		}
+		CPPUNIT_ASSERT( picked == std::set<int>( { 0, 1, 2 } ) );
+	}
+};
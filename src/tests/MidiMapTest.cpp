@@ -0,0 +1,104 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/Basics/Song.h>
+#include <core/Hydrogen.h>
+#include <core/MidiAction.h>
+#include <core/MidiMap.h>
+
+using namespace H2Core;
+
+class MidiMapTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( MidiMapTest );
+	CPPUNIT_TEST( testActionTable );
+	CPPUNIT_TEST( testCCDispatch );
+	CPPUNIT_TEST_SUITE_END();
+
+	void tearDown() override {
+		MidiMap::reset_instance();
+	}
+
+	void testActionTable()
+	{
+		auto pMidiMap = MidiMap::get_instance();
+		auto pManager = MidiActionManager::get_instance();
+		MidiMap::reset_instance();
+
+		auto pMute = std::make_shared<Action>( "MUTE_TOGGLE" );
+		auto pVolume = std::make_shared<Action>( "MASTER_VOLUME_ABSOLUTE" );
+		auto pUnknown = std::make_shared<Action>( "NOT_AN_ACTION" );
+		pMidiMap->registerNoteEvent( 36, pMute );
+		pMidiMap->registerNoteEvent( 36, pUnknown );
+		pMidiMap->registerCCEvent( 7, pVolume );
+		pMidiMap->registerPCEvent( pMute );
+
+		{
+			MidiMap::ActionTableReader pTable( pMidiMap );
+			CPPUNIT_ASSERT_EQUAL( size_t( 2 ), pTable->noteBindings[ 36 ].size() );
+			CPPUNIT_ASSERT( pTable->noteBindings[ 37 ].empty() );
+			CPPUNIT_ASSERT_EQUAL( size_t( 1 ), pTable->ccBindings[ 7 ].size() );
+			// The default "NOTHING" program change action is omitted.
+			CPPUNIT_ASSERT_EQUAL( size_t( 1 ), pTable->pcBindings.size() );
+
+			const auto& muteBinding = pTable->noteBindings[ 36 ][ 0 ];
+			CPPUNIT_ASSERT( muteBinding.pAction == pMute );
+			CPPUNIT_ASSERT_EQUAL( pManager->resolveAction( "MUTE_TOGGLE" ),
+								  muteBinding.nHandler );
+			CPPUNIT_ASSERT( muteBinding.nHandler >= 0 );
+			CPPUNIT_ASSERT_EQUAL( -1, pTable->noteBindings[ 36 ][ 1 ].nHandler );
+			CPPUNIT_ASSERT( pTable->ccBindings[ 7 ][ 0 ].pAction == pVolume );
+
+			// Changing the map while a reader is active must not
+			// alter the table it is holding.
+			pMidiMap->reset();
+			CPPUNIT_ASSERT_EQUAL( size_t( 2 ), pTable->noteBindings[ 36 ].size() );
+		}
+
+		MidiMap::ActionTableReader pTable( pMidiMap );
+		CPPUNIT_ASSERT( pTable->noteBindings[ 36 ].empty() );
+		CPPUNIT_ASSERT( pTable->ccBindings[ 7 ].empty() );
+		CPPUNIT_ASSERT( pTable->pcBindings.empty() );
+	}
+
+	void testCCDispatch()
+	{
+		auto pHydrogen = Hydrogen::get_instance();
+		auto pManager = MidiActionManager::get_instance();
+		pHydrogen->setSong( Song::getEmptySong() );
+		MidiMap::reset_instance();
+
+		auto pVolume = std::make_shared<Action>( "MASTER_VOLUME_ABSOLUTE" );
+		MidiMap::get_instance()->registerCCEvent( 7, pVolume );
+
+		CPPUNIT_ASSERT( pManager->handleCCActions( 7, 127 ) );
+		CPPUNIT_ASSERT_EQUAL( 127, pVolume->getIntValue() );
+		CPPUNIT_ASSERT_EQUAL( QString( "127" ), pVolume->getValue() );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 1.5, pHydrogen->getSong()->getVolume(), 1e-5 );
+
+		CPPUNIT_ASSERT( pManager->handleCCActions( 7, 0 ) );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.0, pHydrogen->getSong()->getVolume(), 1e-5 );
+
+		// Unmapped and out of range parameters.
+		CPPUNIT_ASSERT( pManager->handleCCActions( 8, 64 ) );
+		CPPUNIT_ASSERT( ! pManager->handleCCActions( 128, 64 ) );
+	}
+};
@@ -0,0 +1,132 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/AudioEngine/NotePool.h>
+#include <core/Basics/Instrument.h>
+
+#include <thread>
+#include <vector>
+
+using namespace H2Core;
+
+class NotePoolTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( NotePoolTest );
+	CPPUNIT_TEST( testCreateRelease );
+	CPPUNIT_TEST( testExhaustion );
+	CPPUNIT_TEST( testForeignNote );
+	CPPUNIT_TEST( testConcurrentAccess );
+	CPPUNIT_TEST_SUITE_END();
+
+	void testCreateRelease()
+	{
+		NotePool pool( 4 );
+		auto pInstr = std::make_shared<Instrument>( 1, "Kick", nullptr );
+
+		Note* pNote = pool.create( pInstr, 12, 0.5f, 0.f, -1, 0.f );
+		CPPUNIT_ASSERT( pNote != nullptr );
+		CPPUNIT_ASSERT( pool.owns( pNote ) );
+		CPPUNIT_ASSERT_EQUAL( 1, pool.getUsed() );
+		CPPUNIT_ASSERT_EQUAL( 12, pNote->get_position() );
+		CPPUNIT_ASSERT_EQUAL( 0.5f, pNote->get_velocity() );
+
+		Note* pCopy = pool.create( pNote );
+		CPPUNIT_ASSERT( pCopy != nullptr );
+		CPPUNIT_ASSERT( pCopy != pNote );
+		CPPUNIT_ASSERT_EQUAL( 12, pCopy->get_position() );
+		CPPUNIT_ASSERT_EQUAL( 2, pool.getUsed() );
+
+		pool.release( pNote );
+		pool.release( pCopy );
+		CPPUNIT_ASSERT_EQUAL( 0, pool.getUsed() );
+	}
+
+	void testExhaustion()
+	{
+		const int nCapacity = 8;
+		NotePool pool( nCapacity );
+		std::vector<Note*> notes;
+
+		for ( int ii = 0; ii < nCapacity; ++ii ) {
+			Note* pNote = pool.create( nullptr, ii, 1.0f, 0.f, -1, 0.f );
+			CPPUNIT_ASSERT( pNote != nullptr );
+			notes.push_back( pNote );
+		}
+		CPPUNIT_ASSERT_EQUAL( nCapacity, pool.getUsed() );
+
+		// No fallback to the heap.
+		CPPUNIT_ASSERT( pool.create( nullptr, 0, 1.0f, 0.f, -1, 0.f ) == nullptr );
+		CPPUNIT_ASSERT_EQUAL( 1, pool.getExhaustedCount() );
+
+		// Slots can be reused after a release.
+		pool.release( notes.back() );
+		notes.pop_back();
+		Note* pNote = pool.create( nullptr, 0, 1.0f, 0.f, -1, 0.f );
+		CPPUNIT_ASSERT( pNote != nullptr );
+		notes.push_back( pNote );
+
+		for ( auto& ppNote : notes ) {
+			pool.release( ppNote );
+		}
+		CPPUNIT_ASSERT_EQUAL( 0, pool.getUsed() );
+	}
+
+	void testForeignNote()
+	{
+		NotePool pool( 2 );
+
+		Note* pNote = new Note( nullptr, 0, 1.0f, 0.f, -1, 0.f );
+		CPPUNIT_ASSERT( ! pool.owns( pNote ) );
+
+		// Notes allocated on the heap are deleted instead.
+		pool.release( pNote );
+		CPPUNIT_ASSERT_EQUAL( 0, pool.getUsed() );
+	}
+
+	void testConcurrentAccess()
+	{
+		const int nThreads = 4;
+		const int nIterations = 10000;
+		NotePool pool( nThreads * 2 );
+
+		auto worker = [&]() {
+			for ( int ii = 0; ii < nIterations; ++ii ) {
+				Note* pFirst = pool.create( nullptr, ii, 1.0f, 0.f, -1, 0.f );
+				Note* pSecond = pool.create( nullptr, ii, 1.0f, 0.f, -1, 0.f );
+				CPPUNIT_ASSERT( pFirst != nullptr && pSecond != nullptr );
+				CPPUNIT_ASSERT( pFirst != pSecond );
+				pool.release( pSecond );
+				pool.release( pFirst );
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for ( int ii = 0; ii < nThreads; ++ii ) {
+			threads.emplace_back( worker );
+		}
+		for ( auto& thread : threads ) {
+			thread.join();
+		}
+
+		CPPUNIT_ASSERT_EQUAL( 0, pool.getUsed() );
+		CPPUNIT_ASSERT_EQUAL( 0, pool.getExhaustedCount() );
+	}
+};
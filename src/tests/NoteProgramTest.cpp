@@ -0,0 +1,154 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/AudioEngine/NoteProgram.h>
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace H2Core;
+
+class NoteProgramTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( NoteProgramTest );
+	CPPUNIT_TEST( testMatchesPatterns );
+	CPPUNIT_TEST( testRelocation );
+	CPPUNIT_TEST_SUITE_END();
+
+	static void addNote( Pattern* pPattern, int nPosition ) {
+		pPattern->insert_note( new Note( nullptr, nPosition, 1.0f, 0.f, -1, 0.f ) );
+	}
+
+	/** Notes at @a nTick as visited by the former per-pattern lookup
+	 * in AudioEngine::updateNoteQueue().*/
+	static std::vector<Note*> reference( PatternList* pPatterns, int nTick ) {
+		std::vector<Note*> notes;
+		for ( const auto& ppPattern : *pPatterns ) {
+			FOREACH_NOTE_CST_IT_BOUND( ppPattern->get_notes(), it, nTick ) {
+				notes.push_back( it->second );
+			}
+		}
+		return notes;
+	}
+
+	static std::vector<Note*> visit( NoteProgram* pProgram, int nTick ) {
+		std::vector<Note*> notes;
+		pProgram->forEachNoteAt( nTick, [&]( Note* pNote ) {
+			notes.push_back( pNote ); } );
+		return notes;
+	}
+
+	void testMatchesPatterns()
+	{
+		PatternList patterns;
+		std::srand( 42 );
+		for ( int ii = 0; ii < 8; ++ii ) {
+			auto pPattern = new Pattern( QString( "pattern %1" ).arg( ii ) );
+			for ( int nn = 0; nn < 50; ++nn ) {
+				// Coarse positions to get plenty of notes sharing a
+				// tick.
+				addNote( pPattern, 12 * ( std::rand() % 16 ) );
+			}
+			patterns.add( pPattern );
+		}
+
+		NoteProgram program( 16 );
+		CPPUNIT_ASSERT( ! program.isValid() );
+		program.compile( &patterns );
+		CPPUNIT_ASSERT( program.isValid() );
+		CPPUNIT_ASSERT_EQUAL( 400, program.size() );
+
+		for ( int nTick = 0; nTick < MAX_NOTES; ++nTick ) {
+			CPPUNIT_ASSERT( visit( &program, nTick ) == reference( &patterns, nTick ) );
+		}
+
+		// Pattern loops back to its start.
+		for ( int nTick = 0; nTick < MAX_NOTES; ++nTick ) {
+			CPPUNIT_ASSERT( visit( &program, nTick ) == reference( &patterns, nTick ) );
+		}
+
+		program.invalidate();
+		CPPUNIT_ASSERT( ! program.isValid() );
+
+		// Compiling must not allocate once enough memory is reserved.
+		program.reserve( 1000 );
+		const int nCapacity = program.capacity();
+		CPPUNIT_ASSERT( nCapacity >= 1000 );
+		program.compile( &patterns );
+		CPPUNIT_ASSERT_EQUAL( nCapacity, program.capacity() );
+	}
+
+	void testRelocation()
+	{
+		PatternList patterns;
+		auto pPattern = new Pattern();
+		auto pVirtualPattern = new Pattern();
+		for ( const auto& nPosition : { 0, 24, 48, 48, 96, 180 } ) {
+			addNote( pPattern, nPosition );
+		}
+		for ( const auto& nPosition : { 48, 96, 97 } ) {
+			addNote( pVirtualPattern, nPosition );
+		}
+		patterns.add( pPattern );
+		patterns.add( pVirtualPattern );
+
+		NoteProgram program;
+		program.compile( &patterns );
+		CPPUNIT_ASSERT_EQUAL( 9, program.size() );
+
+		// Jump forward, backward, and to ticks without notes.
+		for ( const auto& nTick : { 48, 96, 24, 24, 180, 0, 97, 47, 48, 200, 96 } ) {
+			const auto notes = visit( &program, nTick );
+			CPPUNIT_ASSERT( notes == reference( &patterns, nTick ) );
+			for ( const auto& ppNote : notes ) {
+				CPPUNIT_ASSERT_EQUAL( nTick, ppNote->get_position() );
+			}
+		}
+		CPPUNIT_ASSERT_EQUAL( size_t( 3 ), visit( &program, 48 ).size() );
+
+		// Notes added afterwards are only picked up after
+		// recompiling.
+		CPPUNIT_ASSERT( program.isValid() );
+		addNote( pPattern, 48 );
+		CPPUNIT_ASSERT( ! program.isValid() );
+		CPPUNIT_ASSERT_EQUAL( size_t( 3 ), visit( &program, 48 ).size() );
+		program.compile( &patterns );
+		CPPUNIT_ASSERT( program.isValid() );
+		CPPUNIT_ASSERT_EQUAL( size_t( 4 ), visit( &program, 48 ).size() );
+		CPPUNIT_ASSERT( visit( &program, 48 ) == reference( &patterns, 48 ) );
+
+		// Removing notes invalidates the program as well.
+		auto pRemovedNote = visit( &program, 180 ).front();
+		pPattern->remove_note( pRemovedNote );
+		delete pRemovedNote;
+		CPPUNIT_ASSERT( ! program.isValid() );
+		program.compile( &patterns );
+		CPPUNIT_ASSERT( program.isValid() );
+		CPPUNIT_ASSERT( visit( &program, 180 ).empty() );
+
+		program.compile( nullptr );
+		CPPUNIT_ASSERT_EQUAL( 0, program.size() );
+		CPPUNIT_ASSERT( visit( &program, 48 ).empty() );
+	}
+};
@@ -0,0 +1,116 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/AudioEngine/NoteQueue.h>
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace H2Core;
+
+class NoteQueueTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( NoteQueueTest );
+	CPPUNIT_TEST( testOrdering );
+	CPPUNIT_TEST( testStableTies );
+	CPPUNIT_TEST( testUpdateAll );
+	CPPUNIT_TEST_SUITE_END();
+
+	std::vector<std::unique_ptr<Note>> createNotes( const std::vector<int>& positions ) {
+		std::vector<std::unique_ptr<Note>> notes;
+		for ( const auto& nPosition : positions ) {
+			auto pNote = std::make_unique<Note>( nullptr, nPosition, 1.0f, 0.f, -1, 0.f );
+			pNote->computeNoteStart();
+			notes.push_back( std::move( pNote ) );
+		}
+		return notes;
+	}
+
+	void testOrdering()
+	{
+		std::vector<int> positions;
+		std::srand( 42 );
+		for ( int ii = 0; ii < 500; ++ii ) {
+			positions.push_back( 1 + std::rand() % 1000 );
+		}
+		auto notes = createNotes( positions );
+
+		NoteQueue queue( 16 );
+		for ( const auto& pNote : notes ) {
+			queue.push( pNote.get() );
+		}
+		CPPUNIT_ASSERT_EQUAL( static_cast<int>( notes.size() ), queue.size() );
+
+		long long nLastStart = -1;
+		while ( ! queue.empty() ) {
+			CPPUNIT_ASSERT( queue.top()->getNoteStart() >= nLastStart );
+			nLastStart = queue.top()->getNoteStart();
+			queue.pop();
+		}
+		CPPUNIT_ASSERT( queue.top() == nullptr );
+	}
+
+	void testStableTies()
+	{
+		auto notes = createNotes( { 96, 48, 96, 48, 96, 48, 96, 48, 96 } );
+
+		NoteQueue queue;
+		for ( const auto& pNote : notes ) {
+			queue.push( pNote.get() );
+		}
+
+		// Notes with the same start have to be returned in the order
+		// they were pushed.
+		std::vector<Note*> expected = { notes[ 1 ].get(), notes[ 3 ].get(),
+			notes[ 5 ].get(), notes[ 7 ].get(), notes[ 0 ].get(), notes[ 2 ].get(),
+			notes[ 4 ].get(), notes[ 6 ].get(), notes[ 8 ].get() };
+		for ( const auto& pNote : expected ) {
+			CPPUNIT_ASSERT( queue.top() == pNote );
+			queue.pop();
+		}
+		CPPUNIT_ASSERT( queue.empty() );
+	}
+
+	void testUpdateAll()
+	{
+		auto notes = createNotes( { 10, 20, 30, 40, 50 } );
+
+		NoteQueue queue;
+		for ( const auto& pNote : notes ) {
+			queue.push( pNote.get() );
+		}
+		CPPUNIT_ASSERT( queue.top() == notes[ 0 ].get() );
+
+		// Reverse the order of all notes.
+		queue.updateAll( []( Note* pNote ) {
+			pNote->set_position( 60 - pNote->get_position() );
+			pNote->computeNoteStart();
+		} );
+
+		for ( int ii = notes.size() - 1; ii >= 0; --ii ) {
+			CPPUNIT_ASSERT( queue.top() == notes[ ii ].get() );
+			queue.pop();
+		}
+		CPPUNIT_ASSERT( queue.empty() );
+	}
+};
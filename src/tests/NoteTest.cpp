@@ -23,6 +23,7 @@
 #include <cppunit/extensions/HelperMacros.h>
 #include <core/Basics/Note.h>
 #include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentComponent.h>
 #include <core/Basics/InstrumentList.h>
 #include <core/Helpers/Xml.h>
 #include <QDomDocument>
@@ -33,6 +34,7 @@ class NoteTest : public CppUnit::TestCase {
 	CPPUNIT_TEST_SUITE( NoteTest );
 	CPPUNIT_TEST( testProbability );
 	CPPUNIT_TEST( testSerializeProbability );
+	CPPUNIT_TEST( testLayerSelection );
 	CPPUNIT_TEST_SUITE_END();
 
 	void testProbability()
@@ -77,5 +79,49 @@ class NoteTest : public CppUnit::TestCase {
 		delete snare;
 		*/
 	}
+
+	void testLayerSelection()
+	{
+		auto pInstr = std::make_shared<Instrument>( 1, "Kick", nullptr );
+		pInstr->get_components()->push_back( std::make_shared<InstrumentComponent>( 0 ) );
+		pInstr->get_components()->push_back( std::make_shared<InstrumentComponent>( 3 ) );
+		pInstr->get_adsr()->set_attack( 123 );
+
+		Note note( pInstr, 0, 1.0f, 0.f, -1, 0.f );
+		CPPUNIT_ASSERT_EQUAL( 2, note.get_layer_selected_count() );
+		CPPUNIT_ASSERT_EQUAL( 123u, note.get_adsr()->get_attack() );
+
+		auto pLayerInfo = note.get_layer_selected( 3 );
+		CPPUNIT_ASSERT( pLayerInfo != nullptr );
+		CPPUNIT_ASSERT_EQUAL( -1, pLayerInfo->SelectedLayer );
+		pLayerInfo->SelectedLayer = 2;
+		pLayerInfo->SamplePosition = 42.5;
+		CPPUNIT_ASSERT( note.isPartiallyRendered() );
+
+		// Looking up an unknown component must not add an entry.
+		CPPUNIT_ASSERT( note.get_layer_selected( 1 ) == nullptr );
+		CPPUNIT_ASSERT_EQUAL( 2, note.get_layer_selected_count() );
+
+		// Copies carry the layer selection and playback position but
+		// neither share them nor the envelope with the original.
+		Note copy( &note, nullptr );
+		CPPUNIT_ASSERT_EQUAL( 2, copy.get_layer_selected_count() );
+		CPPUNIT_ASSERT_EQUAL( 2, copy.get_layer_selected( 3 )->SelectedLayer );
+		CPPUNIT_ASSERT_EQUAL( 42.5f, copy.get_layer_selected( 3 )->SamplePosition );
+		CPPUNIT_ASSERT( copy.get_layer_selected( 3 ) != pLayerInfo );
+		CPPUNIT_ASSERT( copy.get_adsr() != note.get_adsr() );
+		CPPUNIT_ASSERT_EQUAL( 123u, copy.get_adsr()->get_attack() );
+
+		// Notes bound to their instrument after construction - like
+		// the ones read from a pattern file - get the same state.
+		InstrumentList instruments;
+		instruments.add( pInstr );
+		Note mapped( nullptr, 0, 1.0f, 0.f, -1, 0.f );
+		mapped.set_instrument_id( 1 );
+		mapped.map_instrument( &instruments );
+		CPPUNIT_ASSERT_EQUAL( 2, mapped.get_layer_selected_count() );
+		CPPUNIT_ASSERT( mapped.get_layer_selected( 3 ) != nullptr );
+		CPPUNIT_ASSERT_EQUAL( 123u, mapped.get_adsr()->get_attack() );
+	}
 };
 
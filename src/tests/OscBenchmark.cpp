@@ -0,0 +1,122 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include "OscBenchmark.h"
+
+#ifdef H2CORE_HAVE_OSC
+
+#include <core/OscServer.h>
+
+#include <QRegExp>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+#include <chrono>
+#include <vector>
+
+bool OscBenchmark::bEnabled = false;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( OscBenchmark );
+
+/** Paths typically sent by a control surface moving its faders. */
+static const std::vector<QByteArray> messagePaths() {
+	std::vector<QByteArray> paths;
+	for ( int ii = 1; ii <= 16; ++ii ) {
+		paths.push_back( QString( "/Hydrogen/STRIP_VOLUME_ABSOLUTE/%1" ).arg( ii ).toLatin1() );
+		paths.push_back( QString( "/Hydrogen/PAN_ABSOLUTE/%1" ).arg( ii ).toLatin1() );
+		paths.push_back( QString( "/Hydrogen/FILTER_CUTOFF_LEVEL_ABSOLUTE/%1" ).arg( ii ).toLatin1() );
+	}
+	paths.push_back( "/Hydrogen/MASTER_VOLUME_ABSOLUTE" );
+	paths.push_back( "/Hydrogen/PLAY" );
+	paths.push_back( "/Hydrogen/BPM" );
+	return paths;
+}
+
+/** Matching done for every message prior to the dispatch table. */
+static int matchRegExp( const char* sPath ) {
+	static const QStringList patterns = {
+		"/Hydrogen/STRIP_VOLUME_ABSOLUTE/(\\d+)",
+		"/Hydrogen/STRIP_VOLUME_RELATIVE/(\\d+)",
+		"/Hydrogen/PAN_ABSOLUTE/(\\d+)",
+		"/Hydrogen/PAN_ABSOLUTE_SYM/(\\d+)",
+		"/Hydrogen/PAN_RELATIVE/(\\d+)",
+		"/Hydrogen/FILTER_CUTOFF_LEVEL_ABSOLUTE/(\\d+)",
+		"/Hydrogen/STRIP_MUTE_TOGGLE/(\\d+)",
+		"/Hydrogen/STRIP_SOLO_TOGGLE/(\\d+)" };
+
+	QString oscPath( sPath );
+	int nStrip = -1;
+	for ( const auto& sPattern : patterns ) {
+		QRegExp rx( sPattern );
+		if ( rx.indexIn( oscPath ) > -1 ) {
+			nStrip = rx.cap( 1 ).toInt();
+		}
+	}
+	return nStrip;
+}
+
+template <typename F>
+static double messagesPerSecond( const std::vector<QByteArray>& paths, int nRounds, F match ) {
+	long long nChecksum = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for ( int nn = 0; nn < nRounds; ++nn ) {
+		for ( const auto& sPath : paths ) {
+			nChecksum += match( sPath.constData() );
+		}
+	}
+	const std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - start;
+
+	// Keep the compiler from removing the loop.
+	CPPUNIT_ASSERT( nChecksum != 0 );
+
+	return static_cast<double>( paths.size() ) * nRounds / elapsed.count();
+}
+
+void OscBenchmark::oscBenchmark()
+{
+	if ( ! bEnabled ) {
+		return;
+	}
+
+	const auto paths = messagePaths();
+
+	// Build the table before measuring.
+	int nStrip;
+	OscServer::lookupPath( paths[ 0 ].constData(), &nStrip );
+
+	const double fTable = messagesPerSecond( paths, 20000, []( const char* sPath ) {
+		int nStrip;
+		const auto pCommand = OscServer::lookupPath( sPath, &nStrip );
+		return pCommand != nullptr ? nStrip + 2 : 0;
+	} );
+	const double fRegExp = messagesPerSecond( paths, 200, []( const char* sPath ) {
+		return matchRegExp( sPath ) + 2;
+	} );
+
+	qDebug() << "\n=== OSC dispatch benchmark ===";
+	qDebug() << QString( "Dispatch table: %1 messages/sec" ).arg( fTable, 0, 'f', 0 );
+	qDebug() << QString( "QRegExp:        %1 messages/sec" ).arg( fRegExp, 0, 'f', 0 );
+}
+
+#endif
@@ -0,0 +1,47 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#ifndef OSC_BENCHMARK_H
+#define OSC_BENCHMARK_H
+
+#include <core/config.h>
+
+#ifdef H2CORE_HAVE_OSC
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/** Measures the number of incoming OSC messages per second
+ * OscServer is able to resolve. Only run if enabled using the \e
+ * --benchmark option. */
+class OscBenchmark : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( OscBenchmark );
+	CPPUNIT_TEST( oscBenchmark );
+	CPPUNIT_TEST_SUITE_END();
+	static bool bEnabled;
+ public:
+	void oscBenchmark();
+	static void enable() { bEnabled = true; }
+};
+
+#endif
+
+#endif
@@ -117,4 +117,32 @@ void OscServerTest::testSessionManagement(){
 	CPPUNIT_ASSERT( m_sValidPath == m_pHydrogen->getSong()->getFilename() );
 }
 
+void OscServerTest::testPathLookup(){
+
+	int nStrip;
+	auto pCommand = OscServer::lookupPath( "/Hydrogen/PLAY", &nStrip );
+	CPPUNIT_ASSERT( pCommand != nullptr );
+	CPPUNIT_ASSERT( pCommand->sPath == "/Hydrogen/PLAY" );
+	CPPUNIT_ASSERT( pCommand->handlers.size() == 2 );
+	CPPUNIT_ASSERT_EQUAL( -1, nStrip );
+
+	pCommand = OscServer::lookupPath( "/Hydrogen/STRIP_VOLUME_ABSOLUTE/12", &nStrip );
+	CPPUNIT_ASSERT( pCommand != nullptr );
+	CPPUNIT_ASSERT( pCommand->stripHandler != nullptr );
+	CPPUNIT_ASSERT_EQUAL( 12, nStrip );
+
+	pCommand = OscServer::lookupPath( "/Hydrogen/PAN_ABSOLUTE_SYM/3", &nStrip );
+	CPPUNIT_ASSERT( pCommand != nullptr );
+	CPPUNIT_ASSERT( pCommand->sPath == "/Hydrogen/PAN_ABSOLUTE_SYM" );
+	CPPUNIT_ASSERT_EQUAL( 3, nStrip );
+
+	// Invalid strip numbers, commands not taking one, and unknown
+	// paths.
+	for ( const char* sPath : { "/Hydrogen/PAN_ABSOLUTE/", "/Hydrogen/PAN_ABSOLUTE/3a",
+								"/Hydrogen/PAN_ABSOLUTE/-1", "/Hydrogen/PLAY/1",
+								"/Hydrogen/PLAYY", "/Hydrogen", "/hydrogen/PLAY" } ) {
+		CPPUNIT_ASSERT( OscServer::lookupPath( sPath, &nStrip ) == nullptr );
+	}
+}
+
 #endif
@@ -33,6 +33,7 @@
 class OscServerTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST_SUITE( OscServerTest );
 	CPPUNIT_TEST( testSessionManagement );
+	CPPUNIT_TEST( testPathLookup );
 	CPPUNIT_TEST_SUITE_END();
 	
 private:
@@ -73,6 +74,10 @@ public:
 	 * current song does match the expected result.
 	 */
 	void testSessionManagement();
+
+	/** Checks the resolution of fixed paths and paths ending in a
+	 * strip number by OscServer::lookupPath().*/
+	void testPathLookup();
 };
 
 #endif
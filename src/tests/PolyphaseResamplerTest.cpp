@@ -0,0 +1,126 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/Sampler/PolyphaseResampler.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace H2Core;
+
+class PolyphaseResamplerTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( PolyphaseResamplerTest );
+	CPPUNIT_TEST( testSine );
+	CPPUNIT_TEST( testAntiAliasing );
+	CPPUNIT_TEST_SUITE_END();
+
+	/** Converts @a in_L and @a in_R passed in blocks of varying
+	 * size.*/
+	static void convert( PolyphaseResampler* pResampler,
+						 const std::vector<float>& in_L, const std::vector<float>& in_R,
+						 std::vector<float>* pOut_L, std::vector<float>* pOut_R )
+	{
+		const int nInputFrames = in_L.size();
+		const int nOutputFrames = pResampler->getOutputFrames( nInputFrames );
+		pOut_L->assign( nOutputFrames + 1, 0 );
+		pOut_R->assign( nOutputFrames + 1, 0 );
+
+		const int blockSizes[] = { 1, 37, 4096, 1000, 3 };
+		int nRead = 0;
+		int nWritten = 0;
+		for ( int ii = 0; nRead < nInputFrames; ++ii ) {
+			const int nFrames = std::min( blockSizes[ ii % 5 ], nInputFrames - nRead );
+			const int nCount = pResampler->process( &in_L[ nRead ], &in_R[ nRead ], nFrames,
+													pOut_L->data() + nWritten,
+													pOut_R->data() + nWritten,
+													nOutputFrames + 1 - nWritten );
+			CPPUNIT_ASSERT( nCount <= pResampler->getMaxOutputFrames( nFrames ) );
+			nWritten += nCount;
+			nRead += nFrames;
+		}
+		nWritten += pResampler->flush( pOut_L->data() + nWritten, pOut_R->data() + nWritten,
+									   nOutputFrames + 1 - nWritten );
+
+		CPPUNIT_ASSERT_EQUAL( nOutputFrames, nWritten );
+		pOut_L->resize( nWritten );
+		pOut_R->resize( nWritten );
+	}
+
+	static std::vector<float> sine( double fFrequency, int nSampleRate, int nFrames,
+									double fAmplitude ) {
+		std::vector<float> data( nFrames );
+		for ( int ii = 0; ii < nFrames; ++ii ) {
+			data[ ii ] = fAmplitude * std::sin( 2 * M_PI * fFrequency * ii / nSampleRate );
+		}
+		return data;
+	}
+
+	void testSine()
+	{
+		const int nInputFrames = 20000;
+		const double fFrequency = 1000;
+
+		const std::pair<int, int> rates[] = {
+			{ 96000, 44100 }, { 44100, 48000 }, { 48000, 96000 }, { 44100, 44099 } };
+		for ( const auto& rrRates : rates ) {
+			PolyphaseResampler resampler( rrRates.first, rrRates.second );
+			const auto in_L = sine( fFrequency, rrRates.first, nInputFrames, 0.5 );
+			const std::vector<float> in_R( nInputFrames, 0.25 );
+			std::vector<float> out_L, out_R;
+			convert( &resampler, in_L, in_R, &out_L, &out_R );
+
+			const auto expected = sine( fFrequency, rrRates.second, out_L.size(), 0.5 );
+			// Skip the edges of the signal.
+			for ( int ii = resampler.getTaps(); ii < static_cast<int>( out_L.size() ) - resampler.getTaps(); ++ii ) {
+				CPPUNIT_ASSERT_DOUBLES_EQUAL( expected[ ii ], out_L[ ii ], 1e-3 );
+				CPPUNIT_ASSERT_DOUBLES_EQUAL( 0.25, out_R[ ii ], 1e-3 );
+			}
+		}
+	}
+
+	void testAntiAliasing()
+	{
+		// A tone beyond the Nyquist frequency of the target rate has
+		// to be removed instead of being folded back.
+		const int nInputFrames = 20000;
+		PolyphaseResampler resampler( 96000, 44100 );
+		const auto in_L = sine( 30000, 96000, nInputFrames, 1.0 );
+		const auto in_R = sine( 15000, 96000, nInputFrames, 1.0 );
+		std::vector<float> out_L, out_R;
+		convert( &resampler, in_L, in_R, &out_L, &out_R );
+
+		double fPower_L = 0;
+		double fPower_R = 0;
+		int nCount = 0;
+		for ( int ii = resampler.getTaps(); ii < static_cast<int>( out_L.size() ) - resampler.getTaps(); ++ii ) {
+			fPower_L += out_L[ ii ] * out_L[ ii ];
+			fPower_R += out_R[ ii ] * out_R[ ii ];
+			++nCount;
+		}
+		// -60 dB
+		CPPUNIT_ASSERT( std::sqrt( fPower_L / nCount ) < 1e-3 );
+		// Tones within the passband are retained.
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( std::sqrt( 0.5 ), std::sqrt( fPower_R / nCount ), 1e-2 );
+	}
+};
@@ -0,0 +1,111 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/Sampler/ResampleKernels.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace H2Core;
+
+class ResampleKernelsTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( ResampleKernelsTest );
+	CPPUNIT_TEST( testKernelsMatchReference );
+	CPPUNIT_TEST_SUITE_END();
+
+	/** Per-frame reference implementation using the functions in
+	 * Interpolation.h. Frames outside of the sample are silence. */
+	static float reference( Interpolation::InterpolateMode mode,
+							const std::vector<float>& data, double fPos )
+	{
+		const int nFrames = data.size();
+		const int nPos = static_cast<int>( fPos );
+		const double fMu = fPos - nPos;
+		if ( nPos - 1 >= nFrames ) {
+			return 0.0;
+		}
+		auto tap = [&]( int n ) { return ( n >= 0 && n < nFrames ) ? data[ n ] : 0.f; };
+		const float y0 = tap( nPos - 1 ), y1 = tap( nPos ),
+			y2 = tap( nPos + 1 ), y3 = tap( nPos + 2 );
+
+		switch ( mode ) {
+		case Interpolation::InterpolateMode::Linear:
+			return Interpolation::linear_Interpolate( y1, y2, fMu );
+		case Interpolation::InterpolateMode::Cosine:
+			return Interpolation::cosine_Interpolate( y1, y2, fMu );
+		case Interpolation::InterpolateMode::Third:
+			return Interpolation::third_Interpolate( y0, y1, y2, y3, fMu );
+		case Interpolation::InterpolateMode::Cubic:
+			return Interpolation::cubic_Interpolate( y0, y1, y2, y3, fMu );
+		case Interpolation::InterpolateMode::Hermite:
+			return Interpolation::hermite_Interpolate( y0, y1, y2, y3, fMu );
+		}
+		return 0.0;
+	}
+
+	void testKernelsMatchReference()
+	{
+		const int nSampleFrames = 997;
+		std::vector<float> data_L( nSampleFrames ), data_R( nSampleFrames );
+		std::srand( 1234 );
+		for ( int ii = 0; ii < nSampleFrames; ++ii ) {
+			data_L[ ii ] = 2.0 * std::rand() / RAND_MAX - 1.0;
+			data_R[ ii ] = 2.0 * std::rand() / RAND_MAX - 1.0;
+		}
+
+		const std::vector<Interpolation::InterpolateMode> modes = {
+			Interpolation::InterpolateMode::Linear,
+			Interpolation::InterpolateMode::Cosine,
+			Interpolation::InterpolateMode::Third,
+			Interpolation::InterpolateMode::Cubic,
+			Interpolation::InterpolateMode::Hermite };
+		const int nBufferSize = 1024;
+		float buffer_L[ nBufferSize ], buffer_R[ nBufferSize ];
+
+		for ( const auto& mode : modes ) {
+			auto resample = Interpolation::getResampleFunc( mode );
+
+			for ( const double fStep : { 0.37, 1.0, 1.0594630943593, 2.7 } ) {
+				// Start in the middle of a buffer and run past the end
+				// of the sample to cover both the vectorised and the
+				// scalar edge handling.
+				const int nFrom = 3;
+				const int nTo = std::min( nBufferSize,
+										  nFrom + static_cast<int>( nSampleFrames / fStep ) + 5 );
+				const double fStart = 0.25;
+				const double fEnd = resample( data_L.data(), data_R.data(), nSampleFrames,
+											  fStart, fStep, buffer_L, buffer_R, nFrom, nTo );
+
+				CPPUNIT_ASSERT_DOUBLES_EQUAL( fStart + ( nTo - nFrom ) * fStep, fEnd, 1e-6 );
+
+				for ( int ii = nFrom; ii < nTo; ++ii ) {
+					const double fPos = fStart + ( ii - nFrom ) * fStep;
+					CPPUNIT_ASSERT_DOUBLES_EQUAL( reference( mode, data_L, fPos ),
+												  buffer_L[ ii ], 1e-5 );
+					CPPUNIT_ASSERT_DOUBLES_EQUAL( reference( mode, data_R, fPos ),
+												  buffer_R[ ii ], 1e-5 );
+				}
+			}
+		}
+	}
+};
@@ -0,0 +1,135 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/IO/SampleConversion.h>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace H2Core;
+
+class SampleConversionTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( SampleConversionTest );
+	CPPUNIT_TEST( testSaturation );
+	CPPUNIT_TEST( testFormatsMatchReference );
+	CPPUNIT_TEST_SUITE_END();
+
+	/** Reads back the integer sample @a nIndex of the interleaved
+	 * output.*/
+	static int32_t readSample( SampleConversion::Format format,
+							   const std::vector<uint8_t>& buffer, int nIndex )
+	{
+		switch ( format ) {
+		case SampleConversion::Format::S16:
+			return reinterpret_cast<const int16_t*>( buffer.data() )[ nIndex ];
+		case SampleConversion::Format::S32:
+			return reinterpret_cast<const int32_t*>( buffer.data() )[ nIndex ];
+		case SampleConversion::Format::S24_3: {
+			const uint8_t* p = &buffer[ 3 * nIndex ];
+			int32_t nValue = p[ 0 ] | ( p[ 1 ] << 8 ) | ( p[ 2 ] << 16 );
+			if ( nValue & 0x800000 ) {
+				nValue |= 0xFF000000;
+			}
+			return nValue;
+		}
+		default:
+			break;
+		}
+		return 0;
+	}
+
+	void testSaturation()
+	{
+		// Values beyond full scale must clip instead of wrap around.
+		const std::vector<float> in_L = { 1.5f, -1.5f, 1.f, -1.f, 1e20f,
+			std::numeric_limits<float>::quiet_NaN(), 0.5f, 0.f, 2.f };
+		const std::vector<float> in_R( in_L.rbegin(), in_L.rend() );
+		const int nFrames = in_L.size();
+
+		std::vector<int16_t> s16( 2 * nFrames );
+		SampleConversion::interleave( SampleConversion::Format::S16,
+									  in_L.data(), in_R.data(), s16.data(), nFrames );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 32767 ), s16[ 0 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( -32768 ), s16[ 2 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 32767 ), s16[ 4 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( -32768 ), s16[ 6 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 32767 ), s16[ 8 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 0 ), s16[ 10 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 16384 ), s16[ 12 ] );
+		CPPUNIT_ASSERT_EQUAL( int16_t( 32767 ), s16[ 1 ] );
+
+		std::vector<int32_t> s32( 2 * nFrames );
+		SampleConversion::interleave( SampleConversion::Format::S32,
+									  in_L.data(), in_R.data(), s32.data(), nFrames );
+		CPPUNIT_ASSERT( s32[ 0 ] > 2147483000 );
+		CPPUNIT_ASSERT_EQUAL( std::numeric_limits<int32_t>::min(), s32[ 2 ] );
+		CPPUNIT_ASSERT( s32[ 8 ] > 2147483000 );
+		CPPUNIT_ASSERT_EQUAL( int32_t( 0 ), s32[ 10 ] );
+		CPPUNIT_ASSERT_EQUAL( int32_t( 1073741824 ), s32[ 12 ] );
+	}
+
+	void testFormatsMatchReference()
+	{
+		// An odd number of frames covers both the vectorised and the
+		// scalar part.
+		const int nFrames = 1001;
+		std::vector<float> in_L( nFrames ), in_R( nFrames );
+		for ( int ii = 0; ii < nFrames; ++ii ) {
+			in_L[ ii ] = 1.2 * std::sin( 0.01 * ii );
+			in_R[ ii ] = 1.2 * std::cos( 0.013 * ii );
+		}
+
+		struct {
+			SampleConversion::Format format;
+			float fScale;
+			float fMax;
+		} const formats[] = {
+			{ SampleConversion::Format::S16, 32768.f, 32767.f },
+			{ SampleConversion::Format::S24_3, 8388608.f, 8388607.f },
+			{ SampleConversion::Format::S32, 2147483648.f, SampleConversion::fMaxS32 } };
+
+		for ( const auto& ffFormat : formats ) {
+			std::vector<uint8_t> buffer(
+				2 * nFrames * SampleConversion::getBytesPerSample( ffFormat.format ) );
+			SampleConversion::interleave( ffFormat.format, in_L.data(), in_R.data(),
+										  buffer.data(), nFrames );
+
+			for ( int ii = 0; ii < nFrames; ++ii ) {
+				CPPUNIT_ASSERT_EQUAL( SampleConversion::saturate( in_L[ ii ], ffFormat.fScale,
+																   ffFormat.fMax ),
+									  readSample( ffFormat.format, buffer, 2 * ii ) );
+				CPPUNIT_ASSERT_EQUAL( SampleConversion::saturate( in_R[ ii ], ffFormat.fScale,
+																   ffFormat.fMax ),
+									  readSample( ffFormat.format, buffer, 2 * ii + 1 ) );
+			}
+		}
+
+		std::vector<float> out( 2 * nFrames );
+		SampleConversion::interleave( SampleConversion::Format::Float,
+									  in_L.data(), in_R.data(), out.data(), nFrames );
+		for ( int ii = 0; ii < nFrames; ++ii ) {
+			CPPUNIT_ASSERT_EQUAL( in_L[ ii ], out[ 2 * ii ] );
+			CPPUNIT_ASSERT_EQUAL( in_R[ ii ], out[ 2 * ii + 1 ] );
+		}
+	}
+};
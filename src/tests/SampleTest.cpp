@@ -24,13 +24,47 @@
 #include "TestHelper.h"
 
 #include <core/Basics/Sample.h>
+#include <core/Sampler/SamplePrefetcher.h>
+#include <core/Helpers/Filesystem.h>
+#include <core/Preferences/Preferences.h>
+
+#include <QDir>
+#include <cstring>
 
 class SampleTest : public CppUnit::TestCase {
 	CPPUNIT_TEST_SUITE( SampleTest );
 	CPPUNIT_TEST( testLoadInvalidSample );
+	CPPUNIT_TEST( testStreamedSample );
+	CPPUNIT_TEST( testConvertedSample );
 
 	CPPUNIT_TEST_SUITE_END();
 
+	/** Entries of the sample cache present before the test.*/
+	QStringList m_cacheEntries;
+
+	QStringList sampleCacheEntries() const
+	{
+		return QDir( H2Core::Filesystem::sample_cache_dir() )
+			.entryList( QStringList() << "*.h2sample", QDir::Files );
+	}
+
+public:
+	void setUp() override
+	{
+		m_cacheEntries = sampleCacheEntries();
+	}
+
+	// Remove all cache entries created by the test.
+	void tearDown() override
+	{
+		QDir cacheDir( H2Core::Filesystem::sample_cache_dir() );
+		for ( const auto& sEntry : sampleCacheEntries() ) {
+			if ( ! m_cacheEntries.contains( sEntry ) ) {
+				cacheDir.remove( sEntry );
+			}
+		}
+	}
+
 	void testLoadInvalidSample()
 	{
 		std::shared_ptr<H2Core::Sample> pSample;
@@ -45,4 +79,83 @@ class SampleTest : public CppUnit::TestCase {
 		pSample = H2Core::Sample::load( H2TEST_FILE("drumkits/baseKit/drumkit.xml") );
 		CPPUNIT_ASSERT(pSample == nullptr);
 	}
+
+	void testStreamedSample()
+	{
+		auto pPref = H2Core::Preferences::get_instance();
+		const bool bOldStreaming = pPref->m_bUseSampleStreaming;
+		const int nOldPreload = pPref->m_nSampleStreamingPreloadMs;
+		const QString sSamplePath = H2TEST_FILE( "drumkits/baseKit/snare.wav" );
+
+		H2Core::SamplePrefetcher prefetcher;
+
+		pPref->m_bUseSampleStreaming = false;
+		auto pSample = H2Core::Sample::load( sSamplePath );
+		CPPUNIT_ASSERT( pSample != nullptr );
+		CPPUNIT_ASSERT( ! pSample->isStreamed() );
+		CPPUNIT_ASSERT( prefetcher.isResident( pSample.get(), 0, pSample->get_frames() ) );
+
+		// Load the sample twice to cover both the creation of the
+		// cache entry and its reuse.
+		pPref->m_bUseSampleStreaming = true;
+		pPref->m_nSampleStreamingPreloadMs = 1;
+		const int nStreamedSamples = H2Core::Sample::getStreamedSamples();
+		for ( int ii = 0; ii < 2; ++ii ) {
+			auto pStreamed = H2Core::Sample::load( sSamplePath );
+			CPPUNIT_ASSERT( pStreamed != nullptr );
+			CPPUNIT_ASSERT( pStreamed->isStreamed() );
+			CPPUNIT_ASSERT_EQUAL( nStreamedSamples + 1,
+								  H2Core::Sample::getStreamedSamples() );
+			CPPUNIT_ASSERT_EQUAL( pSample->get_frames(), pStreamed->get_frames() );
+			CPPUNIT_ASSERT_EQUAL( pSample->get_sample_rate(), pStreamed->get_sample_rate() );
+			CPPUNIT_ASSERT( memcmp( pSample->get_data_l(), pStreamed->get_data_l(),
+									pSample->get_frames() * sizeof( float ) ) == 0 );
+			CPPUNIT_ASSERT( memcmp( pSample->get_data_r(), pStreamed->get_data_r(),
+									pSample->get_frames() * sizeof( float ) ) == 0 );
+
+			// All pages were just read by memcmp().
+			CPPUNIT_ASSERT( prefetcher.isResident( pStreamed.get(), 0,
+												   pStreamed->get_frames() ) );
+		}
+		CPPUNIT_ASSERT_EQUAL( nStreamedSamples, H2Core::Sample::getStreamedSamples() );
+
+		pPref->m_bUseSampleStreaming = bOldStreaming;
+		pPref->m_nSampleStreamingPreloadMs = nOldPreload;
+	}
+
+	void testConvertedSample()
+	{
+		const QString sSamplePath = H2TEST_FILE( "drumkits/baseKit/snare.wav" );
+		auto pSample = H2Core::Sample::load( sSamplePath );
+		CPPUNIT_ASSERT( pSample != nullptr );
+
+		// No conversion required.
+		auto pConverted = H2Core::Sample::loadConverted( sSamplePath,
+														pSample->get_sample_rate() );
+		CPPUNIT_ASSERT( pConverted != nullptr );
+		CPPUNIT_ASSERT_EQUAL( pSample->get_frames(), pConverted->get_frames() );
+		CPPUNIT_ASSERT( memcmp( pSample->get_data_l(), pConverted->get_data_l(),
+								pSample->get_frames() * sizeof( float ) ) == 0 );
+
+		// Load twice to cover both the creation of the cache entry
+		// and its reuse.
+		const int nSampleRate = 2 * pSample->get_sample_rate();
+		std::shared_ptr<H2Core::Sample> pPrevious;
+		for ( int ii = 0; ii < 2; ++ii ) {
+			pConverted = H2Core::Sample::loadConverted( sSamplePath, nSampleRate );
+			CPPUNIT_ASSERT( pConverted != nullptr );
+			CPPUNIT_ASSERT_EQUAL( nSampleRate, pConverted->get_sample_rate() );
+			CPPUNIT_ASSERT_EQUAL( 2 * pSample->get_frames(), pConverted->get_frames() );
+#ifndef WIN32
+			CPPUNIT_ASSERT( pConverted->isStreamed() );
+#endif
+			if ( pPrevious != nullptr ) {
+				CPPUNIT_ASSERT( memcmp( pPrevious->get_data_r(), pConverted->get_data_r(),
+										pConverted->get_frames() * sizeof( float ) ) == 0 );
+			}
+			pPrevious = pConverted;
+		}
+
+		CPPUNIT_ASSERT( H2Core::Sample::loadConverted( "PathDoesNotExist", nSampleRate ) == nullptr );
+	}
 };
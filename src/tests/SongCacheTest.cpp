@@ -0,0 +1,256 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <core/Basics/AutomationPath.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentComponent.h>
+#include <core/Basics/InstrumentLayer.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Basics/Note.h>
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Sample.h>
+#include <core/Basics/Song.h>
+#include <core/Helpers/Filesystem.h>
+#include <core/Helpers/SongCache.h>
+
+#include <QFile>
+
+#include <algorithm>
+
+#include "TestHelper.h"
+
+using namespace H2Core;
+
+class SongCacheTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( SongCacheTest );
+	CPPUNIT_TEST( testCachedSong );
+	CPPUNIT_TEST( testOutdatedSnapshot );
+	CPPUNIT_TEST( testTruncatedSnapshot );
+	CPPUNIT_TEST_SUITE_END();
+
+	/** Copies @a sSong to a temporary location in order to start
+	 * without a snapshot.*/
+	static QString copySong( const QString& sSong )
+	{
+		const QString sSongPath = Filesystem::tmp_file_path( "songCacheTest.h2song" );
+		QFile::remove( sSongPath );
+		QFile::remove( SongCache::getCachePath( sSongPath ) );
+		CPPUNIT_ASSERT( QFile::copy( H2TEST_FILE( sSong ), sSongPath ) );
+		QFile( sSongPath ).setPermissions( QFile::ReadOwner | QFile::WriteOwner );
+		return sSongPath;
+	}
+
+	static void removeSong( const QString& sSongPath )
+	{
+		QFile::remove( SongCache::getCachePath( sSongPath ) );
+		QFile::remove( sSongPath );
+	}
+
+	void testCachedSong()
+	{
+		for ( const auto& sSong : { "functional/test.h2song",
+									"functional/velocityautomation.h2song" } ) {
+			const QString sSongPath = copySong( sSong );
+
+			SongReader xmlReader;
+			xmlReader.setUseCache( false );
+			auto pSongXml = xmlReader.readSong( sSongPath );
+			CPPUNIT_ASSERT( pSongXml != nullptr );
+			CPPUNIT_ASSERT( ! QFile::exists( SongCache::getCachePath( sSongPath ) ) );
+
+			// The first read stores the snapshot, the second one uses it.
+			CPPUNIT_ASSERT( Song::load( sSongPath ) != nullptr );
+			CPPUNIT_ASSERT( QFile::exists( SongCache::getCachePath( sSongPath ) ) );
+
+			std::vector<SongReader::LadspaFXSettings> ladspaFX;
+			bool bContainsIsTimelineActivated;
+			auto pSongCached = SongCache::load( sSongPath, SongCache::hash( sSongPath ),
+												&ladspaFX, &bContainsIsTimelineActivated );
+			CPPUNIT_ASSERT( pSongCached != nullptr );
+
+			CPPUNIT_ASSERT( pSongXml->getName() == pSongCached->getName() );
+			CPPUNIT_ASSERT_EQUAL( pSongXml->getBpm(), pSongCached->getBpm() );
+			CPPUNIT_ASSERT_EQUAL( pSongXml->getVolume(), pSongCached->getVolume() );
+			CPPUNIT_ASSERT( pSongXml->getMode() == pSongCached->getMode() );
+			CPPUNIT_ASSERT_EQUAL( pSongXml->getSwingFactor(), pSongCached->getSwingFactor() );
+
+			auto pInstrumentsXml = pSongXml->getInstrumentList();
+			auto pInstrumentsCached = pSongCached->getInstrumentList();
+			CPPUNIT_ASSERT_EQUAL( pInstrumentsXml->size(), pInstrumentsCached->size() );
+			for ( int ii = 0; ii < pInstrumentsXml->size(); ++ii ) {
+				auto pInstrumentXml = pInstrumentsXml->get( ii );
+				auto pInstrumentCached = pInstrumentsCached->get( ii );
+				CPPUNIT_ASSERT_EQUAL( pInstrumentXml->get_id(), pInstrumentCached->get_id() );
+				CPPUNIT_ASSERT( pInstrumentXml->get_name() == pInstrumentCached->get_name() );
+				CPPUNIT_ASSERT_EQUAL( pInstrumentXml->get_volume(),
+									  pInstrumentCached->get_volume() );
+				CPPUNIT_ASSERT_EQUAL( pInstrumentXml->getPan(), pInstrumentCached->getPan() );
+				CPPUNIT_ASSERT_EQUAL( pInstrumentXml->get_mute_group(),
+									  pInstrumentCached->get_mute_group() );
+				CPPUNIT_ASSERT_EQUAL( pInstrumentXml->get_components()->size(),
+									  pInstrumentCached->get_components()->size() );
+
+				for ( int cc = 0; cc < pInstrumentXml->get_components()->size(); ++cc ) {
+					auto pComponentXml = pInstrumentXml->get_components()->at( cc );
+					auto pComponentCached = pInstrumentCached->get_components()->at( cc );
+					for ( int nLayer = 0; nLayer < InstrumentComponent::getMaxLayers(); ++nLayer ) {
+						auto pLayerXml = pComponentXml->get_layer( nLayer );
+						auto pLayerCached = pComponentCached->get_layer( nLayer );
+						CPPUNIT_ASSERT_EQUAL( pLayerXml == nullptr, pLayerCached == nullptr );
+						if ( pLayerXml == nullptr ) {
+							continue;
+						}
+						CPPUNIT_ASSERT_EQUAL( pLayerXml->get_start_velocity(),
+											  pLayerCached->get_start_velocity() );
+						CPPUNIT_ASSERT_EQUAL( pLayerXml->get_end_velocity(),
+											  pLayerCached->get_end_velocity() );
+						CPPUNIT_ASSERT( pLayerCached->get_sample() != nullptr );
+						CPPUNIT_ASSERT( pLayerXml->get_sample()->get_filepath() ==
+										pLayerCached->get_sample()->get_filepath() );
+						CPPUNIT_ASSERT_EQUAL( pLayerXml->get_sample()->get_frames(),
+											  pLayerCached->get_sample()->get_frames() );
+					}
+				}
+			}
+
+			auto pPatternsXml = pSongXml->getPatternList();
+			auto pPatternsCached = pSongCached->getPatternList();
+			CPPUNIT_ASSERT_EQUAL( pPatternsXml->size(), pPatternsCached->size() );
+			for ( int ii = 0; ii < pPatternsXml->size(); ++ii ) {
+				auto pNotesXml = pPatternsXml->get( ii )->get_notes();
+				auto pNotesCached = pPatternsCached->get( ii )->get_notes();
+				CPPUNIT_ASSERT( pPatternsXml->get( ii )->get_name() ==
+								pPatternsCached->get( ii )->get_name() );
+				CPPUNIT_ASSERT_EQUAL( pNotesXml->size(), pNotesCached->size() );
+
+				auto itCached = pNotesCached->begin();
+				for ( auto itXml = pNotesXml->begin(); itXml != pNotesXml->end();
+					  ++itXml, ++itCached ) {
+					auto pNoteXml = itXml->second;
+					auto pNoteCached = itCached->second;
+					CPPUNIT_ASSERT( pNoteCached->get_instrument() != nullptr );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_instrument()->get_id(),
+										  pNoteCached->get_instrument()->get_id() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_position(), pNoteCached->get_position() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_length(), pNoteCached->get_length() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_velocity(), pNoteCached->get_velocity() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->getPan(), pNoteCached->getPan() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_pitch(), pNoteCached->get_pitch() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_note_off(), pNoteCached->get_note_off() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_key(), pNoteCached->get_key() );
+					CPPUNIT_ASSERT_EQUAL( pNoteXml->get_octave(), pNoteCached->get_octave() );
+				}
+			}
+
+			auto pColumnsXml = pSongXml->getPatternGroupVector();
+			auto pColumnsCached = pSongCached->getPatternGroupVector();
+			CPPUNIT_ASSERT_EQUAL( pColumnsXml->size(), pColumnsCached->size() );
+			for ( int ii = 0; ii < pColumnsXml->size(); ++ii ) {
+				CPPUNIT_ASSERT_EQUAL( pColumnsXml->at( ii )->size(),
+									  pColumnsCached->at( ii )->size() );
+				for ( int pp = 0; pp < pColumnsXml->at( ii )->size(); ++pp ) {
+					CPPUNIT_ASSERT_EQUAL(
+						pPatternsXml->index( pColumnsXml->at( ii )->get( pp ) ),
+						pPatternsCached->index( pColumnsCached->at( ii )->get( pp ) ) );
+				}
+			}
+
+			CPPUNIT_ASSERT( *pSongXml->getVelocityAutomationPath() ==
+							*pSongCached->getVelocityAutomationPath() );
+
+			removeSong( sSongPath );
+		}
+	}
+
+	void testOutdatedSnapshot()
+	{
+		const QString sSongPath = copySong( "functional/test.h2song" );
+
+		CPPUNIT_ASSERT( Song::load( sSongPath ) != nullptr );
+		const QByteArray hash = SongCache::hash( sSongPath );
+
+		std::vector<SongReader::LadspaFXSettings> ladspaFX;
+		bool bContainsIsTimelineActivated;
+		CPPUNIT_ASSERT( SongCache::load( sSongPath, hash, &ladspaFX,
+										 &bContainsIsTimelineActivated ) != nullptr );
+
+		// Altering the song invalidates its snapshot.
+		QFile file( sSongPath );
+		CPPUNIT_ASSERT( file.open( QIODevice::Append ) );
+		file.write( "\n" );
+		file.close();
+
+		const QByteArray newHash = SongCache::hash( sSongPath );
+		CPPUNIT_ASSERT( newHash != hash );
+		CPPUNIT_ASSERT( SongCache::load( sSongPath, newHash, &ladspaFX,
+										 &bContainsIsTimelineActivated ) == nullptr );
+
+		// Reading the song again replaces the snapshot.
+		CPPUNIT_ASSERT( Song::load( sSongPath ) != nullptr );
+		CPPUNIT_ASSERT( SongCache::load( sSongPath, newHash, &ladspaFX,
+										 &bContainsIsTimelineActivated ) != nullptr );
+
+		removeSong( sSongPath );
+	}
+
+	void testTruncatedSnapshot()
+	{
+		const QString sSongPath = copySong( "functional/test.h2song" );
+		const QString sCachePath = SongCache::getCachePath( sSongPath );
+
+		CPPUNIT_ASSERT( Song::load( sSongPath ) != nullptr );
+		const QByteArray hash = SongCache::hash( sSongPath );
+
+		QFile cacheFile( sCachePath );
+		CPPUNIT_ASSERT( cacheFile.open( QIODevice::ReadOnly ) );
+		const QByteArray snapshot = cacheFile.readAll();
+		cacheFile.close();
+		CPPUNIT_ASSERT( snapshot.size() > 0 );
+
+		// Cutting the snapshot anywhere - including within the note
+		// data of a pattern - must neither crash nor yield a song.
+		std::vector<SongReader::LadspaFXSettings> ladspaFX;
+		bool bContainsIsTimelineActivated;
+		const int nStep = std::max( 1, snapshot.size() / 64 );
+		for ( int nCut = snapshot.size() - 1; nCut > 0; nCut -= nStep ) {
+			CPPUNIT_ASSERT( cacheFile.open( QIODevice::WriteOnly | QIODevice::Truncate ) );
+			CPPUNIT_ASSERT_EQUAL( static_cast<qint64>( nCut ),
+								  cacheFile.write( snapshot.left( nCut ) ) );
+			cacheFile.close();
+
+			CPPUNIT_ASSERT( SongCache::load( sSongPath, hash, &ladspaFX,
+											 &bContainsIsTimelineActivated ) == nullptr );
+		}
+
+		// A regular load falls back to the XML file and restores the
+		// snapshot.
+		CPPUNIT_ASSERT( Song::load( sSongPath ) != nullptr );
+		CPPUNIT_ASSERT( SongCache::load( sSongPath, hash, &ladspaFX,
+										 &bContainsIsTimelineActivated ) != nullptr );
+
+		removeSong( sSongPath );
+	}
+};
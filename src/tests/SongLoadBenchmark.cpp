@@ -0,0 +1,131 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+
+#include "SongLoadBenchmark.h"
+#include "TestHelper.h"
+
+#include <core/Basics/Song.h>
+#include <core/Basics/Instrument.h>
+#include <core/Basics/InstrumentList.h>
+#include <core/Basics/Note.h>
+#include <core/Basics/Pattern.h>
+#include <core/Basics/PatternList.h>
+#include <core/Helpers/Filesystem.h>
+#include <core/Helpers/SongCache.h>
+
+#include <QDebug>
+
+#include <chrono>
+
+using namespace H2Core;
+
+bool SongLoadBenchmark::bEnabled = false;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SongLoadBenchmark );
+
+/** Number of notes per pattern and number of patterns in the
+ * synthetic song. */
+static const int nNotesPerPattern = 1000;
+static const int nPatterns = 100;
+
+static int countNotes( std::shared_ptr<Song> pSong ) {
+	int nNotes = 0;
+	for ( const auto& pPattern : *pSong->getPatternList() ) {
+		nNotes += pPattern->get_notes()->size();
+	}
+	return nNotes;
+}
+
+/** \return Average time in milliseconds required to load @a sSongPath. */
+static double timeLoad( const QString& sSongPath, bool bUseStreamReader,
+						bool bUseCache, int nRounds, int* pNotes ) {
+	double fTotal = 0;
+	for ( int nn = 0; nn < nRounds; ++nn ) {
+		const auto start = std::chrono::steady_clock::now();
+		SongReader reader;
+		reader.setUseStreamReader( bUseStreamReader );
+		reader.setUseCache( bUseCache );
+		auto pSong = reader.readSong( sSongPath );
+		const std::chrono::duration<double, std::milli> elapsed =
+			std::chrono::steady_clock::now() - start;
+		fTotal += elapsed.count();
+
+		CPPUNIT_ASSERT( pSong != nullptr );
+		*pNotes = countNotes( pSong );
+	}
+	return fTotal / nRounds;
+}
+
+void SongLoadBenchmark::songLoadBenchmark()
+{
+	if ( ! bEnabled ) {
+		return;
+	}
+
+	// The samples of the song have to be available in order to
+	// create a snapshot of it.
+	auto pSong = Song::load( H2TEST_FILE( "functional/test.h2song" ) );
+	CPPUNIT_ASSERT( pSong != nullptr );
+
+	auto pInstrumentList = pSong->getInstrumentList();
+	auto pPatternList = pSong->getPatternList();
+	for ( int ii = 0; ii < nPatterns; ++ii ) {
+		Pattern* pPattern = new Pattern( QString( "synthetic %1" ).arg( ii ),
+										 "", "benchmark", 192, 4 );
+		for ( int nn = 0; nn < nNotesPerPattern; ++nn ) {
+			auto pInstrument = pInstrumentList->get( nn % pInstrumentList->size() );
+			Note* pNote = new Note( pInstrument, ( nn * 7 ) % 192,
+									0.1 + 0.9 * ( nn % 10 ) / 10.0,
+									0.f, -1, 0.f );
+			pNote->set_lead_lag( ( nn % 5 ) * 0.1 );
+			pPattern->insert_note( pNote );
+		}
+		pPatternList->add( pPattern );
+	}
+
+	const QString sSongPath = Filesystem::tmp_dir() + "song_load_benchmark.h2song";
+	CPPUNIT_ASSERT( pSong->save( sSongPath ) );
+	const int nExpectedNotes = countNotes( pSong );
+	CPPUNIT_ASSERT( nExpectedNotes >= nPatterns * nNotesPerPattern );
+
+	int nDomNotes = 0, nStreamedNotes = 0, nCachedNotes = 0;
+	const double fDom = timeLoad( sSongPath, false, false, 3, &nDomNotes );
+	const double fStreamed = timeLoad( sSongPath, true, false, 3, &nStreamedNotes );
+	// Creates the snapshot used in the subsequent rounds.
+	timeLoad( sSongPath, true, true, 1, &nCachedNotes );
+	const double fCached = timeLoad( sSongPath, true, true, 3, &nCachedNotes );
+
+	CPPUNIT_ASSERT_EQUAL( nExpectedNotes, nDomNotes );
+	CPPUNIT_ASSERT_EQUAL( nExpectedNotes, nStreamedNotes );
+	CPPUNIT_ASSERT_EQUAL( nExpectedNotes, nCachedNotes );
+
+	qDebug() << "\n=== Song loading benchmark ===";
+	qDebug() << QString( "%1 notes in %2 patterns" ).arg( nExpectedNotes )
+		.arg( pPatternList->size() );
+	qDebug() << QString( "DOM:           %1 ms" ).arg( fDom, 0, 'f', 1 );
+	qDebug() << QString( "Stream reader: %1 ms" ).arg( fStreamed, 0, 'f', 1 );
+	qDebug() << QString( "Song cache:    %1 ms" ).arg( fCached, 0, 'f', 1 );
+
+	Filesystem::rm( SongCache::getCachePath( sSongPath ) );
+	Filesystem::rm( sSongPath );
+}
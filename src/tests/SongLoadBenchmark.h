@@ -0,0 +1,42 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+
+#ifndef SONG_LOAD_BENCHMARK_H
+#define SONG_LOAD_BENCHMARK_H
+
+#include <cppunit/extensions/HelperMacros.h>
+
+/** Compares the time required to load a synthetic song holding
+ * 100k notes using the XMLStreamReader and the DOM based code path of
+ * SongReader. Only run if enabled using the \e --benchmark option. */
+class SongLoadBenchmark : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( SongLoadBenchmark );
+	CPPUNIT_TEST( songLoadBenchmark );
+	CPPUNIT_TEST_SUITE_END();
+	static bool bEnabled;
+ public:
+	void songLoadBenchmark();
+	static void enable() { bEnabled = true; }
+};
+
+#endif
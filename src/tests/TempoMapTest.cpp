@@ -0,0 +1,102 @@
+/*
+ * Hydrogen
+ * Copyright(c) 2008-2022 The hydrogen development team [hydrogen-devel@lists.sourceforge.net]
+ *
+ * http://www.hydrogen-music.org
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY, without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see https://www.gnu.org/licenses
+ *
+ */
+
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <core/AudioEngine/AudioEngine.h>
+#include <core/AudioEngine/TempoMap.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Song.h>
+#include <core/Timeline.h>
+#include "TestHelper.h"
+
+#include <cmath>
+#include <memory>
+
+using namespace H2Core;
+
+class TempoMapTest : public CppUnit::TestCase {
+	CPPUNIT_TEST_SUITE( TempoMapTest );
+	CPPUNIT_TEST( testConversion );
+	CPPUNIT_TEST_SUITE_END();
+
+	/** Frame corresponding to @a fTick computed column by column.*/
+	static double reference( std::shared_ptr<Song> pSong,
+							 std::shared_ptr<Timeline> pTimeline,
+							 int nSampleRate, double fTick )
+	{
+		const auto pColumns = pSong->getPatternGroupVector();
+
+		double fFrames = 0;
+		double fRemainingTicks = fTick;
+		while ( fRemainingTicks > 0 ) {
+			for ( int ii = 0; ii < pColumns->size() && fRemainingTicks > 0; ++ii ) {
+				const double fColumnTicks = ( *pColumns )[ ii ]->size() > 0 ?
+					( *pColumns )[ ii ]->longest_pattern_length() : MAX_NOTES;
+				const double fTickSize =
+					AudioEngine::computeDoubleTickSize( nSampleRate,
+														pTimeline->getTempoAtColumn( ii ),
+														pSong->getResolution() );
+				fFrames += std::min( fRemainingTicks, fColumnTicks ) * fTickSize;
+				fRemainingTicks -= fColumnTicks;
+			}
+		}
+		return fFrames;
+	}
+
+	void testConversion()
+	{
+		auto pSong = Song::load( H2TEST_FILE( "song/AE_songSizeChanged.h2song" ) );
+		CPPUNIT_ASSERT( pSong != nullptr );
+		const int nColumns = pSong->getPatternGroupVector()->size();
+		CPPUNIT_ASSERT( nColumns > 3 );
+
+		auto pTimeline = std::make_shared<Timeline>();
+		pTimeline->addTempoMarker( 1, 100 );
+		pTimeline->addTempoMarker( 3, 40 );
+		// Markers beyond the end of the song are ignored.
+		pTimeline->addTempoMarker( nColumns + 2, 200 );
+
+		const int nSampleRate = 48000;
+		const double fSongSize = pSong->lengthInTicks();
+
+		TempoMap tempoMap;
+		tempoMap.update( pSong, pTimeline, fSongSize, nSampleRate );
+		CPPUNIT_ASSERT( tempoMap.hasTempoMarkers() );
+		CPPUNIT_ASSERT_EQUAL( nSampleRate, tempoMap.getSampleRate() );
+		CPPUNIT_ASSERT_DOUBLES_EQUAL( reference( pSong, pTimeline, nSampleRate, fSongSize ),
+									  tempoMap.getSongSizeInFrames(), 1e-6 );
+
+		for ( const double fTick : { 0.5, 47.3, 191.999, 192.0, 387.25,
+				fSongSize - 0.1, fSongSize, fSongSize + 13.7,
+				7 * fSongSize + 500.01, 534623409.0 } ) {
+			double fTickMismatch;
+			const long long nFrame = tempoMap.computeFrameFromTick( fTick, &fTickMismatch );
+			const double fReference = reference( pSong, pTimeline, nSampleRate, fTick );
+
+			CPPUNIT_ASSERT( std::abs( fReference - static_cast<double>( nFrame ) ) <=
+							0.5 + 1e-6 * fReference );
+			CPPUNIT_ASSERT_DOUBLES_EQUAL(
+				fTick, tempoMap.computeTickFromFrame( nFrame ) + fTickMismatch,
+				1e-6 );
+		}
+	}
+};
@@ -169,3 +169,42 @@ void TransportTest::testNoteEnqueuing() {
 		CPPUNIT_ASSERT( bNoMismatch );
 	}
 }		
+
+void TransportTest::testMidiTimestamps() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pAudioEngine = pHydrogen->getAudioEngine();
+
+	pHydrogen->getCoreActionController()->openSong( m_pSongDemo );
+
+	for ( int ii = 0; ii < 15; ++ii ) {
+		TestHelper::varyAudioDriverConfig( ii );
+		bool bNoMismatch = pAudioEngine->testMidiTimestamps();
+		CPPUNIT_ASSERT( bNoMismatch );
+	}
+}
+
+void TransportTest::testMidiJackClientOrder() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pAudioEngine = pHydrogen->getAudioEngine();
+
+	pHydrogen->getCoreActionController()->openSong( m_pSongDemo );
+
+	for ( int ii = 0; ii < 15; ++ii ) {
+		TestHelper::varyAudioDriverConfig( ii );
+		bool bNoMismatch = pAudioEngine->testMidiJackClientOrder();
+		CPPUNIT_ASSERT( bNoMismatch );
+	}
+}
+
+void TransportTest::testRealtimeNoteWithoutTimestamp() {
+	auto pHydrogen = Hydrogen::get_instance();
+	auto pAudioEngine = pHydrogen->getAudioEngine();
+
+	pHydrogen->getCoreActionController()->openSong( m_pSongDemo );
+
+	for ( int ii = 0; ii < 15; ++ii ) {
+		TestHelper::varyAudioDriverConfig( ii );
+		bool bNoMismatch = pAudioEngine->testRealtimeNoteWithoutTimestamp();
+		CPPUNIT_ASSERT( bNoMismatch );
+	}
+}
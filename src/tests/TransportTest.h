@@ -34,6 +34,9 @@ class TransportTest : public CppUnit::TestFixture {
 	CPPUNIT_TEST( testSongSizeChange );
 	CPPUNIT_TEST( testSongSizeChangeInLoopMode );
 	CPPUNIT_TEST( testNoteEnqueuing );
+	CPPUNIT_TEST( testMidiTimestamps );
+	CPPUNIT_TEST( testMidiJackClientOrder );
+	CPPUNIT_TEST( testRealtimeNoteWithoutTimestamp );
 	CPPUNIT_TEST_SUITE_END();
 	
 private:
@@ -52,4 +55,7 @@ public:
 	void testSongSizeChange();
 	void testSongSizeChangeInLoopMode();
 	void testNoteEnqueuing();
+	void testMidiTimestamps();
+	void testMidiJackClientOrder();
+	void testRealtimeNoteWithoutTimestamp();
 };
@@ -32,6 +32,8 @@
 #include <core/Basics/InstrumentComponent.h>
 #include <core/Basics/Sample.h>
 #include <core/Basics/Playlist.h>
+#include <core/Basics/PatternList.h>
+#include <core/Basics/Song.h>
 #include <core/Hydrogen.h>
 #include <core/CoreActionController.h>
 
@@ -387,6 +389,69 @@ void XmlTest::checkTestPatterns()
 							  H2Core::Filesystem::pattern_xsd_path() ) );
 }
 
+void XmlTest::testSongStreamReader()
+{
+	for ( const auto& sSong : { "song/test_song_0.9.7.h2song",
+								"song/AE_songSizeChanged.h2song",
+								"functional/test.h2song" } ) {
+		H2Core::SongReader domReader;
+		domReader.setUseStreamReader( false );
+		domReader.setUseCache( false );
+		auto pSongDom = domReader.readSong( H2TEST_FILE( sSong ) );
+		H2Core::SongReader streamReader;
+		streamReader.setUseCache( false );
+		auto pSongStreamed = streamReader.readSong( H2TEST_FILE( sSong ) );
+		CPPUNIT_ASSERT( pSongDom != nullptr );
+		CPPUNIT_ASSERT( pSongStreamed != nullptr );
+
+		CPPUNIT_ASSERT( pSongDom->getName() == pSongStreamed->getName() );
+		CPPUNIT_ASSERT_EQUAL( pSongDom->getInstrumentList()->size(),
+							  pSongStreamed->getInstrumentList()->size() );
+		CPPUNIT_ASSERT_EQUAL( pSongDom->getPatternGroupVector()->size(),
+							  pSongStreamed->getPatternGroupVector()->size() );
+
+		auto pPatternsDom = pSongDom->getPatternList();
+		auto pPatternsStreamed = pSongStreamed->getPatternList();
+		CPPUNIT_ASSERT( pPatternsDom->size() > 0 );
+		CPPUNIT_ASSERT_EQUAL( pPatternsDom->size(), pPatternsStreamed->size() );
+
+		for ( int ii = 0; ii < pPatternsDom->size(); ++ii ) {
+			auto pPatternDom = pPatternsDom->get( ii );
+			auto pPatternStreamed = pPatternsStreamed->get( ii );
+			CPPUNIT_ASSERT( pPatternDom->get_name() == pPatternStreamed->get_name() );
+			CPPUNIT_ASSERT( pPatternDom->get_category() == pPatternStreamed->get_category() );
+			CPPUNIT_ASSERT_EQUAL( pPatternDom->get_length(), pPatternStreamed->get_length() );
+			CPPUNIT_ASSERT_EQUAL( pPatternDom->get_denominator(),
+								  pPatternStreamed->get_denominator() );
+
+			auto pNotesDom = pPatternDom->get_notes();
+			auto pNotesStreamed = pPatternStreamed->get_notes();
+			CPPUNIT_ASSERT_EQUAL( pNotesDom->size(), pNotesStreamed->size() );
+
+			auto itStreamed = pNotesStreamed->begin();
+			for ( auto itDom = pNotesDom->begin(); itDom != pNotesDom->end();
+				  ++itDom, ++itStreamed ) {
+				auto pNoteDom = itDom->second;
+				auto pNoteStreamed = itStreamed->second;
+				CPPUNIT_ASSERT( pNoteStreamed->get_instrument() != nullptr );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_instrument()->get_id(),
+									  pNoteStreamed->get_instrument()->get_id() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_position(), pNoteStreamed->get_position() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_length(), pNoteStreamed->get_length() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_velocity(), pNoteStreamed->get_velocity() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->getPan(), pNoteStreamed->getPan() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_pitch(), pNoteStreamed->get_pitch() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_lead_lag(), pNoteStreamed->get_lead_lag() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_probability(),
+									  pNoteStreamed->get_probability() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_note_off(), pNoteStreamed->get_note_off() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_key(), pNoteStreamed->get_key() );
+				CPPUNIT_ASSERT_EQUAL( pNoteDom->get_octave(), pNoteStreamed->get_octave() );
+			}
+		}
+	}
+}
+
 void XmlTest::testPlaylist()
 {
 	QString sPath = H2Core::Filesystem::tmp_dir()+"playlist.h2playlist";
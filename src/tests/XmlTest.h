@@ -31,6 +31,7 @@ class XmlTest : public CppUnit::TestCase {
 	CPPUNIT_TEST(testDrumkit_UpgradeInvalidADSRValues);
 	CPPUNIT_TEST(testDrumkitUpgrade);
 	CPPUNIT_TEST(testPattern);
+	CPPUNIT_TEST(testSongStreamReader);
 	CPPUNIT_TEST(testPlaylist);
 	CPPUNIT_TEST(testShippedDrumkits);
 	CPPUNIT_TEST(checkTestPatterns);
@@ -43,6 +44,9 @@ class XmlTest : public CppUnit::TestCase {
 		void testDrumkit_UpgradeInvalidADSRValues();
 		void testDrumkitUpgrade();
 		void testPattern();
+		// Songs read using the XMLStreamReader must be identical
+		// to the ones constructed from a DOM.
+		void testSongStreamReader();
 		void testPlaylist();
 		// Check whether the drumkits provided alongside this repo can
 		// be validated against the drumkit XSD.
@@ -36,6 +36,8 @@
 #include "utils/AppveyorTestListener.h"
 #include "utils/AppveyorRestClient.h"
 #include "AudioBenchmark.h"
+#include "OscBenchmark.h"
+#include "SongLoadBenchmark.h"
 #include <chrono>
 
 #ifdef HAVE_EXECINFO_H
@@ -93,7 +95,7 @@ int main( int argc, char **argv)
 	QCommandLineParser parser;
 	QCommandLineOption verboseOption( QStringList() << "V" << "verbose", "Level, if present, may be None, Error, Warning, Info, Debug or 0xHHHH","Level");
 	QCommandLineOption appveyorOption( QStringList() << "appveyor", "Report test progress to AppVeyor build worker" );
-	QCommandLineOption benchmarkOption( QStringList() << "b" << "benchmark", "Run audio system benchmark" );
+	QCommandLineOption benchmarkOption( QStringList() << "b" << "benchmark", "Run audio system, OSC, and song loading benchmarks" );
 	parser.addHelpOption();
 	parser.addOption( verboseOption );
 	parser.addOption( appveyorOption );
@@ -120,9 +122,13 @@ int main( int argc, char **argv)
 	signal(SIGBUS, fatal_signal);
 #endif
 
-	// Enable the audio benchmark
+	// Enable the benchmarks
 	if ( parser.isSet( benchmarkOption ) ) {
 		AudioBenchmark::enable();
+		SongLoadBenchmark::enable();
+#ifdef H2CORE_HAVE_OSC
+		OscBenchmark::enable();
+#endif
 	}
 	
 	CppUnit::TextUi::TestRunner runner;
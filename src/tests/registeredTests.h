@@ -26,15 +26,28 @@
 #include "AutomationPathSerializerTest.cpp"
 #include "AutomationPathTest.cpp"
 #include "CoreActionControllerTest.h"
+#include "DrumkitIndexTest.cpp"
+#include "DrumkitSampleLoaderTest.cpp"
+#include "DspProfilerTest.cpp"
 #include "FilesystemTest.h"
 #include "FunctionalTests.cpp"
 #include "InstrumentListTest.cpp"
+#include "LayerSelectionTableTest.cpp"
 #include "MemoryLeakageTest.h"
+#include "MidiMapTest.cpp"
 #include "MidiNoteTest.cpp"
+#include "NotePoolTest.cpp"
+#include "NoteProgramTest.cpp"
+#include "NoteQueueTest.cpp"
 #include "NoteTest.cpp"
 #include "OscServerTest.h"
 #include "PatternTest.h"
+#include "PolyphaseResamplerTest.cpp"
+#include "ResampleKernelsTest.cpp"
+#include "SampleConversionTest.cpp"
 #include "SampleTest.cpp"
+#include "SongCacheTest.cpp"
+#include "TempoMapTest.cpp"
 #include "TimeTest.h"
 #include "Translations.cpp"
 #include "TransportTest.h"
@@ -44,17 +57,30 @@ CPPUNIT_TEST_SUITE_REGISTRATION( ADSRTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( AutomationPathSerializerTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( AutomationPathTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( CoreActionControllerTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( DrumkitIndexTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( DrumkitSampleLoaderTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( DspProfilerTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( FilesystemTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( FunctionalTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( InstrumentListTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( LayerSelectionTableTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( MemoryLeakageTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( MidiMapTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( MidiNoteTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( NotePoolTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( NoteProgramTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( NoteQueueTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( NoteTest );
 #ifdef H2CORE_HAVE_OSC
 CPPUNIT_TEST_SUITE_REGISTRATION( OscServerTest );
 #endif
 CPPUNIT_TEST_SUITE_REGISTRATION( PatternTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( PolyphaseResamplerTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( ResampleKernelsTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( SampleConversionTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( SampleTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( SongCacheTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( TempoMapTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( TimeTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( TransportTest );
 CPPUNIT_TEST_SUITE_REGISTRATION( UITranslationTest );